@@ -0,0 +1,107 @@
+#include "ai/ai_scheduler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+
+// 10k agents retargeting every third of a second, their squads planning every half second and four AI players
+// replanning their base every four seconds, ticked at 30 Hz. The frame report compares the time AI takes per tick
+// when everything due runs at once with the budgeted and time-sliced schedule, as mean, deviation and worst tick.
+
+using namespace TGW::Ai;
+
+namespace {
+constexpr uint32_t AGENT_COUNT = 10'000;
+constexpr uint32_t SQUAD_SIZE = 10;
+constexpr uint32_t PLAYER_COUNT = 4;
+constexpr uint32_t FRAME_TICKS = 480;
+// Rounds of busy work, a few nanoseconds each
+constexpr uint32_t TARGETING_WORK = 300;
+constexpr uint32_t SQUAD_WORK = 3'000;
+constexpr uint32_t PLANNING_WORK = 2'000'000;
+constexpr uint32_t PLANNING_SLICE = 100'000;
+
+// Stands in for thinking, rounds of xorshift the compiler cannot drop
+uint32_t Think(uint32_t seed, uint32_t rounds)
+{
+	uint32_t x = seed | 1;
+	for (uint32_t i = 0; i < rounds; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+	}
+	return x;
+}
+
+struct Army {
+	AiScheduler scheduler;
+	std::vector<uint32_t> agents;
+	std::vector<uint32_t> squads;
+	std::array<uint32_t, PLAYER_COUNT> planningLeft{};
+
+	// Budgeted gives every system a share of 2 ms and cuts planning into slices, otherwise everything due runs
+	explicit Army(bool budgeted) : agents(AGENT_COUNT), squads(AGENT_COUNT / SQUAD_SIZE)
+	{
+		const uint32_t unlimited = UINT32_MAX / 1000;
+		scheduler.AddSystem(
+		  {.name = "targeting", .budgetMicros = budgeted ? 1200 : unlimited, .parallel = true, .agingTicks = 30});
+		scheduler.AddSystem(
+		  {.name = "squads", .budgetMicros = budgeted ? 500 : unlimited, .parallel = false, .agingTicks = 30});
+		scheduler.AddSystem(
+		  {.name = "planning", .budgetMicros = budgeted ? 300 : unlimited, .parallel = false, .agingTicks = 30});
+		for (uint32_t i = 0; i < AGENT_COUNT; i++) {
+			scheduler.AddJob({.system = 0, .priority = 2, .interval = 10}, [this, i] {
+				agents[i] = Think(agents[i] + i, TARGETING_WORK);
+				return false;
+			});
+		}
+		for (uint32_t i = 0; i < squads.size(); i++) {
+			scheduler.AddJob({.system = 1, .priority = 1, .interval = 15}, [this, i] {
+				squads[i] = Think(squads[i] + i, SQUAD_WORK);
+				return false;
+			});
+		}
+		const uint32_t slice = budgeted ? PLANNING_SLICE : PLANNING_WORK;
+		for (uint32_t player = 0; player < PLAYER_COUNT; player++) {
+			scheduler.AddJob({.system = 2, .priority = 0, .interval = 120}, [this, player, slice] {
+				uint32_t &left = planningLeft[player];
+				left = left > 0 ? left : PLANNING_WORK;
+				const uint32_t rounds = std::min(left, slice);
+				benchmark::DoNotOptimize(Think(player, rounds));
+				left -= rounds;
+				return left > 0;
+			});
+		}
+	}
+};
+} // namespace
+
+static void BM_AiFrame(benchmark::State &state)
+{
+	TGW::JobSystem &jobs = TGW::JobSystem::Get();
+	const bool budgeted = state.range(0) != 0;
+	std::vector<double> frames;
+	for (auto _ : state) {
+		state.PauseTiming();
+		Army army{budgeted};
+		frames.clear();
+		state.ResumeTiming();
+		for (uint32_t tick = 0; tick < FRAME_TICKS; tick++) {
+			const auto start = std::chrono::steady_clock::now();
+			army.scheduler.Tick(jobs);
+			frames.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+		}
+	}
+	double sum = 0.0, squares = 0.0;
+	for (const double frame : frames) {
+		sum += frame;
+		squares += frame * frame;
+	}
+	const double mean = sum / frames.size();
+	state.counters["frame_mean_us"] = mean;
+	state.counters["frame_stddev_us"] = std::sqrt(std::max(squares / frames.size() - mean * mean, 0.0));
+	state.counters["frame_max_us"] = *std::ranges::max_element(frames);
+	state.SetItemsProcessed(state.iterations() * FRAME_TICKS);
+}
+BENCHMARK(BM_AiFrame)->ArgName("budgeted")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,159 @@
+#include "anim/pose_cache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+// A 64 joint rig with walk, run, idle and fire clips baked at 60 keys per second on every channel, the way DCC
+// exports come in. Compression reports the ratio against the imported keys, pose evaluation the poses per second,
+// and the crowd a 500 soldier blob marching in a few groups, with and without sharing poses through the cache.
+
+namespace {
+constexpr uint32_t JOINT_COUNT = 64;
+constexpr float BAKE_RATE = 60.0f;
+constexpr uint32_t CLIP_COUNT = 4;
+constexpr uint32_t CROWD_SIZE = 500;
+// Soldiers fall into this many groups marching in step
+constexpr uint32_t CROWD_GROUPS = 8;
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+
+TGW::Anim::Skeleton MakeSkeleton()
+{
+	TGW::Anim::Skeleton skeleton;
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		TGW::Anim::Joint &joint = skeleton.joints.emplace_back();
+		joint.name = "joint" + std::to_string(i);
+		joint.parent = i == 0 ? TGW::Anim::JOINT_NO_PARENT : static_cast<uint16_t>((i - 1) / 2);
+		joint.bindPose.translation = {0.0f, i == 0 ? 1.0f : 0.2f, 0.0f};
+		DirectX::XMStoreFloat4x4(&joint.inverseBind, DirectX::XMMatrixIdentity());
+	}
+	return skeleton;
+}
+
+// Every joint swings about its own axis, the root bobs along, a third of the joints and every scale hold still
+TGW::Anim::AnimationClip MakeClip(uint32_t index)
+{
+	TGW::Anim::AnimationClip clip;
+	clip.name = "clip" + std::to_string(index);
+	clip.duration = 1.0f + 0.5f * index;
+	const uint32_t keyCount = static_cast<uint32_t>(clip.duration * BAKE_RATE) + 1;
+	const float frequency = DirectX::XM_2PI / clip.duration;
+	for (uint32_t joint = 0; joint < JOINT_COUNT; joint++) {
+		TGW::Anim::JointTrack &track = clip.tracks.emplace_back();
+		const DirectX::XMVECTOR axis =
+			DirectX::XMVector3Normalize(DirectX::XMVectorSet(std::sin(joint * 1.7f), 1.0f, std::cos(joint * 0.9f), 0.0f));
+		const float amplitude = joint % 3 == 2 ? 0.0f : 0.6f / (1.0f + joint % 5);
+		for (uint32_t key = 0; key < keyCount; key++) {
+			const float time = key / BAKE_RATE;
+			DirectX::XMFLOAT4 rotation;
+			DirectX::XMStoreFloat4(
+				&rotation, DirectX::XMQuaternionRotationAxis(axis, amplitude * std::sin(frequency * time + joint * 0.3f)));
+			track.rotationTimes.push_back(time);
+			track.rotations.push_back(rotation);
+			track.translationTimes.push_back(time);
+			track.translations.push_back({0.0f, joint == 0 ? 1.0f + 0.05f * std::sin(2.0f * frequency * time) : 0.2f, 0.0f});
+			track.scaleTimes.push_back(time);
+			track.scales.push_back({1.0f, 1.0f, 1.0f});
+		}
+	}
+	return clip;
+}
+
+struct Library {
+	TGW::Anim::Skeleton skeleton = MakeSkeleton();
+	std::vector<TGW::Anim::AnimationClip> raw;
+	std::vector<TGW::Anim::CompressedClip> clips;
+
+	Library()
+	{
+		for (uint32_t i = 0; i < CLIP_COUNT; i++) {
+			raw.push_back(MakeClip(i));
+			clips.push_back(TGW::Anim::CompressClip(raw.back(), skeleton));
+		}
+	}
+};
+
+const Library &GetLibrary()
+{
+	static const Library library;
+	return library;
+}
+
+std::vector<TGW::Anim::AnimationInstance> MakeCrowd()
+{
+	std::vector<TGW::Anim::AnimationInstance> crowd(CROWD_SIZE);
+	for (uint32_t i = 0; i < CROWD_SIZE; i++) {
+		const uint32_t group = i % CROWD_GROUPS;
+		crowd[i] = {group % CLIP_COUNT, 0.13f * group};
+	}
+	return crowd;
+}
+} // namespace
+
+static void BM_AnimCompress(benchmark::State &state)
+{
+	const Library &library = GetLibrary();
+	size_t rawBytes = 0, compressedBytes = 0;
+	for (auto _ : state) {
+		rawBytes = compressedBytes = 0;
+		for (const TGW::Anim::AnimationClip &clip : library.raw) {
+			const TGW::Anim::CompressedClip compressed = TGW::Anim::CompressClip(clip, library.skeleton);
+			rawBytes += clip.GetByteSize();
+			compressedBytes += compressed.GetByteSize();
+			benchmark::DoNotOptimize(compressed.GetKeyCount());
+		}
+	}
+	state.counters["ratio"] = static_cast<double>(rawBytes) / compressedBytes;
+	state.counters["KiB"] = compressedBytes / 1024.0;
+}
+BENCHMARK(BM_AnimCompress)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_AnimEvaluatePose(benchmark::State &state)
+{
+	const Library &library = GetLibrary();
+	std::vector<TGW::Anim::JointTransform> pose(JOINT_COUNT);
+	std::vector<DirectX::XMFLOAT4X4> matrices(JOINT_COUNT);
+	float time = 0.0f;
+	for (auto _ : state) {
+		library.clips[0].Sample(time, pose);
+		TGW::Anim::BuildSkinningMatrices(library.skeleton, pose, matrices);
+		benchmark::DoNotOptimize(matrices.data());
+		time = std::fmod(time + TICK_SECONDS * 0.37f, library.clips[0].GetDuration());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AnimEvaluatePose)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Arg 0 evaluates every soldier on its own, arg 1 goes through the pose cache
+static void BM_AnimCrowd(benchmark::State &state)
+{
+	const Library &library = GetLibrary();
+	std::vector<TGW::Anim::AnimationInstance> crowd = MakeCrowd();
+	TGW::Anim::PoseCache cache{library.skeleton, library.clips};
+
+	const bool shared = state.range(0) != 0;
+	std::vector<DirectX::XMFLOAT4X4> own(size_t{CROWD_SIZE} * JOINT_COUNT);
+	size_t evaluated = 0;
+	for (auto _ : state) {
+		for (TGW::Anim::AnimationInstance &soldier : crowd) {
+			soldier.time = std::fmod(soldier.time + TICK_SECONDS, library.clips[soldier.clip].GetDuration());
+		}
+		if (shared) {
+			cache.Evaluate(crowd);
+			evaluated += cache.GetEvaluatedCount();
+			continue;
+		}
+		TGW::JobSystem::Get().ParallelFor(CROWD_SIZE, 16, [&](uint32_t begin, uint32_t end) {
+			std::vector<TGW::Anim::JointTransform> soldierPose(JOINT_COUNT);
+			for (uint32_t i = begin; i < end; i++) {
+				library.clips[crowd[i].clip].Sample(crowd[i].time, soldierPose);
+				const std::span<DirectX::XMFLOAT4X4> matrices{own.data() + size_t{i} * JOINT_COUNT, JOINT_COUNT};
+				TGW::Anim::BuildSkinningMatrices(library.skeleton, soldierPose, matrices);
+			}
+		});
+		evaluated += CROWD_SIZE;
+	}
+	state.counters["evaluated"] = static_cast<double>(evaluated) / state.iterations();
+	state.SetItemsProcessed(state.iterations() * CROWD_SIZE);
+}
+BENCHMARK(BM_AnimCrowd)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,142 @@
+#include "archive/archive_reader.h"
+#include "archive/archive_writer.h"
+#include "core/file_mapping.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <fstream>
+#include <random>
+
+// A synthetic level: a couple of thousand files between 4 KiB and 1 MiB with texture-like redundancy,
+// loaded once as loose files and once from a packed archive. The data is generated once under $TMPDIR.
+// Cold numbers need $TMPDIR on a real disk, tmpfs pages cannot be evicted.
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t LEVEL_FILE_COUNT = 2000;
+constexpr uint32_t LEVEL_SEED = 1234;
+
+struct Level {
+	fs::path root;
+	fs::path archive;
+	std::vector<std::string> paths;
+	uint64_t totalBytes = 0;
+};
+
+std::vector<uint8_t> MakeAssetBytes(std::mt19937 &rng, size_t size)
+{
+	std::vector<uint8_t> data(size);
+	uint8_t value = static_cast<uint8_t>(rng());
+	for (size_t i = 0; i < size; i++) {
+		// Runs of slowly drifting values with some noise
+		if (rng() % 16 == 0) {
+			value = static_cast<uint8_t>(value + rng() % 5 - 2);
+		}
+		data[i] = (rng() % 64 == 0) ? static_cast<uint8_t>(rng()) : value;
+	}
+	return data;
+}
+
+bool WriteLevel(const Level &level)
+{
+	fs::create_directories(level.root / "loose");
+
+	std::mt19937 rng{LEVEL_SEED};
+	std::uniform_real_distribution<double> logSize{12.0, 20.0};
+	TGW::Archive::ArchiveWriter writer;
+	for (const auto &path : level.paths) {
+		std::vector<uint8_t> data = MakeAssetBytes(rng, static_cast<size_t>(std::exp2(logSize(rng))));
+		std::ofstream file{level.root / path, std::ios::binary | std::ios::trunc};
+		file.write(reinterpret_cast<const char *>(data.data()), data.size());
+		if (!file || !writer.Add(path, std::move(data))) {
+			return false;
+		}
+	}
+	return writer.Write(level.archive);
+}
+
+const Level *GetLevel()
+{
+	static const std::optional<Level> level = []() -> std::optional<Level> {
+		Level level;
+		level.root = fs::temp_directory_path() / "shellshock_bench_level";
+		level.archive = level.root / "level.pak";
+		for (uint32_t i = 0; i < LEVEL_FILE_COUNT; i++) {
+			level.paths.push_back("loose/asset_" + std::to_string(i) + (i % 3 == 0 ? ".glb" : ".png"));
+		}
+
+		std::error_code error;
+		if (!fs::exists(level.archive, error) && !WriteLevel(level)) {
+			return {};
+		}
+		for (const auto &path : level.paths) {
+			level.totalBytes += fs::file_size(level.root / path, error);
+		}
+		return level;
+	}();
+	return level ? &level.value() : nullptr;
+}
+
+void EvictLooseFiles(const Level &level)
+{
+	for (const auto &path : level.paths) {
+		TGW::FileMapping file;
+		if (file.Open(level.root / path)) {
+			file.Evict(0, file.GetSize());
+		}
+	}
+}
+} // namespace
+
+static void BM_LevelLoadLooseFiles(benchmark::State &state)
+{
+	const Level *level = GetLevel();
+	if (!level) {
+		state.SkipWithError("Failed to generate the level");
+		return;
+	}
+
+	const bool cold = state.range(0) != 0;
+	for (auto _ : state) {
+		if (cold) {
+			state.PauseTiming();
+			EvictLooseFiles(*level);
+			state.ResumeTiming();
+		}
+		for (const auto &path : level->paths) {
+			std::ifstream file{level->root / path, std::ios::binary | std::ios::ate};
+			std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(reinterpret_cast<char *>(data.data()), data.size());
+			benchmark::DoNotOptimize(data.data());
+		}
+	}
+	state.SetBytesProcessed(state.iterations() * level->totalBytes);
+}
+BENCHMARK(BM_LevelLoadLooseFiles)->ArgName("cold")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_LevelLoadArchive(benchmark::State &state)
+{
+	const Level *level = GetLevel();
+	TGW::Archive::ArchiveReader reader;
+	if (!level || !reader.Open(level->archive)) {
+		state.SkipWithError("Failed to open the level archive");
+		return;
+	}
+
+	const bool cold = state.range(0) != 0;
+	for (auto _ : state) {
+		if (cold) {
+			state.PauseTiming();
+			reader.Evict();
+			state.ResumeTiming();
+		}
+		auto assets = reader.ReadBatch(level->paths);
+		benchmark::DoNotOptimize(assets.data());
+	}
+	state.SetBytesProcessed(state.iterations() * level->totalBytes);
+	state.counters["archive_bytes"] = static_cast<double>(reader.GetFileSize());
+}
+BENCHMARK(BM_LevelLoadArchive)->ArgName("cold")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,30 @@
+#include "camera.h"
+
+#include <benchmark/benchmark.h>
+
+using namespace DirectX;
+
+static void BM_CameraViewProjection(benchmark::State &state)
+{
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	for (auto _ : state) {
+		XMMATRIX viewProjection = XMMatrixMultiply(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+		XMVECTOR position = camera.GetPosition();
+		benchmark::DoNotOptimize(viewProjection);
+		benchmark::DoNotOptimize(position);
+	}
+}
+BENCHMARK(BM_CameraViewProjection);
+
+// What HandleMouse does every frame while the cursor sits on a screen corner with the middle button held
+static void BM_CameraPanOrbit(benchmark::State &state)
+{
+	Camera camera;
+	for (auto _ : state) {
+		camera.Pan(1, -1);
+		camera.Orbit(3.0f);
+		benchmark::DoNotOptimize(camera.GetTarget());
+	}
+}
+BENCHMARK(BM_CameraPanOrbit);
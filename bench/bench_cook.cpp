@@ -0,0 +1,206 @@
+#include "cook/batch_cooker.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <random>
+
+// A synthetic content tree: a few hundred OBJ models with their own .mtl, drawing on a shared texture pool.
+// Full cooks start from an empty output and cache, no-op cooks find everything up to date, and the single
+// change cooks rebuild one output each.
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t CORPUS_MODEL_COUNT = 300;
+constexpr uint32_t CORPUS_TEXTURE_COUNT = 64;
+constexpr uint32_t CORPUS_GRID_SIZE = 32;
+constexpr size_t CORPUS_TEXTURE_SIZE = 256 * 1024;
+constexpr uint32_t CORPUS_SEED = 4321;
+
+struct Corpus {
+	fs::path content;
+	fs::path output;
+};
+
+std::string MakeObj(uint32_t model, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> height{0.0f, 1.0f};
+	std::string obj = "mtllib model_" + std::to_string(model) + ".mtl\nusemtl main\n";
+	for (uint32_t z = 0; z <= CORPUS_GRID_SIZE; z++) {
+		for (uint32_t x = 0; x <= CORPUS_GRID_SIZE; x++) {
+			obj += "v " + std::to_string(x) + " " + std::to_string(height(rng)) + " " + std::to_string(z) + "\n";
+			obj += "vt " + std::to_string(x / float(CORPUS_GRID_SIZE)) + " " + std::to_string(z / float(CORPUS_GRID_SIZE)) + "\n";
+		}
+	}
+	// OBJ indices are 1 based
+	const uint32_t stride = CORPUS_GRID_SIZE + 1;
+	for (uint32_t z = 0; z < CORPUS_GRID_SIZE; z++) {
+		for (uint32_t x = 0; x < CORPUS_GRID_SIZE; x++) {
+			const uint32_t i = z * stride + x + 1;
+			const std::string a = std::to_string(i), b = std::to_string(i + 1), c = std::to_string(i + stride),
+							  d = std::to_string(i + stride + 1);
+			obj += "f " + a + "/" + a + " " + c + "/" + c + " " + b + "/" + b + "\n";
+			obj += "f " + b + "/" + b + " " + c + "/" + c + " " + d + "/" + d + "\n";
+		}
+	}
+	return obj;
+}
+
+std::string MakeMtl(uint32_t model)
+{
+	const uint32_t diffuse = model % CORPUS_TEXTURE_COUNT;
+	const uint32_t normal = (model * 7 + 3) % CORPUS_TEXTURE_COUNT;
+	return "newmtl main\nmap_Kd ../textures/texture_" + std::to_string(diffuse) + ".png\nmap_Bump ../textures/texture_" +
+		   std::to_string(normal) + ".png\n";
+}
+
+bool WriteText(const fs::path &path, std::string_view text)
+{
+	std::ofstream file{path, std::ios::binary | std::ios::trunc};
+	return static_cast<bool>(file.write(text.data(), text.size()));
+}
+
+bool WriteCorpus(const fs::path &content)
+{
+	fs::create_directories(content / "models");
+	fs::create_directories(content / "textures");
+
+	std::mt19937 rng{CORPUS_SEED};
+	for (uint32_t i = 0; i < CORPUS_MODEL_COUNT; i++) {
+		const fs::path base = content / "models" / ("model_" + std::to_string(i));
+		if (!WriteText(fs::path{base}.replace_extension(".obj"), MakeObj(i, rng)) ||
+			!WriteText(fs::path{base}.replace_extension(".mtl"), MakeMtl(i))) {
+			return false;
+		}
+	}
+
+	std::string texture(CORPUS_TEXTURE_SIZE, '\0');
+	for (uint32_t i = 0; i < CORPUS_TEXTURE_COUNT; i++) {
+		for (char &c : texture) {
+			c = static_cast<char>(rng());
+		}
+		if (!WriteText(content / "textures" / ("texture_" + std::to_string(i) + ".png"), texture)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const Corpus *GetCorpus()
+{
+	static const std::optional<Corpus> corpus = []() -> std::optional<Corpus> {
+		Corpus corpus;
+		corpus.content = fs::temp_directory_path() / "shellshock_bench_cook" / "content";
+		corpus.output = fs::temp_directory_path() / "shellshock_bench_cook" / "cooked";
+
+		std::error_code error;
+		if (!fs::exists(corpus.content / "textures", error) && !WriteCorpus(corpus.content)) {
+			return {};
+		}
+		return corpus;
+	}();
+	return corpus ? &corpus.value() : nullptr;
+}
+
+void ReportStats(benchmark::State &state, const TGW::Cook::CookStats &stats)
+{
+	state.counters["models"] = stats.models;
+	state.counters["textures"] = stats.textures;
+	state.counters["cooked"] = stats.cooked;
+}
+
+// Makes sure there is a complete, current output to start from
+bool CookCorpus(const Corpus &corpus)
+{
+	const TGW::Cook::CookStats stats = TGW::Cook::BatchCooker{corpus.content, corpus.output}.Run();
+	return stats.errors.empty() && stats.models == CORPUS_MODEL_COUNT;
+}
+} // namespace
+
+static void BM_CookFull(benchmark::State &state)
+{
+	const Corpus *corpus = GetCorpus();
+	if (!corpus) {
+		state.SkipWithError("Failed to generate the corpus");
+		return;
+	}
+
+	TGW::Cook::CookStats stats;
+	for (auto _ : state) {
+		state.PauseTiming();
+		std::error_code error;
+		fs::remove_all(corpus->output, error);
+		state.ResumeTiming();
+
+		stats = TGW::Cook::BatchCooker{corpus->content, corpus->output}.Run();
+	}
+	ReportStats(state, stats);
+}
+BENCHMARK(BM_CookFull)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_CookNoOp(benchmark::State &state)
+{
+	const Corpus *corpus = GetCorpus();
+	if (!corpus || !CookCorpus(*corpus)) {
+		state.SkipWithError("Failed to cook the corpus");
+		return;
+	}
+
+	TGW::Cook::CookStats stats;
+	for (auto _ : state) {
+		stats = TGW::Cook::BatchCooker{corpus->content, corpus->output}.Run();
+	}
+	ReportStats(state, stats);
+}
+BENCHMARK(BM_CookNoOp)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Rewrites one texture with new content every iteration, which rebuilds that texture alone
+static void BM_CookTextureChanged(benchmark::State &state)
+{
+	const Corpus *corpus = GetCorpus();
+	if (!corpus || !CookCorpus(*corpus)) {
+		state.SkipWithError("Failed to cook the corpus");
+		return;
+	}
+
+	const fs::path texture = corpus->content / "textures" / "texture_0.png";
+	std::string data(CORPUS_TEXTURE_SIZE, '\0');
+	// Seeded per process, content seen by an earlier run would come straight out of the cache
+	uint64_t generation = std::random_device{}();
+	TGW::Cook::CookStats stats;
+	for (auto _ : state) {
+		state.PauseTiming();
+		const std::string stamp = std::to_string(generation++);
+		data.replace(0, stamp.size(), stamp);
+		WriteText(texture, data);
+		state.ResumeTiming();
+
+		stats = TGW::Cook::BatchCooker{corpus->content, corpus->output}.Run();
+	}
+	ReportStats(state, stats);
+}
+BENCHMARK(BM_CookTextureChanged)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Rewrites one material file, which reimports the model that reads it
+static void BM_CookMaterialChanged(benchmark::State &state)
+{
+	const Corpus *corpus = GetCorpus();
+	if (!corpus || !CookCorpus(*corpus)) {
+		state.SkipWithError("Failed to cook the corpus");
+		return;
+	}
+
+	const fs::path material = corpus->content / "models" / "model_0.mtl";
+	uint64_t generation = std::random_device{}();
+	TGW::Cook::CookStats stats;
+	for (auto _ : state) {
+		state.PauseTiming();
+		WriteText(material, MakeMtl(0) + "# generation " + std::to_string(generation++) + "\n");
+		state.ResumeTiming();
+
+		stats = TGW::Cook::BatchCooker{corpus->content, corpus->output}.Run();
+	}
+	ReportStats(state, stats);
+}
+BENCHMARK(BM_CookMaterialChanged)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,104 @@
+#include "sim/flow_field.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// Rooms maps: a grid of square rooms with a door in every wall and some rubble inside, the usual shape of the
+// Moving AI "rooms" set. Orders go from one corner to the opposite one, so routes cross the whole map.
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t ROOM_SIZE = 32;
+constexpr uint32_t DOOR_WIDTH = 4;
+constexpr uint32_t RUBBLE_PER_ROOM = 6;
+constexpr uint32_t MAP_SEED = 7;
+constexpr uint32_t ORDER_UNITS = 64;
+
+CostGrid MakeRoomsMap(uint32_t size)
+{
+	std::mt19937 rng{MAP_SEED};
+	std::uniform_int_distribution<uint32_t> door{1, ROOM_SIZE - DOOR_WIDTH - 1};
+	std::uniform_int_distribution<uint32_t> inside{2, ROOM_SIZE - 4};
+	std::uniform_int_distribution<uint32_t> cost{1, 4};
+
+	CostGrid grid{size, size};
+	for (uint32_t wall = ROOM_SIZE; wall < size; wall += ROOM_SIZE) {
+		grid.Fill({wall, 0, wall + 1, size}, COST_BLOCKED);
+		grid.Fill({0, wall, size, wall + 1}, COST_BLOCKED);
+	}
+	for (uint32_t roomZ = 0; roomZ < size; roomZ += ROOM_SIZE) {
+		for (uint32_t roomX = 0; roomX < size; roomX += ROOM_SIZE) {
+			// Doors east and north, the neighbours open the other two walls
+			const uint32_t east = roomZ + door(rng), north = roomX + door(rng);
+			grid.Fill({roomX + ROOM_SIZE, east, roomX + ROOM_SIZE + 1, east + DOOR_WIDTH}, COST_DEFAULT);
+			grid.Fill({north, roomZ + ROOM_SIZE, north + DOOR_WIDTH, roomZ + ROOM_SIZE + 1}, COST_DEFAULT);
+			for (uint32_t i = 0; i < RUBBLE_PER_ROOM; i++) {
+				const uint32_t x = roomX + inside(rng), z = roomZ + inside(rng);
+				grid.Fill({x, z, x + 2, z + 2}, i % 2 ? COST_BLOCKED : static_cast<uint8_t>(cost(rng)));
+			}
+		}
+	}
+	return grid;
+}
+
+std::vector<Cell> MakeStarts(const CostGrid &grid)
+{
+	std::vector<Cell> starts;
+	for (uint32_t i = 0; i < ORDER_UNITS; i++) {
+		const Cell cell{2 + i % 8 * 2, 2 + i / 8 * 2};
+		if (grid.IsPassable(cell)) {
+			starts.push_back(cell);
+		}
+	}
+	return starts;
+}
+
+Cell GetGoal(const CostGrid &grid) { return {grid.GetWidth() - 4, grid.GetHeight() - 4}; }
+} // namespace
+
+// Every sector, what a field for a map wide rally point costs
+static void BM_FlowFieldFull(benchmark::State &state)
+{
+	const CostGrid grid = MakeRoomsMap(static_cast<uint32_t>(state.range(0)));
+	const SectorGraph sectors{grid};
+	FlowField field;
+	for (auto _ : state) {
+		field.Build(grid, sectors, GetGoal(grid), {});
+	}
+	state.counters["sectors"] = field.GetCoveredSectorCount();
+	state.SetItemsProcessed(state.iterations() * grid.GetWidth() * grid.GetHeight());
+}
+BENCHMARK(BM_FlowFieldFull)->Arg(512)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// A group order, only the sectors along the route are computed
+static void BM_FlowFieldCorridor(benchmark::State &state)
+{
+	const CostGrid grid = MakeRoomsMap(static_cast<uint32_t>(state.range(0)));
+	const SectorGraph sectors{grid};
+	const std::vector<Cell> starts = MakeStarts(grid);
+	FlowField field;
+	for (auto _ : state) {
+		field.Build(grid, sectors, GetGoal(grid), starts);
+	}
+	state.counters["sectors"] = field.GetCoveredSectorCount();
+}
+BENCHMARK(BM_FlowFieldCorridor)->Arg(512)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Repeated orders to the same goal come out of the cache
+static void BM_FlowFieldCached(benchmark::State &state)
+{
+	const CostGrid grid = MakeRoomsMap(static_cast<uint32_t>(state.range(0)));
+	const std::vector<Cell> starts = MakeStarts(grid);
+	FlowFieldCache cache{grid};
+	if (!cache.Get(GetGoal(grid), starts)) {
+		state.SkipWithError("Failed to build the field");
+		return;
+	}
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(cache.Get(GetGoal(grid), starts));
+	}
+	state.counters["misses"] = cache.GetMisses();
+}
+BENCHMARK(BM_FlowFieldCached)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,126 @@
+#include "sim/fog_of_war.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+
+// Units of two players walking across a 2 km map with 2 m fog cells, reported time is per simulation tick. At
+// these speeds about a tenth of the units cross a cell border every tick, which is what the incremental update
+// pays for. BM_FogFullRebuild stamps every unit from scratch, the cost without it.
+
+namespace {
+constexpr float MAP_SIZE = 2048.0f;
+constexpr float CELL_SIZE = 2.0f;
+constexpr uint32_t FOG_CELLS = static_cast<uint32_t>(MAP_SIZE / CELL_SIZE);
+constexpr float SIGHT_RADIUS = 16.0f;
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+constexpr uint32_t PLAYER_COUNT = 2;
+constexpr uint32_t MARCH_SEED = 11;
+
+struct March {
+	std::vector<float> x, z;
+	std::vector<float> velocityX, velocityZ;
+	std::vector<uint32_t> observers;
+
+	void Tick()
+	{
+		for (size_t i = 0; i < x.size(); i++) {
+			x[i] += velocityX[i] * TICK_SECONDS;
+			z[i] += velocityZ[i] * TICK_SECONDS;
+			if (x[i] < 0.0f || x[i] > MAP_SIZE) {
+				velocityX[i] = -velocityX[i];
+			}
+			if (z[i] < 0.0f || z[i] > MAP_SIZE) {
+				velocityZ[i] = -velocityZ[i];
+			}
+		}
+	}
+};
+
+March MakeMarch(uint32_t count)
+{
+	std::mt19937 rng{MARCH_SEED};
+	std::uniform_real_distribution<float> coordinate{0.0f, MAP_SIZE};
+	std::uniform_real_distribution<float> velocity{-6.0f, 6.0f};
+	March march;
+	for (uint32_t i = 0; i < count; i++) {
+		march.x.push_back(coordinate(rng));
+		march.z.push_back(coordinate(rng));
+		march.velocityX.push_back(velocity(rng));
+		march.velocityZ.push_back(velocity(rng));
+	}
+	return march;
+}
+
+// Rolling hills tall enough to hide units behind them
+std::vector<float> MakeHills()
+{
+	std::vector<float> heights(FOG_CELLS * FOG_CELLS);
+	for (uint32_t z = 0; z < FOG_CELLS; z++) {
+		for (uint32_t x = 0; x < FOG_CELLS; x++) {
+			heights[z * FOG_CELLS + x] = 6.0f * (std::sin(x * 0.15f) + std::cos(z * 0.11f));
+		}
+	}
+	return heights;
+}
+
+TGW::Sim::FogOfWar MakeFog(March &march, bool lineOfSight)
+{
+	TGW::Sim::FogOfWar fog{FOG_CELLS, FOG_CELLS, CELL_SIZE, {0.0f, 0.0f}, PLAYER_COUNT};
+	if (lineOfSight) {
+		fog.SetHeights(MakeHills());
+	}
+	march.observers.clear();
+	for (size_t i = 0; i < march.x.size(); i++) {
+		const uint8_t player = static_cast<uint8_t>(i % PLAYER_COUNT);
+		march.observers.push_back(fog.AddObserver(player, {march.x[i], march.z[i]}, SIGHT_RADIUS));
+	}
+	return fog;
+}
+} // namespace
+
+static void BM_FogUpdate(benchmark::State &state)
+{
+	const bool lineOfSight = state.range(1) != 0;
+	March march = MakeMarch(static_cast<uint32_t>(state.range(0)));
+	TGW::Sim::FogOfWar fog = MakeFog(march, lineOfSight);
+	for (auto _ : state) {
+		march.Tick();
+		fog.MoveObservers(march.observers, march.x, march.z);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.counters["restamped_pct"] =
+		100.0 * static_cast<double>(fog.GetRestampCount()) / (static_cast<double>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_FogUpdate)
+	->ArgNames({"units", "los"})
+	->ArgsProduct({{1'000, 10'000, 100'000}, {0, 1}})
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+static void BM_FogFullRebuild(benchmark::State &state)
+{
+	March march = MakeMarch(static_cast<uint32_t>(state.range(0)));
+	for (auto _ : state) {
+		TGW::Sim::FogOfWar fog = MakeFog(march, false);
+		benchmark::DoNotOptimize(fog.GetVisibleBits(0).data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FogFullRebuild)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// What the renderer pays when a player's fog changed
+static void BM_FogTexels(benchmark::State &state)
+{
+	March march = MakeMarch(10'000);
+	const TGW::Sim::FogOfWar fog = MakeFog(march, false);
+	std::vector<uint8_t> texels;
+	for (auto _ : state) {
+		fog.BuildTexels(0, texels);
+		benchmark::DoNotOptimize(texels.data());
+	}
+	state.SetBytesProcessed(state.iterations() * texels.size());
+}
+BENCHMARK(BM_FogTexels)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,183 @@
+#include "cook/cooked_model.h"
+#include "gltf/gltf_loader.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <fstream>
+
+// A single GLB with a few large interleaved grid meshes and an embedded image, loaded natively and through Assimp.
+// Both paths produce the same MeshData, the gap between them is what the native loader saves per model.
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t GLB_MESH_COUNT = 8;
+constexpr uint32_t GLB_GRID_SIZE = 256;
+constexpr size_t GLB_IMAGE_SIZE = 4 * 1024 * 1024;
+
+template <typename T> void Append(std::vector<uint8_t> &out, const T &value)
+{
+	const size_t offset = out.size();
+	out.resize(offset + sizeof(T));
+	std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+void Pad(std::vector<uint8_t> &out, uint8_t value)
+{
+	while (out.size() % 4 != 0) {
+		out.push_back(value);
+	}
+}
+
+std::vector<uint8_t> MakeGlb()
+{
+	const uint32_t side = GLB_GRID_SIZE + 1;
+	const uint32_t vertexCount = side * side;
+	const uint32_t indexCount = GLB_GRID_SIZE * GLB_GRID_SIZE * 6;
+	const uint32_t vertexBytes = vertexCount * 8 * sizeof(float);
+	const uint32_t indexBytes = indexCount * sizeof(uint32_t);
+
+	// Every mesh gets its own interleaved position/normal/uv view and index view
+	std::vector<uint8_t> bin;
+	std::string views, accessors, meshes;
+	for (uint32_t mesh = 0; mesh < GLB_MESH_COUNT; mesh++) {
+		const size_t vertexOffset = bin.size();
+		for (uint32_t z = 0; z < side; z++) {
+			for (uint32_t x = 0; x < side; x++) {
+				const float vertex[8] = {
+					float(x), float((x * 7 + z * 13 + mesh) % 17) * 0.1f, float(z), 0.0f, 1.0f, 0.0f, float(x) / GLB_GRID_SIZE,
+					float(z) / GLB_GRID_SIZE};
+				Append(bin, vertex);
+			}
+		}
+		const size_t indexOffset = bin.size();
+		for (uint32_t z = 0; z < GLB_GRID_SIZE; z++) {
+			for (uint32_t x = 0; x < GLB_GRID_SIZE; x++) {
+				const uint32_t i = z * side + x;
+				for (uint32_t index : {i, i + side, i + 1, i + 1, i + side, i + side + 1}) {
+					Append(bin, index);
+				}
+			}
+		}
+
+		const std::string v = std::to_string(mesh * 2), a = std::to_string(mesh * 4);
+		views += (mesh ? "," : "") + std::string{"{\"buffer\":0,\"byteOffset\":"} + std::to_string(vertexOffset) +
+				 ",\"byteLength\":" + std::to_string(vertexBytes) + ",\"byteStride\":32},{\"buffer\":0,\"byteOffset\":" +
+				 std::to_string(indexOffset) + ",\"byteLength\":" + std::to_string(indexBytes) + "}";
+		const std::string count = std::to_string(vertexCount);
+		accessors += (mesh ? "," : "") + std::string{"{\"bufferView\":"} + v + ",\"componentType\":5126,\"count\":" + count +
+					 ",\"type\":\"VEC3\"},{\"bufferView\":" + v + ",\"byteOffset\":12,\"componentType\":5126,\"count\":" +
+					 count + ",\"type\":\"VEC3\"},{\"bufferView\":" + v +
+					 ",\"byteOffset\":24,\"componentType\":5126,\"count\":" + count + ",\"type\":\"VEC2\"},{\"bufferView\":" +
+					 std::to_string(mesh * 2 + 1) + ",\"componentType\":5125,\"count\":" + std::to_string(indexCount) +
+					 ",\"type\":\"SCALAR\"}";
+		meshes += (mesh ? "," : "") + std::string{"{\"primitives\":[{\"attributes\":{\"POSITION\":"} + a +
+				  ",\"NORMAL\":" + std::to_string(mesh * 4 + 1) + ",\"TEXCOORD_0\":" + std::to_string(mesh * 4 + 2) +
+				  "},\"indices\":" + std::to_string(mesh * 4 + 3) + ",\"material\":0}]}";
+	}
+
+	const size_t imageOffset = bin.size();
+	for (size_t i = 0; i < GLB_IMAGE_SIZE; i++) {
+		bin.push_back(static_cast<uint8_t>(i * 31));
+	}
+	Pad(bin, 0);
+	views += ",{\"buffer\":0,\"byteOffset\":" + std::to_string(imageOffset) + ",\"byteLength\":" +
+			 std::to_string(GLB_IMAGE_SIZE) + "}";
+
+	std::string nodes, nodeList;
+	for (uint32_t mesh = 0; mesh < GLB_MESH_COUNT; mesh++) {
+		nodes += (mesh ? "," : "") + std::string{"{\"mesh\":"} + std::to_string(mesh) + "}";
+		nodeList += (mesh ? "," : "") + std::to_string(mesh);
+	}
+
+	const std::string json =
+		"{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[" + nodeList + "]}],\"nodes\":[" + nodes +
+		"],\"meshes\":[" + meshes + "],\"materials\":[{\"pbrMetallicRoughness\":{\"baseColorTexture\":{\"index\":0}}}]," +
+		"\"textures\":[{\"source\":0}],\"images\":[{\"bufferView\":" + std::to_string(GLB_MESH_COUNT * 2) +
+		",\"mimeType\":\"image/png\"}],\"bufferViews\":[" + views + "],\"accessors\":[" + accessors +
+		"],\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}]}";
+
+	std::vector<uint8_t> chunk{json.begin(), json.end()};
+	Pad(chunk, ' ');
+
+	std::vector<uint8_t> glb;
+	Append(glb, uint32_t{0x46546C67}); // "glTF"
+	Append(glb, uint32_t{2});
+	Append(glb, static_cast<uint32_t>(12 + 8 + chunk.size() + 8 + bin.size()));
+	Append(glb, static_cast<uint32_t>(chunk.size()));
+	Append(glb, uint32_t{0x4E4F534A}); // "JSON"
+	glb.insert(glb.end(), chunk.begin(), chunk.end());
+	Append(glb, static_cast<uint32_t>(bin.size()));
+	Append(glb, uint32_t{0x004E4942}); // "BIN"
+	glb.insert(glb.end(), bin.begin(), bin.end());
+	return glb;
+}
+
+const fs::path *GetGlbPath()
+{
+	static const std::optional<fs::path> path = []() -> std::optional<fs::path> {
+		const fs::path path = fs::temp_directory_path() / "shellshock_bench_gltf" / "grid.glb";
+		std::error_code error;
+		if (fs::exists(path, error)) {
+			return path;
+		}
+
+		fs::create_directories(path.parent_path(), error);
+		const std::vector<uint8_t> glb = MakeGlb();
+		std::ofstream file{path, std::ios::binary | std::ios::trunc};
+		if (!file.write(reinterpret_cast<const char *>(glb.data()), glb.size())) {
+			return {};
+		}
+		return path;
+	}();
+	return path ? &path.value() : nullptr;
+}
+
+void ReportVertices(benchmark::State &state, const std::vector<MeshData> &meshes)
+{
+	size_t vertices = 0;
+	for (const MeshData &mesh : meshes) {
+		vertices += mesh.vertices.size();
+	}
+	state.SetItemsProcessed(state.iterations() * vertices);
+}
+} // namespace
+
+static void BM_GltfLoadNative(benchmark::State &state)
+{
+	const fs::path *path = GetGlbPath();
+	if (!path) {
+		state.SkipWithError("Failed to write the model");
+		return;
+	}
+
+	std::optional<TGW::Gltf::GltfModel> model;
+	for (auto _ : state) {
+		model = TGW::Gltf::Load(*path);
+		benchmark::DoNotOptimize(model);
+	}
+	if (model) {
+		ReportVertices(state, model->meshes);
+	}
+}
+BENCHMARK(BM_GltfLoadNative)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_GltfLoadAssimp(benchmark::State &state)
+{
+	const fs::path *path = GetGlbPath();
+	if (!path) {
+		state.SkipWithError("Failed to write the model");
+		return;
+	}
+
+	std::optional<TGW::Cook::CookedModel> model;
+	for (auto _ : state) {
+		model = TGW::Cook::ImportModel(*path);
+		benchmark::DoNotOptimize(model);
+	}
+	if (model) {
+		ReportVertices(state, model->meshes);
+	}
+}
+BENCHMARK(BM_GltfLoadAssimp)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,125 @@
+#include "sim/hpa_pathfinder.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// Random block maps, a quarter of them rough ground, with random start/goal pairs across the whole map.
+// Query rates are per thread, the pathfinder is single threaded by design.
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t MAP_SEED = 11;
+constexpr uint32_t QUERY_COUNT = 256;
+constexpr uint32_t BLOCKS_PER_MILLION_CELLS = 12'000;
+
+CostGrid MakeBlockMap(uint32_t size)
+{
+	std::mt19937 rng{MAP_SEED};
+	std::uniform_int_distribution<uint32_t> position{0, size - 1};
+	std::uniform_int_distribution<uint32_t> extent{1, 8};
+	std::uniform_int_distribution<uint32_t> cost{2, 6};
+
+	CostGrid grid{size, size};
+	const uint32_t blocks = static_cast<uint32_t>(uint64_t{size} * size * BLOCKS_PER_MILLION_CELLS / 1'000'000);
+	for (uint32_t i = 0; i < blocks; i++) {
+		const uint32_t x = position(rng), z = position(rng);
+		grid.Fill({x, z, x + extent(rng), z + extent(rng)}, i % 4 ? COST_BLOCKED : static_cast<uint8_t>(cost(rng)));
+	}
+	return grid;
+}
+
+std::vector<std::pair<Cell, Cell>> MakeQueries(const CostGrid &grid)
+{
+	std::mt19937 rng{MAP_SEED + 1};
+	std::uniform_int_distribution<uint32_t> x{0, grid.GetWidth() - 1}, z{0, grid.GetHeight() - 1};
+	std::vector<std::pair<Cell, Cell>> queries;
+	while (queries.size() < QUERY_COUNT) {
+		const Cell start{x(rng), z(rng)}, goal{x(rng), z(rng)};
+		if (grid.IsPassable(start) && grid.IsPassable(goal)) {
+			queries.push_back({start, goal});
+		}
+	}
+	return queries;
+}
+} // namespace
+
+static void BM_HpaBuild(benchmark::State &state)
+{
+	const CostGrid grid = MakeBlockMap(static_cast<uint32_t>(state.range(0)));
+	uint32_t nodes = 0;
+	for (auto _ : state) {
+		HpaPathfinder pathfinder{grid};
+		nodes = pathfinder.GetNodeCount();
+	}
+	state.counters["nodes"] = nodes;
+}
+BENCHMARK(BM_HpaBuild)->Arg(512)->Arg(1024)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Uncached queries, tests/test_hpa.cpp checks how far their paths are from flat A*
+static void BM_HpaQuery(benchmark::State &state)
+{
+	const CostGrid grid = MakeBlockMap(static_cast<uint32_t>(state.range(0)));
+	const auto queries = MakeQueries(grid);
+	HpaPathfinder pathfinder{grid, 0};
+
+	std::vector<Cell> path;
+	size_t i = 0;
+	for (auto _ : state) {
+		const auto &[start, goal] = queries[i++ % queries.size()];
+		benchmark::DoNotOptimize(pathfinder.FindPath(start, goal, path));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HpaQuery)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_HpaQueryCached(benchmark::State &state)
+{
+	const CostGrid grid = MakeBlockMap(static_cast<uint32_t>(state.range(0)));
+	const auto queries = MakeQueries(grid);
+	HpaPathfinder pathfinder{grid, QUERY_COUNT};
+
+	std::vector<Cell> path;
+	size_t i = 0;
+	for (auto _ : state) {
+		const auto &[start, goal] = queries[i++ % queries.size()];
+		benchmark::DoNotOptimize(pathfinder.FindPath(start, goal, path));
+	}
+	state.counters["hit_rate"] = double(pathfinder.GetCacheHits()) / (pathfinder.GetCacheHits() + pathfinder.GetCacheMisses());
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HpaQueryCached)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// The reference the hierarchy is measured against
+static void BM_FlatAStarQuery(benchmark::State &state)
+{
+	const CostGrid grid = MakeBlockMap(static_cast<uint32_t>(state.range(0)));
+	const auto queries = MakeQueries(grid);
+	HpaPathfinder pathfinder{grid, 0};
+
+	std::vector<Cell> path;
+	size_t i = 0;
+	for (auto _ : state) {
+		const auto &[start, goal] = queries[i++ % queries.size()];
+		benchmark::DoNotOptimize(pathfinder.FindFlatPath(start, goal, path));
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FlatAStarQuery)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// A building going up and coming down again, each followed by the incremental graph update
+static void BM_HpaPlaceBuilding(benchmark::State &state)
+{
+	CostGrid grid = MakeBlockMap(static_cast<uint32_t>(state.range(0)));
+	HpaPathfinder pathfinder{grid};
+	const CellRect footprint{grid.GetWidth() / 2, grid.GetHeight() / 2, grid.GetWidth() / 2 + 6, grid.GetHeight() / 2 + 6};
+
+	bool placed = false;
+	for (auto _ : state) {
+		placed = !placed;
+		grid.Fill(footprint, placed ? COST_BLOCKED : COST_DEFAULT);
+		pathfinder.OnCostsChanged(footprint);
+	}
+}
+BENCHMARK(BM_HpaPlaceBuilding)->Arg(512)->Arg(1024)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,57 @@
+#include "camera.h"
+#include "fx/light_clusters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// Explosion lights scattered over a battle around the camera target, assigned to the clusters of the editor
+// camera. tests/test_lights.cpp checks the clusters against a brute force test of every light and froxel.
+
+namespace {
+constexpr float BATTLE_SIZE = 200.0f;
+constexpr float MIN_RADIUS = 3.0f;
+constexpr float MAX_RADIUS = 12.0f;
+constexpr uint32_t LIGHT_SEED = 11;
+
+std::vector<TGW::Fx::PointLight> MakeLights(uint32_t count)
+{
+	std::mt19937 rng{LIGHT_SEED};
+	std::uniform_real_distribution<float> ground{0.0f, BATTLE_SIZE}, height{0.5f, 10.0f}, radius{MIN_RADIUS, MAX_RADIUS};
+	std::uniform_real_distribution<float> channel{0.5f, 1.0f};
+	std::vector<TGW::Fx::PointLight> lights(count);
+	for (TGW::Fx::PointLight &light : lights) {
+		light.position = {ground(rng), height(rng), ground(rng)};
+		light.radius = radius(rng);
+		light.color = {1.0f, channel(rng), channel(rng) * 0.5f};
+		light.intensity = 4.0f;
+	}
+	return lights;
+}
+
+Camera MakeCamera()
+{
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	camera.SetView(DirectX::XMVectorSet(BATTLE_SIZE * 0.5f, 0.0f, BATTLE_SIZE * 0.2f, 1.0f),
+		DirectX::XMVectorSet(0.0f, -0.5f, 1.0f, 0.0f), 15.0f);
+	return camera;
+}
+} // namespace
+
+static void BM_LightAssign(benchmark::State &state)
+{
+	const std::vector<TGW::Fx::PointLight> lights = MakeLights(static_cast<uint32_t>(state.range(0)));
+	const Camera camera = MakeCamera();
+	const DirectX::XMMATRIX view = camera.GetViewMatrix();
+	const DirectX::XMMATRIX projection = camera.GetProjectionMatrix();
+	TGW::Fx::LightClusters clusters;
+	for (auto _ : state) {
+		clusters.Build(view, projection, lights);
+		benchmark::DoNotOptimize(clusters.GetLightIndices().data());
+	}
+	state.counters["clusters"] = static_cast<double>(clusters.GetClusters().size());
+	state.counters["indices"] = static_cast<double>(clusters.GetLightIndices().size());
+	state.SetItemsProcessed(state.iterations() * lights.size());
+}
+BENCHMARK(BM_LightAssign)->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,37 @@
+#include "log.h"
+
+#include <benchmark/benchmark.h>
+
+static void BM_LoggerLogInfo(benchmark::State &state)
+{
+	const std::string message = "Loading Model content/vehicles/tank_t34.glb";
+	for (auto _ : state) {
+		for (int64_t i = 0; i < state.range(0); i++) {
+			TGW::Logger::LogInfo(message);
+		}
+		state.PauseTiming();
+		TGW::Logger::Clear();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoggerLogInfo)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// The Logs panel rebuilds every line through AsString each frame
+static void BM_LogEntriesAsString(benchmark::State &state)
+{
+	TGW::Logger::Clear();
+	for (int64_t i = 0; i < state.range(0); i++) {
+		TGW::Logger::LogInfo("Loading Model content/vehicles/tank_t34.glb");
+	}
+	for (auto _ : state) {
+		size_t length = 0;
+		for (const auto &entry : TGW::Logger::GetAll()) {
+			length += entry.AsString().size();
+		}
+		benchmark::DoNotOptimize(length);
+	}
+	TGW::Logger::Clear();
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LogEntriesAsString)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
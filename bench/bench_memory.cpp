@@ -0,0 +1,65 @@
+#include "core/memory_tracker.h"
+
+#include <benchmark/benchmark.h>
+
+#include <list>
+#include <random>
+#include <unordered_map>
+
+// What counting every allocation costs. The workload is the shape of a level load: hash maps, node based
+// lists and vectors growing by push_back, built once with the standard allocator and once with TrackedAllocator.
+
+namespace {
+constexpr uint32_t WORKLOAD_SEED = 31;
+
+template <typename T, bool TRACKED>
+using BenchAllocator = std::conditional_t<TRACKED, TGW::TrackedAllocator<T, TGW::MEMORY_TAG_SCENE>, std::allocator<T>>;
+
+template <bool TRACKED> size_t RunWorkload(uint32_t items)
+{
+	using Key = uint32_t;
+	using Map = std::unordered_map<Key, uint64_t, std::hash<Key>, std::equal_to<Key>,
+		BenchAllocator<std::pair<const Key, uint64_t>, TRACKED>>;
+	using Vector = std::vector<float, BenchAllocator<float, TRACKED>>;
+	std::mt19937 rng{WORKLOAD_SEED};
+	Map map;
+	std::list<uint64_t, BenchAllocator<uint64_t, TRACKED>> list;
+	std::vector<Vector, BenchAllocator<Vector, TRACKED>> vectors;
+	for (uint32_t i = 0; i < items; i++) {
+		map.emplace(rng(), i);
+		list.push_back(i);
+		if (i % 16 == 0) {
+			vectors.emplace_back();
+		}
+		vectors.back().push_back(static_cast<float>(i));
+	}
+	return map.size() + list.size() + vectors.size();
+}
+
+template <bool TRACKED> void RunWorkloadBench(benchmark::State &state)
+{
+	const uint32_t items = static_cast<uint32_t>(state.range(0));
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(RunWorkload<TRACKED>(items));
+	}
+	state.SetItemsProcessed(state.iterations() * items);
+}
+} // namespace
+
+static void BM_AllocationsUntracked(benchmark::State &state) { RunWorkloadBench<false>(state); }
+BENCHMARK(BM_AllocationsUntracked)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_AllocationsTracked(benchmark::State &state) { RunWorkloadBench<true>(state); }
+BENCHMARK(BM_AllocationsTracked)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Every thread on the same tag, the worst case for the shared counters
+static void BM_TrackerContended(benchmark::State &state)
+{
+	static TGW::MemoryTracker tracker;
+	for (auto _ : state) {
+		tracker.Allocate(TGW::MEMORY_TAG_MESHES, TGW::MEMORY_POOL_CPU, 64);
+		tracker.Free(TGW::MEMORY_TAG_MESHES, TGW::MEMORY_POOL_CPU, 64);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrackerContended)->ThreadRange(1, 8)->UseRealTime();
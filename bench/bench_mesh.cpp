@@ -0,0 +1,53 @@
+#include "mesh_data.h"
+
+#include <assimp/mesh.h>
+#include <benchmark/benchmark.h>
+
+// A grid shaped mesh the way Assimp hands it over after triangulation
+static std::unique_ptr<aiMesh> MakeGridMesh(uint32_t side)
+{
+	auto mesh = std::make_unique<aiMesh>();
+	mesh->mNumVertices = side * side;
+	mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+	mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+	mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+	mesh->mNumUVComponents[0] = 2;
+	for (uint32_t z = 0; z < side; z++) {
+		for (uint32_t x = 0; x < side; x++) {
+			const uint32_t i = z * side + x;
+			mesh->mVertices[i] = aiVector3D(float(x), 0.0f, float(z));
+			mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+			mesh->mTextureCoords[0][i] = aiVector3D(float(x) / side, float(z) / side, 0.0f);
+		}
+	}
+
+	mesh->mNumFaces = (side - 1) * (side - 1) * 2;
+	mesh->mFaces = new aiFace[mesh->mNumFaces];
+	uint32_t face = 0;
+	for (uint32_t z = 0; z + 1 < side; z++) {
+		for (uint32_t x = 0; x + 1 < side; x++) {
+			const uint32_t i = z * side + x;
+			const uint32_t quad[2][3] = {{i, i + side, i + 1}, {i + 1, i + side, i + side + 1}};
+			for (const auto &triangle : quad) {
+				mesh->mFaces[face].mNumIndices = 3;
+				mesh->mFaces[face].mIndices = new unsigned int[3]{triangle[0], triangle[1], triangle[2]};
+				face++;
+			}
+		}
+	}
+	return mesh;
+}
+
+static void BM_BuildMeshData(benchmark::State &state)
+{
+	const auto mesh = MakeGridMesh(static_cast<uint32_t>(state.range(0)));
+	for (auto _ : state) {
+		MeshData data = BuildMeshData(mesh.get());
+		benchmark::DoNotOptimize(data.vertices.data());
+		benchmark::DoNotOptimize(data.indices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * mesh->mNumVertices);
+	state.SetBytesProcessed(
+		state.iterations() * (int64_t(mesh->mNumVertices) * sizeof(Vertex) + int64_t(mesh->mNumFaces) * 3 * sizeof(uint32_t)));
+}
+BENCHMARK(BM_BuildMeshData)->Arg(32)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
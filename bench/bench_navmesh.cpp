@@ -0,0 +1,115 @@
+#include "nav/nav_query.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+// A 256 m map of gentle hills cut in two by a wall with a 4 m gap, as 8 x 8 tiles. Full builds on 1 to 8 threads,
+// the latency of placing or removing a building in the gap from the call to the swapped in tiles, and queries across
+// the wall. tests/test_navmesh.cpp checks the paths and the rebuilds on the same map.
+
+using DirectX::XMFLOAT3;
+using namespace TGW::Nav;
+
+namespace {
+constexpr uint32_t MAP_SAMPLES = 257;
+constexpr float MAP_SIZE = 256.0f;
+constexpr float WALL_X = 128.0f;
+constexpr float GAP_MIN_Z = 120.0f;
+constexpr float GAP_MAX_Z = 124.0f;
+
+float GetGroundHeight(float x, float z) { return 2.0f * std::sin(x * 0.05f) * std::cos(z * 0.04f); }
+
+const TGW::Terrain::Heightmap &GetTerrain()
+{
+	static const TGW::Terrain::Heightmap terrain = [] {
+		std::vector<float> heights(MAP_SAMPLES * MAP_SAMPLES);
+		for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+			for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+				heights[z * MAP_SAMPLES + x] = GetGroundHeight(static_cast<float>(x), static_cast<float>(z));
+			}
+		}
+		return TGW::Terrain::Heightmap{MAP_SAMPLES, MAP_SAMPLES, 1.0f, {0.0f, 0.0f}, std::move(heights)};
+	}();
+	return terrain;
+}
+
+// A closed box from min to max, the way a loaded building mesh would come in
+NavGeometry MakeBox(XMFLOAT3 min, XMFLOAT3 max)
+{
+	MeshData box;
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		box.vertices.push_back(Vertex{
+		  .position = {corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z},
+		  .normal = {0.0f, 1.0f, 0.0f},
+		  .texCoords = {0.0f, 0.0f},
+		});
+	}
+	box.indices = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+	return NavGeometry::FromMeshes(std::span{&box, 1}, DirectX::XMMatrixIdentity());
+}
+
+NavGeometry MakeGapBuilding()
+{
+	return MakeBox({WALL_X - 3.0f, -3.0f, GAP_MIN_Z - 1.0f}, {WALL_X + 3.0f, 6.0f, GAP_MAX_Z + 1.0f});
+}
+
+std::unique_ptr<NavMesh> MakeMesh(float agentRadius, TGW::JobSystem &jobs)
+{
+	const NavMeshSettings settings{.agentRadius = agentRadius};
+	auto mesh = std::make_unique<NavMesh>(settings, DirectX::XMFLOAT2{0.0f, 0.0f}, DirectX::XMFLOAT2{MAP_SIZE, MAP_SIZE},
+		&GetTerrain());
+	mesh->AddGeometry(MakeBox({WALL_X - 0.5f, -3.0f, -1.0f}, {WALL_X + 0.5f, 4.0f, GAP_MIN_Z}));
+	mesh->AddGeometry(MakeBox({WALL_X - 0.5f, -3.0f, GAP_MAX_Z}, {WALL_X + 0.5f, 4.0f, MAP_SIZE + 1.0f}));
+	mesh->Build(jobs);
+	return mesh;
+}
+
+XMFLOAT3 OnGround(float x, float z) { return {x, GetGroundHeight(x, z), z}; }
+} // namespace
+
+static void BM_NavMeshBuild(benchmark::State &state)
+{
+	TGW::JobSystem jobs{static_cast<uint32_t>(state.range(0)) - 1};
+	uint32_t tiles = 0;
+	for (auto _ : state) {
+		const std::unique_ptr<NavMesh> mesh = MakeMesh(0.5f, jobs);
+		tiles = mesh->GetTilesX() * mesh->GetTilesZ();
+	}
+	state.SetItemsProcessed(state.iterations() * tiles);
+}
+BENCHMARK(BM_NavMeshBuild)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// From placing or removing the building to the new tiles being visible to queries
+static void BM_NavMeshTileRebuild(benchmark::State &state)
+{
+	TGW::JobSystem jobs{3};
+	const std::unique_ptr<NavMesh> mesh = MakeMesh(0.5f, jobs);
+	std::optional<uint32_t> building;
+	uint32_t tiles = 0;
+	for (auto _ : state) {
+		if (building) {
+			mesh->RemoveGeometry(*building);
+			building.reset();
+		} else {
+			building = mesh->AddGeometry(MakeGapBuilding());
+		}
+		tiles += mesh->RebuildDirtyAsync(jobs);
+		mesh->WaitForRebuilds();
+	}
+	state.counters["tiles"] = benchmark::Counter(tiles, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_NavMeshTileRebuild)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_NavMeshFindPath(benchmark::State &state)
+{
+	TGW::JobSystem jobs{0};
+	const std::unique_ptr<NavMesh> mesh = MakeMesh(0.5f, jobs);
+	NavQuery query{*mesh};
+	std::vector<XMFLOAT3> path;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(query.FindPath(OnGround(40.0f, 30.0f), OnGround(220.0f, 200.0f), path));
+	}
+	state.counters["expanded"] = query.GetExpandedCount();
+}
+BENCHMARK(BM_NavMeshFindPath)->Unit(benchmark::kMicrosecond);
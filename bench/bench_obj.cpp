@@ -0,0 +1,132 @@
+#include "cook/cooked_model.h"
+#include "obj/obj_loader.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fstream>
+
+// A scan sized OBJ of two height field grids with their own materials, written with quads, v/vt/vn corners and, for
+// the second grid, negative indices. Loaded natively on 1 to 8 threads in MB/s, and through Assimp.
+// tests/test_obj.cpp checks the native load against the same kind of grid and against Assimp.
+
+using DirectX::XMFLOAT3;
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t OBJ_GRID_SIZE = 384;
+constexpr uint32_t OBJ_GRID_COUNT = 2;
+
+// Multiples of 1/8 print and parse exactly
+float GetHeight(uint32_t x, uint32_t z, uint32_t grid)
+{
+	return static_cast<float>((x * 7 + z * 13 + grid * 5) % 64) * 0.125f;
+}
+
+Vertex GetGridVertex(uint32_t x, uint32_t z, uint32_t grid)
+{
+	const float side = static_cast<float>(OBJ_GRID_SIZE);
+	return Vertex{
+	  .position = {static_cast<float>(x), GetHeight(x, z, grid), static_cast<float>(z) + grid * (side + 1.0f)},
+	  .normal = {static_cast<float>((x + z) % 4) * 0.25f, 1.0f, 0.0f},
+	  .texCoords = {static_cast<float>(x) / 256.0f, static_cast<float>(z) / 256.0f},
+	};
+}
+
+std::string MakeObj()
+{
+	const uint32_t side = OBJ_GRID_SIZE + 1;
+	std::string text = "# Height field scan\nmtllib grid.mtl\n";
+	char line[256];
+	for (uint32_t grid = 0; grid < OBJ_GRID_COUNT; grid++) {
+		std::snprintf(line, sizeof(line), "o grid%u\nusemtl ground%u\n", grid, grid);
+		text += line;
+		for (uint32_t z = 0; z < side; z++) {
+			for (uint32_t x = 0; x < side; x++) {
+				const Vertex vertex = GetGridVertex(x, z, grid);
+				const XMFLOAT3 &p = vertex.position;
+				const XMFLOAT3 &n = vertex.normal;
+				std::snprintf(line, sizeof(line), "v %.9g %.9g %.9g\nvt %.9g %.9g\nvn %.9g %.9g %.9g\n", p.x, p.y, p.z,
+					vertex.texCoords.x, vertex.texCoords.y, n.x, n.y, n.z);
+				text += line;
+			}
+		}
+		// The first grid counts from the start of the file, the second back from its last vertex
+		const int64_t base = grid == 0 ? 1 : -int64_t{side} * side;
+		for (uint32_t z = 0; z < OBJ_GRID_SIZE; z++) {
+			for (uint32_t x = 0; x < OBJ_GRID_SIZE; x++) {
+				const int64_t corners[4] = {base + z * side + x, base + (z + 1) * side + x, base + (z + 1) * side + x + 1,
+					base + z * side + x + 1};
+				text += 'f';
+				for (const int64_t corner : corners) {
+					std::snprintf(line, sizeof(line), " %lld/%lld/%lld", static_cast<long long>(corner),
+						static_cast<long long>(corner), static_cast<long long>(corner));
+					text += line;
+				}
+				text += '\n';
+			}
+		}
+	}
+	return text;
+}
+
+const fs::path *GetObjPath()
+{
+	static const std::optional<fs::path> path = []() -> std::optional<fs::path> {
+		const fs::path path = fs::temp_directory_path() / "shellshock_bench_obj" / "grid.obj";
+		std::error_code error;
+		if (fs::exists(path, error)) {
+			return path;
+		}
+
+		fs::create_directories(path.parent_path(), error);
+		const std::string obj = MakeObj();
+		const std::string mtl = "newmtl ground0\nmap_Kd rock.png\n\nnewmtl ground1\nmap_Kd -bm 1 grass.png\nbump grass_n.png\n";
+		std::ofstream mtlFile{path.parent_path() / "grid.mtl", std::ios::binary | std::ios::trunc};
+		std::ofstream objFile{path, std::ios::binary | std::ios::trunc};
+		if (!mtlFile.write(mtl.data(), mtl.size()) || !objFile.write(obj.data(), obj.size())) {
+			return {};
+		}
+		return path;
+	}();
+	return path ? &path.value() : nullptr;
+}
+} // namespace
+
+static void BM_ObjLoadNative(benchmark::State &state)
+{
+	const fs::path *path = GetObjPath();
+	if (!path) {
+		state.SkipWithError("Failed to write the model");
+		return;
+	}
+
+	TGW::JobSystem jobs{static_cast<uint32_t>(state.range(0)) - 1};
+	for (auto _ : state) {
+		std::optional<TGW::Obj::ObjModel> model = TGW::Obj::Load(*path, jobs);
+		benchmark::DoNotOptimize(model);
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fs::file_size(*path)));
+}
+BENCHMARK(BM_ObjLoadNative)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ObjLoadAssimp(benchmark::State &state)
+{
+	const fs::path *path = GetObjPath();
+	if (!path) {
+		state.SkipWithError("Failed to write the model");
+		return;
+	}
+
+	std::optional<TGW::Cook::CookedModel> model;
+	for (auto _ : state) {
+		model = TGW::Cook::ImportModel(*path);
+		benchmark::DoNotOptimize(model);
+	}
+	if (!model) {
+		state.SkipWithError("Assimp failed to load the model");
+		return;
+	}
+	state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fs::file_size(*path)));
+}
+BENCHMARK(BM_ObjLoadAssimp)->Unit(benchmark::kMillisecond)->UseRealTime();
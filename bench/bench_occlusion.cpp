@@ -0,0 +1,133 @@
+#include "cull/occlusion_culler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// A 16x16 block city of detailed tower meshes with 20k units in its streets, seen from a street corner a little
+// above the roofs. Occluders are the towers simplified at import. Reported are the time to rasterize them and to
+// rasterize and test every unit, with the share of units culled.
+
+namespace {
+constexpr uint32_t CITY_BLOCKS = 16;
+constexpr float BLOCK_PITCH = 50.0f;
+constexpr float STREET_WIDTH = 12.0f;
+constexpr uint32_t TOWERS_PER_SIDE = 2;
+constexpr uint32_t FACADE_QUADS = 8; // per side of every face of a tower
+constexpr uint32_t UNIT_COUNT = 20'000;
+constexpr float UNIT_SIZE = 2.0f;
+constexpr uint32_t CITY_SEED = 5;
+
+// Closed unit cube on the ground, x and z in [-0.5, 0.5], y in [0, 1], every face a grid of quads like a facade
+MeshData MakeTower()
+{
+	MeshData mesh;
+	const auto face = [&](DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 u, DirectX::XMFLOAT3 v) {
+		const uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+		for (uint32_t j = 0; j <= FACADE_QUADS; j++) {
+			for (uint32_t i = 0; i <= FACADE_QUADS; i++) {
+				const float s = static_cast<float>(i) / FACADE_QUADS, t = static_cast<float>(j) / FACADE_QUADS;
+				Vertex &vertex = mesh.vertices.emplace_back();
+				vertex.position = {
+					origin.x + u.x * s + v.x * t, origin.y + u.y * s + v.y * t, origin.z + u.z * s + v.z * t};
+			}
+		}
+		for (uint32_t j = 0; j < FACADE_QUADS; j++) {
+			for (uint32_t i = 0; i < FACADE_QUADS; i++) {
+				const uint32_t a = first + j * (FACADE_QUADS + 1) + i, b = a + 1, c = a + FACADE_QUADS + 1, d = c + 1;
+				mesh.indices.insert(mesh.indices.end(), {a, c, b, b, c, d});
+			}
+		}
+	};
+	// u x v points inwards, so every face is clockwise seen from outside
+	face({-0.5f, 0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
+	face({0.5f, 0.0f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
+	face({-0.5f, 0.0f, 0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f});
+	face({0.5f, 0.0f, -0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f});
+	face({-0.5f, 1.0f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f});
+	face({-0.5f, 0.0f, 0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f});
+	return mesh;
+}
+
+struct City {
+	TGW::Cull::OccluderMesh tower;
+	std::vector<TGW::Cull::OccluderInstance> occluders;
+	std::vector<DirectX::XMFLOAT4X4> units;
+	DirectX::XMFLOAT4X4 viewProjection;
+
+	City()
+	{
+		const MeshData towerMesh = MakeTower();
+		tower = TGW::Cull::BuildOccluderMesh({&towerMesh, 1});
+
+		std::mt19937 rng{CITY_SEED};
+		std::uniform_real_distribution<float> height{15.0f, 80.0f};
+		const float lot = (BLOCK_PITCH - STREET_WIDTH) / TOWERS_PER_SIDE;
+		for (uint32_t z = 0; z < CITY_BLOCKS * TOWERS_PER_SIDE; z++) {
+			for (uint32_t x = 0; x < CITY_BLOCKS * TOWERS_PER_SIDE; x++) {
+				const float centerX = (x / TOWERS_PER_SIDE) * BLOCK_PITCH + STREET_WIDTH + (x % TOWERS_PER_SIDE + 0.5f) * lot;
+				const float centerZ = (z / TOWERS_PER_SIDE) * BLOCK_PITCH + STREET_WIDTH + (z % TOWERS_PER_SIDE + 0.5f) * lot;
+				TGW::Cull::OccluderInstance &instance = occluders.emplace_back();
+				instance.mesh = &tower;
+				DirectX::XMStoreFloat4x4(&instance.world,
+					DirectX::XMMatrixMultiply(DirectX::XMMatrixScaling(lot - 2.0f, height(rng), lot - 2.0f),
+						DirectX::XMMatrixTranslation(centerX, 0.0f, centerZ)));
+			}
+		}
+
+		// Units stand in the streets running along x and along z
+		std::uniform_real_distribution<float> along{0.0f, CITY_BLOCKS * BLOCK_PITCH}, across{1.0f, STREET_WIDTH - 1.0f};
+		std::uniform_int_distribution<uint32_t> street{0, CITY_BLOCKS - 1};
+		for (uint32_t i = 0; i < UNIT_COUNT; i++) {
+			const float a = along(rng), b = street(rng) * BLOCK_PITCH + across(rng);
+			DirectX::XMStoreFloat4x4(&units.emplace_back(),
+				i % 2 ? DirectX::XMMatrixTranslation(a, 0.0f, b) : DirectX::XMMatrixTranslation(b, 0.0f, a));
+		}
+
+		const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(DirectX::XMVectorSet(-30.0f, 90.0f, -30.0f, 1.0f),
+			DirectX::XMVectorSet(400.0f, 0.0f, 400.0f, 1.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		const DirectX::XMMATRIX projection =
+			DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3.0f, 16.0f / 9.0f, 0.5f, 3000.0f);
+		DirectX::XMStoreFloat4x4(&viewProjection, DirectX::XMMatrixMultiply(view, projection));
+	}
+};
+
+const City &GetCity()
+{
+	static const City city;
+	return city;
+}
+
+constexpr DirectX::XMFLOAT3 UNIT_MIN{-UNIT_SIZE * 0.5f, 0.0f, -UNIT_SIZE * 0.5f};
+constexpr DirectX::XMFLOAT3 UNIT_MAX{UNIT_SIZE * 0.5f, UNIT_SIZE, UNIT_SIZE * 0.5f};
+} // namespace
+
+static void BM_OcclusionRasterize(benchmark::State &state)
+{
+	const City &city = GetCity();
+	TGW::Cull::OcclusionCuller culler;
+	for (auto _ : state) {
+		culler.RenderOccluders(DirectX::XMLoadFloat4x4(&city.viewProjection), city.occluders);
+		benchmark::DoNotOptimize(culler.GetDepth().data());
+	}
+	state.counters["occluders"] = static_cast<double>(city.occluders.size());
+	state.counters["triangles"] = culler.GetRasterizedTriangleCount();
+}
+BENCHMARK(BM_OcclusionRasterize)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_OcclusionCull(benchmark::State &state)
+{
+	const City &city = GetCity();
+	TGW::Cull::OcclusionCuller culler;
+	uint32_t hidden = 0;
+	for (auto _ : state) {
+		culler.RenderOccluders(DirectX::XMLoadFloat4x4(&city.viewProjection), city.occluders);
+		hidden = 0;
+		for (const DirectX::XMFLOAT4X4 &unit : city.units) {
+			hidden += !culler.IsVisible(UNIT_MIN, UNIT_MAX, DirectX::XMLoadFloat4x4(&unit));
+		}
+	}
+	state.counters["culled_pct"] = 100.0 * hidden / UNIT_COUNT;
+	state.SetItemsProcessed(state.iterations() * UNIT_COUNT);
+}
+BENCHMARK(BM_OcclusionCull)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,120 @@
+#include "fx/particles.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+
+// A battle's worth of smoke columns and fireballs at the given number of live particles, ticked into a steady
+// state before timing. The tick reports particles per ms per core, the billboard stream the sorted instances per
+// second.
+
+namespace {
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+// Smoke lives 4 to 6 seconds at this rate, about 4000 particles a column
+constexpr float SMOKE_RATE = 800.0f;
+constexpr uint32_t SMOKE_CAPACITY = 4096;
+constexpr uint32_t PARTICLES_PER_COLUMN = 4000;
+constexpr float WARM_UP_SECONDS = 6.0f;
+constexpr float BATTLE_SIZE = 500.0f;
+
+TGW::Fx::EmitterDesc MakeSmoke(uint32_t index)
+{
+	return {
+	  .position = {std::fmod(index * 37.0f, BATTLE_SIZE), 0.0f, std::fmod(index * 91.0f, BATTLE_SIZE)},
+	  .radius = 1.0f,
+	  .spread = 0.4f,
+	  .minSpeed = 1.0f,
+	  .maxSpeed = 3.0f,
+	  .minLifetime = 4.0f,
+	  .maxLifetime = 6.0f,
+	  .rate = SMOKE_RATE,
+	  .duration = -1.0f,
+	  .gravityScale = -0.05f,
+	  .drag = 0.3f,
+	  .noiseStrength = 2.0f,
+	  .noiseScale = 6.0f,
+	  .startSize = 1.0f,
+	  .endSize = 6.0f,
+	  .startColor = {0.3f, 0.3f, 0.3f, 0.8f},
+	  .endColor = {0.6f, 0.6f, 0.6f, 0.0f},
+	  .capacity = SMOKE_CAPACITY,
+	  .seed = index + 1,
+	};
+}
+
+TGW::Fx::EmitterDesc MakeFireball(uint32_t index)
+{
+	return {
+	  .position = {std::fmod(index * 53.0f, BATTLE_SIZE), 1.0f, std::fmod(index * 29.0f, BATTLE_SIZE)},
+	  .spread = 3.1f,
+	  .minSpeed = 5.0f,
+	  .maxSpeed = 15.0f,
+	  .minLifetime = 0.3f,
+	  .maxLifetime = 0.8f,
+	  .burst = 300,
+	  .gravityScale = 0.5f,
+	  .drag = 2.0f,
+	  .noiseStrength = 10.0f,
+	  .startSize = 2.0f,
+	  .endSize = 0.5f,
+	  .startColor = {1.0f, 0.8f, 0.3f, 1.0f},
+	  .endColor = {0.5f, 0.1f, 0.0f, 0.0f},
+	  .capacity = 300,
+	  .seed = index + 1000,
+	};
+}
+
+// Smoke columns to hold about particleCount particles, with a fireball going off every tick
+struct Battle {
+	TGW::Fx::ParticleSystem particles;
+	uint32_t fireballs = 0;
+
+	Battle(uint32_t particleCount, TGW::JobSystem &jobs)
+	{
+		for (uint32_t i = 0; i < std::max(1u, particleCount / PARTICLES_PER_COLUMN); i++) {
+			particles.AddEmitter(MakeSmoke(i));
+		}
+		for (float time = 0.0f; time < WARM_UP_SECONDS; time += TICK_SECONDS) {
+			Tick(jobs);
+		}
+	}
+
+	void Tick(TGW::JobSystem &jobs)
+	{
+		particles.AddEmitter(MakeFireball(fireballs++));
+		particles.Tick(TICK_SECONDS, jobs);
+	}
+};
+} // namespace
+
+static void BM_ParticleTick(benchmark::State &state)
+{
+	TGW::JobSystem &jobs = TGW::JobSystem::Get();
+	Battle battle{static_cast<uint32_t>(state.range(0)), jobs};
+	size_t updated = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (auto _ : state) {
+		updated += battle.particles.GetParticleCount();
+		battle.Tick(jobs);
+	}
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	state.counters["particles"] = battle.particles.GetParticleCount();
+	state.counters["per_ms_core"] = updated / elapsed.count() / (jobs.GetWorkerCount() + 1);
+	state.SetItemsProcessed(updated);
+}
+BENCHMARK(BM_ParticleTick)->Arg(100'000)->Arg(500'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ParticleBillboards(benchmark::State &state)
+{
+	TGW::JobSystem &jobs = TGW::JobSystem::Get();
+	Battle battle{static_cast<uint32_t>(state.range(0)), jobs};
+	const DirectX::XMFLOAT3 eye{BATTLE_SIZE * 0.5f, 80.0f, -100.0f};
+	TGW::Fx::BillboardStream stream;
+	for (auto _ : state) {
+		stream.Build(battle.particles, DirectX::XMLoadFloat3(&eye), jobs);
+		benchmark::DoNotOptimize(stream.GetInstances().data());
+	}
+	state.SetItemsProcessed(state.iterations() * stream.GetInstances().size());
+}
+BENCHMARK(BM_ParticleBillboards)->Arg(100'000)->Arg(500'000)->Unit(benchmark::kMillisecond)->UseRealTime();
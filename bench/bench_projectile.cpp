@@ -0,0 +1,107 @@
+#include "sim/projectiles.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+
+// Shells and bullets over a 2 km hilly map with 10k units of two players standing on it, reported time is one
+// simulation tick at the given number of projectiles in flight. Projectiles that land are replaced by new ones,
+// so the count holds.
+
+namespace {
+constexpr uint32_t MAP_SAMPLES = 2049;
+constexpr float MAP_SIZE = static_cast<float>(MAP_SAMPLES - 1);
+constexpr float CELL_SIZE = 8.0f;
+constexpr uint32_t UNIT_COUNT = 10'000;
+constexpr float UNIT_RADIUS = 1.0f;
+constexpr uint32_t PLAYER_COUNT = 2;
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+constexpr uint32_t BATTLE_SEED = 17;
+
+const TGW::Terrain::Heightmap &GetHills()
+{
+	static const TGW::Terrain::Heightmap hills = [] {
+		std::vector<float> heights(size_t{MAP_SAMPLES} * MAP_SAMPLES);
+		for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+			for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+				heights[size_t{z} * MAP_SAMPLES + x] =
+					20.0f * std::sin(x * 0.01f) * std::cos(z * 0.013f) + 3.0f * std::sin((x + z) * 0.07f);
+			}
+		}
+		return TGW::Terrain::Heightmap{MAP_SAMPLES, MAP_SAMPLES, 1.0f, {0.0f, 0.0f}, std::move(heights)};
+	}();
+	return hills;
+}
+
+struct Battlefield {
+	std::vector<float> x, y, z;
+	std::vector<uint8_t> owners;
+	TGW::Sim::SpatialGrid grid{{0.0f, 0.0f}, CELL_SIZE, static_cast<uint32_t>(MAP_SIZE / CELL_SIZE),
+		static_cast<uint32_t>(MAP_SIZE / CELL_SIZE)};
+	std::mt19937 rng{BATTLE_SEED};
+
+	// Units standing on the ground inside a square of side extent around the middle of the map
+	Battlefield(uint32_t unitCount, float extent)
+	{
+		std::uniform_real_distribution<float> coordinate{(MAP_SIZE - extent) * 0.5f, (MAP_SIZE + extent) * 0.5f};
+		for (uint32_t i = 0; i < unitCount; i++) {
+			x.push_back(coordinate(rng));
+			z.push_back(coordinate(rng));
+			y.push_back(GetHills().GetHeight(x.back(), z.back()));
+			owners.push_back(static_cast<uint8_t>(i % PLAYER_COUNT));
+		}
+		grid.Rebuild(x, z);
+	}
+
+	TGW::Sim::ProjectileTargets GetTargets() const
+	{
+		return {&GetHills(), &grid, x, y, z, owners, UNIT_RADIUS};
+	}
+
+	// Shells lobbed from anywhere on the map and bullets skimming over the units, three to one
+	TGW::Sim::ProjectileDesc MakeProjectile(float extent)
+	{
+		std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+		const uint8_t owner = static_cast<uint8_t>(rng() % PLAYER_COUNT);
+		const float middle = MAP_SIZE * 0.5f;
+		if (rng() % 4 != 0) {
+			const float angle = unit(rng) * DirectX::XM_2PI;
+			return {
+			  .position = {MAP_SIZE * unit(rng), 60.0f + 200.0f * unit(rng), MAP_SIZE * unit(rng)},
+			  .velocity = {120.0f * std::cos(angle), 80.0f * (unit(rng) - 0.5f), 120.0f * std::sin(angle)},
+			  .owner = owner,
+			  .payload = 0,
+			};
+		}
+		const float angle = unit(rng) * DirectX::XM_2PI;
+		const float startX = middle + extent * (unit(rng) - 0.5f), startZ = middle + extent * (unit(rng) - 0.5f);
+		return {
+		  .position = {startX, GetHills().GetHeight(startX, startZ) + 1.0f + unit(rng), startZ},
+		  .velocity = {400.0f * std::cos(angle), -4.0f * unit(rng), 400.0f * std::sin(angle)},
+		  .lifetime = 3.0f,
+		  .gravityScale = 0.0f,
+		  .owner = owner,
+		  .payload = 1,
+		};
+	}
+};
+} // namespace
+
+static void BM_ProjectileTick(benchmark::State &state)
+{
+	const uint32_t count = static_cast<uint32_t>(state.range(0));
+	Battlefield field{UNIT_COUNT, MAP_SIZE * 0.5f};
+	TGW::Sim::ProjectileSystem projectiles;
+	size_t impacts = 0;
+	for (auto _ : state) {
+		while (projectiles.GetCount() < count) {
+			projectiles.Spawn(field.MakeProjectile(MAP_SIZE * 0.5f));
+		}
+		projectiles.Tick(TICK_SECONDS, field.GetTargets());
+		impacts += projectiles.GetImpacts().size();
+	}
+	state.counters["impacts"] = static_cast<double>(impacts) / state.iterations();
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ProjectileTick)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond)->UseRealTime();
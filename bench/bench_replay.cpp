@@ -0,0 +1,162 @@
+#include "replay/replay_world.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// A 30 second battle of two 500 unit armies recorded the way a live session would: orders and shots are decided from
+// the running world every tick, along with camera input and model edits. Reported time is a headless replay of the
+// whole stream, with the mean and worst tick. tests/test_replay.cpp checks the format and the determinism on a smaller
+// battle.
+
+using namespace TGW::Replay;
+
+namespace {
+constexpr uint32_t ARMY_SIZE = 500;
+constexpr uint32_t ARMY_COLUMNS = 25;
+constexpr float ARMY_SPACING = 4.0f;
+constexpr float FRONT_DISTANCE = 100.0f;
+constexpr uint32_t BATTLE_TICKS = 900;
+constexpr uint32_t ORDER_INTERVAL = 60;
+constexpr uint32_t SHOTS_PER_TICK = 3;
+constexpr float SHOT_FLIGHT_SECONDS = 1.0f;
+constexpr uint32_t SHOT_DAMAGE = 25;
+constexpr uint32_t BATTLE_SEED = 23;
+
+ReplaySettings GetSettings()
+{
+	return {.tickSeconds = 1.0f / 30.0f, .unitRadius = 1.0f, .battleSize = 1024.0f, .loadModels = false};
+}
+
+// Aims a shell from shooter at the centre of target, arriving after SHOT_FLIGHT_SECONDS if the target stands still
+TGW::Sim::ProjectileDesc Aim(DirectX::XMFLOAT3 shooter, DirectX::XMFLOAT3 target, uint8_t owner, float radius)
+{
+	const float t = SHOT_FLIGHT_SECONDS;
+	const DirectX::XMFLOAT3 start{shooter.x, shooter.y + radius, shooter.z};
+	return {
+	  .position = start,
+	  .velocity = {(target.x - start.x) / t, (target.y + radius - start.y) / t - 0.5f * TGW::Sim::PROJECTILE_GRAVITY * t,
+		  (target.z - start.z) / t},
+	  .lifetime = t * 2.0f,
+	  .gravityScale = 1.0f,
+	  .owner = owner,
+	  .payload = SHOT_DAMAGE,
+	};
+}
+
+// Plays the battle against a live world and records everything it does to it
+CommandStream RecordBattle()
+{
+	CommandRecorder recorder{GetSettings().tickSeconds};
+	ReplayWorld world{GetSettings()};
+	std::mt19937 random{BATTLE_SEED};
+	size_t applied = 0;
+	const auto apply = [&] {
+		const std::vector<Command> &commands = recorder.GetStream().commands;
+		for (; applied < commands.size(); applied++) {
+			world.Apply(commands[applied]);
+		}
+	};
+
+	DirectX::XMFLOAT4X4 headquarters;
+	DirectX::XMStoreFloat4x4(&headquarters, DirectX::XMMatrixTranslation(0.0f, 0.0f, -150.0f));
+	recorder.LoadModel(0, "content/headquarters.glb", headquarters);
+	recorder.LoadModel(1, "content/bunker.obj", headquarters);
+	recorder.SelectModel(0);
+	for (uint8_t owner = 0; owner < 2; owner++) {
+		const float side = owner == 0 ? -1.0f : 1.0f;
+		for (uint32_t i = 0; i < ARMY_SIZE; i++) {
+			recorder.SpawnUnit({
+			  .position = {side * (FRONT_DISTANCE + (i / ARMY_COLUMNS) * ARMY_SPACING), 0.0f,
+				  (static_cast<float>(i % ARMY_COLUMNS) - ARMY_COLUMNS * 0.5f) * ARMY_SPACING},
+			  .heading = 0.0f,
+			  .maxSpeed = 5.0f,
+			  .health = 100.0f,
+			  .owner = owner,
+			  .model = owner,
+			});
+		}
+	}
+
+	for (uint32_t tick = 0; tick < BATTLE_TICKS; tick++) {
+		const TGW::Sim::UnitStore &units = world.GetUnits();
+		const uint32_t count = units.GetCount();
+		if (tick % ORDER_INTERVAL == 0) {
+			// Everyone advances towards the other army, with some spread
+			std::uniform_real_distribution<float> spread{-10.0f, 10.0f};
+			for (uint32_t i = 0; i < count; i++) {
+				const float towards = units.GetOwners()[i] == 0 ? 15.0f : -15.0f;
+				recorder.MoveUnit(
+					units.GetId(i), {units.GetPositionsX()[i] + towards, units.GetPositionsZ()[i] + spread(random)});
+			}
+		}
+		if (count > 0) {
+			std::uniform_int_distribution<uint32_t> pick{0, count - 1};
+			for (uint32_t shot = 0; shot < SHOTS_PER_TICK * 2; shot++) {
+				const uint32_t shooter = pick(random);
+				const uint32_t target = pick(random);
+				const uint8_t owner = units.GetOwners()[shooter];
+				if (units.GetOwners()[target] == owner) {
+					continue;
+				}
+				const DirectX::XMFLOAT3 from{units.GetPositionsX()[shooter], units.GetPositionsY()[shooter],
+					units.GetPositionsZ()[shooter]};
+				const DirectX::XMFLOAT3 to{
+					units.GetPositionsX()[target], units.GetPositionsY()[target], units.GetPositionsZ()[target]};
+				recorder.Fire(Aim(from, to, owner, GetSettings().unitRadius));
+			}
+		}
+
+		// Someone at the screen edge and on the mouse wheel, dragging the selected model now and then
+		if (tick % 4 == 0) {
+			recorder.Orbit(static_cast<float>(tick % 7) - 3.0f);
+		}
+		if (tick % 3 == 0) {
+			recorder.Pan(tick % 2 == 0 ? 1 : -1, 1);
+		}
+		if (tick % 90 == 45) {
+			recorder.Zoom(tick % 180 == 45 ? 120 : -120);
+		}
+		if (tick % 150 == 100) {
+			headquarters._41 += 2.0f;
+			recorder.MoveModel(0, headquarters);
+		}
+		if (tick == BATTLE_TICKS / 2) {
+			recorder.RemoveModel(1);
+			recorder.SelectModel(std::nullopt);
+		}
+
+		apply();
+		world.Tick();
+		recorder.NextTick();
+	}
+	return recorder.GetStream();
+}
+
+const CommandStream &GetBattle()
+{
+	static const CommandStream battle = RecordBattle();
+	return battle;
+}
+} // namespace
+
+static void BM_ReplayBattle(benchmark::State &state)
+{
+	const CommandStream &stream = GetBattle();
+	ReplayReport report;
+	for (auto _ : state) {
+		state.PauseTiming();
+		ReplayWorld world{GetSettings()};
+		state.ResumeTiming();
+		report = RunReplay(stream, world);
+	}
+	double sum = 0.0;
+	for (const float tick : report.tickMicros) {
+		sum += tick;
+	}
+	state.counters["tick_mean_us"] = sum / report.tickMicros.size();
+	state.counters["tick_max_us"] = *std::ranges::max_element(report.tickMicros);
+	state.counters["stream_kb"] = Serialize(stream).size() / 1024.0;
+	state.SetItemsProcessed(state.iterations() * stream.tickCount);
+}
+BENCHMARK(BM_ReplayBattle)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,136 @@
+#include "camera.h"
+#include "scene/scene_file.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+using namespace DirectX;
+
+namespace {
+constexpr uint32_t UNIQUE_MODELS = 64;
+
+// Mirrors the per model constant buffer Editor::Render fills
+struct DrawConstants {
+	XMMATRIX model;
+	XMMATRIX view;
+	XMMATRIX projection;
+};
+
+// Stand-in for Model without the GPU resources
+struct MapEntity {
+	std::string name;
+	std::string path;
+	uint32_t id;
+	XMMATRIX worldMatrix;
+};
+
+TGW::Scene::SceneData MakeScene(uint32_t entityCount)
+{
+	std::mt19937 rng{42};
+	std::uniform_real_distribution<float> position{-500.0f, 500.0f};
+	std::uniform_real_distribution<float> angle{0.0f, XM_2PI};
+
+	TGW::Scene::SceneData scene;
+	scene.camera = {{0.0f, 0.0f, 0.0f}, {0.5f, -0.7f, 0.5f}, 10.0f};
+	for (uint32_t i = 0; i < UNIQUE_MODELS; i++) {
+		scene.modelPaths.push_back("content/models/model_" + std::to_string(i) + ".glb");
+	}
+	for (uint32_t i = 0; i < entityCount; i++) {
+		scene.modelIndices.push_back(i % UNIQUE_MODELS);
+		const XMMATRIX world =
+			XMMatrixMultiply(XMMatrixRotationY(angle(rng)), XMMatrixTranslation(position(rng), 0.0f, position(rng)));
+		XMStoreFloat4x4(&scene.worldMatrices.emplace_back(), world);
+		scene.flags.push_back(i == 0 ? TGW::Scene::ENTITY_FLAG_SELECTED : TGW::Scene::ENTITY_FLAG_NONE);
+	}
+	return scene;
+}
+} // namespace
+
+// The editor today: a hash map of models, camera matrices rebuilt for every model
+static void BM_SceneIterateMap(benchmark::State &state)
+{
+	const TGW::Scene::SceneData scene = MakeScene(static_cast<uint32_t>(state.range(0)));
+	std::unordered_map<uint32_t, MapEntity> entities;
+	for (uint32_t i = 0; i < scene.GetEntityCount(); i++) {
+		entities.insert({i, {"model", scene.modelPaths[scene.modelIndices[i]], i, XMLoadFloat4x4(&scene.worldMatrices[i])}});
+	}
+
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	std::vector<DrawConstants> constants(entities.size());
+	for (auto _ : state) {
+		size_t i = 0;
+		for (const auto &[id, entity] : entities) {
+			constants[i++] = {
+			  XMMatrixTranspose(entity.worldMatrix),
+			  XMMatrixTranspose(camera.GetViewMatrix()),
+			  XMMatrixTranspose(camera.GetProjectionMatrix()),
+			};
+		}
+		benchmark::DoNotOptimize(constants.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SceneIterateMap)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+// Same output from the contiguous arrays a scene file loads into
+static void BM_SceneIterateArrays(benchmark::State &state)
+{
+	const TGW::Scene::SceneData scene = MakeScene(static_cast<uint32_t>(state.range(0)));
+
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	std::vector<DrawConstants> constants(scene.GetEntityCount());
+	for (auto _ : state) {
+		const XMMATRIX view = XMMatrixTranspose(camera.GetViewMatrix());
+		const XMMATRIX projection = XMMatrixTranspose(camera.GetProjectionMatrix());
+		for (size_t i = 0; i < scene.GetEntityCount(); i++) {
+			constants[i] = {XMMatrixTranspose(XMLoadFloat4x4(&scene.worldMatrices[i])), view, projection};
+		}
+		benchmark::DoNotOptimize(constants.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SceneIterateArrays)->Arg(1000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+static void BM_SceneSerialize(benchmark::State &state)
+{
+	const TGW::Scene::SceneData scene = MakeScene(static_cast<uint32_t>(state.range(0)));
+	size_t bytes = 0;
+	for (auto _ : state) {
+		std::vector<uint8_t> data = TGW::Scene::Serialize(scene);
+		bytes = data.size();
+		benchmark::DoNotOptimize(data.data());
+	}
+	state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_SceneSerialize)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+static void BM_SceneDeserialize(benchmark::State &state)
+{
+	const std::vector<uint8_t> data = TGW::Scene::Serialize(MakeScene(static_cast<uint32_t>(state.range(0))));
+	for (auto _ : state) {
+		auto scene = TGW::Scene::Deserialize(data);
+		benchmark::DoNotOptimize(scene->worldMatrices.data());
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_SceneDeserialize)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+static void BM_SceneSaveLoad(benchmark::State &state)
+{
+	const TGW::Scene::SceneData scene = MakeScene(static_cast<uint32_t>(state.range(0)));
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "shellshock_bench.shscene";
+	for (auto _ : state) {
+		if (!TGW::Scene::Save(path, scene)) {
+			state.SkipWithError("Failed to save the scene");
+			break;
+		}
+		auto loaded = TGW::Scene::Load(path);
+		benchmark::DoNotOptimize(loaded->worldMatrices.data());
+	}
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
+BENCHMARK(BM_SceneSaveLoad)->Arg(50000)->Unit(benchmark::kMillisecond);
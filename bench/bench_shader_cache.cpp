@@ -0,0 +1,197 @@
+#include "shader/shader_cache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+
+// Startup cost of the shader permutations of a small include tree: compiled from scratch, read back from the cache
+// directory and taken from an embedded pack. The timing compiler stands in for D3DCompile, expanding includes and then
+// hashing the result over and over so a compile costs something, if still far less than fxc. tests/test_shader_cache.cpp
+// checks the keying, the invalidation and the file formats.
+
+using namespace TGW::Shader;
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t SHADER_FUNCTIONS = 200;
+constexpr uint32_t COMPILE_WORK_ROUNDS = 64;
+
+class TimingCompiler final : public IShaderCompiler {
+  public:
+	std::optional<std::vector<uint8_t>> Compile(
+		const ShaderRequest &request, const ShaderFileReader &read, std::string &errors) override
+	{
+		std::string text = request.entryPoint + " " + request.profile + "\n";
+		for (const ShaderDefine &define : request.defines) {
+			text += "#define " + define.name + " " + define.value + "\n";
+		}
+		if (!Expand(request.source, read, text, errors, 0)) {
+			return {};
+		}
+		const std::span<const uint8_t> bytes{reinterpret_cast<const uint8_t *>(text.data()), text.size()};
+		TGW::Hash::Hash128 hash;
+		for (uint32_t round = 0; round < COMPILE_WORK_ROUNDS; round++) {
+			hash = TGW::Hash::ContentHash128(bytes, hash.low + round);
+		}
+		std::vector<uint8_t> bytecode(bytes.begin(), bytes.end());
+		bytecode.insert(bytecode.end(), reinterpret_cast<const uint8_t *>(&hash), reinterpret_cast<const uint8_t *>(&hash + 1));
+		return bytecode;
+	}
+
+	uint64_t GetVersion() const override { return 1; }
+
+  private:
+	// #include "name" is relative to the including file, like the D3D compiler does it
+	static bool Expand(const std::string &path, const ShaderFileReader &read, std::string &text, std::string &errors,
+		uint32_t depth)
+	{
+		const std::optional<std::vector<uint8_t>> data = read(path);
+		if (!data || depth > 8) {
+			errors = "cannot open " + path;
+			return false;
+		}
+		const std::string directory = path.substr(0, path.find_last_of('/') + 1);
+		std::string_view source{reinterpret_cast<const char *>(data->data()), data->size()};
+		while (!source.empty()) {
+			const size_t end = std::min(source.find('\n'), source.size());
+			const std::string_view line = source.substr(0, end);
+			source.remove_prefix(std::min(end + 1, source.size()));
+			if (line.starts_with("#include \"")) {
+				const std::string_view name = line.substr(10, line.find('"', 10) - 10);
+				if (!Expand(directory + std::string{name}, read, text, errors, depth + 1)) {
+					return false;
+				}
+			} else {
+				text.append(line).push_back('\n');
+			}
+		}
+		return true;
+	}
+};
+
+fs::path GetSourceRoot() { return fs::temp_directory_path() / "shellshock_bench_shaders" / "src"; }
+fs::path GetCacheRoot() { return fs::temp_directory_path() / "shellshock_bench_shaders" / "cache"; }
+
+std::string MakeSource(std::string_view name, std::string_view includes)
+{
+	std::string text{includes};
+	for (uint32_t i = 0; i < SHADER_FUNCTIONS; i++) {
+		text += "float " + std::string{name} + "_" + std::to_string(i) + "(float x) { return x * " + std::to_string(i) +
+			".5 + SHADOWS; }\n";
+	}
+	return text;
+}
+
+bool WriteText(const fs::path &path, std::string_view text)
+{
+	std::error_code error;
+	fs::create_directories(path.parent_path(), error);
+	std::ofstream file{path, std::ios::binary | std::ios::trunc};
+	return static_cast<bool>(file.write(text.data(), text.size()));
+}
+
+// model.hlsl reads lib/lighting.hlsl which reads lib/common.hlsl, terrain.hlsl reads only lib/common.hlsl
+bool WriteSources()
+{
+	const fs::path root = GetSourceRoot();
+	return WriteText(root / "lib" / "common.hlsl", MakeSource("common", "")) &&
+		WriteText(root / "lib" / "lighting.hlsl", MakeSource("lighting", "#include \"common.hlsl\"\n")) &&
+		WriteText(root / "model.hlsl", MakeSource("model", "#include \"lib/lighting.hlsl\"\n")) &&
+		WriteText(root / "terrain.hlsl", MakeSource("terrain", "#include \"lib/common.hlsl\"\n"));
+}
+
+void ResetCache()
+{
+	std::error_code error;
+	fs::remove_all(GetCacheRoot(), error);
+}
+
+// Both shaders, both stages, shadows and fog on or off and four light counts, the model ones first
+const std::vector<ShaderRequest> &GetRequests()
+{
+	static const std::vector<ShaderRequest> requests = [] {
+		std::vector<ShaderRequest> requests;
+		for (const char *source : {"model.hlsl", "terrain.hlsl"}) {
+			for (const auto &[entryPoint, profile] : {std::pair{"VSMain", "vs_5_0"}, std::pair{"PSMain", "ps_5_0"}}) {
+				for (uint32_t permutation = 0; permutation < 16; permutation++) {
+					requests.push_back(ShaderRequest{
+					  .source = source,
+					  .entryPoint = entryPoint,
+					  .profile = profile,
+					  .defines = {{"SHADOWS", std::to_string(permutation & 1)}, {"FOG", std::to_string((permutation >> 1) & 1)},
+						{"LIGHTS", std::to_string(1 << (permutation >> 2))}},
+					});
+				}
+			}
+		}
+		return requests;
+	}();
+	return requests;
+}
+
+// Written once for every bench, only the cache directory is reset between them
+bool HasSources(benchmark::State &state)
+{
+	static const bool written = WriteSources();
+	if (!written) {
+		state.SkipWithError("Cannot write the shader sources");
+	}
+	return written;
+}
+
+std::vector<uint8_t> MakePack(IShaderCompiler &compiler)
+{
+	ShaderCache cache{compiler, GetSourceRoot()};
+	std::vector<ShaderEntry> entries;
+	for (const auto &entry : cache.LoadAll(GetRequests())) {
+		entries.push_back(*entry);
+	}
+	return SerializeShaderPack(entries);
+}
+} // namespace
+
+static void BM_ShaderCacheCompile(benchmark::State &state)
+{
+	if (!HasSources(state)) {
+		return;
+	}
+	TimingCompiler compiler;
+	for (auto _ : state) {
+		ShaderCache cache{compiler, GetSourceRoot()};
+		benchmark::DoNotOptimize(cache.LoadAll(GetRequests()));
+	}
+	state.SetItemsProcessed(state.iterations() * GetRequests().size());
+}
+BENCHMARK(BM_ShaderCacheCompile)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ShaderCacheDiskHit(benchmark::State &state)
+{
+	if (!HasSources(state)) {
+		return;
+	}
+	TimingCompiler compiler;
+	ResetCache();
+	ShaderCache{compiler, GetSourceRoot(), GetCacheRoot()}.LoadAll(GetRequests());
+	for (auto _ : state) {
+		ShaderCache cache{compiler, GetSourceRoot(), GetCacheRoot()};
+		benchmark::DoNotOptimize(cache.LoadAll(GetRequests()));
+	}
+	state.SetItemsProcessed(state.iterations() * GetRequests().size());
+}
+BENCHMARK(BM_ShaderCacheDiskHit)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ShaderCacheEmbeddedHit(benchmark::State &state)
+{
+	if (!HasSources(state)) {
+		return;
+	}
+	TimingCompiler compiler;
+	const std::vector<uint8_t> pack = MakePack(compiler);
+	for (auto _ : state) {
+		ShaderCache cache{compiler, GetSourceRoot()};
+		cache.AddEmbedded(pack);
+		benchmark::DoNotOptimize(cache.LoadAll(GetRequests()));
+	}
+	state.SetItemsProcessed(state.iterations() * GetRequests().size());
+}
+BENCHMARK(BM_ShaderCacheEmbeddedHit)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,71 @@
+#include "sim/unit_store.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// Armies of the given size spread over a square map, all of them under move orders so every lane does real work.
+// Reported time is per simulation tick.
+
+namespace {
+constexpr float MAP_SIZE = 2048.0f;
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+constexpr uint32_t ARMY_SEED = 99;
+
+TGW::Sim::UnitStore MakeArmy(uint32_t count)
+{
+	std::mt19937 rng{ARMY_SEED};
+	std::uniform_real_distribution<float> coordinate{0.0f, MAP_SIZE};
+	std::uniform_real_distribution<float> speed{3.0f, 8.0f};
+
+	TGW::Sim::UnitStore units;
+	for (uint32_t i = 0; i < count; i++) {
+		const TGW::Sim::UnitId id = units.Spawn({
+		  .position = {coordinate(rng), 0.0f, coordinate(rng)},
+		  .maxSpeed = speed(rng),
+		  .owner = static_cast<uint8_t>(i % 8),
+		  .model = i % 16,
+		});
+		units.SetMoveTarget(id, {coordinate(rng), coordinate(rng)});
+	}
+	return units;
+}
+} // namespace
+
+static void BM_UnitTick(benchmark::State &state)
+{
+	TGW::Sim::UnitStore units = MakeArmy(static_cast<uint32_t>(state.range(0)));
+	for (auto _ : state) {
+		units.Tick(TICK_SECONDS);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UnitTick)->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_UnitWorldMatrices(benchmark::State &state)
+{
+	TGW::Sim::UnitStore units = MakeArmy(static_cast<uint32_t>(state.range(0)));
+	units.Tick(TICK_SECONDS);
+	std::vector<DirectX::XMFLOAT4X4> matrices;
+	for (auto _ : state) {
+		units.BuildWorldMatrices(matrices);
+		benchmark::DoNotOptimize(matrices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UnitWorldMatrices)->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// A full frame for the simulation: tick, then the matrices the renderer needs
+static void BM_UnitFrame(benchmark::State &state)
+{
+	TGW::Sim::UnitStore units = MakeArmy(static_cast<uint32_t>(state.range(0)));
+	std::vector<DirectX::XMFLOAT4X4> matrices;
+	for (auto _ : state) {
+		units.Tick(TICK_SECONDS);
+		units.BuildWorldMatrices(matrices);
+		benchmark::DoNotOptimize(matrices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UnitFrame)->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond)->UseRealTime();
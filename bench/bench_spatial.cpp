@@ -0,0 +1,87 @@
+#include "sim/spatial_grid.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+// A crowd of units spread over a square map. The grid is rebuilt every tick, then every unit looks for its
+// neighbours, which is what separation steering and target acquisition do. tests/test_spatial.cpp checks the
+// queries against brute force.
+
+namespace {
+constexpr float MAP_SIZE = 2048.0f;
+constexpr float CELL_SIZE = 8.0f;
+constexpr float NEIGHBOUR_RADIUS = 6.0f;
+constexpr uint32_t NEAREST_COUNT = 8;
+constexpr uint32_t CROWD_SEED = 5;
+
+struct Crowd {
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<DirectX::XMFLOAT2> positions;
+};
+
+Crowd MakeCrowd(uint32_t count)
+{
+	std::mt19937 rng{CROWD_SEED};
+	std::uniform_real_distribution<float> coordinate{0.0f, MAP_SIZE};
+	Crowd crowd;
+	for (uint32_t i = 0; i < count; i++) {
+		crowd.positions.push_back({coordinate(rng), coordinate(rng)});
+		crowd.x.push_back(crowd.positions.back().x);
+		crowd.z.push_back(crowd.positions.back().y);
+	}
+	return crowd;
+}
+
+TGW::Sim::SpatialGrid MakeGrid()
+{
+	const uint32_t cells = static_cast<uint32_t>(MAP_SIZE / CELL_SIZE);
+	return TGW::Sim::SpatialGrid{{0.0f, 0.0f}, CELL_SIZE, cells, cells};
+}
+} // namespace
+
+static void BM_SpatialRebuild(benchmark::State &state)
+{
+	const Crowd crowd = MakeCrowd(static_cast<uint32_t>(state.range(0)));
+	TGW::Sim::SpatialGrid grid = MakeGrid();
+	for (auto _ : state) {
+		grid.Rebuild(crowd.x, crowd.z);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SpatialRebuild)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Rebuild plus one neighbour query per unit, a full tick of separation steering
+static void BM_SpatialRadiusBatch(benchmark::State &state)
+{
+	const Crowd crowd = MakeCrowd(static_cast<uint32_t>(state.range(0)));
+	TGW::Sim::SpatialGrid grid = MakeGrid();
+	TGW::Sim::SpatialQueryResults results;
+	for (auto _ : state) {
+		grid.Rebuild(crowd.x, crowd.z);
+		grid.QueryRadiusBatch(crowd.positions, NEIGHBOUR_RADIUS, results);
+		benchmark::DoNotOptimize(results.indices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.counters["neighbours"] = static_cast<double>(results.indices.size()) / state.range(0);
+}
+BENCHMARK(BM_SpatialRadiusBatch)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_SpatialNearest(benchmark::State &state)
+{
+	const Crowd crowd = MakeCrowd(static_cast<uint32_t>(state.range(0)));
+	TGW::Sim::SpatialGrid grid = MakeGrid();
+	grid.Rebuild(crowd.x, crowd.z);
+	std::vector<uint32_t> found;
+	for (auto _ : state) {
+		for (const DirectX::XMFLOAT2 &position : crowd.positions) {
+			found.clear();
+			grid.QueryNearest(position, NEAREST_COUNT, MAP_SIZE, found);
+			benchmark::DoNotOptimize(found.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SpatialNearest)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,109 @@
+#include "terrain/quadtree.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+
+// A 2 km heightmap at one sample per metre. Selection runs from an RTS camera sweeping across the map, height and
+// normal queries from positions spread over all of it, the pattern of units and projectiles asking every tick.
+
+namespace {
+constexpr uint32_t MAP_SAMPLES = 2049;
+constexpr float MAP_SIZE = static_cast<float>(MAP_SAMPLES - 1);
+constexpr uint32_t QUERY_COUNT = 1'000'000;
+constexpr uint32_t QUERY_SEED = 3;
+constexpr uint32_t SWEEP_STEPS = 64;
+
+const TGW::Terrain::Heightmap &GetHills()
+{
+	static const TGW::Terrain::Heightmap hills = [] {
+		std::vector<float> heights(size_t{MAP_SAMPLES} * MAP_SAMPLES);
+		for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+			for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+				heights[size_t{z} * MAP_SAMPLES + x] =
+					20.0f * std::sin(x * 0.01f) * std::cos(z * 0.013f) + 3.0f * std::sin((x + z) * 0.07f);
+			}
+		}
+		return TGW::Terrain::Heightmap{MAP_SAMPLES, MAP_SAMPLES, 1.0f, {0.0f, 0.0f}, std::move(heights)};
+	}();
+	return hills;
+}
+
+// Eye and view projection of a camera looking down at a point of the sweep, like the editor camera does
+std::pair<DirectX::XMFLOAT3, DirectX::XMMATRIX> GetSweepView(uint32_t step)
+{
+	const float t = static_cast<float>(step % SWEEP_STEPS) / SWEEP_STEPS;
+	const DirectX::XMVECTOR target = DirectX::XMVectorSet(MAP_SIZE * t, 0.0f, MAP_SIZE * (0.2f + 0.6f * t), 1.0f);
+	const DirectX::XMVECTOR eye = DirectX::XMVectorAdd(target, DirectX::XMVectorSet(-60.0f, 80.0f, -60.0f, 0.0f));
+	const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(eye, target, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	DirectX::XMFLOAT3 eyePosition;
+	DirectX::XMStoreFloat3(&eyePosition, eye);
+	return {eyePosition, DirectX::XMMatrixMultiply(view, projection)};
+}
+} // namespace
+
+static void BM_TerrainBuildQuadtree(benchmark::State &state)
+{
+	const TGW::Terrain::Heightmap &hills = GetHills();
+	for (auto _ : state) {
+		TGW::Terrain::Quadtree quadtree{hills};
+		benchmark::DoNotOptimize(quadtree.GetLodCount());
+	}
+}
+BENCHMARK(BM_TerrainBuildQuadtree)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_TerrainSelect(benchmark::State &state)
+{
+	const TGW::Terrain::Quadtree quadtree{GetHills()};
+	std::vector<TGW::Terrain::TerrainChunk> chunks;
+	uint32_t step = 0;
+	size_t selected = 0;
+	for (auto _ : state) {
+		const auto [eye, viewProjection] = GetSweepView(step++);
+		quadtree.Select(eye, viewProjection, chunks);
+		selected += chunks.size();
+		benchmark::DoNotOptimize(chunks.data());
+	}
+	state.counters["chunks"] = static_cast<double>(selected) / state.iterations();
+}
+BENCHMARK(BM_TerrainSelect)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_TerrainHeightQuery(benchmark::State &state)
+{
+	const TGW::Terrain::Heightmap &hills = GetHills();
+	std::mt19937 rng{QUERY_SEED};
+	std::uniform_real_distribution<float> coordinate{0.0f, MAP_SIZE};
+	std::vector<float> x(QUERY_COUNT), z(QUERY_COUNT), heights(QUERY_COUNT);
+	for (uint32_t i = 0; i < QUERY_COUNT; i++) {
+		x[i] = coordinate(rng);
+		z[i] = coordinate(rng);
+	}
+	for (auto _ : state) {
+		hills.GetHeights(x, z, heights);
+		benchmark::DoNotOptimize(heights.data());
+	}
+	state.SetItemsProcessed(state.iterations() * QUERY_COUNT);
+}
+BENCHMARK(BM_TerrainHeightQuery)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_TerrainNormalQuery(benchmark::State &state)
+{
+	const TGW::Terrain::Heightmap &hills = GetHills();
+	std::mt19937 rng{QUERY_SEED};
+	std::uniform_real_distribution<float> coordinate{0.0f, MAP_SIZE};
+	std::vector<DirectX::XMFLOAT2> positions(QUERY_COUNT);
+	for (DirectX::XMFLOAT2 &position : positions) {
+		position = {coordinate(rng), coordinate(rng)};
+	}
+	for (auto _ : state) {
+		float sum = 0.0f;
+		for (const DirectX::XMFLOAT2 &position : positions) {
+			sum += hills.GetNormal(position.x, position.y).y;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * QUERY_COUNT);
+}
+BENCHMARK(BM_TerrainNormalQuery)->Unit(benchmark::kMillisecond)->UseRealTime();
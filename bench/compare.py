@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Compares two shellshock_bench JSON reports and flags regressions.
+
+    python3 bench/compare.py <baseline.json> <current.json> [--threshold 0.10] [--metric real_time]
+
+Both files are Google Benchmark JSON output (--benchmark_out_format=json). When repetitions were run the
+median is compared, otherwise the mean of the plain iterations. A benchmark regresses when it got slower by
+more than the threshold, widened by the run-to-run noise (coefficient of variation) of both reports.
+Exits with 1 when anything regressed, so it can gate CI.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+TIME_UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_report(path, metric):
+    with open(path) as file:
+        report = json.load(file)
+
+    medians = {}
+    cvs = {}
+    iterations = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            continue
+        name = entry.get("run_name", entry["name"])
+        scale = TIME_UNIT_TO_NS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            aggregate = entry.get("aggregate_name")
+            if aggregate == "median":
+                medians[name] = entry[metric] * scale
+            elif aggregate == "cv":
+                # The cv aggregate is a plain ratio even though it sits in the time fields
+                cvs[name] = entry[metric]
+        else:
+            iterations.setdefault(name, []).append(entry[metric] * scale)
+
+    results = {}
+    for name, values in iterations.items():
+        results[name] = (sum(values) / len(values), 0.0)
+    for name, value in medians.items():
+        results[name] = (value, cvs.get(name, 0.0))
+    return results
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.3f} {unit}"
+    return f"{ns:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10, help="allowed slowdown, 0.10 = 10%% (default)")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time")
+    parser.add_argument("--filter", default="", help="only compare benchmarks matching this regex")
+    args = parser.parse_args()
+
+    baseline = load_report(args.baseline, args.metric)
+    current = load_report(args.current, args.metric)
+    pattern = re.compile(args.filter)
+
+    regressions = []
+    width = max((len(name) for name in current), default=10)
+    print(f"{'benchmark':<{width}}  {'baseline':>12}  {'current':>12}  {'change':>8}  status")
+    for name in sorted(current):
+        if not pattern.search(name):
+            continue
+        if name not in baseline:
+            print(f"{name:<{width}}  {'-':>12}  {format_time(current[name][0]):>12}  {'':>8}  new")
+            continue
+
+        base_time, base_cv = baseline[name]
+        cur_time, cur_cv = current[name]
+        change = cur_time / base_time - 1.0 if base_time > 0 else 0.0
+        allowed = max(args.threshold, 2.0 * (base_cv + cur_cv))
+        if change > allowed:
+            status = "REGRESSION"
+            regressions.append(name)
+        elif change < -allowed:
+            status = "improved"
+        else:
+            status = "ok"
+        print(f"{name:<{width}}  {format_time(base_time):>12}  {format_time(cur_time):>12}  {change:>+7.1%}  {status}")
+
+    for name in sorted(set(baseline) - set(current)):
+        if pattern.search(name):
+            print(f"{name:<{width}}  {format_time(baseline[name][0]):>12}  {'-':>12}  {'':>8}  missing")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) over {args.threshold:.0%}: " + ", ".join(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
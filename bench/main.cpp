@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include <string_view>
+#include <vector>
+
+// Defaults for the regression suite: every benchmark warms up, runs several times and only the
+// mean/median/stddev/cv aggregates are reported. Flags given on the command line win.
+static const char *DEFAULT_FLAGS[] = {
+  "--benchmark_min_warmup_time=0.1",
+  "--benchmark_repetitions=5",
+  "--benchmark_report_aggregates_only=true",
+};
+
+int main(int argc, char **argv)
+{
+	std::vector<char *> args{argv, argv + argc};
+	for (const char *flag : DEFAULT_FLAGS) {
+		const std::string_view name = std::string_view{flag}.substr(0, std::string_view{flag}.find('='));
+		bool overridden = false;
+		for (int i = 1; i < argc; i++) {
+			overridden |= std::string_view{argv[i]}.starts_with(name);
+		}
+		if (!overridden) {
+			args.insert(args.begin() + 1, const_cast<char *>(flag));
+		}
+	}
+
+	int count = static_cast<int>(args.size());
+	benchmark::Initialize(&count, args.data());
+	if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,213 @@
+#include "ai_scheduler.h"
+
+#include <chrono>
+
+using namespace TGW::Ai;
+
+namespace {
+// Parallel systems run their jobs in waves of this many per thread and check the budget after each wave, so a
+// wrong estimate overshoots by one wave at most
+constexpr uint32_t WAVE_JOBS_PER_THREAD = 64;
+constexpr uint32_t WAVE_SLICE = 16;
+// Share of a new measurement in the learned costs
+constexpr float ESTIMATE_WEIGHT = 0.25f;
+// Share of the last tick in the smoothed system time
+constexpr float AVERAGE_WEIGHT = 1.0f / 32.0f;
+
+uint64_t GetSteadyNanoseconds()
+{
+	return static_cast<uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline float Blend(float estimate, float sample, float weight)
+{
+	return estimate > 0.0f ? estimate + (sample - estimate) * weight : sample;
+}
+} // namespace
+
+AiScheduler::AiScheduler(AiClock clock) : _clock{clock ? std::move(clock) : AiClock{GetSteadyNanoseconds}} {}
+
+uint32_t AiScheduler::AddSystem(const AiSystemDesc &desc)
+{
+	System &system = _systems.emplace_back();
+	system.desc = desc;
+	return static_cast<uint32_t>(_systems.size() - 1);
+}
+
+void AiScheduler::SetBudget(uint32_t system, uint32_t budgetMicros) { _systems[system].desc.budgetMicros = budgetMicros; }
+
+void AiScheduler::ResetPeaks()
+{
+	for (System &system : _systems) {
+		system.stats.peakMicros = 0.0f;
+		system.stats.peakLateness = 0;
+	}
+}
+
+AiJobId AiScheduler::AddJob(const AiJobDesc &desc, AiJobFn fn)
+{
+	uint32_t index;
+	if (!_freeJobs.empty()) {
+		index = _freeJobs.back();
+		_freeJobs.pop_back();
+	} else {
+		index = static_cast<uint32_t>(_jobs.size());
+		_jobs.emplace_back();
+	}
+	System &system = _systems[desc.system];
+	Job &job = _jobs[index];
+	job.fn = std::move(fn);
+	job.system = desc.system;
+	job.interval = std::max(desc.interval, 1u);
+	job.priority = static_cast<uint8_t>(std::min<uint32_t>(desc.priority, AI_PRIORITY_LEVELS - 1));
+	job.alive = true;
+	job.continuing = false;
+	job.slices = 0;
+	job.due = _tick + 1 + system.stagger++ % job.interval;
+	job.key = GetKey(job);
+	job.estimate = 0.0f;
+
+	// Positions are by job index, every system's heaps have to cover all of them
+	system.waiting.Reserve(static_cast<uint32_t>(_jobs.size()));
+	system.ready.Reserve(static_cast<uint32_t>(_jobs.size()));
+	system.waiting.Push(index, job.due);
+	system.stats.jobCount++;
+	return AiJobId{index, job.generation};
+}
+
+// The slot stays in its queue until it comes up and is freed there
+void AiScheduler::RemoveJob(AiJobId id)
+{
+	if (!IsAlive(id)) {
+		return;
+	}
+	Job &job = _jobs[id.index];
+	job.alive = false;
+	job.generation++;
+	job.fn = nullptr;
+	_systems[job.system].stats.jobCount--;
+}
+
+void AiScheduler::Tick(JobSystem &jobs)
+{
+	_tick++;
+	float micros = 0.0f;
+	for (System &system : _systems) {
+		RunSystem(system, jobs);
+		micros += system.stats.lastMicros;
+	}
+	_lastTickMicros = micros;
+}
+
+/* Implementation of private functions */
+
+void AiScheduler::RunSystem(System &system, JobSystem &jobs)
+{
+	while (!system.waiting.IsEmpty() && _jobs[system.waiting.Peek()].due <= _tick) {
+		const uint32_t job = system.waiting.Pop();
+		if (_jobs[job].alive) {
+			system.ready.Push(job, _jobs[job].key);
+		} else {
+			FreeJob(job);
+		}
+	}
+
+	const float budget = system.desc.budgetMicros * 1000.0f;
+	const uint32_t waveSize = system.desc.parallel ? (jobs.GetWorkerCount() + 1) * WAVE_JOBS_PER_THREAD : 1;
+	uint64_t spent = 0;
+	uint32_t run = 0;
+	uint32_t lateness = 0;
+	while (spent < budget) {
+		// The next wave by what its jobs are expected to cost. The first job of a tick always runs, or a job costing
+		// more than the whole budget would never get to.
+		_batch.clear();
+		float planned = static_cast<float>(spent);
+		while (_batch.size() < waveSize && !system.ready.IsEmpty()) {
+			const uint32_t job = system.ready.Peek();
+			if (!_jobs[job].alive) {
+				FreeJob(system.ready.Pop());
+				continue;
+			}
+			const float estimate = _jobs[job].estimate > 0.0f ? _jobs[job].estimate : system.estimate;
+			if ((run > 0 || !_batch.empty()) && planned + estimate > budget) {
+				break;
+			}
+			_batch.push_back(system.ready.Pop());
+			planned += estimate;
+		}
+		if (_batch.empty()) {
+			break;
+		}
+
+		const uint32_t count = static_cast<uint32_t>(_batch.size());
+		_costs.resize(count);
+		_more.resize(count);
+		if (count > 1) {
+			jobs.ParallelFor(count, WAVE_SLICE, [this](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; i++) {
+					RunJob(i);
+				}
+			});
+		} else {
+			RunJob(0);
+		}
+
+		uint64_t waveCost = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			Job &job = _jobs[_batch[i]];
+			if (!job.continuing) {
+				lateness = std::max(lateness, _tick - job.due);
+			}
+			job.estimate = Blend(job.estimate, static_cast<float>(_costs[i]), ESTIMATE_WEIGHT);
+			waveCost += _costs[i];
+			Requeue(system, _batch[i], _more[i]);
+		}
+		system.estimate = Blend(system.estimate, static_cast<float>(waveCost) / count, ESTIMATE_WEIGHT);
+		spent += waveCost;
+		run += count;
+	}
+	for (const uint32_t job : _continued) {
+		system.ready.Push(job, _jobs[job].key);
+	}
+	_continued.clear();
+
+	AiSystemStats &stats = system.stats;
+	stats.ticks++;
+	stats.jobsRun += run;
+	stats.overruns += spent > budget;
+	stats.lastMicros = spent / 1000.0f;
+	stats.averageMicros = Blend(stats.averageMicros, stats.lastMicros, AVERAGE_WEIGHT);
+	stats.peakMicros = std::max(stats.peakMicros, stats.lastMicros);
+	stats.backlog = system.ready.GetSize();
+	stats.peakLateness = std::max(stats.peakLateness, lateness);
+}
+
+void AiScheduler::RunJob(uint32_t slot)
+{
+	const uint64_t start = _clock();
+	_more[slot] = _jobs[_batch[slot]].fn();
+	_costs[slot] = _clock() - start;
+}
+
+void AiScheduler::Requeue(System &system, uint32_t job, bool more)
+{
+	Job &state = _jobs[job];
+	state.continuing = more;
+	if (more) {
+		// Keeps its key for a while, so the rest of the work goes ahead of everything that became due since. After
+		// that it is due again on every next tick and ages like the others.
+		if (++state.slices >= AI_MAX_PRIORITY_SLICES) {
+			state.due = _tick + 1;
+			state.key = GetKey(state);
+		}
+		_continued.push_back(job);
+		return;
+	}
+	state.slices = 0;
+	state.due = _tick + state.interval;
+	state.key = GetKey(state);
+	system.waiting.Push(job, state.due);
+}
+
+void AiScheduler::FreeJob(uint32_t job) { _freeJobs.push_back(job); }
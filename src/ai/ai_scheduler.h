@@ -0,0 +1,153 @@
+#pragma once
+
+#include "common.h"
+#include "core/job_system.h"
+#include "sim/node_heap.h"
+
+namespace TGW::Ai {
+
+// Priorities go from 0 to AI_PRIORITY_LEVELS - 1, higher runs first when the budget is short
+constexpr uint32_t AI_PRIORITY_LEVELS = 4;
+
+// Nanoseconds since any fixed point. Called from the workers too, has to be thread safe.
+using AiClock = std::function<uint64_t()>;
+
+// Stays valid until the job is removed, then the slot bumps its generation and stale ids stop resolving
+struct AiJobId {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	inline bool IsValid() const { return index != UINT32_MAX; }
+	bool operator==(const AiJobId &) const = default;
+};
+
+struct AiSystemDesc {
+	std::string name;
+	// CPU time the jobs of the system may use per tick, summed over every thread they ran on
+	uint32_t budgetMicros = 1000;
+	// Jobs that only touch their own agent run spread over the job system, the others one after another
+	bool parallel = false;
+	// A job one priority level lower waits this many ticks longer before it goes first, so low priorities are
+	// late under load but never starve
+	uint32_t agingTicks = 30;
+};
+
+struct AiJobDesc {
+	uint32_t system = 0;
+	uint8_t priority = 0;
+	// Runs every interval ticks. The first run is staggered over the interval, so agents added together do not all
+	// think on the same tick.
+	uint32_t interval = 1;
+};
+
+// Kept ahead of newer work for this many slices in a row, later slices queue up like work that just became due
+constexpr uint32_t AI_MAX_PRIORITY_SLICES = 8;
+
+// Returns true when the job has work left, it then continues as soon as possible on the next tick. Long work like
+// build planning is cut into slices this way instead of spiking one frame. After AI_MAX_PRIORITY_SLICES in a row the
+// job takes its turn with the rest, so work that never finishes cannot starve its system.
+using AiJobFn = std::function<bool()>;
+
+struct AiSystemStats {
+	uint32_t jobCount = 0;
+	uint64_t ticks = 0;
+	uint64_t jobsRun = 0;
+	// Ticks the system used more than its budget
+	uint64_t overruns = 0;
+	float lastMicros = 0.0f;
+	float averageMicros = 0.0f;
+	float peakMicros = 0.0f;
+	// Jobs due but left for later by the last tick
+	uint32_t backlog = 0;
+	// Most ticks a job started after it was due
+	uint32_t peakLateness = 0;
+};
+
+// Runs the thinking of AI agents within a fixed CPU budget per tick. Agents register jobs with a priority and an
+// interval, each tick the jobs that are due go in order of priority and then of how long they waited, round robin
+// between equals, until the budget of their system is spent. What does not fit waits for the next tick and ages
+// ahead of newer work. How long a job takes is learned from its past runs.
+//
+// Jobs, systems and ticks are driven from one thread and jobs must not add or remove jobs.
+class AiScheduler {
+  public:
+	// Without a clock, jobs are timed with the steady clock. Tests pass a virtual one.
+	explicit AiScheduler(AiClock clock = {});
+
+	uint32_t AddSystem(const AiSystemDesc &desc);
+	inline uint32_t GetSystemCount() const { return static_cast<uint32_t>(_systems.size()); }
+	inline const AiSystemDesc &GetSystemDesc(uint32_t system) const { return _systems[system].desc; }
+	inline const AiSystemStats &GetStats(uint32_t system) const { return _systems[system].stats; }
+	void SetBudget(uint32_t system, uint32_t budgetMicros);
+	void ResetPeaks();
+
+	AiJobId AddJob(const AiJobDesc &desc, AiJobFn fn);
+	void RemoveJob(AiJobId id);
+	inline bool IsAlive(AiJobId id) const
+	{
+		return id.index < _jobs.size() && _jobs[id.index].alive && _jobs[id.index].generation == id.generation;
+	}
+
+	// Runs the due jobs of every system, one system after another
+	void Tick(JobSystem &jobs = JobSystem::Get());
+	inline uint32_t GetTickCount() const { return _tick; }
+	// CPU time all systems used in the last tick
+	inline float GetLastTickMicros() const { return _lastTickMicros; }
+
+  private:
+	struct Job {
+		AiJobFn fn;
+		uint32_t system = 0;
+		uint32_t interval = 1;
+		uint32_t generation = 0;
+		uint8_t priority = 0;
+		bool alive = false;
+		// Returned true last time it ran
+		bool continuing = false;
+		// Slices run in a row since it last finished
+		uint32_t slices = 0;
+		// Tick it runs next, and its place in the ready queue once that tick came
+		uint32_t due = 0;
+		uint32_t key = 0;
+		// Learned cost of a run in nanoseconds, zero until it ran once
+		float estimate = 0.0f;
+	};
+
+	struct System {
+		AiSystemDesc desc;
+		AiSystemStats stats;
+		// Jobs by due tick, and the ones due by key
+		Sim::NodeHeap waiting;
+		Sim::NodeHeap ready;
+		// Cost of an average run, what jobs that never ran are assumed to take
+		float estimate = 0.0f;
+		uint32_t stagger = 0;
+	};
+
+	void RunSystem(System &system, JobSystem &jobs);
+	// Runs the job at slot of the batch and records its cost and whether it has work left
+	void RunJob(uint32_t slot);
+	// Back into the queues after running
+	void Requeue(System &system, uint32_t job, bool more);
+	void FreeJob(uint32_t job);
+	inline uint32_t GetKey(const Job &job) const
+	{
+		return job.due + (AI_PRIORITY_LEVELS - 1 - job.priority) * _systems[job.system].desc.agingTicks;
+	}
+
+	AiClock _clock;
+	std::vector<System> _systems;
+	std::vector<Job> _jobs;
+	std::vector<uint32_t> _freeJobs;
+	uint32_t _tick = 0;
+	float _lastTickMicros = 0.0f;
+
+	// Jobs picked for the next wave of a system, with what each cost and returned
+	std::vector<uint32_t> _batch;
+	std::vector<uint64_t> _costs;
+	std::vector<uint8_t> _more;
+	// Jobs with work left, they go back into the ready queue once the system is done for the tick
+	std::vector<uint32_t> _continued;
+};
+
+} // namespace TGW::Ai
@@ -0,0 +1,171 @@
+#include "anim_import.h"
+
+#include <assimp/anim.h>
+#include <assimp/mesh.h>
+#include <assimp/scene.h>
+
+#include <unordered_set>
+
+using namespace DirectX;
+using namespace TGW::Anim;
+
+namespace {
+// Assimp docs suggest 25 ticks per second when the file does not say
+constexpr double DEFAULT_TICKS_PER_SECOND = 25.0;
+
+// Assimp multiplies column vectors, DirectXMath row vectors
+XMMATRIX ToRowVectorMatrix(const aiMatrix4x4 &m)
+{
+	return XMMATRIX(m.a1, m.b1, m.c1, m.d1, m.a2, m.b2, m.c2, m.d2, m.a3, m.b3, m.c3, m.d3, m.a4, m.b4, m.c4, m.d4);
+}
+
+// True when node or anything below it is a bone, marking those nodes in needed
+bool MarkJoints(const aiNode *node, const std::unordered_map<std::string, const aiBone *> &bones,
+	std::unordered_set<const aiNode *> &needed)
+{
+	bool isNeeded = bones.contains(node->mName.C_Str());
+	for (uint32_t i = 0; i < node->mNumChildren; i++) {
+		isNeeded |= MarkJoints(node->mChildren[i], bones, needed);
+	}
+	if (isNeeded) {
+		needed.insert(node);
+	}
+	return isNeeded;
+}
+} // namespace
+
+/* Implementation of public functions */
+
+std::optional<Skeleton> TGW::Anim::ImportSkeleton(const aiScene *scene)
+{
+	if (!scene || !scene->mRootNode) {
+		return {};
+	}
+	std::unordered_map<std::string, const aiBone *> bones;
+	for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
+		const aiMesh *mesh = scene->mMeshes[i];
+		for (uint32_t b = 0; b < mesh->mNumBones; b++) {
+			bones.emplace(mesh->mBones[b]->mName.C_Str(), mesh->mBones[b]);
+		}
+	}
+	std::unordered_set<const aiNode *> needed;
+	if (bones.empty() || !MarkJoints(scene->mRootNode, bones, needed) || needed.size() > ANIM_MAX_JOINTS) {
+		return {};
+	}
+
+	// Depth first, so every joint comes after its parent
+	Skeleton skeleton;
+	std::vector<XMFLOAT4X4> bindModels;
+	const std::function<void(const aiNode *, uint16_t)> visit = [&](const aiNode *node, uint16_t parent) {
+		if (!needed.contains(node)) {
+			return;
+		}
+		const uint16_t index = static_cast<uint16_t>(skeleton.joints.size());
+		Joint &joint = skeleton.joints.emplace_back();
+		joint.name = node->mName.C_Str();
+		joint.parent = parent;
+
+		const XMMATRIX local = ToRowVectorMatrix(node->mTransformation);
+		XMVECTOR scale, rotation, translation;
+		XMMatrixDecompose(&scale, &rotation, &translation, local);
+		XMStoreFloat3(&joint.bindPose.scale, scale);
+		XMStoreFloat4(&joint.bindPose.rotation, rotation);
+		XMStoreFloat3(&joint.bindPose.translation, translation);
+
+		const XMMATRIX model = parent == JOINT_NO_PARENT ? local : XMMatrixMultiply(local, XMLoadFloat4x4(&bindModels[parent]));
+		XMStoreFloat4x4(&bindModels.emplace_back(), model);
+		// Nodes that only carry bones stay where the bind pose puts them
+		const auto bone = bones.find(joint.name);
+		XMStoreFloat4x4(&joint.inverseBind,
+			bone != bones.end() ? ToRowVectorMatrix(bone->second->mOffsetMatrix) : XMMatrixInverse(nullptr, model));
+
+		for (uint32_t i = 0; i < node->mNumChildren; i++) {
+			visit(node->mChildren[i], index);
+		}
+	};
+	visit(scene->mRootNode, JOINT_NO_PARENT);
+	return skeleton;
+}
+
+std::vector<AnimationClip> TGW::Anim::ImportClips(const aiScene *scene, const Skeleton &skeleton)
+{
+	std::vector<AnimationClip> clips;
+	if (!scene) {
+		return clips;
+	}
+	for (uint32_t a = 0; a < scene->mNumAnimations; a++) {
+		const aiAnimation *animation = scene->mAnimations[a];
+		const double ticksPerSecond = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : DEFAULT_TICKS_PER_SECOND;
+		const auto toSeconds = [&](double ticks) { return static_cast<float>(ticks / ticksPerSecond); };
+
+		AnimationClip &clip = clips.emplace_back();
+		clip.name = animation->mName.C_Str();
+		clip.duration = toSeconds(animation->mDuration);
+		clip.tracks.resize(skeleton.GetJointCount());
+		for (uint32_t c = 0; c < animation->mNumChannels; c++) {
+			const aiNodeAnim *channel = animation->mChannels[c];
+			const std::optional<uint16_t> joint = skeleton.FindJoint(channel->mNodeName.C_Str());
+			if (!joint) {
+				continue;
+			}
+			JointTrack &track = clip.tracks[*joint];
+			for (uint32_t k = 0; k < channel->mNumPositionKeys; k++) {
+				const aiVectorKey &key = channel->mPositionKeys[k];
+				track.translationTimes.push_back(toSeconds(key.mTime));
+				track.translations.push_back({key.mValue.x, key.mValue.y, key.mValue.z});
+			}
+			for (uint32_t k = 0; k < channel->mNumRotationKeys; k++) {
+				const aiQuatKey &key = channel->mRotationKeys[k];
+				track.rotationTimes.push_back(toSeconds(key.mTime));
+				track.rotations.push_back({key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w});
+			}
+			for (uint32_t k = 0; k < channel->mNumScalingKeys; k++) {
+				const aiVectorKey &key = channel->mScalingKeys[k];
+				track.scaleTimes.push_back(toSeconds(key.mTime));
+				track.scales.push_back({key.mValue.x, key.mValue.y, key.mValue.z});
+			}
+		}
+	}
+	return clips;
+}
+
+std::vector<VertexSkin> TGW::Anim::ImportSkin(const aiMesh *mesh, const Skeleton &skeleton)
+{
+	std::vector<VertexSkin> skin;
+	if (!mesh || mesh->mNumBones == 0) {
+		return skin;
+	}
+	skin.resize(mesh->mNumVertices);
+	for (uint32_t b = 0; b < mesh->mNumBones; b++) {
+		const aiBone *bone = mesh->mBones[b];
+		const std::optional<uint16_t> joint = skeleton.FindJoint(bone->mName.C_Str());
+		if (!joint) {
+			continue;
+		}
+		for (uint32_t w = 0; w < bone->mNumWeights; w++) {
+			const aiVertexWeight &weight = bone->mWeights[w];
+			if (weight.mVertexId >= skin.size()) {
+				continue;
+			}
+			// Replace the weakest influence if this one is stronger
+			VertexSkin &vertex = skin[weight.mVertexId];
+			const auto weakest = std::min_element(vertex.weights.begin(), vertex.weights.end());
+			if (weight.mWeight > *weakest) {
+				*weakest = weight.mWeight;
+				vertex.joints[weakest - vertex.weights.begin()] = static_cast<uint8_t>(*joint);
+			}
+		}
+	}
+	for (VertexSkin &vertex : skin) {
+		float total = 0.0f;
+		for (float weight : vertex.weights) {
+			total += weight;
+		}
+		if (total > 0.0f) {
+			for (float &weight : vertex.weights) {
+				weight /= total;
+			}
+		}
+	}
+	return skin;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "animation_clip.h"
+
+struct aiScene;
+struct aiMesh;
+
+namespace TGW::Anim {
+
+// Joints are the bones of every mesh plus the nodes above them, in node order so parents come first. Empty when
+// no mesh has bones or there are more than ANIM_MAX_JOINTS of them.
+std::optional<Skeleton> ImportSkeleton(const aiScene *scene);
+
+// Channels find their joint by node name, those of nodes outside the skeleton are skipped
+std::vector<AnimationClip> ImportClips(const aiScene *scene, const Skeleton &skeleton);
+
+// The strongest ANIM_MAX_INFLUENCES bones of every vertex of mesh, weights renormalized. Empty when the mesh has
+// no bones.
+std::vector<VertexSkin> ImportSkin(const aiMesh *mesh, const Skeleton &skeleton);
+
+} // namespace TGW::Anim
@@ -0,0 +1,245 @@
+#include "animation_clip.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+using namespace TGW::Anim;
+
+namespace {
+constexpr uint32_t KEY_COMPONENTS = 4;
+constexpr float QUANTIZED_MAX = 65535.0f;
+// Frames are stored in 16 bits
+constexpr uint32_t MAX_FRAMES = UINT16_MAX + 1;
+
+XMVECTOR Load(const XMFLOAT3 &value) { return XMLoadFloat3(&value); }
+XMVECTOR Load(const XMFLOAT4 &value) { return XMLoadFloat4(&value); }
+
+// q and -q are the same rotation, puts b on a's side so blending them takes the short way
+XMVECTOR AlignRotation(FXMVECTOR a, FXMVECTOR b)
+{
+	return XMVectorSelect(b, XMVectorNegate(b), XMVectorLess(XMVector4Dot(a, b), XMVectorZero()));
+}
+
+XMVECTOR Interpolate(FXMVECTOR a, FXMVECTOR b, float t, bool rotation)
+{
+	if (!rotation) {
+		return XMVectorLerp(a, b, t);
+	}
+	return XMQuaternionNormalize(XMVectorLerp(a, b, t));
+}
+
+// Value of a raw channel at time, fallback when it has no keys
+template <typename T>
+XMVECTOR SampleRaw(const std::vector<float> &times, const std::vector<T> &values, float time, XMVECTOR fallback, bool rotation)
+{
+	const size_t count = std::min(times.size(), values.size());
+	if (count == 0) {
+		return fallback;
+	}
+	const size_t next = std::upper_bound(times.begin(), times.begin() + count, time) - times.begin();
+	if (next == 0) {
+		return Load(values[0]);
+	}
+	if (next == count) {
+		return Load(values[count - 1]);
+	}
+	const float span = times[next] - times[next - 1];
+	const float t = span > 0.0f ? (time - times[next - 1]) / span : 0.0f;
+	const XMVECTOR a = Load(values[next - 1]);
+	return Interpolate(a, rotation ? AlignRotation(a, Load(values[next])) : Load(values[next]), t, rotation);
+}
+
+float GetLargestError(FXMVECTOR a, FXMVECTOR b)
+{
+	XMFLOAT4 error;
+	XMStoreFloat4(&error, XMVectorAbs(XMVectorSubtract(a, b)));
+	return std::max({error.x, error.y, error.z, error.w});
+}
+} // namespace
+
+/* AnimationClip */
+
+size_t AnimationClip::GetByteSize() const
+{
+	size_t bytes = 0;
+	for (const JointTrack &track : tracks) {
+		bytes += track.translationTimes.size() * sizeof(float) + track.translations.size() * sizeof(XMFLOAT3);
+		bytes += track.rotationTimes.size() * sizeof(float) + track.rotations.size() * sizeof(XMFLOAT4);
+		bytes += track.scaleTimes.size() * sizeof(float) + track.scales.size() * sizeof(XMFLOAT3);
+	}
+	return bytes;
+}
+
+void AnimationClip::Sample(const Skeleton &skeleton, float time, std::span<JointTransform> pose) const
+{
+	const size_t count = std::min(pose.size(), skeleton.joints.size());
+	for (size_t i = 0; i < count; i++) {
+		const JointTransform &bind = skeleton.joints[i].bindPose;
+		if (i >= tracks.size()) {
+			pose[i] = bind;
+			continue;
+		}
+		const JointTrack &track = tracks[i];
+		XMStoreFloat4(&pose[i].rotation, SampleRaw(track.rotationTimes, track.rotations, time, Load(bind.rotation), true));
+		XMStoreFloat3(
+			&pose[i].translation, SampleRaw(track.translationTimes, track.translations, time, Load(bind.translation), false));
+		XMStoreFloat3(&pose[i].scale, SampleRaw(track.scaleTimes, track.scales, time, Load(bind.scale), false));
+	}
+}
+
+/* CompressedClip */
+
+size_t CompressedClip::GetByteSize() const
+{
+	return _channels.size() * sizeof(Channel) + _keyFrames.size() * sizeof(uint16_t) + _keyValues.size() * sizeof(uint16_t);
+}
+
+void CompressedClip::SampleFrame(float frame, std::span<JointTransform> pose) const
+{
+	frame = frame > 0.0f ? std::min(frame, static_cast<float>(_frameCount - 1)) : 0.0f;
+	const size_t count = std::min(pose.size(), size_t{GetJointCount()});
+	for (size_t i = 0; i < count; i++) {
+		const Channel *channels = &_channels[i * CHANNELS_PER_JOINT];
+		XMStoreFloat4(&pose[i].rotation, SampleChannel(channels[CHANNEL_ROTATION], frame, true));
+		XMStoreFloat3(&pose[i].translation, SampleChannel(channels[CHANNEL_TRANSLATION], frame, false));
+		XMStoreFloat3(&pose[i].scale, SampleChannel(channels[CHANNEL_SCALE], frame, false));
+	}
+}
+
+/* Implementation of private functions */
+
+XMVECTOR CompressedClip::DecodeKey(const Channel &channel, uint32_t key) const
+{
+	const uint16_t *value = &_keyValues[size_t{key} * KEY_COMPONENTS];
+	const XMVECTOR quantized = XMVectorSet(value[0], value[1], value[2], value[3]);
+	return XMVectorMultiplyAdd(quantized, XMLoadFloat4(&channel.scale), XMLoadFloat4(&channel.offset));
+}
+
+XMVECTOR CompressedClip::SampleChannel(const Channel &channel, float frame, bool rotation) const
+{
+	const uint16_t *frames = &_keyFrames[channel.firstKey];
+	// Last key at or before the frame, the first key always sits on frame 0
+	const uint32_t next = static_cast<uint32_t>(
+		std::upper_bound(frames, frames + channel.keyCount, static_cast<uint16_t>(frame)) - frames);
+	if (next >= channel.keyCount) {
+		const XMVECTOR last = DecodeKey(channel, channel.firstKey + channel.keyCount - 1);
+		return rotation ? XMQuaternionNormalize(last) : last;
+	}
+	const float from = frames[next - 1], to = frames[next];
+	const XMVECTOR a = DecodeKey(channel, channel.firstKey + next - 1);
+	const XMVECTOR b = DecodeKey(channel, channel.firstKey + next);
+	return Interpolate(a, b, (frame - from) / (to - from), rotation);
+}
+
+/* Compression */
+
+CompressedClip
+TGW::Anim::CompressClip(const AnimationClip &clip, const Skeleton &skeleton, const ClipCompressionSettings &settings)
+{
+	CompressedClip out;
+	out._name = clip.name;
+	out._duration = std::max(clip.duration, 0.0f);
+	out._sampleRate = settings.sampleRate > 0.0f ? settings.sampleRate : 30.0f;
+	out._frameCount =
+		std::min(static_cast<uint32_t>(std::ceil(out._duration * out._sampleRate)) + 1, MAX_FRAMES);
+
+	const uint32_t jointCount = skeleton.GetJointCount();
+	out._channels.resize(size_t{jointCount} * CompressedClip::CHANNELS_PER_JOINT);
+
+	// Every frame of the clip, then one channel at a time
+	std::vector<std::vector<JointTransform>> frames(out._frameCount, std::vector<JointTransform>(jointCount));
+	for (uint32_t frame = 0; frame < out._frameCount; frame++) {
+		clip.Sample(skeleton, std::min(frame / out._sampleRate, out._duration), frames[frame]);
+	}
+
+	std::vector<XMFLOAT4> values(out._frameCount);
+	std::vector<uint16_t> quantized(size_t{out._frameCount} * KEY_COMPONENTS);
+	std::vector<XMFLOAT4> decoded(out._frameCount);
+	for (uint32_t joint = 0; joint < jointCount; joint++) {
+		for (uint32_t type = 0; type < CompressedClip::CHANNELS_PER_JOINT; type++) {
+			const bool rotation = type == CompressedClip::CHANNEL_ROTATION;
+			const float tolerance = rotation							   ? settings.rotationTolerance
+									: type == CompressedClip::CHANNEL_SCALE ? settings.scaleTolerance
+																		   : settings.translationTolerance;
+			for (uint32_t frame = 0; frame < out._frameCount; frame++) {
+				const JointTransform &pose = frames[frame][joint];
+				values[frame] = rotation ? pose.rotation
+							  : type == CompressedClip::CHANNEL_SCALE
+								  ? XMFLOAT4{pose.scale.x, pose.scale.y, pose.scale.z, 0.0f}
+								  : XMFLOAT4{pose.translation.x, pose.translation.y, pose.translation.z, 0.0f};
+				// Keep consecutive rotations on the same side so neighbouring keys interpolate the short way
+				if (rotation && frame > 0) {
+					XMStoreFloat4(&values[frame], AlignRotation(XMLoadFloat4(&values[frame - 1]), XMLoadFloat4(&values[frame])));
+				}
+			}
+
+			// Quantize over the channel's range
+			XMVECTOR low = XMLoadFloat4(&values[0]), high = low;
+			for (const XMFLOAT4 &value : values) {
+				low = XMVectorMin(low, XMLoadFloat4(&value));
+				high = XMVectorMax(high, XMLoadFloat4(&value));
+			}
+			CompressedClip::Channel &channel = out._channels[size_t{joint} * CompressedClip::CHANNELS_PER_JOINT + type];
+			const XMVECTOR scale = XMVectorScale(XMVectorSubtract(high, low), 1.0f / QUANTIZED_MAX);
+			XMStoreFloat4(&channel.offset, low);
+			XMStoreFloat4(&channel.scale, scale);
+			XMFLOAT4 inverse;
+			// Held channels have no range, their keys all quantize to 0
+			const XMVECTOR held = XMVectorEqual(scale, XMVectorZero());
+			XMStoreFloat4(&inverse, XMVectorSelect(XMVectorReciprocal(scale), XMVectorZero(), held));
+			for (uint32_t frame = 0; frame < out._frameCount; frame++) {
+				const XMFLOAT4 &value = values[frame];
+				const float components[KEY_COMPONENTS] = {
+				  (value.x - channel.offset.x) * inverse.x, (value.y - channel.offset.y) * inverse.y,
+				  (value.z - channel.offset.z) * inverse.z, (value.w - channel.offset.w) * inverse.w};
+				for (uint32_t c = 0; c < KEY_COMPONENTS; c++) {
+					quantized[size_t{frame} * KEY_COMPONENTS + c] =
+						static_cast<uint16_t>(std::clamp(std::round(components[c]), 0.0f, QUANTIZED_MAX));
+				}
+				const uint16_t *key = &quantized[size_t{frame} * KEY_COMPONENTS];
+				XMStoreFloat4(&decoded[frame], XMVectorMultiplyAdd(XMVectorSet(key[0], key[1], key[2], key[3]), scale, low));
+			}
+
+			// Greedy key reduction: from each kept key, reach as far as interpolating to the next one stays
+			// within tolerance of every frame in between
+			channel.firstKey = static_cast<uint32_t>(out._keyFrames.size());
+			const auto keep = [&](uint32_t frame) {
+				out._keyFrames.push_back(static_cast<uint16_t>(frame));
+				out._keyValues.insert(out._keyValues.end(), quantized.begin() + size_t{frame} * KEY_COMPONENTS,
+					quantized.begin() + size_t{frame + 1} * KEY_COMPONENTS);
+			};
+			const auto reproduces = [&](uint32_t from, uint32_t to) {
+				const XMVECTOR a = XMLoadFloat4(&decoded[from]), b = XMLoadFloat4(&decoded[to]);
+				for (uint32_t frame = from + 1; frame < to; frame++) {
+					const XMVECTOR expected = rotation ? XMQuaternionNormalize(XMLoadFloat4(&values[frame]))
+													   : XMLoadFloat4(&values[frame]);
+					if (GetLargestError(Interpolate(a, b, static_cast<float>(frame - from) / (to - from), rotation), expected) >
+						tolerance) {
+						return false;
+					}
+				}
+				return GetLargestError(rotation ? XMQuaternionNormalize(b) : b,
+						   rotation ? XMQuaternionNormalize(XMLoadFloat4(&values[to])) : XMLoadFloat4(&values[to])) <=
+					   tolerance;
+			};
+			// A channel that holds still needs only its first key
+			const XMVECTOR first = rotation ? XMQuaternionNormalize(XMLoadFloat4(&decoded[0])) : XMLoadFloat4(&decoded[0]);
+			const bool still = std::all_of(values.begin(), values.end(), [&](const XMFLOAT4 &value) {
+				return GetLargestError(first, rotation ? XMQuaternionNormalize(XMLoadFloat4(&value)) : XMLoadFloat4(&value)) <=
+					   tolerance;
+			});
+			keep(0);
+			for (uint32_t from = 0; !still && from + 1 < out._frameCount;) {
+				uint32_t to = from + 1;
+				while (to + 1 < out._frameCount && reproduces(from, to + 1)) {
+					to++;
+				}
+				keep(to);
+				from = to;
+			}
+			channel.keyCount = static_cast<uint32_t>(out._keyFrames.size()) - channel.firstKey;
+		}
+	}
+	return out;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "skeleton.h"
+
+namespace TGW::Anim {
+
+// Keys of one joint as imported, every channel with its own times in seconds. Empty channels hold the bind pose.
+struct JointTrack {
+	std::vector<float> translationTimes;
+	std::vector<DirectX::XMFLOAT3> translations;
+	std::vector<float> rotationTimes;
+	std::vector<DirectX::XMFLOAT4> rotations;
+	std::vector<float> scaleTimes;
+	std::vector<DirectX::XMFLOAT3> scales;
+};
+
+struct AnimationClip {
+	std::string name;
+	float duration = 0.0f; // seconds
+	std::vector<JointTrack> tracks; // one per skeleton joint
+
+	// Keys as imported, a time and a value each
+	size_t GetByteSize() const;
+	// Pose at time seconds, clamped to the clip. Joints without keys take their bind pose.
+	void Sample(const Skeleton &skeleton, float time, std::span<JointTransform> pose) const;
+};
+
+struct ClipCompressionSettings {
+	float sampleRate = 30.0f;
+	// Largest error a dropped or quantized key may cause, per component
+	float rotationTolerance = 5e-4f;
+	float translationTolerance = 1e-3f; // metres
+	float scaleTolerance = 1e-3f;
+};
+
+// Clip resampled at a fixed rate with the keys linear interpolation reproduces dropped, a held pose costing a
+// single key, and the rest quantized to 16 bits per component over the range of their channel.
+class CompressedClip {
+  public:
+	inline const std::string &GetName() const { return _name; }
+	inline float GetDuration() const { return _duration; }
+	inline float GetSampleRate() const { return _sampleRate; }
+	inline uint32_t GetFrameCount() const { return _frameCount; }
+	inline uint32_t GetJointCount() const { return static_cast<uint32_t>(_channels.size() / CHANNELS_PER_JOINT); }
+	inline size_t GetKeyCount() const { return _keyFrames.size(); }
+	size_t GetByteSize() const;
+
+	// Pose at time seconds, clamped to the clip, into GetJointCount() entries
+	inline void Sample(float time, std::span<JointTransform> pose) const { SampleFrame(time * _sampleRate, pose); }
+	// Same at a fractional frame
+	void SampleFrame(float frame, std::span<JointTransform> pose) const;
+
+  private:
+	friend CompressedClip CompressClip(const AnimationClip &, const Skeleton &, const ClipCompressionSettings &);
+
+	enum ChannelType : uint8_t {
+		CHANNEL_ROTATION,
+		CHANNEL_TRANSLATION,
+		CHANNEL_SCALE,
+		CHANNELS_PER_JOINT,
+	};
+
+	// Values decode as offset + quantized * scale, four components per key whatever the channel
+	struct Channel {
+		uint32_t firstKey = 0;
+		uint32_t keyCount = 0;
+		DirectX::XMFLOAT4 offset{};
+		DirectX::XMFLOAT4 scale{};
+	};
+
+	DirectX::XMVECTOR DecodeKey(const Channel &channel, uint32_t key) const;
+	DirectX::XMVECTOR SampleChannel(const Channel &channel, float frame, bool rotation) const;
+
+	std::string _name;
+	float _duration = 0.0f;
+	float _sampleRate = 30.0f;
+	uint32_t _frameCount = 0;
+	std::vector<Channel> _channels; // CHANNELS_PER_JOINT per joint
+	std::vector<uint16_t> _keyFrames;
+	std::vector<uint16_t> _keyValues; // 4 per key
+};
+
+CompressedClip CompressClip(const AnimationClip &clip, const Skeleton &skeleton, const ClipCompressionSettings &settings = {});
+
+} // namespace TGW::Anim
@@ -0,0 +1,88 @@
+#include "pose_cache.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace TGW::Anim;
+
+namespace {
+constexpr uint32_t POSES_PER_BATCH = 4;
+} // namespace
+
+/* Implementation of public functions */
+
+PoseCache::PoseCache(const Skeleton &skeleton, std::span<const CompressedClip> clips, uint32_t capacity)
+	: _skeleton{skeleton}, _clips{clips}, _jointCount{skeleton.GetJointCount()}, _capacity{std::max(capacity, 1u)}
+{
+}
+
+void PoseCache::Evaluate(std::span<const AnimationInstance> instances, JobSystem &jobs)
+{
+	_tick++;
+	_pending.clear();
+	_evaluatedCount = 0;
+	if (_clips.empty()) {
+		_instanceSlots.clear();
+		return;
+	}
+	_instanceSlots.resize(instances.size());
+	for (size_t i = 0; i < instances.size(); i++) {
+		const uint64_t key = GetFrameKey(instances[i]);
+		auto found = _slots.find(key);
+		if (found == _slots.end()) {
+			if (_freeSlots.empty() && _slots.size() >= _capacity) {
+				EvictUnused();
+			}
+			uint32_t index;
+			if (!_freeSlots.empty()) {
+				index = _freeSlots.back();
+				_freeSlots.pop_back();
+			} else {
+				// Over capacity with every pose in use this tick, grow rather than show a wrong pose
+				index = static_cast<uint32_t>(_matrices.size() / std::max(_jointCount, 1u));
+				_matrices.resize(_matrices.size() + _jointCount);
+			}
+			found = _slots.emplace(key, Slot{index, _tick}).first;
+			_pending.emplace_back(key, index);
+		}
+		found->second.lastUsed = _tick;
+		_instanceSlots[i] = found->second.index;
+	}
+
+	_evaluatedCount = static_cast<uint32_t>(_pending.size());
+	jobs.ParallelFor(_evaluatedCount, POSES_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		std::vector<JointTransform> pose(_jointCount);
+		for (uint32_t i = begin; i < end; i++) {
+			const auto [key, index] = _pending[i];
+			const CompressedClip &clip = _clips[static_cast<uint32_t>(key >> 32)];
+			clip.SampleFrame(static_cast<float>(static_cast<uint32_t>(key)), pose);
+			BuildSkinningMatrices(_skeleton, pose, {_matrices.data() + size_t{index} * _jointCount, _jointCount});
+		}
+	});
+}
+
+/* Implementation of private functions */
+
+uint64_t PoseCache::GetFrameKey(const AnimationInstance &instance) const
+{
+	const uint32_t clip = std::min(instance.clip, static_cast<uint32_t>(_clips.size()) - 1);
+	const CompressedClip &data = _clips[clip];
+	// Looping: the last frame is the first one again
+	const uint32_t loopFrames = std::max(data.GetFrameCount() - 1, 1u);
+	const float frame = std::round(instance.time * data.GetSampleRate());
+	const float wrapped = frame - std::floor(frame / loopFrames) * loopFrames;
+	const uint32_t index = std::min(static_cast<uint32_t>(wrapped > 0.0f ? wrapped : 0.0f), loopFrames - 1);
+	return uint64_t{clip} << 32 | index;
+}
+
+void PoseCache::EvictUnused()
+{
+	for (auto it = _slots.begin(); it != _slots.end();) {
+		if (it->second.lastUsed != _tick) {
+			_freeSlots.push_back(it->second.index);
+			it = _slots.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "animation_clip.h"
+#include "core/job_system.h"
+
+namespace TGW::Anim {
+
+// A unit playing a clip, time in seconds wraps around the clip
+struct AnimationInstance {
+	uint32_t clip = 0;
+	float time = 0.0f;
+};
+
+// Skinning matrices for a crowd of units sharing a skeleton. Instances snap to the nearest frame of their clip and
+// every clip frame is evaluated at most once, so a blob of soldiers marching in step costs a handful of poses
+// rather than one each. Frames stay cached between ticks up to a capacity, a looping walk cycle of 30 frames is
+// never evaluated again once every frame was shown.
+class PoseCache {
+  public:
+	// capacity is in poses, frames not shown in the current tick are dropped when it runs out
+	PoseCache(const Skeleton &skeleton, std::span<const CompressedClip> clips, uint32_t capacity = 1024);
+
+	// Resolves the pose of every instance, evaluating the frames not cached yet in parallel. Does nothing without
+	// clips.
+	void Evaluate(std::span<const AnimationInstance> instances, JobSystem &jobs = JobSystem::Get());
+
+	// Skinning matrices of instance i of the last Evaluate, one per joint
+	inline std::span<const DirectX::XMFLOAT4X4> GetMatrices(uint32_t instance) const
+	{
+		return {_matrices.data() + size_t{_instanceSlots[instance]} * _jointCount, _jointCount};
+	}
+	inline uint32_t GetCachedCount() const { return static_cast<uint32_t>(_slots.size()); }
+	// Poses evaluated by the last Evaluate
+	inline uint32_t GetEvaluatedCount() const { return _evaluatedCount; }
+
+  private:
+	uint64_t GetFrameKey(const AnimationInstance &instance) const;
+	void EvictUnused();
+
+	const Skeleton &_skeleton;
+	std::span<const CompressedClip> _clips;
+	uint32_t _jointCount;
+	uint32_t _capacity;
+	uint64_t _tick = 0;
+	uint32_t _evaluatedCount = 0;
+
+	struct Slot {
+		uint32_t index;
+		uint64_t lastUsed;
+	};
+	std::unordered_map<uint64_t, Slot> _slots;
+	std::vector<uint32_t> _freeSlots;
+	std::vector<DirectX::XMFLOAT4X4> _matrices; // _jointCount per slot
+	std::vector<uint32_t> _instanceSlots;
+	std::vector<std::pair<uint64_t, uint32_t>> _pending; // frame key and slot to evaluate this tick
+};
+
+} // namespace TGW::Anim
@@ -0,0 +1,63 @@
+#include "skeleton.h"
+
+using namespace DirectX;
+using namespace TGW::Anim;
+
+/* Implementation of public functions */
+
+std::optional<uint16_t> Skeleton::FindJoint(std::string_view name) const
+{
+	for (size_t i = 0; i < joints.size(); i++) {
+		if (joints[i].name == name) {
+			return static_cast<uint16_t>(i);
+		}
+	}
+	return {};
+}
+
+void TGW::Anim::GetBindPose(const Skeleton &skeleton, std::span<JointTransform> pose)
+{
+	const size_t count = std::min(pose.size(), skeleton.joints.size());
+	for (size_t i = 0; i < count; i++) {
+		pose[i] = skeleton.joints[i].bindPose;
+	}
+}
+
+void TGW::Anim::BlendPoses(
+	std::span<const JointTransform> a, std::span<const JointTransform> b, float weight, std::span<JointTransform> out)
+{
+	const size_t count = std::min({a.size(), b.size(), out.size()});
+	const XMVECTOR t = XMVectorReplicate(weight);
+	for (size_t i = 0; i < count; i++) {
+		const XMVECTOR rotationA = XMLoadFloat4(&a[i].rotation);
+		XMVECTOR rotationB = XMLoadFloat4(&b[i].rotation);
+		// q and -q are the same rotation, flip b onto a's side so the blend does not go the long way
+		rotationB = XMVectorSelect(
+			rotationB, XMVectorNegate(rotationB), XMVectorLess(XMVector4Dot(rotationA, rotationB), XMVectorZero()));
+
+		XMStoreFloat4(&out[i].rotation, XMQuaternionNormalize(XMVectorLerpV(rotationA, rotationB, t)));
+		XMStoreFloat3(&out[i].translation, XMVectorLerpV(XMLoadFloat3(&a[i].translation), XMLoadFloat3(&b[i].translation), t));
+		XMStoreFloat3(&out[i].scale, XMVectorLerpV(XMLoadFloat3(&a[i].scale), XMLoadFloat3(&b[i].scale), t));
+	}
+}
+
+void TGW::Anim::BuildSkinningMatrices(
+	const Skeleton &skeleton, std::span<const JointTransform> pose, std::span<XMFLOAT4X4> matrices)
+{
+	const size_t count = std::min({skeleton.joints.size(), pose.size(), matrices.size()});
+	// Model space first, parents come before their children so theirs is always ready
+	for (size_t i = 0; i < count; i++) {
+		const JointTransform &local = pose[i];
+		XMMATRIX model = XMMatrixAffineTransformation(
+			XMLoadFloat3(&local.scale), XMVectorZero(), XMLoadFloat4(&local.rotation), XMLoadFloat3(&local.translation));
+		const uint16_t parent = skeleton.joints[i].parent;
+		if (parent != JOINT_NO_PARENT && parent < i) {
+			model = XMMatrixMultiply(model, XMLoadFloat4x4(&matrices[parent]));
+		}
+		XMStoreFloat4x4(&matrices[i], model);
+	}
+	for (size_t i = 0; i < count; i++) {
+		XMStoreFloat4x4(
+			&matrices[i], XMMatrixMultiply(XMLoadFloat4x4(&skeleton.joints[i].inverseBind), XMLoadFloat4x4(&matrices[i])));
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.h"
+
+#include <span>
+
+namespace TGW::Anim {
+
+// Joint indices go into a byte per influence of the vertex skin
+constexpr uint32_t ANIM_MAX_JOINTS = 256;
+constexpr uint32_t ANIM_MAX_INFLUENCES = 4;
+constexpr uint16_t JOINT_NO_PARENT = UINT16_MAX;
+
+// Pose of a joint relative to its parent
+struct JointTransform {
+	DirectX::XMFLOAT4 rotation{0.0f, 0.0f, 0.0f, 1.0f};
+	DirectX::XMFLOAT3 translation{0.0f, 0.0f, 0.0f};
+	DirectX::XMFLOAT3 scale{1.0f, 1.0f, 1.0f};
+};
+
+struct Joint {
+	std::string name;
+	uint16_t parent = JOINT_NO_PARENT;
+	// Model space to joint space at bind time, row vector layout like the rest of DirectXMath
+	DirectX::XMFLOAT4X4 inverseBind{};
+	JointTransform bindPose;
+};
+
+// Joints are ordered parents first, so a pose resolves in one pass from the front
+struct Skeleton {
+	std::vector<Joint> joints;
+
+	inline uint32_t GetJointCount() const { return static_cast<uint32_t>(joints.size()); }
+	std::optional<uint16_t> FindJoint(std::string_view name) const;
+};
+
+// Up to ANIM_MAX_INFLUENCES joints moving a vertex, weights summing to 1 and unused ones 0
+struct VertexSkin {
+	std::array<uint8_t, ANIM_MAX_INFLUENCES> joints{};
+	std::array<float, ANIM_MAX_INFLUENCES> weights{};
+};
+
+// Bind pose of every joint
+void GetBindPose(const Skeleton &skeleton, std::span<JointTransform> pose);
+
+// out = a blended toward b by weight, per joint. Rotations take the short way around and are normalized
+// (nlerp), which for the small angles between animation frames matches slerp closely at a fraction of the cost.
+void BlendPoses(
+	std::span<const JointTransform> a, std::span<const JointTransform> b, float weight, std::span<JointTransform> out);
+
+// Model space matrix of every joint times its inverse bind matrix, what a skinning shader multiplies vertices by
+void BuildSkinningMatrices(
+	const Skeleton &skeleton, std::span<const JointTransform> pose, std::span<DirectX::XMFLOAT4X4> matrices);
+
+} // namespace TGW::Anim
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+// On-disk layout of a packed asset archive (.pak):
+//
+//   ArchiveHeader
+//   chunk data      every asset split in CHUNK_SIZE pieces, LZ4 compressed, stored in load order
+//   ArchiveChunk[]  one per chunk
+//   ArchiveEntry[]  one per asset, sorted by pathHash so lookups are a binary search
+//   string table    zero terminated normalized paths, only used for listing and collision checks
+//
+// The archive is read straight out of a memory map, so every struct is little-endian and naturally aligned.
+
+namespace TGW::Archive {
+
+static_assert(std::endian::native == std::endian::little, "Archives are mapped as-is, big-endian hosts are not supported");
+
+constexpr uint32_t ARCHIVE_MAGIC = 0x4B415053; // "SPAK"
+constexpr uint32_t ARCHIVE_VERSION = 1;
+constexpr uint32_t CHUNK_SIZE = 256 * 1024;
+
+struct ArchiveHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t chunkCount;
+	uint64_t chunkTableOffset;
+	uint64_t entryTableOffset;
+	uint64_t stringTableOffset;
+	uint64_t stringTableSize;
+};
+
+struct ArchiveChunk {
+	uint64_t offset;
+	uint32_t storedSize; // equal to size when LZ4 could not shrink the chunk and it is stored raw
+	uint32_t size;
+};
+
+struct ArchiveEntry {
+	uint64_t pathHash;
+	uint64_t size;
+	uint32_t firstChunk;
+	uint32_t chunkCount;
+	uint32_t loadOrder;
+	uint32_t nameOffset;
+};
+
+static_assert(sizeof(ArchiveHeader) == 48);
+static_assert(sizeof(ArchiveChunk) == 16);
+static_assert(sizeof(ArchiveEntry) == 32);
+
+} // namespace TGW::Archive
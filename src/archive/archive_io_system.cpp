@@ -0,0 +1,26 @@
+#include "archive_io_system.h"
+
+#include <assimp/MemoryIOWrapper.h>
+
+using namespace TGW::Archive;
+
+bool ArchiveIOSystem::Exists(const char *file) const
+{
+	return _archives.Find(file).has_value() || Assimp::DefaultIOSystem::Exists(file);
+}
+
+Assimp::IOStream *ArchiveIOSystem::Open(const char *file, const char *mode)
+{
+	const bool isRead = std::string_view{mode}.find_first_of("wa+") == std::string_view::npos;
+	if (isRead) {
+		if (auto location = _archives.Find(file)) {
+			const size_t size = location->entry->size;
+			// MemoryIOStream releases the buffer with delete[] when it owns it
+			std::unique_ptr<uint8_t[]> buffer{new uint8_t[size]};
+			if (location->reader->ReadInto(*location->entry, buffer.get())) {
+				return new Assimp::MemoryIOStream(buffer.release(), size, true);
+			}
+		}
+	}
+	return Assimp::DefaultIOSystem::Open(file, mode);
+}
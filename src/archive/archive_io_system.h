@@ -0,0 +1,21 @@
+#pragma once
+
+#include "archive_set.h"
+
+#include <assimp/DefaultIOSystem.h>
+
+namespace TGW::Archive {
+
+// Lets Assimp pull a model and its side files (.bin, .mtl, ...) out of the mounted archives, loose files are the fallback
+class ArchiveIOSystem : public Assimp::DefaultIOSystem {
+  public:
+	explicit ArchiveIOSystem(const ArchiveSet &archives) : _archives{archives} {}
+
+	bool Exists(const char *file) const override;
+	Assimp::IOStream *Open(const char *file, const char *mode = "rb") override;
+
+  private:
+	const ArchiveSet &_archives;
+};
+
+} // namespace TGW::Archive
@@ -0,0 +1,199 @@
+#include "archive_reader.h"
+#include "core/hash.h"
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+using namespace TGW::Archive;
+
+namespace {
+struct ChunkRequest {
+	const ArchiveChunk *chunk;
+	uint8_t *dst;
+	uint32_t result;
+};
+
+// Neighbouring ranges closer than this are prefetched as one
+constexpr uint64_t PREFETCH_MERGE_GAP = 64 * 1024;
+
+// Offsets come from the file, so the check must not wrap around when one is close to UINT64_MAX
+inline bool InBounds(uint64_t offset, uint64_t size, uint64_t limit) { return offset <= limit && size <= limit - offset; }
+} // namespace
+
+bool ArchiveReader::Open(const std::filesystem::path &path)
+{
+	if (!_mapping.Open(path) || _mapping.GetSize() < sizeof(ArchiveHeader)) {
+		return false;
+	}
+
+	std::memcpy(&_header, _mapping.GetData(), sizeof(ArchiveHeader));
+	if (_header.magic != ARCHIVE_MAGIC || _header.version != ARCHIVE_VERSION) {
+		_mapping.Close();
+		return false;
+	}
+
+	const uint64_t fileSize = _mapping.GetSize();
+	const bool tablesInBounds =
+		InBounds(_header.chunkTableOffset, uint64_t(_header.chunkCount) * sizeof(ArchiveChunk), fileSize) &&
+		InBounds(_header.entryTableOffset, uint64_t(_header.entryCount) * sizeof(ArchiveEntry), fileSize) &&
+		InBounds(_header.stringTableOffset, _header.stringTableSize, fileSize) && _header.chunkTableOffset % 8 == 0 &&
+		_header.entryTableOffset % 8 == 0;
+	if (!tablesInBounds) {
+		_mapping.Close();
+		return false;
+	}
+
+	_chunks = reinterpret_cast<const ArchiveChunk *>(_mapping.GetData() + _header.chunkTableOffset);
+	_entries = reinterpret_cast<const ArchiveEntry *>(_mapping.GetData() + _header.entryTableOffset);
+	_strings = reinterpret_cast<const char *>(_mapping.GetData() + _header.stringTableOffset);
+
+	for (const ArchiveChunk &chunk : std::span{_chunks, _header.chunkCount}) {
+		if (!InBounds(chunk.offset, chunk.storedSize, _header.chunkTableOffset) || chunk.size > CHUNK_SIZE) {
+			_mapping.Close();
+			return false;
+		}
+	}
+	for (const ArchiveEntry &entry : GetEntries()) {
+		if (uint64_t(entry.firstChunk) + entry.chunkCount > _header.chunkCount || entry.nameOffset >= _header.stringTableSize) {
+			_mapping.Close();
+			return false;
+		}
+
+		// Readers decompress chunk i at i * CHUNK_SIZE, so only the last chunk of an asset may be short
+		uint64_t size = 0;
+		for (uint32_t c = 0; c < entry.chunkCount; c++) {
+			const ArchiveChunk &chunk = _chunks[entry.firstChunk + c];
+			if (c + 1 < entry.chunkCount && chunk.size != CHUNK_SIZE) {
+				_mapping.Close();
+				return false;
+			}
+			size += chunk.size;
+		}
+		if (size != entry.size) {
+			_mapping.Close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const ArchiveEntry *ArchiveReader::Find(std::string_view path) const { return Find(Hash::HashPath(path)); }
+
+const ArchiveEntry *ArchiveReader::Find(uint64_t pathHash) const
+{
+	auto entries = GetEntries();
+	auto it = std::lower_bound(
+		entries.begin(), entries.end(), pathHash, [](const ArchiveEntry &entry, uint64_t hash) { return entry.pathHash < hash; });
+	if (it == entries.end() || it->pathHash != pathHash) {
+		return nullptr;
+	}
+	return &*it;
+}
+
+bool ArchiveReader::ReadInto(const ArchiveEntry &entry, uint8_t *dst, JobSystem &jobs) const
+{
+	const ArchiveChunk *chunks = _chunks + entry.firstChunk;
+	if (entry.chunkCount > 0) {
+		const ArchiveChunk &last = chunks[entry.chunkCount - 1];
+		_mapping.Prefetch(chunks[0].offset, last.offset + last.storedSize - chunks[0].offset);
+	}
+
+	std::atomic<bool> ok{true};
+	jobs.ParallelFor(entry.chunkCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (!DecompressChunk(chunks[i], dst + uint64_t(i) * CHUNK_SIZE)) {
+				ok = false;
+			}
+		}
+	});
+	return ok;
+}
+
+std::optional<std::vector<uint8_t>> ArchiveReader::Read(std::string_view path, JobSystem &jobs) const
+{
+	const ArchiveEntry *entry = Find(path);
+	if (!entry) {
+		return {};
+	}
+
+	std::vector<uint8_t> data(entry->size);
+	if (!ReadInto(*entry, data.data(), jobs)) {
+		return {};
+	}
+	return data;
+}
+
+std::vector<std::optional<std::vector<uint8_t>>>
+ArchiveReader::ReadBatch(std::span<const std::string> paths, JobSystem &jobs) const
+{
+	std::vector<std::optional<std::vector<uint8_t>>> results(paths.size());
+	std::vector<ChunkRequest> requests;
+	for (uint32_t i = 0; i < paths.size(); i++) {
+		const ArchiveEntry *entry = Find(paths[i]);
+		if (!entry) {
+			continue;
+		}
+
+		results[i].emplace(entry->size);
+		for (uint32_t c = 0; c < entry->chunkCount; c++) {
+			requests.push_back({&_chunks[entry->firstChunk + c], results[i]->data() + uint64_t(c) * CHUNK_SIZE, i});
+		}
+	}
+
+	// Walk the file front to back: archives are written in load order, so a level batch is mostly one sequential range
+	std::sort(requests.begin(), requests.end(), [](const ChunkRequest &a, const ChunkRequest &b) {
+		return a.chunk->offset < b.chunk->offset;
+	});
+	for (size_t i = 0; i < requests.size();) {
+		const uint64_t begin = requests[i].chunk->offset;
+		uint64_t end = begin + requests[i].chunk->storedSize;
+		for (i++; i < requests.size() && requests[i].chunk->offset <= end + PREFETCH_MERGE_GAP; i++) {
+			end = std::max(end, requests[i].chunk->offset + requests[i].chunk->storedSize);
+		}
+		_mapping.Prefetch(begin, end - begin);
+	}
+
+	auto failed = std::make_unique<std::atomic<bool>[]>(paths.size());
+	jobs.ParallelFor(static_cast<uint32_t>(requests.size()), 2, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (!DecompressChunk(*requests[i].chunk, requests[i].dst)) {
+				failed[requests[i].result] = true;
+			}
+		}
+	});
+
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (failed[i]) {
+			results[i].reset();
+		}
+	}
+	return results;
+}
+
+void ArchiveReader::Evict() const { _mapping.Evict(0, _mapping.GetSize()); }
+
+std::string_view ArchiveReader::GetName(const ArchiveEntry &entry) const
+{
+	const size_t maxLength = _header.stringTableSize - entry.nameOffset;
+	const char *name = _strings + entry.nameOffset;
+	return {name, strnlen(name, maxLength)};
+}
+
+bool ArchiveReader::DecompressChunk(const ArchiveChunk &chunk, uint8_t *dst) const
+{
+	const uint8_t *src = _mapping.GetData() + chunk.offset;
+	if (chunk.storedSize == chunk.size) {
+		std::memcpy(dst, src, chunk.size);
+		return true;
+	}
+
+	const int written = LZ4_decompress_safe(
+		reinterpret_cast<const char *>(src), reinterpret_cast<char *>(dst), static_cast<int>(chunk.storedSize),
+		static_cast<int>(chunk.size));
+	return written == static_cast<int>(chunk.size);
+}
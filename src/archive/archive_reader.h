@@ -0,0 +1,48 @@
+#pragma once
+
+#include "archive_format.h"
+#include "core/file_mapping.h"
+#include "core/job_system.h"
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace TGW::Archive {
+
+class ArchiveReader {
+  public:
+	bool Open(const std::filesystem::path &path);
+
+	const ArchiveEntry *Find(std::string_view path) const;
+	const ArchiveEntry *Find(uint64_t pathHash) const;
+
+	// dst must hold entry.size bytes. Chunks of big assets are decompressed in parallel.
+	bool ReadInto(const ArchiveEntry &entry, uint8_t *dst, JobSystem &jobs = JobSystem::Get()) const;
+	std::optional<std::vector<uint8_t>> Read(std::string_view path, JobSystem &jobs = JobSystem::Get()) const;
+
+	// Prefetches every touched range in one go and decompresses all chunks of all assets in parallel.
+	// Results come back in the same order as paths, missing or corrupt assets are empty.
+	std::vector<std::optional<std::vector<uint8_t>>>
+	ReadBatch(std::span<const std::string> paths, JobSystem &jobs = JobSystem::Get()) const;
+
+	// Drops the archive from the page cache, used to measure cold loads
+	void Evict() const;
+
+	std::string_view GetName(const ArchiveEntry &entry) const;
+	inline std::span<const ArchiveEntry> GetEntries() const { return {_entries, _header.entryCount}; }
+	inline size_t GetFileSize() const { return _mapping.GetSize(); }
+
+  private:
+	bool DecompressChunk(const ArchiveChunk &chunk, uint8_t *dst) const;
+
+	FileMapping _mapping;
+	ArchiveHeader _header{};
+	const ArchiveChunk *_chunks = nullptr;
+	const ArchiveEntry *_entries = nullptr;
+	const char *_strings = nullptr;
+};
+
+} // namespace TGW::Archive
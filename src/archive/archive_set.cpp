@@ -0,0 +1,58 @@
+#include "archive_set.h"
+
+using namespace TGW::Archive;
+
+static std::filesystem::path MakeAbsolute(const std::filesystem::path &path)
+{
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	return error ? path.lexically_normal() : absolute.lexically_normal();
+}
+
+bool ArchiveSet::Mount(const std::filesystem::path &archivePath)
+{
+	return Mount(archivePath, MakeAbsolute(archivePath).parent_path());
+}
+
+bool ArchiveSet::Mount(const std::filesystem::path &archivePath, const std::filesystem::path &mountRoot)
+{
+	auto reader = std::make_unique<ArchiveReader>();
+	if (!reader->Open(archivePath)) {
+		return false;
+	}
+	_mounts.push_back({std::move(reader), MakeAbsolute(mountRoot)});
+	return true;
+}
+
+std::optional<ArchiveSet::Location> ArchiveSet::Find(const std::filesystem::path &path) const
+{
+	if (_mounts.empty()) {
+		return {};
+	}
+
+	const std::filesystem::path absolute = MakeAbsolute(path);
+	for (auto mount = _mounts.rbegin(); mount != _mounts.rend(); ++mount) {
+		const std::filesystem::path relative = absolute.lexically_relative(mount->root);
+		if (relative.empty() || *relative.begin() == "..") {
+			continue;
+		}
+		if (const ArchiveEntry *entry = mount->reader->Find(relative.generic_string())) {
+			return Location{mount->reader.get(), entry};
+		}
+	}
+	return {};
+}
+
+std::optional<std::vector<uint8_t>> ArchiveSet::Read(const std::filesystem::path &path) const
+{
+	auto location = Find(path);
+	if (!location) {
+		return {};
+	}
+
+	std::vector<uint8_t> data(location->entry->size);
+	if (!location->reader->ReadInto(*location->entry, data.data())) {
+		return {};
+	}
+	return data;
+}
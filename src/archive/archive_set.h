@@ -0,0 +1,36 @@
+#pragma once
+
+#include "archive_reader.h"
+
+#include <memory>
+
+namespace TGW::Archive {
+
+// All mounted archives. Asset code asks here before touching loose files.
+class ArchiveSet {
+  public:
+	struct Location {
+		const ArchiveReader *reader;
+		const ArchiveEntry *entry;
+	};
+
+	// Files under mountRoot resolve to archive paths relative to it. By default that is the folder holding the archive.
+	// Later mounts shadow earlier ones, so patches can be layered on top of the base content.
+	bool Mount(const std::filesystem::path &archivePath);
+	bool Mount(const std::filesystem::path &archivePath, const std::filesystem::path &mountRoot);
+
+	std::optional<Location> Find(const std::filesystem::path &path) const;
+	std::optional<std::vector<uint8_t>> Read(const std::filesystem::path &path) const;
+
+	inline bool IsEmpty() const { return _mounts.empty(); }
+
+  private:
+	struct MountPoint {
+		std::unique_ptr<ArchiveReader> reader;
+		std::filesystem::path root;
+	};
+
+	std::vector<MountPoint> _mounts;
+};
+
+} // namespace TGW::Archive
@@ -0,0 +1,128 @@
+#include "archive_writer.h"
+#include "archive_format.h"
+#include "core/hash.h"
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace TGW::Archive;
+
+namespace {
+struct ChunkJob {
+	const uint8_t *source;
+	uint32_t size;
+	std::vector<uint8_t> stored;
+};
+} // namespace
+
+bool ArchiveWriter::Add(std::string_view path, std::vector<uint8_t> data)
+{
+	std::string normalized = Hash::NormalizePath(path);
+	const uint64_t hash = Hash::Fnv1a(normalized);
+	if (_assetByHash.contains(hash)) {
+		return false;
+	}
+
+	_assetByHash.emplace(hash, _assets.size());
+	_assets.push_back({std::move(normalized), hash, std::move(data)});
+	return true;
+}
+
+bool ArchiveWriter::Write(const std::filesystem::path &path, JobSystem &jobs) const
+{
+	std::vector<ChunkJob> chunkJobs;
+	std::vector<ArchiveEntry> entries;
+	entries.reserve(_assets.size());
+
+	std::string stringTable;
+	for (uint32_t i = 0; i < _assets.size(); i++) {
+		const PendingAsset &asset = _assets[i];
+		ArchiveEntry entry{
+		  .pathHash = asset.pathHash,
+		  .size = asset.data.size(),
+		  .firstChunk = static_cast<uint32_t>(chunkJobs.size()),
+		  .chunkCount = 0,
+		  .loadOrder = i,
+		  .nameOffset = static_cast<uint32_t>(stringTable.size()),
+		};
+		stringTable += asset.path;
+		stringTable.push_back('\0');
+
+		for (size_t offset = 0; offset < asset.data.size(); offset += CHUNK_SIZE) {
+			const uint32_t size = static_cast<uint32_t>(std::min<size_t>(CHUNK_SIZE, asset.data.size() - offset));
+			chunkJobs.push_back({asset.data.data() + offset, size, {}});
+			entry.chunkCount++;
+		}
+		entries.push_back(entry);
+	}
+
+	jobs.ParallelFor(static_cast<uint32_t>(chunkJobs.size()), 4, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			ChunkJob &job = chunkJobs[i];
+			job.stored.resize(LZ4_compressBound(static_cast<int>(job.size)));
+			const int compressed = LZ4_compress_default(
+				reinterpret_cast<const char *>(job.source), reinterpret_cast<char *>(job.stored.data()),
+				static_cast<int>(job.size), static_cast<int>(job.stored.size()));
+			if (compressed <= 0 || static_cast<uint32_t>(compressed) >= job.size) {
+				job.stored.assign(job.source, job.source + job.size);
+			} else {
+				job.stored.resize(compressed);
+			}
+		}
+	});
+
+	std::ofstream file{path, std::ios::binary | std::ios::trunc};
+	if (!file) {
+		return false;
+	}
+
+	ArchiveHeader header{
+	  .magic = ARCHIVE_MAGIC,
+	  .version = ARCHIVE_VERSION,
+	  .entryCount = static_cast<uint32_t>(entries.size()),
+	  .chunkCount = static_cast<uint32_t>(chunkJobs.size()),
+	  // Known once the chunks are written, the header goes out again at the end
+	  .chunkTableOffset = 0,
+	  .entryTableOffset = 0,
+	  .stringTableOffset = 0,
+	  .stringTableSize = 0,
+	};
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	std::vector<ArchiveChunk> chunks;
+	chunks.reserve(chunkJobs.size());
+	uint64_t offset = sizeof(header);
+	for (const ChunkJob &job : chunkJobs) {
+		chunks.push_back({offset, static_cast<uint32_t>(job.stored.size()), job.size});
+		file.write(reinterpret_cast<const char *>(job.stored.data()), job.stored.size());
+		offset += job.stored.size();
+	}
+
+	// Keep the tables 8 byte aligned so they can be read in place from the mapping
+	const uint64_t padding = (8 - offset % 8) % 8;
+	const char zeros[8] = {};
+	file.write(zeros, padding);
+	offset += padding;
+
+	std::sort(
+		entries.begin(), entries.end(), [](const ArchiveEntry &a, const ArchiveEntry &b) { return a.pathHash < b.pathHash; });
+
+	header.chunkTableOffset = offset;
+	file.write(reinterpret_cast<const char *>(chunks.data()), chunks.size() * sizeof(ArchiveChunk));
+	offset += chunks.size() * sizeof(ArchiveChunk);
+
+	header.entryTableOffset = offset;
+	file.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(ArchiveEntry));
+	offset += entries.size() * sizeof(ArchiveEntry);
+
+	header.stringTableOffset = offset;
+	header.stringTableSize = stringTable.size();
+	file.write(stringTable.data(), stringTable.size());
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/job_system.h"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace TGW::Archive {
+
+class ArchiveWriter {
+  public:
+	// Assets are laid out in the order they are added, which should be the order the game asks for them.
+	// Fails when the path (or its hash) is already in the archive.
+	bool Add(std::string_view path, std::vector<uint8_t> data);
+
+	// Chunks are compressed in parallel, then the file is written front to back in one go
+	bool Write(const std::filesystem::path &path, JobSystem &jobs = JobSystem::Get()) const;
+
+	inline size_t GetAssetCount() const { return _assets.size(); }
+
+  private:
+	struct PendingAsset {
+		std::string path;
+		uint64_t pathHash;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<PendingAsset> _assets;
+	std::unordered_map<uint64_t, size_t> _assetByHash;
+};
+
+} // namespace TGW::Archive
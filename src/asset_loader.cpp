@@ -1,6 +1,9 @@
 #include "asset_loader.h"
+#include "archive/archive_io_system.h"
+#include "cook/cook_cache.h"
+#include "gltf/gltf_loader.h"
 #include "log.h"
-#include "texture.h"
+#include "obj/obj_loader.h"
 
 #include <assimp/importer.hpp>
 #include <assimp/postprocess.h>
@@ -13,9 +16,22 @@ DirectX::XMMATRIX ConvertToDirectXMatrix(aiMatrix4x4 from);
 
 std::optional<Model> AssetLoader::LoadModel(std::string_view path)
 {
+	// Loose glTF and OBJ files skip Assimp, anything the native loaders do not handle still goes through it
+	if (!(_archives && _archives->Find(path))) {
+		if (std::optional<Model> model = TGW::Gltf::IsGltfFile(path) ? LoadGltfModel(path) : std::nullopt) {
+			return model;
+		}
+		if (std::optional<Model> model = TGW::Obj::IsObjFile(path) ? LoadObjModel(path) : std::nullopt) {
+			return model;
+		}
+	}
+
 	Assimp::Importer importer;
-	const aiScene *scene =
-		importer.ReadFile(path.data(), aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices);
+	if (_archives && !_archives->IsEmpty()) {
+		// The importer takes ownership of the handler
+		importer.SetIOHandler(new TGW::Archive::ArchiveIOSystem(*_archives));
+	}
+	const aiScene *scene = importer.ReadFile(path.data(), MODEL_IMPORT_FLAGS);
 
 	if (!scene || !scene->HasMeshes()) {
 		std::string errorMsg = std::format("Failed to load model asset.\n\nPath: {}\nError: {}", path, importer.GetErrorString());
@@ -24,48 +40,119 @@ std::optional<Model> AssetLoader::LoadModel(std::string_view path)
 	}
 
 	std::filesystem::path fsPath{path};
-	std::string basePath = fsPath.parent_path().string();
 
 	Model model;
 	model.name = fsPath.filename().string();
+	model.path = std::string{path};
 	model.worldMatrix = ConvertToDirectXMatrix(scene->mRootNode->mTransformation);
 	for (uint32_t i = 0; i < scene->mNumMaterials; i++) {
-		model.materials.push_back(LoadMaterial(scene, scene->mMaterials[i], basePath));
+		model.materials.push_back(LoadMaterial(scene, scene->mMaterials[i], path));
 	}
 
+	std::vector<MeshData> meshes;
 	for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
-		model.meshes.push_back(LoadMesh(scene->mMeshes[i]));
+		meshes.push_back(BuildMeshData(scene->mMeshes[i]));
+		model.meshes.push_back(CreateMeshBuffer(meshes.back()));
 	}
+	model.occluder = TGW::Cull::BuildOccluderMesh(meshes);
+	SortMeshes(model);
+	CountMemory(model);
 
 	return model;
 }
 
 /* Implementation of private functions */
 
-MeshBuffer AssetLoader::LoadMesh(const aiMesh *mesh)
+std::optional<Model> AssetLoader::LoadGltfModel(std::string_view path)
 {
-	std::vector<Vertex> vertices(mesh->mNumVertices);
-	for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
-		vertices[i] = {
-		  {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z},
-		  {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z},
-		  {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y}};
+	std::optional<TGW::Gltf::GltfModel> gltf = TGW::Gltf::Load(path);
+	if (!gltf || gltf->meshes.empty()) {
+		return {};
 	}
-	D3D11_SUBRESOURCE_DATA vbData = {vertices.data()};
+	return BuildModel(path, DirectX::XMLoadFloat4x4(&gltf->rootTransform), gltf->materials, gltf->meshes, gltf->embeddedImages);
+}
 
-	std::vector<uint32_t> indices(mesh->mNumFaces * 3);
-	for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
-		indices[i * 3 + 0] = mesh->mFaces[i].mIndices[0];
-		indices[i * 3 + 1] = mesh->mFaces[i].mIndices[1];
-		indices[i * 3 + 2] = mesh->mFaces[i].mIndices[2];
+std::optional<Model> AssetLoader::LoadObjModel(std::string_view path)
+{
+	std::optional<TGW::Obj::ObjModel> obj = TGW::Obj::Load(path);
+	if (!obj || obj->meshes.empty()) {
+		return {};
 	}
-	D3D11_SUBRESOURCE_DATA ibData = {indices.data()};
+	return BuildModel(path, DirectX::XMMatrixIdentity(), obj->materials, obj->meshes, {});
+}
+
+Model AssetLoader::BuildModel(std::string_view path, DirectX::FXMMATRIX rootTransform, std::span<const MaterialData> materials,
+	std::span<const MeshData> meshes, std::span<const std::span<const uint8_t>> embeddedImages)
+{
+	std::filesystem::path fsPath{path};
+	const std::filesystem::path basePath = fsPath.parent_path();
+
+	Model model;
+	model.name = fsPath.filename().string();
+	model.path = std::string{path};
+	model.worldMatrix = rootTransform;
+	for (const MaterialData &data : materials) {
+		TGW::Cook::MaterialEntry material;
+		for (size_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++) {
+			const std::string &texPath = data.textures[slot];
+			if (texPath.empty() || !_materials) {
+				continue;
+			}
+			if (IsEmbeddedTexturePath(texPath)) {
+				const uint32_t index = std::strtoul(texPath.c_str() + 1, nullptr, 10);
+				if (index < embeddedImages.size()) {
+					material.textures[slot] = _materials->AddTexture(_device, model.path + texPath, embeddedImages[index]);
+				}
+				continue;
+			}
+			material.textures[slot] = LoadTextureFile(basePath / texPath);
+		}
+		model.materials.push_back(_materials ? _materials->AddMaterial(material) : 0);
+	}
+
+	for (const MeshData &data : meshes) {
+		model.meshes.push_back(CreateMeshBuffer(data));
+	}
+	model.occluder = TGW::Cull::BuildOccluderMesh(meshes);
+	SortMeshes(model);
+	CountMemory(model);
+
+	return model;
+}
 
+MeshBuffer AssetLoader::CreateMeshBuffer(const MeshData &data)
+{
 	MeshBuffer out{
-	  .indexCount = (uint32_t)indices.size(),
-	  .materialIndex = mesh->mMaterialIndex,
+	  .indexCount = (uint32_t)data.indices.size(),
+	  .materialIndex = data.materialIndex,
+	};
+	if (!_geometry) {
+		out.geometry = std::make_shared<const MeshGeometry>(*CreateGeometry(data));
+		return out;
+	}
+
+	// Indices are hashed on from the vertices, so the pair is one key
+	const std::span<const uint8_t> vertexBytes{
+	  reinterpret_cast<const uint8_t *>(data.vertices.data()), data.vertices.size() * sizeof(Vertex)};
+	const std::span<const uint8_t> indexBytes{
+	  reinterpret_cast<const uint8_t *>(data.indices.data()), data.indices.size() * sizeof(uint32_t)};
+	const TGW::Hash::Hash128 vertexHash = TGW::Hash::ContentHash128(vertexBytes);
+	const TGW::ContentKey key{
+	  .hash = TGW::Hash::ContentHash128(indexBytes, vertexHash.low ^ vertexHash.high),
+	  .bytes = vertexBytes.size() + indexBytes.size(),
 	};
+	out.geometry = _geometry->Acquire(key, [&] { return CreateGeometry(data); });
+	return out;
+}
+
+std::optional<MeshGeometry> AssetLoader::CreateGeometry(const MeshData &data)
+{
+	const std::vector<Vertex> &vertices = data.vertices;
+	const std::vector<uint32_t> &indices = data.indices;
+	D3D11_SUBRESOURCE_DATA vbData = {vertices.data()};
+	D3D11_SUBRESOURCE_DATA ibData = {indices.data()};
 
+	MeshGeometry out;
 	D3D11_BUFFER_DESC vbDesc{
 	  .ByteWidth = UINT(sizeof(Vertex) * vertices.size()),
 	  .Usage = D3D11_USAGE_DEFAULT,
@@ -79,49 +166,74 @@ MeshBuffer AssetLoader::LoadMesh(const aiMesh *mesh)
 	  .BindFlags = D3D11_BIND_INDEX_BUFFER,
 	};
 	ASSERT_SUCCEEDED(_device->CreateBuffer(&ibDesc, &ibData, out.indexBuffer.GetAddressOf()));
+	out.memory =
+		TGW::TrackedAllocation{TGW::MEMORY_TAG_MESHES, TGW::MEMORY_POOL_GPU, uint64_t{vbDesc.ByteWidth} + ibDesc.ByteWidth};
 
 	return out;
 }
 
-ComPtr<ID3D11ShaderResourceView>
-AssetLoader::LoadMaterialTexture(const aiScene *scene, const char *texPath, std::string_view basePath)
+uint32_t AssetLoader::LoadMaterial(const aiScene *scene, const aiMaterial *mat, std::string_view modelPath)
 {
-	if (const aiTexture *embeddedTex = scene->GetEmbeddedTexture(texPath)) {
-		const BOOL isCompressed = embeddedTex->mHeight == 0;
-		if (isCompressed) {
-			return TGW::Texture::LoadEmbeddedCompressed(
-				_device, reinterpret_cast<const uint8_t *>(embeddedTex->pcData), embeddedTex->mWidth);
-		} else {
-			// TODO
-		}
+	if (!_materials) {
+		return 0;
 	}
 
-	std::filesystem::path fullPath = std::filesystem::path(basePath) / texPath;
-	return TGW::Texture::Load(_device, fullPath.wstring().c_str());
+	const MaterialData data = BuildMaterialData(mat);
+	const std::filesystem::path basePath = std::filesystem::path{modelPath}.parent_path();
+	TGW::Cook::MaterialEntry material;
+	for (size_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++) {
+		const std::string &texPath = data.textures[slot];
+		if (texPath.empty()) {
+			continue;
+		}
+		if (const aiTexture *embeddedTex = scene->GetEmbeddedTexture(texPath.c_str())) {
+			// Uncompressed embedded textures are not supported yet
+			if (embeddedTex->mHeight == 0) {
+				const std::span<const uint8_t> image{reinterpret_cast<const uint8_t *>(embeddedTex->pcData), embeddedTex->mWidth};
+				material.textures[slot] = _materials->AddTexture(_device, std::string{modelPath} + texPath, image);
+			}
+			continue;
+		}
+		material.textures[slot] = LoadTextureFile(basePath / texPath);
+	}
+	return _materials->AddMaterial(material);
 }
 
-Material AssetLoader::LoadMaterial(const aiScene *scene, const aiMaterial *mat, std::string_view basePath)
+TGW::Cook::TextureRef AssetLoader::LoadTextureFile(const std::filesystem::path &path)
 {
-	Material m{};
-	aiString aiTexPath;
-
-	if (mat->GetTexture(aiTextureType_DIFFUSE, 0, &aiTexPath) == aiReturn_SUCCESS) {
-		m.diffuse = LoadMaterialTexture(scene, aiTexPath.C_Str(), basePath);
+	// Models sharing a texture name it the same way, only the first one reads it
+	const std::string name = TGW::MaterialArrays::ToTextureName(path);
+	if (const auto ref = _materials->FindTexture(name)) {
+		return *ref;
 	}
 
-	if (mat->GetTexture(aiTextureType_SPECULAR, 0, &aiTexPath) == aiReturn_SUCCESS) {
-		m.specular = LoadMaterialTexture(scene, aiTexPath.C_Str(), basePath);
+	std::optional<std::vector<uint8_t>> data = _archives ? _archives->Read(path) : std::nullopt;
+	if (!data) {
+		data = TGW::Cook::ReadWholeFile(path);
 	}
-
-	if (mat->GetTexture(aiTextureType_HEIGHT, 0, &aiTexPath) == aiReturn_SUCCESS) {
-		m.normal = LoadMaterialTexture(scene, aiTexPath.C_Str(), basePath);
+	if (!data) {
+		TGW::Logger::LogInfo("Failed to read texture " + name);
+		return {};
 	}
+	return _materials->AddTexture(_device, name, *data);
+}
 
-	if (mat->GetTexture(aiTextureType_AMBIENT, 0, &aiTexPath) == aiReturn_SUCCESS) {
-		m.roughness = LoadMaterialTexture(scene, aiTexPath.C_Str(), basePath);
-	}
+void AssetLoader::SortMeshes(Model &model) const
+{
+	auto tableIndex = [&model](const MeshBuffer &mesh) {
+		return mesh.materialIndex < model.materials.size() ? model.materials[mesh.materialIndex] : 0;
+	};
+	std::stable_sort(model.meshes.begin(), model.meshes.end(),
+		[&](const MeshBuffer &a, const MeshBuffer &b) { return tableIndex(a) < tableIndex(b); });
+}
 
-	return m;
+void AssetLoader::CountMemory(Model &model) const
+{
+	const TGW::Cull::OccluderMesh &occluder = model.occluder;
+	const uint64_t occluderBytes =
+		occluder.positions.capacity() * sizeof(occluder.positions[0]) + occluder.indices.capacity() * sizeof(uint32_t);
+	model.occluderMemory = TGW::TrackedAllocation{TGW::MEMORY_TAG_SCENE, TGW::MEMORY_POOL_CPU, occluderBytes};
+	model.textureBytes = _materials ? _materials->GetTextureBytes(model.materials) : 0;
 }
 
 DirectX::XMMATRIX ConvertToDirectXMatrix(aiMatrix4x4 from)
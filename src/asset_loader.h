@@ -1,22 +1,43 @@
 #pragma once
 
 #include "pch.h"
+#include "material_arrays.h"
 #include "model.h"
 
 struct ID3D11Device;
 struct aiScene;
 struct aiMaterial;
 
+namespace TGW::Archive {
+class ArchiveSet;
+}
+
 class AssetLoader {
   public:
-	AssetLoader() : _device{nullptr} {};
-	AssetLoader(ID3D11Device *device) : _device{device} {};
+	AssetLoader() : _device{nullptr}, _materials{nullptr}, _geometry{nullptr}, _archives{nullptr} {};
+	AssetLoader(ID3D11Device *device, TGW::MaterialArrays *materials, GeometryRegistry *geometry,
+		const TGW::Archive::ArchiveSet *archives = nullptr)
+		: _device{device}, _materials{materials}, _geometry{geometry}, _archives{archives} {};
 	std::optional<Model> LoadModel(std::string_view path);
 
   private:
 	ID3D11Device *_device;
+	// Textures and materials of every model end up in this one table
+	TGW::MaterialArrays *_materials;
+	// Mesh buffers are looked up here by content before new ones are made
+	GeometryRegistry *_geometry;
+	// Mounted archives are searched before loose files, for the model itself and for its textures
+	const TGW::Archive::ArchiveSet *_archives;
 
-	MeshBuffer LoadMesh(const aiMesh *mesh);
-	Material LoadMaterial(const aiScene *scene, const aiMaterial *mat, std::string_view basePath);
-	ComPtr<ID3D11ShaderResourceView> LoadMaterialTexture(const aiScene *scene, const char *texPath, std::string_view basePath);
+	std::optional<Model> LoadGltfModel(std::string_view path);
+	std::optional<Model> LoadObjModel(std::string_view path);
+	// Model from what a native loader read, the way LoadModel builds it from Assimp
+	Model BuildModel(std::string_view path, DirectX::FXMMATRIX rootTransform, std::span<const MaterialData> materials,
+		std::span<const MeshData> meshes, std::span<const std::span<const uint8_t>> embeddedImages);
+	MeshBuffer CreateMeshBuffer(const MeshData &data);
+	std::optional<MeshGeometry> CreateGeometry(const MeshData &data);
+	uint32_t LoadMaterial(const aiScene *scene, const aiMaterial *mat, std::string_view modelPath);
+	TGW::Cook::TextureRef LoadTextureFile(const std::filesystem::path &path);
+	void SortMeshes(Model &model) const;
+	void CountMemory(Model &model) const;
 };
@@ -1,25 +1,28 @@
 #include "camera.h"
+#include "terrain/heightmap.h"
+
+#include <cmath>
 
 using namespace DirectX;
 
-// Most significant bit of SHORT returned by GetAsyncKeyState
-constexpr auto IS_KEY_DOWN_MASK = 0x8000;
+// Same as WHEEL_DELTA, one notch of a standard mouse wheel
+constexpr float WHEEL_NOTCH = 120.0f;
 
 Camera::Camera()
-	: _target{XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f)}, _up{XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)}, _zoom{10.0f}, _minZoom{5.0f},
-	  _maxZoom{15.0f}, _angle{XM_PIDIV4}, _speed{0.15f}, _lastMousePos{0, 0}, _moveSensitivity{0.005f}, _edgeSize{30},
-	  _zoomSensitivity{2.0f}
+	: _target{XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f)}, _up{XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)}, _speed{0.15f}, _zoom{10.0f},
+	  _minZoom{5.0f}, _maxZoom{15.0f}, _angle{XM_PIDIV4}, _moveSensitivity{0.005f}, _zoomSensitivity{2.0f}, _edgeSize{30},
+	  _lastMouseX{0}, _lastMouseY{0}
 {
 	XMVECTOR baseForward = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
 	XMMATRIX rotPitch = XMMatrixRotationX(_angle);
 	XMMATRIX rotYaw = XMMatrixRotationY(XM_PIDIV4);
-	XMMATRIX combinedRot = rotPitch * rotYaw;
+	XMMATRIX combinedRot = XMMatrixMultiply(rotPitch, rotYaw);
 	_forward = XMVector3TransformNormal(baseForward, combinedRot);
 }
 
 XMMATRIX Camera::GetViewMatrix() const
 {
-	XMVECTOR eyePos = _target - (_forward * _zoom);
+	XMVECTOR eyePos = XMVectorSubtract(_target, XMVectorScale(_forward, _zoom));
 	return XMMatrixLookAtLH(eyePos, _target, _up);
 }
 
@@ -37,47 +40,55 @@ DirectX::XMVECTOR Camera::GetPosition() const
 	return DirectX::XMVectorAdd(_target, pos);
 }
 
-void Camera::HandleMouse(HWND hwnd)
+std::optional<XMFLOAT2> Camera::ScreenToGround(float x, float y, float width, float height) const
 {
-	if (GetFocus() != hwnd)
-		return;
-
-	RECT rect;
-	GetClientRect(hwnd, &rect);
-	POINT cursorPosition;
-	GetCursorPos(&cursorPosition);
-	ScreenToClient(hwnd, &cursorPosition);
+	if (width <= 0.0f || height <= 0.0f) {
+		return {};
+	}
+	const XMMATRIX inverseViewProjection = XMMatrixInverse(nullptr, XMMatrixMultiply(GetViewMatrix(), GetProjectionMatrix()));
+	const float ndcX = 2.0f * x / width - 1.0f;
+	const float ndcY = 1.0f - 2.0f * y / height;
+	const XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 0.0f, 1.0f), inverseViewProjection);
+	const XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 1.0f, 1.0f), inverseViewProjection);
 
-	if (GetAsyncKeyState(VK_MBUTTON) & IS_KEY_DOWN_MASK) {
-		float dx = static_cast<float>(cursorPosition.x - _lastMousePos.x);
-		XMMATRIX rotY = XMMatrixRotationY(dx * _moveSensitivity);
-		_forward = XMVector3Normalize(XMVector3TransformNormal(_forward, rotY));
-	} else {
-		const int width = rect.right - rect.left;
-		const int height = rect.bottom - rect.top;
+	// Rays that run parallel to the ground or point away from it never reach it
+	const float nearY = XMVectorGetY(nearPoint);
+	const float deltaY = XMVectorGetY(farPoint) - nearY;
+	if (std::abs(deltaY) < 1e-6f || -nearY / deltaY < 0.0f) {
+		return {};
+	}
+	const XMVECTOR hit = XMVectorLerp(nearPoint, farPoint, -nearY / deltaY);
+	return XMFLOAT2{XMVectorGetX(hit), XMVectorGetZ(hit)};
+}
 
-		XMVECTOR normForward = XMVector3Normalize(XMVectorSet(XMVectorGetX(_forward), 0.0f, XMVectorGetZ(_forward), 0.0f));
-		XMVECTOR worldUp = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-		XMVECTOR normRight = XMVector3Cross(worldUp, normForward);
+void Camera::Orbit(float dx)
+{
+	XMMATRIX rotY = XMMatrixRotationY(dx * _moveSensitivity);
+	_forward = XMVector3Normalize(XMVector3TransformNormal(_forward, rotY));
+}
 
-		if (cursorPosition.x < _edgeSize) {
-			_target -= normRight * _speed;
-		} else if (cursorPosition.x > width - _edgeSize) {
-			_target += normRight * _speed;
-		}
+void Camera::Pan(int right, int forward)
+{
+	XMVECTOR normForward = XMVector3Normalize(XMVectorSet(XMVectorGetX(_forward), 0.0f, XMVectorGetZ(_forward), 0.0f));
+	XMVECTOR worldUp = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	XMVECTOR normRight = XMVector3Cross(worldUp, normForward);
 
-		if (cursorPosition.y < _edgeSize) {
-			_target += normForward * _speed;
-		} else if (cursorPosition.y > height - _edgeSize) {
-			_target -= normForward * _speed;
-		}
+	_target = XMVectorAdd(_target, XMVectorScale(normRight, static_cast<float>(right) * _speed));
+	_target = XMVectorAdd(_target, XMVectorScale(normForward, static_cast<float>(forward) * _speed));
+	if (_ground) {
+		_target = XMVectorSetY(_target, _ground->GetHeight(XMVectorGetX(_target), XMVectorGetZ(_target)));
 	}
+}
 
-	_lastMousePos = cursorPosition;
+void Camera::SetView(FXMVECTOR target, FXMVECTOR forward, float zoom)
+{
+	_target = target;
+	_forward = XMVector3Normalize(forward);
+	_zoom = std::clamp(zoom, _minZoom, _maxZoom);
 }
 
 void Camera::HandleZoom(short wheelDelta)
 {
-	_zoom -= (static_cast<float>(wheelDelta) / WHEEL_DELTA) * _zoomSensitivity;
+	_zoom -= (static_cast<float>(wheelDelta) / WHEEL_NOTCH) * _zoomSensitivity;
 	_zoom = std::clamp(_zoom, _minZoom, _maxZoom);
 }
\ No newline at end of file
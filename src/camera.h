@@ -1,21 +1,48 @@
 #pragma once
 
 
-#include "pch.h"
+#include "common.h"
+
+namespace TGW::Terrain {
+class Heightmap;
+}
+
+// What one HandleMouse call did to the camera, for the command recorder
+struct CameraMouseInput {
+	std::optional<float> orbit;
+	int panRight = 0;
+	int panForward = 0;
+};
 
 class Camera {
   public:
 	Camera();
 	DirectX::XMMATRIX GetViewMatrix() const;
-	void HandleMouse(HWND hwnd);
+#ifdef _WIN32
+	// Reads the cursor and middle button and turns them into Orbit / Pan calls, returns the ones it made
+	CameraMouseInput HandleMouse(HWND hwnd);
+#endif
 	void HandleZoom(short delta);
+
+	// Rotates around the target by a horizontal mouse delta in pixels
+	void Orbit(float dx);
+	// Moves the target on the ground plane, directions are -1, 0 or 1 along camera right and forward
+	void Pan(int right, int forward);
 	
 	inline float GetAngle() { return _angle; }
+	inline float GetZoom() const { return _zoom; }
+	inline DirectX::XMVECTOR GetTarget() const { return _target; }
+	inline DirectX::XMVECTOR GetForward() const { return _forward; }
 	inline void SetTarget(DirectX::FXMVECTOR target) { _target = target; }
+	void SetView(DirectX::FXMVECTOR target, DirectX::FXMVECTOR forward, float zoom);
 	inline void SetAspectRatio(float aspectRatio) { _aspectRatio = aspectRatio; }
 
 	DirectX::XMMATRIX GetProjectionMatrix() const;
 	DirectX::XMVECTOR GetPosition() const;
+	// Where the ray through a pixel of a width x height viewport hits the ground plane y = 0, as (x, z)
+	std::optional<DirectX::XMFLOAT2> ScreenToGround(float x, float y, float width, float height) const;
+	// Panning keeps the target on this terrain, nullptr leaves its height alone. ground has to outlive the camera.
+	inline void SetGround(const TGW::Terrain::Heightmap *ground) { _ground = ground; }
   
 private:
 	DirectX::XMVECTOR _target;
@@ -32,5 +59,8 @@ private:
 	float _aspectRatio;
 	int _edgeSize;
 
-	POINT _lastMousePos;
-};
\ No newline at end of file
+	int _lastMouseX;
+	int _lastMouseY;
+
+	const TGW::Terrain::Heightmap *_ground = nullptr;
+};
@@ -0,0 +1,49 @@
+#include "camera.h"
+
+// Most significant bit of SHORT returned by GetAsyncKeyState
+constexpr auto IS_KEY_DOWN_MASK = 0x8000;
+
+CameraMouseInput Camera::HandleMouse(HWND hwnd)
+{
+	CameraMouseInput input;
+	if (GetFocus() != hwnd)
+		return input;
+
+	RECT rect;
+	GetClientRect(hwnd, &rect);
+	POINT cursorPosition;
+	GetCursorPos(&cursorPosition);
+	ScreenToClient(hwnd, &cursorPosition);
+
+	if (GetAsyncKeyState(VK_MBUTTON) & IS_KEY_DOWN_MASK) {
+		input.orbit = static_cast<float>(cursorPosition.x - _lastMouseX);
+		Orbit(*input.orbit);
+	} else {
+		const int width = rect.right - rect.left;
+		const int height = rect.bottom - rect.top;
+
+		int right = 0;
+		if (cursorPosition.x < _edgeSize) {
+			right = -1;
+		} else if (cursorPosition.x > width - _edgeSize) {
+			right = 1;
+		}
+
+		int forward = 0;
+		if (cursorPosition.y < _edgeSize) {
+			forward = 1;
+		} else if (cursorPosition.y > height - _edgeSize) {
+			forward = -1;
+		}
+
+		if (right != 0 || forward != 0) {
+			Pan(right, forward);
+			input.panRight = right;
+			input.panForward = forward;
+		}
+	}
+
+	_lastMouseX = cursorPosition.x;
+	_lastMouseY = cursorPosition.y;
+	return input;
+}
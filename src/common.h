@@ -0,0 +1,24 @@
+// Everything here builds on any platform. Windows and D3D headers live in pch.h, which pulls this in.
+
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cwctype>
+#include <filesystem>
+#include <exception>
+#include <functional>
+#include <unordered_map>
+
+#include "utility.h"
@@ -0,0 +1,415 @@
+#include "batch_cooker.h"
+#include "core/hash.h"
+
+#include <assimp/DefaultIOSystem.h>
+
+#include <fstream>
+#include <set>
+
+using namespace TGW::Cook;
+namespace fs = std::filesystem;
+
+namespace {
+// Same formats the editor offers in its model dialog
+constexpr std::string_view MODEL_EXTENSIONS[] = {".obj", ".fbx", ".gltf", ".glb"};
+
+// Enough for the size fields of any header ReadTextureInfo understands, JPEG can put its metadata first
+constexpr size_t TEXTURE_HEADER_BYTES = 256 * 1024;
+
+enum class Outcome : uint8_t {
+	FAILED,
+	UP_TO_DATE,
+	CACHE_HIT,
+	COOKED,
+};
+
+uint64_t HashCombine(uint64_t seed, uint64_t value)
+{
+	return TGW::Hash::Fnv1a({reinterpret_cast<const char *>(&value), sizeof(value)}, seed);
+}
+
+uint64_t HashCombine(uint64_t seed, std::string_view value) { return TGW::Hash::Fnv1a(value, HashCombine(seed, value.size())); }
+
+std::optional<FileRecord> StatFile(const fs::path &path)
+{
+	std::error_code error;
+	const uint64_t size = fs::file_size(path, error);
+	if (error) {
+		return {};
+	}
+	const auto writeTime = fs::last_write_time(path, error);
+	if (error) {
+		return {};
+	}
+	return FileRecord{.size = size, .writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count())};
+}
+
+std::optional<std::vector<uint8_t>> ReadFileHeader(const fs::path &path, size_t maxBytes)
+{
+	std::ifstream file{path, std::ios::binary};
+	if (!file) {
+		return {};
+	}
+	std::vector<uint8_t> data(maxBytes);
+	file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(maxBytes));
+	data.resize(static_cast<size_t>(file.gcount()));
+	return data;
+}
+
+// Assimp opens the model and every side file (.mtl, .bin, ...) through here, which gives us its dependencies
+class RecordingIOSystem : public Assimp::DefaultIOSystem {
+  public:
+	explicit RecordingIOSystem(std::vector<std::string> &opened) : _opened{opened} {}
+
+	Assimp::IOStream *Open(const char *file, const char *mode = "rb") override
+	{
+		Assimp::IOStream *stream = DefaultIOSystem::Open(file, mode);
+		if (stream) {
+			_opened.emplace_back(file);
+		}
+		return stream;
+	}
+
+  private:
+	std::vector<std::string> &_opened;
+};
+} // namespace
+
+struct BatchCooker::RunState {
+	CookManifest previous;
+
+	// Inputs stat'ed or hashed this run, becomes the file list of the next manifest
+	std::unordered_map<std::string, FileRecord> files;
+	std::mutex filesMutex;
+};
+
+struct BatchCooker::ModelResult {
+	Outcome outcome = Outcome::FAILED;
+	ModelRecord record;
+	std::string error;
+};
+
+struct BatchCooker::TextureResult {
+	Outcome outcome = Outcome::FAILED;
+	uint64_t key = 0;
+	std::string error;
+};
+
+BatchCooker::BatchCooker(const fs::path &contentDir, const fs::path &outputDir, CookSettings settings)
+	: _contentDir{fs::absolute(contentDir).lexically_normal()}, _outputDir{fs::absolute(outputDir).lexically_normal()},
+	  _cache{_outputDir / COOK_CACHE_DIR}, _settings{settings}
+{
+	_settingsHash = HashCombine(Hash::FNV_OFFSET_BASIS, uint64_t{COOK_VERSION});
+	_settingsHash = HashCombine(_settingsHash, uint64_t{COOKED_MODEL_VERSION});
+	_settingsHash = HashCombine(_settingsHash, uint64_t{_settings.importFlags});
+}
+
+void BatchCooker::SetCacheDirectory(const fs::path &directory) { _cache = CookCache{fs::absolute(directory)}; }
+
+bool BatchCooker::IsModelFile(const fs::path &path)
+{
+	const std::string extension = Hash::NormalizePath(path.extension().string());
+	return std::find(std::begin(MODEL_EXTENSIONS), std::end(MODEL_EXTENSIONS), extension) != std::end(MODEL_EXTENSIONS);
+}
+
+CookStats BatchCooker::Run(JobSystem &jobs)
+{
+	const fs::path manifestPath = _cache.GetDirectory() / COOK_MANIFEST_NAME;
+	RunState state;
+	if (!_settings.force) {
+		state.previous = CookManifest::Load(manifestPath);
+	}
+
+	CookStats stats;
+	auto tally = [&stats](Outcome outcome, std::string &error) {
+		switch (outcome) {
+		case Outcome::UP_TO_DATE:
+			stats.upToDate++;
+			break;
+		case Outcome::CACHE_HIT:
+			stats.cacheHits++;
+			break;
+		case Outcome::COOKED:
+			stats.cooked++;
+			break;
+		case Outcome::FAILED:
+			stats.errors.push_back(std::move(error));
+			break;
+		}
+	};
+
+	// Models go wide first, their records tell which textures are needed
+	const std::vector<std::string> models = ScanModels();
+	std::vector<ModelResult> modelResults(models.size());
+	jobs.ParallelFor(static_cast<uint32_t>(models.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			CookModel(state, models[i], modelResults[i]);
+		}
+	});
+
+	std::set<std::string> textureSet;
+	for (const auto &result : modelResults) {
+		textureSet.insert(result.record.textures.begin(), result.record.textures.end());
+	}
+	const std::vector<std::string> textures{textureSet.begin(), textureSet.end()};
+	std::vector<TextureResult> textureResults(textures.size());
+	jobs.ParallelFor(static_cast<uint32_t>(textures.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			CookTexture(state, textures[i], textureResults[i]);
+		}
+	});
+
+	// Failed nodes are left out of the manifest so the next run retries them
+	CookManifest manifest;
+	manifest.files = std::move(state.files);
+	for (size_t i = 0; i < models.size(); i++) {
+		ModelResult &result = modelResults[i];
+		tally(result.outcome, result.error);
+		if (result.outcome != Outcome::FAILED) {
+			manifest.outputs.emplace(models[i] + std::string{COOKED_MODEL_EXTENSION}, result.record.key);
+			manifest.models.emplace(models[i], std::move(result.record));
+		}
+	}
+	for (size_t i = 0; i < textures.size(); i++) {
+		TextureResult &result = textureResults[i];
+		tally(result.outcome, result.error);
+		if (result.outcome != Outcome::FAILED) {
+			manifest.outputs.emplace(textures[i], result.key);
+		}
+	}
+
+	// Regenerated every run, it depends on every texture at once and is cheap next to cooking them
+	std::vector<std::string> cookedTextures;
+	for (size_t i = 0; i < textures.size(); i++) {
+		if (textureResults[i].outcome != Outcome::FAILED) {
+			cookedTextures.push_back(textures[i]);
+		}
+	}
+	const std::vector<TextureBucket> buckets = PlanTextureBuckets(jobs, cookedTextures);
+	if (!WriteFileAtomic(_outputDir / TEXTURE_BUCKETS_NAME, SerializeTextureBuckets(buckets))) {
+		stats.errors.push_back("Failed to write " + std::string{TEXTURE_BUCKETS_NAME});
+	}
+	stats.textureBuckets = static_cast<uint32_t>(buckets.size());
+
+	if (!manifest.Save(manifestPath)) {
+		stats.errors.push_back("Failed to write " + manifestPath.string());
+	}
+
+	stats.models = static_cast<uint32_t>(models.size());
+	stats.textures = static_cast<uint32_t>(textures.size());
+	return stats;
+}
+
+/* Implementation of private functions */
+
+std::vector<std::string> BatchCooker::ScanModels() const
+{
+	std::vector<std::string> models;
+	std::error_code error;
+	for (fs::recursive_directory_iterator it{_contentDir, error}, end; !error && it != end; it.increment(error)) {
+		// Never cook our own output when it lives inside the content directory
+		if (it->is_directory() && it->path() == _outputDir) {
+			it.disable_recursion_pending();
+			continue;
+		}
+		if (it->is_regular_file() && IsModelFile(it->path())) {
+			models.push_back(ToContentPath(it->path()));
+		}
+	}
+	std::sort(models.begin(), models.end());
+	return models;
+}
+
+void BatchCooker::CookModel(RunState &state, const std::string &modelPath, ModelResult &result) const
+{
+	const std::string outputPath = modelPath + std::string{COOKED_MODEL_EXTENSION};
+
+	// Same inputs as last time: either nothing to do, or the output is still in the cache
+	auto previous = state.previous.models.find(modelPath);
+	if (previous != state.previous.models.end()) {
+		const ModelRecord &record = previous->second;
+		if (const auto key = GetModelKey(state, modelPath, record.inputs)) {
+			if (*key == record.key && IsOutputCurrent(state, outputPath, *key)) {
+				result = {.outcome = Outcome::UP_TO_DATE, .record = record, .error = {}};
+				return;
+			}
+			const auto cached = _cache.Load(*key);
+			const auto model = cached ? DeserializeModel(*cached) : std::nullopt;
+			if (model && WriteFileAtomic(_outputDir / outputPath, *cached)) {
+				result.outcome = Outcome::CACHE_HIT;
+				result.record = {.key = *key, .inputs = record.inputs, .textures = GetTexturePaths(modelPath, *model)};
+				return;
+			}
+		}
+	}
+
+	std::vector<std::string> opened;
+	const auto model = ImportModel(_contentDir / modelPath, _settings.importFlags, new RecordingIOSystem{opened});
+	if (!model) {
+		result.error = "Failed to import " + modelPath;
+		return;
+	}
+
+	std::set<std::string> inputs{modelPath};
+	for (const auto &file : opened) {
+		inputs.insert(ToContentPath(file));
+	}
+	result.record.inputs.assign(inputs.begin(), inputs.end());
+
+	const auto key = GetModelKey(state, modelPath, result.record.inputs);
+	if (!key) {
+		result.error = "Inputs of " + modelPath + " changed while cooking";
+		return;
+	}
+
+	const std::vector<uint8_t> data = SerializeModel(*model);
+	if (!_cache.Store(*key, data) || !WriteFileAtomic(_outputDir / outputPath, data)) {
+		result.error = "Failed to write " + outputPath;
+		return;
+	}
+
+	result.outcome = Outcome::COOKED;
+	result.record.key = *key;
+	result.record.textures = GetTexturePaths(modelPath, *model);
+}
+
+void BatchCooker::CookTexture(RunState &state, const std::string &texturePath, TextureResult &result) const
+{
+	// Its output path would point back at the source
+	if (fs::path{texturePath}.is_absolute()) {
+		result.error = "Texture outside the content directory " + texturePath;
+		return;
+	}
+
+	const auto hash = HashInput(state, texturePath);
+	if (!hash) {
+		result.error = "Missing texture " + texturePath;
+		return;
+	}
+
+	// Textures are keyed on content alone, identical files share one cache entry
+	result.key = HashCombine(HashCombine(_settingsHash, "texture"), *hash);
+	if (IsOutputCurrent(state, texturePath, result.key)) {
+		result.outcome = Outcome::UP_TO_DATE;
+		return;
+	}
+
+	if (const auto cached = _settings.force ? std::nullopt : _cache.Load(result.key)) {
+		if (WriteFileAtomic(_outputDir / texturePath, *cached)) {
+			result.outcome = Outcome::CACHE_HIT;
+			return;
+		}
+	}
+
+	// Textures are copied as they are for now. Block compression will slot in here, which is why they already go
+	// through the cache.
+	const auto data = ReadWholeFile(_contentDir / texturePath);
+	if (!data) {
+		result.error = "Failed to read " + texturePath;
+		return;
+	}
+	if (!_cache.Store(result.key, *data) || !WriteFileAtomic(_outputDir / texturePath, *data)) {
+		result.error = "Failed to write " + texturePath;
+		return;
+	}
+	result.outcome = Outcome::COOKED;
+}
+
+std::optional<uint64_t> BatchCooker::HashInput(RunState &state, const std::string &path) const
+{
+	auto stat = StatFile(_contentDir / path);
+	if (!stat) {
+		return {};
+	}
+
+	// Unchanged size and write time, trust the hash from last time and skip reading the file
+	auto previous = state.previous.files.find(path);
+	if (previous != state.previous.files.end() && previous->second.size == stat->size &&
+		previous->second.writeTime == stat->writeTime) {
+		stat->hash = previous->second.hash;
+	} else {
+		const auto data = ReadWholeFile(_contentDir / path);
+		if (!data) {
+			return {};
+		}
+		stat->hash = Hash::Fnv1a({reinterpret_cast<const char *>(data->data()), data->size()});
+	}
+
+	std::lock_guard lock{state.filesMutex};
+	state.files[path] = *stat;
+	return stat->hash;
+}
+
+std::optional<uint64_t>
+BatchCooker::GetModelKey(RunState &state, const std::string &modelPath, const std::vector<std::string> &inputs) const
+{
+	// Inputs enter the key relative to the model, so a moved or copied model folder still hits the cache
+	const fs::path modelDir = fs::path{modelPath}.parent_path();
+	uint64_t key = HashCombine(_settingsHash, "model");
+	for (const auto &input : inputs) {
+		const auto hash = HashInput(state, input);
+		if (!hash) {
+			return {};
+		}
+		key = HashCombine(key, fs::path{input}.lexically_relative(modelDir).generic_string());
+		key = HashCombine(key, *hash);
+	}
+	return key;
+}
+
+std::vector<std::string> BatchCooker::GetTexturePaths(const std::string &modelPath, const CookedModel &model) const
+{
+	const fs::path modelDir = _contentDir / fs::path{modelPath}.parent_path();
+	std::set<std::string> textures;
+	for (const auto &material : model.materials) {
+		for (std::string texture : material.textures) {
+			if (texture.empty() || IsEmbeddedTexturePath(texture)) {
+				continue;
+			}
+			// Material files written on Windows use backslashes
+			std::replace(texture.begin(), texture.end(), '\\', '/');
+			textures.insert(ToContentPath(modelDir / texture));
+		}
+	}
+	return {textures.begin(), textures.end()};
+}
+
+std::vector<TextureBucket> BatchCooker::PlanTextureBuckets(JobSystem &jobs, const std::vector<std::string> &textures) const
+{
+	std::vector<std::optional<TextureInfo>> infos(textures.size());
+	jobs.ParallelFor(static_cast<uint32_t>(textures.size()), 8, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (const auto header = ReadFileHeader(_outputDir / textures[i], TEXTURE_HEADER_BYTES)) {
+				infos[i] = ReadTextureInfo(*header);
+			}
+		}
+	});
+
+	// Textures arrive sorted, so the same content always produces the same slices. Ones the editor cannot place
+	// are left out and fall back to their own texture.
+	MaterialTable table;
+	for (size_t i = 0; i < textures.size(); i++) {
+		if (infos[i]) {
+			table.AddTexture(textures[i], *infos[i]);
+		}
+	}
+	return {table.GetBuckets().begin(), table.GetBuckets().end()};
+}
+
+bool BatchCooker::IsOutputCurrent(const RunState &state, const std::string &outputPath, uint64_t key) const
+{
+	auto output = state.previous.outputs.find(outputPath);
+	std::error_code error;
+	return output != state.previous.outputs.end() && output->second == key && fs::exists(_outputDir / outputPath, error);
+}
+
+std::string BatchCooker::ToContentPath(const fs::path &path) const
+{
+	// Files outside the content directory keep their absolute path
+	const fs::path normal = fs::absolute(path).lexically_normal();
+	const fs::path relative = normal.lexically_relative(_contentDir);
+	if (relative.empty() || *relative.begin() == "..") {
+		return normal.generic_string();
+	}
+	return relative.generic_string();
+}
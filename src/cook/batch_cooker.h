@@ -0,0 +1,72 @@
+#pragma once
+
+#include "cook_cache.h"
+#include "core/job_system.h"
+#include "cooked_model.h"
+#include "texture_buckets.h"
+
+namespace TGW::Cook {
+
+// Bump when the cook output changes in a way the inputs do not capture, it invalidates the whole cache
+constexpr uint32_t COOK_VERSION = 1;
+constexpr std::string_view COOK_CACHE_DIR = ".cook_cache";
+constexpr std::string_view COOK_MANIFEST_NAME = "manifest.bin";
+
+struct CookSettings {
+	uint32_t importFlags = MODEL_IMPORT_FLAGS;
+	// Ignores the manifest and the cache and cooks everything again
+	bool force = false;
+};
+
+struct CookStats {
+	uint32_t models = 0;
+	uint32_t textures = 0;
+	// Produced from scratch this run
+	uint32_t cooked = 0;
+	// Stale outputs restored from the cache without cooking them
+	uint32_t cacheHits = 0;
+	uint32_t upToDate = 0;
+	// Texture2DArrays the cooked textures were grouped into, see TEXTURE_BUCKETS_NAME
+	uint32_t textureBuckets = 0;
+	std::vector<std::string> errors;
+};
+
+// Cooks every model under a content directory, plus the textures their materials reference, into an output
+// directory with the same layout. The dependency graph is model -> files the importer read (materials, buffers)
+// -> textures. Only outputs whose inputs or settings changed are rebuilt, in parallel. Last, the cooked textures
+// are grouped into the buckets the editor packs into texture arrays.
+class BatchCooker {
+  public:
+	BatchCooker(const std::filesystem::path &contentDir, const std::filesystem::path &outputDir, CookSettings settings = {});
+
+	// Defaults to .cook_cache inside the output directory
+	void SetCacheDirectory(const std::filesystem::path &directory);
+	CookStats Run(JobSystem &jobs = JobSystem::Get());
+
+	static bool IsModelFile(const std::filesystem::path &path);
+
+  private:
+	struct RunState;
+	struct ModelResult;
+	struct TextureResult;
+
+	std::vector<std::string> ScanModels() const;
+	void CookModel(RunState &state, const std::string &modelPath, ModelResult &result) const;
+	void CookTexture(RunState &state, const std::string &texturePath, TextureResult &result) const;
+
+	std::optional<uint64_t> HashInput(RunState &state, const std::string &path) const;
+	std::optional<uint64_t>
+	GetModelKey(RunState &state, const std::string &modelPath, const std::vector<std::string> &inputs) const;
+	std::vector<std::string> GetTexturePaths(const std::string &modelPath, const CookedModel &model) const;
+	std::vector<TextureBucket> PlanTextureBuckets(JobSystem &jobs, const std::vector<std::string> &textures) const;
+	bool IsOutputCurrent(const RunState &state, const std::string &outputPath, uint64_t key) const;
+	std::string ToContentPath(const std::filesystem::path &path) const;
+
+	std::filesystem::path _contentDir;
+	std::filesystem::path _outputDir;
+	CookCache _cache;
+	CookSettings _settings;
+	uint64_t _settingsHash;
+};
+
+} // namespace TGW::Cook
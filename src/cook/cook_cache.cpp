@@ -0,0 +1,179 @@
+#include "cook_cache.h"
+#include "core/binary_stream.h"
+
+#include <atomic>
+#include <fstream>
+
+using namespace TGW::Cook;
+
+namespace {
+void WriteStrings(TGW::BinaryWriter &writer, const std::vector<std::string> &values)
+{
+	writer.Write(static_cast<uint32_t>(values.size()));
+	for (const auto &value : values) {
+		writer.WriteString(value);
+	}
+}
+
+bool ReadStrings(TGW::BinaryReader &reader, std::vector<std::string> &values)
+{
+	uint32_t count = 0;
+	if (!reader.Read(count) || count > reader.GetRemaining() / sizeof(uint32_t)) {
+		return false;
+	}
+	values.resize(count);
+	for (auto &value : values) {
+		reader.ReadString(value);
+	}
+	return !reader.HasFailed();
+}
+} // namespace
+
+/* CookManifest */
+
+CookManifest CookManifest::Load(const std::filesystem::path &path)
+{
+	const auto data = ReadWholeFile(path);
+	if (!data) {
+		return {};
+	}
+
+	BinaryReader reader{*data};
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	if (!reader.Read(magic) || !reader.Read(version) || magic != COOK_MANIFEST_MAGIC || version != COOK_MANIFEST_VERSION) {
+		return {};
+	}
+
+	CookManifest manifest;
+	uint32_t fileCount = 0;
+	reader.Read(fileCount);
+	for (uint32_t i = 0; i < fileCount && !reader.HasFailed(); i++) {
+		std::string path;
+		FileRecord record;
+		reader.ReadString(path);
+		reader.Read(record.size);
+		reader.Read(record.writeTime);
+		reader.Read(record.hash);
+		manifest.files.emplace(std::move(path), record);
+	}
+
+	uint32_t modelCount = 0;
+	reader.Read(modelCount);
+	for (uint32_t i = 0; i < modelCount && !reader.HasFailed(); i++) {
+		std::string path;
+		ModelRecord record;
+		reader.ReadString(path);
+		reader.Read(record.key);
+		if (!ReadStrings(reader, record.inputs) || !ReadStrings(reader, record.textures)) {
+			break;
+		}
+		manifest.models.emplace(std::move(path), std::move(record));
+	}
+
+	uint32_t outputCount = 0;
+	reader.Read(outputCount);
+	for (uint32_t i = 0; i < outputCount && !reader.HasFailed(); i++) {
+		std::string path;
+		uint64_t key = 0;
+		reader.ReadString(path);
+		reader.Read(key);
+		manifest.outputs.emplace(std::move(path), key);
+	}
+
+	if (reader.HasFailed() || reader.GetRemaining() != 0) {
+		return {};
+	}
+	return manifest;
+}
+
+bool CookManifest::Save(const std::filesystem::path &path) const
+{
+	BinaryWriter writer;
+	writer.Write(COOK_MANIFEST_MAGIC);
+	writer.Write(COOK_MANIFEST_VERSION);
+
+	writer.Write(static_cast<uint32_t>(files.size()));
+	for (const auto &[filePath, record] : files) {
+		writer.WriteString(filePath);
+		writer.Write(record.size);
+		writer.Write(record.writeTime);
+		writer.Write(record.hash);
+	}
+
+	writer.Write(static_cast<uint32_t>(models.size()));
+	for (const auto &[modelPath, record] : models) {
+		writer.WriteString(modelPath);
+		writer.Write(record.key);
+		WriteStrings(writer, record.inputs);
+		WriteStrings(writer, record.textures);
+	}
+
+	writer.Write(static_cast<uint32_t>(outputs.size()));
+	for (const auto &[outputPath, key] : outputs) {
+		writer.WriteString(outputPath);
+		writer.Write(key);
+	}
+
+	return WriteFileAtomic(path, writer.GetBuffer());
+}
+
+/* CookCache */
+
+std::optional<std::vector<uint8_t>> CookCache::Load(uint64_t key) const { return ReadWholeFile(GetObjectPath(key)); }
+
+bool CookCache::Store(uint64_t key, std::span<const uint8_t> data) const
+{
+	return WriteFileAtomic(GetObjectPath(key), data);
+}
+
+std::filesystem::path CookCache::GetObjectPath(uint64_t key) const
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	// Two level fan out keeps directories small with tens of thousands of objects
+	return _directory / "objects" / std::string_view{name, 2} / name;
+}
+
+/* Files */
+
+std::optional<std::vector<uint8_t>> TGW::Cook::ReadWholeFile(const std::filesystem::path &path)
+{
+	std::ifstream file{path, std::ios::binary | std::ios::ate};
+	if (!file) {
+		return {};
+	}
+
+	std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char *>(data.data()), data.size())) {
+		return {};
+	}
+	return data;
+}
+
+bool TGW::Cook::WriteFileAtomic(const std::filesystem::path &path, std::span<const uint8_t> data)
+{
+	static std::atomic<uint32_t> tempCounter = 0;
+
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp" + std::to_string(tempCounter++);
+	{
+		std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+		if (!file.write(reinterpret_cast<const char *>(data.data()), data.size())) {
+			file.close();
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common.h"
+
+#include <span>
+
+namespace TGW::Cook {
+
+constexpr uint32_t COOK_MANIFEST_MAGIC = 0x4B434853; // "SHCK"
+constexpr uint32_t COOK_MANIFEST_VERSION = 1;
+
+// What a file looked like the last time its contents were hashed. Same size and write time means same hash.
+struct FileRecord {
+	uint64_t size = 0;
+	int64_t writeTime = 0;
+	uint64_t hash = 0;
+};
+
+struct ModelRecord {
+	// Cache key of the cooked model
+	uint64_t key = 0;
+	// Every file the importer opened, the model itself included. Relative to the content dir.
+	std::vector<std::string> inputs;
+	// Referenced texture files, relative to the content dir
+	std::vector<std::string> textures;
+};
+
+// State of the previous cook, kept next to the cache. Paths are relative with forward slashes.
+struct CookManifest {
+	std::unordered_map<std::string, FileRecord> files;
+	std::unordered_map<std::string, ModelRecord> models;
+	// Output path -> key of what was last written there
+	std::unordered_map<std::string, uint64_t> outputs;
+
+	// A missing or unreadable manifest loads as empty, which just means a full cook
+	static CookManifest Load(const std::filesystem::path &path);
+	bool Save(const std::filesystem::path &path) const;
+};
+
+// Content addressed store of cooked outputs. The key covers the inputs and the cook settings, so different
+// content directories or reverted changes share the entries.
+class CookCache {
+  public:
+	explicit CookCache(std::filesystem::path directory) : _directory{std::move(directory)} {}
+
+	std::optional<std::vector<uint8_t>> Load(uint64_t key) const;
+	// Safe to call for the same key from several threads
+	bool Store(uint64_t key, std::span<const uint8_t> data) const;
+
+	std::filesystem::path GetObjectPath(uint64_t key) const;
+	inline const std::filesystem::path &GetDirectory() const { return _directory; }
+
+  private:
+	std::filesystem::path _directory;
+};
+
+std::optional<std::vector<uint8_t>> ReadWholeFile(const std::filesystem::path &path);
+// Writes to a uniquely named temp file and renames it over path, readers never see a half written file
+bool WriteFileAtomic(const std::filesystem::path &path, std::span<const uint8_t> data);
+
+} // namespace TGW::Cook
@@ -0,0 +1,170 @@
+#include "cooked_model.h"
+#include "core/binary_stream.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+using namespace TGW::Cook;
+
+namespace {
+constexpr size_t FLOATS_PER_VERTEX = sizeof(Vertex) / sizeof(float);
+static_assert(sizeof(Vertex) == FLOATS_PER_VERTEX * sizeof(float));
+
+std::span<const float> AsFloats(const std::vector<Vertex> &vertices)
+{
+	return {reinterpret_cast<const float *>(vertices.data()), vertices.size() * FLOATS_PER_VERTEX};
+}
+
+bool ReadOccluder(TGW::BinaryReader &reader, TGW::Cull::OccluderMesh &occluder)
+{
+	uint32_t positionCount = 0;
+	uint32_t indexCount = 0;
+	reader.ReadArray(std::span<float>{&occluder.boundsMin.x, 3});
+	reader.ReadArray(std::span<float>{&occluder.boundsMax.x, 3});
+	reader.Read(positionCount);
+	reader.Read(indexCount);
+	if (reader.HasFailed() || positionCount > reader.GetRemaining() / sizeof(DirectX::XMFLOAT3)) {
+		return false;
+	}
+	occluder.positions.resize(positionCount);
+	reader.ReadArray(std::span<float>{reinterpret_cast<float *>(occluder.positions.data()), positionCount * 3});
+	reader.ReadArray(occluder.indices, indexCount);
+	if (reader.HasFailed() || indexCount % 3 != 0) {
+		return false;
+	}
+	for (uint32_t index : occluder.indices) {
+		if (index >= positionCount) {
+			return false;
+		}
+	}
+	return true;
+}
+} // namespace
+
+std::optional<CookedModel> TGW::Cook::ImportModel(const std::filesystem::path &path, uint32_t importFlags, Assimp::IOSystem *io)
+{
+	Assimp::Importer importer;
+	if (io) {
+		importer.SetIOHandler(io);
+	}
+	const aiScene *scene = importer.ReadFile(path.string(), importFlags);
+	if (!scene || !scene->HasMeshes()) {
+		return {};
+	}
+
+	CookedModel model;
+	const aiMatrix4x4 &root = scene->mRootNode->mTransformation;
+	model.rootTransform = {root.a1, root.a2, root.a3, root.a4, root.b1, root.b2, root.b3, root.b4,
+						   root.c1, root.c2, root.c3, root.c4, root.d1, root.d2, root.d3, root.d4};
+	for (uint32_t i = 0; i < scene->mNumMaterials; i++) {
+		model.materials.push_back(BuildMaterialData(scene->mMaterials[i]));
+	}
+	for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
+		model.meshes.push_back(BuildMeshData(scene->mMeshes[i]));
+	}
+	model.occluder = Cull::BuildOccluderMesh(model.meshes);
+	return model;
+}
+
+std::vector<uint8_t> TGW::Cook::SerializeModel(const CookedModel &model)
+{
+	BinaryWriter writer;
+	writer.Write(COOKED_MODEL_MAGIC);
+	writer.Write(COOKED_MODEL_VERSION);
+	writer.WriteArray(std::span<const float>{&model.rootTransform.m[0][0], 16});
+
+	writer.Write(static_cast<uint32_t>(model.materials.size()));
+	for (const auto &material : model.materials) {
+		for (const auto &texture : material.textures) {
+			writer.WriteString(texture);
+		}
+	}
+
+	writer.Write(static_cast<uint32_t>(model.meshes.size()));
+	for (const auto &mesh : model.meshes) {
+		writer.Write(mesh.materialIndex);
+		writer.Write(static_cast<uint32_t>(mesh.vertices.size()));
+		writer.Write(static_cast<uint32_t>(mesh.indices.size()));
+		writer.WriteArray(AsFloats(mesh.vertices));
+		writer.WriteArray(std::span<const uint32_t>{mesh.indices});
+	}
+
+	const Cull::OccluderMesh &occluder = model.occluder;
+	writer.WriteArray(std::span<const float>{&occluder.boundsMin.x, 3});
+	writer.WriteArray(std::span<const float>{&occluder.boundsMax.x, 3});
+	writer.Write(static_cast<uint32_t>(occluder.positions.size()));
+	writer.Write(static_cast<uint32_t>(occluder.indices.size()));
+	const float *positions = reinterpret_cast<const float *>(occluder.positions.data());
+	writer.WriteArray(std::span<const float>{positions, occluder.positions.size() * 3});
+	writer.WriteArray(std::span<const uint32_t>{occluder.indices});
+
+	return writer.TakeBuffer();
+}
+
+std::optional<CookedModel> TGW::Cook::DeserializeModel(std::span<const uint8_t> data)
+{
+	BinaryReader reader{data};
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	if (!reader.Read(magic) || !reader.Read(version) || magic != COOKED_MODEL_MAGIC || version == 0 ||
+		version > COOKED_MODEL_VERSION) {
+		return {};
+	}
+
+	CookedModel model;
+	reader.ReadArray(std::span<float>{&model.rootTransform.m[0][0], 16});
+
+	uint32_t materialCount = 0;
+	reader.Read(materialCount);
+	// Each material costs at least the length prefixes of its paths
+	if (materialCount > reader.GetRemaining() / (TEXTURE_SLOT_COUNT * sizeof(uint32_t))) {
+		return {};
+	}
+	model.materials.resize(materialCount);
+	for (auto &material : model.materials) {
+		for (auto &texture : material.textures) {
+			reader.ReadString(texture);
+		}
+	}
+
+	uint32_t meshCount = 0;
+	reader.Read(meshCount);
+	if (reader.HasFailed() || meshCount > reader.GetRemaining() / (3 * sizeof(uint32_t))) {
+		return {};
+	}
+	model.meshes.resize(meshCount);
+	for (auto &mesh : model.meshes) {
+		uint32_t vertexCount = 0;
+		uint32_t indexCount = 0;
+		reader.Read(mesh.materialIndex);
+		reader.Read(vertexCount);
+		reader.Read(indexCount);
+		if (reader.HasFailed() || vertexCount > reader.GetRemaining() / sizeof(Vertex)) {
+			return {};
+		}
+		mesh.vertices.resize(vertexCount);
+		reader.ReadArray(std::span<float>{reinterpret_cast<float *>(mesh.vertices.data()), vertexCount * FLOATS_PER_VERTEX});
+		reader.ReadArray(mesh.indices, indexCount);
+		if (reader.HasFailed() || (materialCount > 0 && mesh.materialIndex >= materialCount)) {
+			return {};
+		}
+		for (uint32_t index : mesh.indices) {
+			if (index >= vertexCount) {
+				return {};
+			}
+		}
+	}
+
+	if (version >= 2 && !ReadOccluder(reader, model.occluder)) {
+		return {};
+	}
+	// Occluders cooked before 3 could bridge the notch of a concave model
+	if (version < 3) {
+		model.occluder = Cull::BuildOccluderMesh(model.meshes);
+	}
+
+	if (reader.HasFailed() || reader.GetRemaining() != 0) {
+		return {};
+	}
+	return model;
+}
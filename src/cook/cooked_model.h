@@ -0,0 +1,36 @@
+#pragma once
+
+#include "cull/occluder_mesh.h"
+#include "mesh_data.h"
+
+#include <span>
+
+namespace Assimp {
+class IOSystem;
+}
+
+namespace TGW::Cook {
+
+constexpr uint32_t COOKED_MODEL_MAGIC = 0x4C444D53; // "SMDL"
+// 2 added the occluder mesh, 3 keeps clustered occluders to closed convex models
+constexpr uint32_t COOKED_MODEL_VERSION = 3;
+constexpr std::string_view COOKED_MODEL_EXTENSION = ".shmodel";
+
+// Everything the editor pulls out of a model file, without the GPU objects
+struct CookedModel {
+	DirectX::XMFLOAT4X4 rootTransform{};
+	std::vector<MeshData> meshes;
+	std::vector<MaterialData> materials;
+	Cull::OccluderMesh occluder;
+};
+
+// Same import as AssetLoader::LoadModel. The importer takes ownership of io when given one.
+std::optional<CookedModel>
+ImportModel(const std::filesystem::path &path, uint32_t importFlags = MODEL_IMPORT_FLAGS, Assimp::IOSystem *io = nullptr);
+
+std::vector<uint8_t> SerializeModel(const CookedModel &model);
+// Rejects wrong magic, newer versions, truncated data and indices past the vertex or material arrays. Version 1
+// files get their occluder built on load.
+std::optional<CookedModel> DeserializeModel(std::span<const uint8_t> data);
+
+} // namespace TGW::Cook
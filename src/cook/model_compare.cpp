@@ -0,0 +1,111 @@
+#include "model_compare.h"
+#include "gltf/gltf_loader.h"
+#include "obj/obj_loader.h"
+
+using namespace TGW::Cook;
+
+namespace {
+constexpr float EPSILON = 1e-4f;
+
+std::optional<std::string> CompareMesh(const MeshData &native, const MeshData &assimp)
+{
+	// Vertex is plain floats, compare it as such
+	auto near = [](const Vertex &a, const Vertex &b) {
+		const float *fa = &a.position.x;
+		const float *fb = &b.position.x;
+		for (size_t i = 0; i < sizeof(Vertex) / sizeof(float); i++) {
+			if (std::abs(fa[i] - fb[i]) > EPSILON) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	if (native.materialIndex != assimp.materialIndex) {
+		return "material index " + std::to_string(native.materialIndex) + " vs " + std::to_string(assimp.materialIndex);
+	}
+	if (native.indices.size() != assimp.indices.size()) {
+		return "index count " + std::to_string(native.indices.size()) + " vs " + std::to_string(assimp.indices.size());
+	}
+	for (size_t i = 0; i < native.indices.size(); i++) {
+		if (native.indices[i] >= native.vertices.size() || assimp.indices[i] >= assimp.vertices.size()) {
+			return "corner " + std::to_string(i) + " indexes past the vertices";
+		}
+		if (!near(native.vertices[native.indices[i]], assimp.vertices[assimp.indices[i]])) {
+			return "corner " + std::to_string(i) + " differs";
+		}
+	}
+	return {};
+}
+} // namespace
+
+/* Implementation of public functions */
+
+std::vector<std::string> TGW::Cook::CompareModels(const CookedModel &native, const CookedModel &assimp)
+{
+	std::vector<std::string> differences;
+	if (native.meshes.size() != assimp.meshes.size()) {
+		differences.push_back(
+			"mesh count " + std::to_string(native.meshes.size()) + " vs " + std::to_string(assimp.meshes.size()));
+	}
+	for (size_t i = 0; i < std::min(native.meshes.size(), assimp.meshes.size()); i++) {
+		if (auto difference = CompareMesh(native.meshes[i], assimp.meshes[i])) {
+			differences.push_back("mesh " + std::to_string(i) + ": " + *difference);
+		}
+	}
+
+	if (native.materials.size() != assimp.materials.size()) {
+		differences.push_back(
+			"material count " + std::to_string(native.materials.size()) + " vs " + std::to_string(assimp.materials.size()));
+	}
+	for (size_t i = 0; i < std::min(native.materials.size(), assimp.materials.size()); i++) {
+		for (uint32_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++) {
+			const std::string &a = native.materials[i].textures[slot];
+			const std::string &b = assimp.materials[i].textures[slot];
+			if (a != b) {
+				differences.push_back(
+					"material " + std::to_string(i) + " slot " + std::to_string(slot) + ": \"" + a + "\" vs \"" + b + "\"");
+			}
+		}
+	}
+
+	for (int r = 0; r < 4; r++) {
+		for (int c = 0; c < 4; c++) {
+			if (std::abs(native.rootTransform.m[r][c] - assimp.rootTransform.m[r][c]) > EPSILON) {
+				differences.push_back("root transform differs");
+				r = c = 4;
+			}
+		}
+	}
+	return differences;
+}
+
+std::optional<CookedModel> TGW::Cook::LoadGltfModel(const std::filesystem::path &path)
+{
+	std::optional<Gltf::GltfModel> gltf = Gltf::Load(path);
+	if (!gltf) {
+		return {};
+	}
+	return CookedModel{
+	  .rootTransform = gltf->rootTransform,
+	  .meshes = std::move(gltf->meshes),
+	  .materials = std::move(gltf->materials),
+	  .occluder = {},
+	};
+}
+
+std::optional<CookedModel> TGW::Cook::LoadObjModel(const std::filesystem::path &path)
+{
+	std::optional<Obj::ObjModel> obj = Obj::Load(path);
+	if (!obj) {
+		return {};
+	}
+	CookedModel model{
+	  .rootTransform = {},
+	  .meshes = std::move(obj->meshes),
+	  .materials = std::move(obj->materials),
+	  .occluder = {},
+	};
+	DirectX::XMStoreFloat4x4(&model.rootTransform, DirectX::XMMatrixIdentity());
+	return model;
+}
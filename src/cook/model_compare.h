@@ -0,0 +1,17 @@
+#pragma once
+
+#include "cooked_model.h"
+
+namespace TGW::Cook {
+
+// Every way a natively loaded model differs from what ImportModel made of the same file: mesh and triangle counts,
+// vertex attributes, materials and root transform. Empty when they match. Assimp may weld or reorder vertices, so
+// meshes are compared corner by corner through their indices.
+std::vector<std::string> CompareModels(const CookedModel &native, const CookedModel &assimp);
+
+// The native glTF loader's result in the shape ImportModel returns, nothing for files it leaves to Assimp
+std::optional<CookedModel> LoadGltfModel(const std::filesystem::path &path);
+// The same for the native OBJ loader. OBJ has no node hierarchy, the root transform is identity.
+std::optional<CookedModel> LoadObjModel(const std::filesystem::path &path);
+
+} // namespace TGW::Cook
@@ -0,0 +1,363 @@
+#include "texture_buckets.h"
+#include "core/binary_stream.h"
+#include "core/hash.h"
+
+#include <bit>
+
+using namespace TGW::Cook;
+
+namespace {
+constexpr uint8_t PNG_SIGNATURE[] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+constexpr size_t DDS_HEADER_SIZE = 128; // magic and DDS_HEADER
+constexpr size_t DDS_DX10_HEADER_SIZE = 20;
+constexpr uint32_t DDS_PIXEL_FORMAT_FOURCC = 0x4;
+constexpr uint32_t DDS_PIXEL_FORMAT_RGB = 0x40;
+constexpr uint32_t DDS_CAPS2_CUBEMAP = 0x200;
+constexpr uint32_t DDS_CAPS2_VOLUME = 0x200000;
+
+// DXGI_FORMAT values, spelled out since the cook builds without D3D
+constexpr uint32_t DXGI_RGBA8_UNORM = 28;
+constexpr uint32_t DXGI_RGBA8_UNORM_SRGB = 29;
+constexpr uint32_t DXGI_BC1_UNORM = 71;
+constexpr uint32_t DXGI_BC1_UNORM_SRGB = 72;
+constexpr uint32_t DXGI_BC3_UNORM = 77;
+constexpr uint32_t DXGI_BC3_UNORM_SRGB = 78;
+constexpr uint32_t DXGI_BC5_UNORM = 83;
+constexpr uint32_t DXGI_BC7_UNORM = 98;
+constexpr uint32_t DXGI_BC7_UNORM_SRGB = 99;
+
+constexpr uint32_t FourCC(const char (&code)[5])
+{
+	return static_cast<uint32_t>(code[0]) | code[1] << 8 | code[2] << 16 | static_cast<uint32_t>(code[3]) << 24;
+}
+
+inline uint32_t ReadBigEndian16(std::span<const uint8_t> data, size_t offset) { return data[offset] << 8 | data[offset + 1]; }
+
+inline uint32_t ReadBigEndian32(std::span<const uint8_t> data, size_t offset)
+{
+	return static_cast<uint32_t>(data[offset]) << 24 | data[offset + 1] << 16 | data[offset + 2] << 8 | data[offset + 3];
+}
+
+inline uint32_t ReadLittleEndian32(std::span<const uint8_t> data, size_t offset)
+{
+	return data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 | static_cast<uint32_t>(data[offset + 3]) << 24;
+}
+
+std::optional<TextureInfo> ReadPngInfo(std::span<const uint8_t> data)
+{
+	// The IHDR chunk always comes first: length, type, width, height
+	constexpr std::string_view HEADER_CHUNK = "IHDR";
+	if (data.size() < 24 || !std::equal(HEADER_CHUNK.begin(), HEADER_CHUNK.end(), data.begin() + 12)) {
+		return {};
+	}
+	return TextureInfo{
+	  .width = ReadBigEndian32(data, 16), .height = ReadBigEndian32(data, 20), .format = TEXTURE_FORMAT_RGBA8, .resizable = true};
+}
+
+std::optional<TextureInfo> ReadJpegInfo(std::span<const uint8_t> data)
+{
+	// Walks the segments up to the first start of frame, which holds the size
+	size_t offset = 2;
+	while (offset + 4 <= data.size()) {
+		if (data[offset] != 0xFF) {
+			return {};
+		}
+		const uint8_t marker = data[offset + 1];
+		if (marker == 0xFF) {
+			offset++; // fill byte
+			continue;
+		}
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD9)) {
+			offset += 2; // markers without a length
+			continue;
+		}
+		const uint32_t length = ReadBigEndian16(data, offset + 2);
+		const bool isFrame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+		if (isFrame) {
+			if (offset + 9 > data.size()) {
+				return {};
+			}
+			return TextureInfo{.width = ReadBigEndian16(data, offset + 7),
+			  .height = ReadBigEndian16(data, offset + 5),
+			  .format = TEXTURE_FORMAT_RGBA8,
+			  .resizable = true};
+		}
+		offset += 2 + length;
+	}
+	return {};
+}
+
+std::optional<TextureInfo> ReadBmpInfo(std::span<const uint8_t> data)
+{
+	if (data.size() < 26) {
+		return {};
+	}
+	// BITMAPCOREHEADER has 16 bit sizes, every later header 32 bit ones with the height negative for top down rows
+	if (ReadLittleEndian32(data, 14) == 12) {
+		return TextureInfo{.width = static_cast<uint32_t>(data[18] | data[19] << 8),
+		  .height = static_cast<uint32_t>(data[20] | data[21] << 8),
+		  .format = TEXTURE_FORMAT_RGBA8,
+		  .resizable = true};
+	}
+	const int64_t height = static_cast<int32_t>(ReadLittleEndian32(data, 22));
+	return TextureInfo{.width = ReadLittleEndian32(data, 18),
+	  .height = static_cast<uint32_t>(height < 0 ? -height : height),
+	  .format = TEXTURE_FORMAT_RGBA8,
+	  .resizable = true};
+}
+
+TextureFormat GetDxgiFormat(uint32_t format)
+{
+	switch (format) {
+	case DXGI_RGBA8_UNORM:
+	case DXGI_RGBA8_UNORM_SRGB:
+		return TEXTURE_FORMAT_RGBA8;
+	case DXGI_BC1_UNORM:
+	case DXGI_BC1_UNORM_SRGB:
+		return TEXTURE_FORMAT_BC1;
+	case DXGI_BC3_UNORM:
+	case DXGI_BC3_UNORM_SRGB:
+		return TEXTURE_FORMAT_BC3;
+	case DXGI_BC5_UNORM:
+		return TEXTURE_FORMAT_BC5;
+	case DXGI_BC7_UNORM:
+	case DXGI_BC7_UNORM_SRGB:
+		return TEXTURE_FORMAT_BC7;
+	default:
+		return TEXTURE_FORMAT_UNKNOWN;
+	}
+}
+
+std::optional<TextureInfo> ReadDdsInfo(std::span<const uint8_t> data)
+{
+	if (data.size() < DDS_HEADER_SIZE || ReadLittleEndian32(data, 4) != 124) {
+		return {};
+	}
+	TextureInfo info{.width = ReadLittleEndian32(data, 16), .height = ReadLittleEndian32(data, 12)};
+	info.mipLevels = std::max(ReadLittleEndian32(data, 28), 1u);
+	// Cube maps and volumes do not fit in an array slice
+	if (ReadLittleEndian32(data, 112) & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME)) {
+		return info;
+	}
+
+	const uint32_t flags = ReadLittleEndian32(data, 80);
+	const uint32_t fourCC = ReadLittleEndian32(data, 84);
+	if (flags & DDS_PIXEL_FORMAT_FOURCC) {
+		if (fourCC == FourCC("DX10")) {
+			if (data.size() < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE) {
+				return {};
+			}
+			if (ReadLittleEndian32(data, DDS_HEADER_SIZE + 12) <= 1) {
+				info.format = GetDxgiFormat(ReadLittleEndian32(data, DDS_HEADER_SIZE));
+			}
+		} else if (fourCC == FourCC("DXT1")) {
+			info.format = TEXTURE_FORMAT_BC1;
+		} else if (fourCC == FourCC("DXT4") || fourCC == FourCC("DXT5")) {
+			info.format = TEXTURE_FORMAT_BC3;
+		} else if (fourCC == FourCC("ATI2") || fourCC == FourCC("BC5U")) {
+			info.format = TEXTURE_FORMAT_BC5;
+		}
+	} else if ((flags & DDS_PIXEL_FORMAT_RGB) && ReadLittleEndian32(data, 88) == 32 && ReadLittleEndian32(data, 92) == 0xFF &&
+			   ReadLittleEndian32(data, 96) == 0xFF00 && ReadLittleEndian32(data, 100) == 0xFF0000) {
+		info.format = TEXTURE_FORMAT_RGBA8;
+	}
+	return info;
+}
+} // namespace
+
+/* Implementation of public functions */
+
+std::optional<TextureInfo> TGW::Cook::ReadTextureInfo(std::span<const uint8_t> data)
+{
+	std::optional<TextureInfo> info;
+	if (data.size() >= sizeof(PNG_SIGNATURE) && std::equal(std::begin(PNG_SIGNATURE), std::end(PNG_SIGNATURE), data.begin())) {
+		info = ReadPngInfo(data);
+	} else if (data.size() >= 2 && data[0] == 0xFF && data[1] == 0xD8) {
+		info = ReadJpegInfo(data);
+	} else if (data.size() >= 2 && data[0] == 'B' && data[1] == 'M') {
+		info = ReadBmpInfo(data);
+	} else if (data.size() >= 4 && ReadLittleEndian32(data, 0) == FourCC("DDS ")) {
+		info = ReadDdsInfo(data);
+	}
+	if (!info || info->width == 0 || info->height == 0) {
+		return {};
+	}
+	return info;
+}
+
+TextureBucketKey TGW::Cook::GetBucketKey(const TextureInfo &info, const TextureBucketSettings &settings)
+{
+	if (info.format != TEXTURE_FORMAT_RGBA8 || !info.resizable) {
+		return {.format = info.format, .width = info.width, .height = info.height, .mipLevels = info.mipLevels};
+	}
+	// Nearest in scale: the next power of two up once the side is past the geometric mean of the two
+	const uint32_t side = std::max(info.width, info.height);
+	uint32_t size = std::bit_floor(side);
+	if (uint64_t{side} * side > 2 * uint64_t{size} * size) {
+		size *= 2;
+	}
+	const uint32_t low = std::bit_ceil(std::max(settings.minSize, 1u));
+	size = std::clamp(size, low, std::max(std::bit_floor(settings.maxSize), low));
+	return {
+	  .format = TEXTURE_FORMAT_RGBA8, .width = size, .height = size, .mipLevels = static_cast<uint32_t>(std::bit_width(size))};
+}
+
+/* MaterialTable */
+
+uint64_t TGW::Cook::GetSliceBytes(const TextureBucketKey &key)
+{
+	// Block compressed mips round up to whole 4x4 blocks
+	const bool isBlock = key.format != TEXTURE_FORMAT_RGBA8;
+	const uint64_t unitBytes = key.format == TEXTURE_FORMAT_RGBA8 ? 4 : (key.format == TEXTURE_FORMAT_BC1 ? 8 : 16);
+	uint64_t bytes = 0;
+	for (uint32_t mip = 0; mip < key.mipLevels; mip++) {
+		uint64_t width = std::max(key.width >> mip, 1u);
+		uint64_t height = std::max(key.height >> mip, 1u);
+		if (isBlock) {
+			width = (width + 3) / 4;
+			height = (height + 3) / 4;
+		}
+		bytes += width * height * unitBytes;
+	}
+	return bytes;
+}
+
+MaterialTable::MaterialTable(const TextureBucketSettings &settings) : _settings{settings} {}
+
+bool MaterialTable::UsePlan(std::span<const TextureBucket> buckets)
+{
+	if (!_buckets.empty() || !_textures.empty()) {
+		return false;
+	}
+	const size_t bucketCount = std::min<size_t>(buckets.size(), std::min<uint32_t>(_settings.maxBuckets, NO_TEXTURE_BUCKET));
+	for (size_t b = 0; b < bucketCount; b++) {
+		TextureBucket &bucket = _buckets.emplace_back(TextureBucket{.key = buckets[b].key, .textures = {}});
+		for (const std::string &texture : buckets[b].textures) {
+			if (bucket.textures.size() >= _settings.maxSlices) {
+				break;
+			}
+			const TextureRef ref{.bucket = static_cast<uint16_t>(b), .slice = static_cast<uint16_t>(bucket.textures.size())};
+			if (_planned.try_emplace(texture, ref).second) {
+				bucket.textures.push_back(texture);
+			}
+		}
+	}
+	return true;
+}
+
+TextureRef MaterialTable::AddTexture(std::string_view name, const TextureInfo &info)
+{
+	const auto [it, inserted] = _textures.try_emplace(std::string{name});
+	if (!inserted || info.format == TEXTURE_FORMAT_UNKNOWN) {
+		return it->second;
+	}
+
+	// A texture that changed since the cook no longer fits its planned slice and is placed like any other
+	const TextureBucketKey key = GetBucketKey(info, _settings);
+	if (const auto planned = _planned.find(it->first); planned != _planned.end()) {
+		const TextureRef ref = planned->second;
+		_planned.erase(planned);
+		if (_buckets[ref.bucket].key == key) {
+			it->second = ref;
+			return it->second;
+		}
+	}
+
+	// Only the last bucket of a key can have room, earlier ones filled up before it was opened
+	auto bucket = std::find_if(_buckets.rbegin(), _buckets.rend(), [&](const TextureBucket &b) { return b.key == key; });
+	if (bucket == _buckets.rend() || bucket->textures.size() >= _settings.maxSlices) {
+		if (_buckets.size() >= std::min<uint32_t>(_settings.maxBuckets, NO_TEXTURE_BUCKET)) {
+			return it->second;
+		}
+		_buckets.push_back({.key = key, .textures = {}});
+		bucket = _buckets.rbegin();
+	}
+	it->second = {.bucket = static_cast<uint16_t>(std::distance(bucket, _buckets.rend()) - 1),
+		.slice = static_cast<uint16_t>(bucket->textures.size())};
+	bucket->textures.emplace_back(name);
+	return it->second;
+}
+
+std::optional<TextureRef> MaterialTable::FindTexture(std::string_view name) const
+{
+	const auto it = _textures.find(std::string{name});
+	if (it == _textures.end()) {
+		return {};
+	}
+	return it->second;
+}
+
+uint32_t MaterialTable::AddMaterial(const MaterialEntry &material)
+{
+	const auto [it, inserted] = _materialIndices.try_emplace(material, static_cast<uint32_t>(_materials.size()));
+	if (inserted) {
+		_materials.push_back(material);
+	}
+	return it->second;
+}
+
+size_t MaterialTable::MaterialHash::operator()(const MaterialEntry &material) const
+{
+	uint64_t hash = Hash::FNV_OFFSET_BASIS;
+	for (const TextureRef &texture : material.textures) {
+		const uint32_t packed = uint32_t{texture.bucket} << 16 | texture.slice;
+		hash = Hash::Fnv1a({reinterpret_cast<const char *>(&packed), sizeof(packed)}, hash);
+	}
+	return static_cast<size_t>(hash);
+}
+
+/* Serialization */
+
+std::vector<uint8_t> TGW::Cook::SerializeTextureBuckets(std::span<const TextureBucket> buckets)
+{
+	BinaryWriter writer;
+	writer.Write(TEXTURE_BUCKETS_MAGIC);
+	writer.Write(TEXTURE_BUCKETS_VERSION);
+	writer.Write(static_cast<uint32_t>(buckets.size()));
+	for (const TextureBucket &bucket : buckets) {
+		writer.Write(static_cast<uint32_t>(bucket.key.format));
+		writer.Write(bucket.key.width);
+		writer.Write(bucket.key.height);
+		writer.Write(bucket.key.mipLevels);
+		writer.Write(static_cast<uint32_t>(bucket.textures.size()));
+		for (const std::string &texture : bucket.textures) {
+			writer.WriteString(texture);
+		}
+	}
+	return writer.TakeBuffer();
+}
+
+std::optional<std::vector<TextureBucket>> TGW::Cook::DeserializeTextureBuckets(std::span<const uint8_t> data)
+{
+	BinaryReader reader{data};
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t bucketCount = 0;
+	if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(bucketCount) || magic != TEXTURE_BUCKETS_MAGIC ||
+		version == 0 || version > TEXTURE_BUCKETS_VERSION || bucketCount > reader.GetRemaining() / (5 * sizeof(uint32_t))) {
+		return {};
+	}
+
+	std::vector<TextureBucket> buckets(bucketCount);
+	for (TextureBucket &bucket : buckets) {
+		uint32_t format = 0;
+		uint32_t textureCount = 0;
+		reader.Read(format);
+		reader.Read(bucket.key.width);
+		reader.Read(bucket.key.height);
+		reader.Read(bucket.key.mipLevels);
+		reader.Read(textureCount);
+		if (reader.HasFailed() || format > TEXTURE_FORMAT_BC7 || textureCount > reader.GetRemaining() / sizeof(uint32_t)) {
+			return {};
+		}
+		bucket.key.format = static_cast<TextureFormat>(format);
+		bucket.textures.resize(textureCount);
+		for (std::string &texture : bucket.textures) {
+			reader.ReadString(texture);
+		}
+	}
+	if (reader.HasFailed() || reader.GetRemaining() != 0) {
+		return {};
+	}
+	return buckets;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "mesh_data.h"
+
+#include <span>
+
+namespace TGW::Cook {
+
+constexpr uint32_t TEXTURE_BUCKETS_MAGIC = 0x42544D53; // "SMTB"
+constexpr uint32_t TEXTURE_BUCKETS_VERSION = 1;
+constexpr std::string_view TEXTURE_BUCKETS_NAME = "texture_buckets.bin";
+constexpr uint16_t NO_TEXTURE_BUCKET = UINT16_MAX;
+
+// What a texture becomes on the GPU. Images WIC decodes are expanded to RGBA8, DDS files keep their format.
+enum TextureFormat : uint8_t {
+	TEXTURE_FORMAT_UNKNOWN,
+	TEXTURE_FORMAT_RGBA8,
+	TEXTURE_FORMAT_BC1,
+	TEXTURE_FORMAT_BC3,
+	TEXTURE_FORMAT_BC5,
+	TEXTURE_FORMAT_BC7,
+};
+
+struct TextureInfo {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	TextureFormat format = TEXTURE_FORMAT_UNKNOWN;
+	uint32_t mipLevels = 1;
+	// Decoded to pixels on load, so it can be resized on the way into its array
+	bool resizable = false;
+};
+
+// Size and format from the header of a PNG, JPEG, BMP or DDS file, without decoding it. Empty for anything else
+// or a header cut short.
+std::optional<TextureInfo> ReadTextureInfo(std::span<const uint8_t> data);
+
+// Textures with equal keys share a Texture2DArray, one slice each
+struct TextureBucketKey {
+	TextureFormat format = TEXTURE_FORMAT_UNKNOWN;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mipLevels = 1;
+
+	auto operator<=>(const TextureBucketKey &) const = default;
+};
+
+struct TextureBucketSettings {
+	// RGBA8 textures are resized to a square power of two between these, with a full mip chain
+	uint32_t minSize = 64;
+	uint32_t maxSize = 2048;
+	// D3D11 caps an array at 2048 slices, a full bucket is followed by another with the same key
+	uint32_t maxSlices = 2048;
+	// As many arrays as model.hlsl declares
+	uint32_t maxBuckets = 8;
+};
+
+// RGBA8 textures go to the power of two nearest their larger side. Block compressed ones cannot be resized without
+// decoding them, so they keep their exact size and mips and only share with identical ones.
+TextureBucketKey GetBucketKey(const TextureInfo &info, const TextureBucketSettings &settings = {});
+// Bytes one slice takes on the GPU with all of its mips
+uint64_t GetSliceBytes(const TextureBucketKey &key);
+
+struct TextureRef {
+	uint16_t bucket = NO_TEXTURE_BUCKET;
+	uint16_t slice = 0;
+
+	inline bool IsValid() const { return bucket != NO_TEXTURE_BUCKET; }
+	bool operator==(const TextureRef &) const = default;
+};
+
+// Every slice of one array, textures[i] is slice i
+struct TextureBucket {
+	TextureBucketKey key;
+	std::vector<std::string> textures;
+};
+
+// What the material buffer holds for one material, the slice of each texture slot
+struct MaterialEntry {
+	std::array<TextureRef, TEXTURE_SLOT_COUNT> textures;
+
+	bool operator==(const MaterialEntry &) const = default;
+};
+
+// Packs textures into buckets of same format and size, and materials into one table shared by every model. A
+// draw then only needs the index of its material, the arrays are bound once for all of them.
+class MaterialTable {
+  public:
+	explicit MaterialTable(const TextureBucketSettings &settings = {});
+
+	// Lays out the buckets a cook planned, their textures then get the planned slice when they are added, as long as
+	// their key still matches. Only an empty table takes a plan, buckets and slices over the limits are left out.
+	bool UsePlan(std::span<const TextureBucket> buckets);
+	// Slice of the texture known under name, placed in the bucket of its key the first time the name is seen.
+	// Invalid when its format is unknown or every bucket for its key is full and no new one can be opened.
+	TextureRef AddTexture(std::string_view name, const TextureInfo &info);
+	// Slice the texture got when it was added, empty for a name never added
+	std::optional<TextureRef> FindTexture(std::string_view name) const;
+	// Index of a material with these textures, materials with the same textures share one
+	uint32_t AddMaterial(const MaterialEntry &material);
+
+	inline std::span<const TextureBucket> GetBuckets() const { return _buckets; }
+	inline std::span<const MaterialEntry> GetMaterials() const { return _materials; }
+	inline const TextureBucketSettings &GetSettings() const { return _settings; }
+
+  private:
+	struct MaterialHash {
+		size_t operator()(const MaterialEntry &material) const;
+	};
+
+	TextureBucketSettings _settings;
+	std::vector<TextureBucket> _buckets;
+	std::vector<MaterialEntry> _materials;
+	std::unordered_map<std::string, TextureRef> _textures;
+	// Slices reserved by UsePlan, textures move to _textures once added
+	std::unordered_map<std::string, TextureRef> _planned;
+	std::unordered_map<MaterialEntry, uint32_t, MaterialHash> _materialIndices;
+};
+
+std::vector<uint8_t> SerializeTextureBuckets(std::span<const TextureBucket> buckets);
+// Rejects wrong magic, newer versions and truncated data
+std::optional<std::vector<TextureBucket>> DeserializeTextureBuckets(std::span<const uint8_t> data);
+
+} // namespace TGW::Cook
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Little-endian serialization helpers. On little-endian hosts arrays go through a single memcpy.
+
+namespace TGW {
+
+template <typename T> constexpr T ByteSwap(T value)
+{
+	static_assert(std::is_integral_v<T>);
+	auto bytes = std::bit_cast<std::array<uint8_t, sizeof(T)>>(value);
+	for (size_t i = 0; i < sizeof(T) / 2; i++) {
+		std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+	}
+	return std::bit_cast<T>(bytes);
+}
+
+template <typename T> constexpr T ToLittleEndian(T value)
+{
+	if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+		return value;
+	} else if constexpr (std::is_floating_point_v<T>) {
+		using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+		return std::bit_cast<T>(ByteSwap(std::bit_cast<Bits>(value)));
+	} else {
+		return ByteSwap(value);
+	}
+}
+
+class BinaryWriter {
+  public:
+	template <typename T> void Write(T value)
+	{
+		static_assert(std::is_arithmetic_v<T>);
+		value = ToLittleEndian(value);
+		const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+		_buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	template <typename T> void WriteArray(std::span<const T> values)
+	{
+		static_assert(std::is_arithmetic_v<T>);
+		const size_t offset = _buffer.size();
+		_buffer.resize(offset + values.size_bytes());
+		if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+			if (!values.empty()) {
+				std::memcpy(_buffer.data() + offset, values.data(), values.size_bytes());
+			}
+		} else {
+			for (size_t i = 0; i < values.size(); i++) {
+				const T swapped = ToLittleEndian(values[i]);
+				std::memcpy(_buffer.data() + offset + i * sizeof(T), &swapped, sizeof(T));
+			}
+		}
+	}
+
+	void WriteString(std::string_view value)
+	{
+		Write(static_cast<uint32_t>(value.size()));
+		_buffer.insert(_buffer.end(), value.begin(), value.end());
+	}
+
+	inline const std::vector<uint8_t> &GetBuffer() const { return _buffer; }
+	inline std::vector<uint8_t> TakeBuffer() { return std::move(_buffer); }
+
+  private:
+	std::vector<uint8_t> _buffer;
+};
+
+// Every read is bounds checked. Once a read fails the reader stays failed, so callers can check once at the end.
+class BinaryReader {
+  public:
+	explicit BinaryReader(std::span<const uint8_t> data) : _data{data} {}
+
+	template <typename T> bool Read(T &value)
+	{
+		static_assert(std::is_arithmetic_v<T>);
+		if (!CanRead(sizeof(T))) {
+			return false;
+		}
+		std::memcpy(&value, _data.data() + _offset, sizeof(T));
+		value = ToLittleEndian(value);
+		_offset += sizeof(T);
+		return true;
+	}
+
+	template <typename T> bool ReadArray(std::span<T> values)
+	{
+		static_assert(std::is_arithmetic_v<T>);
+		if (!CanRead(values.size_bytes())) {
+			return false;
+		}
+		if (!values.empty()) {
+			std::memcpy(values.data(), _data.data() + _offset, values.size_bytes());
+		}
+		if constexpr (std::endian::native != std::endian::little && sizeof(T) > 1) {
+			for (T &value : values) {
+				value = ToLittleEndian(value);
+			}
+		}
+		_offset += values.size_bytes();
+		return true;
+	}
+
+	// Sizes the vector to count elements. The count is checked against the remaining bytes before allocating.
+	template <typename T> bool ReadArray(std::vector<T> &values, size_t count)
+	{
+		if (count > GetRemaining() / sizeof(T)) {
+			_failed = true;
+			return false;
+		}
+		values.resize(count);
+		return ReadArray(std::span<T>{values});
+	}
+
+	bool ReadString(std::string &value)
+	{
+		uint32_t size = 0;
+		if (!Read(size) || !CanRead(size)) {
+			return false;
+		}
+		value.assign(reinterpret_cast<const char *>(_data.data() + _offset), size);
+		_offset += size;
+		return true;
+	}
+
+	inline size_t GetRemaining() const { return _data.size() - _offset; }
+	inline size_t GetOffset() const { return _offset; }
+	inline bool HasFailed() const { return _failed; }
+
+  private:
+	bool CanRead(size_t size)
+	{
+		if (_failed || size > GetRemaining()) {
+			_failed = true;
+			return false;
+		}
+		return true;
+	}
+
+	std::span<const uint8_t> _data;
+	size_t _offset = 0;
+	bool _failed = false;
+};
+
+} // namespace TGW
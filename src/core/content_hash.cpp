@@ -0,0 +1,147 @@
+#include "content_hash.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TGW_CONTENT_HASH_SSE2
+#include <emmintrin.h>
+#endif
+
+using TGW::Hash::Hash128;
+
+namespace {
+constexpr size_t LANES = 8;
+constexpr size_t STRIPE_BYTES = LANES * sizeof(uint64_t);
+// Stripes between two scrambles, which keep the high bits of the accumulators from only ever growing
+constexpr size_t STRIPES_PER_BLOCK = 16;
+
+constexpr uint64_t PRIME32 = 0x9E3779B1ull;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t KEYS[LANES] = {
+	0xBE4BA423396CFEB8ull, 0x1CAD21F72C81017Cull, 0xDB979083E96DD4DEull, 0x1F67B3B7A4A44072ull,
+	0x78E5C0CC4EE679CBull, 0x2172FFCC7DD05A82ull, 0x8E2443F7744608B8ull, 0x4C263A81E69035E0ull,
+};
+
+struct Lanes {
+	alignas(16) uint64_t acc[LANES];
+	alignas(16) uint64_t keys[LANES];
+};
+
+inline uint64_t Avalanche(uint64_t x)
+{
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	x *= 0xC4CEB9FE1A85EC53ull;
+	x ^= x >> 33;
+	return x;
+}
+
+inline uint64_t LoadLane(const uint8_t *data)
+{
+	uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+// Each lane adds the product of the halves of its keyed word and, unkeyed, the word of its neighbour
+void AccumulateScalar(Lanes &lanes, const uint8_t *stripe)
+{
+	uint64_t words[LANES];
+	for (size_t i = 0; i < LANES; i++) {
+		words[i] = LoadLane(stripe + i * sizeof(uint64_t));
+	}
+	for (size_t i = 0; i < LANES; i++) {
+		const uint64_t keyed = words[i] ^ lanes.keys[i];
+		lanes.acc[i] += (keyed & 0xFFFFFFFFull) * (keyed >> 32) + words[i ^ 1];
+	}
+}
+
+void ScrambleScalar(Lanes &lanes)
+{
+	for (size_t i = 0; i < LANES; i++) {
+		uint64_t x = lanes.acc[i];
+		x ^= x >> 47;
+		x ^= lanes.keys[i];
+		lanes.acc[i] = x * PRIME32;
+	}
+}
+
+#ifdef TGW_CONTENT_HASH_SSE2
+void AccumulateSSE2(Lanes &lanes, const uint8_t *stripe)
+{
+	for (size_t i = 0; i < LANES; i += 2) {
+		const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(stripe + i * sizeof(uint64_t)));
+		const __m128i keyed = _mm_xor_si128(words, _mm_load_si128(reinterpret_cast<const __m128i *>(lanes.keys + i)));
+		const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+		const __m128i neighbours = _mm_shuffle_epi32(words, _MM_SHUFFLE(1, 0, 3, 2));
+		__m128i *acc = reinterpret_cast<__m128i *>(lanes.acc + i);
+		_mm_store_si128(acc, _mm_add_epi64(_mm_load_si128(acc), _mm_add_epi64(product, neighbours)));
+	}
+}
+
+void ScrambleSSE2(Lanes &lanes)
+{
+	const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32));
+	for (size_t i = 0; i < LANES; i += 2) {
+		__m128i *acc = reinterpret_cast<__m128i *>(lanes.acc + i);
+		__m128i x = _mm_load_si128(acc);
+		x = _mm_xor_si128(x, _mm_srli_epi64(x, 47));
+		x = _mm_xor_si128(x, _mm_load_si128(reinterpret_cast<const __m128i *>(lanes.keys + i)));
+		// 64x32 bit multiply from two 32x32 ones
+		const __m128i low = _mm_mul_epu32(x, prime);
+		const __m128i high = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+		_mm_store_si128(acc, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+	}
+}
+#endif
+
+template <void (*ACCUMULATE)(Lanes &, const uint8_t *), void (*SCRAMBLE)(Lanes &)>
+Hash128 Run(std::span<const uint8_t> data, uint64_t seed)
+{
+	Lanes lanes;
+	for (size_t i = 0; i < LANES; i++) {
+		lanes.keys[i] = KEYS[i] ^ (seed + i * PRIME64_1);
+		lanes.acc[i] = lanes.keys[i];
+	}
+
+	const size_t stripes = data.size() / STRIPE_BYTES;
+	for (size_t stripe = 0; stripe < stripes; stripe++) {
+		ACCUMULATE(lanes, data.data() + stripe * STRIPE_BYTES);
+		if ((stripe + 1) % STRIPES_PER_BLOCK == 0) {
+			SCRAMBLE(lanes);
+		}
+	}
+	// The tail goes in zero padded, the length mixed in below tells it apart from real zeros
+	if (const size_t tail = data.size() % STRIPE_BYTES) {
+		uint8_t last[STRIPE_BYTES] = {};
+		std::memcpy(last, data.data() + stripes * STRIPE_BYTES, tail);
+		ACCUMULATE(lanes, last);
+	}
+
+	const uint64_t length = data.size();
+	Hash128 hash{.low = Avalanche(length * PRIME64_1 ^ seed), .high = Avalanche(~length * PRIME64_2 ^ seed)};
+	for (size_t i = 0; i < LANES; i++) {
+		hash.low = Avalanche(hash.low ^ lanes.acc[i]);
+		hash.high = Avalanche(hash.high ^ (lanes.acc[LANES - 1 - i] + PRIME64_2));
+	}
+	return hash;
+}
+} // namespace
+
+/* Implementation of public functions */
+
+Hash128 TGW::Hash::ContentHash128(std::span<const uint8_t> data, uint64_t seed)
+{
+#ifdef TGW_CONTENT_HASH_SSE2
+	return Run<AccumulateSSE2, ScrambleSSE2>(data, seed);
+#else
+	return Run<AccumulateScalar, ScrambleScalar>(data, seed);
+#endif
+}
+
+Hash128 TGW::Hash::ContentHash128Scalar(std::span<const uint8_t> data, uint64_t seed)
+{
+	return Run<AccumulateScalar, ScrambleScalar>(data, seed);
+}
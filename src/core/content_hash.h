@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace TGW::Hash {
+
+struct Hash128 {
+	uint64_t low = 0;
+	uint64_t high = 0;
+
+	bool operator==(const Hash128 &) const = default;
+};
+
+// Fast non-cryptographic 128-bit hash of a block of bytes, for telling identical asset data apart without comparing
+// it byte by byte. Eight 64-bit lanes take a 64 byte stripe at a time with 32x32 bit multiplies, two lanes per SSE2
+// register, and are scrambled every 1 KiB and avalanched at the end. The same input and seed give the same hash on
+// every platform.
+Hash128 ContentHash128(std::span<const uint8_t> data, uint64_t seed = 0);
+// Same result one lane at a time, for platforms without SSE2 and to check the SIMD path against
+Hash128 ContentHash128Scalar(std::span<const uint8_t> data, uint64_t seed = 0);
+
+} // namespace TGW::Hash
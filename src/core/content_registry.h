@@ -0,0 +1,148 @@
+#pragma once
+
+#include "content_hash.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace TGW {
+
+// Identifies a block of content, the size is part of it so a hash collision also needs the same size
+struct ContentKey {
+	Hash::Hash128 hash;
+	uint64_t bytes = 0;
+
+	bool operator==(const ContentKey &) const = default;
+};
+
+struct ContentRegistryStats {
+	uint64_t requests = 0;
+	// Requests served by content already in the registry
+	uint64_t hits = 0;
+	uint64_t liveEntries = 0;
+	// Bytes of the entries alive, each counted once
+	uint64_t liveBytes = 0;
+	// Bytes the users of those entries would hold if none of them were shared
+	uint64_t referencedBytes = 0;
+
+	inline uint64_t GetSavedBytes() const { return referencedBytes - liveBytes; }
+	// Users per entry, weighted by size. 1 when nothing is shared.
+	inline double GetDedupRatio() const { return liveBytes ? static_cast<double>(referencedBytes) / liveBytes : 1.0; }
+};
+
+// Shares one T between every user of the same content. Acquire hands each user its own shared_ptr, the entry goes
+// away with the last of them, so dropping whatever holds it is all a user has to do. Safe from any thread, the
+// handles can outlive the registry.
+template <typename T> class ContentRegistry {
+  public:
+	ContentRegistry() : _state{std::make_shared<State>()} {}
+
+	// Content already registered under the key, or what make returns for it otherwise. make runs without the lock held
+	// and returns std::optional<T>, nullopt fails the request with nullptr.
+	template <typename MAKE> std::shared_ptr<const T> Acquire(const ContentKey &key, MAKE &&make)
+	{
+		{
+			std::scoped_lock lock{_state->mutex};
+			_state->stats.requests++;
+			if (auto shared = Find(key)) {
+				return AddUser(key, std::move(shared));
+			}
+		}
+
+		std::optional<T> value = make();
+		if (!value) {
+			return nullptr;
+		}
+		std::scoped_lock lock{_state->mutex};
+		// Another thread may have made the same content meanwhile, the copy made here is dropped then
+		if (auto shared = Find(key)) {
+			return AddUser(key, std::move(shared));
+		}
+		std::shared_ptr<const T> shared{new T{std::move(*value)}, EntryDeleter{_state, key}};
+		_state->entries[key] = shared;
+		_state->stats.liveEntries++;
+		_state->stats.liveBytes += key.bytes;
+		_state->stats.referencedBytes += key.bytes;
+		return MakeUser(key, std::move(shared));
+	}
+
+	ContentRegistryStats GetStats() const
+	{
+		std::scoped_lock lock{_state->mutex};
+		return _state->stats;
+	}
+
+  private:
+	struct KeyHash {
+		size_t operator()(const ContentKey &key) const { return static_cast<size_t>(key.hash.low ^ key.bytes); }
+	};
+
+	struct State {
+		std::mutex mutex;
+		std::unordered_map<ContentKey, std::weak_ptr<const T>, KeyHash> entries;
+		ContentRegistryStats stats;
+	};
+
+	// Runs when the last user is gone
+	struct EntryDeleter {
+		std::shared_ptr<State> state;
+		ContentKey key;
+
+		void operator()(const T *value) const
+		{
+			{
+				std::scoped_lock lock{state->mutex};
+				// A new entry under the same key may already be in, made while this one was on its way out
+				if (auto it = state->entries.find(key); it != state->entries.end() && it->second.expired()) {
+					state->entries.erase(it);
+				}
+				state->stats.liveEntries--;
+				state->stats.liveBytes -= key.bytes;
+			}
+			delete value;
+		}
+	};
+
+	// Runs when one user is gone, holding the entry until then
+	struct UserDeleter {
+		std::shared_ptr<State> state;
+		std::shared_ptr<const T> entry;
+		uint64_t bytes = 0;
+
+		void operator()(const T *)
+		{
+			{
+				std::scoped_lock lock{state->mutex};
+				state->stats.referencedBytes -= bytes;
+			}
+			entry.reset();
+		}
+	};
+
+	// Called with the lock held
+	std::shared_ptr<const T> Find(const ContentKey &key) const
+	{
+		const auto it = _state->entries.find(key);
+		return it != _state->entries.end() ? it->second.lock() : nullptr;
+	}
+
+	// Called with the lock held
+	std::shared_ptr<const T> AddUser(const ContentKey &key, std::shared_ptr<const T> shared)
+	{
+		_state->stats.hits++;
+		_state->stats.referencedBytes += key.bytes;
+		return MakeUser(key, std::move(shared));
+	}
+
+	std::shared_ptr<const T> MakeUser(const ContentKey &key, std::shared_ptr<const T> shared)
+	{
+		const T *value = shared.get();
+		return std::shared_ptr<const T>{value, UserDeleter{_state, std::move(shared), key.bytes}};
+	}
+
+	std::shared_ptr<State> _state;
+};
+
+} // namespace TGW
@@ -0,0 +1,176 @@
+#include "file_mapping.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TGW::FileMapping::~FileMapping() { Close(); }
+
+TGW::FileMapping::FileMapping(FileMapping &&other) noexcept { *this = std::move(other); }
+
+TGW::FileMapping &TGW::FileMapping::operator=(FileMapping &&other) noexcept
+{
+	if (this != &other) {
+		Close();
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+#ifdef _WIN32
+		std::swap(_file, other._file);
+		std::swap(_mapping, other._mapping);
+#else
+		std::swap(_fd, other._fd);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool TGW::FileMapping::Open(const std::filesystem::path &path)
+{
+	Close();
+
+	HANDLE file = CreateFileW(
+		path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_mapping = mapping;
+	_data = static_cast<const uint8_t *>(view);
+	_size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void TGW::FileMapping::Close()
+{
+	if (_data) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mapping) {
+		CloseHandle(_mapping);
+	}
+	if (_file) {
+		CloseHandle(_file);
+	}
+	_data = nullptr;
+	_size = 0;
+	_file = nullptr;
+	_mapping = nullptr;
+}
+
+void TGW::FileMapping::Prefetch(size_t offset, size_t size) const
+{
+	if (!_data || offset >= _size) {
+		return;
+	}
+	WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t *>(_data + offset), std::min(size, _size - offset)};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void TGW::FileMapping::Evict(size_t offset, size_t size) const
+{
+	if (!_data || offset >= _size) {
+		return;
+	}
+	// Only drops our working set, Windows has no per-file page cache eviction for mapped views
+	VirtualUnlock(const_cast<uint8_t *>(_data + offset), std::min(size, _size - offset));
+}
+
+#else
+
+bool TGW::FileMapping::Open(const std::filesystem::path &path)
+{
+	Close();
+
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info{};
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void *view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+
+	_fd = fd;
+	_data = static_cast<const uint8_t *>(view);
+	_size = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void TGW::FileMapping::Close()
+{
+	if (_data) {
+		munmap(const_cast<uint8_t *>(_data), _size);
+	}
+	if (_fd >= 0) {
+		close(_fd);
+	}
+	_data = nullptr;
+	_size = 0;
+	_fd = -1;
+}
+
+void TGW::FileMapping::Prefetch(size_t offset, size_t size) const
+{
+	if (!_data || offset >= _size) {
+		return;
+	}
+	// madvise wants page aligned addresses
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t begin = offset & ~(pageSize - 1);
+	const size_t end = std::min(offset + size, _size);
+	madvise(const_cast<uint8_t *>(_data + begin), end - begin, MADV_WILLNEED);
+}
+
+void TGW::FileMapping::Evict(size_t offset, size_t size) const
+{
+	if (!_data || offset >= _size) {
+		return;
+	}
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t begin = offset & ~(pageSize - 1);
+	const size_t end = std::min(offset + size, _size);
+	madvise(const_cast<uint8_t *>(_data + begin), end - begin, MADV_DONTNEED);
+	posix_fadvise(_fd, static_cast<off_t>(begin), static_cast<off_t>(end - begin), POSIX_FADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace TGW {
+
+// Read-only memory map of a whole file. Pages are faulted in lazily unless Prefetch is called.
+class FileMapping {
+  public:
+	FileMapping() = default;
+	~FileMapping();
+
+	FileMapping(const FileMapping &) = delete;
+	FileMapping &operator=(const FileMapping &) = delete;
+	FileMapping(FileMapping &&other) noexcept;
+	FileMapping &operator=(FileMapping &&other) noexcept;
+
+	bool Open(const std::filesystem::path &path);
+	void Close();
+
+	// Hints the OS to start reading [offset, offset + size) in the background
+	void Prefetch(size_t offset, size_t size) const;
+	// Tells the OS the range is no longer needed and may be dropped from the page cache
+	void Evict(size_t offset, size_t size) const;
+
+	inline const uint8_t *GetData() const { return _data; }
+	inline size_t GetSize() const { return _size; }
+	inline bool IsOpen() const { return _data != nullptr; }
+
+  private:
+	const uint8_t *_data = nullptr;
+	size_t _size = 0;
+#ifdef _WIN32
+	void *_file = nullptr;
+	void *_mapping = nullptr;
+#else
+	int _fd = -1;
+#endif
+};
+
+} // namespace TGW
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace TGW::Hash {
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+constexpr uint64_t Fnv1a(std::string_view data, uint64_t seed = FNV_OFFSET_BASIS)
+{
+	uint64_t hash = seed;
+	for (char c : data) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+// Asset paths are compared case-insensitively with forward slashes, the way they show up in model files
+inline std::string NormalizePath(std::string_view path)
+{
+	std::string out;
+	out.reserve(path.size());
+	for (char c : path) {
+		if (c == '\\') {
+			c = '/';
+		} else if (c >= 'A' && c <= 'Z') {
+			c = static_cast<char>(c - 'A' + 'a');
+		}
+		if (c == '/' && !out.empty() && out.back() == '/') {
+			continue;
+		}
+		out.push_back(c);
+	}
+	while (out.starts_with("./")) {
+		out.erase(0, 2);
+	}
+	return out;
+}
+
+inline uint64_t HashPath(std::string_view path) { return Fnv1a(NormalizePath(path)); }
+
+} // namespace TGW::Hash
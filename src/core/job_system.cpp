@@ -0,0 +1,100 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+TGW::JobSystem::JobSystem(uint32_t workerCount)
+{
+	_workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++) {
+		_workers.emplace_back([this] { WorkerLoop(); });
+	}
+}
+
+TGW::JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock{_mutex};
+		_quit = true;
+	}
+	_wakeUp.notify_all();
+	for (auto &worker : _workers) {
+		worker.join();
+	}
+}
+
+void TGW::JobSystem::ParallelFor(
+	uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)> &fn)
+{
+	if (count == 0) {
+		return;
+	}
+
+	batchSize = std::max(1u, batchSize);
+	const uint32_t batchCount = (count + batchSize - 1) / batchSize;
+	if (batchCount == 1 || _workers.empty()) {
+		fn(0, count);
+		return;
+	}
+
+	// Batches are claimed from a counter, the caller and its helpers take them until none are left. Helpers that get
+	// to run after that find nothing, so they hold on to the counters and never touch fn.
+	struct Loop {
+		std::atomic<uint32_t> next{0};
+		std::atomic<uint32_t> remaining{0};
+	};
+	const auto loop = std::make_shared<Loop>();
+	loop->remaining.store(batchCount, std::memory_order_relaxed);
+	const auto runBatches = [&fn, count, batchSize, batchCount](Loop &loop) {
+		for (uint32_t batch = loop.next.fetch_add(1); batch < batchCount; batch = loop.next.fetch_add(1)) {
+			const uint32_t begin = batch * batchSize;
+			fn(begin, std::min(count, begin + batchSize));
+			loop.remaining.fetch_sub(1, std::memory_order_release);
+		}
+	};
+
+	const uint32_t helperCount = std::min(GetWorkerCount(), batchCount - 1);
+	{
+		std::lock_guard lock{_mutex};
+		for (uint32_t i = 0; i < helperCount; i++) {
+			_queue.emplace_back([loop, runBatches] { runBatches(*loop); });
+		}
+	}
+	_wakeUp.notify_all();
+
+	// The caller only ever runs batches of its own loop, never a job someone else queued
+	runBatches(*loop);
+	while (loop->remaining.load(std::memory_order_acquire) > 0) {
+		std::this_thread::yield();
+	}
+}
+
+void TGW::JobSystem::Submit(std::function<void()> job)
+{
+	if (_workers.empty()) {
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard lock{_mutex};
+		_queue.push_back(std::move(job));
+	}
+	_wakeUp.notify_one();
+}
+
+void TGW::JobSystem::WorkerLoop()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock lock{_mutex};
+			_wakeUp.wait(lock, [this] { return _quit || !_queue.empty(); });
+			if (_quit && _queue.empty()) {
+				return;
+			}
+			job = std::move(_queue.front());
+			_queue.pop_front();
+		}
+		job();
+	}
+}
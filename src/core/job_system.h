@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TGW {
+
+// Fixed pool of worker threads shared by every subsystem that wants to go wide.
+// A thread waiting in ParallelFor only helps with the batches of its own loop, so ParallelFor may be called from inside
+// a job and a long job from Submit never ends up running on the caller. The exception is a pool without workers, which
+// runs everything inline, Submit included. Get() keeps one worker even on a single core for that reason.
+class JobSystem {
+  public:
+	explicit JobSystem(uint32_t workerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem &) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	// Runs fn(begin, end) over [0, count) in slices of at most batchSize and returns once all of them finished
+	void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)> &fn);
+
+	// Fire and forget, the job runs on a worker at some point later. Without workers it runs before Submit returns.
+	void Submit(std::function<void()> job);
+
+	inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+	inline static JobSystem &Get()
+	{
+		static JobSystem instance{std::max(2u, std::thread::hardware_concurrency()) - 1};
+		return instance;
+	}
+
+  private:
+	void WorkerLoop();
+
+	std::vector<std::thread> _workers;
+	std::deque<std::function<void()>> _queue;
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	bool _quit = false;
+};
+
+} // namespace TGW
@@ -0,0 +1,354 @@
+#include "json_reader.h"
+
+#include <charconv>
+#include <cmath>
+
+using namespace TGW::Json;
+
+namespace {
+// Deep enough for any glTF, shallow enough that hostile input cannot blow the stack
+constexpr uint32_t MAX_DEPTH = 64;
+
+void AppendUtf8(std::string &out, uint32_t codePoint)
+{
+	if (codePoint < 0x80) {
+		out.push_back(static_cast<char>(codePoint));
+	} else if (codePoint < 0x800) {
+		out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+		out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	} else if (codePoint < 0x10000) {
+		out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+		out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	} else {
+		out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+		out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+}
+
+std::optional<uint32_t> ParseHex4(std::string_view text)
+{
+	uint32_t value = 0;
+	if (text.size() < 4 || std::from_chars(text.data(), text.data() + 4, value, 16).ptr != text.data() + 4) {
+		return {};
+	}
+	return value;
+}
+} // namespace
+
+/* JsonDocument */
+
+bool JsonDocument::Parse(std::string_view text)
+{
+	_text = text;
+	_position = 0;
+	_tokens.clear();
+	// A token per 8 characters is about what minified glTF needs
+	_tokens.reserve(text.size() / 8 + 1);
+
+	if (text.size() >= UINT32_MAX || !ParseValue(0)) {
+		_tokens.clear();
+		return false;
+	}
+	SkipWhitespace();
+	if (_position != _text.size()) {
+		_tokens.clear();
+		return false;
+	}
+	return true;
+}
+
+bool JsonDocument::ParseValue(uint32_t depth)
+{
+	SkipWhitespace();
+	if (_position >= _text.size() || depth > MAX_DEPTH) {
+		return false;
+	}
+
+	const uint32_t index = static_cast<uint32_t>(_tokens.size());
+	const char c = _text[_position];
+	if (c == '{' || c == '[') {
+		const bool isObject = c == '{';
+		const char close = isObject ? '}' : ']';
+		_tokens.push_back({isObject ? JsonType::OBJECT : JsonType::ARRAY, false, static_cast<uint32_t>(_position), 0, 0});
+		_position++;
+
+		uint32_t count = 0;
+		SkipWhitespace();
+		if (_position < _text.size() && _text[_position] == close) {
+			_position++;
+		} else {
+			while (true) {
+				if (isObject) {
+					SkipWhitespace();
+					JsonToken key{};
+					if (_position >= _text.size() || _text[_position] != '"' || !ParseString(key)) {
+						return false;
+					}
+					key.next = static_cast<uint32_t>(_tokens.size() + 1);
+					_tokens.push_back(key);
+					SkipWhitespace();
+					if (_position >= _text.size() || _text[_position] != ':') {
+						return false;
+					}
+					_position++;
+				}
+				if (!ParseValue(depth + 1)) {
+					return false;
+				}
+				count++;
+
+				SkipWhitespace();
+				if (_position >= _text.size()) {
+					return false;
+				}
+				if (_text[_position] == ',') {
+					_position++;
+				} else if (_text[_position] == close) {
+					_position++;
+					break;
+				} else {
+					return false;
+				}
+			}
+		}
+
+		_tokens[index].length = count;
+		_tokens[index].next = static_cast<uint32_t>(_tokens.size());
+		return true;
+	}
+
+	JsonToken token{};
+	bool parsed = false;
+	if (c == '"') {
+		parsed = ParseString(token);
+	} else if (c == '-' || (c >= '0' && c <= '9')) {
+		parsed = ParseNumber(token);
+	} else if (c == 't') {
+		return ParseLiteral("true", JsonType::BOOLEAN, true);
+	} else if (c == 'f') {
+		return ParseLiteral("false", JsonType::BOOLEAN, false);
+	} else if (c == 'n') {
+		return ParseLiteral("null", JsonType::NUL, false);
+	}
+	if (!parsed) {
+		return false;
+	}
+	token.next = index + 1;
+	_tokens.push_back(token);
+	return true;
+}
+
+bool JsonDocument::ParseString(JsonToken &token)
+{
+	// _position is on the opening quote
+	const size_t begin = ++_position;
+	bool hasEscapes = false;
+	while (_position < _text.size()) {
+		const char c = _text[_position];
+		if (c == '"') {
+			token = {JsonType::STRING, hasEscapes, static_cast<uint32_t>(begin), static_cast<uint32_t>(_position - begin), 0};
+			_position++;
+			return true;
+		}
+		if (c == '\\') {
+			hasEscapes = true;
+			_position++;
+		} else if (static_cast<uint8_t>(c) < 0x20) {
+			return false;
+		}
+		_position++;
+	}
+	return false;
+}
+
+bool JsonDocument::ParseNumber(JsonToken &token)
+{
+	const size_t begin = _position;
+	if (_text[_position] == '-') {
+		_position++;
+	}
+	auto digits = [this] {
+		const size_t start = _position;
+		while (_position < _text.size() && _text[_position] >= '0' && _text[_position] <= '9') {
+			_position++;
+		}
+		return _position > start;
+	};
+
+	if (!digits()) {
+		return false;
+	}
+	if (_position < _text.size() && _text[_position] == '.') {
+		_position++;
+		if (!digits()) {
+			return false;
+		}
+	}
+	if (_position < _text.size() && (_text[_position] == 'e' || _text[_position] == 'E')) {
+		_position++;
+		if (_position < _text.size() && (_text[_position] == '+' || _text[_position] == '-')) {
+			_position++;
+		}
+		if (!digits()) {
+			return false;
+		}
+	}
+
+	token = {JsonType::NUMBER, false, static_cast<uint32_t>(begin), static_cast<uint32_t>(_position - begin), 0};
+	return true;
+}
+
+bool JsonDocument::ParseLiteral(std::string_view literal, JsonType type, bool flag)
+{
+	if (_text.substr(_position, literal.size()) != literal) {
+		return false;
+	}
+	const uint32_t index = static_cast<uint32_t>(_tokens.size());
+	_tokens.push_back({type, flag, static_cast<uint32_t>(_position), static_cast<uint32_t>(literal.size()), index + 1});
+	_position += literal.size();
+	return true;
+}
+
+void JsonDocument::SkipWhitespace()
+{
+	while (_position < _text.size()) {
+		const char c = _text[_position];
+		if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+			return;
+		}
+		_position++;
+	}
+}
+
+/* JsonValue */
+
+const JsonToken *JsonValue::GetToken() const { return _document ? &_document->GetTokens()[_index] : nullptr; }
+
+JsonType JsonValue::GetType() const { return GetToken()->type; }
+
+JsonValue JsonValue::operator[](std::string_view key) const
+{
+	JsonValue found;
+	ForEachMember([&](std::string_view name, JsonValue value) {
+		if (!found.IsValid() && name == key) {
+			found = value;
+		}
+	});
+	return found;
+}
+
+JsonValue JsonValue::operator[](uint32_t index) const
+{
+	if (!Is(JsonType::ARRAY) || index >= GetToken()->length) {
+		return {};
+	}
+	uint32_t token = _index + 1;
+	for (uint32_t i = 0; i < index; i++) {
+		token = _document->GetTokens()[token].next;
+	}
+	return {_document, token};
+}
+
+uint32_t JsonValue::GetSize() const { return Is(JsonType::ARRAY) || Is(JsonType::OBJECT) ? GetToken()->length : 0; }
+
+double JsonValue::AsDouble(double fallback) const
+{
+	if (!Is(JsonType::NUMBER)) {
+		return fallback;
+	}
+	const JsonToken *token = GetToken();
+	const char *begin = _document->GetText().data() + token->offset;
+	double value = fallback;
+	std::from_chars(begin, begin + token->length, value);
+	return value;
+}
+
+std::optional<uint32_t> JsonValue::AsUint() const
+{
+	if (!Is(JsonType::NUMBER)) {
+		return {};
+	}
+	const JsonToken *token = GetToken();
+	const char *begin = _document->GetText().data() + token->offset;
+	uint32_t value = 0;
+	const auto result = std::from_chars(begin, begin + token->length, value);
+	if (result.ec == std::errc{} && result.ptr == begin + token->length) {
+		return value;
+	}
+
+	// Exporters sometimes write integers as 1.0 or 1e2
+	const double number = AsDouble(-1.0);
+	if (number >= 0.0 && number <= UINT32_MAX && std::floor(number) == number) {
+		return static_cast<uint32_t>(number);
+	}
+	return {};
+}
+
+bool JsonValue::AsBool(bool fallback) const { return Is(JsonType::BOOLEAN) ? GetToken()->flag : fallback; }
+
+std::string_view JsonValue::AsRawString() const
+{
+	if (!Is(JsonType::STRING)) {
+		return {};
+	}
+	const JsonToken *token = GetToken();
+	return _document->GetText().substr(token->offset, token->length);
+}
+
+std::string JsonValue::AsString() const
+{
+	const std::string_view raw = AsRawString();
+	if (!Is(JsonType::STRING) || !GetToken()->flag) {
+		return std::string{raw};
+	}
+
+	std::string out;
+	out.reserve(raw.size());
+	for (size_t i = 0; i < raw.size(); i++) {
+		if (raw[i] != '\\' || i + 1 >= raw.size()) {
+			out.push_back(raw[i]);
+			continue;
+		}
+		const char escape = raw[++i];
+		switch (escape) {
+		case 'b':
+			out.push_back('\b');
+			break;
+		case 'f':
+			out.push_back('\f');
+			break;
+		case 'n':
+			out.push_back('\n');
+			break;
+		case 'r':
+			out.push_back('\r');
+			break;
+		case 't':
+			out.push_back('\t');
+			break;
+		case 'u': {
+			auto codePoint = ParseHex4(raw.substr(i + 1));
+			if (!codePoint) {
+				return out;
+			}
+			i += 4;
+			// Surrogate pair
+			if (*codePoint >= 0xD800 && *codePoint < 0xDC00 && raw.substr(i + 1, 2) == "\\u") {
+				if (auto low = ParseHex4(raw.substr(i + 3)); low && *low >= 0xDC00 && *low < 0xE000) {
+					*codePoint = 0x10000 + ((*codePoint - 0xD800) << 10) + (*low - 0xDC00);
+					i += 6;
+				}
+			}
+			AppendUtf8(out, *codePoint);
+			break;
+		}
+		default:
+			out.push_back(escape);
+			break;
+		}
+	}
+	return out;
+}
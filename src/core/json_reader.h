@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace TGW::Json {
+
+enum class JsonType : uint8_t {
+	NUL,
+	BOOLEAN,
+	NUMBER,
+	STRING,
+	ARRAY,
+	OBJECT,
+};
+
+// One value in document order. Containers are followed by their children, object members as key/value pairs,
+// and next points past the whole subtree so siblings can be skipped without looking inside.
+struct JsonToken {
+	JsonType type;
+	bool flag; // true for BOOLEAN true, STRING with escapes
+	uint32_t offset;
+	uint32_t length; // characters for scalars, children for ARRAY, members for OBJECT
+	uint32_t next;
+};
+
+class JsonDocument;
+
+// Cheap handle to a token. Lookups on a missing value or the wrong type give an invalid value or the fallback.
+class JsonValue {
+  public:
+	JsonValue() = default;
+	JsonValue(const JsonDocument *document, uint32_t index) : _document{document}, _index{index} {}
+
+	inline bool IsValid() const { return _document != nullptr; }
+	JsonType GetType() const;
+	bool Is(JsonType type) const { return IsValid() && GetType() == type; }
+
+	// Object member lookup, linear in the member count like every glTF object needs
+	JsonValue operator[](std::string_view key) const;
+	// Array element lookup, linear in the index
+	JsonValue operator[](uint32_t index) const;
+	uint32_t GetSize() const;
+
+	double AsDouble(double fallback = 0.0) const;
+	float AsFloat(float fallback = 0.0f) const { return static_cast<float>(AsDouble(fallback)); }
+	// Fails for negative, fractional or out of range numbers
+	std::optional<uint32_t> AsUint() const;
+	uint32_t AsUint(uint32_t fallback) const { return AsUint().value_or(fallback); }
+	bool AsBool(bool fallback = false) const;
+	// Raw text between the quotes, only valid while the source text lives. Use AsString when it may hold escapes.
+	std::string_view AsRawString() const;
+	std::string AsString() const;
+
+	// Iterates array elements or object values in order, calling fn(value) or fn(key, value)
+	template <typename Fn> void ForEachElement(Fn &&fn) const;
+	template <typename Fn> void ForEachMember(Fn &&fn) const;
+
+  private:
+	const JsonToken *GetToken() const;
+
+	const JsonDocument *_document = nullptr;
+	uint32_t _index = 0;
+};
+
+// Parses a whole document in one pass into a flat token tape. No allocation per value, strings and numbers stay
+// as views into the source text, which must outlive the document.
+class JsonDocument {
+  public:
+	bool Parse(std::string_view text);
+
+	inline JsonValue GetRoot() const { return _tokens.empty() ? JsonValue{} : JsonValue{this, 0}; }
+	inline std::string_view GetText() const { return _text; }
+	inline const std::vector<JsonToken> &GetTokens() const { return _tokens; }
+
+  private:
+	bool ParseValue(uint32_t depth);
+	bool ParseString(JsonToken &token);
+	bool ParseNumber(JsonToken &token);
+	bool ParseLiteral(std::string_view literal, JsonType type, bool flag);
+	void SkipWhitespace();
+
+	std::string_view _text;
+	size_t _position = 0;
+	std::vector<JsonToken> _tokens;
+};
+
+template <typename Fn> void JsonValue::ForEachElement(Fn &&fn) const
+{
+	if (!Is(JsonType::ARRAY)) {
+		return;
+	}
+	const uint32_t count = GetToken()->length;
+	uint32_t index = _index + 1;
+	for (uint32_t i = 0; i < count; i++) {
+		fn(JsonValue{_document, index});
+		index = _document->GetTokens()[index].next;
+	}
+}
+
+template <typename Fn> void JsonValue::ForEachMember(Fn &&fn) const
+{
+	if (!Is(JsonType::OBJECT)) {
+		return;
+	}
+	const uint32_t count = GetToken()->length;
+	uint32_t index = _index + 1;
+	for (uint32_t i = 0; i < count; i++) {
+		const JsonValue key{_document, index};
+		const uint32_t valueIndex = index + 1;
+		fn(key.AsRawString(), JsonValue{_document, valueIndex});
+		index = _document->GetTokens()[valueIndex].next;
+	}
+}
+
+} // namespace TGW::Json
@@ -0,0 +1,52 @@
+#include "memory_tracker.h"
+
+TGW::MemoryStats TGW::MemoryTracker::GetStats(MemoryTag tag, MemoryPool pool) const
+{
+	const Counters &counters = _counters[tag][pool];
+	return MemoryStats{
+	  .liveBytes = counters.liveBytes.load(std::memory_order_relaxed),
+	  .peakBytes = counters.peakBytes.load(std::memory_order_relaxed),
+	  .liveCount = counters.liveCount.load(std::memory_order_relaxed),
+	  .totalCount = counters.totalCount.load(std::memory_order_relaxed),
+	};
+}
+
+TGW::MemoryStats TGW::MemoryTracker::GetTotal(MemoryPool pool) const
+{
+	MemoryStats total;
+	for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+		const MemoryStats stats = GetStats(static_cast<MemoryTag>(tag), pool);
+		total.liveBytes += stats.liveBytes;
+		total.peakBytes += stats.peakBytes;
+		total.liveCount += stats.liveCount;
+		total.totalCount += stats.totalCount;
+	}
+	return total;
+}
+
+void TGW::MemoryTracker::ResetPeaks()
+{
+	for (auto &pools : _counters) {
+		for (Counters &counters : pools) {
+			counters.peakBytes.store(counters.liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+}
+
+const char *TGW::MemoryTracker::GetTagName(MemoryTag tag)
+{
+	switch (tag) {
+	case MEMORY_TAG_MESHES:
+		return "Meshes";
+	case MEMORY_TAG_TEXTURES:
+		return "Textures";
+	case MEMORY_TAG_GUI:
+		return "GUI";
+	case MEMORY_TAG_LOGS:
+		return "Logs";
+	case MEMORY_TAG_SCENE:
+		return "Scene";
+	default:
+		return "Unknown";
+	}
+}
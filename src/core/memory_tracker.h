@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace TGW {
+
+// Subsystem a block of memory is counted against
+enum MemoryTag : uint8_t {
+	MEMORY_TAG_MESHES,
+	MEMORY_TAG_TEXTURES,
+	MEMORY_TAG_GUI,
+	MEMORY_TAG_LOGS,
+	MEMORY_TAG_SCENE,
+	MEMORY_TAG_COUNT,
+};
+
+// Where the block lives, GPU blocks are the sizes of the D3D resources created for them
+enum MemoryPool : uint8_t {
+	MEMORY_POOL_CPU,
+	MEMORY_POOL_GPU,
+	MEMORY_POOL_COUNT,
+};
+
+struct MemoryStats {
+	uint64_t liveBytes = 0;
+	// Highest liveBytes since the start or the last ResetPeaks
+	uint64_t peakBytes = 0;
+	uint64_t liveCount = 0;
+	// Every allocation ever counted, freed or not
+	uint64_t totalCount = 0;
+};
+
+// Live bytes, peaks and counts per tag and pool. Counting is a few relaxed atomic adds on counters of their own
+// cache line, so it is cheap enough for every allocation of a container and safe from any thread. It only knows
+// what it is told: callers report each allocation and free with the same size.
+class MemoryTracker {
+  public:
+	inline void Allocate(MemoryTag tag, MemoryPool pool, uint64_t bytes)
+	{
+		Counters &counters = _counters[tag][pool];
+		const uint64_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+		}
+		counters.liveCount.fetch_add(1, std::memory_order_relaxed);
+		counters.totalCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline void Free(MemoryTag tag, MemoryPool pool, uint64_t bytes)
+	{
+		Counters &counters = _counters[tag][pool];
+		counters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		counters.liveCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	// Counters are read one by one, while other threads allocate they may be slightly out of step with each other
+	MemoryStats GetStats(MemoryTag tag, MemoryPool pool) const;
+	// Sum over every tag, the peak is the sum of the tag peaks and so an upper bound
+	MemoryStats GetTotal(MemoryPool pool) const;
+	void ResetPeaks();
+
+	static const char *GetTagName(MemoryTag tag);
+
+	inline static MemoryTracker &Get()
+	{
+		static MemoryTracker instance;
+		return instance;
+	}
+
+  private:
+	struct alignas(64) Counters {
+		std::atomic<uint64_t> liveBytes{0};
+		std::atomic<uint64_t> peakBytes{0};
+		std::atomic<uint64_t> liveCount{0};
+		std::atomic<uint64_t> totalCount{0};
+	};
+
+	Counters _counters[MEMORY_TAG_COUNT][MEMORY_POOL_COUNT];
+};
+
+// Counts bytes against a tag for as long as it lives. A copy counts them again, like a copy of the memory it stands
+// for would. Hold it in a shared_ptr instead when copies of the owner share that memory.
+class TrackedAllocation {
+  public:
+	TrackedAllocation() = default;
+	TrackedAllocation(MemoryTag tag, MemoryPool pool, uint64_t bytes) : _tag{tag}, _pool{pool}, _bytes{bytes}, _active{true}
+	{
+		MemoryTracker::Get().Allocate(_tag, _pool, _bytes);
+	}
+	~TrackedAllocation() { Release(); }
+
+	TrackedAllocation(const TrackedAllocation &other) { *this = other; }
+	TrackedAllocation &operator=(const TrackedAllocation &other)
+	{
+		if (this != &other) {
+			*this = other._active ? TrackedAllocation{other._tag, other._pool, other._bytes} : TrackedAllocation{};
+		}
+		return *this;
+	}
+	TrackedAllocation(TrackedAllocation &&other) noexcept { *this = std::move(other); }
+	TrackedAllocation &operator=(TrackedAllocation &&other) noexcept
+	{
+		if (this != &other) {
+			Release();
+			_tag = other._tag;
+			_pool = other._pool;
+			_bytes = other._bytes;
+			_active = other._active;
+			other._active = false;
+		}
+		return *this;
+	}
+
+	inline uint64_t GetBytes() const { return _active ? _bytes : 0; }
+
+  private:
+	inline void Release()
+	{
+		if (_active) {
+			MemoryTracker::Get().Free(_tag, _pool, _bytes);
+			_active = false;
+		}
+	}
+
+	MemoryTag _tag = MEMORY_TAG_SCENE;
+	MemoryPool _pool = MEMORY_POOL_CPU;
+	uint64_t _bytes = 0;
+	bool _active = false;
+};
+
+// Standard allocator that counts a container's heap blocks against TAG in the CPU pool
+template <typename T, MemoryTag TAG> class TrackedAllocator {
+  public:
+	using value_type = T;
+
+	template <typename U> struct rebind {
+		using other = TrackedAllocator<U, TAG>;
+	};
+
+	TrackedAllocator() = default;
+	template <typename U> TrackedAllocator(const TrackedAllocator<U, TAG> &) noexcept {}
+
+	T *allocate(size_t count)
+	{
+		T *data = std::allocator<T>{}.allocate(count);
+		MemoryTracker::Get().Allocate(TAG, MEMORY_POOL_CPU, count * sizeof(T));
+		return data;
+	}
+
+	void deallocate(T *data, size_t count) noexcept
+	{
+		MemoryTracker::Get().Free(TAG, MEMORY_POOL_CPU, count * sizeof(T));
+		std::allocator<T>{}.deallocate(data, count);
+	}
+
+	template <typename U> bool operator==(const TrackedAllocator<U, TAG> &) const noexcept { return true; }
+};
+
+} // namespace TGW
@@ -0,0 +1,267 @@
+#include "occluder_mesh.h"
+
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <unordered_set>
+
+using namespace DirectX;
+using namespace TGW::Cull;
+
+namespace {
+// Coarsest grid tried, one cell per axis would collapse everything
+constexpr uint32_t MIN_RESOLUTION = 2;
+// Cluster ids packed three to a key for the duplicate check
+constexpr uint32_t CLUSTER_BITS = 21;
+// How far, relative to the bounds diagonal, a surface may bend outwards and still count as convex
+constexpr float CONVEX_TOLERANCE = 1e-5f;
+
+// Mesh of every vertex snapped to its cell of a resolution^3 grid over the bounds
+void Cluster(std::span<const MeshData> meshes, const OccluderMesh &bounds, uint32_t resolution, std::vector<XMFLOAT3> &positions,
+	std::vector<uint32_t> &indices)
+{
+	positions.clear();
+	indices.clear();
+	const XMFLOAT3 low = bounds.boundsMin;
+	const XMFLOAT3 scale{resolution / std::max(bounds.boundsMax.x - low.x, 1e-6f),
+		resolution / std::max(bounds.boundsMax.y - low.y, 1e-6f), resolution / std::max(bounds.boundsMax.z - low.z, 1e-6f)};
+	const auto cell = [&](float value, float origin, float perUnit) {
+		return std::min(static_cast<uint32_t>((value - origin) * perUnit), resolution - 1);
+	};
+
+	std::unordered_map<uint32_t, uint32_t> clusters;
+	std::vector<uint32_t> counts;
+	std::vector<uint32_t> remap;
+	std::unordered_set<uint64_t> triangles;
+	for (const MeshData &mesh : meshes) {
+		remap.resize(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); i++) {
+			const XMFLOAT3 &p = mesh.vertices[i].position;
+			const uint32_t key = (cell(p.x, low.x, scale.x) * resolution + cell(p.y, low.y, scale.y)) * resolution +
+								 cell(p.z, low.z, scale.z);
+			const auto [it, added] = clusters.try_emplace(key, static_cast<uint32_t>(positions.size()));
+			if (added) {
+				positions.push_back({0.0f, 0.0f, 0.0f});
+				counts.push_back(0);
+			}
+			XMFLOAT3 &sum = positions[it->second];
+			sum = {sum.x + p.x, sum.y + p.y, sum.z + p.z};
+			counts[it->second]++;
+			remap[i] = it->second;
+		}
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			std::array<uint32_t, 3> corners{remap[mesh.indices[i]], remap[mesh.indices[i + 1]], remap[mesh.indices[i + 2]]};
+			if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2]) {
+				continue;
+			}
+			// Smallest id first keeps the winding, so only the same triangle facing the same way is a duplicate
+			std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+			const uint64_t key =
+				(uint64_t{corners[0]} << (2 * CLUSTER_BITS)) | (uint64_t{corners[1]} << CLUSTER_BITS) | corners[2];
+			if (triangles.insert(key).second) {
+				indices.insert(indices.end(), corners.begin(), corners.end());
+			}
+		}
+	}
+
+	// Clusters of collapsed triangles only are dropped, the rasterizer transforms every position
+	std::vector<uint32_t> kept(positions.size(), UINT32_MAX);
+	std::vector<XMFLOAT3> means;
+	for (uint32_t &index : indices) {
+		if (kept[index] == UINT32_MAX) {
+			const float inverse = 1.0f / counts[index];
+			kept[index] = static_cast<uint32_t>(means.size());
+			means.push_back({positions[index].x * inverse, positions[index].y * inverse, positions[index].z * inverse});
+		}
+		index = kept[index];
+	}
+	positions = std::move(means);
+}
+
+// Every mesh of the model as one, with vertices at the same position merged, seams split them
+struct WeldedMesh {
+	std::vector<XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+};
+
+WeldedMesh Weld(std::span<const MeshData> meshes)
+{
+	struct Corner {
+		XMFLOAT3 position;
+		uint32_t vertex;
+	};
+	std::vector<Corner> corners;
+	for (const MeshData &mesh : meshes) {
+		for (const Vertex &vertex : mesh.vertices) {
+			corners.push_back({vertex.position, static_cast<uint32_t>(corners.size())});
+		}
+	}
+	const auto less = [](const Corner &a, const Corner &b) {
+		return std::tie(a.position.x, a.position.y, a.position.z) < std::tie(b.position.x, b.position.y, b.position.z);
+	};
+	std::sort(corners.begin(), corners.end(), less);
+
+	WeldedMesh welded;
+	std::vector<uint32_t> remap(corners.size());
+	for (size_t i = 0; i < corners.size(); i++) {
+		if (i == 0 || less(corners[i - 1], corners[i])) {
+			welded.positions.push_back(corners[i].position);
+		}
+		remap[corners[i].vertex] = static_cast<uint32_t>(welded.positions.size() - 1);
+	}
+
+	uint32_t first = 0;
+	for (const MeshData &mesh : meshes) {
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			const uint32_t a = remap[first + mesh.indices[i]], b = remap[first + mesh.indices[i + 1]],
+						   c = remap[first + mesh.indices[i + 2]];
+			if (a != b && b != c && a != c) {
+				welded.indices.insert(welded.indices.end(), {a, b, c});
+			}
+		}
+		first += static_cast<uint32_t>(mesh.vertices.size());
+	}
+	return welded;
+}
+
+// Whether the mesh bounds a convex solid: every edge has its twin running the other way, the triangle across any
+// edge stays on the same side of the plane of the one before it, and everything hangs together. A closed surface
+// that is convex at every edge is convex as a whole. Either winding passes, as long as it is the same throughout.
+bool IsClosedConvex(const WeldedMesh &mesh, float tolerance)
+{
+	struct HalfEdge {
+		uint64_t key;
+		uint32_t triangle;
+		uint32_t opposite;
+	};
+	const uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+	if (triangleCount == 0) {
+		return false;
+	}
+
+	std::vector<XMFLOAT3> normals(triangleCount);
+	std::vector<HalfEdge> edges;
+	edges.reserve(mesh.indices.size());
+	std::vector<uint32_t> parents(mesh.positions.size());
+	std::iota(parents.begin(), parents.end(), 0);
+	const auto root = [&](uint32_t vertex) {
+		while (parents[vertex] != vertex) {
+			vertex = parents[vertex] = parents[parents[vertex]];
+		}
+		return vertex;
+	};
+
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		const uint32_t *corners = &mesh.indices[size_t{t} * 3];
+		const XMVECTOR p0 = XMLoadFloat3(&mesh.positions[corners[0]]);
+		const XMVECTOR p1 = XMLoadFloat3(&mesh.positions[corners[1]]);
+		const XMVECTOR p2 = XMLoadFloat3(&mesh.positions[corners[2]]);
+		XMStoreFloat3(&normals[t], XMVector3Normalize(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+		for (uint32_t k = 0; k < 3; k++) {
+			const uint32_t from = corners[k], to = corners[(k + 1) % 3];
+			edges.push_back({(uint64_t{from} << 32) | to, t, corners[(k + 2) % 3]});
+			parents[root(from)] = root(to);
+		}
+	}
+
+	const auto byKey = [](const HalfEdge &a, const HalfEdge &b) { return a.key < b.key; };
+	std::sort(edges.begin(), edges.end(), byKey);
+	float lowest = 0.0f, highest = 0.0f;
+	for (const HalfEdge &edge : edges) {
+		const uint32_t from = static_cast<uint32_t>(edge.key >> 32), to = static_cast<uint32_t>(edge.key);
+		const HalfEdge twinKey{(uint64_t{to} << 32) | from, 0, 0};
+		const auto [begin, end] = std::equal_range(edges.begin(), edges.end(), twinKey, byKey);
+		if (begin == end) {
+			return false;
+		}
+		const XMVECTOR normal = XMLoadFloat3(&normals[edge.triangle]);
+		const XMVECTOR origin = XMLoadFloat3(&mesh.positions[from]);
+		for (auto twin = begin; twin != end; twin++) {
+			const XMVECTOR across = XMVectorSubtract(XMLoadFloat3(&mesh.positions[twin->opposite]), origin);
+			const float height = XMVectorGetX(XMVector3Dot(normal, across));
+			lowest = std::min(lowest, height);
+			highest = std::max(highest, height);
+			if (highest > tolerance && lowest < -tolerance) {
+				return false;
+			}
+		}
+	}
+
+	const uint32_t component = root(mesh.indices[0]);
+	return std::all_of(mesh.indices.begin(), mesh.indices.end(), [&](uint32_t vertex) { return root(vertex) == component; });
+}
+
+// The model's own triangles, largest first. Part of the real surface hides nothing the model does not.
+void KeepLargestTriangles(const WeldedMesh &mesh, uint32_t maxTriangles, OccluderMesh &occluder)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(mesh.indices.size() / 3);
+	std::vector<float> areas(triangleCount);
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		const XMVECTOR p0 = XMLoadFloat3(&mesh.positions[mesh.indices[size_t{t} * 3]]);
+		const XMVECTOR p1 = XMLoadFloat3(&mesh.positions[mesh.indices[size_t{t} * 3 + 1]]);
+		const XMVECTOR p2 = XMLoadFloat3(&mesh.positions[mesh.indices[size_t{t} * 3 + 2]]);
+		areas[t] = XMVectorGetX(XMVector3Length(XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+	}
+
+	std::vector<uint32_t> order(triangleCount);
+	std::iota(order.begin(), order.end(), 0);
+	const auto middle = order.begin() + std::min(maxTriangles, triangleCount);
+	// Equal areas keep model order, so the same model always gives the same occluder
+	std::partial_sort(order.begin(), middle, order.end(), [&](uint32_t a, uint32_t b) {
+		return areas[a] != areas[b] ? areas[a] > areas[b] : a < b;
+	});
+
+	std::vector<uint32_t> kept(mesh.positions.size(), UINT32_MAX);
+	for (auto t = order.begin(); t != middle && areas[*t] > 0.0f; t++) {
+		for (uint32_t k = 0; k < 3; k++) {
+			uint32_t &index = kept[mesh.indices[size_t{*t} * 3 + k]];
+			if (index == UINT32_MAX) {
+				index = static_cast<uint32_t>(occluder.positions.size());
+				occluder.positions.push_back(mesh.positions[mesh.indices[size_t{*t} * 3 + k]]);
+			}
+			occluder.indices.push_back(index);
+		}
+	}
+}
+} // namespace
+
+OccluderMesh TGW::Cull::BuildOccluderMesh(std::span<const MeshData> meshes, const OccluderSettings &settings)
+{
+	OccluderMesh occluder;
+	XMVECTOR low = XMVectorReplicate(std::numeric_limits<float>::max());
+	XMVECTOR high = XMVectorNegate(low);
+	bool hasVertices = false;
+	for (const MeshData &mesh : meshes) {
+		for (const Vertex &vertex : mesh.vertices) {
+			const XMVECTOR p = XMLoadFloat3(&vertex.position);
+			low = XMVectorMin(low, p);
+			high = XMVectorMax(high, p);
+			hasVertices = true;
+		}
+	}
+	if (!hasVertices) {
+		return occluder;
+	}
+	XMStoreFloat3(&occluder.boundsMin, low);
+	XMStoreFloat3(&occluder.boundsMax, high);
+
+	const WeldedMesh welded = Weld(meshes);
+	const float tolerance = CONVEX_TOLERANCE * XMVectorGetX(XMVector3Length(XMVectorSubtract(high, low)));
+	if (IsClosedConvex(welded, tolerance)) {
+		std::vector<XMFLOAT3> positions;
+		std::vector<uint32_t> indices;
+		const uint32_t finest = std::min(settings.maxResolution, 1u << (CLUSTER_BITS / 3));
+		for (uint32_t resolution = finest; resolution >= MIN_RESOLUTION; resolution /= 2) {
+			Cluster(meshes, occluder, resolution, positions, indices);
+			if (indices.size() / 3 <= settings.maxTriangles) {
+				occluder.positions = std::move(positions);
+				occluder.indices = std::move(indices);
+				return occluder;
+			}
+		}
+	}
+
+	KeepLargestTriangles(welded, settings.maxTriangles, occluder);
+	return occluder;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "mesh_data.h"
+
+#include <span>
+
+namespace TGW::Cull {
+
+struct OccluderSettings {
+	// Most triangles an occluder keeps, the clustering grid is refined while the result stays under this
+	uint32_t maxTriangles = 128;
+	// Finest clustering grid, cells per axis over the bounds
+	uint32_t maxResolution = 64;
+};
+
+// Low poly stand-in of a model for the CPU depth rasterizer, in the model's own space
+struct OccluderMesh {
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+	// Of the full model, what occlusion tests of the model itself use
+	DirectX::XMFLOAT3 boundsMin{0.0f, 0.0f, 0.0f};
+	DirectX::XMFLOAT3 boundsMax{0.0f, 0.0f, 0.0f};
+
+	inline bool IsEmpty() const { return indices.empty(); }
+	inline uint32_t GetTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+};
+
+// Simplifies every mesh of a model together into an occluder that hides nothing the model does not. A closed, convex
+// model is clustered: vertices falling in the same grid cell merge into their mean and collapsed triangles go. Means
+// lie inside the hull of what they replace, which is inside the solid. Clustering anything else could bridge a notch
+// or an open side, so other models, and convex ones no grid fits, keep their largest own triangles instead.
+// Empty only without triangles.
+OccluderMesh BuildOccluderMesh(std::span<const MeshData> meshes, const OccluderSettings &settings = {});
+
+} // namespace TGW::Cull
@@ -0,0 +1,260 @@
+#include "occlusion_culler.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+using namespace TGW::Cull;
+
+namespace {
+constexpr uint32_t TILE_WIDTH = 32;
+constexpr uint32_t TILE_HEIGHT = 16;
+constexpr uint32_t BLOCK_SIZE = 8;
+constexpr uint32_t LANES = 4;
+constexpr uint32_t OCCLUDERS_PER_BATCH = 16;
+static_assert(TILE_WIDTH % BLOCK_SIZE == 0 && TILE_HEIGHT % BLOCK_SIZE == 0 && BLOCK_SIZE % LANES == 0);
+
+inline uint32_t RoundUp(uint32_t value, uint32_t multiple) { return (std::max(value, 1u) + multiple - 1) / multiple * multiple; }
+
+inline float GetLargestLane(FXMVECTOR v)
+{
+	XMFLOAT4 lanes;
+	XMStoreFloat4(&lanes, v);
+	return std::max({lanes.x, lanes.y, lanes.z, lanes.w});
+}
+} // namespace
+
+/* Implementation of public functions */
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+	: _width{RoundUp(width, TILE_WIDTH)}, _height{RoundUp(height, TILE_HEIGHT)}, _tilesX{_width / TILE_WIDTH},
+	  _tilesY{_height / TILE_HEIGHT}, _blocksX{_width / BLOCK_SIZE}
+{
+	_depth.assign(size_t{_width} * _height, 1.0f);
+	_blockMax.assign(size_t{_blocksX} * (_height / BLOCK_SIZE), 1.0f);
+	_bins.resize(size_t{_tilesX} * _tilesY);
+}
+
+void OcclusionCuller::RenderOccluders(FXMMATRIX viewProjection, std::span<const OccluderInstance> occluders, JobSystem &jobs)
+{
+	XMStoreFloat4x4(&_viewProjection, viewProjection);
+
+	// Every occluder sets its triangles up into its own range, in parallel
+	_firstTriangles.resize(occluders.size() + 1);
+	uint32_t total = 0;
+	for (size_t i = 0; i < occluders.size(); i++) {
+		_firstTriangles[i] = total;
+		total += occluders[i].mesh ? occluders[i].mesh->GetTriangleCount() : 0;
+	}
+	_firstTriangles[occluders.size()] = total;
+	_triangles.resize(total);
+	jobs.ParallelFor(static_cast<uint32_t>(occluders.size()), OCCLUDERS_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		std::vector<XMFLOAT3> projected;
+		for (uint32_t i = begin; i < end; i++) {
+			SetupTriangles(occluders[i], _firstTriangles[i], projected);
+		}
+	});
+
+	// Binning is serial and cheap, most triangles of a low poly occluder touch one or two tiles
+	for (std::vector<uint32_t> &bin : _bins) {
+		bin.clear();
+	}
+	_rasterizedCount = 0;
+	for (uint32_t i = 0; i < total; i++) {
+		const Triangle &triangle = _triangles[i];
+		if (triangle.minX > triangle.maxX) {
+			continue;
+		}
+		_rasterizedCount++;
+		for (int32_t y = triangle.minY / TILE_HEIGHT; y <= triangle.maxY / static_cast<int32_t>(TILE_HEIGHT); y++) {
+			for (int32_t x = triangle.minX / TILE_WIDTH; x <= triangle.maxX / static_cast<int32_t>(TILE_WIDTH); x++) {
+				_bins[y * _tilesX + x].push_back(i);
+			}
+		}
+	}
+
+	// Tiles own their pixels and blocks, so they rasterize without any locking
+	jobs.ParallelFor(_tilesX * _tilesY, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t tile = begin; tile < end; tile++) {
+			RasterizeTile(tile);
+		}
+	});
+}
+
+bool OcclusionCuller::IsVisible(const XMFLOAT3 &boundsMin, const XMFLOAT3 &boundsMax, FXMMATRIX world) const
+{
+	const XMMATRIX transform = XMMatrixMultiply(world, XMLoadFloat4x4(&_viewProjection));
+	float minX = std::numeric_limits<float>::max(), minY = minX, minZ = minX;
+	float maxX = -minX, maxY = -minX;
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		const XMVECTOR point = XMVectorSet(corner & 1 ? boundsMax.x : boundsMin.x, corner & 2 ? boundsMax.y : boundsMin.y,
+			corner & 4 ? boundsMax.z : boundsMin.z, 1.0f);
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(point, transform));
+		// Reaches past the near plane, nothing can be said about it
+		if (clip.w <= 0.0f || clip.z < 0.0f) {
+			return true;
+		}
+		const float inverseW = 1.0f / clip.w;
+		const float x = (clip.x * inverseW * 0.5f + 0.5f) * _width, y = (0.5f - clip.y * inverseW * 0.5f) * _height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		minZ = std::min(minZ, clip.z * inverseW);
+	}
+	if (maxX <= 0.0f || maxY <= 0.0f || minX >= _width || minY >= _height || minZ > 1.0f) {
+		return false;
+	}
+
+	const uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0f)), y0 = static_cast<uint32_t>(std::max(minY, 0.0f));
+	const uint32_t x1 = static_cast<uint32_t>(std::ceil(std::min(maxX, static_cast<float>(_width)))) - 1;
+	const uint32_t y1 = static_cast<uint32_t>(std::ceil(std::min(maxY, static_cast<float>(_height)))) - 1;
+	for (uint32_t blockY = y0 / BLOCK_SIZE; blockY <= y1 / BLOCK_SIZE; blockY++) {
+		for (uint32_t blockX = x0 / BLOCK_SIZE; blockX <= x1 / BLOCK_SIZE; blockX++) {
+			if (minZ > _blockMax[blockY * _blocksX + blockX]) {
+				continue;
+			}
+			// Not behind the whole block, maybe behind the pixels of it the box covers
+			const uint32_t lastY = std::min(y1, blockY * BLOCK_SIZE + BLOCK_SIZE - 1);
+			const uint32_t lastX = std::min(x1, blockX * BLOCK_SIZE + BLOCK_SIZE - 1);
+			for (uint32_t y = std::max(y0, blockY * BLOCK_SIZE); y <= lastY; y++) {
+				for (uint32_t x = std::max(x0, blockX * BLOCK_SIZE); x <= lastX; x++) {
+					if (minZ <= _depth[size_t{y} * _width + x]) {
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+/* Implementation of private functions */
+
+void OcclusionCuller::SetupTriangles(const OccluderInstance &occluder, uint32_t first, std::vector<XMFLOAT3> &projected)
+{
+	if (!occluder.mesh) {
+		return;
+	}
+	const OccluderMesh &mesh = *occluder.mesh;
+	const XMMATRIX transform = XMMatrixMultiply(XMLoadFloat4x4(&occluder.world), XMLoadFloat4x4(&_viewProjection));
+	const float width = static_cast<float>(_width), height = static_cast<float>(_height);
+
+	// Screen x and y with z / w, w <= 0 and points past the near plane as NaN x so their triangles get skipped
+	projected.resize(mesh.positions.size());
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(XMLoadFloat3(&mesh.positions[i]), 1.0f), transform));
+		if (clip.w <= 0.0f || clip.z < 0.0f) {
+			projected[i] = {std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f};
+			continue;
+		}
+		const float inverseW = 1.0f / clip.w;
+		projected[i] = {(clip.x * inverseW * 0.5f + 0.5f) * width, (0.5f - clip.y * inverseW * 0.5f) * height, clip.z * inverseW};
+	}
+
+	for (uint32_t t = 0; t < mesh.GetTriangleCount(); t++) {
+		Triangle &triangle = _triangles[first + t];
+		triangle.minX = 1;
+		triangle.maxX = 0;
+		const XMFLOAT3 &a = projected[mesh.indices[3 * t]];
+		const XMFLOAT3 &b = projected[mesh.indices[3 * t + 1]];
+		const XMFLOAT3 &c = projected[mesh.indices[3 * t + 2]];
+		if (std::isnan(a.x) || std::isnan(b.x) || std::isnan(c.x)) {
+			continue;
+		}
+		// Clockwise on screen faces the camera, as with D3D's default rasterizer state
+		const float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+		if (!(area > 0.0f)) {
+			continue;
+		}
+		// Clamped as floats first, corners far off screen do not fit an int
+		const auto toPixel = [](float value, float limit) { return static_cast<int32_t>(std::clamp(value, -1.0f, limit)); };
+		const int32_t minX = std::max(toPixel(std::ceil(std::min({a.x, b.x, c.x}) - 0.5f), width), 0);
+		const int32_t minY = std::max(toPixel(std::ceil(std::min({a.y, b.y, c.y}) - 0.5f), height), 0);
+		const int32_t maxX =
+			std::min(toPixel(std::floor(std::max({a.x, b.x, c.x}) - 0.5f), width), static_cast<int32_t>(_width) - 1);
+		const int32_t maxY =
+			std::min(toPixel(std::floor(std::max({a.y, b.y, c.y}) - 0.5f), height), static_cast<int32_t>(_height) - 1);
+		if (minX > maxX || minY > maxY) {
+			continue;
+		}
+
+		const std::array<const XMFLOAT3 *, 3> corners{&a, &b, &c};
+		for (uint32_t edge = 0; edge < 3; edge++) {
+			const XMFLOAT3 &from = *corners[edge], &to = *corners[(edge + 1) % 3];
+			triangle.edgeA[edge] = from.y - to.y;
+			triangle.edgeB[edge] = to.x - from.x;
+			triangle.edgeC[edge] = (to.y - from.y) * from.x - (to.x - from.x) * from.y;
+		}
+		const float inverseArea = 1.0f / area;
+		triangle.depthA = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) * inverseArea;
+		triangle.depthB = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) * inverseArea;
+		triangle.depthC = a.z - triangle.depthA * a.x - triangle.depthB * a.y;
+		triangle.minX = minX;
+		triangle.minY = minY;
+		triangle.maxX = maxX;
+		triangle.maxY = maxY;
+	}
+}
+
+void OcclusionCuller::RasterizeTile(uint32_t tile)
+{
+	const int32_t tileX = static_cast<int32_t>(tile % _tilesX * TILE_WIDTH);
+	const int32_t tileY = static_cast<int32_t>(tile / _tilesX * TILE_HEIGHT);
+	for (int32_t y = tileY; y < tileY + static_cast<int32_t>(TILE_HEIGHT); y++) {
+		std::fill_n(_depth.begin() + size_t(y) * _width + tileX, TILE_WIDTH, 1.0f);
+	}
+
+	const XMVECTOR laneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const XMVECTOR laneStep = XMVectorReplicate(static_cast<float>(LANES));
+	const XMVECTOR zero = XMVectorZero();
+	for (uint32_t index : _bins[tile]) {
+		const Triangle &triangle = _triangles[index];
+		const int32_t minX = std::max(triangle.minX, tileX) & ~static_cast<int32_t>(LANES - 1);
+		const int32_t maxX = std::min(triangle.maxX, tileX + static_cast<int32_t>(TILE_WIDTH) - 1);
+		const int32_t minY = std::max(triangle.minY, tileY);
+		const int32_t maxY = std::min(triangle.maxY, tileY + static_cast<int32_t>(TILE_HEIGHT) - 1);
+		const XMVECTOR edgeA0 = XMVectorReplicate(triangle.edgeA[0]);
+		const XMVECTOR edgeA1 = XMVectorReplicate(triangle.edgeA[1]);
+		const XMVECTOR edgeA2 = XMVectorReplicate(triangle.edgeA[2]);
+		const XMVECTOR depthA = XMVectorReplicate(triangle.depthA);
+		const XMVECTOR startX = XMVectorAdd(XMVectorReplicate(static_cast<float>(minX)), laneOffsets);
+
+		for (int32_t y = minY; y <= maxY; y++) {
+			const float centerY = y + 0.5f;
+			const XMVECTOR row0 = XMVectorReplicate(triangle.edgeB[0] * centerY + triangle.edgeC[0]);
+			const XMVECTOR row1 = XMVectorReplicate(triangle.edgeB[1] * centerY + triangle.edgeC[1]);
+			const XMVECTOR row2 = XMVectorReplicate(triangle.edgeB[2] * centerY + triangle.edgeC[2]);
+			const XMVECTOR rowDepth = XMVectorReplicate(triangle.depthB * centerY + triangle.depthC);
+			float *depthRow = _depth.data() + size_t(y) * _width;
+			XMVECTOR centerX = startX;
+			for (int32_t x = minX; x <= maxX; x += LANES, centerX = XMVectorAdd(centerX, laneStep)) {
+				const XMVECTOR inside = XMVectorAndInt(
+					XMVectorAndInt(XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA0, centerX, row0), zero),
+						XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA1, centerX, row1), zero)),
+					XMVectorGreaterOrEqual(XMVectorMultiplyAdd(edgeA2, centerX, row2), zero));
+				XMFLOAT4 *pixels = reinterpret_cast<XMFLOAT4 *>(depthRow + x);
+				const XMVECTOR depth = XMLoadFloat4(pixels);
+				const XMVECTOR nearest = XMVectorMin(depth, XMVectorMultiplyAdd(depthA, centerX, rowDepth));
+				XMStoreFloat4(pixels, XMVectorSelect(depth, nearest, inside));
+			}
+		}
+	}
+
+	// Farthest depth of every block of the tile
+	for (uint32_t blockY = 0; blockY < TILE_HEIGHT / BLOCK_SIZE; blockY++) {
+		for (uint32_t blockX = 0; blockX < TILE_WIDTH / BLOCK_SIZE; blockX++) {
+			const uint32_t x = tileX + blockX * BLOCK_SIZE, y = tileY + blockY * BLOCK_SIZE;
+			XMVECTOR farthest = zero;
+			for (uint32_t row = y; row < y + BLOCK_SIZE; row++) {
+				for (uint32_t lane = 0; lane < BLOCK_SIZE; lane += LANES) {
+					const float *pixels = &_depth[size_t{row} * _width + x + lane];
+					farthest = XMVectorMax(farthest, XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(pixels)));
+				}
+			}
+			_blockMax[(y / BLOCK_SIZE) * _blocksX + x / BLOCK_SIZE] = GetLargestLane(farthest);
+		}
+	}
+}
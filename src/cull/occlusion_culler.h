@@ -0,0 +1,75 @@
+#pragma once
+
+#include "core/job_system.h"
+#include "occluder_mesh.h"
+
+namespace TGW::Cull {
+
+struct OccluderInstance {
+	const OccluderMesh *mesh = nullptr;
+	DirectX::XMFLOAT4X4 world{};
+};
+
+// Software occlusion culling. Occluders are rasterized into a small depth buffer on the CPU, screen tiles spread
+// over the job system and four pixels at a time, then every 8x8 block keeps the farthest depth in it. A box is
+// hidden when it lies behind that for every block its screen rect touches, blocks it is not clearly behind fall
+// back to their pixels.
+//
+// Depth follows D3D: z / w in [0, 1], nearer is smaller, pixels are sampled at their centres. Occluder triangles
+// crossing the near plane or facing away are skipped, which only ever makes the buffer emptier, so culling stays
+// conservative as long as the occluders are inside what they stand for.
+class OcclusionCuller {
+  public:
+	// Rounded up to whole tiles
+	explicit OcclusionCuller(uint32_t width = 320, uint32_t height = 192);
+
+	// Clears the buffer and rasterizes occluders as seen through viewProjection
+	void RenderOccluders(
+		DirectX::FXMMATRIX viewProjection, std::span<const OccluderInstance> occluders, JobSystem &jobs = JobSystem::Get());
+
+	// False when the box, in the space of world, is off screen or certainly behind the occluders of the last
+	// RenderOccluders
+	bool IsVisible(const DirectX::XMFLOAT3 &boundsMin, const DirectX::XMFLOAT3 &boundsMax, DirectX::FXMMATRIX world) const;
+
+	inline uint32_t GetWidth() const { return _width; }
+	inline uint32_t GetHeight() const { return _height; }
+	// Row-major, GetWidth() * GetHeight() depths
+	inline std::span<const float> GetDepth() const { return _depth; }
+	// Occluder triangles that made it through setup in the last RenderOccluders
+	inline uint32_t GetRasterizedTriangleCount() const { return _rasterizedCount; }
+
+  private:
+	// Edge functions a * x + b * y + c, non-negative inside, and depth plane in pixel coordinates
+	struct Triangle {
+		std::array<float, 3> edgeA;
+		std::array<float, 3> edgeB;
+		std::array<float, 3> edgeC;
+		float depthA;
+		float depthB;
+		float depthC;
+		// Pixels whose centres the bounds cover, inclusive. minX > maxX marks a skipped triangle.
+		int32_t minX;
+		int32_t minY;
+		int32_t maxX;
+		int32_t maxY;
+	};
+
+	void SetupTriangles(const OccluderInstance &occluder, uint32_t first, std::vector<DirectX::XMFLOAT3> &projected);
+	void RasterizeTile(uint32_t tile);
+
+	uint32_t _width;
+	uint32_t _height;
+	uint32_t _tilesX;
+	uint32_t _tilesY;
+	uint32_t _blocksX;
+	uint32_t _rasterizedCount = 0;
+	DirectX::XMFLOAT4X4 _viewProjection{};
+
+	std::vector<float> _depth;
+	std::vector<float> _blockMax; // farthest depth of every 8x8 block
+	std::vector<Triangle> _triangles;
+	std::vector<std::vector<uint32_t>> _bins; // triangles touching every tile, in submission order
+	std::vector<uint32_t> _firstTriangles;
+};
+
+} // namespace TGW::Cull
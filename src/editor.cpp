@@ -1,4 +1,7 @@
 #include "editor.h"
+#include "cook/cook_cache.h"
+#include "core/job_system.h"
+#include "scene/scene_file.h"
 #include "shaders.h"
 
 #include <log.h>
@@ -7,6 +10,9 @@
 
 using namespace DirectX;
 constexpr float CLEAR_COLOR[] = {0.1f, 0.2f, 0.6f, 1.0f};
+constexpr auto CONTENT_DIR = "content";
+constexpr auto ARCHIVE_EXTENSION = ".pak";
+constexpr auto TERRAIN_FILE = "content/terrain.r16";
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -82,7 +88,9 @@ TGW::Editor::Editor(HINSTANCE hInstance)
 	ASSERT_SUCCEEDED(_device->CreateDepthStencilView(depthBuffer.Get(), nullptr, &_dsv));
 
 	CreateGUI();
-	_assetLoader = AssetLoader{_device.Get()};
+	MountArchives();
+	LoadTexturePlan();
+	_assetLoader = AssetLoader{_device.Get(), &_materialArrays, &_geometry, &_archives};
 }
 
 void TGW::Editor::Run(int nCmdShow)
@@ -140,13 +148,65 @@ void TGW::Editor::Render()
 	_context->OMSetRenderTargets(1, _rtv.GetAddressOf(), _dsv.Get());
 	_context->ClearRenderTargetView(_rtv.Get(), CLEAR_COLOR);
 	_context->ClearDepthStencilView(_dsv.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+
+	FogConstantBuffer fog;
+	if (_fog && _fogTexture.Update(_device.Get(), _context.Get(), *_fog, _fogPlayer)) {
+		fog = _fogTexture.GetConstants();
+	}
+	ID3D11ShaderResourceView *fogSrv = fog.enabled ? _fogTexture.GetSRV() : nullptr;
+	_context->UpdateSubresource(_cbFog.Get(), 0, nullptr, &fog, 0, 0);
+	_context->PSSetConstantBuffers(1, 1, _cbFog.GetAddressOf());
+	_context->PSSetShaderResources(4, 1, &fogSrv);
+	_context->PSSetSamplers(1, 1, _fogSampler.GetAddressOf());
+
+	LightConstantBuffer lighting;
+	std::array<ID3D11ShaderResourceView *, 3> lightSrvs{};
+	D3D11_VIEWPORT viewport{};
+	UINT viewportCount = 1;
+	_context->RSGetViewports(&viewportCount, &viewport);
+	if (_lights && !_lights->empty() &&
+		_lightBuffers.Update(_device.Get(), _context.Get(), _camera, viewport.Width, viewport.Height, *_lights)) {
+		lighting = _lightBuffers.GetConstants();
+		lightSrvs = _lightBuffers.GetSRVs();
+	}
+	_context->UpdateSubresource(_cbLights.Get(), 0, nullptr, &lighting, 0, 0);
+	_context->PSSetConstantBuffers(2, 1, _cbLights.GetAddressOf());
+	_context->PSSetShaderResources(5, static_cast<UINT>(lightSrvs.size()), lightSrvs.data());
+
+	// Every material and texture for the whole frame, draws only pick their material index
+	_materialArrays.Update(_device.Get(), _context.Get());
+	const auto materialSrvs = _materialArrays.GetSRVs();
+	_context->PSSetShaderResources(MaterialArrays::FIRST_SLOT, static_cast<UINT>(materialSrvs.size()), materialSrvs.data());
+
+	if (_terrainRenderer.IsCreated()) {
+		_context->RSSetState(_rasterState.Get());
+		_terrainRenderer.Render(_context.Get(), _camera, _terrainTree);
+	}
+
 	_context->IASetInputLayout(_inputLayout.Get());
 	_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	_context->VSSetShader(_vs.Get(), nullptr, 0);
 	_context->PSSetShader(_ps.Get(), nullptr, 0);
 	_context->PSSetSamplers(0, 1, _sampler.GetAddressOf());
+	_context->VSSetConstantBuffers(0, 1, _cbMVP.GetAddressOf());
+	_context->PSSetConstantBuffers(0, 1, _cbMVP.GetAddressOf());
+
+	_occluders.clear();
+	for (const auto &[id, model] : _models) {
+		if (!model.occluder.IsEmpty()) {
+			Cull::OccluderInstance &occluder = _occluders.emplace_back();
+			occluder.mesh = &model.occluder;
+			DirectX::XMStoreFloat4x4(&occluder.world, model.worldMatrix);
+		}
+	}
+	_occlusion.RenderOccluders(DirectX::XMMatrixMultiply(_camera.GetViewMatrix(), _camera.GetProjectionMatrix()), _occluders);
 
 	for (const auto &[id, model] : _models) {
+		const bool selected = _selectedModel && id == _selectedModel.value();
+		if (!selected && !_occlusion.IsVisible(model.occluder.boundsMin, model.occluder.boundsMax, model.worldMatrix)) {
+			continue;
+		}
+
 		ConstantBuffer cb{
 		  .model = DirectX::XMMatrixTranspose(model.worldMatrix),
 		  .view = DirectX::XMMatrixTranspose(_camera.GetViewMatrix()),
@@ -154,65 +214,94 @@ void TGW::Editor::Render()
 		};
 		DirectX::XMStoreFloat3(&cb.cameraPos, _camera.GetPosition());
 
-		if (_selectedModel && id == _selectedModel.value()) {
+		if (selected) {
 			cb.isSelected = 1.0f;
-			_context->UpdateSubresource(_cbMVP.Get(), 0, nullptr, &cb, 0, 0);
-			_context->VSSetConstantBuffers(0, 1, _cbMVP.GetAddressOf());
-			_context->PSSetConstantBuffers(0, 1, _cbMVP.GetAddressOf());
 			_context->RSSetState(_rasterStateOutline.Get());
-			DrawModel(model); // outline
+			DrawModel(model, cb); // outline
 		}
 
 		cb.isSelected = 0.0f;
-		_context->UpdateSubresource(_cbMVP.Get(), 0, nullptr, &cb, 0, 0);
-		_context->VSSetConstantBuffers(0, 1, _cbMVP.GetAddressOf());
-		_context->PSSetConstantBuffers(0, 1, _cbMVP.GetAddressOf());
 		_context->RSSetState(_rasterState.Get());
-		DrawModel(model);
+		DrawModel(model, cb);
+	}
+
+	// Last, blended over everything solid
+	if (_particles && _particleRenderer.IsCreated()) {
+		_particleRenderer.Render(_device.Get(), _context.Get(), _camera, *_particles);
+		_context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
+		_context->OMSetDepthStencilState(nullptr, 0);
 	}
 
 	_gui->Render();
 	ASSERT_SUCCEEDED(_swapchain->Present(1, 0));
 }
-void TGW::Editor::DrawModel(const Model &model)
+void TGW::Editor::DrawModel(const Model &model, ConstantBuffer &cb)
 {
-	for (const auto &mesh : model.meshes) {
-		const Material &material = model.materials[mesh.materialIndex];
-		std::array<ID3D11ShaderResourceView *, 4> srvs = {
-		  material.diffuse ? material.diffuse.Get() : nullptr, material.specular ? material.specular.Get() : nullptr,
-		  material.normal ? material.normal.Get() : nullptr, material.roughness ? material.roughness.Get() : nullptr};
-
-		_context->PSSetShaderResources(0, srvs.size(), srvs.data());
+	for (size_t i = 0; i < model.meshes.size(); i++) {
+		const MeshBuffer &mesh = model.meshes[i];
+		const uint32_t material = mesh.materialIndex < model.materials.size() ? model.materials[mesh.materialIndex] : 0;
+		if (i == 0 || material != cb.materialIndex) {
+			cb.materialIndex = material;
+			_context->UpdateSubresource(_cbMVP.Get(), 0, nullptr, &cb, 0, 0);
+		}
 
 		UINT stride = sizeof(Vertex);
 		UINT offset = 0;
-		_context->IASetVertexBuffers(0, 1, mesh.vertexBuffer.GetAddressOf(), &stride, &offset);
-		_context->IASetIndexBuffer(mesh.indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		_context->IASetVertexBuffers(0, 1, mesh.geometry->vertexBuffer.GetAddressOf(), &stride, &offset);
+		_context->IASetIndexBuffer(mesh.geometry->indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
 		_context->DrawIndexed(mesh.indexCount, 0, 0);
 	}
 }
 
 void TGW::Editor::Update()
 {
-	_camera.HandleMouse(_hwnd);
+	const CameraMouseInput mouse = _camera.HandleMouse(_hwnd);
+	if (_recorder && mouse.orbit) {
+		_recorder->Orbit(*mouse.orbit);
+	}
+	if (_recorder && (mouse.panRight != 0 || mouse.panForward != 0)) {
+		_recorder->Pan(mouse.panRight, mouse.panForward);
+	}
 	_matView = _camera.GetViewMatrix();
+	if (_ai) {
+		_ai->Tick();
+	}
 
 	std::vector<TGW::GUI::AssetMetadata> assetsMetadata;
-	for (const auto &model : _models) {
+	for (const auto &[id, model] : _models) {
+		uint64_t meshBytes = 0;
+		for (const MeshBuffer &mesh : model.meshes) {
+			meshBytes += mesh.geometry ? mesh.geometry->memory.GetBytes() : 0;
+		}
 		assetsMetadata.push_back(TGW::GUI::AssetMetadata{
-		  .id = model.second.id,
-		  .name = model.second.name,
+		  .id = model.id,
+		  .name = model.name,
+		  .meshBytes = meshBytes,
+		  .textureBytes = model.textureBytes,
+		  .sceneBytes = model.occluderMemory.GetBytes(),
 		});
 	}
 
-	_gui->Update(TGW::GUI::EditorMetadata{assetsMetadata});
+	_gui->Update(TGW::GUI::EditorMetadata{.assets = assetsMetadata, .geometry = _geometry.GetStats(), .ai = _ai});
 	if (auto selectedModelId = _selectedModel) {
-		_gui->UpdateGizmo(_models[selectedModelId.value()], _camera);
+		Model &model = _models[selectedModelId.value()];
+		DirectX::XMFLOAT4X4 before, after;
+		XMStoreFloat4x4(&before, model.worldMatrix);
+		_gui->UpdateGizmo(model, _camera);
+		XMStoreFloat4x4(&after, model.worldMatrix);
+		if (_recorder && std::memcmp(&before, &after, sizeof(after)) != 0) {
+			_recorder->MoveModel(model.id, after);
+		}
+	}
+	if (_recorder) {
+		_recorder->NextTick();
 	}
 }
 
 void TGW::Editor::LoadAssets()
 {
+	PreloadShaders();
+
 	ID3DBlob *vsBlob = nullptr;
 	ID3DBlob *psBlob = nullptr;
 	ASSERT_SUCCEEDED(CompileShader(L"shaders/model.hlsl", "VSMain", "vs_5_0", &vsBlob));
@@ -238,6 +327,17 @@ void TGW::Editor::LoadAssets()
 	cbd.Usage = D3D11_USAGE_DEFAULT;
 	ASSERT_SUCCEEDED(_device->CreateBuffer(&cbd, nullptr, &_cbMVP));
 
+	cbd.ByteWidth = sizeof(FogConstantBuffer);
+	ASSERT_SUCCEEDED(_device->CreateBuffer(&cbd, nullptr, &_cbFog));
+
+	cbd.ByteWidth = sizeof(LightConstantBuffer);
+	ASSERT_SUCCEEDED(_device->CreateBuffer(&cbd, nullptr, &_cbLights));
+
+	// Fog cells blend into each other, and nothing past the map edge wraps around
+	D3D11_SAMPLER_DESC fogSampDesc = sampDesc;
+	fogSampDesc.AddressU = fogSampDesc.AddressV = fogSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ASSERT_SUCCEEDED(_device->CreateSamplerState(&fogSampDesc, &_fogSampler));
+
 	D3D11_RASTERIZER_DESC rasterDesc = {};
 	rasterDesc.FillMode = D3D11_FILL_SOLID;
 	rasterDesc.CullMode = D3D11_CULL_BACK;
@@ -249,6 +349,86 @@ void TGW::Editor::LoadAssets()
 	outlineDesc.CullMode = D3D11_CULL_FRONT;
 	outlineDesc.FrontCounterClockwise = false;
 	ASSERT_SUCCEEDED(_device->CreateRasterizerState(&outlineDesc, &_rasterStateOutline));
+
+	if (!_particleRenderer.Create(_device.Get())) {
+		Logger::LogInfo("Failed to create the particle renderer");
+	}
+
+	std::error_code error;
+	if (std::filesystem::is_regular_file(TERRAIN_FILE, error)) {
+		LoadTerrain(TERRAIN_FILE);
+	}
+}
+
+void TGW::Editor::LoadTerrain(const std::filesystem::path &path)
+{
+	auto heightmap = Terrain::Heightmap::LoadRaw16(path, Terrain::TERRAIN_SPACING, Terrain::TERRAIN_HEIGHT_SCALE);
+	if (!heightmap) {
+		Logger::LogInfo("Failed to load terrain " + path.string());
+		return;
+	}
+
+	_heightmap = std::move(*heightmap);
+	_terrainTree = Terrain::Quadtree{_heightmap};
+	if (!_terrainRenderer.Create(_device.Get(), _heightmap)) {
+		Logger::LogInfo("Failed to create the terrain renderer");
+		return;
+	}
+	_camera.SetGround(&_heightmap);
+	// Replays of the session load the same file and check it did not change since
+	if (_recorder) {
+		if (const std::optional<Hash::Hash128> hash = Replay::HashTerrainFile(path)) {
+			_recorder->SetTerrain(path.generic_string(), *hash);
+		}
+	}
+	Logger::LogInfo(std::format(
+		"Loaded terrain {} ({}x{} samples, {} LODs)", path.string(), _heightmap.GetWidth(), _heightmap.GetHeight(),
+		_terrainTree.GetLodCount()));
+}
+
+void TGW::Editor::MountArchives()
+{
+	std::error_code error;
+	if (!std::filesystem::is_directory(CONTENT_DIR, error)) {
+		return;
+	}
+
+	// Mounted in name order, so "base.pak" is shadowed by "patch_01.pak"
+	std::vector<std::filesystem::path> archives;
+	for (const auto &file : std::filesystem::directory_iterator{CONTENT_DIR, error}) {
+		if (file.is_regular_file() && file.path().extension() == ARCHIVE_EXTENSION) {
+			archives.push_back(file.path());
+		}
+	}
+	std::sort(archives.begin(), archives.end());
+
+	for (const auto &archive : archives) {
+		if (_archives.Mount(archive)) {
+			Logger::LogInfo("Mounted archive " + archive.string());
+		} else {
+			Logger::LogInfo("Failed to mount archive " + archive.string());
+		}
+	}
+}
+
+// texture_buckets.bin from shellshock_cook build, packed into one of the archives or loose in the content dir
+void TGW::Editor::LoadTexturePlan()
+{
+	const std::filesystem::path path = std::filesystem::path{CONTENT_DIR} / Cook::TEXTURE_BUCKETS_NAME;
+	std::optional<std::vector<uint8_t>> data = _archives.Read(path);
+	if (!data) {
+		data = Cook::ReadWholeFile(path);
+	}
+	if (!data) {
+		return;
+	}
+
+	const std::optional<std::vector<Cook::TextureBucket>> buckets = Cook::DeserializeTextureBuckets(*data);
+	if (buckets && _materialArrays.UsePlan(*buckets, CONTENT_DIR)) {
+		Logger::LogInfo(std::format("Loaded the texture plan, {} arrays", buckets->size()));
+	} else {
+		Logger::LogInfo("Failed to load the texture plan " + path.string());
+	}
 }
 
 void TGW::Editor::CreateGUI()
@@ -258,7 +438,12 @@ void TGW::Editor::CreateGUI()
 	auto OnLoadModel = [&](std::string path) {
 		auto newModel = _assetLoader.LoadModel(path);
 		if (newModel) {
-			newModel.value().id = _models.size();
+			newModel.value().id = _nextModelId++;
+			if (_recorder) {
+				DirectX::XMFLOAT4X4 worldMatrix;
+				XMStoreFloat4x4(&worldMatrix, newModel.value().worldMatrix);
+				_recorder->LoadModel(newModel.value().id, path, worldMatrix);
+			}
 			_models.insert({newModel.value().id, std::move(newModel.value())});
 		}
 	};
@@ -267,11 +452,134 @@ void TGW::Editor::CreateGUI()
 		DirectX::XMVECTOR modelPos = _models[id].worldMatrix.r[3];
 		_camera.SetTarget(modelPos);
 		_selectedModel = id;
+		if (_recorder) {
+			_recorder->SelectModel(id);
+		}
 	};
 
-	auto OnRemoveModel = [&](UINT id) { _models.erase(id); };
+	auto OnRemoveModel = [&](UINT id) {
+		_models.erase(id);
+		if (_selectedModel == id) {
+			_selectedModel.reset();
+		}
+		if (_recorder) {
+			_recorder->RemoveModel(id);
+		}
+	};
+
+	auto OnSaveScene = [&](std::string path) { SaveScene(path); };
+
+	auto OnLoadScene = [&](std::string path) { LoadScene(path); };
+
+	_gui = std::make_unique<TGW::GUI::MainUI>(OnLoadModel, OnSelectModel, OnRemoveModel, OnSaveScene, OnLoadScene);
+}
+
+void TGW::Editor::SaveScene(const std::string &path)
+{
+	std::vector<UINT> ids;
+	ids.reserve(_models.size());
+	for (const auto &[id, model] : _models) {
+		ids.push_back(id);
+	}
+	std::sort(ids.begin(), ids.end());
+
+	Scene::SceneData scene;
+	XMStoreFloat3(&scene.camera.target, _camera.GetTarget());
+	XMStoreFloat3(&scene.camera.forward, _camera.GetForward());
+	scene.camera.zoom = _camera.GetZoom();
+
+	std::unordered_map<std::string, uint32_t> modelIndexByPath;
+	scene.modelIndices.reserve(ids.size());
+	scene.worldMatrices.reserve(ids.size());
+	scene.flags.reserve(ids.size());
+	for (UINT id : ids) {
+		const Model &model = _models.at(id);
+		auto [it, inserted] = modelIndexByPath.try_emplace(model.path, static_cast<uint32_t>(scene.modelPaths.size()));
+		if (inserted) {
+			scene.modelPaths.push_back(model.path);
+		}
+
+		scene.modelIndices.push_back(it->second);
+		XMStoreFloat4x4(&scene.worldMatrices.emplace_back(), model.worldMatrix);
+		scene.flags.push_back(_selectedModel == id ? Scene::ENTITY_FLAG_SELECTED : Scene::ENTITY_FLAG_NONE);
+	}
+
+	if (Scene::Save(path, scene)) {
+		Logger::LogInfo(std::format("Saved scene {} ({} models)", path, ids.size()));
+	} else {
+		Logger::LogInfo("Failed to save scene " + path);
+	}
+}
+
+void TGW::Editor::LoadScene(const std::string &path)
+{
+	auto scene = Scene::Load(path);
+	if (!scene) {
+		Logger::LogInfo("Failed to load scene " + path);
+		return;
+	}
+
+	// Each referenced file is imported once and all of them at the same time. Entities sharing a file share its GPU resources.
+	std::vector<std::optional<Model>> loaded(scene->modelPaths.size());
+	JobSystem::Get().ParallelFor(static_cast<uint32_t>(loaded.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			loaded[i] = _assetLoader.LoadModel(scene->modelPaths[i]);
+		}
+	});
+
+	_models.clear();
+	_selectedModel.reset();
+	_nextModelId = 0;
+	for (size_t i = 0; i < scene->GetEntityCount(); i++) {
+		const std::optional<Model> &source = loaded[scene->modelIndices[i]];
+		if (!source) {
+			continue;
+		}
+
+		Model model = source.value();
+		model.id = _nextModelId++;
+		model.worldMatrix = XMLoadFloat4x4(&scene->worldMatrices[i]);
+		if (scene->flags[i] & Scene::ENTITY_FLAG_SELECTED) {
+			_selectedModel = model.id;
+		}
+		_models.insert({model.id, std::move(model)});
+	}
+
+	const Scene::CameraState &camera = scene->camera;
+	_camera.SetView(XMLoadFloat3(&camera.target), XMLoadFloat3(&camera.forward), camera.zoom);
+	if (_recorder) {
+		RecordScene();
+	}
+
+	Logger::LogInfo(std::format("Loaded scene {} ({} models)", path, _models.size()));
+}
+
+// Replays have no scene files, a loaded scene goes in as the models it ended up with. The view comes last, selecting
+// moves the camera.
+void TGW::Editor::RecordScene()
+{
+	std::vector<UINT> ids;
+	ids.reserve(_models.size());
+	for (const auto &[id, model] : _models) {
+		ids.push_back(id);
+	}
+	std::sort(ids.begin(), ids.end());
+
+	_recorder->ClearModels();
+	for (UINT id : ids) {
+		const Model &model = _models.at(id);
+		DirectX::XMFLOAT4X4 worldMatrix;
+		XMStoreFloat4x4(&worldMatrix, model.worldMatrix);
+		_recorder->LoadModel(id, model.path, worldMatrix);
+	}
+	if (_selectedModel) {
+		_recorder->SelectModel(_selectedModel);
+	}
 
-	_gui = std::make_unique<TGW::GUI::MainUI>(OnLoadModel, OnSelectModel, OnRemoveModel);
+	DirectX::XMFLOAT3 target, forward;
+	XMStoreFloat3(&target, _camera.GetTarget());
+	XMStoreFloat3(&forward, _camera.GetForward());
+	_recorder->SetView(target, forward, _camera.GetZoom());
 }
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -2,10 +2,18 @@
 
 #include "pch.h"
 
+#include "archive/archive_set.h"
 #include "asset_loader.h"
 
 #include "camera.h"
+#include "cull/occlusion_culler.h"
+#include "fog_texture.h"
 #include "gui/gui.h"
+#include "light_cluster_buffers.h"
+#include "material_arrays.h"
+#include "particle_renderer.h"
+#include "replay/command_stream.h"
+#include "terrain_renderer.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -17,14 +25,46 @@ class Editor {
 	void Run(int nCmdShow);
 	void Resize(UINT width, UINT height);
 	void Render();
-	void DrawModel(const Model &model);
+	// cb only goes to the GPU again when the material changes between meshes
+	void DrawModel(const Model &model, ConstantBuffer &cb);
 	void Update();
 
-	inline void HandleZoom(float wheelDelta) { _camera.HandleZoom(wheelDelta); }
+	inline void HandleZoom(float wheelDelta)
+	{
+		_camera.HandleZoom(wheelDelta);
+		if (_recorder) {
+			_recorder->Zoom(static_cast<short>(wheelDelta));
+		}
+	}
+	// Darkens models by what player can see in fog, nullptr turns it off. fog has to stay alive until the next call.
+	// The editor has no units to see with, so only a host that runs the simulation calls this.
+	inline void SetFog(const Sim::FogOfWar *fog, uint8_t player)
+	{
+		_fog = fog;
+		_fogPlayer = player;
+	}
+	// Draws these particles over the scene, nullptr draws none. particles has to stay alive until the next call.
+	// The editor spawns no effects, so only a host that ticks a ParticleSystem calls this.
+	inline void SetParticles(const Fx::ParticleSystem *particles) { _particles = particles; }
+	// Lights models with these point lights, nullptr lights none. lights has to stay alive until the next call.
+	// Nothing in the editor gives off light, so only a host that runs the simulation calls this.
+	inline void SetLights(const std::vector<Fx::PointLight> *lights) { _lights = lights; }
+	// Ticks this scheduler once a frame and shows its budgets in the AI panel, nullptr runs no AI. ai has to stay
+	// alive until the next call.
+	inline void SetAi(Ai::AiScheduler *ai) { _ai = ai; }
+	// Records camera input and model edits into recorder and ends one of its ticks every frame, nullptr records
+	// nothing. recorder has to stay alive until the next call.
+	inline void SetRecorder(Replay::CommandRecorder *recorder) { _recorder = recorder; }
 
   private:
 	void LoadAssets();
+	void MountArchives();
+	void LoadTexturePlan();
+	void LoadTerrain(const std::filesystem::path &path);
 	void CreateGUI();
+	void SaveScene(const std::string &path);
+	void LoadScene(const std::string &path);
+	void RecordScene();
 
 	HWND _hwnd;
 
@@ -38,10 +78,14 @@ class Editor {
 	ComPtr<ID3D11SamplerState> _sampler;
 	ComPtr<ID3D11DepthStencilView> _dsv;
 	ComPtr<ID3D11Buffer> _cbMVP;
+	ComPtr<ID3D11Buffer> _cbFog;
+	ComPtr<ID3D11Buffer> _cbLights;
+	ComPtr<ID3D11SamplerState> _fogSampler;
 	ComPtr<ID3D11RasterizerState> _rasterState;
 	ComPtr<ID3D11RasterizerState> _rasterStateOutline;
 
 	std::unordered_map<UINT, Model> _models;
+	UINT _nextModelId = 0;
 
 	DirectX::XMMATRIX _matView;
 	DirectX::XMMATRIX _matProj;
@@ -49,8 +93,34 @@ class Editor {
 
 	std::unique_ptr<GUI::MainUI> _gui;
 
+	TGW::Archive::ArchiveSet _archives;
+	// Textures and materials of every loaded model
+	MaterialArrays _materialArrays;
+	// Vertex and index buffers of every loaded model, one copy per distinct mesh
+	GeometryRegistry _geometry;
 	AssetLoader _assetLoader;
 
 	std::optional<UINT> _selectedModel = std::nullopt;
+
+	// Models hidden behind the occluders of the others skip their draw
+	Cull::OcclusionCuller _occlusion;
+	std::vector<Cull::OccluderInstance> _occluders;
+
+	const Sim::FogOfWar *_fog = nullptr;
+	uint8_t _fogPlayer = 0;
+	FogTexture _fogTexture;
+
+	Terrain::Heightmap _heightmap;
+	Terrain::Quadtree _terrainTree;
+	TerrainRenderer _terrainRenderer;
+
+	const Fx::ParticleSystem *_particles = nullptr;
+	ParticleRenderer _particleRenderer;
+
+	const std::vector<Fx::PointLight> *_lights = nullptr;
+	LightClusterBuffers _lightBuffers;
+
+	Ai::AiScheduler *_ai = nullptr;
+	Replay::CommandRecorder *_recorder = nullptr;
 };
 } // namespace TGW
\ No newline at end of file
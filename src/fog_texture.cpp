@@ -0,0 +1,77 @@
+#include "fog_texture.h"
+#include "log.h"
+#include "sim/fog_of_war.h"
+
+/* Implementation of public functions */
+
+bool TGW::FogTexture::Update(ID3D11Device *device, ID3D11DeviceContext *context, const Sim::FogOfWar &fog, uint8_t player)
+{
+	if (!device || !context) {
+		return false;
+	}
+	if (!_texture || fog.GetWidth() != _width || fog.GetHeight() != _height) {
+		if (!Create(device, fog.GetWidth(), fog.GetHeight())) {
+			return false;
+		}
+	} else if (player == _player && fog.GetVersion(player) == _version) {
+		return true;
+	}
+
+	fog.BuildTexels(player, _texels);
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	HRESULT hr = context->Map(_texture.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to map the fog texture. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return false;
+	}
+	// Rows of a mapped texture may be padded
+	for (uint32_t row = 0; row < _height; row++) {
+		uint8_t *destination = static_cast<uint8_t *>(mapped.pData) + size_t{row} * mapped.RowPitch;
+		memcpy(destination, _texels.data() + size_t{row} * _width, _width);
+	}
+	context->Unmap(_texture.Get(), 0);
+
+	_player = player;
+	_version = fog.GetVersion(player);
+	const DirectX::XMFLOAT2 origin = fog.GetOrigin();
+	_constants = FogConstantBuffer{
+	  .origin = origin,
+	  .inverseSize = {1.0f / (_width * fog.GetCellSize()), 1.0f / (_height * fog.GetCellSize())},
+	  .enabled = 1.0f,
+	};
+	return true;
+}
+
+/* Implementation of private functions */
+
+bool TGW::FogTexture::Create(ID3D11Device *device, uint32_t width, uint32_t height)
+{
+	_texture.Reset();
+	_srv.Reset();
+	_version = UINT64_MAX;
+
+	D3D11_TEXTURE2D_DESC desc{};
+	desc.Width = width;
+	desc.Height = height;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	HRESULT hr = device->CreateTexture2D(&desc, nullptr, _texture.GetAddressOf());
+	if (SUCCEEDED(hr)) {
+		hr = device->CreateShaderResourceView(_texture.Get(), nullptr, _srv.GetAddressOf());
+	}
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to create the fog texture. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		_texture.Reset();
+		return false;
+	}
+
+	_width = width;
+	_height = height;
+	return true;
+}
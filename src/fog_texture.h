@@ -0,0 +1,37 @@
+#pragma once
+
+#include "pch.h"
+#include "shaders.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace TGW::Sim {
+class FogOfWar;
+}
+
+namespace TGW {
+
+// GPU copy of one player's fog of war, an R8 texel per fog cell. Uploads are skipped while the fog's version for
+// that player is unchanged, so a tick where nobody crossed a cell border costs nothing here.
+class FogTexture {
+  public:
+	// Recreates the texture when the grid size changes. Returns false when D3D fails.
+	bool Update(ID3D11Device *device, ID3D11DeviceContext *context, const Sim::FogOfWar &fog, uint8_t player);
+
+	inline ID3D11ShaderResourceView *GetSRV() const { return _srv.Get(); }
+	inline const FogConstantBuffer &GetConstants() const { return _constants; }
+
+  private:
+	bool Create(ID3D11Device *device, uint32_t width, uint32_t height);
+
+	ComPtr<ID3D11Texture2D> _texture;
+	ComPtr<ID3D11ShaderResourceView> _srv;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	uint8_t _player = 0;
+	uint64_t _version = UINT64_MAX;
+	std::vector<uint8_t> _texels;
+	FogConstantBuffer _constants;
+};
+
+} // namespace TGW
@@ -0,0 +1,165 @@
+#include "light_clusters.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace TGW::Fx;
+
+namespace {
+constexpr uint32_t LANES = 4;
+constexpr uint32_t ROWS_PER_BATCH = 4;
+// Padding lights sit here with no radius, too far away to touch any cluster
+constexpr float PADDING_POSITION = 1e30f;
+
+inline uint32_t RoundUp(uint32_t value, uint32_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+inline XMVECTOR Load4(const std::vector<float> &values, uint32_t i)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values.data() + i));
+}
+
+// Calls fn(lane) for the lanes of a comparison result that passed, up to count lanes
+template <typename Fn> inline void ForEachSetLane(FXMVECTOR mask, uint32_t count, Fn &&fn)
+{
+	uint32_t lanes[LANES];
+	XMStoreInt4(lanes, mask);
+	for (uint32_t lane = 0; lane < count; lane++) {
+		if (lanes[lane]) {
+			fn(lane);
+		}
+	}
+}
+
+// How far v lies outside [low, high], 0 inside
+inline XMVECTOR DistanceOutside(FXMVECTOR v, float low, float high)
+{
+	return XMVectorMax(XMVectorMax(XMVectorSubtract(XMVectorReplicate(low), v), XMVectorSubtract(v, XMVectorReplicate(high))),
+		XMVectorZero());
+}
+} // namespace
+
+/* Implementation of public functions */
+
+LightClusters::LightClusters(uint32_t tilesX, uint32_t tilesY, uint32_t slices)
+	: _tilesX{std::max(tilesX, 1u)}, _tilesY{std::max(tilesY, 1u)}, _slices{std::max(slices, 1u)}
+{
+	_edgesX.resize(_tilesX + 1);
+	_edgesY.resize(_tilesY + 1);
+	_edgesZ.resize(_slices + 1);
+	_clusters.resize(size_t{_tilesX} * _tilesY * _slices);
+	_rowIndices.resize(size_t{_tilesY} * _slices);
+}
+
+void LightClusters::Build(FXMMATRIX view, CXMMATRIX projection, std::span<const PointLight> lights, JobSystem &jobs)
+{
+	// Perspective LH: _11 and _22 scale x and y by the inverse half fov tangents, z / w maps near to 0 and far to 1
+	XMFLOAT4X4 p;
+	XMStoreFloat4x4(&p, projection);
+	const float nearZ = -p._43 / p._33;
+	const float farZ = p._43 / (1.0f - p._33);
+	for (uint32_t i = 0; i <= _tilesX; i++) {
+		_edgesX[i] = (2.0f * i / _tilesX - 1.0f) / p._11;
+	}
+	for (uint32_t i = 0; i <= _tilesY; i++) {
+		_edgesY[i] = (1.0f - 2.0f * i / _tilesY) / p._22;
+	}
+	const float logRatio = std::log(farZ / nearZ);
+	for (uint32_t i = 0; i <= _slices; i++) {
+		_edgesZ[i] = nearZ * std::exp(logRatio * i / _slices);
+	}
+	_sliceScale = _slices / logRatio;
+	_sliceBias = -std::log(nearZ) * _sliceScale;
+
+	const uint32_t padded = RoundUp(static_cast<uint32_t>(lights.size()), LANES);
+	_lightX.assign(padded, PADDING_POSITION);
+	_lightY.assign(padded, PADDING_POSITION);
+	_lightZ.assign(padded, PADDING_POSITION);
+	_lightRadius.assign(padded, 0.0f);
+	for (uint32_t i = 0; i < lights.size(); i++) {
+		XMFLOAT3 position;
+		XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat3(&lights[i].position), view));
+		_lightX[i] = position.x;
+		_lightY[i] = position.y;
+		_lightZ[i] = position.z;
+		_lightRadius[i] = lights[i].radius;
+	}
+
+	const uint32_t rows = _tilesY * _slices;
+	jobs.ParallelFor(rows, ROWS_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t row = begin; row < end; row++) {
+			AssignRow(row / _tilesY, row % _tilesY);
+		}
+	});
+
+	// Rows hold their clusters in order, so laying the rows out one after another gives every cluster its range
+	uint32_t offset = 0;
+	for (LightCluster &cluster : _clusters) {
+		cluster.offset = offset;
+		offset += cluster.count;
+	}
+	_lightIndices.resize(offset);
+	jobs.ParallelFor(rows, ROWS_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t row = begin; row < end; row++) {
+			std::ranges::copy(_rowIndices[row], _lightIndices.begin() + _clusters[row * _tilesX].offset);
+		}
+	});
+}
+
+/* Implementation of private functions */
+
+void LightClusters::AssignRow(uint32_t slice, uint32_t y)
+{
+	// Edge planes of a froxel lean outwards, so its box reaches out to wherever they are farthest from the axis
+	const float zMin = _edgesZ[slice];
+	const float zMax = _edgesZ[slice + 1];
+	const auto low = [&](float edge) { return std::min(edge * zMin, edge * zMax); };
+	const auto high = [&](float edge) { return std::max(edge * zMin, edge * zMax); };
+	const float yMin = low(_edgesY[y + 1]);
+	const float yMax = high(_edgesY[y]);
+
+	// Lights touching the box of the whole row, with what y and z add to their squared distance to each cluster
+	std::vector<uint32_t> candidates;
+	std::vector<float> candidateX;
+	std::vector<float> candidateYZ;
+	std::vector<float> candidateRadiusSq;
+	const float rowMinX = low(_edgesX[0]);
+	const float rowMaxX = high(_edgesX[_tilesX]);
+	for (uint32_t i = 0; i < _lightX.size(); i += LANES) {
+		const XMVECTOR x = Load4(_lightX, i);
+		const XMVECTOR dx = DistanceOutside(x, rowMinX, rowMaxX);
+		const XMVECTOR dy = DistanceOutside(Load4(_lightY, i), yMin, yMax);
+		const XMVECTOR dz = DistanceOutside(Load4(_lightZ, i), zMin, zMax);
+		const XMVECTOR yz = XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz));
+		const XMVECTOR radius = Load4(_lightRadius, i);
+		const XMVECTOR radiusSq = XMVectorMultiply(radius, radius);
+		XMFLOAT4 xs, yzs, radiusSqs;
+		XMStoreFloat4(&xs, x);
+		XMStoreFloat4(&yzs, yz);
+		XMStoreFloat4(&radiusSqs, radiusSq);
+		ForEachSetLane(XMVectorLessOrEqual(XMVectorMultiplyAdd(dx, dx, yz), radiusSq), LANES, [&](uint32_t lane) {
+			candidates.push_back(i + lane);
+			candidateX.push_back((&xs.x)[lane]);
+			candidateYZ.push_back((&yzs.x)[lane]);
+			candidateRadiusSq.push_back((&radiusSqs.x)[lane]);
+		});
+	}
+	const uint32_t candidateCount = static_cast<uint32_t>(candidates.size());
+	candidateX.resize(RoundUp(candidateCount, LANES), PADDING_POSITION);
+	candidateYZ.resize(candidateX.size(), 0.0f);
+	candidateRadiusSq.resize(candidateX.size(), 0.0f);
+
+	std::vector<uint32_t> &indices = _rowIndices[slice * _tilesY + y];
+	indices.clear();
+	for (uint32_t x = 0; x < _tilesX; x++) {
+		const float xMin = low(_edgesX[x]);
+		const float xMax = high(_edgesX[x + 1]);
+		const size_t first = indices.size();
+		for (uint32_t i = 0; i < candidateCount; i += LANES) {
+			const XMVECTOR dx = DistanceOutside(Load4(candidateX, i), xMin, xMax);
+			const XMVECTOR distanceSq = XMVectorMultiplyAdd(dx, dx, Load4(candidateYZ, i));
+			ForEachSetLane(XMVectorLessOrEqual(distanceSq, Load4(candidateRadiusSq, i)), std::min(LANES, candidateCount - i),
+				[&](uint32_t lane) { indices.push_back(candidates[i + lane]); });
+		}
+		_clusters[GetClusterIndex(x, y, slice)].count = static_cast<uint32_t>(indices.size() - first);
+	}
+}
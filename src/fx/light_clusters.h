@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common.h"
+#include "core/job_system.h"
+
+#include <span>
+
+namespace TGW::Fx {
+
+// Point light as the pixel shader reads it. Light falls off to nothing at radius.
+struct PointLight {
+	DirectX::XMFLOAT3 position;
+	float radius;
+	DirectX::XMFLOAT3 color; // linear RGB
+	float intensity;
+};
+
+// Lights touching one cluster, a range of the light index list
+struct LightCluster {
+	uint32_t offset;
+	uint32_t count;
+};
+
+// Clustered light assignment. The view frustum is split into tilesX x tilesY screen tiles and slices depth slices
+// spaced exponentially from the near to the far plane, and every light lists under the clusters its sphere
+// touches. Rows of clusters spread over the job system, testing four lights at a time against the view space box
+// of each cluster. Boxes hold their froxel, so lights are never missed but may list under a cluster they only
+// come near at its corner.
+class LightClusters {
+  public:
+	explicit LightClusters(uint32_t tilesX = 16, uint32_t tilesY = 9, uint32_t slices = 24);
+
+	// projection is a left handed perspective projection like Camera's. Lights past the far plane are dropped.
+	void Build(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, std::span<const PointLight> lights,
+		JobSystem &jobs = JobSystem::Get());
+
+	inline uint32_t GetTilesX() const { return _tilesX; }
+	inline uint32_t GetTilesY() const { return _tilesY; }
+	inline uint32_t GetSlices() const { return _slices; }
+	// Tile row 0 is the top of the screen, like pixel coordinates
+	inline uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t slice) const { return (slice * _tilesY + y) * _tilesX + x; }
+	inline std::span<const LightCluster> GetClusters() const { return _clusters; }
+	inline std::span<const uint32_t> GetLightIndices() const { return _lightIndices; }
+
+	// The slice of a view space depth is floor(log(depth) * scale + bias)
+	inline float GetSliceScale() const { return _sliceScale; }
+	inline float GetSliceBias() const { return _sliceBias; }
+
+  private:
+	void AssignRow(uint32_t slice, uint32_t y);
+
+	uint32_t _tilesX;
+	uint32_t _tilesY;
+	uint32_t _slices;
+	float _sliceScale = 0.0f;
+	float _sliceBias = 0.0f;
+
+	// View space x / z and y / z at the tile edges and depth at the slice edges, from the last Build
+	std::vector<float> _edgesX;
+	std::vector<float> _edgesY;
+	std::vector<float> _edgesZ;
+
+	// View space lights, padded to 4
+	std::vector<float> _lightX;
+	std::vector<float> _lightY;
+	std::vector<float> _lightZ;
+	std::vector<float> _lightRadius;
+
+	std::vector<LightCluster> _clusters;
+	std::vector<uint32_t> _lightIndices;
+	std::vector<std::vector<uint32_t>> _rowIndices; // lights of every cluster of a row, in cluster order
+};
+
+} // namespace TGW::Fx
@@ -0,0 +1,413 @@
+#include "particles.h"
+#include "core/hash.h"
+
+#include <bit>
+#include <cmath>
+#include <utility>
+
+using namespace DirectX;
+using namespace TGW::Fx;
+
+namespace {
+// Groups of PARTICLE_LANES particles per job
+constexpr uint32_t GROUPS_PER_CHUNK = 512;
+constexpr uint32_t EMITTERS_PER_BATCH = 8;
+constexpr uint32_t INSTANCES_PER_BATCH = 4096;
+// Radix sort of the 32-bit depth keys, three passes
+constexpr uint32_t RADIX_BITS = 11;
+constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+// How fast the turbulence drifts, in noise periods per second
+constexpr float NOISE_DRIFT = 0.3f;
+constexpr float GRAVITY = -9.81f;
+
+inline uint32_t RoundUpToLanes(uint32_t count)
+{
+	return (count + PARTICLE_LANES - 1) / PARTICLE_LANES * PARTICLE_LANES;
+}
+
+inline XMVECTOR Load4(const std::vector<float> &values, uint32_t i)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values.data() + i));
+}
+
+inline void Store4(std::vector<float> &values, uint32_t i, FXMVECTOR v)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(values.data() + i), v);
+}
+
+// xorshift32, in [0, 1)
+inline float NextRandom(uint32_t &state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+// Four lanes of channels in [0, 1] to RGBA8. Rounded before the shift into place, so the conversion stays exact.
+inline XMVECTOR PackColors(FXMVECTOR r, FXMVECTOR g, FXMVECTOR b, GXMVECTOR a)
+{
+	const XMVECTOR scale = XMVectorReplicate(255.0f);
+	const auto channel = [&](FXMVECTOR value, uint32_t shift) {
+		return XMConvertVectorFloatToUInt(XMVectorRound(XMVectorMultiply(XMVectorSaturate(value), scale)), shift);
+	};
+	return XMVectorOrInt(XMVectorOrInt(channel(r, 0), channel(g, 8)), XMVectorOrInt(channel(b, 16), channel(a, 24)));
+}
+
+inline uint32_t PackColor(const XMFLOAT4 &color)
+{
+	return XMVectorGetIntX(PackColors(
+		XMVectorReplicate(color.x), XMVectorReplicate(color.y), XMVectorReplicate(color.z), XMVectorReplicate(color.w)));
+}
+} // namespace
+
+/* ParticleSystem */
+
+/* Implementation of public functions */
+
+EmitterId ParticleSystem::AddEmitter(const EmitterDesc &desc)
+{
+	uint32_t index;
+	if (!_freeEmitters.empty()) {
+		index = _freeEmitters.back();
+		_freeEmitters.pop_back();
+	} else {
+		index = static_cast<uint32_t>(_emitters.size());
+		_emitters.emplace_back();
+	}
+
+	Emitter &emitter = _emitters[index];
+	emitter.desc = desc;
+	emitter.active = true;
+	emitter.started = false;
+	emitter.stopped = false;
+	emitter.elapsed = 0.0f;
+	emitter.spawnDebt = 0.0f;
+	emitter.random = desc.seed != 0 ? desc.seed : 1;
+	emitter.count = 0;
+	// Allocated once, ticks never grow a pool. Padding lanes stay finite.
+	const uint32_t paddedCount = RoundUpToLanes(desc.capacity);
+	for (std::vector<float> *values : {&emitter.positionX, &emitter.positionY, &emitter.positionZ, &emitter.velocityX,
+			 &emitter.velocityY, &emitter.velocityZ, &emitter.age, &emitter.inverseLifetime, &emitter.size}) {
+		values->assign(paddedCount, 0.0f);
+	}
+	emitter.color.assign(paddedCount, 0);
+	_emitterCount++;
+	return {index, emitter.generation};
+}
+
+void ParticleSystem::MoveEmitter(EmitterId id, XMFLOAT3 position)
+{
+	if (IsAlive(id)) {
+		_emitters[id.index].desc.position = position;
+	}
+}
+
+void ParticleSystem::StopEmitter(EmitterId id)
+{
+	if (IsAlive(id)) {
+		_emitters[id.index].stopped = true;
+	}
+}
+
+void ParticleSystem::Clear()
+{
+	for (uint32_t i = 0; i < _emitters.size(); i++) {
+		if (_emitters[i].active) {
+			_emitters[i].active = false;
+			_emitters[i].generation++;
+			_emitters[i].count = 0;
+			_freeEmitters.push_back(i);
+		}
+	}
+	_emitterCount = 0;
+	_particleCount = 0;
+}
+
+void ParticleSystem::Tick(float dt, JobSystem &jobs)
+{
+	_time += dt;
+
+	// Big pools split into several chunks, so one large explosion does not land on a single thread
+	_chunks.clear();
+	for (uint32_t i = 0; i < _emitters.size(); i++) {
+		const uint32_t groupCount = RoundUpToLanes(_emitters[i].count) / PARTICLE_LANES;
+		for (uint32_t first = 0; first < groupCount; first += GROUPS_PER_CHUNK) {
+			_chunks.push_back({i, first, std::min(GROUPS_PER_CHUNK, groupCount - first)});
+		}
+	}
+	jobs.ParallelFor(static_cast<uint32_t>(_chunks.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			UpdateGroups(_emitters[_chunks[i].emitter], _chunks[i].firstGroup, _chunks[i].groupCount, dt);
+		}
+	});
+
+	jobs.ParallelFor(static_cast<uint32_t>(_emitters.size()), EMITTERS_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			if (_emitters[i].active) {
+				RemoveDead(_emitters[i]);
+				SpawnParticles(_emitters[i], dt);
+			}
+		}
+	});
+
+	_particleCount = 0;
+	for (uint32_t i = 0; i < _emitters.size(); i++) {
+		Emitter &emitter = _emitters[i];
+		if (!emitter.active) {
+			continue;
+		}
+		const bool emitting = !emitter.stopped && (emitter.desc.duration < 0.0f || emitter.elapsed < emitter.desc.duration);
+		if (emitter.count == 0 && !emitting) {
+			emitter.active = false;
+			emitter.generation++;
+			_freeEmitters.push_back(i);
+			_emitterCount--;
+			continue;
+		}
+		_particleCount += emitter.count;
+	}
+}
+
+uint64_t ParticleSystem::GetStateHash() const
+{
+	uint64_t hash = Hash::Fnv1a({reinterpret_cast<const char *>(&_particleCount), sizeof(_particleCount)});
+	for (const Emitter &emitter : _emitters) {
+		if (!emitter.active) {
+			continue;
+		}
+		for (const std::vector<float> *values : {&emitter.positionX, &emitter.positionY, &emitter.positionZ,
+				 &emitter.velocityX, &emitter.velocityY, &emitter.velocityZ, &emitter.age}) {
+			hash = Hash::Fnv1a({reinterpret_cast<const char *>(values->data()), emitter.count * sizeof(float)}, hash);
+		}
+	}
+	return hash;
+}
+
+/* Implementation of private functions */
+
+void ParticleSystem::UpdateGroups(Emitter &emitter, uint32_t firstGroup, uint32_t groupCount, float dt) const
+{
+	const EmitterDesc &desc = emitter.desc;
+	const XMVECTOR deltaTime = XMVectorReplicate(dt);
+	const XMVECTOR fall = XMVectorReplicate(GRAVITY * desc.gravityScale * dt);
+	const XMVECTOR damping = XMVectorReplicate(std::max(0.0f, 1.0f - desc.drag * dt));
+	// The flow peaks at about twice its factor per axis
+	const XMVECTOR turbulence = XMVectorReplicate(0.5f * desc.noiseStrength * dt);
+	const XMVECTOR frequency = XMVectorReplicate(XM_2PI / std::max(desc.noiseScale, 1e-3f));
+	const XMVECTOR drift = XMVectorReplicate(XM_2PI * NOISE_DRIFT * _time);
+	const bool turbulent = desc.noiseStrength != 0.0f;
+
+	const XMVECTOR startSize = XMVectorReplicate(desc.startSize);
+	const XMVECTOR sizeChange = XMVectorReplicate(desc.endSize - desc.startSize);
+	const XMFLOAT4 start = desc.startColor, end = desc.endColor;
+	const XMVECTOR startR = XMVectorReplicate(start.x), changeR = XMVectorReplicate(end.x - start.x);
+	const XMVECTOR startG = XMVectorReplicate(start.y), changeG = XMVectorReplicate(end.y - start.y);
+	const XMVECTOR startB = XMVectorReplicate(start.z), changeB = XMVectorReplicate(end.z - start.z);
+	const XMVECTOR startA = XMVectorReplicate(start.w), changeA = XMVectorReplicate(end.w - start.w);
+
+	for (uint32_t group = firstGroup; group < firstGroup + groupCount; group++) {
+		const uint32_t i = group * PARTICLE_LANES;
+		const XMVECTOR age = XMVectorAdd(Load4(emitter.age, i), deltaTime);
+		const XMVECTOR posX = Load4(emitter.positionX, i);
+		const XMVECTOR posY = Load4(emitter.positionY, i);
+		const XMVECTOR posZ = Load4(emitter.positionZ, i);
+		XMVECTOR velX = Load4(emitter.velocityX, i);
+		XMVECTOR velY = XMVectorAdd(Load4(emitter.velocityY, i), fall);
+		XMVECTOR velZ = Load4(emitter.velocityZ, i);
+
+		if (turbulent) {
+			// ABC flow, the curl of a sine potential: divergence-free, so smoke swirls without bunching up
+			XMVECTOR sinX, cosX, sinY, cosY, sinZ, cosZ;
+			XMVectorSinCos(&sinX, &cosX, XMVectorMultiplyAdd(posX, frequency, drift));
+			XMVectorSinCos(&sinY, &cosY, XMVectorMultiplyAdd(posY, frequency, drift));
+			XMVectorSinCos(&sinZ, &cosZ, XMVectorMultiplyAdd(posZ, frequency, drift));
+			velX = XMVectorMultiplyAdd(XMVectorAdd(sinZ, cosY), turbulence, velX);
+			velY = XMVectorMultiplyAdd(XMVectorAdd(sinX, cosZ), turbulence, velY);
+			velZ = XMVectorMultiplyAdd(XMVectorAdd(sinY, cosX), turbulence, velZ);
+		}
+		velX = XMVectorMultiply(velX, damping);
+		velY = XMVectorMultiply(velY, damping);
+		velZ = XMVectorMultiply(velZ, damping);
+
+		Store4(emitter.velocityX, i, velX);
+		Store4(emitter.velocityY, i, velY);
+		Store4(emitter.velocityZ, i, velZ);
+		Store4(emitter.positionX, i, XMVectorMultiplyAdd(velX, deltaTime, posX));
+		Store4(emitter.positionY, i, XMVectorMultiplyAdd(velY, deltaTime, posY));
+		Store4(emitter.positionZ, i, XMVectorMultiplyAdd(velZ, deltaTime, posZ));
+		Store4(emitter.age, i, age);
+
+		const XMVECTOR life = XMVectorSaturate(XMVectorMultiply(age, Load4(emitter.inverseLifetime, i)));
+		Store4(emitter.size, i, XMVectorMultiplyAdd(sizeChange, life, startSize));
+		XMStoreInt4(emitter.color.data() + i,
+			PackColors(XMVectorMultiplyAdd(changeR, life, startR), XMVectorMultiplyAdd(changeG, life, startG),
+				XMVectorMultiplyAdd(changeB, life, startB), XMVectorMultiplyAdd(changeA, life, startA)));
+	}
+}
+
+// Swaps the last particle into every hole, the pool stays dense
+void ParticleSystem::RemoveDead(Emitter &emitter) const
+{
+	for (uint32_t i = 0; i < emitter.count;) {
+		if (emitter.age[i] * emitter.inverseLifetime[i] < 1.0f) {
+			i++;
+			continue;
+		}
+		const uint32_t last = --emitter.count;
+		emitter.positionX[i] = emitter.positionX[last];
+		emitter.positionY[i] = emitter.positionY[last];
+		emitter.positionZ[i] = emitter.positionZ[last];
+		emitter.velocityX[i] = emitter.velocityX[last];
+		emitter.velocityY[i] = emitter.velocityY[last];
+		emitter.velocityZ[i] = emitter.velocityZ[last];
+		emitter.age[i] = emitter.age[last];
+		emitter.inverseLifetime[i] = emitter.inverseLifetime[last];
+		emitter.size[i] = emitter.size[last];
+		emitter.color[i] = emitter.color[last];
+	}
+}
+
+void ParticleSystem::SpawnParticles(Emitter &emitter, float dt) const
+{
+	const EmitterDesc &desc = emitter.desc;
+	uint32_t spawnCount = 0;
+	if (!emitter.stopped) {
+		if (!emitter.started) {
+			spawnCount += desc.burst;
+		}
+		// Only the part of the tick before the duration ran out emits
+		const float emitTime = desc.duration < 0.0f ? dt : std::clamp(desc.duration - emitter.elapsed, 0.0f, dt);
+		emitter.spawnDebt += desc.rate * emitTime;
+		const float whole = std::floor(emitter.spawnDebt);
+		emitter.spawnDebt -= whole;
+		spawnCount += static_cast<uint32_t>(whole);
+	}
+	emitter.started = true;
+	emitter.elapsed += dt;
+	spawnCount = std::min(spawnCount, desc.capacity - emitter.count);
+	if (spawnCount == 0) {
+		return;
+	}
+
+	// Cone around direction: cos theta uniform in [cos spread, 1] covers the cap evenly
+	const XMVECTOR axis = XMVector3Normalize(XMLoadFloat3(&desc.direction));
+	const XMVECTOR reference = std::abs(desc.direction.y) < 0.9f * XMVectorGetX(XMVector3Length(XMLoadFloat3(&desc.direction)))
+								   ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)
+								   : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	const XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(axis, reference));
+	const XMVECTOR bitangent = XMVector3Cross(axis, tangent);
+	const float minCos = std::cos(desc.spread);
+	const uint32_t startColor = PackColor(desc.startColor);
+
+	for (uint32_t n = 0; n < spawnCount; n++) {
+		const uint32_t i = emitter.count++;
+		XMFLOAT3 offset{0.0f, 0.0f, 0.0f};
+		if (desc.radius > 0.0f) {
+			do {
+				offset = {2.0f * NextRandom(emitter.random) - 1.0f, 2.0f * NextRandom(emitter.random) - 1.0f,
+					2.0f * NextRandom(emitter.random) - 1.0f};
+			} while (offset.x * offset.x + offset.y * offset.y + offset.z * offset.z > 1.0f);
+		}
+		emitter.positionX[i] = desc.position.x + offset.x * desc.radius;
+		emitter.positionY[i] = desc.position.y + offset.y * desc.radius;
+		emitter.positionZ[i] = desc.position.z + offset.z * desc.radius;
+
+		const float cosTheta = 1.0f - NextRandom(emitter.random) * (1.0f - minCos);
+		const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+		const float phi = XM_2PI * NextRandom(emitter.random);
+		const float speed = desc.minSpeed + (desc.maxSpeed - desc.minSpeed) * NextRandom(emitter.random);
+		XMVECTOR direction = XMVectorScale(axis, cosTheta);
+		direction = XMVectorAdd(direction, XMVectorScale(tangent, sinTheta * std::cos(phi)));
+		direction = XMVectorAdd(direction, XMVectorScale(bitangent, sinTheta * std::sin(phi)));
+		XMFLOAT3 velocity;
+		XMStoreFloat3(&velocity, XMVectorScale(direction, speed));
+		emitter.velocityX[i] = velocity.x;
+		emitter.velocityY[i] = velocity.y;
+		emitter.velocityZ[i] = velocity.z;
+
+		const float lifetime = desc.minLifetime + (desc.maxLifetime - desc.minLifetime) * NextRandom(emitter.random);
+		emitter.age[i] = 0.0f;
+		emitter.inverseLifetime[i] = 1.0f / std::max(lifetime, 1e-3f);
+		emitter.size[i] = desc.startSize;
+		emitter.color[i] = startColor;
+	}
+}
+
+/* BillboardStream */
+
+/* Implementation of public functions */
+
+void BillboardStream::Build(const ParticleSystem &particles, FXMVECTOR eye, JobSystem &jobs)
+{
+	_ranges.clear();
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < particles._emitters.size(); i++) {
+		const uint32_t count = particles._emitters[i].active ? particles._emitters[i].count : 0;
+		for (uint32_t begin = 0; begin < count; begin += INSTANCES_PER_BATCH) {
+			const uint32_t end = std::min(count, begin + INSTANCES_PER_BATCH);
+			_ranges.push_back({i, begin, end, total});
+			total += end - begin;
+		}
+	}
+	_unsorted.resize(total);
+	_instances.resize(total);
+	_keys.resize(total);
+	_order.resize(total);
+
+	XMFLOAT3 eyePosition;
+	XMStoreFloat3(&eyePosition, eye);
+	jobs.ParallelFor(static_cast<uint32_t>(_ranges.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t r = begin; r < end; r++) {
+			const Range &range = _ranges[r];
+			const ParticleSystem::Emitter &emitter = particles._emitters[range.emitter];
+			for (uint32_t i = range.begin, out = range.first; i < range.end; i++, out++) {
+				const float x = emitter.positionX[i], y = emitter.positionY[i], z = emitter.positionZ[i];
+				_unsorted[out] = {{x, y, z}, emitter.size[i], emitter.color[i]};
+				const float dx = x - eyePosition.x, dy = y - eyePosition.y, dz = z - eyePosition.z;
+				// Squared distances are positive, so their bits order like the floats. Flipped, the far ones go first.
+				_keys[out] = ~std::bit_cast<uint32_t>(dx * dx + dy * dy + dz * dz);
+				_order[out] = out;
+			}
+		}
+	});
+
+	SortKeys();
+	jobs.ParallelFor(total, INSTANCES_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			_instances[i] = _unsorted[_order[i]];
+		}
+	});
+}
+
+/* Implementation of private functions */
+
+// LSD radix sort of _order by _keys, stable so equal depths keep the pool order
+void BillboardStream::SortKeys()
+{
+	const uint32_t count = static_cast<uint32_t>(_keys.size());
+	_keysScratch.resize(count);
+	_orderScratch.resize(count);
+	std::vector<uint32_t> histogram(RADIX_SIZE);
+	for (uint32_t shift = 0; shift < 32; shift += RADIX_BITS) {
+		std::fill(histogram.begin(), histogram.end(), 0);
+		for (uint32_t key : _keys) {
+			histogram[(key >> shift) & (RADIX_SIZE - 1)]++;
+		}
+		// Every key in one bucket leaves the order as it is
+		if (count == 0 || histogram[(_keys[0] >> shift) & (RADIX_SIZE - 1)] == count) {
+			continue;
+		}
+		uint32_t sum = 0;
+		for (uint32_t &bucket : histogram) {
+			sum += std::exchange(bucket, sum);
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			const uint32_t slot = histogram[(_keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+			_keysScratch[slot] = _keys[i];
+			_orderScratch[slot] = _order[i];
+		}
+		_keys.swap(_keysScratch);
+		_order.swap(_orderScratch);
+	}
+}
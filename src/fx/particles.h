@@ -0,0 +1,163 @@
+#pragma once
+
+#include "common.h"
+#include "core/job_system.h"
+
+namespace TGW::Fx {
+
+// Kernels work on groups of this many particles, every pool is padded to a multiple of it
+constexpr uint32_t PARTICLE_LANES = 4;
+
+// Stays valid while the emitter has particles or keeps emitting. Finished emitters free their slot and bump its
+// generation, so stale ids stop resolving.
+struct EmitterId {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	inline bool IsValid() const { return index != UINT32_MAX; }
+	bool operator==(const EmitterId &) const = default;
+};
+
+struct EmitterDesc {
+	DirectX::XMFLOAT3 position{};
+	// Particles start anywhere within this many metres of position
+	float radius = 0.0f;
+	// and leave inside a cone of spread radians around direction
+	DirectX::XMFLOAT3 direction{0.0f, 1.0f, 0.0f};
+	float spread = 0.5f;
+	float minSpeed = 1.0f;
+	float maxSpeed = 2.0f;
+	float minLifetime = 1.0f; // seconds
+	float maxLifetime = 2.0f;
+
+	// Particles emitted on the first tick, then rate per second for duration seconds. A negative duration emits
+	// until StopEmitter.
+	uint32_t burst = 0;
+	float rate = 0.0f;
+	float duration = 0.0f;
+
+	// Share of gravity felt, negative for smoke that rises
+	float gravityScale = 0.0f;
+	// Share of the velocity lost per second
+	float drag = 0.0f;
+	// Turbulence in m/s^2, a divergence-free flow varying over noiseScale metres that drifts with time
+	float noiseStrength = 0.0f;
+	float noiseScale = 4.0f;
+
+	// Size in metres and RGBA colour blend linearly from start to end over the life of a particle
+	float startSize = 0.5f;
+	float endSize = 1.0f;
+	DirectX::XMFLOAT4 startColor{1.0f, 1.0f, 1.0f, 1.0f};
+	DirectX::XMFLOAT4 endColor{1.0f, 1.0f, 1.0f, 0.0f};
+
+	// Most particles alive at once, the pool is allocated up front and spawns past it are dropped
+	uint32_t capacity = 4096;
+	uint32_t seed = 1;
+};
+
+// One camera facing billboard, the vertex shader expands it into a quad
+struct ParticleInstance {
+	DirectX::XMFLOAT3 position;
+	float size;
+	uint32_t color; // RGBA8, red in the lowest byte
+};
+
+// Explosions, smoke and muzzle flashes. Every emitter owns a pool of particles as parallel arrays, ticks update
+// them four at a time spread over the job system, dead particles are swap-removed and emitters with nothing
+// left to do free themselves.
+class ParticleSystem {
+  public:
+	EmitterId AddEmitter(const EmitterDesc &desc);
+	inline bool IsAlive(EmitterId id) const
+	{
+		return id.index < _emitters.size() && _emitters[id.index].active && _emitters[id.index].generation == id.generation;
+	}
+	// Moves where new particles start, for flashes following a barrel. Live particles stay where they are.
+	void MoveEmitter(EmitterId id, DirectX::XMFLOAT3 position);
+	// No more spawns, the emitter goes once its particles died
+	void StopEmitter(EmitterId id);
+	void Clear();
+
+	inline uint32_t GetParticleCount() const { return _particleCount; }
+	inline uint32_t GetEmitterCount() const { return _emitterCount; }
+
+	// Ages, moves and recolours every particle over dt seconds, then removes the dead and spawns new ones
+	void Tick(float dt, JobSystem &jobs = JobSystem::Get());
+
+	// Hash of every live particle, equal across runs that replayed the same emitters and ticks
+	uint64_t GetStateHash() const;
+
+  private:
+	friend class BillboardStream;
+
+	struct Emitter {
+		EmitterDesc desc;
+		uint32_t generation = 0;
+		bool active = false;
+		bool started = false;
+		bool stopped = false;
+		float elapsed = 0.0f;
+		float spawnDebt = 0.0f; // fractional particles carried over between ticks
+		uint32_t random = 1;
+
+		uint32_t count = 0;
+		// Padded to PARTICLE_LANES
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+		std::vector<float> velocityX;
+		std::vector<float> velocityY;
+		std::vector<float> velocityZ;
+		std::vector<float> age;
+		std::vector<float> inverseLifetime;
+		std::vector<float> size;
+		std::vector<uint32_t> color;
+	};
+
+	// Consecutive groups of one emitter, the unit of work of a tick
+	struct Chunk {
+		uint32_t emitter;
+		uint32_t firstGroup;
+		uint32_t groupCount;
+	};
+
+	void UpdateGroups(Emitter &emitter, uint32_t firstGroup, uint32_t groupCount, float dt) const;
+	void RemoveDead(Emitter &emitter) const;
+	void SpawnParticles(Emitter &emitter, float dt) const;
+
+	std::vector<Emitter> _emitters;
+	std::vector<uint32_t> _freeEmitters;
+	std::vector<Chunk> _chunks;
+	uint32_t _emitterCount = 0;
+	uint32_t _particleCount = 0;
+	float _time = 0.0f; // drives the drift of the turbulence
+};
+
+// Instance stream of every live particle, sorted back to front for alpha blending, for a single instanced draw
+class BillboardStream {
+  public:
+	void Build(const ParticleSystem &particles, DirectX::FXMVECTOR eye, JobSystem &jobs = JobSystem::Get());
+	inline const std::vector<ParticleInstance> &GetInstances() const { return _instances; }
+
+  private:
+	// Particles of one emitter written to the unsorted stream from first on
+	struct Range {
+		uint32_t emitter;
+		uint32_t begin;
+		uint32_t end;
+		uint32_t first;
+	};
+
+	void SortKeys();
+
+	std::vector<ParticleInstance> _instances;
+	std::vector<Range> _ranges;
+	// Instances in pool order with their sort keys, and the radix sort ping-pong
+	std::vector<ParticleInstance> _unsorted;
+	std::vector<uint32_t> _keys;
+	std::vector<uint32_t> _keysScratch;
+	std::vector<uint32_t> _order;
+	std::vector<uint32_t> _orderScratch;
+};
+
+} // namespace TGW::Fx
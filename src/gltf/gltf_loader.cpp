@@ -0,0 +1,565 @@
+#include "gltf_loader.h"
+#include "core/hash.h"
+#include "core/json_reader.h"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+
+using namespace DirectX;
+using namespace TGW;
+using namespace TGW::Gltf;
+using TGW::Json::JsonType;
+using TGW::Json::JsonValue;
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+constexpr uint32_t GLB_VERSION = 2;
+constexpr uint32_t GLB_HEADER_SIZE = 12;
+constexpr uint32_t GLB_CHUNK_HEADER_SIZE = 8;
+constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+constexpr uint32_t COMPONENT_FLOAT = 5126;
+
+constexpr uint32_t MODE_TRIANGLES = 4;
+constexpr uint32_t MODE_TRIANGLE_STRIP = 5;
+constexpr uint32_t MODE_TRIANGLE_FAN = 6;
+
+// Extensions that only add material data we ignore anyway. Anything else required goes to Assimp.
+constexpr std::string_view IGNORABLE_EXTENSIONS[] = {
+  "KHR_materials_emissive_strength",
+  "KHR_materials_pbrSpecularGlossiness",
+  "KHR_materials_unlit",
+  "KHR_texture_transform",
+};
+
+// Two 16 byte stores per vertex: position + normal.x, then normal.yz + uv
+static_assert(sizeof(Vertex) == 8 * sizeof(float));
+static_assert(offsetof(Vertex, normal) == 3 * sizeof(float) && offsetof(Vertex, texCoords) == 6 * sizeof(float));
+
+uint32_t ReadU32(const uint8_t *data)
+{
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+uint32_t GetComponentSize(uint32_t componentType)
+{
+	switch (componentType) {
+	case COMPONENT_UNSIGNED_BYTE:
+		return 1;
+	case COMPONENT_UNSIGNED_SHORT:
+		return 2;
+	case COMPONENT_UNSIGNED_INT:
+	case COMPONENT_FLOAT:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+uint32_t GetComponentCount(std::string_view type)
+{
+	if (type == "SCALAR") {
+		return 1;
+	}
+	if (type == "VEC2") {
+		return 2;
+	}
+	if (type == "VEC3") {
+		return 3;
+	}
+	if (type == "VEC4") {
+		return 4;
+	}
+	return 0;
+}
+
+fs::path PathFromUtf8(std::string_view path)
+{
+	return fs::path{std::u8string_view{reinterpret_cast<const char8_t *>(path.data()), path.size()}};
+}
+
+std::string DecodeUri(std::string_view uri)
+{
+	std::string out;
+	out.reserve(uri.size());
+	for (size_t i = 0; i < uri.size(); i++) {
+		uint8_t value = 0;
+		const char *hex = uri.data() + i + 1;
+		if (uri[i] == '%' && i + 2 < uri.size() && std::from_chars(hex, hex + 2, value, 16).ptr == hex + 2) {
+			out.push_back(static_cast<char>(value));
+			i += 2;
+		} else {
+			out.push_back(uri[i]);
+		}
+	}
+	return out;
+}
+
+std::optional<std::vector<uint8_t>> DecodeBase64(std::string_view text)
+{
+	auto decode = [](char c) -> int {
+		if (c >= 'A' && c <= 'Z') {
+			return c - 'A';
+		}
+		if (c >= 'a' && c <= 'z') {
+			return c - 'a' + 26;
+		}
+		if (c >= '0' && c <= '9') {
+			return c - '0' + 52;
+		}
+		return c == '+' ? 62 : c == '/' ? 63 : -1;
+	};
+
+	while (!text.empty() && text.back() == '=') {
+		text.remove_suffix(1);
+	}
+	std::vector<uint8_t> out;
+	out.reserve(text.size() * 3 / 4);
+	uint32_t bits = 0;
+	uint32_t bitCount = 0;
+	for (char c : text) {
+		const int value = decode(c);
+		if (value < 0) {
+			return {};
+		}
+		bits = (bits << 6) | static_cast<uint32_t>(value);
+		bitCount += 6;
+		if (bitCount >= 8) {
+			bitCount -= 8;
+			out.push_back(static_cast<uint8_t>(bits >> bitCount));
+		}
+	}
+	return out;
+}
+
+// Where an accessor's elements are, after all offsets and bounds were checked
+struct AccessorView {
+	const uint8_t *data;
+	uint32_t count;
+	uint32_t stride;
+	uint32_t componentType;
+	uint32_t componentCount;
+	bool normalized;
+};
+
+class GltfParser {
+  public:
+	GltfParser(GltfModel &model, fs::path baseDir) : _model{model}, _baseDir{std::move(baseDir)} {}
+
+	bool Parse(JsonValue root, std::span<const uint8_t> glbBuffer);
+
+  private:
+	bool CheckExtensions() const;
+	bool LoadBuffers(std::span<const uint8_t> glbBuffer);
+	bool LoadImages();
+	void LoadMaterials();
+	bool LoadMeshes();
+	void LoadRootTransform();
+
+	std::optional<std::span<const uint8_t>> GetBufferView(uint32_t index) const;
+	std::optional<AccessorView> GetAccessor(JsonValue index) const;
+	std::string GetTexturePath(JsonValue textureInfo) const;
+	bool LoadPrimitive(JsonValue primitive, MeshData &mesh) const;
+
+	GltfModel &_model;
+	fs::path _baseDir;
+	JsonValue _root;
+	std::vector<std::span<const uint8_t>> _buffers;
+	// Texture path of every image, "*<index>" for embedded ones
+	std::vector<std::string> _imagePaths;
+	uint32_t _defaultMaterial = 0;
+};
+
+bool GltfParser::Parse(JsonValue root, std::span<const uint8_t> glbBuffer)
+{
+	_root = root;
+	const JsonValue asset = root["asset"];
+	if (!root.Is(JsonType::OBJECT) || !asset["version"].AsRawString().starts_with("2.") || !CheckExtensions()) {
+		return false;
+	}
+	if (!LoadBuffers(glbBuffer) || !LoadImages()) {
+		return false;
+	}
+	LoadMaterials();
+	if (!LoadMeshes()) {
+		return false;
+	}
+	LoadRootTransform();
+	return true;
+}
+
+bool GltfParser::CheckExtensions() const
+{
+	bool supported = true;
+	_root["extensionsRequired"].ForEachElement([&](JsonValue extension) {
+		const std::string_view name = extension.AsRawString();
+		supported &= std::find(std::begin(IGNORABLE_EXTENSIONS), std::end(IGNORABLE_EXTENSIONS), name) !=
+					 std::end(IGNORABLE_EXTENSIONS);
+	});
+	return supported;
+}
+
+bool GltfParser::LoadBuffers(std::span<const uint8_t> glbBuffer)
+{
+	bool valid = true;
+	_root["buffers"].ForEachElement([&](JsonValue buffer) {
+		const auto byteLength = buffer["byteLength"].AsUint();
+		const JsonValue uri = buffer["uri"];
+		std::span<const uint8_t> data;
+		if (!uri.IsValid()) {
+			// Only the first buffer of a .glb may leave out the uri, it is the BIN chunk
+			data = _buffers.empty() ? glbBuffer : std::span<const uint8_t>{};
+		} else if (const std::string path = uri.AsString(); path.starts_with("data:")) {
+			const size_t comma = path.find(',');
+			auto decoded = comma != std::string::npos && std::string_view{path}.substr(0, comma).ends_with(";base64")
+							   ? DecodeBase64(std::string_view{path}.substr(comma + 1))
+							   : std::nullopt;
+			if (decoded) {
+				data = _model.decodedBuffers.emplace_back(std::move(*decoded));
+			}
+		} else {
+			FileMapping file;
+			const fs::path filePath = _baseDir / PathFromUtf8(DecodeUri(path));
+			if (file.Open(filePath)) {
+				data = {file.GetData(), file.GetSize()};
+				_model.files.push_back(filePath);
+				_model.mappings.push_back(std::move(file));
+			}
+		}
+
+		// The BIN chunk may carry up to 3 bytes of padding past byteLength
+		valid &= byteLength.has_value() && data.size() >= *byteLength;
+		_buffers.push_back(valid ? data.first(*byteLength) : std::span<const uint8_t>{});
+	});
+	return valid;
+}
+
+bool GltfParser::LoadImages()
+{
+	bool valid = true;
+	uint32_t embeddedCount = 0;
+	_root["images"].ForEachElement([&](JsonValue image) {
+		const JsonValue bufferView = image["bufferView"];
+		const std::string uri = image["uri"].AsString();
+		if (bufferView.IsValid()) {
+			const auto view = GetBufferView(bufferView.AsUint(UINT32_MAX));
+			valid &= view.has_value();
+			_model.embeddedImages.push_back(view.value_or(std::span<const uint8_t>{}));
+		} else if (uri.starts_with("data:")) {
+			const size_t comma = uri.find(',');
+			auto decoded = comma != std::string::npos ? DecodeBase64(std::string_view{uri}.substr(comma + 1)) : std::nullopt;
+			valid &= decoded.has_value();
+			_model.embeddedImages.push_back(_model.decodedBuffers.emplace_back(decoded.value_or(std::vector<uint8_t>{})));
+		} else {
+			_imagePaths.push_back(DecodeUri(uri));
+			return;
+		}
+		// Numbered in the order they appear, the same way Assimp names embedded textures
+		_imagePaths.push_back("*" + std::to_string(embeddedCount++));
+	});
+	return valid;
+}
+
+void GltfParser::LoadMaterials()
+{
+	// Only the slots Assimp fills for glTF and BuildMaterialData reads: base color (or the diffuse of the
+	// spec-gloss extension) and spec-gloss specular
+	_root["materials"].ForEachElement([&](JsonValue material) {
+		MaterialData data;
+		data.textures[TEXTURE_SLOT_DIFFUSE] = GetTexturePath(material["pbrMetallicRoughness"]["baseColorTexture"]);
+		const JsonValue specularGlossiness = material["extensions"]["KHR_materials_pbrSpecularGlossiness"];
+		if (specularGlossiness.IsValid()) {
+			if (const std::string diffuse = GetTexturePath(specularGlossiness["diffuseTexture"]); !diffuse.empty()) {
+				data.textures[TEXTURE_SLOT_DIFFUSE] = diffuse;
+			}
+			data.textures[TEXTURE_SLOT_SPECULAR] = GetTexturePath(specularGlossiness["specularGlossinessTexture"]);
+		}
+		_model.materials.push_back(std::move(data));
+	});
+
+	// Like Assimp, a default material always goes last for primitives that do not name one
+	_defaultMaterial = static_cast<uint32_t>(_model.materials.size());
+	_model.materials.emplace_back();
+}
+
+bool GltfParser::LoadMeshes()
+{
+	bool valid = true;
+	_root["meshes"].ForEachElement([&](JsonValue mesh) {
+		mesh["primitives"].ForEachElement([&](JsonValue primitive) {
+			if (valid) {
+				valid &= LoadPrimitive(primitive, _model.meshes.emplace_back());
+			}
+		});
+	});
+	return valid && !_model.meshes.empty();
+}
+
+void GltfParser::LoadRootTransform()
+{
+	// Assimp makes the only root node of the scene the scene root, or adds an identity root above several
+	float matrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+	const JsonValue scene = _root["scenes"][_root["scene"].AsUint(0)];
+	if (scene["nodes"].GetSize() == 1) {
+		const JsonValue node = _root["nodes"][scene["nodes"][0u].AsUint(UINT32_MAX)];
+		if (node["matrix"].GetSize() == 16) {
+			for (uint32_t i = 0; i < 16; i++) {
+				matrix[i] = node["matrix"][i].AsFloat();
+			}
+		} else {
+			const JsonValue t = node["translation"];
+			const JsonValue r = node["rotation"];
+			const JsonValue s = node["scale"];
+			const XMVECTOR translation = XMVectorSet(t[0u].AsFloat(), t[1u].AsFloat(), t[2u].AsFloat(), 1.0f);
+			XMVECTOR rotation = XMQuaternionIdentity();
+			if (r.GetSize() == 4) {
+				rotation = XMVectorSet(r[0u].AsFloat(), r[1u].AsFloat(), r[2u].AsFloat(), r[3u].AsFloat());
+			}
+			const XMVECTOR scale = XMVectorSet(s[0u].AsFloat(1.0f), s[1u].AsFloat(1.0f), s[2u].AsFloat(1.0f), 0.0f);
+			// Row vector S * R * T is exactly glTF's column major T * R * S
+			XMFLOAT4X4 trs;
+			XMStoreFloat4x4(&trs, XMMatrixAffineTransformation(scale, XMVectorZero(), rotation, translation));
+			std::memcpy(matrix, &trs, sizeof(matrix));
+		}
+	}
+
+	// Same layout ConvertToDirectXMatrix gives Assimp's row major matrices: the transpose of glTF's column major
+	for (uint32_t row = 0; row < 4; row++) {
+		for (uint32_t column = 0; column < 4; column++) {
+			_model.rootTransform.m[row][column] = matrix[column * 4 + row];
+		}
+	}
+}
+
+std::optional<std::span<const uint8_t>> GltfParser::GetBufferView(uint32_t index) const
+{
+	const JsonValue view = _root["bufferViews"][index];
+	const auto buffer = view["buffer"].AsUint();
+	const auto byteLength = view["byteLength"].AsUint();
+	const uint64_t byteOffset = view["byteOffset"].AsUint(0);
+	if (!buffer || !byteLength || *buffer >= _buffers.size() || byteOffset + *byteLength > _buffers[*buffer].size()) {
+		return {};
+	}
+	return _buffers[*buffer].subspan(byteOffset, *byteLength);
+}
+
+std::optional<AccessorView> GltfParser::GetAccessor(JsonValue index) const
+{
+	const JsonValue accessor = _root["accessors"][index.AsUint(UINT32_MAX)];
+	if (!accessor.IsValid() || accessor["sparse"].IsValid()) {
+		return {};
+	}
+
+	AccessorView out{
+	  .data = nullptr,
+	  .count = accessor["count"].AsUint(0),
+	  .stride = 0,
+	  .componentType = accessor["componentType"].AsUint(0),
+	  .componentCount = GetComponentCount(accessor["type"].AsRawString()),
+	  .normalized = accessor["normalized"].AsBool(),
+	};
+	const uint32_t componentSize = GetComponentSize(out.componentType);
+	const uint32_t elementSize = componentSize * out.componentCount;
+	const JsonValue viewIndex = accessor["bufferView"];
+	const auto view = GetBufferView(viewIndex.AsUint(UINT32_MAX));
+	if (elementSize == 0 || out.count == 0 || !view) {
+		return {};
+	}
+
+	out.stride = _root["bufferViews"][viewIndex.AsUint(0)]["byteStride"].AsUint(0);
+	out.stride = out.stride ? out.stride : elementSize;
+	const uint64_t byteOffset = accessor["byteOffset"].AsUint(0);
+	if (out.stride < elementSize || byteOffset + uint64_t{out.stride} * (out.count - 1) + elementSize > view->size()) {
+		return {};
+	}
+	// The spec requires component alignment, the vertex loads below rely on it
+	out.data = view->data() + byteOffset;
+	if (reinterpret_cast<uintptr_t>(out.data) % componentSize != 0 || out.stride % componentSize != 0) {
+		return {};
+	}
+	return out;
+}
+
+std::string GltfParser::GetTexturePath(JsonValue textureInfo) const
+{
+	const JsonValue texture = _root["textures"][textureInfo["index"].AsUint(UINT32_MAX)];
+	const uint32_t image = texture["source"].AsUint(UINT32_MAX);
+	return image < _imagePaths.size() ? _imagePaths[image] : std::string{};
+}
+
+bool GltfParser::LoadPrimitive(JsonValue primitive, MeshData &mesh) const
+{
+	const uint32_t mode = primitive["mode"].AsUint(MODE_TRIANGLES);
+	const JsonValue attributes = primitive["attributes"];
+	const auto positions = GetAccessor(attributes["POSITION"]);
+	const auto normals = attributes["NORMAL"].IsValid() ? GetAccessor(attributes["NORMAL"]) : std::nullopt;
+	const auto texCoords = attributes["TEXCOORD_0"].IsValid() ? GetAccessor(attributes["TEXCOORD_0"]) : std::nullopt;
+
+	// Quantized positions and normals need KHR_mesh_quantization, which Assimp handles
+	auto isFloat3 = [](const AccessorView &view) { return view.componentType == COMPONENT_FLOAT && view.componentCount == 3; };
+	if (mode < MODE_TRIANGLES || mode > MODE_TRIANGLE_FAN || !positions || !isFloat3(*positions)) {
+		return false;
+	}
+	if ((attributes["NORMAL"].IsValid() && (!normals || !isFloat3(*normals) || normals->count != positions->count)) ||
+		(attributes["TEXCOORD_0"].IsValid() &&
+		 (!texCoords || texCoords->componentCount != 2 || texCoords->count != positions->count))) {
+		return false;
+	}
+	if (texCoords && texCoords->componentType != COMPONENT_FLOAT && !texCoords->normalized) {
+		return false;
+	}
+
+	const uint32_t material = primitive["material"].AsUint(_defaultMaterial);
+	mesh.materialIndex = material < _defaultMaterial ? material : _defaultMaterial;
+
+	// De-interleave straight from the (possibly strided) buffers into our layout. UVs get V flipped like Assimp does.
+	const uint32_t vertexCount = positions->count;
+	mesh.vertices.resize(vertexCount);
+	float *out = reinterpret_cast<float *>(mesh.vertices.data());
+	const XMVECTOR uvScale = XMVectorSet(1.0f, 1.0f, 1.0f, texCoords ? -1.0f : 1.0f);
+	const XMVECTOR uvBias = XMVectorSet(0.0f, 0.0f, 0.0f, texCoords ? 1.0f : 0.0f);
+	auto loadFloat3 = [](const AccessorView &view, uint32_t i) {
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3 *>(view.data + size_t{i} * view.stride));
+	};
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		const XMVECTOR position = loadFloat3(*positions, i);
+		const XMVECTOR normal = normals ? loadFloat3(*normals, i) : XMVectorZero();
+
+		XMFLOAT2 uv{};
+		if (texCoords) {
+			const uint8_t *source = texCoords->data + size_t{i} * texCoords->stride;
+			if (texCoords->componentType == COMPONENT_FLOAT) {
+				std::memcpy(&uv, source, sizeof(uv));
+			} else if (texCoords->componentType == COMPONENT_UNSIGNED_SHORT) {
+				uint16_t values[2];
+				std::memcpy(values, source, sizeof(values));
+				uv = {values[0] / 65535.0f, values[1] / 65535.0f};
+			} else {
+				uv = {source[0] / 255.0f, source[1] / 255.0f};
+			}
+		}
+		const XMVECTOR texCoord = XMLoadFloat2(&uv);
+
+		const XMVECTOR low = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_1X>(position, normal);
+		XMVECTOR high = XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_1X, XM_PERMUTE_1Y>(normal, texCoord);
+		high = XMVectorMultiplyAdd(high, uvScale, uvBias);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(out + size_t{i} * 8), low);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(out + size_t{i} * 8 + 4), high);
+	}
+
+	// Indices widen to 32 bit. Non-indexed primitives just count up.
+	std::vector<uint32_t> indices;
+	const JsonValue indexAccessor = primitive["indices"];
+	if (indexAccessor.IsValid()) {
+		const auto view = GetAccessor(indexAccessor);
+		if (!view || view->componentCount != 1 || view->componentType == COMPONENT_FLOAT) {
+			return false;
+		}
+		indices.resize(view->count);
+		if (view->componentType == COMPONENT_UNSIGNED_INT && view->stride == sizeof(uint32_t)) {
+			std::memcpy(indices.data(), view->data, indices.size() * sizeof(uint32_t));
+		} else {
+			for (uint32_t i = 0; i < view->count; i++) {
+				const uint8_t *source = view->data + size_t{i} * view->stride;
+				if (view->componentType == COMPONENT_UNSIGNED_BYTE) {
+					indices[i] = *source;
+				} else if (view->componentType == COMPONENT_UNSIGNED_SHORT) {
+					uint16_t value;
+					std::memcpy(&value, source, sizeof(value));
+					indices[i] = value;
+				} else {
+					std::memcpy(&indices[i], source, sizeof(uint32_t));
+				}
+			}
+		}
+		for (uint32_t index : indices) {
+			if (index >= vertexCount) {
+				return false;
+			}
+		}
+	} else {
+		indices.resize(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++) {
+			indices[i] = i;
+		}
+	}
+
+	// Strips and fans become lists with the winding Assimp gives them
+	if (mode == MODE_TRIANGLES) {
+		indices.resize(indices.size() / 3 * 3);
+		mesh.indices = std::move(indices);
+	} else if (indices.size() >= 3) {
+		const size_t triangleCount = indices.size() - 2;
+		mesh.indices.reserve(triangleCount * 3);
+		for (size_t i = 0; i < triangleCount; i++) {
+			if (mode == MODE_TRIANGLE_FAN) {
+				mesh.indices.insert(mesh.indices.end(), {indices[0], indices[i + 1], indices[i + 2]});
+			} else if (i % 2 == 1) {
+				mesh.indices.insert(mesh.indices.end(), {indices[i + 1], indices[i], indices[i + 2]});
+			} else {
+				mesh.indices.insert(mesh.indices.end(), {indices[i], indices[i + 1], indices[i + 2]});
+			}
+		}
+	}
+	return true;
+}
+} // namespace
+
+bool TGW::Gltf::IsGltfFile(const fs::path &path)
+{
+	const std::string extension = Hash::NormalizePath(path.extension().string());
+	return extension == ".gltf" || extension == ".glb";
+}
+
+std::optional<GltfModel> TGW::Gltf::Load(const fs::path &path)
+{
+	FileMapping file;
+	if (!file.Open(path)) {
+		return {};
+	}
+
+	std::string_view json{reinterpret_cast<const char *>(file.GetData()), file.GetSize()};
+	std::span<const uint8_t> glbBuffer;
+	const uint8_t *data = file.GetData();
+	if (file.GetSize() >= GLB_HEADER_SIZE && ReadU32(data) == GLB_MAGIC) {
+		// Header, then a JSON chunk and an optional BIN chunk, each with 4 byte aligned lengths
+		const uint64_t length = ReadU32(data + 8);
+		if (ReadU32(data + 4) != GLB_VERSION || length > file.GetSize() || length < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE) {
+			return {};
+		}
+		const uint64_t jsonLength = ReadU32(data + GLB_HEADER_SIZE);
+		const uint64_t jsonBegin = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+		if (ReadU32(data + GLB_HEADER_SIZE + 4) != GLB_CHUNK_JSON || jsonBegin + jsonLength > length) {
+			return {};
+		}
+		json = {reinterpret_cast<const char *>(data + jsonBegin), jsonLength};
+
+		const uint64_t binHeader = jsonBegin + ((jsonLength + 3) & ~uint64_t{3});
+		if (binHeader + GLB_CHUNK_HEADER_SIZE <= length && ReadU32(data + binHeader + 4) == GLB_CHUNK_BIN) {
+			const uint64_t binLength = ReadU32(data + binHeader);
+			if (binHeader + GLB_CHUNK_HEADER_SIZE + binLength > length) {
+				return {};
+			}
+			glbBuffer = {data + binHeader + GLB_CHUNK_HEADER_SIZE, binLength};
+		}
+	}
+
+	// The mapping moves into the model, views into it stay valid
+	GltfModel model;
+	model.files.push_back(path);
+	model.mappings.push_back(std::move(file));
+
+	Json::JsonDocument document;
+	if (!document.Parse(json) || !GltfParser{model, path.parent_path()}.Parse(document.GetRoot(), glbBuffer)) {
+		return {};
+	}
+	return model;
+}
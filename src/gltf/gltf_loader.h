@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/file_mapping.h"
+#include "mesh_data.h"
+
+#include <span>
+
+namespace TGW::Gltf {
+
+// A glTF 2.0 model in the same shape AssetLoader builds from Assimp: meshes are primitives in file order,
+// UVs have V flipped and material texture paths are either relative files or "*<index>" into embeddedImages.
+struct GltfModel {
+	DirectX::XMFLOAT4X4 rootTransform{};
+	std::vector<MeshData> meshes;
+	std::vector<MaterialData> materials;
+
+	// Encoded image files (PNG, JPEG, ...) stored inside the model. They point into the mapped file or decodedBuffers.
+	std::vector<std::span<const uint8_t>> embeddedImages;
+
+	// Every file that was read, the model first
+	std::vector<std::filesystem::path> files;
+
+	// Keep the spans above valid
+	std::vector<FileMapping> mappings;
+	std::vector<std::vector<uint8_t>> decodedBuffers;
+};
+
+bool IsGltfFile(const std::filesystem::path &path);
+
+// Loads .glb and .gltf without going through Assimp. Returns nothing for anything outside the common subset
+// (sparse or quantized accessors, compression extensions, points and lines), so callers can fall back to Assimp.
+std::optional<GltfModel> Load(const std::filesystem::path &path);
+
+} // namespace TGW::Gltf
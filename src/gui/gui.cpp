@@ -9,11 +9,15 @@
 #include "ImGuiFileDialog.h"
 
 #include <log.h>
+#include <core/memory_tracker.h>
 
 /* Consts */
 
 constexpr auto MASTER_DOCKSPACE_ID = "MasterDockspace";
 constexpr auto CHOOSE_MODEL_DIALOG_KEY = "ChooseModelKey";
+constexpr auto OPEN_SCENE_DIALOG_KEY = "OpenSceneKey";
+constexpr auto SAVE_SCENE_DIALOG_KEY = "SaveSceneKey";
+constexpr auto SCENE_FILTER = ".shscene";
 constexpr auto LOG_WHITE = ImVec4(1, 1, 1, 1);
 constexpr std::array<ImVec4, static_cast<size_t>(TGW::LogType::NUM_LOG_TYPES)> LOG_COLORS = {
   LOG_WHITE,
@@ -21,6 +25,32 @@ constexpr std::array<ImVec4, static_cast<size_t>(TGW::LogType::NUM_LOG_TYPES)> L
 
 #define LOG_COLOR(log) LOG_COLORS.at(static_cast<size_t>(log.type))
 
+constexpr auto MEMORY_WARNING_COLOR = ImVec4(1.0f, 0.35f, 0.3f, 1.0f);
+constexpr double MIB = 1024.0 * 1024.0;
+// Ahead of every ImGui block, so the free callback knows how much to count off
+constexpr size_t GUI_ALLOCATION_HEADER = alignof(std::max_align_t);
+
+static void *TrackedImGuiAlloc(size_t size, void *)
+{
+	auto *block = static_cast<uint8_t *>(std::malloc(size + GUI_ALLOCATION_HEADER));
+	if (!block) {
+		return nullptr;
+	}
+	*reinterpret_cast<size_t *>(block) = size;
+	TGW::MemoryTracker::Get().Allocate(TGW::MEMORY_TAG_GUI, TGW::MEMORY_POOL_CPU, size);
+	return block + GUI_ALLOCATION_HEADER;
+}
+
+static void TrackedImGuiFree(void *data, void *)
+{
+	if (!data) {
+		return;
+	}
+	uint8_t *block = static_cast<uint8_t *>(data) - GUI_ALLOCATION_HEADER;
+	TGW::MemoryTracker::Get().Free(TGW::MEMORY_TAG_GUI, TGW::MEMORY_POOL_CPU, *reinterpret_cast<size_t *>(block));
+	std::free(block);
+}
+
 /* Class implementations */
 
 TGW::GUI::MainUI::~MainUI()
@@ -33,6 +63,7 @@ TGW::GUI::MainUI::~MainUI()
 void TGW::GUI::Init(HWND hwnd, ID3D11Device *device, ID3D11DeviceContext *context)
 {
 	IMGUI_CHECKVERSION();
+	ImGui::SetAllocatorFunctions(TrackedImGuiAlloc, TrackedImGuiFree);
 	ImGui::CreateContext();
 	ImGuiIO &io = ImGui::GetIO();
 	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
@@ -64,6 +95,8 @@ void TGW::GUI::MainUI::Update(const EditorMetadata &editorMetadata)
 	UpdateTopMenu();
 	UpdateLogs();
 	UpdateAssets(editorMetadata);
+	UpdateMemory(editorMetadata);
+	UpdateAi(editorMetadata);
 
 	ImGui::End();
 }
@@ -102,6 +135,8 @@ void TGW::GUI::MainUI::GenerateDockspace()
 
 		ImGui::DockBuilderDockWindow("Logs", bottomDockID);
 		ImGui::DockBuilderDockWindow("Assets", bottomDockID);
+		ImGui::DockBuilderDockWindow("Memory", bottomDockID);
+		ImGui::DockBuilderDockWindow("AI", bottomDockID);
 		ImGui::DockBuilderFinish(masterDockspaceID);
 	}
 
@@ -118,6 +153,18 @@ void TGW::GUI::MainUI::UpdateTopMenu()
 				config.path = ".";
 				ImGuiFileDialog::Instance()->OpenDialog(CHOOSE_MODEL_DIALOG_KEY, "Choose Model", ".obj,.fbx,.gltf,.glb", config);
 			}
+			ImGui::Separator();
+			if (ImGui::MenuItem("Open Scene...")) {
+				IGFD::FileDialogConfig config;
+				config.path = ".";
+				ImGuiFileDialog::Instance()->OpenDialog(OPEN_SCENE_DIALOG_KEY, "Open Scene", SCENE_FILTER, config);
+			}
+			if (ImGui::MenuItem("Save Scene...")) {
+				IGFD::FileDialogConfig config;
+				config.path = ".";
+				config.flags = ImGuiFileDialogFlags_ConfirmOverwrite;
+				ImGuiFileDialog::Instance()->OpenDialog(SAVE_SCENE_DIALOG_KEY, "Save Scene", SCENE_FILTER, config);
+			}
 			ImGui::EndMenu();
 		}
 		ImGui::EndMenuBar();
@@ -131,6 +178,20 @@ void TGW::GUI::MainUI::UpdateTopMenu()
 		}
 		ImGuiFileDialog::Instance()->Close();
 	}
+
+	if (ImGuiFileDialog::Instance()->Display(OPEN_SCENE_DIALOG_KEY)) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			_OnLoadScene(ImGuiFileDialog::Instance()->GetFilePathName());
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
+
+	if (ImGuiFileDialog::Instance()->Display(SAVE_SCENE_DIALOG_KEY)) {
+		if (ImGuiFileDialog::Instance()->IsOk()) {
+			_OnSaveScene(ImGuiFileDialog::Instance()->GetFilePathName());
+		}
+		ImGuiFileDialog::Instance()->Close();
+	}
 }
 
 void TGW::GUI::MainUI::UpdateLogs()
@@ -199,6 +260,177 @@ void TGW::GUI::MainUI::UpdateAssets(const EditorMetadata &editorMetadata)
 	ImGui::End();
 }
 
+void TGW::GUI::MainUI::UpdateMemory(const EditorMetadata &editorMetadata)
+{
+	if (ImGui::Begin("Memory")) {
+		const MemoryTracker &tracker = MemoryTracker::Get();
+		const MemoryStats gpu = tracker.GetTotal(MEMORY_POOL_GPU);
+		const double budget = _vramBudgetMiB * MIB;
+		ImGui::SetNextItemWidth(120.0f);
+		ImGui::InputInt("VRAM budget (MiB)", &_vramBudgetMiB, 64, 256);
+		_vramBudgetMiB = std::max(_vramBudgetMiB, 1);
+		ImGui::SameLine();
+		if (ImGui::Button("Reset Peaks")) {
+			MemoryTracker::Get().ResetPeaks();
+		}
+		ImGui::ProgressBar(static_cast<float>(std::min(gpu.liveBytes / budget, 1.0)), ImVec2(-1.0f, 0.0f),
+			std::format("{:.1f} / {} MiB of VRAM", gpu.liveBytes / MIB, _vramBudgetMiB).c_str());
+		if (gpu.liveBytes > budget) {
+			ImGui::TextColored(MEMORY_WARNING_COLOR, "Over the VRAM budget by %.1f MiB", (gpu.liveBytes - budget) / MIB);
+		}
+		const ContentRegistryStats &geometry = editorMetadata.geometry;
+		ImGui::Text("Mesh geometry: %llu unique, dedup ratio %.2fx, %.2f MiB saved",
+			static_cast<unsigned long long>(geometry.liveEntries), geometry.GetDedupRatio(), geometry.GetSavedBytes() / MIB);
+		ImGui::Separator();
+
+		const ImGuiTableFlags flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV;
+		if (ImGui::BeginTable("MemoryTags", 6, flags)) {
+			ImGui::TableSetupColumn("Tag");
+			ImGui::TableSetupColumn("Pool");
+			ImGui::TableSetupColumn("Live (MiB)");
+			ImGui::TableSetupColumn("Peak (MiB)");
+			ImGui::TableSetupColumn("Live blocks");
+			ImGui::TableSetupColumn("Allocations");
+			ImGui::TableHeadersRow();
+			for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+				for (uint32_t pool = 0; pool < MEMORY_POOL_COUNT; pool++) {
+					const MemoryStats stats = tracker.GetStats(static_cast<MemoryTag>(tag), static_cast<MemoryPool>(pool));
+					if (stats.totalCount == 0) {
+						continue;
+					}
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(MemoryTracker::GetTagName(static_cast<MemoryTag>(tag)));
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(pool == MEMORY_POOL_GPU ? "GPU" : "CPU");
+					ImGui::TableNextColumn();
+					ImGui::Text("%.2f", stats.liveBytes / MIB);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.2f", stats.peakBytes / MIB);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(stats.liveCount));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", static_cast<unsigned long long>(stats.totalCount));
+				}
+			}
+			ImGui::EndTable();
+		}
+
+		// Textures sit in shared arrays and meshes may share buffers, a model is charged for each one it uses even when
+		// others use it too
+		if (ImGui::CollapsingHeader("Per model", ImGuiTreeNodeFlags_DefaultOpen) &&
+			ImGui::BeginTable("MemoryModels", 4, flags | ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY)) {
+			ImGui::TableSetupColumn("Model", ImGuiTableColumnFlags_WidthStretch);
+			ImGui::TableSetupColumn("Meshes (MiB)");
+			ImGui::TableSetupColumn(
+				"Textures (MiB)", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+			ImGui::TableSetupColumn("Occluder (KiB)");
+			ImGui::TableHeadersRow();
+
+			std::vector<const AssetMetadata *> rows;
+			for (const auto &asset : editorMetadata.assets) {
+				rows.push_back(&asset);
+			}
+			if (const ImGuiTableSortSpecs *sort = ImGui::TableGetSortSpecs(); sort && sort->SpecsCount > 0) {
+				const ImGuiTableColumnSortSpecs &spec = sort->Specs[0];
+				auto key = [&spec](const AssetMetadata *asset) {
+					switch (spec.ColumnIndex) {
+					case 1:
+						return asset->meshBytes;
+					case 2:
+						return asset->textureBytes;
+					case 3:
+						return asset->sceneBytes;
+					default:
+						return uint64_t{0};
+					}
+				};
+				std::stable_sort(rows.begin(), rows.end(), [&](const AssetMetadata *a, const AssetMetadata *b) {
+					if (spec.ColumnIndex == 0) {
+						return spec.SortDirection == ImGuiSortDirection_Ascending ? a->name < b->name : a->name > b->name;
+					}
+					return spec.SortDirection == ImGuiSortDirection_Ascending ? key(a) < key(b) : key(a) > key(b);
+				});
+			}
+
+			for (const AssetMetadata *asset : rows) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(asset->name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", asset->meshBytes / MIB);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", asset->textureBytes / MIB);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", asset->sceneBytes / 1024.0);
+			}
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+}
+
+void TGW::GUI::MainUI::UpdateAi(const EditorMetadata &editorMetadata)
+{
+	if (ImGui::Begin("AI")) {
+		Ai::AiScheduler *ai = editorMetadata.ai;
+		if (!ai) {
+			ImGui::TextUnformatted("No AI running");
+			ImGui::End();
+			return;
+		}
+		ImGui::Text("Tick %u, %.0f us of AI last tick", ai->GetTickCount(), ai->GetLastTickMicros());
+		ImGui::SameLine();
+		if (ImGui::Button("Reset Peaks")) {
+			ai->ResetPeaks();
+		}
+		ImGui::Separator();
+
+		const ImGuiTableFlags flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV;
+		if (ImGui::BeginTable("AiSystems", 9, flags)) {
+			ImGui::TableSetupColumn("System", ImGuiTableColumnFlags_WidthStretch);
+			ImGui::TableSetupColumn("Jobs");
+			ImGui::TableSetupColumn("Budget (us)");
+			ImGui::TableSetupColumn("Last (us)");
+			ImGui::TableSetupColumn("Average (us)");
+			ImGui::TableSetupColumn("Peak (us)");
+			ImGui::TableSetupColumn("Overruns");
+			ImGui::TableSetupColumn("Backlog");
+			ImGui::TableSetupColumn("Late (ticks)");
+			ImGui::TableHeadersRow();
+			for (uint32_t system = 0; system < ai->GetSystemCount(); system++) {
+				const Ai::AiSystemDesc &desc = ai->GetSystemDesc(system);
+				const Ai::AiSystemStats &stats = ai->GetStats(system);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(desc.name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", stats.jobCount);
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", desc.budgetMicros);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.0f", stats.lastMicros);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.0f", stats.averageMicros);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.0f", stats.peakMicros);
+				ImGui::TableNextColumn();
+				if (stats.lastMicros > desc.budgetMicros) {
+					ImGui::TextColored(MEMORY_WARNING_COLOR, "%llu", static_cast<unsigned long long>(stats.overruns));
+				} else {
+					ImGui::Text("%llu", static_cast<unsigned long long>(stats.overruns));
+				}
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", stats.backlog);
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", stats.peakLateness);
+			}
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+}
+
 void TGW::GUI::MainUI::UpdateGizmo(Model &model, const Camera &camera)
 {
 	ImGuiIO &io = ImGui::GetIO();
@@ -16,8 +16,10 @@ class MainUI {
   public:
 	MainUI(
 		std::function<void(std::string)> OnLoadModel, std::function<void(UINT id)> OnSelectModel,
-		std::function<void(UINT id)> OnRemoveModel)
-		: _OnLoadModel{OnLoadModel}, _OnSelectModel{OnSelectModel}, _OnRemoveModel{OnRemoveModel}
+		std::function<void(UINT id)> OnRemoveModel, std::function<void(std::string)> OnSaveScene,
+		std::function<void(std::string)> OnLoadScene)
+		: _OnLoadModel{OnLoadModel}, _OnSelectModel{OnSelectModel}, _OnRemoveModel{OnRemoveModel}, _OnSaveScene{OnSaveScene},
+		  _OnLoadScene{OnLoadScene}
 	{
 	}
 	
@@ -34,8 +36,14 @@ class MainUI {
   private:
 	void UpdateLogs();
 	void UpdateAssets(const EditorMetadata &editorMetadata);
+	void UpdateMemory(const EditorMetadata &editorMetadata);
+	void UpdateAi(const EditorMetadata &editorMetadata);
 	std::function<void(std::string)> _OnLoadModel;
 	std::function<void(UINT id)> _OnSelectModel;
 	std::function<void(UINT id)> _OnRemoveModel;
+	std::function<void(std::string)> _OnSaveScene;
+	std::function<void(std::string)> _OnLoadScene;
+	// The Memory panel warns once live GPU memory goes past this
+	int _vramBudgetMiB = 1024;
 };
 } // namespace TGW::GUI
@@ -0,0 +1,85 @@
+#include "light_cluster_buffers.h"
+#include "camera.h"
+#include "log.h"
+
+namespace {
+// Fewest elements a buffer is created with, it doubles from there
+constexpr uint32_t MIN_BUFFER_CAPACITY = 256;
+} // namespace
+
+/* Implementation of public functions */
+
+bool TGW::LightClusterBuffers::Update(ID3D11Device *device, ID3D11DeviceContext *context, const Camera &camera, float width,
+	float height, std::span<const Fx::PointLight> lights)
+{
+	if (!device || !context || width <= 0.0f || height <= 0.0f) {
+		return false;
+	}
+	_assignment.Build(camera.GetViewMatrix(), camera.GetProjectionMatrix(), lights);
+	const std::span<const Fx::LightCluster> clusters = _assignment.GetClusters();
+	const std::span<const uint32_t> indices = _assignment.GetLightIndices();
+	if (!Upload(device, context, _lights, lights.data(), static_cast<uint32_t>(lights.size()), sizeof(Fx::PointLight)) ||
+		!Upload(device, context, _clusters, clusters.data(), static_cast<uint32_t>(clusters.size()), sizeof(Fx::LightCluster)) ||
+		!Upload(device, context, _indices, indices.data(), static_cast<uint32_t>(indices.size()), sizeof(uint32_t))) {
+		return false;
+	}
+
+	_constants = LightConstantBuffer{
+	  .tilesPerPixel = {_assignment.GetTilesX() / width, _assignment.GetTilesY() / height},
+	  .sliceScale = _assignment.GetSliceScale(),
+	  .sliceBias = _assignment.GetSliceBias(),
+	  .tilesX = _assignment.GetTilesX(),
+	  .tilesY = _assignment.GetTilesY(),
+	  .slices = _assignment.GetSlices(),
+	  .enabled = 1.0f,
+	};
+	return true;
+}
+
+/* Implementation of private functions */
+
+bool TGW::LightClusterBuffers::Upload(ID3D11Device *device, ID3D11DeviceContext *context, StructuredBuffer &target,
+	const void *data, uint32_t count, uint32_t stride)
+{
+	if (!target.buffer || count > target.capacity) {
+		uint32_t capacity = std::max(target.capacity, MIN_BUFFER_CAPACITY);
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = capacity * stride;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		desc.StructureByteStride = stride;
+		HRESULT hr = device->CreateBuffer(&desc, nullptr, target.buffer.ReleaseAndGetAddressOf());
+		if (SUCCEEDED(hr)) {
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			srvDesc.Buffer.NumElements = capacity;
+			hr = device->CreateShaderResourceView(target.buffer.Get(), &srvDesc, target.srv.ReleaseAndGetAddressOf());
+		}
+		if (FAILED(hr)) {
+			Logger::LogInfo(std::format("Failed to create a light buffer. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+			target = {};
+			return false;
+		}
+		target.capacity = capacity;
+	}
+	if (count == 0) {
+		return true;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	HRESULT hr = context->Map(target.buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to map a light buffer. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return false;
+	}
+	memcpy(mapped.pData, data, size_t{count} * stride);
+	context->Unmap(target.buffer.Get(), 0);
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "pch.h"
+#include "fx/light_clusters.h"
+#include "shaders.h"
+
+using Microsoft::WRL::ComPtr;
+
+class Camera;
+
+namespace TGW {
+
+// GPU side of clustered lighting. Every frame the lights are assigned to the clusters of the camera on the CPU,
+// then the lights, the cluster ranges and the light index list are streamed into structured buffers for
+// model.hlsl. Buffers grow by doubling and are never shrunk.
+class LightClusterBuffers {
+  public:
+	// For a viewport of width x height pixels. Returns false when D3D fails.
+	bool Update(ID3D11Device *device, ID3D11DeviceContext *context, const Camera &camera, float width, float height,
+		std::span<const Fx::PointLight> lights);
+
+	// Lights, clusters and light indices, for t5 to t7
+	inline std::array<ID3D11ShaderResourceView *, 3> GetSRVs() const
+	{
+		return {_lights.srv.Get(), _clusters.srv.Get(), _indices.srv.Get()};
+	}
+	inline const LightConstantBuffer &GetConstants() const { return _constants; }
+
+  private:
+	struct StructuredBuffer {
+		ComPtr<ID3D11Buffer> buffer;
+		ComPtr<ID3D11ShaderResourceView> srv;
+		uint32_t capacity = 0;
+	};
+
+	bool Upload(ID3D11Device *device, ID3D11DeviceContext *context, StructuredBuffer &target, const void *data, uint32_t count,
+		uint32_t stride);
+
+	StructuredBuffer _lights;
+	StructuredBuffer _clusters;
+	StructuredBuffer _indices;
+	Fx::LightClusters _assignment;
+	LightConstantBuffer _constants;
+};
+
+} // namespace TGW
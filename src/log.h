@@ -1,6 +1,7 @@
 #pragma once
 
-#include "pch.h"
+#include "common.h"
+#include "core/memory_tracker.h"
 
 namespace TGW {
 enum class LogType { INFO, NUM_LOG_TYPES };
@@ -22,20 +23,33 @@ struct LogEntry {
 	inline const std::string AsString() const { return GetTypeString() + message; }
 };
 
+using LogEntries = std::vector<LogEntry, TrackedAllocator<LogEntry, MEMORY_TAG_LOGS>>;
+
 class Logger {
   public:
 	inline static void LogInfo(const std::string &log) { Log(log, LogType::INFO); }
-	inline static void Clear() { Get()._entries.clear(); }
-	inline static const std::vector<LogEntry> &GetAll() { return Get()._entries; }
+	inline static void Clear()
+	{
+		std::lock_guard lock{Get()._mutex};
+		// Gives the memory back too, a cleared log is usually not refilled to the same size
+		LogEntries{}.swap(Get()._entries);
+	}
+	// Only read this from the main thread, background loads may still be appending
+	inline static const LogEntries &GetAll() { return Get()._entries; }
 
   private:
-	inline static void Log(const std::string &log, LogType type) { Get()._entries.push_back({log, type}); }
+	inline static void Log(const std::string &log, LogType type)
+	{
+		std::lock_guard lock{Get()._mutex};
+		Get()._entries.push_back({log, type});
+	}
 
 	inline static Logger &Get()
 	{
 		static Logger instance;
 		return instance;
 	}
-	std::vector<LogEntry> _entries;
+	LogEntries _entries;
+	std::mutex _mutex;
 };
 } // namespace TGW
\ No newline at end of file
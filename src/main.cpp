@@ -1,5 +1,25 @@
 #include "editor.h"
 
+#include <shellapi.h>
+
+// "-record <file>" records the session into file, for tools/replay
+std::optional<std::filesystem::path> GetRecordPath()
+{
+	int argc = 0;
+	LPWSTR *argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	if (!argv) {
+		return {};
+	}
+	std::optional<std::filesystem::path> path;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::wstring_view{argv[i]} == L"-record") {
+			path = argv[i + 1];
+		}
+	}
+	LocalFree(argv);
+	return path;
+}
+
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int nCmdShow)
 {
 	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
@@ -7,7 +27,20 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int nCmdShow)
 		return -1;
 	}
 
+	const std::optional<std::filesystem::path> recordPath = GetRecordPath();
+	TGW::Replay::CommandRecorder recorder;
+	// Ticked by the editor and shown in its AI panel. Nothing in the editor thinks yet, so it starts with no systems.
+	TGW::Ai::AiScheduler ai;
+
 	TGW::Editor editor{hInstance};
+	editor.SetAi(&ai);
+	if (recordPath) {
+		editor.SetRecorder(&recorder);
+	}
 	editor.Run(nCmdShow);
+
+	if (recordPath && !TGW::Replay::Save(*recordPath, recorder.GetStream())) {
+		return -1;
+	}
 	return 0;
 }
@@ -0,0 +1,301 @@
+#include "material_arrays.h"
+#include "log.h"
+#include "texture.h"
+
+namespace {
+// Fewest slices an array or materials the buffer is created with, they double from there
+constexpr uint32_t MIN_ARRAY_CAPACITY = 4;
+constexpr uint32_t MIN_MATERIAL_CAPACITY = 64;
+
+DXGI_FORMAT ToDxgiFormat(TGW::Cook::TextureFormat format)
+{
+	switch (format) {
+	case TGW::Cook::TEXTURE_FORMAT_RGBA8:
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case TGW::Cook::TEXTURE_FORMAT_BC1:
+		return DXGI_FORMAT_BC1_UNORM;
+	case TGW::Cook::TEXTURE_FORMAT_BC3:
+		return DXGI_FORMAT_BC3_UNORM;
+	case TGW::Cook::TEXTURE_FORMAT_BC5:
+		return DXGI_FORMAT_BC5_UNORM;
+	case TGW::Cook::TEXTURE_FORMAT_BC7:
+		return DXGI_FORMAT_BC7_UNORM;
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+// What model.hlsl reads for one texture slot, bucket in the high half and slice in the low one
+uint32_t PackTextureRef(TGW::Cook::TextureRef ref) { return uint32_t{ref.bucket} << 16 | ref.slice; }
+} // namespace
+
+/* Implementation of public functions */
+
+TGW::MaterialArrays::MaterialArrays() : _table{Cook::TextureBucketSettings{.maxBuckets = MAX_ARRAYS}}
+{
+	_table.AddMaterial({});
+}
+
+bool TGW::MaterialArrays::UsePlan(std::span<const Cook::TextureBucket> buckets, const std::filesystem::path &contentDir)
+{
+	// The cook names textures relative to its content dir, the loader by their full path
+	std::vector<Cook::TextureBucket> named{buckets.begin(), buckets.end()};
+	for (Cook::TextureBucket &bucket : named) {
+		for (std::string &texture : bucket.textures) {
+			texture = ToTextureName(contentDir / texture);
+		}
+	}
+	std::lock_guard lock{_mutex};
+	return _table.UsePlan(named);
+}
+
+TGW::Cook::TextureRef
+TGW::MaterialArrays::AddTexture(ID3D11Device *device, const std::string &name, std::span<const uint8_t> data)
+{
+	{
+		std::lock_guard lock{_mutex};
+		if (const auto ref = _table.FindTexture(name)) {
+			return *ref;
+		}
+	}
+	const std::optional<Cook::TextureInfo> info = Cook::ReadTextureInfo(data);
+	if (!device || !info) {
+		return {};
+	}
+
+	// Decoding is most of the work, it happens outside the lock
+	std::vector<uint8_t> pixels;
+	if (info->resizable) {
+		const Cook::TextureBucketKey key = Cook::GetBucketKey(*info, _table.GetSettings());
+		pixels = Texture::DecodeRGBA8(data.data(), data.size(), key.width, key.height);
+		if (pixels.empty()) {
+			return {};
+		}
+	}
+
+	std::lock_guard lock{_mutex};
+	// Another thread may have added it in the meantime
+	if (const auto ref = _table.FindTexture(name)) {
+		return *ref;
+	}
+	const Cook::TextureRef ref = _table.AddTexture(name, *info);
+	if (!ref.IsValid()) {
+		return ref;
+	}
+
+	// A planned bucket is created with room for every texture of the plan at once
+	ComPtr<ID3D11DeviceContext> context;
+	device->GetImmediateContext(context.GetAddressOf());
+	const uint32_t slices = static_cast<uint32_t>(_table.GetBuckets()[ref.bucket].textures.size());
+	if (!Reserve(device, context.Get(), ref.bucket, std::max(slices, ref.slice + 1u))) {
+		return {};
+	}
+	if (!info->resizable) {
+		return CopyDDS(device, context.Get(), ref, data) ? ref : Cook::TextureRef{};
+	}
+
+	ArrayTexture &array = _arrays[ref.bucket];
+	const Cook::TextureBucketKey &key = _table.GetBuckets()[ref.bucket].key;
+	context->UpdateSubresource(
+		array.texture.Get(), D3D11CalcSubresource(0, ref.slice, key.mipLevels), nullptr, pixels.data(), key.width * 4, 0);
+	array.dirty = true;
+	return ref;
+}
+
+std::optional<TGW::Cook::TextureRef> TGW::MaterialArrays::FindTexture(const std::string &name)
+{
+	std::lock_guard lock{_mutex};
+	return _table.FindTexture(name);
+}
+
+uint32_t TGW::MaterialArrays::AddMaterial(const Cook::MaterialEntry &material)
+{
+	std::lock_guard lock{_mutex};
+	return _table.AddMaterial(material);
+}
+
+uint64_t TGW::MaterialArrays::GetTextureBytes(std::span<const uint32_t> materials)
+{
+	std::lock_guard lock{_mutex};
+	std::vector<Cook::TextureRef> textures;
+	for (uint32_t index : materials) {
+		if (index < _table.GetMaterials().size()) {
+			for (const Cook::TextureRef &ref : _table.GetMaterials()[index].textures) {
+				if (ref.IsValid() && std::find(textures.begin(), textures.end(), ref) == textures.end()) {
+					textures.push_back(ref);
+				}
+			}
+		}
+	}
+	uint64_t bytes = 0;
+	for (const Cook::TextureRef &ref : textures) {
+		bytes += Cook::GetSliceBytes(_table.GetBuckets()[ref.bucket].key);
+	}
+	return bytes;
+}
+
+bool TGW::MaterialArrays::Update(ID3D11Device *device, ID3D11DeviceContext *context)
+{
+	if (!device || !context) {
+		return false;
+	}
+	std::lock_guard lock{_mutex};
+
+	for (ArrayTexture &array : _arrays) {
+		if (array.dirty) {
+			context->GenerateMips(array.srv.Get());
+			array.dirty = false;
+		}
+	}
+
+	const std::span<const Cook::MaterialEntry> materials = _table.GetMaterials();
+	const uint32_t count = static_cast<uint32_t>(materials.size());
+	if (count == _uploadedMaterials) {
+		return true;
+	}
+
+	if (count > _materialCapacity) {
+		uint32_t capacity = std::max(_materialCapacity, MIN_MATERIAL_CAPACITY);
+		while (capacity < count) {
+			capacity *= 2;
+		}
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = capacity * sizeof(DirectX::XMUINT4);
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		desc.StructureByteStride = sizeof(DirectX::XMUINT4);
+		HRESULT hr = device->CreateBuffer(&desc, nullptr, _materialBuffer.ReleaseAndGetAddressOf());
+		if (SUCCEEDED(hr)) {
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			srvDesc.Buffer.NumElements = capacity;
+			hr = device->CreateShaderResourceView(_materialBuffer.Get(), &srvDesc, _materials.ReleaseAndGetAddressOf());
+		}
+		if (FAILED(hr)) {
+			Logger::LogInfo(
+				std::format("Failed to create the material buffer. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+			_materialBuffer.Reset();
+			_materials.Reset();
+			_materialCapacity = 0;
+			_materialMemory = {};
+			return false;
+		}
+		_materialCapacity = capacity;
+		_materialMemory = TrackedAllocation{MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, uint64_t{desc.ByteWidth}};
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	HRESULT hr = context->Map(_materialBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to map the material buffer. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return false;
+	}
+	auto *entries = static_cast<DirectX::XMUINT4 *>(mapped.pData);
+	for (uint32_t i = 0; i < count; i++) {
+		const auto &textures = materials[i].textures;
+		entries[i] = {PackTextureRef(textures[TEXTURE_SLOT_DIFFUSE]), PackTextureRef(textures[TEXTURE_SLOT_SPECULAR]),
+			PackTextureRef(textures[TEXTURE_SLOT_NORMAL]), PackTextureRef(textures[TEXTURE_SLOT_ROUGHNESS])};
+	}
+	context->Unmap(_materialBuffer.Get(), 0);
+	_uploadedMaterials = count;
+	return true;
+}
+
+std::string TGW::MaterialArrays::ToTextureName(const std::filesystem::path &path)
+{
+	std::error_code error;
+	const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+	return (error ? path : absolute).lexically_normal().generic_string();
+}
+
+/* Implementation of private functions */
+
+bool TGW::MaterialArrays::Reserve(ID3D11Device *device, ID3D11DeviceContext *context, uint32_t bucket, uint32_t slices)
+{
+	if (bucket >= _arrays.size()) {
+		_arrays.resize(bucket + 1);
+	}
+	ArrayTexture &array = _arrays[bucket];
+	if (slices <= array.capacity) {
+		return true;
+	}
+
+	const Cook::TextureBucketKey &key = _table.GetBuckets()[bucket].key;
+	uint32_t capacity = std::max(array.capacity, MIN_ARRAY_CAPACITY);
+	while (capacity < slices) {
+		capacity *= 2;
+	}
+	capacity = std::min(capacity, _table.GetSettings().maxSlices);
+
+	// RGBA8 arrays get their mips from GenerateMips, which needs them bindable as render targets
+	const DXGI_FORMAT format = ToDxgiFormat(key.format);
+	const bool generateMips = key.format == Cook::TEXTURE_FORMAT_RGBA8;
+	D3D11_TEXTURE2D_DESC desc{};
+	desc.Width = key.width;
+	desc.Height = key.height;
+	desc.MipLevels = key.mipLevels;
+	desc.ArraySize = capacity;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (generateMips ? D3D11_BIND_RENDER_TARGET : 0);
+	desc.MiscFlags = generateMips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
+
+	ComPtr<ID3D11Texture2D> texture;
+	ComPtr<ID3D11ShaderResourceView> srv;
+	HRESULT hr = device->CreateTexture2D(&desc, nullptr, texture.GetAddressOf());
+	if (SUCCEEDED(hr)) {
+		hr = device->CreateShaderResourceView(texture.Get(), nullptr, srv.GetAddressOf());
+	}
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to create a texture array. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return false;
+	}
+
+	// Slices already filled move over with every mip, the rest of the new array stays blank until used
+	for (uint32_t slice = 0; slice < array.capacity; slice++) {
+		for (uint32_t mip = 0; mip < key.mipLevels; mip++) {
+			context->CopySubresourceRegion(texture.Get(), D3D11CalcSubresource(mip, slice, key.mipLevels), 0, 0, 0,
+				array.texture.Get(), D3D11CalcSubresource(mip, slice, key.mipLevels), nullptr);
+		}
+	}
+	array.texture = std::move(texture);
+	array.srv = std::move(srv);
+	array.capacity = capacity;
+	array.memory = TrackedAllocation{MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, capacity * Cook::GetSliceBytes(key)};
+	return true;
+}
+
+bool TGW::MaterialArrays::CopyDDS(
+	ID3D11Device *device, ID3D11DeviceContext *context, Cook::TextureRef ref, std::span<const uint8_t> data)
+{
+	const ComPtr<ID3D11ShaderResourceView> srv = Texture::LoadDDSFromMemory(device, data.data(), data.size());
+	if (!srv) {
+		return false;
+	}
+	ComPtr<ID3D11Resource> resource;
+	srv->GetResource(resource.GetAddressOf());
+	ComPtr<ID3D11Texture2D> source;
+	if (FAILED(resource.As(&source))) {
+		return false;
+	}
+
+	// The loader can drop top mips the feature level does not allow, then it no longer fits its slice
+	const Cook::TextureBucketKey &key = _table.GetBuckets()[ref.bucket].key;
+	D3D11_TEXTURE2D_DESC desc{};
+	source->GetDesc(&desc);
+	if (desc.Width != key.width || desc.Height != key.height || desc.MipLevels != key.mipLevels || desc.ArraySize != 1) {
+		Logger::LogInfo(std::format("DDS texture does not match its texture array, {}x{} with {} mips", desc.Width,
+			desc.Height, desc.MipLevels));
+		return false;
+	}
+	for (uint32_t mip = 0; mip < key.mipLevels; mip++) {
+		context->CopySubresourceRegion(_arrays[ref.bucket].texture.Get(), D3D11CalcSubresource(mip, ref.slice, key.mipLevels),
+			0, 0, 0, source.Get(), mip, nullptr);
+	}
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "pch.h"
+#include "cook/texture_buckets.h"
+#include "core/memory_tracker.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace TGW {
+
+// GPU side of the material table shared by every model. Textures are packed into one Texture2DArray per bucket of
+// same format and size, and materials into one structured buffer with the slice of each of their textures. A draw
+// then only picks its material index in model.hlsl, the arrays and the buffer are bound once a frame instead of
+// four textures per mesh. Arrays grow by doubling and are never shrunk, their memory counts under
+// MEMORY_TAG_TEXTURES.
+//
+// AddTexture and AddMaterial can be called from several loading threads at once.
+class MaterialArrays {
+  public:
+	// Materials at t8, the arrays from t9 on, as many as model.hlsl declares
+	static constexpr uint32_t FIRST_SLOT = 8;
+	static constexpr uint32_t MAX_ARRAYS = 8;
+
+	// Index 0 is the material without textures
+	MaterialArrays();
+
+	// Takes the buckets shellshock_cook planned for the content in contentDir, before any texture is added. Planned
+	// textures land in their slices and each array is created at its planned size, instead of growing as textures
+	// come in.
+	bool UsePlan(std::span<const Cook::TextureBucket> buckets, const std::filesystem::path &contentDir);
+
+	// Places the image file in data (PNG, JPEG, BMP or DDS) in its array the first time name is seen. RGBA8 images
+	// are resized to the size of their array. Files are named as ToTextureName makes it, so a plan finds them.
+	// Invalid when the format is not supported, the arrays are full or D3D fails.
+	Cook::TextureRef AddTexture(ID3D11Device *device, const std::string &name, std::span<const uint8_t> data);
+	// Lets callers skip reading a file that is already in
+	std::optional<Cook::TextureRef> FindTexture(const std::string &name);
+	uint32_t AddMaterial(const Cook::MaterialEntry &material);
+	// GPU bytes of the distinct textures these materials use, all mips of their slices
+	uint64_t GetTextureBytes(std::span<const uint32_t> materials);
+
+	// Uploads the materials added since the last call and fills in the mips of new RGBA8 slices. Returns false when
+	// D3D fails.
+	bool Update(ID3D11Device *device, ID3D11DeviceContext *context);
+
+	// Materials and arrays, for t8 onwards in one call
+	inline std::array<ID3D11ShaderResourceView *, 1 + MAX_ARRAYS> GetSRVs() const
+	{
+		std::array<ID3D11ShaderResourceView *, 1 + MAX_ARRAYS> srvs{_materials.Get()};
+		for (size_t i = 0; i < _arrays.size(); i++) {
+			srvs[1 + i] = _arrays[i].srv.Get();
+		}
+		return srvs;
+	}
+
+	// What AddTexture and UsePlan name the texture file at path
+	static std::string ToTextureName(const std::filesystem::path &path);
+
+  private:
+	struct ArrayTexture {
+		ComPtr<ID3D11Texture2D> texture;
+		ComPtr<ID3D11ShaderResourceView> srv;
+		uint32_t capacity = 0;
+		TrackedAllocation memory;
+		// New slices whose mips still have to be generated
+		bool dirty = false;
+	};
+
+	bool Reserve(ID3D11Device *device, ID3D11DeviceContext *context, uint32_t bucket, uint32_t slices);
+	bool CopyDDS(ID3D11Device *device, ID3D11DeviceContext *context, Cook::TextureRef ref, std::span<const uint8_t> data);
+
+	std::mutex _mutex;
+	Cook::MaterialTable _table;
+	std::vector<ArrayTexture> _arrays;
+
+	ComPtr<ID3D11Buffer> _materialBuffer;
+	ComPtr<ID3D11ShaderResourceView> _materials;
+	uint32_t _materialCapacity = 0;
+	TrackedAllocation _materialMemory;
+	uint32_t _uploadedMaterials = 0;
+};
+
+} // namespace TGW
@@ -0,0 +1,55 @@
+#include "mesh_data.h"
+
+#include <assimp/material.h>
+#include <assimp/mesh.h>
+
+MeshData BuildMeshData(const aiMesh *mesh)
+{
+	MeshData out;
+	out.materialIndex = mesh->mMaterialIndex;
+
+	const aiVector3D *normals = mesh->mNormals;
+	const aiVector3D *texCoords = mesh->mTextureCoords[0];
+	out.vertices.resize(mesh->mNumVertices);
+	for (uint32_t i = 0; i < mesh->mNumVertices; i++) {
+		const aiVector3D &position = mesh->mVertices[i];
+		Vertex &vertex = out.vertices[i];
+		vertex.position = {position.x, position.y, position.z};
+		vertex.normal = normals ? DirectX::XMFLOAT3{normals[i].x, normals[i].y, normals[i].z} : DirectX::XMFLOAT3{};
+		vertex.texCoords = texCoords ? DirectX::XMFLOAT2{texCoords[i].x, texCoords[i].y} : DirectX::XMFLOAT2{};
+	}
+
+	// aiProcess_Triangulate leaves points and lines alone, those faces are skipped
+	out.indices.reserve(mesh->mNumFaces * 3);
+	for (uint32_t i = 0; i < mesh->mNumFaces; i++) {
+		const aiFace &face = mesh->mFaces[i];
+		if (face.mNumIndices != 3) {
+			continue;
+		}
+		out.indices.push_back(face.mIndices[0]);
+		out.indices.push_back(face.mIndices[1]);
+		out.indices.push_back(face.mIndices[2]);
+	}
+
+	return out;
+}
+
+MaterialData BuildMaterialData(const aiMaterial *material)
+{
+	// Normal maps come in through the height slot and roughness through ambient, like OBJ materials write them
+	constexpr aiTextureType SLOT_TYPES[TEXTURE_SLOT_COUNT] = {
+	  aiTextureType_DIFFUSE,
+	  aiTextureType_SPECULAR,
+	  aiTextureType_HEIGHT,
+	  aiTextureType_AMBIENT,
+	};
+
+	MaterialData out;
+	aiString path;
+	for (uint32_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++) {
+		if (material->GetTexture(SLOT_TYPES[slot], 0, &path) == aiReturn_SUCCESS) {
+			out.textures[slot] = path.C_Str();
+		}
+	}
+	return out;
+}
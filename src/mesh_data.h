@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common.h"
+
+#include <assimp/postprocess.h>
+
+struct aiMesh;
+struct aiMaterial;
+
+// Post processing every model import runs with, the editor and the cook must agree on it
+constexpr uint32_t MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices;
+
+struct Vertex {
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT2 texCoords;
+};
+
+// CPU side of a mesh, what ends up in the vertex and index buffers
+struct MeshData {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	uint32_t materialIndex = 0;
+};
+
+// Flattens an imported mesh into our vertex layout. Missing normals or UVs are zero filled.
+MeshData BuildMeshData(const aiMesh *mesh);
+
+enum TextureSlot : uint8_t {
+	TEXTURE_SLOT_DIFFUSE,
+	TEXTURE_SLOT_SPECULAR,
+	TEXTURE_SLOT_NORMAL,
+	TEXTURE_SLOT_ROUGHNESS,
+	TEXTURE_SLOT_COUNT,
+};
+
+// Texture paths of a material as written in the model file, relative to it. Unused slots are empty and
+// embedded textures show up as "*<index>".
+struct MaterialData {
+	std::array<std::string, TEXTURE_SLOT_COUNT> textures;
+};
+
+MaterialData BuildMaterialData(const aiMaterial *material);
+
+inline bool IsEmbeddedTexturePath(std::string_view path) { return path.starts_with('*'); }
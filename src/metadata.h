@@ -1,16 +1,26 @@
 #pragma once
 
 #include "pch.h"
+#include "ai/ai_scheduler.h"
+#include "core/content_registry.h"
 
 namespace TGW::GUI {
 
 struct AssetMetadata {
 	UINT id;
 	std::string name;
+	// What the model holds, for the Memory panel
+	uint64_t meshBytes = 0;
+	uint64_t textureBytes = 0;
+	uint64_t sceneBytes = 0;
 };
 
 struct EditorMetadata {
 	std::vector<AssetMetadata> assets;
+	// Mesh buffers shared between models
+	ContentRegistryStats geometry;
+	// Ticked by the editor, nullptr when there is none
+	Ai::AiScheduler *ai = nullptr;
 };
 
 } // namespace TGW::GUI
\ No newline at end of file
@@ -1,37 +1,46 @@
 #pragma once
 
 #include "pch.h"
+#include "core/content_registry.h"
+#include "core/memory_tracker.h"
+#include "cull/occluder_mesh.h"
+#include "mesh_data.h"
 
 using Microsoft::WRL::ComPtr;
 
-struct aiMesh;
 struct ID3D11Buffer;
-struct ID3D11ShaderResourceView;
 
-struct Vertex {
-	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 normal;
-	DirectX::XMFLOAT2 texCoords;
+struct MeshGeometry {
+	ComPtr<ID3D11Buffer> vertexBuffer;
+	ComPtr<ID3D11Buffer> indexBuffer;
+	// Both buffers under MEMORY_TAG_MESHES, counted once however many meshes share them
+	TGW::TrackedAllocation memory;
 };
 
+// Meshes with the same vertices and indices share their buffers, in any model
+using GeometryRegistry = TGW::ContentRegistry<MeshGeometry>;
+
 struct MeshBuffer {
-	ComPtr<ID3D11Buffer> vertexBuffer;
-	ComPtr<ID3D11Buffer> indexBuffer;
+	std::shared_ptr<const MeshGeometry> geometry;
 	uint32_t indexCount = 0;
+	// Into the model's materials. Meshes are sorted by the table index it leads to, so draws sharing a material follow
+	// each other.
 	uint32_t materialIndex = 0;
 };
 
-struct Material {
-	ComPtr<ID3D11ShaderResourceView> diffuse;
-	ComPtr<ID3D11ShaderResourceView> specular;
-	ComPtr<ID3D11ShaderResourceView> roughness;
-	ComPtr<ID3D11ShaderResourceView> normal;
-};
-
 struct Model {
 	std::string name;
+	std::string path;
 	UINT id;
 	DirectX::XMMATRIX worldMatrix;
 	std::vector<MeshBuffer> meshes;
-	std::vector<Material> materials;
+	// Index of each material in the MaterialArrays table shared by every model
+	std::vector<uint32_t> materials;
+	// Model space stand-in for occlusion culling, with the bounds of the full model
+	TGW::Cull::OccluderMesh occluder;
+	// The occluder under MEMORY_TAG_SCENE, every copy of the model has its own
+	TGW::TrackedAllocation occluderMemory;
+	// GPU bytes of the textures its materials use. They live in the shared arrays, models using the same texture
+	// each count it in full.
+	uint64_t textureBytes = 0;
 };
\ No newline at end of file
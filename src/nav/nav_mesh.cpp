@@ -0,0 +1,213 @@
+#include "nav_mesh.h"
+
+using namespace TGW::Nav;
+
+namespace {
+bool Overlaps(const NavGeometry &geometry, float minX, float minZ, float maxX, float maxZ)
+{
+	return geometry.boundsMin.x <= maxX && geometry.boundsMax.x >= minX && geometry.boundsMin.z <= maxZ &&
+		geometry.boundsMax.z >= minZ;
+}
+} // namespace
+
+NavMesh::NavMesh(const NavMeshSettings &settings, DirectX::XMFLOAT2 origin, DirectX::XMFLOAT2 size,
+	const Terrain::Heightmap *terrain)
+	: _settings{settings}, _origin{origin}, _terrain{terrain}
+{
+	const float tileSize = settings.GetTileSize();
+	_tilesX = std::max(1u, static_cast<uint32_t>(std::ceil(size.x / tileSize)));
+	_tilesZ = std::max(1u, static_cast<uint32_t>(std::ceil(size.y / tileSize)));
+	_dirty.assign(size_t{_tilesX} * _tilesZ, 0);
+
+	auto snapshot = std::make_shared<NavSnapshot>();
+	snapshot->tiles.resize(_dirty.size());
+	snapshot->rebuilds.resize(_dirty.size());
+	snapshot->firstPolys.assign(_dirty.size() + 1, 0);
+	_snapshot = std::move(snapshot);
+}
+
+NavMesh::~NavMesh() { WaitForRebuilds(); }
+
+uint32_t NavMesh::AddGeometry(NavGeometry geometry)
+{
+	const uint32_t id = _nextGeometryId++;
+	MarkDirty(geometry.boundsMin.x, geometry.boundsMin.z, geometry.boundsMax.x, geometry.boundsMax.z);
+	_geometry.emplace(id, std::make_shared<const NavGeometry>(std::move(geometry)));
+	return id;
+}
+
+void NavMesh::RemoveGeometry(uint32_t id)
+{
+	const auto found = _geometry.find(id);
+	if (found == _geometry.end()) {
+		return;
+	}
+	const NavGeometry &geometry = *found->second;
+	MarkDirty(geometry.boundsMin.x, geometry.boundsMin.z, geometry.boundsMax.x, geometry.boundsMax.z);
+	_geometry.erase(found);
+}
+
+void NavMesh::OnTerrainChanged(std::span<const Terrain::SampleRect> rects)
+{
+	if (!_terrain) {
+		return;
+	}
+	const float spacing = _terrain->GetSpacing();
+	const DirectX::XMFLOAT2 origin = _terrain->GetOrigin();
+	for (const Terrain::SampleRect &rect : rects) {
+		// Every quad that has one of the samples as a corner
+		MarkDirty(origin.x + (static_cast<float>(rect.minX) - 1.0f) * spacing,
+			origin.y + (static_cast<float>(rect.minZ) - 1.0f) * spacing, origin.x + rect.maxX * spacing,
+			origin.y + rect.maxZ * spacing);
+	}
+}
+
+void NavMesh::Build(JobSystem &jobs)
+{
+	MarkDirty(_origin.x, _origin.y, _origin.x + _tilesX * _settings.GetTileSize(),
+		_origin.y + _tilesZ * _settings.GetTileSize());
+	if (const std::shared_ptr<Rebuild> rebuild = TakeDirty()) {
+		RunRebuild(*rebuild, jobs);
+	}
+}
+
+uint32_t NavMesh::RebuildDirtyAsync(JobSystem &jobs)
+{
+	const std::shared_ptr<Rebuild> rebuild = TakeDirty();
+	if (!rebuild) {
+		return 0;
+	}
+	{
+		std::lock_guard lock{_pendingMutex};
+		_pending++;
+	}
+	jobs.Submit([this, rebuild, &jobs] {
+		RunRebuild(*rebuild, jobs);
+		// Notified under the lock, so a waiting destructor cannot free the mutex before it is released
+		std::lock_guard lock{_pendingMutex};
+		_pending--;
+		_pendingDone.notify_all();
+	});
+	return static_cast<uint32_t>(rebuild->tiles.size());
+}
+
+void NavMesh::WaitForRebuilds()
+{
+	std::unique_lock lock{_pendingMutex};
+	_pendingDone.wait(lock, [this] { return _pending == 0; });
+}
+
+uint32_t NavMesh::GetPendingRebuilds() const
+{
+	std::lock_guard lock{_pendingMutex};
+	return _pending;
+}
+
+std::shared_ptr<const NavSnapshot> NavMesh::GetSnapshot() const
+{
+	std::lock_guard lock{_snapshotMutex};
+	return _snapshot;
+}
+
+std::optional<uint32_t> NavMesh::GetTileIndex(float x, float z) const
+{
+	const float tileSize = _settings.GetTileSize();
+	const float tileX = std::floor((x - _origin.x) / tileSize);
+	const float tileZ = std::floor((z - _origin.y) / tileSize);
+	// Written so NaN fails too
+	if (!(tileX >= 0.0f && tileZ >= 0.0f && tileX < _tilesX && tileZ < _tilesZ)) {
+		return {};
+	}
+	return static_cast<uint32_t>(tileZ) * _tilesX + static_cast<uint32_t>(tileX);
+}
+
+/* Implementation of private functions */
+
+// Tiles whose border reaches into the rectangle
+void NavMesh::MarkDirty(float minX, float minZ, float maxX, float maxZ)
+{
+	const float tileSize = _settings.GetTileSize();
+	const float reach = _settings.GetBorderCells() * _settings.cellSize;
+	const auto toTile = [tileSize](float position, float origin, uint32_t count) {
+		return static_cast<uint32_t>(std::clamp(std::floor((position - origin) / tileSize), 0.0f, count - 1.0f));
+	};
+	const uint32_t x0 = toTile(minX - reach, _origin.x, _tilesX), x1 = toTile(maxX + reach, _origin.x, _tilesX);
+	const uint32_t z0 = toTile(minZ - reach, _origin.y, _tilesZ), z1 = toTile(maxZ + reach, _origin.y, _tilesZ);
+	for (uint32_t z = z0; z <= z1; z++) {
+		for (uint32_t x = x0; x <= x1; x++) {
+			const uint32_t tile = z * _tilesX + x;
+			if (!_dirty[tile]) {
+				_dirty[tile] = 1;
+				_dirtyTiles.push_back(tile);
+			}
+		}
+	}
+}
+
+std::shared_ptr<NavMesh::Rebuild> NavMesh::TakeDirty()
+{
+	if (_dirtyTiles.empty()) {
+		return nullptr;
+	}
+	auto rebuild = std::make_shared<Rebuild>();
+	rebuild->id = _nextRebuild++;
+	rebuild->tiles.swap(_dirtyTiles);
+	std::sort(rebuild->tiles.begin(), rebuild->tiles.end());
+
+	const float tileSize = _settings.GetTileSize();
+	const float reach = _settings.GetBorderCells() * _settings.cellSize;
+	for (const uint32_t tile : rebuild->tiles) {
+		_dirty[tile] = 0;
+	}
+	for (const auto &[id, geometry] : _geometry) {
+		for (const uint32_t tile : rebuild->tiles) {
+			const float minX = _origin.x + tile % _tilesX * tileSize - reach;
+			const float minZ = _origin.y + tile / _tilesX * tileSize - reach;
+			if (Overlaps(*geometry, minX, minZ, minX + tileSize + 2 * reach, minZ + tileSize + 2 * reach)) {
+				rebuild->geometry.push_back(geometry);
+				break;
+			}
+		}
+	}
+	return rebuild;
+}
+
+void NavMesh::RunRebuild(const Rebuild &rebuild, JobSystem &jobs)
+{
+	const float tileSize = _settings.GetTileSize();
+	const float reach = _settings.GetBorderCells() * _settings.cellSize;
+	std::vector<std::shared_ptr<const NavTile>> built(rebuild.tiles.size());
+	jobs.ParallelFor(static_cast<uint32_t>(rebuild.tiles.size()), 1, [&](uint32_t begin, uint32_t end) {
+		std::vector<const NavGeometry *> geometry;
+		for (uint32_t i = begin; i < end; i++) {
+			const uint32_t x = rebuild.tiles[i] % _tilesX;
+			const uint32_t z = rebuild.tiles[i] / _tilesX;
+			const float minX = _origin.x + x * tileSize - reach;
+			const float minZ = _origin.y + z * tileSize - reach;
+			geometry.clear();
+			for (const auto &candidate : rebuild.geometry) {
+				if (Overlaps(*candidate, minX, minZ, minX + tileSize + 2 * reach, minZ + tileSize + 2 * reach)) {
+					geometry.push_back(candidate.get());
+				}
+			}
+			const NavTileInput input{.x = x, .z = z, .origin = _origin, .terrain = _terrain, .geometry = geometry};
+			built[i] = std::make_shared<const NavTile>(BuildNavTile(_settings, input));
+		}
+	});
+
+	std::lock_guard lock{_snapshotMutex};
+	auto snapshot = std::make_shared<NavSnapshot>(*_snapshot);
+	for (size_t i = 0; i < rebuild.tiles.size(); i++) {
+		const uint32_t tile = rebuild.tiles[i];
+		if (rebuild.id > snapshot->rebuilds[tile]) {
+			snapshot->tiles[tile] = std::move(built[i]);
+			snapshot->rebuilds[tile] = rebuild.id;
+		}
+	}
+	for (size_t tile = 0; tile < snapshot->tiles.size(); tile++) {
+		const uint32_t count = snapshot->tiles[tile] ? static_cast<uint32_t>(snapshot->tiles[tile]->polys.size()) : 0;
+		snapshot->firstPolys[tile + 1] = snapshot->firstPolys[tile] + count;
+	}
+	snapshot->version++;
+	_snapshot = std::move(snapshot);
+}
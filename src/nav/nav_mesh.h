@@ -0,0 +1,96 @@
+#pragma once
+
+#include "core/job_system.h"
+#include "nav_tile.h"
+
+#include <condition_variable>
+
+namespace TGW::Nav {
+
+// The tiles queries see. Never changes once published, rebuilds publish a new one.
+struct NavSnapshot {
+	// Row major, nullptr for tiles not built yet
+	std::vector<std::shared_ptr<const NavTile>> tiles;
+	// Rebuild that produced each tile, a slower older rebuild never replaces a newer one
+	std::vector<uint64_t> rebuilds;
+	// Polygons of all tiles before each tile, and the total at the end. Gives every polygon a dense id.
+	std::vector<uint32_t> firstPolys;
+	uint64_t version = 0;
+
+	inline uint32_t GetPolyCount() const { return firstPolys.back(); }
+};
+
+// Tiled navmesh over the terrain and the static models on it. Tiles are built in parallel and each one only from the
+// geometry over it and its border, so placing or removing a building rebuilds just the tiles under it. Rebuilds run
+// in the background and are swapped in all at once, queries hold on to the snapshot they started with and never wait
+// for a build.
+//
+// Geometry and rebuilds are driven from one thread. The terrain is read by the rebuild jobs, it must not change while
+// rebuilds are pending.
+class NavMesh {
+  public:
+	// Covers size from origin on the ground plane, rounded up to whole tiles
+	NavMesh(const NavMeshSettings &settings, DirectX::XMFLOAT2 origin, DirectX::XMFLOAT2 size,
+		const Terrain::Heightmap *terrain = nullptr);
+	~NavMesh();
+
+	NavMesh(const NavMesh &) = delete;
+	NavMesh &operator=(const NavMesh &) = delete;
+
+	// Both mark the tiles under the geometry for the next rebuild
+	uint32_t AddGeometry(NavGeometry geometry);
+	void RemoveGeometry(uint32_t id);
+	// Call after changing terrain samples, typically with the dirty rects of a crater batch
+	void OnTerrainChanged(std::span<const Terrain::SampleRect> rects);
+
+	// Builds every tile and returns once they are published
+	void Build(JobSystem &jobs = JobSystem::Get());
+	// Starts rebuilding the tiles marked since the last call in the background and returns how many there are
+	uint32_t RebuildDirtyAsync(JobSystem &jobs = JobSystem::Get());
+	void WaitForRebuilds();
+	uint32_t GetPendingRebuilds() const;
+
+	// Safe from any thread
+	std::shared_ptr<const NavSnapshot> GetSnapshot() const;
+
+	inline const NavMeshSettings &GetSettings() const { return _settings; }
+	inline DirectX::XMFLOAT2 GetOrigin() const { return _origin; }
+	inline uint32_t GetTilesX() const { return _tilesX; }
+	inline uint32_t GetTilesZ() const { return _tilesZ; }
+	inline uint32_t GetDirtyTileCount() const { return static_cast<uint32_t>(_dirtyTiles.size()); }
+	// Tile under a world position, nothing outside the mesh
+	std::optional<uint32_t> GetTileIndex(float x, float z) const;
+
+  private:
+	struct Rebuild {
+		uint64_t id = 0;
+		std::vector<uint32_t> tiles;
+		// Held until the rebuild is done, so removing geometry does not pull it from under the jobs
+		std::vector<std::shared_ptr<const NavGeometry>> geometry;
+	};
+
+	void MarkDirty(float minX, float minZ, float maxX, float maxZ);
+	std::shared_ptr<Rebuild> TakeDirty();
+	void RunRebuild(const Rebuild &rebuild, JobSystem &jobs);
+
+	NavMeshSettings _settings;
+	DirectX::XMFLOAT2 _origin;
+	uint32_t _tilesX = 0;
+	uint32_t _tilesZ = 0;
+	const Terrain::Heightmap *_terrain = nullptr;
+
+	std::unordered_map<uint32_t, std::shared_ptr<const NavGeometry>> _geometry;
+	uint32_t _nextGeometryId = 0;
+	std::vector<uint8_t> _dirty;
+	std::vector<uint32_t> _dirtyTiles;
+	uint64_t _nextRebuild = 1;
+
+	mutable std::mutex _snapshotMutex;
+	std::shared_ptr<const NavSnapshot> _snapshot;
+
+	mutable std::mutex _pendingMutex;
+	std::condition_variable _pendingDone;
+	uint32_t _pending = 0;
+};
+
+} // namespace TGW::Nav
@@ -0,0 +1,266 @@
+#include "nav_query.h"
+
+using namespace TGW::Nav;
+using DirectX::XMFLOAT3;
+
+namespace {
+constexpr uint32_t NO_NODE = UINT32_MAX;
+// Search costs are whole centimetres
+constexpr float COST_SCALE = 100.0f;
+
+float GetDistance(const XMFLOAT3 &a, const XMFLOAT3 &b)
+{
+	const float dx = b.x - a.x, dy = b.y - a.y, dz = b.z - a.z;
+	return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+inline uint32_t GetCost(const XMFLOAT3 &a, const XMFLOAT3 &b)
+{
+	return static_cast<uint32_t>(GetDistance(a, b) * COST_SCALE);
+}
+
+// Positive when b lies counter clockwise of a on the ground plane, left of it looking along a
+inline float Cross(const XMFLOAT3 &origin, const XMFLOAT3 &a, const XMFLOAT3 &b)
+{
+	return (a.x - origin.x) * (b.z - origin.z) - (a.z - origin.z) * (b.x - origin.x);
+}
+
+inline bool IsSamePoint(const XMFLOAT3 &a, const XMFLOAT3 &b) { return a.x == b.x && a.z == b.z; }
+} // namespace
+
+NavPolyRef NavQuery::FindPoly(XMFLOAT3 position) const { return FindPoly(*_mesh.GetSnapshot(), position); }
+
+NavPolyRef NavQuery::FindPoly(const NavSnapshot &snapshot, XMFLOAT3 position) const
+{
+	const std::optional<uint32_t> tileIndex = _mesh.GetTileIndex(position.x, position.z);
+	if (!tileIndex || !snapshot.tiles[*tileIndex]) {
+		return {};
+	}
+	const NavTile &tile = *snapshot.tiles[*tileIndex];
+	const NavMeshSettings &settings = _mesh.GetSettings();
+	const float tileSize = settings.GetTileSize();
+	const float localX = position.x - _mesh.GetOrigin().x - tile.x * tileSize;
+	const float localZ = position.z - _mesh.GetOrigin().y - tile.z * tileSize;
+	const uint32_t cellX = std::min(static_cast<uint32_t>(localX / settings.cellSize), settings.tileCells - 1);
+	const uint32_t cellZ = std::min(static_cast<uint32_t>(localZ / settings.cellSize), settings.tileCells - 1);
+
+	NavPolyRef best;
+	float bestDistance = std::numeric_limits<float>::max();
+	for (uint16_t i = 0; i < tile.polys.size(); i++) {
+		const NavPoly &poly = tile.polys[i];
+		if (cellX < poly.minX || cellX >= poly.maxX || cellZ < poly.minZ || cellZ >= poly.maxZ) {
+			continue;
+		}
+		const float distance = std::abs(position.y - std::clamp(position.y, poly.minY, poly.maxY));
+		if (distance <= settings.agentHeight && distance < bestDistance) {
+			best = NavPolyRef{*tileIndex, i};
+			bestDistance = distance;
+		}
+	}
+	return best;
+}
+
+std::optional<float> NavQuery::FindPath(XMFLOAT3 start, XMFLOAT3 goal, std::vector<XMFLOAT3> &path)
+{
+	path.clear();
+	_corridor.clear();
+	const std::shared_ptr<const NavSnapshot> snapshot = _mesh.GetSnapshot();
+	const NavPolyRef startPoly = FindPoly(*snapshot, start);
+	const NavPolyRef goalPoly = FindPoly(*snapshot, goal);
+	if (!startPoly.IsValid() || !goalPoly.IsValid() || !SearchCorridor(*snapshot, startPoly, goalPoly, start, goal)) {
+		return {};
+	}
+	return PullString(start, goal, path);
+}
+
+/* Implementation of private functions */
+
+template <typename Fn> void NavQuery::ForEachNeighbour(const NavSnapshot &snapshot, NavPolyRef ref, Fn &&fn) const
+{
+	const NavTile &tile = *snapshot.tiles[ref.tile];
+	const NavPoly &poly = tile.polys[ref.poly];
+	for (uint32_t i = poly.firstLink; i < poly.firstLink + poly.linkCount; i++) {
+		const NavLink &link = tile.links[i];
+		fn(NavPolyRef{ref.tile, link.poly}, link.side, link.begin, link.end);
+	}
+
+	const float maxClimb = _mesh.GetSettings().maxClimb;
+	for (uint32_t side = 0; side < NAV_SIDE_COUNT; side++) {
+		const int32_t x = static_cast<int32_t>(tile.x) + NAV_SIDE_X[side];
+		const int32_t z = static_cast<int32_t>(tile.z) + NAV_SIDE_Z[side];
+		if (x < 0 || z < 0 || x >= static_cast<int32_t>(_mesh.GetTilesX()) || z >= static_cast<int32_t>(_mesh.GetTilesZ())) {
+			continue;
+		}
+		const uint32_t neighbourIndex = static_cast<uint32_t>(z) * _mesh.GetTilesX() + static_cast<uint32_t>(x);
+		const NavTile *neighbour = snapshot.tiles[neighbourIndex].get();
+		if (!neighbour) {
+			continue;
+		}
+		for (const NavBorderEdge &edge : tile.borders[side]) {
+			if (edge.poly != ref.poly) {
+				continue;
+			}
+			for (const NavBorderEdge &other : neighbour->borders[GetOppositeSide(static_cast<NavSide>(side))]) {
+				if (other.begin >= edge.end) {
+					break;
+				}
+				const uint16_t begin = std::max(edge.begin, other.begin);
+				const uint16_t end = std::min(edge.end, other.end);
+				if (begin < end && other.minY <= edge.maxY + maxClimb && other.maxY >= edge.minY - maxClimb) {
+					fn(NavPolyRef{neighbourIndex, other.poly}, static_cast<NavSide>(side), begin, end);
+				}
+			}
+		}
+	}
+}
+
+// The edge from shares with to over begin to end, left and right as seen walking from one into the other
+NavQuery::Portal NavQuery::GetPortal(const NavSnapshot &snapshot, NavPolyRef from, NavPolyRef to, NavSide side,
+	uint16_t begin, uint16_t end) const
+{
+	const NavTile &tile = *snapshot.tiles[from.tile];
+	const NavPoly &poly = tile.polys[from.poly];
+	const NavMeshSettings &settings = _mesh.GetSettings();
+	const float tileSize = settings.GetTileSize();
+	const float tileX = _mesh.GetOrigin().x + tile.x * tileSize;
+	const float tileZ = _mesh.GetOrigin().y + tile.z * tileSize;
+	const float y = (poly.y + snapshot.tiles[to.tile]->polys[to.poly].y) * 0.5f;
+	const float low = begin * settings.cellSize;
+	const float high = end * settings.cellSize;
+
+	switch (side) {
+	case NAV_SIDE_EAST: {
+		const float x = tileX + poly.maxX * settings.cellSize;
+		return {{x, y, tileZ + high}, {x, y, tileZ + low}};
+	}
+	case NAV_SIDE_NORTH: {
+		const float z = tileZ + poly.maxZ * settings.cellSize;
+		return {{tileX + low, y, z}, {tileX + high, y, z}};
+	}
+	case NAV_SIDE_WEST: {
+		const float x = tileX + poly.minX * settings.cellSize;
+		return {{x, y, tileZ + low}, {x, y, tileZ + high}};
+	}
+	default: {
+		const float z = tileZ + poly.minZ * settings.cellSize;
+		return {{tileX + high, y, z}, {tileX + low, y, z}};
+	}
+	}
+}
+
+bool NavQuery::SearchCorridor(const NavSnapshot &snapshot, NavPolyRef start, NavPolyRef goal, XMFLOAT3 startPosition,
+	XMFLOAT3 goalPosition)
+{
+	const uint32_t nodeCount = snapshot.GetPolyCount();
+	if (_states.size() < nodeCount) {
+		_states.resize(nodeCount, SearchState{0, NO_NODE, 0, {}, {}, NAV_SIDE_EAST, 0, 0, false});
+	}
+	_open.Reserve(nodeCount);
+	_open.Clear();
+	_stamp++;
+	_expanded = 0;
+
+	const auto getNode = [&snapshot](NavPolyRef ref) { return snapshot.firstPolys[ref.tile] + ref.poly; };
+	const uint32_t startNode = getNode(start);
+	const uint32_t goalNode = getNode(goal);
+	_states[startNode] = SearchState{0, NO_NODE, _stamp, start, startPosition, NAV_SIDE_EAST, 0, 0, false};
+	_open.Push(startNode, GetCost(startPosition, goalPosition));
+
+	bool found = false;
+	while (!_open.IsEmpty()) {
+		const uint32_t node = _open.Pop();
+		SearchState &state = _states[node];
+		state.closed = true;
+		_expanded++;
+		if (node == goalNode) {
+			found = true;
+			break;
+		}
+		const NavPolyRef ref = state.ref;
+		const XMFLOAT3 position = state.position;
+		const uint32_t cost = state.cost;
+		ForEachNeighbour(snapshot, ref, [&](NavPolyRef next, NavSide side, uint16_t begin, uint16_t end) {
+			const uint32_t nextNode = getNode(next);
+			SearchState &nextState = _states[nextNode];
+			if (nextState.stamp == _stamp && nextState.closed) {
+				return;
+			}
+			// Through the middle of the shared edge, straight on to the goal once in its polygon
+			const Portal portal = GetPortal(snapshot, ref, next, side, begin, end);
+			const XMFLOAT3 middle{(portal.left.x + portal.right.x) * 0.5f, portal.left.y,
+				(portal.left.z + portal.right.z) * 0.5f};
+			const uint32_t remaining = GetCost(middle, goalPosition);
+			const uint32_t nextCost = cost + GetCost(position, middle) + (nextNode == goalNode ? remaining : 0);
+			if (nextState.stamp == _stamp && nextState.cost <= nextCost) {
+				return;
+			}
+			nextState = SearchState{nextCost, node, _stamp, next, middle, side, begin, end, false};
+			_open.Push(nextNode, nextNode == goalNode ? nextCost : nextCost + remaining);
+		});
+	}
+	if (!found) {
+		return false;
+	}
+
+	_portals.clear();
+	for (uint32_t node = goalNode; node != startNode; node = _states[node].parent) {
+		const SearchState &state = _states[node];
+		_corridor.push_back(state.ref);
+		_portals.push_back(GetPortal(snapshot, _states[state.parent].ref, state.ref, state.side, state.begin, state.end));
+	}
+	_corridor.push_back(start);
+	std::reverse(_corridor.begin(), _corridor.end());
+	std::reverse(_portals.begin(), _portals.end());
+	return true;
+}
+
+// Simple stupid funnel algorithm: the funnel from the apex narrows portal by portal, and when one side crosses the
+// other the crossed corner becomes a corner of the path and the new apex
+float NavQuery::PullString(XMFLOAT3 start, XMFLOAT3 goal, std::vector<XMFLOAT3> &path) const
+{
+	std::vector<Portal> portals;
+	portals.reserve(_portals.size() + 2);
+	portals.push_back({start, start});
+	portals.insert(portals.end(), _portals.begin(), _portals.end());
+	portals.push_back({goal, goal});
+
+	path.push_back(start);
+	XMFLOAT3 apex = start, left = start, right = start;
+	size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+	for (size_t i = 1; i < portals.size(); i++) {
+		const Portal &portal = portals[i];
+		if (Cross(apex, right, portal.right) >= 0.0f) {
+			if (IsSamePoint(apex, right) || Cross(apex, left, portal.right) < 0.0f) {
+				right = portal.right;
+				rightIndex = i;
+			} else {
+				path.push_back(left);
+				apex = right = left;
+				apexIndex = rightIndex = leftIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+		if (Cross(apex, left, portal.left) <= 0.0f) {
+			if (IsSamePoint(apex, left) || Cross(apex, right, portal.left) > 0.0f) {
+				left = portal.left;
+				leftIndex = i;
+			} else {
+				path.push_back(right);
+				apex = left = right;
+				apexIndex = leftIndex = rightIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+	}
+	if (!IsSamePoint(path.back(), goal)) {
+		path.push_back(goal);
+	}
+
+	float length = 0.0f;
+	for (size_t i = 1; i < path.size(); i++) {
+		length += GetDistance(path[i - 1], path[i]);
+	}
+	return length;
+}
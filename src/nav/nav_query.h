@@ -0,0 +1,73 @@
+#pragma once
+
+#include "nav_mesh.h"
+#include "sim/node_heap.h"
+
+namespace TGW::Nav {
+
+struct NavPolyRef {
+	uint32_t tile = UINT32_MAX;
+	uint16_t poly = NAV_NO_POLY;
+
+	inline bool IsValid() const { return poly != NAV_NO_POLY; }
+	bool operator==(const NavPolyRef &) const = default;
+};
+
+// A* over the polygons of a navmesh snapshot, then the funnel algorithm through the shared edges for the corners of
+// the path. Each query takes the snapshot current when it starts, tiles swapped in during the query are seen by the
+// next one. Search state is kept between queries and only grows, not thread safe, give every thread its own query.
+class NavQuery {
+  public:
+	explicit NavQuery(const NavMesh &mesh) : _mesh{mesh} {}
+
+	// Polygon under a position, the closest in height where floors are stacked. Positions higher than an agent above
+	// any ground do not count as on it.
+	NavPolyRef FindPoly(DirectX::XMFLOAT3 position) const;
+	NavPolyRef FindPoly(const NavSnapshot &snapshot, DirectX::XMFLOAT3 position) const;
+
+	// Fills path with the corners from start to goal, both included, and returns its length. Nothing when either end
+	// is off the mesh or the goal cannot be reached.
+	std::optional<float> FindPath(DirectX::XMFLOAT3 start, DirectX::XMFLOAT3 goal, std::vector<DirectX::XMFLOAT3> &path);
+
+	// Polygons of the last path found, start first
+	inline const std::vector<NavPolyRef> &GetCorridor() const { return _corridor; }
+	inline uint32_t GetExpandedCount() const { return _expanded; }
+
+  private:
+	struct SearchState {
+		uint32_t cost;
+		uint32_t parent;
+		uint32_t stamp;
+		NavPolyRef ref;
+		// Middle of the edge it was entered through, costs are measured between these
+		DirectX::XMFLOAT3 position;
+		// The edge of the parent it was entered through, in cells of the parent's tile
+		NavSide side;
+		uint16_t begin;
+		uint16_t end;
+		bool closed;
+	};
+
+	struct Portal {
+		DirectX::XMFLOAT3 left;
+		DirectX::XMFLOAT3 right;
+	};
+
+	// Calls fn(neighbour, side, begin, end) for every polygon sharing an edge with ref, the overlap in cells of ref
+	template <typename Fn> void ForEachNeighbour(const NavSnapshot &snapshot, NavPolyRef ref, Fn &&fn) const;
+	Portal GetPortal(const NavSnapshot &snapshot, NavPolyRef from, NavPolyRef to, NavSide side, uint16_t begin,
+		uint16_t end) const;
+	bool SearchCorridor(const NavSnapshot &snapshot, NavPolyRef start, NavPolyRef goal, DirectX::XMFLOAT3 startPosition,
+		DirectX::XMFLOAT3 goalPosition);
+	float PullString(DirectX::XMFLOAT3 start, DirectX::XMFLOAT3 goal, std::vector<DirectX::XMFLOAT3> &path) const;
+
+	const NavMesh &_mesh;
+	Sim::NodeHeap _open;
+	std::vector<SearchState> _states;
+	std::vector<NavPolyRef> _corridor;
+	std::vector<Portal> _portals;
+	uint32_t _stamp = 0;
+	uint32_t _expanded = 0;
+};
+
+} // namespace TGW::Nav
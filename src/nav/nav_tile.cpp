@@ -0,0 +1,560 @@
+#include "nav_tile.h"
+
+using namespace TGW::Nav;
+using DirectX::XMFLOAT3;
+
+namespace {
+constexpr uint32_t NO_SPAN = UINT32_MAX;
+constexpr uint16_t NO_DISTANCE = UINT16_MAX;
+constexpr uint32_t MAX_CLIPPED_POINTS = 12;
+
+// Solid interval of a voxel column, walkable when its top is
+struct RawSpan {
+	float min;
+	float max;
+	uint32_t next;
+	bool walkable;
+};
+
+// Top of a walkable span and the first solid above it
+struct OpenSpan {
+	float y;
+	float ceiling;
+	uint32_t neighbours[NAV_SIDE_COUNT];
+};
+
+struct ClipPolygon {
+	std::array<XMFLOAT3, MAX_CLIPPED_POINTS> points;
+	uint32_t count = 0;
+};
+
+inline float GetAxis(const XMFLOAT3 &point, uint32_t axis) { return axis == 0 ? point.x : point.z; }
+
+// Splits a convex polygon where the coordinate along axis (0 for X, 2 for Z) equals offset
+void SplitPolygon(const ClipPolygon &in, ClipPolygon &below, ClipPolygon &above, float offset, uint32_t axis)
+{
+	below.count = 0;
+	above.count = 0;
+	for (uint32_t i = 0, j = in.count - 1; i < in.count; j = i, i++) {
+		const float distanceJ = GetAxis(in.points[j], axis) - offset;
+		const float distanceI = GetAxis(in.points[i], axis) - offset;
+		if ((distanceJ < 0.0f) != (distanceI < 0.0f)) {
+			const float t = distanceJ / (distanceJ - distanceI);
+			const XMFLOAT3 &a = in.points[j];
+			const XMFLOAT3 &b = in.points[i];
+			const XMFLOAT3 crossing{a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t};
+			below.points[below.count++] = crossing;
+			above.points[above.count++] = crossing;
+		}
+		if (distanceI < 0.0f) {
+			below.points[below.count++] = in.points[i];
+		} else if (distanceI > 0.0f) {
+			above.points[above.count++] = in.points[i];
+		} else {
+			below.points[below.count++] = in.points[i];
+			above.points[above.count++] = in.points[i];
+		}
+	}
+}
+
+// Voxel columns over a tile and its border
+class Heightfield {
+  public:
+	Heightfield(const NavMeshSettings &settings, const NavTileInput &input)
+		: _settings{settings}, _border{settings.GetBorderCells()}, _side{settings.tileCells + 2 * _border}
+	{
+		const float tileSize = settings.GetTileSize();
+		_minX = input.origin.x + input.x * tileSize - _border * settings.cellSize;
+		_minZ = input.origin.y + input.z * tileSize - _border * settings.cellSize;
+		_columns.assign(size_t{_side} * _side, NO_SPAN);
+		// Horizontal ground has a normal of y 1, ground as steep as maxSlope one of 1 / sqrt(1 + maxSlope^2)
+		_minNormalY = 1.0f / std::sqrt(1.0f + settings.maxSlope * settings.maxSlope);
+	}
+
+	inline uint32_t GetBorder() const { return _border; }
+	inline uint32_t GetSide() const { return _side; }
+	inline float GetMinX() const { return _minX; }
+	inline float GetMinZ() const { return _minZ; }
+	inline float GetMaxX() const { return _minX + _side * _settings.cellSize; }
+	inline float GetMaxZ() const { return _minZ + _side * _settings.cellSize; }
+	inline uint32_t GetFirstSpan(uint32_t column) const { return _columns[column]; }
+	inline const RawSpan &GetSpan(uint32_t span) const { return _spans[span]; }
+
+	void RasterizeTriangle(const XMFLOAT3 &a, const XMFLOAT3 &b, const XMFLOAT3 &c)
+	{
+		const float minX = std::min({a.x, b.x, c.x}), maxX = std::max({a.x, b.x, c.x});
+		const float minZ = std::min({a.z, b.z, c.z}), maxZ = std::max({a.z, b.z, c.z});
+		if (maxX < _minX || minX >= GetMaxX() || maxZ < _minZ || minZ >= GetMaxZ()) {
+			return;
+		}
+
+		// Slope from the face normal, whichever way the triangle winds
+		const XMFLOAT3 ab{b.x - a.x, b.y - a.y, b.z - a.z};
+		const XMFLOAT3 ac{c.x - a.x, c.y - a.y, c.z - a.z};
+		const XMFLOAT3 normal{ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x};
+		const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		const bool walkable = length > 0.0f && std::abs(normal.y) >= _minNormalY * length;
+
+		const float cellSize = _settings.cellSize;
+		const int32_t lastCell = static_cast<int32_t>(_side) - 1;
+		const int32_t z0 = std::clamp(static_cast<int32_t>(std::floor((minZ - _minZ) / cellSize)), 0, lastCell);
+		const int32_t z1 = std::clamp(static_cast<int32_t>(std::floor((maxZ - _minZ) / cellSize)), 0, lastCell);
+		const int32_t x0 = std::clamp(static_cast<int32_t>(std::floor((minX - _minX) / cellSize)), 0, lastCell);
+		const int32_t x1 = std::clamp(static_cast<int32_t>(std::floor((maxX - _minX) / cellSize)), 0, lastCell);
+
+		ClipPolygon rest, row, cell, rowRest, discard;
+		rest.points[0] = a;
+		rest.points[1] = b;
+		rest.points[2] = c;
+		rest.count = 3;
+		// Whatever lies before the first row or column is outside the heightfield
+		SplitPolygon(ClipPolygon{rest}, discard, rest, _minZ + z0 * cellSize, 2);
+		for (int32_t z = z0; z <= z1 && rest.count >= 3; z++) {
+			SplitPolygon(ClipPolygon{rest}, row, rest, _minZ + (z + 1) * cellSize, 2);
+			if (row.count < 3) {
+				continue;
+			}
+			SplitPolygon(ClipPolygon{row}, discard, row, _minX + x0 * cellSize, 0);
+			for (int32_t x = x0; x <= x1 && row.count >= 3; x++) {
+				SplitPolygon(row, cell, rowRest, _minX + (x + 1) * cellSize, 0);
+				row = rowRest;
+				if (cell.count < 3) {
+					continue;
+				}
+				float low = cell.points[0].y, high = cell.points[0].y;
+				for (uint32_t i = 1; i < cell.count; i++) {
+					low = std::min(low, cell.points[i].y);
+					high = std::max(high, cell.points[i].y);
+				}
+				AddSpan(static_cast<uint32_t>(z) * _side + x, low, high, walkable);
+			}
+		}
+	}
+
+  private:
+	// Overlapping spans merge. The merged top is walkable if the top that wins is, tops within a climb of each other
+	// are both walked on.
+	void AddSpan(uint32_t column, float min, float max, bool walkable)
+	{
+		uint32_t previous = NO_SPAN;
+		uint32_t current = _columns[column];
+		while (current != NO_SPAN) {
+			const RawSpan &span = _spans[current];
+			if (span.min > max) {
+				break;
+			}
+			if (span.max < min) {
+				previous = current;
+				current = span.next;
+				continue;
+			}
+			if (span.max > max + _settings.maxClimb) {
+				walkable = span.walkable;
+			} else if (span.max >= max - _settings.maxClimb) {
+				walkable = walkable || span.walkable;
+			}
+			min = std::min(min, span.min);
+			max = std::max(max, span.max);
+			const uint32_t next = span.next;
+			Free(current);
+			current = next;
+			if (previous == NO_SPAN) {
+				_columns[column] = next;
+			} else {
+				_spans[previous].next = next;
+			}
+		}
+
+		const uint32_t added = Allocate();
+		_spans[added] = RawSpan{min, max, current, walkable};
+		if (previous == NO_SPAN) {
+			_columns[column] = added;
+		} else {
+			_spans[previous].next = added;
+		}
+	}
+
+	uint32_t Allocate()
+	{
+		if (_freeSpans.empty()) {
+			_spans.emplace_back();
+			return static_cast<uint32_t>(_spans.size() - 1);
+		}
+		const uint32_t span = _freeSpans.back();
+		_freeSpans.pop_back();
+		return span;
+	}
+	inline void Free(uint32_t span) { _freeSpans.push_back(span); }
+
+	const NavMeshSettings &_settings;
+	uint32_t _border;
+	uint32_t _side;
+	float _minX = 0.0f;
+	float _minZ = 0.0f;
+	float _minNormalY = 0.0f;
+	std::vector<uint32_t> _columns;
+	std::vector<RawSpan> _spans;
+	std::vector<uint32_t> _freeSpans;
+};
+
+// Two triangles per quad of terrain samples under the heightfield
+void RasterizeTerrain(Heightfield &field, const TGW::Terrain::Heightmap &terrain)
+{
+	const float spacing = terrain.GetSpacing();
+	const DirectX::XMFLOAT2 origin = terrain.GetOrigin();
+	const auto toSample = [spacing](float position, float start, uint32_t count) {
+		const float sample = std::floor((position - start) / spacing);
+		return static_cast<uint32_t>(std::clamp(sample, 0.0f, static_cast<float>(count - 2)));
+	};
+	const uint32_t minX = toSample(field.GetMinX(), origin.x, terrain.GetWidth());
+	const uint32_t maxX = toSample(field.GetMaxX(), origin.x, terrain.GetWidth());
+	const uint32_t minZ = toSample(field.GetMinZ(), origin.y, terrain.GetHeight());
+	const uint32_t maxZ = toSample(field.GetMaxZ(), origin.y, terrain.GetHeight());
+	for (uint32_t z = minZ; z <= maxZ; z++) {
+		for (uint32_t x = minX; x <= maxX; x++) {
+			const float x0 = origin.x + x * spacing, x1 = x0 + spacing;
+			const float z0 = origin.y + z * spacing, z1 = z0 + spacing;
+			const XMFLOAT3 p00{x0, terrain.GetSample(x, z), z0};
+			const XMFLOAT3 p10{x1, terrain.GetSample(x + 1, z), z0};
+			const XMFLOAT3 p01{x0, terrain.GetSample(x, z + 1), z1};
+			const XMFLOAT3 p11{x1, terrain.GetSample(x + 1, z + 1), z1};
+			field.RasterizeTriangle(p00, p01, p11);
+			field.RasterizeTriangle(p00, p11, p10);
+		}
+	}
+}
+
+void RasterizeGeometry(Heightfield &field, const NavGeometry &geometry)
+{
+	if (geometry.boundsMax.x < field.GetMinX() || geometry.boundsMin.x >= field.GetMaxX() ||
+		geometry.boundsMax.z < field.GetMinZ() || geometry.boundsMin.z >= field.GetMaxZ()) {
+		return;
+	}
+	for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3) {
+		field.RasterizeTriangle(geometry.vertices[geometry.indices[i]], geometry.vertices[geometry.indices[i + 1]],
+			geometry.vertices[geometry.indices[i + 2]]);
+	}
+}
+
+// The walkable tops of a heightfield and how they connect, eroded by the agent radius
+class OpenField {
+  public:
+	OpenField(const NavMeshSettings &settings, const Heightfield &field) : _side{field.GetSide()}
+	{
+		_columnStarts.resize(size_t{_side} * _side + 1);
+		for (uint32_t column = 0; column < _side * _side; column++) {
+			_columnStarts[column] = static_cast<uint32_t>(_spans.size());
+			for (uint32_t span = field.GetFirstSpan(column); span != NO_SPAN; span = field.GetSpan(span).next) {
+				const RawSpan &raw = field.GetSpan(span);
+				const float ceiling =
+					raw.next == NO_SPAN ? std::numeric_limits<float>::max() : field.GetSpan(raw.next).min;
+				if (raw.walkable && ceiling - raw.max >= settings.agentHeight) {
+					_spans.push_back(OpenSpan{raw.max, ceiling, {NO_SPAN, NO_SPAN, NO_SPAN, NO_SPAN}});
+				}
+			}
+		}
+		_columnStarts.back() = static_cast<uint32_t>(_spans.size());
+
+		for (uint32_t z = 0; z < _side; z++) {
+			for (uint32_t x = 0; x < _side; x++) {
+				Connect(settings, x, z);
+			}
+		}
+		Erode(static_cast<uint32_t>(std::ceil(settings.agentRadius / settings.cellSize)));
+	}
+
+	inline uint32_t GetColumnStart(uint32_t x, uint32_t z) const { return _columnStarts[z * _side + x]; }
+	inline uint32_t GetColumnEnd(uint32_t x, uint32_t z) const { return _columnStarts[z * _side + x + 1]; }
+	inline const OpenSpan &GetSpan(uint32_t span) const { return _spans[span]; }
+	inline bool IsOpen(uint32_t span) const { return span != NO_SPAN && !_eroded[span]; }
+	inline uint32_t GetSpanCount() const { return static_cast<uint32_t>(_spans.size()); }
+	// Neighbour of an open span that survived erosion, or NO_SPAN
+	inline uint32_t GetNeighbour(uint32_t span, NavSide side) const
+	{
+		const uint32_t neighbour = _spans[span].neighbours[side];
+		return IsOpen(neighbour) ? neighbour : NO_SPAN;
+	}
+
+  private:
+	// Lowest span of each neighbouring column that is within a climb and leaves room for the agent in between
+	void Connect(const NavMeshSettings &settings, uint32_t x, uint32_t z)
+	{
+		for (uint32_t span = GetColumnStart(x, z); span < GetColumnEnd(x, z); span++) {
+			OpenSpan &open = _spans[span];
+			for (uint32_t side = 0; side < NAV_SIDE_COUNT; side++) {
+				const int32_t nx = static_cast<int32_t>(x) + NAV_SIDE_X[side];
+				const int32_t nz = static_cast<int32_t>(z) + NAV_SIDE_Z[side];
+				if (nx < 0 || nz < 0 || nx >= static_cast<int32_t>(_side) || nz >= static_cast<int32_t>(_side)) {
+					continue;
+				}
+				for (uint32_t other = GetColumnStart(nx, nz); other < GetColumnEnd(nx, nz); other++) {
+					const OpenSpan &neighbour = _spans[other];
+					const float gap = std::min(open.ceiling, neighbour.ceiling) - std::max(open.y, neighbour.y);
+					if (std::abs(neighbour.y - open.y) <= settings.maxClimb && gap >= settings.agentHeight) {
+						open.neighbours[side] = other;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// Spans closer than radius cells to an edge go, measured over the 8 neighbours so corners are not cut
+	void Erode(uint32_t radius)
+	{
+		_eroded.assign(_spans.size(), 0);
+		if (radius == 0) {
+			return;
+		}
+		std::vector<uint16_t> distances(_spans.size(), NO_DISTANCE);
+		std::vector<uint32_t> queue;
+		for (uint32_t span = 0; span < _spans.size(); span++) {
+			const uint32_t *neighbours = _spans[span].neighbours;
+			if (std::find(neighbours, neighbours + NAV_SIDE_COUNT, NO_SPAN) != neighbours + NAV_SIDE_COUNT) {
+				distances[span] = 0;
+				queue.push_back(span);
+			}
+		}
+		for (size_t head = 0; head < queue.size(); head++) {
+			const uint32_t span = queue[head];
+			const uint16_t distance = distances[span] + 1;
+			if (distance >= radius) {
+				continue;
+			}
+			const auto visit = [&](uint32_t neighbour) {
+				if (neighbour != NO_SPAN && distances[neighbour] > distance) {
+					distances[neighbour] = distance;
+					queue.push_back(neighbour);
+				}
+			};
+			for (uint32_t side = 0; side < NAV_SIDE_COUNT; side++) {
+				const uint32_t straight = _spans[span].neighbours[side];
+				visit(straight);
+				// The diagonal between this side and the next, through either of the two
+				const uint32_t next = (side + 1) % NAV_SIDE_COUNT;
+				uint32_t diagonal = straight != NO_SPAN ? _spans[straight].neighbours[next] : NO_SPAN;
+				if (diagonal == NO_SPAN && _spans[span].neighbours[next] != NO_SPAN) {
+					diagonal = _spans[_spans[span].neighbours[next]].neighbours[side];
+				}
+				visit(diagonal);
+			}
+		}
+		for (uint32_t span = 0; span < _spans.size(); span++) {
+			_eroded[span] = distances[span] < radius;
+		}
+	}
+
+	uint32_t _side;
+	std::vector<uint32_t> _columnStarts;
+	std::vector<OpenSpan> _spans;
+	std::vector<uint8_t> _eroded;
+};
+
+// Greedy rectangles over the open spans of the tile, without its border
+class PolyBuilder {
+  public:
+	PolyBuilder(const NavMeshSettings &settings, const OpenField &field, uint32_t border)
+		: _field{field}, _border{border}, _end{border + settings.tileCells}
+	{
+		_polys.assign(field.GetSpanCount(), NAV_NO_POLY);
+	}
+
+	void Build(NavTile &tile)
+	{
+		std::vector<uint32_t> row, next, cells;
+		for (uint32_t z = _border; z < _end; z++) {
+			for (uint32_t x = _border; x < _end; x++) {
+				for (uint32_t span = _field.GetColumnStart(x, z); span < _field.GetColumnEnd(x, z); span++) {
+					if (!IsFree(span, x, z)) {
+						continue;
+					}
+					// As wide as the row allows, then as many rows as are free and connected across
+					row.assign(1, span);
+					while (row.size() < NAV_MAX_POLY_CELLS) {
+						const uint32_t east = _field.GetNeighbour(row.back(), NAV_SIDE_EAST);
+						if (!IsFree(east, x + static_cast<uint32_t>(row.size()), z)) {
+							break;
+						}
+						row.push_back(east);
+					}
+					cells = row;
+					uint32_t rows = 1;
+					while (rows < NAV_MAX_POLY_CELLS && GetNextRow(row, x, z + rows, next)) {
+						cells.insert(cells.end(), next.begin(), next.end());
+						row.swap(next);
+						rows++;
+					}
+					AddPoly(tile, cells, x, z, static_cast<uint32_t>(row.size()), rows);
+				}
+			}
+		}
+		for (uint16_t poly = 0; poly < tile.polys.size(); poly++) {
+			AddLinks(tile, poly);
+		}
+	}
+
+  private:
+	inline bool IsInside(uint32_t x, uint32_t z) const { return x >= _border && x < _end && z >= _border && z < _end; }
+	inline bool IsFree(uint32_t span, uint32_t x, uint32_t z) const
+	{
+		return _field.IsOpen(span) && IsInside(x, z) && _polys[span] == NAV_NO_POLY;
+	}
+
+	bool GetNextRow(const std::vector<uint32_t> &row, uint32_t x, uint32_t z, std::vector<uint32_t> &next) const
+	{
+		next.clear();
+		for (uint32_t i = 0; i < row.size(); i++) {
+			const uint32_t north = _field.GetNeighbour(row[i], NAV_SIDE_NORTH);
+			if (!IsFree(north, x + i, z) || (i > 0 && _field.GetNeighbour(next.back(), NAV_SIDE_EAST) != north)) {
+				return false;
+			}
+			next.push_back(north);
+		}
+		return true;
+	}
+
+	void AddPoly(NavTile &tile, const std::vector<uint32_t> &cells, uint32_t x, uint32_t z, uint32_t width, uint32_t depth)
+	{
+		const uint16_t id = static_cast<uint16_t>(tile.polys.size());
+		NavPoly poly{
+		  .minX = static_cast<uint16_t>(x - _border),
+		  .minZ = static_cast<uint16_t>(z - _border),
+		  .maxX = static_cast<uint16_t>(x - _border + width),
+		  .maxZ = static_cast<uint16_t>(z - _border + depth),
+		  .y = 0.0f,
+		  .minY = std::numeric_limits<float>::max(),
+		  .maxY = std::numeric_limits<float>::lowest(),
+		  .firstLink = 0,
+		  .linkCount = 0,
+		};
+		double sum = 0.0;
+		for (const uint32_t span : cells) {
+			const float y = _field.GetSpan(span).y;
+			sum += y;
+			poly.minY = std::min(poly.minY, y);
+			poly.maxY = std::max(poly.maxY, y);
+			_polys[span] = id;
+		}
+		poly.y = static_cast<float>(sum / cells.size());
+		tile.polys.push_back(poly);
+	}
+
+	// Span of poly in the column at x, z of the field
+	uint32_t FindSpan(uint16_t poly, uint32_t x, uint32_t z) const
+	{
+		for (uint32_t span = _field.GetColumnStart(x, z); span < _field.GetColumnEnd(x, z); span++) {
+			if (_polys[span] == poly) {
+				return span;
+			}
+		}
+		return NO_SPAN;
+	}
+
+	// Walks each side cell by cell, runs of the same polygon beyond become links, runs of open ground beyond the
+	// tile edge become border edges
+	void AddLinks(NavTile &tile, uint16_t id)
+	{
+		NavPoly &poly = tile.polys[id];
+		poly.firstLink = static_cast<uint32_t>(tile.links.size());
+		for (uint32_t side = 0; side < NAV_SIDE_COUNT; side++) {
+			const bool alongX = side == NAV_SIDE_NORTH || side == NAV_SIDE_SOUTH;
+			const uint32_t begin = alongX ? poly.minX : poly.minZ;
+			const uint32_t end = alongX ? poly.maxX : poly.maxZ;
+			const uint32_t fixed = side == NAV_SIDE_EAST ? poly.maxX - 1u
+				: side == NAV_SIDE_NORTH				 ? poly.maxZ - 1u
+				: side == NAV_SIDE_WEST					 ? poly.minX
+														 : poly.minZ;
+			const uint32_t outside = fixed + _border + (side == NAV_SIDE_EAST || side == NAV_SIDE_NORTH ? 1 : -1);
+			const bool onTileEdge = outside < _border || outside >= _end;
+
+			uint16_t runPoly = NAV_NO_POLY;
+			uint32_t runBegin = 0;
+			float runMinY = 0.0f, runMaxY = 0.0f;
+			const auto closeRun = [&](uint32_t runEnd) {
+				if (runPoly == NAV_NO_POLY) {
+					return;
+				}
+				if (onTileEdge) {
+					tile.borders[side].push_back(NavBorderEdge{id, static_cast<uint16_t>(runBegin),
+						static_cast<uint16_t>(runEnd), runMinY, runMaxY});
+				} else {
+					tile.links.push_back(NavLink{runPoly, static_cast<NavSide>(side), static_cast<uint16_t>(runBegin),
+						static_cast<uint16_t>(runEnd)});
+				}
+				runPoly = NAV_NO_POLY;
+			};
+
+			for (uint32_t i = begin; i < end; i++) {
+				const uint32_t x = (alongX ? i : fixed) + _border;
+				const uint32_t z = (alongX ? fixed : i) + _border;
+				const uint32_t inner = FindSpan(id, x, z);
+				const uint32_t outer = _field.GetNeighbour(inner, static_cast<NavSide>(side));
+				// Beyond the tile edge there are no polygons yet, any open ground will do
+				const uint16_t across = outer == NO_SPAN ? NAV_NO_POLY : onTileEdge ? id : _polys[outer];
+				const float y = _field.GetSpan(inner).y;
+				if (across != runPoly) {
+					closeRun(i);
+					runPoly = across;
+					runBegin = i;
+					runMinY = y;
+					runMaxY = y;
+				} else {
+					runMinY = std::min(runMinY, y);
+					runMaxY = std::max(runMaxY, y);
+				}
+			}
+			closeRun(end);
+		}
+		poly.linkCount = static_cast<uint32_t>(tile.links.size()) - poly.firstLink;
+	}
+
+	const OpenField &_field;
+	uint32_t _border;
+	uint32_t _end;
+	std::vector<uint16_t> _polys;
+};
+} // namespace
+
+/* Implementation of public functions */
+
+NavGeometry NavGeometry::FromMeshes(std::span<const MeshData> meshes, DirectX::FXMMATRIX world)
+{
+	NavGeometry geometry;
+	XMFLOAT3 &low = geometry.boundsMin;
+	XMFLOAT3 &high = geometry.boundsMax;
+	low = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+	high = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+	for (const MeshData &mesh : meshes) {
+		const uint32_t base = static_cast<uint32_t>(geometry.vertices.size());
+		for (const Vertex &vertex : mesh.vertices) {
+			XMFLOAT3 position;
+			DirectX::XMStoreFloat3(&position, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&vertex.position), world));
+			low = {std::min(low.x, position.x), std::min(low.y, position.y), std::min(low.z, position.z)};
+			high = {std::max(high.x, position.x), std::max(high.y, position.y), std::max(high.z, position.z)};
+			geometry.vertices.push_back(position);
+		}
+		for (const uint32_t index : mesh.indices) {
+			geometry.indices.push_back(base + index);
+		}
+	}
+	if (geometry.vertices.empty()) {
+		low = high = {};
+	}
+	return geometry;
+}
+
+NavTile TGW::Nav::BuildNavTile(const NavMeshSettings &settings, const NavTileInput &input)
+{
+	Heightfield heightfield{settings, input};
+	if (input.terrain && !input.terrain->IsEmpty()) {
+		RasterizeTerrain(heightfield, *input.terrain);
+	}
+	for (const NavGeometry *geometry : input.geometry) {
+		RasterizeGeometry(heightfield, *geometry);
+	}
+
+	const OpenField field{settings, heightfield};
+	NavTile tile{.x = input.x, .z = input.z, .polys = {}, .links = {}, .borders = {}};
+	PolyBuilder{settings, field, heightfield.GetBorder()}.Build(tile);
+	return tile;
+}
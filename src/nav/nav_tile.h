@@ -0,0 +1,112 @@
+#pragma once
+
+#include "mesh_data.h"
+#include "terrain/heightmap.h"
+
+#include <span>
+
+namespace TGW::Nav {
+
+constexpr uint16_t NAV_NO_POLY = UINT16_MAX;
+// Polygons are rectangles of walkable cells, at most this many cells on a side
+constexpr uint32_t NAV_MAX_POLY_CELLS = 16;
+
+// Sides of a cell or a tile, counter clockwise from +X
+enum NavSide : uint8_t {
+	NAV_SIDE_EAST,
+	NAV_SIDE_NORTH,
+	NAV_SIDE_WEST,
+	NAV_SIDE_SOUTH,
+	NAV_SIDE_COUNT,
+};
+constexpr int32_t NAV_SIDE_X[NAV_SIDE_COUNT] = {1, 0, -1, 0};
+constexpr int32_t NAV_SIDE_Z[NAV_SIDE_COUNT] = {0, 1, 0, -1};
+
+inline NavSide GetOppositeSide(NavSide side) { return static_cast<NavSide>((side + 2) % NAV_SIDE_COUNT); }
+
+// One navmesh per agent size, a tank and a jeep get their own
+struct NavMeshSettings {
+	// Voxel side on the ground plane
+	float cellSize = 0.5f;
+	// Tile side in cells
+	uint32_t tileCells = 64;
+	// Walkable ground is shrunk by this, so the agent centre can go anywhere on the mesh
+	float agentRadius = 0.5f;
+	// Free space needed above the ground
+	float agentHeight = 2.0f;
+	// Steps up or down to this are walked over
+	float maxClimb = 0.5f;
+	// Rise over run above which ground cannot be walked, 1 is 45 degrees
+	float maxSlope = 1.0f;
+
+	inline float GetTileSize() const { return cellSize * tileCells; }
+	// Cells voxelized around a tile so the erosion at its edges sees the ground beyond
+	inline uint32_t GetBorderCells() const { return static_cast<uint32_t>(std::ceil(agentRadius / cellSize)) + 1; }
+};
+
+// World space triangles of a placed static model, the meshes LoadMesh gives moved by the model transform
+struct NavGeometry {
+	std::vector<DirectX::XMFLOAT3> vertices;
+	std::vector<uint32_t> indices;
+	DirectX::XMFLOAT3 boundsMin{0.0f, 0.0f, 0.0f};
+	DirectX::XMFLOAT3 boundsMax{0.0f, 0.0f, 0.0f};
+
+	static NavGeometry FromMeshes(std::span<const MeshData> meshes, DirectX::FXMMATRIX world);
+};
+
+// A rectangle of cells of the tile, half open, and the height of the ground over it
+struct NavPoly {
+	uint16_t minX = 0;
+	uint16_t minZ = 0;
+	uint16_t maxX = 0;
+	uint16_t maxZ = 0;
+	float y = 0.0f; // mean
+	float minY = 0.0f;
+	float maxY = 0.0f;
+	uint32_t firstLink = 0;
+	uint32_t linkCount = 0;
+};
+
+// The part of a polygon side shared with another polygon of the same tile, in cells along the side
+struct NavLink {
+	uint16_t poly = NAV_NO_POLY;
+	NavSide side = NAV_SIDE_EAST;
+	uint16_t begin = 0;
+	uint16_t end = 0;
+};
+
+// A run of a polygon side along the tile edge with walkable ground beyond it. Matched against the opposite edge of
+// the neighbour tile when searching, so a tile can be rebuilt without touching its neighbours.
+struct NavBorderEdge {
+	uint16_t poly = NAV_NO_POLY;
+	uint16_t begin = 0;
+	uint16_t end = 0;
+	float minY = 0.0f;
+	float maxY = 0.0f;
+};
+
+struct NavTile {
+	uint32_t x = 0;
+	uint32_t z = 0;
+	std::vector<NavPoly> polys;
+	// Grouped by polygon, see NavPoly::firstLink
+	std::vector<NavLink> links;
+	// Per tile side, sorted by begin
+	std::array<std::vector<NavBorderEdge>, NAV_SIDE_COUNT> borders;
+};
+
+// Everything that lies on one tile
+struct NavTileInput {
+	uint32_t x = 0;
+	uint32_t z = 0;
+	// Corner of tile (0, 0) on the ground plane
+	DirectX::XMFLOAT2 origin{0.0f, 0.0f};
+	const Terrain::Heightmap *terrain = nullptr;
+	std::span<const NavGeometry *const> geometry;
+};
+
+// Voxelizes the terrain and geometry over the tile and its border, keeps the tops of solid columns that are flat
+// enough and have room above them, erodes them by the agent radius and covers what is left with rectangles.
+NavTile BuildNavTile(const NavMeshSettings &settings, const NavTileInput &input);
+
+} // namespace TGW::Nav
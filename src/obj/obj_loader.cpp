@@ -0,0 +1,661 @@
+#include "obj_loader.h"
+#include "core/file_mapping.h"
+#include "core/hash.h"
+
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TGW_OBJ_LOADER_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+using namespace TGW;
+using namespace TGW::Obj;
+namespace fs = std::filesystem;
+
+namespace {
+// Chunks end at the first line break past every CHUNK_BYTES, so where they are does not depend on the workers
+constexpr size_t CHUNK_BYTES = 1 << 20;
+// Corners welded per job
+constexpr uint32_t WELD_BATCH = 1 << 16;
+// Corners are spread over partitions by hash, each partition welds its own on one job
+constexpr uint32_t PARTITION_BITS = 6;
+constexpr uint32_t PARTITION_COUNT = 1 << PARTITION_BITS;
+constexpr int32_t MISSING_INDEX = INT32_MIN;
+// Set on the rank of the corner that first used a vertex, it writes the vertex
+constexpr uint32_t FIRST_USE_BIT = 1u << 31;
+
+enum Attribute : uint8_t {
+	ATTRIBUTE_POSITION,
+	ATTRIBUTE_TEXCOORD,
+	ATTRIBUTE_NORMAL,
+	ATTRIBUTE_COUNT,
+};
+
+// What a face corner points at, zero based into the whole file once resolved
+struct Corner {
+	int32_t indices[ATTRIBUTE_COUNT];
+
+	bool operator==(const Corner &) const = default;
+};
+
+enum ChunkEventType : uint8_t {
+	CHUNK_EVENT_OBJECT,
+	CHUNK_EVENT_MATERIAL,
+};
+
+// o, g or usemtl, in effect from the corner it was read at
+struct ChunkEvent {
+	uint32_t corner;
+	ChunkEventType type;
+	std::string_view name;
+};
+
+struct Chunk {
+	std::string_view text;
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT2> texCoords;
+	std::vector<XMFLOAT3> normals;
+	// Three per triangle
+	std::vector<Corner> corners;
+	// corner * ATTRIBUTE_COUNT + attribute of every negative index. Those are relative to the chunk's own elements
+	// until resolved, the others already count from the start of the file.
+	std::vector<uint32_t> relativeIndices;
+	std::vector<ChunkEvent> events;
+	std::vector<std::string_view> materialLibraries;
+	// Where the chunk's elements start in the whole file
+	uint32_t offsets[ATTRIBUTE_COUNT] = {};
+	uint32_t cornerOffset = 0;
+	bool valid = true;
+};
+
+// Corners of one mesh, at most WELD_BATCH of them
+struct WeldItem {
+	uint32_t begin;
+	uint32_t end;
+	uint32_t mesh;
+	// Where the first corner goes in the mesh's indices
+	uint32_t indexOffset;
+};
+
+struct WeldEntry {
+	uint32_t corner;
+	uint32_t mesh;
+};
+
+const char *FindLineEnd(const char *begin, const char *end)
+{
+#ifdef TGW_OBJ_LOADER_SSE2
+	const __m128i newline = _mm_set1_epi8('\n');
+	for (; end - begin >= 16; begin += 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+		if (const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline))) {
+			return begin + std::countr_zero(static_cast<uint32_t>(mask));
+		}
+	}
+#endif
+	const void *found = std::memchr(begin, '\n', end - begin);
+	return found ? static_cast<const char *>(found) : end;
+}
+
+inline void SkipSpaces(const char *&p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t')) {
+		p++;
+	}
+}
+
+std::string_view ReadWord(const char *&p, const char *end)
+{
+	SkipSpaces(p, end);
+	const char *begin = p;
+	while (p < end && *p != ' ' && *p != '\t') {
+		p++;
+	}
+	return {begin, static_cast<size_t>(p - begin)};
+}
+
+// The rest of the line without surrounding spaces
+std::string_view ReadRest(const char *p, const char *end)
+{
+	SkipSpaces(p, end);
+	while (end > p && (end[-1] == ' ' || end[-1] == '\t')) {
+		end--;
+	}
+	return {p, static_cast<size_t>(end - p)};
+}
+
+bool ReadFloat(const char *&p, const char *end, float &value)
+{
+	SkipSpaces(p, end);
+	if (p < end && *p == '+') {
+		p++;
+	}
+	const auto [next, error] = std::from_chars(p, end, value);
+	p = next;
+	return error == std::errc{};
+}
+
+// Polygons become fans around their first corner, like Assimp does with convex quads
+bool ReadFace(Chunk &chunk, const char *p, const char *end, std::vector<Corner> &face, std::vector<uint8_t> &relative)
+{
+	face.clear();
+	relative.clear();
+	const uint32_t counts[ATTRIBUTE_COUNT] = {static_cast<uint32_t>(chunk.positions.size()),
+		static_cast<uint32_t>(chunk.texCoords.size()), static_cast<uint32_t>(chunk.normals.size())};
+	for (SkipSpaces(p, end); p < end; SkipSpaces(p, end)) {
+		Corner corner{MISSING_INDEX, MISSING_INDEX, MISSING_INDEX};
+		uint8_t relativeMask = 0;
+		for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+			if (attribute > 0) {
+				if (p == end || *p != '/') {
+					break;
+				}
+				p++;
+			}
+			int32_t index = 0;
+			const auto [next, error] = std::from_chars(p, end, index);
+			if (error != std::errc{}) {
+				// Only the position is required, v//n leaves out the UV
+				if (attribute == ATTRIBUTE_POSITION) {
+					return false;
+				}
+				continue;
+			}
+			p = next;
+			if (index > 0) {
+				corner.indices[attribute] = index - 1;
+			} else if (index < 0) {
+				corner.indices[attribute] = static_cast<int32_t>(counts[attribute]) + index;
+				relativeMask |= 1 << attribute;
+			} else {
+				return false;
+			}
+		}
+		if (p < end && *p != ' ' && *p != '\t') {
+			return false;
+		}
+		face.push_back(corner);
+		relative.push_back(relativeMask);
+	}
+
+	// Points and lines are skipped, like BuildMeshData does with Assimp's
+	for (size_t i = 2; i < face.size(); i++) {
+		for (const size_t source : {size_t{0}, i - 1, i}) {
+			const uint32_t corner = static_cast<uint32_t>(chunk.corners.size());
+			for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+				if (relative[source] & (1 << attribute)) {
+					chunk.relativeIndices.push_back(corner * ATTRIBUTE_COUNT + attribute);
+				}
+			}
+			chunk.corners.push_back(face[source]);
+		}
+	}
+	return true;
+}
+
+void ParseChunk(Chunk &chunk)
+{
+	std::vector<Corner> face;
+	std::vector<uint8_t> relative;
+	const char *p = chunk.text.data();
+	const char *textEnd = p + chunk.text.size();
+	while (p < textEnd && chunk.valid) {
+		const char *end = FindLineEnd(p, textEnd);
+		const char *next = end < textEnd ? end + 1 : textEnd;
+		if (end > p && end[-1] == '\r') {
+			end--;
+		}
+
+		const std::string_view keyword = ReadWord(p, end);
+		if (keyword == "v") {
+			XMFLOAT3 &position = chunk.positions.emplace_back();
+			chunk.valid = ReadFloat(p, end, position.x) && ReadFloat(p, end, position.y) && ReadFloat(p, end, position.z);
+		} else if (keyword == "vt") {
+			// V and W are optional
+			XMFLOAT2 &texCoords = chunk.texCoords.emplace_back();
+			chunk.valid = ReadFloat(p, end, texCoords.x);
+			SkipSpaces(p, end);
+			if (p < end && !ReadFloat(p, end, texCoords.y)) {
+				chunk.valid = false;
+			}
+		} else if (keyword == "vn") {
+			XMFLOAT3 &normal = chunk.normals.emplace_back();
+			chunk.valid = ReadFloat(p, end, normal.x) && ReadFloat(p, end, normal.y) && ReadFloat(p, end, normal.z);
+		} else if (keyword == "f") {
+			chunk.valid = ReadFace(chunk, p, end, face, relative);
+		} else if (keyword == "o" || keyword == "g") {
+			chunk.events.push_back(ChunkEvent{
+			  .corner = static_cast<uint32_t>(chunk.corners.size()),
+			  .type = CHUNK_EVENT_OBJECT,
+			  .name = ReadRest(p, end),
+			});
+		} else if (keyword == "usemtl") {
+			chunk.events.push_back(ChunkEvent{
+			  .corner = static_cast<uint32_t>(chunk.corners.size()),
+			  .type = CHUNK_EVENT_MATERIAL,
+			  .name = ReadRest(p, end),
+			});
+		} else if (keyword == "mtllib") {
+			chunk.materialLibraries.push_back(ReadRest(p, end));
+		}
+		p = next;
+	}
+}
+
+// Cuts the text after the first line break past every CHUNK_BYTES
+std::vector<Chunk> SplitChunks(std::string_view text)
+{
+	std::vector<Chunk> chunks;
+	for (size_t begin = 0; begin < text.size();) {
+		size_t end = std::min(begin + CHUNK_BYTES, text.size());
+		if (end < text.size()) {
+			end = FindLineEnd(text.data() + end, text.data() + text.size()) - text.data();
+			end = std::min(end + 1, text.size());
+		}
+		chunks.emplace_back().text = text.substr(begin, end - begin);
+		begin = end;
+	}
+	return chunks;
+}
+
+// Adds up where each chunk starts and checks the totals fit the indices
+bool AssignOffsets(std::vector<Chunk> &chunks, uint32_t (&totals)[ATTRIBUTE_COUNT], uint32_t &cornerCount)
+{
+	uint64_t sums[ATTRIBUTE_COUNT + 1] = {};
+	for (Chunk &chunk : chunks) {
+		if (!chunk.valid) {
+			return false;
+		}
+		const size_t sizes[ATTRIBUTE_COUNT + 1] = {
+			chunk.positions.size(), chunk.texCoords.size(), chunk.normals.size(), chunk.corners.size()};
+		for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+			chunk.offsets[attribute] = static_cast<uint32_t>(sums[attribute]);
+		}
+		chunk.cornerOffset = static_cast<uint32_t>(sums[ATTRIBUTE_COUNT]);
+		for (uint32_t i = 0; i <= ATTRIBUTE_COUNT; i++) {
+			sums[i] += sizes[i];
+			// Ranks keep FIRST_USE_BIT to themselves
+			if (sums[i] >= FIRST_USE_BIT) {
+				return false;
+			}
+		}
+	}
+	for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+		totals[attribute] = static_cast<uint32_t>(sums[attribute]);
+	}
+	cornerCount = static_cast<uint32_t>(sums[ATTRIBUTE_COUNT]);
+	return true;
+}
+
+// Pieces of a .mtl file that map to texture slots, the way Assimp reads them
+void ParseMaterialLibrary(
+	std::string_view text, std::vector<MaterialData> &materials, std::unordered_map<std::string_view, uint32_t> &names)
+{
+	const char *p = text.data();
+	const char *textEnd = p + text.size();
+	while (p < textEnd) {
+		const char *end = FindLineEnd(p, textEnd);
+		const char *next = end < textEnd ? end + 1 : textEnd;
+		if (end > p && end[-1] == '\r') {
+			end--;
+		}
+
+		const std::string_view keyword = ReadWord(p, end);
+		if (keyword == "newmtl") {
+			names.emplace(ReadRest(p, end), static_cast<uint32_t>(materials.size()));
+			materials.emplace_back();
+		} else if (!materials.empty()) {
+			std::optional<TextureSlot> slot;
+			if (keyword == "map_Kd") {
+				slot = TEXTURE_SLOT_DIFFUSE;
+			} else if (keyword == "map_Ks") {
+				slot = TEXTURE_SLOT_SPECULAR;
+			} else if (keyword == "map_bump" || keyword == "map_Bump" || keyword == "bump") {
+				slot = TEXTURE_SLOT_NORMAL;
+			} else if (keyword == "map_Ka") {
+				slot = TEXTURE_SLOT_ROUGHNESS;
+			}
+			// Options like -bm 0.5 come before the file name
+			const std::string_view rest = ReadRest(p, end);
+			const size_t space = rest.find_last_of(" \t");
+			if (slot) {
+				materials.back().textures[*slot] = rest.substr(space == std::string_view::npos ? 0 : space + 1);
+			}
+		}
+		p = next;
+	}
+}
+
+inline uint64_t HashCorner(uint32_t mesh, const Corner &corner)
+{
+	const uint64_t low = static_cast<uint32_t>(corner.indices[0]) | uint64_t{static_cast<uint32_t>(corner.indices[1])} << 32;
+	const uint64_t high = static_cast<uint32_t>(corner.indices[2]) | uint64_t{mesh} << 32;
+	uint64_t hash = low * 0x9E3779B97F4A7C15ull;
+	hash = (hash ^ (hash >> 32) ^ high) * 0xC2B2AE3D27D4EB4Full;
+	return hash ^ (hash >> 29);
+}
+
+inline uint32_t GetPartition(uint64_t hash) { return static_cast<uint32_t>(hash >> (64 - PARTITION_BITS)); }
+
+class Welder {
+  public:
+	Welder(ObjModel &model, const std::vector<Corner> &corners, std::vector<WeldItem> items, JobSystem &jobs)
+		: _model{model}, _corners{corners}, _items{std::move(items)}, _jobs{jobs}
+	{
+	}
+
+	void Weld(const std::vector<XMFLOAT3> &positions, const std::vector<XMFLOAT2> &texCoords,
+		const std::vector<XMFLOAT3> &normals);
+
+  private:
+	void Scatter();
+	void RankPartition(uint32_t partition);
+
+	ObjModel &_model;
+	const std::vector<Corner> &_corners;
+	std::vector<WeldItem> _items;
+	JobSystem &_jobs;
+
+	// Per item and partition, how many corners it has and then where they go in _entries
+	std::vector<uint32_t> _cursors;
+	uint32_t _partitionStarts[PARTITION_COUNT + 1] = {};
+	std::vector<WeldEntry> _entries;
+	// Per corner, which of the distinct vertices of its mesh in its partition it is
+	std::vector<uint32_t> _ranks;
+	// Per partition and mesh, distinct vertices and then where they start in the mesh
+	std::vector<uint32_t> _vertexCounts;
+};
+
+// Radix partitions the corners by hash, keeping file order within each partition
+void Welder::Scatter()
+{
+	const uint32_t itemCount = static_cast<uint32_t>(_items.size());
+	_cursors.assign(size_t{itemCount} * PARTITION_COUNT, 0);
+	_jobs.ParallelFor(itemCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const WeldItem &item = _items[i];
+			uint32_t *counts = &_cursors[size_t{i} * PARTITION_COUNT];
+			for (uint32_t corner = item.begin; corner < item.end; corner++) {
+				counts[GetPartition(HashCorner(item.mesh, _corners[corner]))]++;
+			}
+		}
+	});
+
+	uint32_t offset = 0;
+	for (uint32_t partition = 0; partition < PARTITION_COUNT; partition++) {
+		_partitionStarts[partition] = offset;
+		for (uint32_t i = 0; i < itemCount; i++) {
+			uint32_t &cursor = _cursors[size_t{i} * PARTITION_COUNT + partition];
+			const uint32_t count = cursor;
+			cursor = offset;
+			offset += count;
+		}
+	}
+	_partitionStarts[PARTITION_COUNT] = offset;
+
+	_entries.resize(offset);
+	_jobs.ParallelFor(itemCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const WeldItem &item = _items[i];
+			uint32_t *cursors = &_cursors[size_t{i} * PARTITION_COUNT];
+			for (uint32_t corner = item.begin; corner < item.end; corner++) {
+				const uint32_t partition = GetPartition(HashCorner(item.mesh, _corners[corner]));
+				_entries[cursors[partition]++] = WeldEntry{.corner = corner, .mesh = item.mesh};
+			}
+		}
+	});
+}
+
+// Open addressing over the partition's entries, ranks count up per mesh in the order corners first show up
+void Welder::RankPartition(uint32_t partition)
+{
+	const uint32_t begin = _partitionStarts[partition];
+	const uint32_t end = _partitionStarts[partition + 1];
+	const uint32_t meshCount = static_cast<uint32_t>(_model.meshes.size());
+	uint32_t *vertexCounts = &_vertexCounts[size_t{partition} * meshCount];
+	const uint32_t mask = std::bit_ceil(std::max(16u, (end - begin) * 2)) - 1;
+	std::vector<uint32_t> slots(size_t{mask} + 1, UINT32_MAX);
+	for (uint32_t i = begin; i < end; i++) {
+		const WeldEntry &entry = _entries[i];
+		const Corner &corner = _corners[entry.corner];
+		for (uint32_t slot = HashCorner(entry.mesh, corner) & mask;; slot = (slot + 1) & mask) {
+			if (slots[slot] == UINT32_MAX) {
+				slots[slot] = i;
+				_ranks[entry.corner] = vertexCounts[entry.mesh]++ | FIRST_USE_BIT;
+				break;
+			}
+			const WeldEntry &first = _entries[slots[slot]];
+			if (first.mesh == entry.mesh && _corners[first.corner] == corner) {
+				_ranks[entry.corner] = _ranks[first.corner] & ~FIRST_USE_BIT;
+				break;
+			}
+		}
+	}
+}
+
+void Welder::Weld(
+	const std::vector<XMFLOAT3> &positions, const std::vector<XMFLOAT2> &texCoords, const std::vector<XMFLOAT3> &normals)
+{
+	Scatter();
+
+	const uint32_t meshCount = static_cast<uint32_t>(_model.meshes.size());
+	_ranks.resize(_corners.size());
+	_vertexCounts.assign(size_t{PARTITION_COUNT} * meshCount, 0);
+	_jobs.ParallelFor(PARTITION_COUNT, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t partition = begin; partition < end; partition++) {
+			RankPartition(partition);
+		}
+	});
+
+	// Each mesh's vertices go partition after partition
+	for (uint32_t mesh = 0; mesh < meshCount; mesh++) {
+		uint32_t offset = 0;
+		for (uint32_t partition = 0; partition < PARTITION_COUNT; partition++) {
+			uint32_t &count = _vertexCounts[size_t{partition} * meshCount + mesh];
+			const uint32_t vertices = count;
+			count = offset;
+			offset += vertices;
+		}
+		_model.meshes[mesh].vertices.resize(offset);
+	}
+
+	_jobs.ParallelFor(static_cast<uint32_t>(_items.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const WeldItem &item = _items[i];
+			MeshData &mesh = _model.meshes[item.mesh];
+			for (uint32_t c = item.begin; c < item.end; c++) {
+				const Corner &corner = _corners[c];
+				const uint32_t partition = GetPartition(HashCorner(item.mesh, corner));
+				const uint32_t rank = _ranks[c];
+				const uint32_t index = _vertexCounts[size_t{partition} * meshCount + item.mesh] + (rank & ~FIRST_USE_BIT);
+				mesh.indices[item.indexOffset + c - item.begin] = index;
+				if (rank & FIRST_USE_BIT) {
+					const int32_t texCoord = corner.indices[ATTRIBUTE_TEXCOORD];
+					const int32_t normal = corner.indices[ATTRIBUTE_NORMAL];
+					mesh.vertices[index] = Vertex{
+					  .position = positions[corner.indices[ATTRIBUTE_POSITION]],
+					  .normal = normal != MISSING_INDEX ? normals[normal] : XMFLOAT3{},
+					  .texCoords = texCoord != MISSING_INDEX ? texCoords[texCoord] : XMFLOAT2{},
+					};
+				}
+			}
+		}
+	});
+}
+
+class ObjParser {
+  public:
+	ObjParser(ObjModel &model, const fs::path &path, JobSystem &jobs) : _model{model}, _path{path}, _jobs{jobs} {}
+
+	bool Parse(std::string_view text);
+
+  private:
+	bool Gather();
+	void LoadMaterials();
+	std::vector<WeldItem> BuildMeshes();
+
+	ObjModel &_model;
+	const fs::path &_path;
+	JobSystem &_jobs;
+
+	std::vector<Chunk> _chunks;
+	std::vector<XMFLOAT3> _positions;
+	std::vector<XMFLOAT2> _texCoords;
+	std::vector<XMFLOAT3> _normals;
+	std::vector<Corner> _corners;
+	// Keep the material names in _materialNames valid
+	std::vector<FileMapping> _libraries;
+	std::unordered_map<std::string_view, uint32_t> _materialNames;
+};
+
+bool ObjParser::Parse(std::string_view text)
+{
+	_chunks = SplitChunks(text);
+	_jobs.ParallelFor(static_cast<uint32_t>(_chunks.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			ParseChunk(_chunks[i]);
+		}
+	});
+	if (!Gather()) {
+		return false;
+	}
+
+	LoadMaterials();
+	Welder{_model, _corners, BuildMeshes(), _jobs}.Weld(_positions, _texCoords, _normals);
+	return true;
+}
+
+// Copies the chunks into whole file arrays, resolving relative indices and checking all of them on the way
+bool ObjParser::Gather()
+{
+	uint32_t totals[ATTRIBUTE_COUNT];
+	uint32_t cornerCount;
+	if (!AssignOffsets(_chunks, totals, cornerCount)) {
+		return false;
+	}
+	_positions.resize(totals[ATTRIBUTE_POSITION]);
+	_texCoords.resize(totals[ATTRIBUTE_TEXCOORD]);
+	_normals.resize(totals[ATTRIBUTE_NORMAL]);
+	_corners.resize(cornerCount);
+
+	_jobs.ParallelFor(static_cast<uint32_t>(_chunks.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			Chunk &chunk = _chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), _positions.begin() + chunk.offsets[ATTRIBUTE_POSITION]);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), _texCoords.begin() + chunk.offsets[ATTRIBUTE_TEXCOORD]);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), _normals.begin() + chunk.offsets[ATTRIBUTE_NORMAL]);
+			for (const uint32_t relative : chunk.relativeIndices) {
+				const uint32_t attribute = relative % ATTRIBUTE_COUNT;
+				chunk.corners[relative / ATTRIBUTE_COUNT].indices[attribute] += chunk.offsets[attribute];
+			}
+			for (const Corner &corner : chunk.corners) {
+				for (uint32_t attribute = 0; attribute < ATTRIBUTE_COUNT; attribute++) {
+					const int32_t index = corner.indices[attribute];
+					// Relative indices may point before the start of the file
+					if ((attribute == ATTRIBUTE_POSITION || index != MISSING_INDEX) &&
+						(index < 0 || static_cast<uint32_t>(index) >= totals[attribute])) {
+						chunk.valid = false;
+					}
+				}
+			}
+			std::copy(chunk.corners.begin(), chunk.corners.end(), _corners.begin() + chunk.cornerOffset);
+		}
+	});
+	return std::all_of(_chunks.begin(), _chunks.end(), [](const Chunk &chunk) { return chunk.valid; });
+}
+
+void ObjParser::LoadMaterials()
+{
+	// Faces before any usemtl, or naming a material no library has, get an untextured default
+	_model.materials.emplace_back();
+	std::vector<std::string_view> loaded;
+	for (const Chunk &chunk : _chunks) {
+		for (const std::string_view library : chunk.materialLibraries) {
+			if (std::find(loaded.begin(), loaded.end(), library) != loaded.end()) {
+				continue;
+			}
+			loaded.push_back(library);
+			FileMapping file;
+			const fs::path libraryPath = _path.parent_path() / fs::path{library};
+			if (!file.Open(libraryPath)) {
+				continue;
+			}
+			const std::string_view text{reinterpret_cast<const char *>(file.GetData()), file.GetSize()};
+			ParseMaterialLibrary(text, _model.materials, _materialNames);
+			_model.files.push_back(libraryPath);
+			_libraries.push_back(std::move(file));
+		}
+	}
+}
+
+// A new mesh starts at every o or g and wherever the material changes, empty ones are left out
+std::vector<WeldItem> ObjParser::BuildMeshes()
+{
+	std::vector<WeldItem> items;
+	std::vector<uint32_t> meshCorners;
+	uint32_t material = 0;
+	bool startMesh = true;
+	uint32_t runBegin = 0;
+	auto endRun = [&](uint32_t corner) {
+		if (corner > runBegin && startMesh) {
+			_model.meshes.push_back(MeshData{.vertices = {}, .indices = {}, .materialIndex = material});
+			meshCorners.push_back(0);
+			startMesh = false;
+		}
+		for (uint32_t begin = runBegin; begin < corner; begin += WELD_BATCH) {
+			const uint32_t end = std::min(corner, begin + WELD_BATCH);
+			items.push_back(WeldItem{
+			  .begin = begin,
+			  .end = end,
+			  .mesh = static_cast<uint32_t>(_model.meshes.size() - 1),
+			  .indexOffset = meshCorners.back(),
+			});
+			meshCorners.back() += end - begin;
+		}
+		runBegin = corner;
+	};
+
+	for (const Chunk &chunk : _chunks) {
+		for (const ChunkEvent &event : chunk.events) {
+			endRun(chunk.cornerOffset + event.corner);
+			if (event.type == CHUNK_EVENT_OBJECT) {
+				startMesh = true;
+			} else {
+				const auto it = _materialNames.find(event.name);
+				const uint32_t next = it != _materialNames.end() ? it->second : 0;
+				startMesh |= next != material;
+				material = next;
+			}
+		}
+	}
+	endRun(static_cast<uint32_t>(_corners.size()));
+
+	for (size_t mesh = 0; mesh < _model.meshes.size(); mesh++) {
+		_model.meshes[mesh].indices.resize(meshCorners[mesh]);
+	}
+	return items;
+}
+} // namespace
+
+bool TGW::Obj::IsObjFile(const fs::path &path) { return Hash::NormalizePath(path.extension().string()) == ".obj"; }
+
+std::optional<ObjModel> TGW::Obj::Load(const fs::path &path, JobSystem &jobs)
+{
+	FileMapping file;
+	if (!file.Open(path)) {
+		return {};
+	}
+
+	ObjModel model;
+	model.files.push_back(path);
+	const std::string_view text{reinterpret_cast<const char *>(file.GetData()), file.GetSize()};
+	if (!ObjParser{model, path, jobs}.Parse(text)) {
+		return {};
+	}
+	return model;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "core/job_system.h"
+#include "mesh_data.h"
+
+namespace TGW::Obj {
+
+// A Wavefront OBJ model in the same shape AssetLoader builds from Assimp: one mesh per run of faces sharing an
+// object and a material, polygons fanned into triangles and identical corners welded. Material 0 is the default
+// one for faces without usemtl, the materials of the .mtl libraries follow in the order they are defined.
+struct ObjModel {
+	std::vector<MeshData> meshes;
+	std::vector<MaterialData> materials;
+
+	// Every file that was read, the model first
+	std::vector<std::filesystem::path> files;
+};
+
+bool IsObjFile(const std::filesystem::path &path);
+
+// Loads .obj without going through Assimp, parsing line aligned chunks of the mapped file and welding the corners on
+// jobs. The result does not depend on the number of workers. Returns nothing for indices out of range, so callers can
+// fall back to Assimp.
+std::optional<ObjModel> Load(const std::filesystem::path &path, JobSystem &jobs = JobSystem::Get());
+
+} // namespace TGW::Obj
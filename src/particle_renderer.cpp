@@ -0,0 +1,131 @@
+#include "particle_renderer.h"
+#include "camera.h"
+#include "log.h"
+
+using namespace DirectX;
+
+namespace {
+// Smallest instance buffer, it doubles from there as the particle count grows
+constexpr uint32_t MIN_INSTANCE_CAPACITY = 16 * 1024;
+constexpr uint32_t QUAD_CORNERS = 4;
+} // namespace
+
+/* Implementation of public functions */
+
+bool TGW::ParticleRenderer::Create(ID3D11Device *device)
+{
+	ComPtr<ID3DBlob> vsBlob, psBlob;
+	if (FAILED(CompileShader(L"shaders/particles.hlsl", "VSMain", "vs_5_0", vsBlob.GetAddressOf())) ||
+		FAILED(CompileShader(L"shaders/particles.hlsl", "PSMain", "ps_5_0", psBlob.GetAddressOf()))) {
+		return false;
+	}
+	ASSERT_SUCCEEDED(device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &_vs));
+	ASSERT_SUCCEEDED(device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &_ps));
+
+	// One Fx::ParticleInstance per quad, the corners come from SV_VertexID
+	D3D11_INPUT_ELEMENT_DESC layout[] = {
+	  {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+	  {"PSIZE", 0, DXGI_FORMAT_R32_FLOAT, 0, 12, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+	  {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1}};
+	ASSERT_SUCCEEDED(device->CreateInputLayout(layout, 3, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &_inputLayout));
+
+	D3D11_BUFFER_DESC cbd = {};
+	cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cbd.Usage = D3D11_USAGE_DEFAULT;
+	cbd.ByteWidth = sizeof(ParticleFrameConstantBuffer);
+	ASSERT_SUCCEEDED(device->CreateBuffer(&cbd, nullptr, &_cbFrame));
+
+	D3D11_BLEND_DESC blendDesc = {};
+	D3D11_RENDER_TARGET_BLEND_DESC &target = blendDesc.RenderTarget[0];
+	target.BlendEnable = TRUE;
+	target.SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	target.DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	target.BlendOp = D3D11_BLEND_OP_ADD;
+	target.SrcBlendAlpha = D3D11_BLEND_ONE;
+	target.DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+	target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	target.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	ASSERT_SUCCEEDED(device->CreateBlendState(&blendDesc, &_blendState));
+
+	// Hidden behind terrain and models, but never hiding each other, the stream is sorted instead
+	D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+	depthDesc.DepthEnable = TRUE;
+	depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	depthDesc.DepthFunc = D3D11_COMPARISON_LESS;
+	ASSERT_SUCCEEDED(device->CreateDepthStencilState(&depthDesc, &_depthState));
+
+	D3D11_RASTERIZER_DESC rasterDesc = {};
+	rasterDesc.FillMode = D3D11_FILL_SOLID;
+	rasterDesc.CullMode = D3D11_CULL_NONE;
+	ASSERT_SUCCEEDED(device->CreateRasterizerState(&rasterDesc, &_rasterState));
+	return true;
+}
+
+void TGW::ParticleRenderer::Render(
+	ID3D11Device *device, ID3D11DeviceContext *context, const Camera &camera, const Fx::ParticleSystem &particles)
+{
+	if (!IsCreated() || particles.GetParticleCount() == 0) {
+		return;
+	}
+	_stream.Build(particles, camera.GetPosition());
+	const std::vector<Fx::ParticleInstance> &instances = _stream.GetInstances();
+	if (instances.empty() || !ReserveInstances(device, static_cast<uint32_t>(instances.size()))) {
+		return;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped{};
+	HRESULT hr = context->Map(_instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to map the particle buffer. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return;
+	}
+	memcpy(mapped.pData, instances.data(), instances.size() * sizeof(Fx::ParticleInstance));
+	context->Unmap(_instanceBuffer.Get(), 0);
+
+	const XMMATRIX view = camera.GetViewMatrix();
+	const XMMATRIX cameraWorld = XMMatrixInverse(nullptr, view);
+	ParticleFrameConstantBuffer frame{.viewProjection = XMMatrixTranspose(XMMatrixMultiply(view, camera.GetProjectionMatrix()))};
+	XMStoreFloat3(&frame.cameraRight, cameraWorld.r[0]);
+	XMStoreFloat3(&frame.cameraUp, cameraWorld.r[1]);
+	context->UpdateSubresource(_cbFrame.Get(), 0, nullptr, &frame, 0, 0);
+
+	UINT stride = sizeof(Fx::ParticleInstance);
+	UINT offset = 0;
+	context->IASetInputLayout(_inputLayout.Get());
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	context->IASetVertexBuffers(0, 1, _instanceBuffer.GetAddressOf(), &stride, &offset);
+	context->VSSetShader(_vs.Get(), nullptr, 0);
+	context->PSSetShader(_ps.Get(), nullptr, 0);
+	context->VSSetConstantBuffers(0, 1, _cbFrame.GetAddressOf());
+	context->OMSetBlendState(_blendState.Get(), nullptr, 0xFFFFFFFF);
+	context->OMSetDepthStencilState(_depthState.Get(), 0);
+	context->RSSetState(_rasterState.Get());
+	context->DrawInstanced(QUAD_CORNERS, static_cast<UINT>(instances.size()), 0, 0);
+}
+
+/* Implementation of private functions */
+
+bool TGW::ParticleRenderer::ReserveInstances(ID3D11Device *device, uint32_t count)
+{
+	if (count <= _instanceCapacity) {
+		return true;
+	}
+	uint32_t capacity = std::max(_instanceCapacity, MIN_INSTANCE_CAPACITY);
+	while (capacity < count) {
+		capacity *= 2;
+	}
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = capacity * sizeof(Fx::ParticleInstance);
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	HRESULT hr = device->CreateBuffer(&desc, nullptr, _instanceBuffer.ReleaseAndGetAddressOf());
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to create the particle buffer. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		_instanceCapacity = 0;
+		return false;
+	}
+	_instanceCapacity = capacity;
+	return true;
+}
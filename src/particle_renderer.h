@@ -0,0 +1,41 @@
+#pragma once
+
+#include "pch.h"
+#include "fx/particles.h"
+#include "shaders.h"
+
+using Microsoft::WRL::ComPtr;
+
+class Camera;
+
+namespace TGW {
+
+// Draws every live particle as a camera facing quad in one instanced draw. The sorted instance stream is built
+// on the CPU each frame and streamed into a dynamic buffer, particles.hlsl expands the corners.
+class ParticleRenderer {
+  public:
+	// Compiles the shaders and creates the blend and depth states. Returns false when D3D fails.
+	bool Create(ID3D11Device *device);
+	inline bool IsCreated() const { return _vs != nullptr; }
+
+	// Blends over what was drawn so far, testing but not writing depth. Leaves its own shaders, states and buffers
+	// bound.
+	void Render(ID3D11Device *device, ID3D11DeviceContext *context, const Camera &camera, const Fx::ParticleSystem &particles);
+
+  private:
+	bool ReserveInstances(ID3D11Device *device, uint32_t count);
+
+	ComPtr<ID3D11VertexShader> _vs;
+	ComPtr<ID3D11PixelShader> _ps;
+	ComPtr<ID3D11InputLayout> _inputLayout;
+	ComPtr<ID3D11Buffer> _instanceBuffer;
+	ComPtr<ID3D11Buffer> _cbFrame;
+	ComPtr<ID3D11BlendState> _blendState;
+	ComPtr<ID3D11DepthStencilState> _depthState;
+	ComPtr<ID3D11RasterizerState> _rasterState;
+
+	uint32_t _instanceCapacity = 0;
+	Fx::BillboardStream _stream;
+};
+
+} // namespace TGW
@@ -35,25 +35,11 @@
 #include <wrl/event.h>
 
 #include <d3d11.h>
-#include <DirectXMath.h>
 
 #ifdef _DEBUG
 #include <dxgidebug.h>
 #endif
 
-#include <cstdint>
-#include <cstdio>
-#include <cstdarg>
-#include <vector>
-#include <array>
-#include <memory>
-#include <string>
-#include <string_view>
-#include <optional>
-#include <cwctype>
-#include <filesystem>
-#include <exception>
 #include <ppltasks.h>
-#include <functional>
 
-#include "utility.h"
+#include "common.h"
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "command_stream.h"
+#include "cook/cook_cache.h"
+#include "core/binary_stream.h"
+
+#include <cstring>
+
+using namespace TGW::Replay;
+using DirectX::XMFLOAT4X4;
+
+namespace {
+// What a command of each type stores, in this order: id, generation, integers, values, path
+struct CommandLayout {
+	bool id;
+	bool generation;
+	uint8_t integers;
+	uint8_t values;
+	bool path;
+};
+
+constexpr std::array<CommandLayout, COMMAND_TYPE_COUNT> COMMAND_LAYOUTS = {{
+  {.id = false, .generation = false, .integers = 0, .values = 1, .path = false},  // COMMAND_CAMERA_ORBIT
+  {.id = false, .generation = false, .integers = 2, .values = 0, .path = false},  // COMMAND_CAMERA_PAN
+  {.id = false, .generation = false, .integers = 1, .values = 0, .path = false},  // COMMAND_CAMERA_ZOOM
+  {.id = false, .generation = false, .integers = 0, .values = 7, .path = false},  // COMMAND_CAMERA_VIEW
+  {.id = true, .generation = false, .integers = 0, .values = 16, .path = true},   // COMMAND_LOAD_MODEL
+  {.id = true, .generation = false, .integers = 0, .values = 16, .path = false},  // COMMAND_MOVE_MODEL
+  {.id = true, .generation = false, .integers = 0, .values = 0, .path = false},   // COMMAND_SELECT_MODEL
+  {.id = true, .generation = false, .integers = 0, .values = 0, .path = false},   // COMMAND_REMOVE_MODEL
+  {.id = false, .generation = false, .integers = 0, .values = 0, .path = false},  // COMMAND_CLEAR_MODELS
+  {.id = false, .generation = false, .integers = 2, .values = 6, .path = false},  // COMMAND_SPAWN_UNIT
+  {.id = true, .generation = true, .integers = 0, .values = 2, .path = false},    // COMMAND_MOVE_UNIT
+  {.id = true, .generation = true, .integers = 0, .values = 0, .path = false},    // COMMAND_STOP_UNIT
+  {.id = true, .generation = true, .integers = 0, .values = 0, .path = false},    // COMMAND_DESPAWN_UNIT
+  {.id = false, .generation = false, .integers = 2, .values = 8, .path = false},  // COMMAND_FIRE
+}};
+
+// Unsigned LEB128, at most 5 bytes for 32 bits
+void WriteVarint(TGW::BinaryWriter &writer, uint32_t value)
+{
+	while (value >= 0x80) {
+		writer.Write(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	writer.Write(static_cast<uint8_t>(value));
+}
+
+bool ReadVarint(TGW::BinaryReader &reader, uint32_t &value)
+{
+	value = 0;
+	for (uint32_t shift = 0; shift < 35; shift += 7) {
+		uint8_t byte = 0;
+		if (!reader.Read(byte)) {
+			return false;
+		}
+		value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Zigzag, so small negative numbers stay one byte too
+inline uint32_t ToZigzag(int32_t value) { return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+inline int32_t FromZigzag(uint32_t value) { return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1); }
+
+void StoreMatrix(std::array<float, 16> &values, const XMFLOAT4X4 &matrix)
+{
+	std::memcpy(values.data(), &matrix, sizeof(XMFLOAT4X4));
+}
+} // namespace
+
+/* CommandRecorder */
+
+void CommandRecorder::SetTerrain(std::string_view path, const Hash::Hash128 &hash)
+{
+	_stream.terrainPath = path;
+	_stream.terrainHash = hash;
+}
+
+void CommandRecorder::Orbit(float dx) { Add(COMMAND_CAMERA_ORBIT).values[0] = dx; }
+
+void CommandRecorder::Pan(int right, int forward)
+{
+	Command &command = Add(COMMAND_CAMERA_PAN);
+	command.integers = {right, forward};
+}
+
+void CommandRecorder::Zoom(short wheelDelta) { Add(COMMAND_CAMERA_ZOOM).integers[0] = wheelDelta; }
+
+void CommandRecorder::SetView(DirectX::XMFLOAT3 target, DirectX::XMFLOAT3 forward, float zoom)
+{
+	Command &command = Add(COMMAND_CAMERA_VIEW);
+	command.values = {target.x, target.y, target.z, forward.x, forward.y, forward.z, zoom};
+}
+
+void CommandRecorder::LoadModel(uint32_t id, std::string_view path, const XMFLOAT4X4 &worldMatrix)
+{
+	Command &command = Add(COMMAND_LOAD_MODEL);
+	command.id = id;
+	command.path = path;
+	StoreMatrix(command.values, worldMatrix);
+}
+
+void CommandRecorder::MoveModel(uint32_t id, const XMFLOAT4X4 &worldMatrix)
+{
+	Command &command = Add(COMMAND_MOVE_MODEL);
+	command.id = id;
+	StoreMatrix(command.values, worldMatrix);
+}
+
+void CommandRecorder::SelectModel(std::optional<uint32_t> id) { Add(COMMAND_SELECT_MODEL).id = id.value_or(REPLAY_NO_MODEL); }
+
+void CommandRecorder::RemoveModel(uint32_t id) { Add(COMMAND_REMOVE_MODEL).id = id; }
+
+void CommandRecorder::ClearModels() { Add(COMMAND_CLEAR_MODELS); }
+
+void CommandRecorder::SpawnUnit(const Sim::UnitDesc &desc)
+{
+	Command &command = Add(COMMAND_SPAWN_UNIT);
+	command.integers = {desc.owner, static_cast<int32_t>(desc.model)};
+	command.values = {desc.position.x, desc.position.y, desc.position.z, desc.heading, desc.maxSpeed, desc.health};
+}
+
+void CommandRecorder::MoveUnit(Sim::UnitId unit, DirectX::XMFLOAT2 target)
+{
+	Command &command = Add(COMMAND_MOVE_UNIT);
+	command.id = unit.index;
+	command.generation = unit.generation;
+	command.values = {target.x, target.y};
+}
+
+void CommandRecorder::StopUnit(Sim::UnitId unit)
+{
+	Command &command = Add(COMMAND_STOP_UNIT);
+	command.id = unit.index;
+	command.generation = unit.generation;
+}
+
+void CommandRecorder::DespawnUnit(Sim::UnitId unit)
+{
+	Command &command = Add(COMMAND_DESPAWN_UNIT);
+	command.id = unit.index;
+	command.generation = unit.generation;
+}
+
+void CommandRecorder::Fire(const Sim::ProjectileDesc &desc)
+{
+	Command &command = Add(COMMAND_FIRE);
+	command.integers = {desc.owner, static_cast<int32_t>(desc.payload)};
+	command.values = {desc.position.x, desc.position.y, desc.position.z, desc.velocity.x, desc.velocity.y,
+		desc.velocity.z, desc.lifetime, desc.gravityScale};
+}
+
+Command &CommandRecorder::Add(CommandType type)
+{
+	Command &command = _stream.commands.emplace_back();
+	command.tick = _stream.tickCount;
+	command.type = type;
+	return command;
+}
+
+/* Implementation of public functions */
+
+std::vector<uint8_t> TGW::Replay::Serialize(const CommandStream &stream)
+{
+	BinaryWriter writer;
+	writer.Write(REPLAY_MAGIC);
+	writer.Write(REPLAY_VERSION);
+	writer.Write(stream.tickSeconds);
+	// Commands recorded after the last NextTick still get their tick
+	writer.Write(stream.commands.empty() ? stream.tickCount : std::max(stream.tickCount, stream.commands.back().tick + 1));
+	writer.WriteString(stream.terrainPath);
+	writer.Write(stream.terrainHash.low);
+	writer.Write(stream.terrainHash.high);
+	writer.Write(static_cast<uint32_t>(stream.commands.size()));
+
+	uint32_t tick = 0;
+	for (const Command &command : stream.commands) {
+		const CommandLayout &layout = COMMAND_LAYOUTS[command.type];
+		WriteVarint(writer, command.tick - tick);
+		tick = command.tick;
+		writer.Write(static_cast<uint8_t>(command.type));
+		if (layout.id) {
+			WriteVarint(writer, command.id);
+		}
+		if (layout.generation) {
+			WriteVarint(writer, command.generation);
+		}
+		for (uint32_t i = 0; i < layout.integers; i++) {
+			WriteVarint(writer, ToZigzag(command.integers[i]));
+		}
+		writer.WriteArray(std::span<const float>{command.values.data(), layout.values});
+		if (layout.path) {
+			writer.WriteString(command.path);
+		}
+	}
+	return writer.TakeBuffer();
+}
+
+std::optional<CommandStream> TGW::Replay::Deserialize(std::span<const uint8_t> data)
+{
+	BinaryReader reader{data};
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	if (!reader.Read(magic) || !reader.Read(version) || magic != REPLAY_MAGIC || version == 0 || version > REPLAY_VERSION) {
+		return {};
+	}
+
+	CommandStream stream;
+	uint32_t commandCount = 0;
+	reader.Read(stream.tickSeconds);
+	reader.Read(stream.tickCount);
+	// Version 1 streams did not record their terrain
+	if (version >= 2) {
+		reader.ReadString(stream.terrainPath);
+		reader.Read(stream.terrainHash.low);
+		reader.Read(stream.terrainHash.high);
+	}
+	reader.Read(commandCount);
+	// Every command takes at least its tick and type byte, which bounds the allocation for garbage counts
+	if (reader.HasFailed() || commandCount > reader.GetRemaining() / 2 || !(stream.tickSeconds > 0.0f)) {
+		return {};
+	}
+	stream.commands.resize(commandCount);
+
+	uint32_t tick = 0;
+	for (Command &command : stream.commands) {
+		uint32_t delta = 0;
+		uint8_t type = 0;
+		if (!ReadVarint(reader, delta) || !reader.Read(type) || type >= COMMAND_TYPE_COUNT) {
+			return {};
+		}
+		const CommandLayout &layout = COMMAND_LAYOUTS[type];
+		command.tick = tick += delta;
+		command.type = static_cast<CommandType>(type);
+		if ((layout.id && !ReadVarint(reader, command.id)) ||
+			(layout.generation && !ReadVarint(reader, command.generation))) {
+			return {};
+		}
+		for (uint32_t i = 0; i < layout.integers; i++) {
+			uint32_t value = 0;
+			if (!ReadVarint(reader, value)) {
+				return {};
+			}
+			command.integers[i] = FromZigzag(value);
+		}
+		reader.ReadArray(std::span<float>{command.values.data(), layout.values});
+		if (layout.path) {
+			reader.ReadString(command.path);
+		}
+		if (reader.HasFailed() || command.tick < delta || command.tick >= stream.tickCount) {
+			return {};
+		}
+	}
+
+	if (reader.GetRemaining() != 0) {
+		return {};
+	}
+	return stream;
+}
+
+bool TGW::Replay::Save(const std::filesystem::path &path, const CommandStream &stream)
+{
+	return Cook::WriteFileAtomic(path, Serialize(stream));
+}
+
+std::optional<CommandStream> TGW::Replay::Load(const std::filesystem::path &path)
+{
+	const std::optional<std::vector<uint8_t>> data = Cook::ReadWholeFile(path);
+	if (!data) {
+		return {};
+	}
+	return Deserialize(*data);
+}
+
+std::optional<TGW::Hash::Hash128> TGW::Replay::HashTerrainFile(const std::filesystem::path &path)
+{
+	const std::optional<std::vector<uint8_t>> data = Cook::ReadWholeFile(path);
+	if (!data) {
+		return {};
+	}
+	return Hash::ContentHash128(*data);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "common.h"
+#include "core/content_hash.h"
+#include "sim/projectiles.h"
+#include "sim/unit_store.h"
+
+#include <span>
+
+namespace TGW::Replay {
+
+constexpr uint32_t REPLAY_MAGIC = 0x50524853; // "SHRP"
+constexpr uint32_t REPLAY_VERSION = 2;
+// Selects nothing when given as the model of COMMAND_SELECT_MODEL
+constexpr uint32_t REPLAY_NO_MODEL = UINT32_MAX;
+
+enum CommandType : uint8_t {
+	// Camera input the way Camera::HandleMouse and HandleZoom apply it, one command per frame it moved
+	COMMAND_CAMERA_ORBIT,
+	COMMAND_CAMERA_PAN,
+	COMMAND_CAMERA_ZOOM,
+	COMMAND_CAMERA_VIEW,
+	// Editor models, by the id the editor gave them
+	COMMAND_LOAD_MODEL,
+	COMMAND_MOVE_MODEL,
+	COMMAND_SELECT_MODEL,
+	COMMAND_REMOVE_MODEL,
+	COMMAND_CLEAR_MODELS,
+	// Gameplay orders
+	COMMAND_SPAWN_UNIT,
+	COMMAND_MOVE_UNIT,
+	COMMAND_STOP_UNIT,
+	COMMAND_DESPAWN_UNIT,
+	COMMAND_FIRE,
+	COMMAND_TYPE_COUNT,
+};
+
+// One recorded input. Only the fields of its type are stored, see the recorder for which ones.
+struct Command {
+	uint32_t tick = 0;
+	CommandType type = COMMAND_CAMERA_ORBIT;
+	// Model id, or the slot and generation of a unit
+	uint32_t id = 0;
+	uint32_t generation = 0;
+	// Small integers: pan directions, wheel delta, owner, payload, unit model
+	std::array<int32_t, 2> integers{};
+	// Orbit delta, positions, velocities, matrices, by type
+	std::array<float, 16> values{};
+	std::string path;
+
+	bool operator==(const Command &) const = default;
+};
+
+// A whole session: commands in tick order and how many fixed ticks it ran
+struct CommandStream {
+	float tickSeconds = 1.0f / 30.0f;
+	uint32_t tickCount = 0;
+	// Terrain file the session ran on, as the editor opened it, and the content hash of that file. No path for flat
+	// ground, and for streams from version 1 that did not record it.
+	std::string terrainPath;
+	Hash::Hash128 terrainHash;
+	std::vector<Command> commands;
+
+	bool operator==(const CommandStream &) const = default;
+};
+
+// Collects what the user and the gameplay code did, stamped with the tick it happened on. NextTick ends a tick,
+// commands recorded before it are replayed before that tick is simulated.
+class CommandRecorder {
+  public:
+	explicit CommandRecorder(float tickSeconds = 1.0f / 30.0f) { _stream.tickSeconds = tickSeconds; }
+
+	inline void NextTick() { _stream.tickCount++; }
+	inline uint32_t GetTick() const { return _stream.tickCount; }
+	inline const CommandStream &GetStream() const { return _stream; }
+
+	// The terrain the session runs on, see HashTerrainFile
+	void SetTerrain(std::string_view path, const Hash::Hash128 &hash);
+
+	void Orbit(float dx);
+	void Pan(int right, int forward);
+	void Zoom(short wheelDelta);
+	void SetView(DirectX::XMFLOAT3 target, DirectX::XMFLOAT3 forward, float zoom);
+
+	void LoadModel(uint32_t id, std::string_view path, const DirectX::XMFLOAT4X4 &worldMatrix);
+	void MoveModel(uint32_t id, const DirectX::XMFLOAT4X4 &worldMatrix);
+	void SelectModel(std::optional<uint32_t> id);
+	void RemoveModel(uint32_t id);
+	void ClearModels();
+
+	void SpawnUnit(const Sim::UnitDesc &desc);
+	void MoveUnit(Sim::UnitId unit, DirectX::XMFLOAT2 target);
+	void StopUnit(Sim::UnitId unit);
+	void DespawnUnit(Sim::UnitId unit);
+	void Fire(const Sim::ProjectileDesc &desc);
+
+  private:
+	Command &Add(CommandType type);
+
+	CommandStream _stream;
+};
+
+// Ticks are stored as varint deltas and each command only with the fields of its type, a frame of camera panning
+// costs four bytes
+std::vector<uint8_t> Serialize(const CommandStream &stream);
+// Rejects anything malformed: wrong magic, newer versions, unknown commands, ticks out of order or truncated data
+std::optional<CommandStream> Deserialize(std::span<const uint8_t> data);
+
+bool Save(const std::filesystem::path &path, const CommandStream &stream);
+std::optional<CommandStream> Load(const std::filesystem::path &path);
+
+// Content hash of a terrain file as it goes into CommandStream::terrainHash, nothing when it cannot be read
+std::optional<Hash::Hash128> HashTerrainFile(const std::filesystem::path &path);
+
+} // namespace TGW::Replay
@@ -0,0 +1,240 @@
+#include "replay_world.h"
+#include "core/hash.h"
+#include "gltf/gltf_loader.h"
+#include "obj/obj_loader.h"
+
+#include <chrono>
+#include <cstring>
+
+using namespace TGW::Replay;
+using namespace DirectX;
+
+namespace {
+constexpr float GRID_CELL_SIZE = 16.0f;
+
+template <typename T> uint64_t HashValue(const T &value, uint64_t hash)
+{
+	return TGW::Hash::Fnv1a({reinterpret_cast<const char *>(&value), sizeof(T)}, hash);
+}
+
+XMFLOAT4X4 LoadMatrix(const std::array<float, 16> &values)
+{
+	XMFLOAT4X4 matrix;
+	std::memcpy(&matrix, values.data(), sizeof(XMFLOAT4X4));
+	return matrix;
+}
+
+template <typename Model> void CountGeometry(const Model &model, ReplayModel &out)
+{
+	for (const MeshData &mesh : model.meshes) {
+		out.vertexCount += static_cast<uint32_t>(mesh.vertices.size());
+		out.indexCount += static_cast<uint32_t>(mesh.indices.size());
+	}
+}
+} // namespace
+
+ReplayWorld::ReplayWorld(const ReplaySettings &settings, JobSystem &jobs)
+	: _settings{settings}, _jobs{jobs},
+	  _grid{{-settings.battleSize * 0.5f, -settings.battleSize * 0.5f}, GRID_CELL_SIZE,
+		  static_cast<uint32_t>(std::ceil(settings.battleSize / GRID_CELL_SIZE)),
+		  static_cast<uint32_t>(std::ceil(settings.battleSize / GRID_CELL_SIZE))}
+{
+}
+
+void ReplayWorld::SetTerrain(const Terrain::Heightmap *terrain)
+{
+	_terrain = terrain;
+	_camera.SetGround(terrain);
+}
+
+void ReplayWorld::Apply(const Command &command)
+{
+	const Sim::UnitId unit{command.id, command.generation};
+	const std::array<float, 16> &v = command.values;
+	switch (command.type) {
+	case COMMAND_CAMERA_ORBIT:
+		_camera.Orbit(v[0]);
+		break;
+	case COMMAND_CAMERA_PAN:
+		_camera.Pan(command.integers[0], command.integers[1]);
+		break;
+	case COMMAND_CAMERA_ZOOM:
+		_camera.HandleZoom(static_cast<short>(command.integers[0]));
+		break;
+	case COMMAND_CAMERA_VIEW:
+		_camera.SetView(XMVectorSet(v[0], v[1], v[2], 0.0f), XMVectorSet(v[3], v[4], v[5], 0.0f), v[6]);
+		break;
+	case COMMAND_LOAD_MODEL: {
+		ReplayModel &model = _models[command.id];
+		model = {.path = command.path, .worldMatrix = LoadMatrix(v), .vertexCount = 0, .indexCount = 0};
+		LoadModel(model);
+		break;
+	}
+	case COMMAND_MOVE_MODEL:
+		if (const auto it = _models.find(command.id); it != _models.end()) {
+			it->second.worldMatrix = LoadMatrix(v);
+		}
+		break;
+	case COMMAND_SELECT_MODEL:
+		_selectedModel.reset();
+		// Selecting in the editor centres the camera on the model
+		if (const auto it = _models.find(command.id); it != _models.end()) {
+			_camera.SetTarget(XMLoadFloat4x4(&it->second.worldMatrix).r[3]);
+			_selectedModel = command.id;
+		}
+		break;
+	case COMMAND_REMOVE_MODEL:
+		_models.erase(command.id);
+		if (_selectedModel == command.id) {
+			_selectedModel.reset();
+		}
+		break;
+	case COMMAND_CLEAR_MODELS:
+		_models.clear();
+		_selectedModel.reset();
+		break;
+	case COMMAND_SPAWN_UNIT:
+		_units.Spawn({
+		  .position = {v[0], v[1], v[2]},
+		  .heading = v[3],
+		  .maxSpeed = v[4],
+		  .health = v[5],
+		  .owner = static_cast<uint8_t>(command.integers[0]),
+		  .model = static_cast<uint32_t>(command.integers[1]),
+		});
+		break;
+	case COMMAND_MOVE_UNIT:
+		_units.SetMoveTarget(unit, {v[0], v[1]});
+		break;
+	case COMMAND_STOP_UNIT:
+		_units.Stop(unit);
+		break;
+	case COMMAND_DESPAWN_UNIT:
+		_units.Despawn(unit);
+		break;
+	case COMMAND_FIRE:
+		_projectiles.Spawn({
+		  .position = {v[0], v[1], v[2]},
+		  .velocity = {v[3], v[4], v[5]},
+		  .lifetime = v[6],
+		  .gravityScale = v[7],
+		  .owner = static_cast<uint8_t>(command.integers[0]),
+		  .payload = static_cast<uint32_t>(command.integers[1]),
+		});
+		break;
+	case COMMAND_TYPE_COUNT:
+		break;
+	}
+}
+
+void ReplayWorld::Tick()
+{
+	const float dt = _settings.tickSeconds;
+	_units.Tick(dt, _jobs);
+	_grid.Rebuild(_units.GetPositionsX(), _units.GetPositionsZ(), _jobs);
+	_projectiles.Tick(
+		dt,
+		{
+		  .terrain = _terrain,
+		  .grid = &_grid,
+		  .unitsX = _units.GetPositionsX(),
+		  .unitsY = _units.GetPositionsY(),
+		  .unitsZ = _units.GetPositionsZ(),
+		  .unitOwners = _units.GetOwners(),
+		  .unitRadius = _settings.unitRadius,
+		},
+		_jobs);
+
+	// Impacts point at dense indices, which stay put until RemoveDead
+	for (const Sim::ProjectileImpact &impact : _projectiles.GetImpacts()) {
+		if (impact.type == Sim::PROJECTILE_IMPACT_UNIT) {
+			_units.ApplyDamage(_units.GetId(impact.unit), static_cast<float>(impact.payload));
+		}
+	}
+	_units.RemoveDead();
+}
+
+uint64_t ReplayWorld::GetStateHash() const
+{
+	XMFLOAT3 target, forward;
+	XMStoreFloat3(&target, _camera.GetTarget());
+	XMStoreFloat3(&forward, _camera.GetForward());
+	uint64_t hash = HashValue(target, Hash::FNV_OFFSET_BASIS);
+	hash = HashValue(forward, hash);
+	hash = HashValue(_camera.GetZoom(), hash);
+
+	for (const auto &[id, model] : _models) {
+		hash = HashValue(id, hash);
+		hash = Hash::Fnv1a(model.path, hash);
+		hash = HashValue(model.worldMatrix, hash);
+		hash = HashValue(model.vertexCount, hash);
+		hash = HashValue(model.indexCount, hash);
+	}
+	hash = HashValue(_selectedModel.value_or(REPLAY_NO_MODEL), hash);
+	hash = HashValue(_units.GetStateHash(), hash);
+	return HashValue(_projectiles.GetStateHash(), hash);
+}
+
+/* Implementation of private functions */
+
+void ReplayWorld::LoadModel(ReplayModel &model) const
+{
+	if (!_settings.loadModels) {
+		return;
+	}
+	const std::filesystem::path path{model.path};
+	if (Gltf::IsGltfFile(path)) {
+		if (const std::optional<Gltf::GltfModel> gltf = Gltf::Load(path)) {
+			CountGeometry(*gltf, model);
+		}
+	} else if (Obj::IsObjFile(path)) {
+		if (const std::optional<Obj::ObjModel> obj = Obj::Load(path, _jobs)) {
+			CountGeometry(*obj, model);
+		}
+	}
+}
+
+/* Implementation of public functions */
+
+ReplayReport TGW::Replay::RunReplay(const CommandStream &stream, ReplayWorld &world, uint32_t hashInterval)
+{
+	ReplayReport report;
+	report.hashInterval = hashInterval;
+	report.tickMicros.reserve(stream.tickCount);
+
+	size_t next = 0;
+	for (uint32_t tick = 0; tick < stream.tickCount; tick++) {
+		const auto start = std::chrono::steady_clock::now();
+		for (; next < stream.commands.size() && stream.commands[next].tick == tick; next++) {
+			world.Apply(stream.commands[next]);
+		}
+		world.Tick();
+		report.tickMicros.push_back(
+			std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+		if (hashInterval > 0 && ((tick + 1) % hashInterval == 0 || tick + 1 == stream.tickCount)) {
+			report.hashes.push_back(world.GetStateHash());
+		}
+	}
+	report.finalHash = world.GetStateHash();
+	return report;
+}
+
+std::optional<uint32_t> TGW::Replay::FindDesync(const ReplayReport &a, const ReplayReport &b)
+{
+	const uint32_t interval = a.hashInterval;
+	if (interval > 0 && interval == b.hashInterval) {
+		const size_t shared = std::min(a.hashes.size(), b.hashes.size());
+		for (size_t i = 0; i < shared; i++) {
+			if (a.hashes[i] != b.hashes[i]) {
+				// The last checkpoint may come early, after the final tick
+				const uint32_t tick = static_cast<uint32_t>(i + 1) * interval;
+				return std::min(tick, static_cast<uint32_t>(std::min(a.tickMicros.size(), b.tickMicros.size()))) - 1;
+			}
+		}
+	}
+	if (!a.tickMicros.empty() && a.tickMicros.size() == b.tickMicros.size() && a.finalHash != b.finalHash) {
+		return static_cast<uint32_t>(a.tickMicros.size()) - 1;
+	}
+	return {};
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "camera.h"
+#include "command_stream.h"
+#include "sim/spatial_grid.h"
+
+#include <map>
+
+namespace TGW::Replay {
+
+// An editor model the way the headless replay sees it
+struct ReplayModel {
+	std::string path;
+	DirectX::XMFLOAT4X4 worldMatrix{};
+	// Geometry the native loaders read, zero when the file is missing or only Assimp reads it
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+};
+
+struct ReplaySettings {
+	float tickSeconds = 1.0f / 30.0f;
+	// Projectiles hit units within this radius and take their payload off the unit's health
+	float unitRadius = 1.0f;
+	// Side of the square around the origin the spatial grid covers, units outside it still work but crowd its border
+	float battleSize = 2048.0f;
+	// Off keeps model loads out of the timing and the hash, for replays run where the content is not
+	bool loadModels = true;
+};
+
+// What a recorded session drives without a window or a GPU: the camera, the editor's models and selection, and the
+// units and projectiles of a battle. Commands go in with Apply, Tick advances one fixed step. Nothing
+// depends on wall time or on how many threads the job system has, the same stream always ends in the same state.
+class ReplayWorld {
+  public:
+	explicit ReplayWorld(const ReplaySettings &settings, JobSystem &jobs = JobSystem::Get());
+
+	// The camera pans over this terrain and projectiles hit it, nullptr is flat open ground. terrain has to outlive
+	// the world.
+	void SetTerrain(const Terrain::Heightmap *terrain);
+
+	void Apply(const Command &command);
+	void Tick();
+
+	// Hash of the camera, models, selection, units and projectiles
+	uint64_t GetStateHash() const;
+
+	inline const Camera &GetCamera() const { return _camera; }
+	inline const std::map<uint32_t, ReplayModel> &GetModels() const { return _models; }
+	inline std::optional<uint32_t> GetSelectedModel() const { return _selectedModel; }
+	inline const Sim::UnitStore &GetUnits() const { return _units; }
+	inline const Sim::ProjectileSystem &GetProjectiles() const { return _projectiles; }
+
+  private:
+	void LoadModel(ReplayModel &model) const;
+
+	ReplaySettings _settings;
+	JobSystem &_jobs;
+	const Terrain::Heightmap *_terrain = nullptr;
+	Camera _camera;
+	// Ordered, so the hash goes through them by id
+	std::map<uint32_t, ReplayModel> _models;
+	std::optional<uint32_t> _selectedModel;
+	Sim::UnitStore _units;
+	Sim::ProjectileSystem _projectiles;
+	Sim::SpatialGrid _grid;
+};
+
+struct ReplayReport {
+	// Wall time of every tick, its commands included
+	std::vector<float> tickMicros;
+	// State hash after every hashInterval ticks, the last one after the final tick whatever the interval
+	uint32_t hashInterval = 0;
+	std::vector<uint64_t> hashes;
+	uint64_t finalHash = 0;
+};
+
+// Plays the whole stream as fast as it goes, every tick applies its commands and then steps the world
+ReplayReport RunReplay(const CommandStream &stream, ReplayWorld &world, uint32_t hashInterval = 0);
+
+// Tick after which two runs of the same stream first disagree, as far as their checkpoints tell. Nothing when every
+// checkpoint they share and, for runs of the same length, the final state match.
+std::optional<uint32_t> FindDesync(const ReplayReport &a, const ReplayReport &b);
+
+} // namespace TGW::Replay
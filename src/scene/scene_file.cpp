@@ -0,0 +1,135 @@
+#include "scene_file.h"
+#include "core/binary_stream.h"
+
+#include <fstream>
+
+using namespace TGW::Scene;
+
+namespace {
+constexpr size_t FLOATS_PER_MATRIX = sizeof(DirectX::XMFLOAT4X4) / sizeof(float);
+static_assert(FLOATS_PER_MATRIX == 16);
+
+std::span<const float> AsFloats(const std::vector<DirectX::XMFLOAT4X4> &matrices)
+{
+	return {reinterpret_cast<const float *>(matrices.data()), matrices.size() * FLOATS_PER_MATRIX};
+}
+} // namespace
+
+std::vector<uint8_t> TGW::Scene::Serialize(const SceneData &scene)
+{
+	const size_t entityCount = scene.GetEntityCount();
+	if (scene.worldMatrices.size() != entityCount || scene.flags.size() != entityCount) {
+		return {};
+	}
+
+	BinaryWriter writer;
+	writer.Write(SCENE_MAGIC);
+	writer.Write(SCENE_VERSION);
+
+	const CameraState &camera = scene.camera;
+	const float cameraValues[] = {camera.target.x,	camera.target.y,  camera.target.z, camera.forward.x,
+								  camera.forward.y, camera.forward.z, camera.zoom};
+	writer.WriteArray(std::span<const float>{cameraValues});
+
+	writer.Write(static_cast<uint32_t>(scene.modelPaths.size()));
+	for (const auto &path : scene.modelPaths) {
+		writer.WriteString(path);
+	}
+
+	writer.Write(static_cast<uint32_t>(entityCount));
+	writer.WriteArray(std::span<const uint32_t>{scene.modelIndices});
+	writer.WriteArray(AsFloats(scene.worldMatrices));
+	writer.WriteArray(std::span<const uint8_t>{scene.flags});
+
+	return writer.TakeBuffer();
+}
+
+std::optional<SceneData> TGW::Scene::Deserialize(std::span<const uint8_t> data)
+{
+	BinaryReader reader{data};
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	if (!reader.Read(magic) || !reader.Read(version) || magic != SCENE_MAGIC || version == 0 || version > SCENE_VERSION) {
+		return {};
+	}
+
+	SceneData scene;
+	float cameraValues[7] = {};
+	reader.ReadArray(std::span<float>{cameraValues});
+	scene.camera = {
+	  .target = {cameraValues[0], cameraValues[1], cameraValues[2]},
+	  .forward = {cameraValues[3], cameraValues[4], cameraValues[5]},
+	  .zoom = cameraValues[6],
+	};
+
+	uint32_t modelCount = 0;
+	reader.Read(modelCount);
+	// Every path costs at least its length prefix, which bounds the allocation for garbage counts
+	if (modelCount > reader.GetRemaining() / sizeof(uint32_t)) {
+		return {};
+	}
+	scene.modelPaths.resize(modelCount);
+	for (auto &path : scene.modelPaths) {
+		reader.ReadString(path);
+	}
+
+	uint32_t entityCount = 0;
+	reader.Read(entityCount);
+	constexpr size_t ENTITY_SIZE = sizeof(uint32_t) + sizeof(DirectX::XMFLOAT4X4) + sizeof(uint8_t);
+	if (reader.HasFailed() || entityCount > reader.GetRemaining() / ENTITY_SIZE) {
+		return {};
+	}
+
+	reader.ReadArray(scene.modelIndices, entityCount);
+	scene.worldMatrices.resize(entityCount);
+	reader.ReadArray(std::span<float>{reinterpret_cast<float *>(scene.worldMatrices.data()), entityCount * FLOATS_PER_MATRIX});
+	reader.ReadArray(scene.flags, entityCount);
+
+	if (reader.HasFailed() || reader.GetRemaining() != 0) {
+		return {};
+	}
+	for (uint32_t modelIndex : scene.modelIndices) {
+		if (modelIndex >= modelCount) {
+			return {};
+		}
+	}
+
+	return scene;
+}
+
+bool TGW::Scene::Save(const std::filesystem::path &path, const SceneData &scene)
+{
+	const std::vector<uint8_t> data = Serialize(scene);
+	if (data.empty()) {
+		return false;
+	}
+
+	// Write next to the target and swap it in, a crash mid-save must not eat the previous scene
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+		if (!file.write(reinterpret_cast<const char *>(data.data()), data.size())) {
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	return !error;
+}
+
+std::optional<SceneData> TGW::Scene::Load(const std::filesystem::path &path)
+{
+	std::ifstream file{path, std::ios::binary | std::ios::ate};
+	if (!file) {
+		return {};
+	}
+
+	std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char *>(data.data()), data.size())) {
+		return {};
+	}
+	return Deserialize(data);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.h"
+
+#include <span>
+
+namespace TGW::Scene {
+
+constexpr uint32_t SCENE_MAGIC = 0x43534853; // "SHSC"
+constexpr uint32_t SCENE_VERSION = 1;
+
+enum EntityFlags : uint8_t {
+	ENTITY_FLAG_NONE = 0,
+	ENTITY_FLAG_SELECTED = 1 << 0,
+};
+
+struct CameraState {
+	DirectX::XMFLOAT3 target;
+	DirectX::XMFLOAT3 forward;
+	float zoom;
+};
+
+// Entities are stored as parallel arrays so a load is a handful of bulk copies
+struct SceneData {
+	CameraState camera{};
+
+	// Every model file the scene references, once
+	std::vector<std::string> modelPaths;
+
+	// Per entity, all the same length
+	std::vector<uint32_t> modelIndices;
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+	std::vector<uint8_t> flags;
+
+	inline size_t GetEntityCount() const { return modelIndices.size(); }
+};
+
+// Returns an empty buffer when the entity arrays disagree in length
+std::vector<uint8_t> Serialize(const SceneData &scene);
+// Rejects anything malformed: wrong magic, newer versions, truncated arrays or out of range model indices
+std::optional<SceneData> Deserialize(std::span<const uint8_t> data);
+
+bool Save(const std::filesystem::path &path, const SceneData &scene);
+std::optional<SceneData> Load(const std::filesystem::path &path);
+
+} // namespace TGW::Scene
@@ -0,0 +1,84 @@
+#include "d3d_shader_compiler.h"
+#include <d3dcompiler.h>
+
+#include <list>
+
+using Microsoft::WRL::ComPtr;
+using namespace TGW::Shader;
+
+namespace {
+UINT GetCompileFlags()
+{
+	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+#if defined(DEBUG) || defined(_DEBUG)
+	flags |= D3DCOMPILE_DEBUG;
+#endif
+	return flags;
+}
+
+std::string GetDirectory(const std::string &path) { return path.substr(0, path.find_last_of('/') + 1); }
+
+// Keeps every opened file alive until the compile is done, keyed by its data so nested includes know their parent
+class CacheInclude final : public ID3DInclude {
+  public:
+	CacheInclude(const ShaderFileReader &read, std::string source) : _read{read}, _source{std::move(source)} {}
+
+	HRESULT __stdcall Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID parentData, LPCVOID *data, UINT *bytes) override
+	{
+		const auto parent = _paths.find(parentData);
+		const std::string directory = GetDirectory(parent != _paths.end() ? parent->second : _source);
+		const std::string path = std::filesystem::path{directory + fileName}.lexically_normal().generic_string();
+		std::optional<std::vector<uint8_t>> file = _read(path);
+		if (!file) {
+			return E_FAIL;
+		}
+		_files.push_back(std::move(*file));
+		*data = _files.back().data();
+		*bytes = static_cast<UINT>(_files.back().size());
+		_paths.emplace(*data, path);
+		return S_OK;
+	}
+
+	HRESULT __stdcall Close(LPCVOID) override { return S_OK; }
+
+  private:
+	const ShaderFileReader &_read;
+	std::string _source;
+	// A list, so the data pointers handed out stay put
+	std::list<std::vector<uint8_t>> _files;
+	std::unordered_map<LPCVOID, std::string> _paths;
+};
+} // namespace
+
+std::optional<std::vector<uint8_t>> D3DShaderCompiler::Compile(
+	const ShaderRequest &request, const ShaderFileReader &read, std::string &errors)
+{
+	const std::optional<std::vector<uint8_t>> source = read(request.source);
+	if (!source) {
+		errors = "Cannot open " + request.source;
+		return {};
+	}
+
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (const ShaderDefine &define : request.defines) {
+		macros.push_back(D3D_SHADER_MACRO{define.name.c_str(), define.value.c_str()});
+	}
+	macros.push_back(D3D_SHADER_MACRO{nullptr, nullptr});
+
+	CacheInclude include{read, request.source};
+	ComPtr<ID3DBlob> bytecode;
+	ComPtr<ID3DBlob> errorBlob;
+	const HRESULT hr = D3DCompile(source->data(), source->size(), request.source.c_str(), macros.data(), &include,
+		request.entryPoint.c_str(), request.profile.c_str(), GetCompileFlags(), 0, &bytecode, &errorBlob);
+	if (errorBlob) {
+		errors.assign(static_cast<const char *>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize());
+	}
+	if (FAILED(hr)) {
+		return {};
+	}
+
+	const auto *bytes = static_cast<const uint8_t *>(bytecode->GetBufferPointer());
+	return std::vector<uint8_t>(bytes, bytes + bytecode->GetBufferSize());
+}
+
+uint64_t D3DShaderCompiler::GetVersion() const { return (uint64_t{D3D_COMPILER_VERSION} << 32) | GetCompileFlags(); }
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "pch.h"
+#include "shader/shader_cache.h"
+
+namespace TGW::Shader {
+
+// D3DCompile behind the shader cache. Includes are resolved relative to the including file and read through the
+// cache, so it sees every file a shader depends on.
+class D3DShaderCompiler final : public IShaderCompiler {
+  public:
+	std::optional<std::vector<uint8_t>> Compile(
+		const ShaderRequest &request, const ShaderFileReader &read, std::string &errors) override;
+	uint64_t GetVersion() const override;
+};
+
+} // namespace TGW::Shader
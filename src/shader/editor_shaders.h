@@ -0,0 +1,21 @@
+#pragma once
+
+#include "shader/shader_cache.h"
+
+namespace TGW::Shader {
+
+// Every shader the editor creates. shellshock_shaderc compiles these at build time into the embedded pack, and the
+// editor loads them all in parallel on startup. Paths are relative to the shaders directory.
+inline const std::vector<ShaderRequest> EDITOR_SHADERS = {
+  {.source = "model.hlsl", .entryPoint = "VSMain", .profile = "vs_5_0", .defines = {}},
+  {.source = "model.hlsl", .entryPoint = "PSMain", .profile = "ps_5_0", .defines = {}},
+  {.source = "terrain.hlsl", .entryPoint = "VSMain", .profile = "vs_5_0", .defines = {}},
+  {.source = "terrain.hlsl", .entryPoint = "PSMain", .profile = "ps_5_0", .defines = {}},
+  {.source = "particles.hlsl", .entryPoint = "VSMain", .profile = "vs_5_0", .defines = {}},
+  {.source = "particles.hlsl", .entryPoint = "PSMain", .profile = "ps_5_0", .defines = {}},
+};
+
+// The pack shellshock_shaderc generated, defined in embedded_shaders.cpp in the build directory
+std::span<const uint8_t> GetEmbeddedShaders();
+
+} // namespace TGW::Shader
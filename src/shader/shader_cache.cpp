@@ -0,0 +1,298 @@
+#include "shader_cache.h"
+#include "cook/cook_cache.h"
+#include "core/binary_stream.h"
+#include "core/hash.h"
+#include "log.h"
+
+using namespace TGW::Shader;
+
+namespace {
+// Path, two hash halves and at least the bytecode size
+constexpr size_t MIN_DEPENDENCY_BYTES = sizeof(uint32_t) + 2 * sizeof(uint64_t);
+constexpr size_t MIN_ENTRY_BYTES = sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+// Fields are hashed with their lengths, so moving text from one to the next changes the key
+uint64_t HashField(uint64_t hash, std::string_view field)
+{
+	const uint32_t size = static_cast<uint32_t>(field.size());
+	hash = TGW::Hash::Fnv1a({reinterpret_cast<const char *>(&size), sizeof(size)}, hash);
+	return TGW::Hash::Fnv1a(field, hash);
+}
+
+void WriteEntry(TGW::BinaryWriter &writer, const ShaderEntry &entry)
+{
+	writer.Write(entry.key);
+	writer.Write(static_cast<uint32_t>(entry.dependencies.size()));
+	for (const ShaderDependency &dependency : entry.dependencies) {
+		writer.WriteString(dependency.path);
+		writer.Write(dependency.hash.low);
+		writer.Write(dependency.hash.high);
+	}
+	writer.Write(static_cast<uint32_t>(entry.bytecode.size()));
+	writer.WriteArray(std::span<const uint8_t>{entry.bytecode});
+}
+
+bool ReadEntry(TGW::BinaryReader &reader, ShaderEntry &entry)
+{
+	uint32_t dependencyCount = 0;
+	if (!reader.Read(entry.key) || !reader.Read(dependencyCount) ||
+		dependencyCount > reader.GetRemaining() / MIN_DEPENDENCY_BYTES) {
+		return false;
+	}
+	entry.dependencies.resize(dependencyCount);
+	for (ShaderDependency &dependency : entry.dependencies) {
+		reader.ReadString(dependency.path);
+		reader.Read(dependency.hash.low);
+		reader.Read(dependency.hash.high);
+	}
+	uint32_t bytecodeSize = 0;
+	// Every entry was compiled from at least its source
+	return reader.Read(bytecodeSize) && reader.ReadArray(entry.bytecode, bytecodeSize) && dependencyCount > 0;
+}
+
+bool ReadHeader(TGW::BinaryReader &reader, uint32_t expectedMagic)
+{
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	return reader.Read(magic) && reader.Read(version) && magic == expectedMagic && version != 0 &&
+		version <= SHADER_CACHE_VERSION;
+}
+} // namespace
+
+/* ShaderCache */
+
+ShaderCache::ShaderCache(IShaderCompiler &compiler, std::filesystem::path sourceRoot, std::filesystem::path cacheDirectory)
+	: _compiler{compiler}, _sourceRoot{std::move(sourceRoot)}, _cacheDirectory{std::move(cacheDirectory)}
+{
+}
+
+bool ShaderCache::AddEmbedded(std::span<const uint8_t> pack)
+{
+	std::optional<std::vector<ShaderEntry>> entries = DeserializeShaderPack(pack);
+	if (!entries) {
+		return false;
+	}
+	std::lock_guard lock{_mutex};
+	for (ShaderEntry &entry : *entries) {
+		const uint64_t key = entry.key;
+		_embedded.insert_or_assign(key, std::make_shared<const ShaderEntry>(std::move(entry)));
+	}
+	return true;
+}
+
+std::shared_ptr<const ShaderEntry> ShaderCache::Load(const ShaderRequest &request)
+{
+	const uint64_t key = GetShaderKey(request, _compiler.GetVersion());
+	{
+		std::lock_guard lock{_mutex};
+		if (const auto loaded = _loaded.find(key); loaded != _loaded.end()) {
+			return loaded->second;
+		}
+	}
+	return Resolve(request, key);
+}
+
+std::vector<std::shared_ptr<const ShaderEntry>> ShaderCache::LoadAll(
+	std::span<const ShaderRequest> requests, JobSystem &jobs)
+{
+	std::vector<std::shared_ptr<const ShaderEntry>> entries(requests.size());
+	// One job per shader, a single compile is long enough to be worth its own worker
+	jobs.ParallelFor(static_cast<uint32_t>(requests.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			entries[i] = Load(requests[i]);
+		}
+	});
+	return entries;
+}
+
+ShaderCacheStats ShaderCache::GetStats() const
+{
+	return ShaderCacheStats{
+	  .embeddedHits = _embeddedHits,
+	  .diskHits = _diskHits,
+	  .compiled = _compiled,
+	  .failed = _failed,
+	};
+}
+
+std::filesystem::path ShaderCache::GetEntryPath(uint64_t key) const
+{
+	char name[21];
+	std::snprintf(name, sizeof(name), "%016llx.shc", static_cast<unsigned long long>(key));
+	return _cacheDirectory / name;
+}
+
+std::shared_ptr<const ShaderEntry> ShaderCache::Resolve(const ShaderRequest &request, uint64_t key)
+{
+	std::shared_ptr<const ShaderEntry> entry;
+	{
+		std::lock_guard lock{_mutex};
+		if (const auto embedded = _embedded.find(key); embedded != _embedded.end()) {
+			entry = embedded->second;
+		}
+	}
+	if (entry && IsCurrent(*entry, true)) {
+		_embeddedHits++;
+	} else {
+		entry.reset();
+	}
+
+	if (!entry && !_cacheDirectory.empty()) {
+		const std::optional<std::vector<uint8_t>> data = Cook::ReadWholeFile(GetEntryPath(key));
+		std::optional<ShaderEntry> stored = data ? DeserializeShaderEntry(*data) : std::nullopt;
+		if (stored && stored->key == key && IsCurrent(*stored, false)) {
+			entry = std::make_shared<const ShaderEntry>(std::move(*stored));
+			_diskHits++;
+		}
+	}
+
+	if (!entry) {
+		std::optional<ShaderEntry> compiled = Compile(request, key);
+		if (!compiled) {
+			_failed++;
+			return nullptr;
+		}
+		_compiled++;
+		// A failed write only costs a compile next time
+		if (!_cacheDirectory.empty()) {
+			Cook::WriteFileAtomic(GetEntryPath(key), SerializeShaderEntry(*compiled));
+		}
+		entry = std::make_shared<const ShaderEntry>(std::move(*compiled));
+	}
+
+	std::lock_guard lock{_mutex};
+	return _loaded.try_emplace(key, std::move(entry)).first->second;
+}
+
+std::optional<ShaderEntry> ShaderCache::Compile(const ShaderRequest &request, uint64_t key)
+{
+	ShaderEntry entry;
+	entry.key = key;
+	const ShaderFileReader read = [this, &entry](const std::string &path) {
+		Hash::Hash128 hash;
+		std::optional<std::vector<uint8_t>> data = ReadSource(path, hash);
+		if (data) {
+			entry.dependencies.push_back(ShaderDependency{.path = path, .hash = hash});
+		}
+		return data;
+	};
+
+	std::string errors;
+	std::optional<std::vector<uint8_t>> bytecode = _compiler.Compile(request, read, errors);
+	if (!bytecode || entry.dependencies.empty() || entry.dependencies.front().path != request.source) {
+		Logger::LogInfo("Failed to compile " + request.source + " " + request.entryPoint + " " + request.profile + ": " +
+			(errors.empty() ? "source not found" : errors));
+		return {};
+	}
+	entry.bytecode = std::move(*bytecode);
+	return entry;
+}
+
+bool ShaderCache::IsCurrent(const ShaderEntry &entry, bool allowMissingSource)
+{
+	for (size_t i = 0; i < entry.dependencies.size(); i++) {
+		const std::optional<Hash::Hash128> hash = GetFileHash(entry.dependencies[i].path);
+		if (!hash) {
+			// Shipped without sources, the embedded bytecode is all there is
+			return i == 0 && allowMissingSource;
+		}
+		if (*hash != entry.dependencies[i].hash) {
+			return false;
+		}
+	}
+	return !entry.dependencies.empty();
+}
+
+std::optional<TGW::Hash::Hash128> ShaderCache::GetFileHash(const std::string &path)
+{
+	{
+		std::lock_guard lock{_mutex};
+		if (const auto known = _fileHashes.find(path); known != _fileHashes.end()) {
+			return known->second;
+		}
+	}
+	Hash::Hash128 hash;
+	if (!ReadSource(path, hash)) {
+		return {};
+	}
+	return hash;
+}
+
+std::optional<std::vector<uint8_t>> ShaderCache::ReadSource(const std::string &path, Hash::Hash128 &hash)
+{
+	std::optional<std::vector<uint8_t>> data = Cook::ReadWholeFile(_sourceRoot / path);
+	if (data) {
+		hash = Hash::ContentHash128(*data);
+	}
+	std::lock_guard lock{_mutex};
+	_fileHashes.insert_or_assign(path, data ? std::optional{hash} : std::nullopt);
+	return data;
+}
+
+/* Implementation of public functions */
+
+uint64_t TGW::Shader::GetShaderKey(const ShaderRequest &request, uint64_t compilerVersion)
+{
+	uint64_t hash = Hash::Fnv1a({reinterpret_cast<const char *>(&compilerVersion), sizeof(compilerVersion)});
+	hash = HashField(hash, request.source);
+	hash = HashField(hash, request.entryPoint);
+	hash = HashField(hash, request.profile);
+	for (const ShaderDefine &define : request.defines) {
+		hash = HashField(hash, define.name);
+		hash = HashField(hash, define.value);
+	}
+	return hash;
+}
+
+std::vector<uint8_t> TGW::Shader::SerializeShaderEntry(const ShaderEntry &entry)
+{
+	BinaryWriter writer;
+	writer.Write(SHADER_ENTRY_MAGIC);
+	writer.Write(SHADER_CACHE_VERSION);
+	WriteEntry(writer, entry);
+	return writer.TakeBuffer();
+}
+
+std::optional<ShaderEntry> TGW::Shader::DeserializeShaderEntry(std::span<const uint8_t> data)
+{
+	BinaryReader reader{data};
+	ShaderEntry entry;
+	if (!ReadHeader(reader, SHADER_ENTRY_MAGIC) || !ReadEntry(reader, entry) || reader.HasFailed() ||
+		reader.GetRemaining() != 0) {
+		return {};
+	}
+	return entry;
+}
+
+std::vector<uint8_t> TGW::Shader::SerializeShaderPack(std::span<const ShaderEntry> entries)
+{
+	BinaryWriter writer;
+	writer.Write(SHADER_PACK_MAGIC);
+	writer.Write(SHADER_CACHE_VERSION);
+	writer.Write(static_cast<uint32_t>(entries.size()));
+	for (const ShaderEntry &entry : entries) {
+		WriteEntry(writer, entry);
+	}
+	return writer.TakeBuffer();
+}
+
+std::optional<std::vector<ShaderEntry>> TGW::Shader::DeserializeShaderPack(std::span<const uint8_t> data)
+{
+	BinaryReader reader{data};
+	uint32_t entryCount = 0;
+	if (!ReadHeader(reader, SHADER_PACK_MAGIC) || !reader.Read(entryCount) ||
+		entryCount > reader.GetRemaining() / MIN_ENTRY_BYTES) {
+		return {};
+	}
+
+	std::vector<ShaderEntry> entries(entryCount);
+	for (ShaderEntry &entry : entries) {
+		if (!ReadEntry(reader, entry)) {
+			return {};
+		}
+	}
+	if (reader.HasFailed() || reader.GetRemaining() != 0) {
+		return {};
+	}
+	return entries;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "common.h"
+#include "core/content_hash.h"
+#include "core/job_system.h"
+
+#include <atomic>
+#include <span>
+
+namespace TGW::Shader {
+
+constexpr uint32_t SHADER_ENTRY_MAGIC = 0x43485353; // "SSHC"
+constexpr uint32_t SHADER_PACK_MAGIC = 0x50485353;	// "SSHP"
+constexpr uint32_t SHADER_CACHE_VERSION = 1;
+
+struct ShaderDefine {
+	std::string name;
+	std::string value;
+};
+
+// One permutation of a shader
+struct ShaderRequest {
+	// Relative to the source root, with forward slashes
+	std::string source;
+	std::string entryPoint;
+	std::string profile;
+	std::vector<ShaderDefine> defines;
+};
+
+// A file the compiler read and the content hash it had then
+struct ShaderDependency {
+	std::string path;
+	Hash::Hash128 hash;
+};
+
+struct ShaderEntry {
+	uint64_t key = 0;
+	// The source first, then every file it included. Relative to the source root.
+	std::vector<ShaderDependency> dependencies;
+	std::vector<uint8_t> bytecode;
+};
+
+// Reads a file relative to the source root, nothing if it is missing
+using ShaderFileReader = std::function<std::optional<std::vector<uint8_t>>(const std::string &path)>;
+
+// The cache knows nothing about D3D, the editor plugs D3DCompile in behind this
+class IShaderCompiler {
+  public:
+	virtual ~IShaderCompiler() = default;
+
+	// Has to read the source and all of its includes through read, that is how the cache learns the dependencies.
+	// Returns nothing on failure, with the compiler output in errors.
+	virtual std::optional<std::vector<uint8_t>> Compile(
+		const ShaderRequest &request, const ShaderFileReader &read, std::string &errors) = 0;
+	// Changes whenever the same sources could compile to different bytecode, compiler updates and flags included
+	virtual uint64_t GetVersion() const = 0;
+};
+
+struct ShaderCacheStats {
+	uint32_t embeddedHits = 0;
+	uint32_t diskHits = 0;
+	uint32_t compiled = 0;
+	uint32_t failed = 0;
+};
+
+// Compiled shaders keyed by the request and the compiler version. An entry is only used while every file it was
+// compiled from still hashes the same, so edited sources or includes recompile and untouched ones never do. Looks in
+// memory, then the embedded pack, then the cache directory, and only then compiles and writes the result back.
+class ShaderCache {
+  public:
+	// An empty cache directory keeps compiled shaders in memory only
+	ShaderCache(IShaderCompiler &compiler, std::filesystem::path sourceRoot, std::filesystem::path cacheDirectory = {});
+
+	// A pack from SerializeShaderPack, usually compiled into the executable. Its entries are checked against the sources
+	// like any other, but are used as they are when the source is not there at all.
+	bool AddEmbedded(std::span<const uint8_t> pack);
+
+	// Nothing if the shader failed to compile, the errors go to the log
+	std::shared_ptr<const ShaderEntry> Load(const ShaderRequest &request);
+	// Same order as requests. Misses are compiled in parallel on jobs.
+	std::vector<std::shared_ptr<const ShaderEntry>> LoadAll(
+		std::span<const ShaderRequest> requests, JobSystem &jobs = JobSystem::Get());
+
+	ShaderCacheStats GetStats() const;
+	std::filesystem::path GetEntryPath(uint64_t key) const;
+
+  private:
+	std::shared_ptr<const ShaderEntry> Resolve(const ShaderRequest &request, uint64_t key);
+	std::optional<ShaderEntry> Compile(const ShaderRequest &request, uint64_t key);
+	bool IsCurrent(const ShaderEntry &entry, bool allowMissingSource);
+	std::optional<Hash::Hash128> GetFileHash(const std::string &path);
+	std::optional<std::vector<uint8_t>> ReadSource(const std::string &path, Hash::Hash128 &hash);
+
+	IShaderCompiler &_compiler;
+	std::filesystem::path _sourceRoot;
+	std::filesystem::path _cacheDirectory;
+
+	mutable std::mutex _mutex;
+	std::unordered_map<uint64_t, std::shared_ptr<const ShaderEntry>> _loaded;
+	std::unordered_map<uint64_t, std::shared_ptr<const ShaderEntry>> _embedded;
+	// Sources are hashed once per cache, many permutations share them. Missing files are remembered as nothing.
+	std::unordered_map<std::string, std::optional<Hash::Hash128>> _fileHashes;
+
+	std::atomic<uint32_t> _embeddedHits = 0;
+	std::atomic<uint32_t> _diskHits = 0;
+	std::atomic<uint32_t> _compiled = 0;
+	std::atomic<uint32_t> _failed = 0;
+};
+
+// Covers the request and the compiler version but not the file contents, those are checked per entry
+uint64_t GetShaderKey(const ShaderRequest &request, uint64_t compilerVersion);
+
+std::vector<uint8_t> SerializeShaderEntry(const ShaderEntry &entry);
+std::optional<ShaderEntry> DeserializeShaderEntry(std::span<const uint8_t> data);
+std::vector<uint8_t> SerializeShaderPack(std::span<const ShaderEntry> entries);
+std::optional<std::vector<ShaderEntry>> DeserializeShaderPack(std::span<const uint8_t> data);
+
+} // namespace TGW::Shader
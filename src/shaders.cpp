@@ -1,6 +1,23 @@
 #include "shaders.h"
+#include "shader/d3d_shader_compiler.h"
+#include "shader/editor_shaders.h"
+
 #include <d3dcompiler.h>
 
+namespace {
+// Compiled shaders are kept next to the executable, the embedded pack covers them until a source changes
+TGW::Shader::ShaderCache &GetShaderCache()
+{
+	static TGW::Shader::D3DShaderCompiler compiler;
+	static TGW::Shader::ShaderCache cache{compiler, "shaders", "shader_cache"};
+	static std::once_flag embedded;
+	std::call_once(embedded, [] { cache.AddEmbedded(TGW::Shader::GetEmbeddedShaders()); });
+	return cache;
+}
+} // namespace
+
+void PreloadShaders() { GetShaderCache().LoadAll(TGW::Shader::EDITOR_SHADERS); }
+
 HRESULT CompileShader(_In_ LPCWSTR srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob **blob)
 {
 	if (!srcFile || !entryPoint || !profile || !blob) {
@@ -9,28 +26,21 @@ HRESULT CompileShader(_In_ LPCWSTR srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR
 
 	*blob = nullptr;
 
-	UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-#if defined(DEBUG) || defined(_DEBUG)
-	flags |= D3DCOMPILE_DEBUG;
-#endif
-
-	ID3DBlob *shaderBlob = nullptr;
-	ID3DBlob *errorBlob = nullptr;
-	HRESULT hr = D3DCompileFromFile(
-		srcFile, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, profile, flags, 0, &shaderBlob, &errorBlob);
+	// Callers name the file the way it sits next to the executable, the cache wants it relative to the shaders
+	const std::filesystem::path path = std::filesystem::path{srcFile}.lexically_relative("shaders");
+	const TGW::Shader::ShaderRequest request{
+	  .source = path.generic_string(), .entryPoint = entryPoint, .profile = profile, .defines = {}};
+	const std::shared_ptr<const TGW::Shader::ShaderEntry> entry = GetShaderCache().Load(request);
+	if (!entry) {
+		ERROR("Failed to compile %s %s, see the log", request.source.c_str(), entryPoint);
+		return E_FAIL;
+	}
 
+	const HRESULT hr = D3DCreateBlob(entry->bytecode.size(), blob);
 	if (FAILED(hr)) {
-		if (errorBlob) {
-			ERROR((char *)errorBlob->GetBufferPointer());
-			errorBlob->Release();
-		}
-		if (shaderBlob) {
-			shaderBlob->Release();
-		}
 		return hr;
 	}
-
-	*blob = shaderBlob;
+	std::memcpy((*blob)->GetBufferPointer(), entry->bytecode.data(), entry->bytecode.size());
 
 	return hr;
-}
\ No newline at end of file
+}
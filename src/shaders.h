@@ -9,6 +9,62 @@ struct ConstantBuffer {
 
 	DirectX::XMFLOAT3 cameraPos;
 	float isSelected{0.0f};
+
+	// Into the material buffer at t8, see MaterialArrays
+	uint32_t materialIndex{0};
+	float padding[3]{};
+};
+
+// Register b1 of model.hlsl, maps world XZ onto the fog texture at t4
+struct FogConstantBuffer {
+	DirectX::XMFLOAT2 origin{0.0f, 0.0f};
+	DirectX::XMFLOAT2 inverseSize{0.0f, 0.0f};
+	float enabled{0.0f};
+	float padding[3]{};
+};
+
+// Register b2 of model.hlsl, how pixels find their cluster in the light buffers at t5 to t7
+struct LightConstantBuffer {
+	DirectX::XMFLOAT2 tilesPerPixel{0.0f, 0.0f};
+	float sliceScale{0.0f};
+	float sliceBias{0.0f};
+	uint32_t tilesX{0};
+	uint32_t tilesY{0};
+	uint32_t slices{0};
+	float enabled{0.0f};
+};
+
+// Registers b0 and b2 of terrain.hlsl, per frame and per drawn chunk
+struct TerrainFrameConstantBuffer {
+	DirectX::XMMATRIX viewProjection;
+	DirectX::XMFLOAT3 eye;
+	float gridQuads{0.0f};
+	DirectX::XMFLOAT2 mapOrigin{0.0f, 0.0f};
+	DirectX::XMFLOAT2 mapToUV{0.0f, 0.0f};
+	DirectX::XMFLOAT2 texelSize{0.0f, 0.0f};
+	float sampleSpacing{1.0f};
+	float padding{0.0f};
+};
+
+struct TerrainChunkConstantBuffer {
+	DirectX::XMFLOAT2 origin{0.0f, 0.0f};
+	float size{0.0f};
+	float morphStart{0.0f};
+	float morphEnd{0.0f};
+	float padding[3]{};
+};
+
+// Register b0 of particles.hlsl, the camera axes the billboards are spanned by
+struct ParticleFrameConstantBuffer {
+	DirectX::XMMATRIX viewProjection;
+	DirectX::XMFLOAT3 cameraRight{1.0f, 0.0f, 0.0f};
+	float padding0{0.0f};
+	DirectX::XMFLOAT3 cameraUp{0.0f, 1.0f, 0.0f};
+	float padding1{0.0f};
 };
 
+// Loads every editor shader at once, compiling the ones neither the embedded pack nor the shader cache has up to date in
+// parallel. CompileShader then only copies out the bytecode.
+void PreloadShaders();
+// Bytecode of the shader at srcFile, through the shader cache
 HRESULT CompileShader(_In_ LPCWSTR srcFile, _In_ LPCSTR entryPoint, _In_ LPCSTR profile, _Outptr_ ID3DBlob **blob);
\ No newline at end of file
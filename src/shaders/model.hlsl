@@ -5,6 +5,36 @@ cbuffer CB : register(b0)
     float4x4 projection;
     float3 cameraPos;
     float isSelected;
+    uint materialIndex;
+};
+
+// Filled from FogTexture, world XZ to fog texture coordinates. Off when fogEnabled is 0.
+cbuffer FogCB : register(b1)
+{
+    float2 fogOrigin;
+    float2 fogInverseSize;
+    float fogEnabled;
+};
+
+// Filled from LightClusterBuffers. Pixels find their cluster from their screen tile and view depth, which lists
+// the lights reaching it. Off when lightsEnabled is 0.
+cbuffer LightCB : register(b2)
+{
+    float2 tilesPerPixel;
+    float sliceScale;
+    float sliceBias;
+    uint tilesX;
+    uint tilesY;
+    uint slices;
+    float lightsEnabled;
+};
+
+struct PointLight
+{
+    float3 position;
+    float radius;
+    float3 color;
+    float intensity;
 };
 
 struct VSInput
@@ -18,6 +48,9 @@ struct VSOutput
 {
     float4 pos : SV_POSITION;
     float2 uv : TEXCOORD;
+    float3 worldPos : TEXCOORD1;
+    float3 normal : NORMAL;
+    float viewDepth : TEXCOORD2;
 };
 
 VSOutput VSMain(VSInput input)
@@ -31,16 +64,88 @@ VSOutput VSMain(VSInput input)
     float4 worldPos = mul(float4(finalPos, 1.0f), model);
     o.pos = mul(mul(worldPos, view), projection);
     o.uv = input.uv;
+    o.worldPos = worldPos.xyz;
+    o.normal = mul(float4(input.norm, 0.0f), model).xyz;
+    o.viewDepth = mul(worldPos, view).z;
     
     return o;
 }
 
-Texture2D tex : register(t0);
 SamplerState samp : register(s0);
+Texture2D fogTex : register(t4);
+SamplerState fogSamp : register(s1);
+StructuredBuffer<PointLight> lights : register(t5);
+StructuredBuffer<uint2> lightClusters : register(t6); // offset and count into lightIndices
+StructuredBuffer<uint> lightIndices : register(t7);
+// Filled from MaterialArrays. Per texture slot (diffuse, specular, normal, roughness) the array in the high half
+// and the slice in the low half, 0xFFFF arrays for textures a material does not have.
+StructuredBuffer<uint4> materials : register(t8);
+Texture2DArray textureArrays[8] : register(t9);
+
+// Brightness of cells that were never seen, explored cells sit halfway to full brightness
+static const float FOG_UNEXPLORED_BRIGHTNESS = 0.1f;
+
+// Shader model 5 only indexes resource arrays with literals. The index is the same for the whole draw, and
+// gradients come from outside the switch, so it costs a branch. Missing textures read 0 like an unbound one.
+float4 SampleMaterial(uint packed, float2 uv, float2 dx, float2 dy)
+{
+    float3 coords = float3(uv, packed & 0xFFFF);
+    switch (packed >> 16)
+    {
+    case 0: return textureArrays[0].SampleGrad(samp, coords, dx, dy);
+    case 1: return textureArrays[1].SampleGrad(samp, coords, dx, dy);
+    case 2: return textureArrays[2].SampleGrad(samp, coords, dx, dy);
+    case 3: return textureArrays[3].SampleGrad(samp, coords, dx, dy);
+    case 4: return textureArrays[4].SampleGrad(samp, coords, dx, dy);
+    case 5: return textureArrays[5].SampleGrad(samp, coords, dx, dy);
+    case 6: return textureArrays[6].SampleGrad(samp, coords, dx, dy);
+    case 7: return textureArrays[7].SampleGrad(samp, coords, dx, dy);
+    default: return 0.0f;
+    }
+}
+
+// Diffuse and Blinn-Phong highlights of the lights in the pixel's cluster, each fading out at its radius
+float3 ShadePointLights(VSOutput input, float3 albedo, float specular, float roughness)
+{
+    uint2 tile = min(uint2(input.pos.xy * tilesPerPixel), uint2(tilesX - 1, tilesY - 1));
+    uint slice = uint(clamp(floor(log(input.viewDepth) * sliceScale + sliceBias), 0.0f, slices - 1.0f));
+    uint2 cluster = lightClusters[(slice * tilesY + tile.y) * tilesX + tile.x];
+
+    float3 n = normalize(input.normal);
+    float3 toEye = normalize(cameraPos - input.worldPos);
+    float shininess = exp2(10.0f * (1.0f - roughness) + 1.0f);
+    float3 result = 0.0f;
+    for (uint i = 0; i < cluster.y; i++)
+    {
+        PointLight light = lights[lightIndices[cluster.x + i]];
+        float3 toLight = light.position - input.worldPos;
+        float distanceSq = dot(toLight, toLight);
+        float falloff = saturate(1.0f - distanceSq / (light.radius * light.radius));
+        float3 l = toLight * rsqrt(max(distanceSq, 1e-6f));
+        float3 h = normalize(l + toEye);
+        float3 radiance = light.color * (light.intensity * falloff * falloff);
+        result += radiance * (albedo * saturate(dot(n, l)) + specular * pow(saturate(dot(n, h)), shininess));
+    }
+    return result;
+}
 
 float4 PSMain(VSOutput input) : SV_Target
 {
-    float4 texColor = tex.Sample(samp, input.uv);
+    uint4 material = materials[materialIndex];
+    float2 dx = ddx(input.uv);
+    float2 dy = ddy(input.uv);
+    float4 texColor = SampleMaterial(material.x, input.uv, dx, dy);
+    if (lightsEnabled > 0.0f)
+    {
+        float specular = SampleMaterial(material.y, input.uv, dx, dy).r;
+        float roughness = SampleMaterial(material.w, input.uv, dx, dy).r;
+        texColor.rgb += ShadePointLights(input, texColor.rgb, specular, roughness);
+    }
+    if (fogEnabled > 0.0f)
+    {
+        float fog = fogTex.Sample(fogSamp, (input.worldPos.xz - fogOrigin) * fogInverseSize).r;
+        texColor.rgb *= lerp(FOG_UNEXPLORED_BRIGHTNESS, 1.0f, fog);
+    }
     float4 outlineColor = float4(1.0, 1.0, 1.0, 1.0);
     return lerp(texColor, outlineColor, isSelected);
 }
\ No newline at end of file
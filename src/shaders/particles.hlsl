@@ -0,0 +1,42 @@
+cbuffer ParticleFrameCB : register(b0)
+{
+    float4x4 viewProjection;
+    float3 cameraRight;
+    float3 cameraUp;
+};
+
+// One particle per instance, see Fx::ParticleInstance
+struct VSInput
+{
+    float3 center : POSITION;
+    float size : PSIZE;
+    float4 color : COLOR;
+    uint corner : SV_VertexID;
+};
+
+struct VSOutput
+{
+    float4 pos : SV_POSITION;
+    float2 uv : TEXCOORD0;
+    float4 color : COLOR;
+};
+
+VSOutput VSMain(VSInput input)
+{
+    // Triangle strip over the corners (-1, -1), (1, -1), (-1, 1), (1, 1)
+    float2 corner = float2(input.corner & 1, input.corner >> 1) * 2.0f - 1.0f;
+    float3 world = input.center + (cameraRight * corner.x + cameraUp * corner.y) * (input.size * 0.5f);
+
+    VSOutput o;
+    o.pos = mul(float4(world, 1.0f), viewProjection);
+    o.uv = corner;
+    o.color = input.color;
+    return o;
+}
+
+// Soft round puff, fading out towards the edge of the quad
+float4 PSMain(VSOutput input) : SV_Target
+{
+    float falloff = saturate(1.0f - dot(input.uv, input.uv));
+    return float4(input.color.rgb, input.color.a * falloff * falloff);
+}
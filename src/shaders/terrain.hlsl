@@ -0,0 +1,91 @@
+cbuffer TerrainFrameCB : register(b0)
+{
+    float4x4 viewProjection;
+    float3 eyePos;
+    float gridQuads;
+    float2 mapOrigin;
+    float2 mapToUV;
+    float2 texelSize;
+    float sampleSpacing;
+};
+
+// Same fog as model.hlsl
+cbuffer FogCB : register(b1)
+{
+    float2 fogOrigin;
+    float2 fogInverseSize;
+    float fogEnabled;
+};
+
+cbuffer TerrainChunkCB : register(b2)
+{
+    float2 chunkOrigin;
+    float chunkSize;
+    float morphStart;
+    float morphEnd;
+};
+
+struct VSInput
+{
+    float3 pos : POSITION;
+    float3 norm : NORMAL;
+    float2 uv : TEXCOORD;
+};
+
+struct VSOutput
+{
+    float4 pos : SV_POSITION;
+    float3 worldPos : TEXCOORD0;
+    float3 normal : NORMAL;
+};
+
+Texture2D<float> heightTex : register(t0);
+SamplerState heightSamp : register(s2);
+Texture2D fogTex : register(t4);
+SamplerState fogSamp : register(s1);
+
+static const float FOG_UNEXPLORED_BRIGHTNESS = 0.1f;
+static const float3 SUN_DIRECTION = float3(0.4f, 0.8f, 0.3f);
+static const float3 GRASS_COLOR = float3(0.32f, 0.45f, 0.2f);
+static const float3 ROCK_COLOR = float3(0.45f, 0.42f, 0.38f);
+
+// Sample centres sit half a texel in, the clamp sampler holds the border past the map edge
+float SampleHeight(float2 worldXZ)
+{
+    return heightTex.SampleLevel(heightSamp, (worldXZ - mapOrigin) * mapToUV + texelSize * 0.5f, 0);
+}
+
+VSOutput VSMain(VSInput input)
+{
+    float2 grid = input.pos.xz;
+    float2 worldXZ = chunkOrigin + grid * chunkSize;
+    float distance = length(eyePos - float3(worldXZ.x, SampleHeight(worldXZ), worldXZ.y));
+
+    // Odd vertices slide onto their even neighbours until the grid matches the next LOD, see MorphGridPosition
+    float morph = saturate((distance - morphStart) / max(morphEnd - morphStart, 1e-5f));
+    grid -= frac(grid * gridQuads * 0.5f) * 2.0f / gridQuads * morph;
+    worldXZ = chunkOrigin + grid * chunkSize;
+
+    float height = SampleHeight(worldXZ);
+    float slopeX = SampleHeight(worldXZ + float2(sampleSpacing, 0)) - SampleHeight(worldXZ - float2(sampleSpacing, 0));
+    float slopeZ = SampleHeight(worldXZ + float2(0, sampleSpacing)) - SampleHeight(worldXZ - float2(0, sampleSpacing));
+
+    VSOutput o;
+    o.worldPos = float3(worldXZ.x, height, worldXZ.y);
+    o.pos = mul(float4(o.worldPos, 1.0f), viewProjection);
+    o.normal = normalize(float3(-slopeX, 2.0f * sampleSpacing, -slopeZ));
+    return o;
+}
+
+float4 PSMain(VSOutput input) : SV_Target
+{
+    float3 normal = normalize(input.normal);
+    float3 color = lerp(ROCK_COLOR, GRASS_COLOR, smoothstep(0.7f, 0.9f, normal.y));
+    color *= 0.3f + 0.7f * saturate(dot(normal, normalize(SUN_DIRECTION)));
+    if (fogEnabled > 0.0f)
+    {
+        float fog = fogTex.Sample(fogSamp, (input.worldPos.xz - fogOrigin) * fogInverseSize).r;
+        color *= lerp(FOG_UNEXPLORED_BRIGHTNESS, 1.0f, fog);
+    }
+    return float4(color, 1.0f);
+}
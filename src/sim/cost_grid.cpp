@@ -0,0 +1,87 @@
+#include "cost_grid.h"
+
+#include <cmath>
+#include <fstream>
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint8_t COST_SWAMP = 3;
+} // namespace
+
+/* Implementation of public functions */
+
+CostGrid::CostGrid(uint32_t width, uint32_t height, float cellSize, DirectX::XMFLOAT2 origin)
+	: _width{width}, _height{height}, _cellSize{cellSize}, _origin{origin}, _costs(size_t{width} * height, COST_DEFAULT)
+{
+}
+
+void CostGrid::SetCost(Cell cell, uint8_t cost)
+{
+	if (IsInside(cell)) {
+		_costs[cell.z * _width + cell.x] = cost;
+		_version++;
+	}
+}
+
+void CostGrid::Fill(const CellRect &rect, uint8_t cost)
+{
+	const uint32_t maxX = std::min(rect.maxX, _width);
+	const uint32_t maxZ = std::min(rect.maxZ, _height);
+	for (uint32_t z = rect.minZ; z < maxZ; z++) {
+		for (uint32_t x = rect.minX; x < maxX; x++) {
+			_costs[z * _width + x] = cost;
+		}
+	}
+	_version++;
+}
+
+std::optional<Cell> CostGrid::WorldToCell(DirectX::XMFLOAT2 position) const
+{
+	const float x = std::floor((position.x - _origin.x) / _cellSize);
+	const float z = std::floor((position.y - _origin.y) / _cellSize);
+	if (x < 0.0f || z < 0.0f || x >= _width || z >= _height) {
+		return {};
+	}
+	return Cell{static_cast<uint32_t>(x), static_cast<uint32_t>(z)};
+}
+
+DirectX::XMFLOAT2 CostGrid::CellToWorld(Cell cell) const
+{
+	return {_origin.x + (cell.x + 0.5f) * _cellSize, _origin.y + (cell.z + 0.5f) * _cellSize};
+}
+
+std::optional<CostGrid> TGW::Sim::LoadMovingAiMap(const std::filesystem::path &path)
+{
+	std::ifstream file{path};
+	std::string key;
+	uint32_t width = 0, height = 0;
+	while (file >> key && key != "map") {
+		if (key == "width") {
+			file >> width;
+		} else if (key == "height") {
+			file >> height;
+		} else {
+			file >> key;
+		}
+	}
+	if (!file || width == 0 || height == 0) {
+		return {};
+	}
+
+	CostGrid grid{width, height};
+	std::string row;
+	for (uint32_t z = 0; z < height; z++) {
+		if (!(file >> row) || row.size() < width) {
+			return {};
+		}
+		for (uint32_t x = 0; x < width; x++) {
+			const char c = row[x];
+			const uint8_t cost = c == '.' || c == 'G' ? COST_DEFAULT : c == 'S' ? COST_SWAMP : COST_BLOCKED;
+			if (cost != COST_DEFAULT) {
+				grid.SetCost({x, z}, cost);
+			}
+		}
+	}
+	return grid;
+}
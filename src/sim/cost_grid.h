@@ -0,0 +1,93 @@
+#pragma once
+
+#include "common.h"
+
+namespace TGW::Sim {
+
+// Cells at this cost cannot be entered, everything else is the relative price of walking through a cell
+constexpr uint8_t COST_BLOCKED = 255;
+constexpr uint8_t COST_DEFAULT = 1;
+
+// Steps to the 8 neighbours, counter clockwise from +X. Costs are scaled so octile distances stay integers and
+// entering a cell multiplies them by its cost.
+constexpr uint32_t GRID_DIRECTION_COUNT = 8;
+constexpr int32_t GRID_STEP_X[GRID_DIRECTION_COUNT] = {1, 1, 0, -1, -1, -1, 0, 1};
+constexpr int32_t GRID_STEP_Z[GRID_DIRECTION_COUNT] = {0, 1, 1, 1, 0, -1, -1, -1};
+constexpr uint32_t STRAIGHT_STEP_COST = 10;
+constexpr uint32_t DIAGONAL_STEP_COST = 14;
+
+struct Cell {
+	uint32_t x = 0;
+	uint32_t z = 0;
+
+	bool operator==(const Cell &) const = default;
+};
+
+// Half open on both axes
+struct CellRect {
+	uint32_t minX = 0;
+	uint32_t minZ = 0;
+	uint32_t maxX = 0;
+	uint32_t maxZ = 0;
+
+	inline bool Contains(Cell cell) const { return cell.x >= minX && cell.x < maxX && cell.z >= minZ && cell.z < maxZ; }
+	inline bool Intersects(const CellRect &other) const
+	{
+		return minX < other.maxX && other.minX < maxX && minZ < other.maxZ && other.minZ < maxZ;
+	}
+};
+
+// Movement cost per cell over the ground plane. Cell (0, 0) starts at origin and x, z grow along world X and Z,
+// the same ground coordinates the camera pans over.
+class CostGrid {
+  public:
+	CostGrid() = default;
+	CostGrid(uint32_t width, uint32_t height, float cellSize = 1.0f, DirectX::XMFLOAT2 origin = {});
+
+	inline uint32_t GetWidth() const { return _width; }
+	inline uint32_t GetHeight() const { return _height; }
+	inline float GetCellSize() const { return _cellSize; }
+	inline DirectX::XMFLOAT2 GetOrigin() const { return _origin; }
+	inline const uint8_t *GetCosts() const { return _costs.data(); }
+	// Bumped by every change, anything derived from the costs compares it to know when to rebuild
+	inline uint64_t GetVersion() const { return _version; }
+
+	inline bool IsInside(Cell cell) const { return cell.x < _width && cell.z < _height; }
+	inline uint8_t GetCost(Cell cell) const { return _costs[cell.z * _width + cell.x]; }
+	inline bool IsPassable(Cell cell) const { return IsInside(cell) && GetCost(cell) != COST_BLOCKED; }
+	void SetCost(Cell cell, uint8_t cost);
+
+	// Diagonal steps may not cut the corner of a blocked cell
+	inline bool CanStep(Cell from, uint32_t direction) const
+	{
+		const int32_t dx = GRID_STEP_X[direction], dz = GRID_STEP_Z[direction];
+		if (!IsPassable({from.x + dx, from.z + dz})) {
+			return false;
+		}
+		return dx == 0 || dz == 0 || (IsPassable({from.x + dx, from.z}) && IsPassable({from.x, from.z + dz}));
+	}
+	// Price of stepping into cell along direction
+	inline uint32_t GetStepCost(Cell cell, uint32_t direction) const
+	{
+		return (direction % 2 ? DIAGONAL_STEP_COST : STRAIGHT_STEP_COST) * GetCost(cell);
+	}
+	// Clamped to the grid
+	void Fill(const CellRect &rect, uint8_t cost);
+
+	std::optional<Cell> WorldToCell(DirectX::XMFLOAT2 position) const;
+	DirectX::XMFLOAT2 CellToWorld(Cell cell) const;
+
+  private:
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	float _cellSize = 1.0f;
+	DirectX::XMFLOAT2 _origin{};
+	uint64_t _version = 0;
+	std::vector<uint8_t> _costs;
+};
+
+// Reads the text maps of the Moving AI pathfinding benchmarks ("type octile", height, width, map).
+// '.', 'G' and 'S' are walkable, 'S' (swamp) at a higher cost, everything else blocks.
+std::optional<CostGrid> LoadMovingAiMap(const std::filesystem::path &path);
+
+} // namespace TGW::Sim
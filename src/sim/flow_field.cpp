@@ -0,0 +1,461 @@
+#include "flow_field.h"
+#include "unit_store.h"
+
+#include <cmath>
+#include <deque>
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t SECTOR_CELLS = FLOW_SECTOR_SIZE * FLOW_SECTOR_SIZE;
+// Dial's algorithm: the bucket ring has to be longer than the most expensive single step
+constexpr uint32_t BUCKET_COUNT = 4096;
+static_assert(BUCKET_COUNT > DIAGONAL_STEP_COST * (COST_BLOCKED - 1));
+
+constexpr float INV_SQRT2 = 0.70710678f;
+constexpr XMFLOAT2 DIRECTION_VECTORS[8] = {
+	{1.0f, 0.0f},  {INV_SQRT2, INV_SQRT2},	 {0.0f, 1.0f},	{-INV_SQRT2, INV_SQRT2},
+	{-1.0f, 0.0f}, {-INV_SQRT2, -INV_SQRT2}, {0.0f, -1.0f}, {INV_SQRT2, -INV_SQRT2},
+};
+
+enum SectorLink : uint8_t {
+	SECTOR_LINK_EAST = 1 << 0,
+	SECTOR_LINK_NORTH = 1 << 1,
+	SECTOR_LINK_WEST = 1 << 2,
+	SECTOR_LINK_SOUTH = 1 << 3,
+};
+} // namespace
+
+/* SectorGraph */
+
+SectorGraph::SectorGraph(const CostGrid &grid)
+	: _sectorsX{(grid.GetWidth() + FLOW_SECTOR_SIZE - 1) / FLOW_SECTOR_SIZE},
+	  _sectorsZ{(grid.GetHeight() + FLOW_SECTOR_SIZE - 1) / FLOW_SECTOR_SIZE}, _width{grid.GetWidth()},
+	  _height{grid.GetHeight()}, _links(GetSectorCount(), 0)
+{
+	// Two sectors are linked when any pair of cells facing each other across the edge is walkable
+	for (uint32_t sz = 0; sz < _sectorsZ; sz++) {
+		for (uint32_t sx = 0; sx < _sectorsX; sx++) {
+			const uint32_t sector = sz * _sectorsX + sx;
+			const CellRect rect = GetSectorRect(sector);
+			if (rect.maxX < grid.GetWidth()) {
+				for (uint32_t z = rect.minZ; z < rect.maxZ; z++) {
+					if (grid.IsPassable({rect.maxX - 1, z}) && grid.IsPassable({rect.maxX, z})) {
+						_links[sector] |= SECTOR_LINK_EAST;
+						_links[sector + 1] |= SECTOR_LINK_WEST;
+						break;
+					}
+				}
+			}
+			if (rect.maxZ < grid.GetHeight()) {
+				for (uint32_t x = rect.minX; x < rect.maxX; x++) {
+					if (grid.IsPassable({x, rect.maxZ - 1}) && grid.IsPassable({x, rect.maxZ})) {
+						_links[sector] |= SECTOR_LINK_NORTH;
+						_links[sector + _sectorsX] |= SECTOR_LINK_SOUTH;
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+CellRect SectorGraph::GetSectorRect(uint32_t sector) const
+{
+	const uint32_t minX = sector % _sectorsX * FLOW_SECTOR_SIZE;
+	const uint32_t minZ = sector / _sectorsX * FLOW_SECTOR_SIZE;
+	return {minX, minZ, std::min(minX + FLOW_SECTOR_SIZE, _width), std::min(minZ + FLOW_SECTOR_SIZE, _height)};
+}
+
+std::vector<uint8_t> SectorGraph::FindCorridor(uint32_t goalSector, std::span<const uint32_t> startSectors) const
+{
+	// Breadth first from the goal, every sector remembers its next hop towards it
+	std::vector<uint32_t> next(GetSectorCount(), UINT32_MAX);
+	std::deque<uint32_t> open{goalSector};
+	next[goalSector] = goalSector;
+	while (!open.empty()) {
+		const uint32_t sector = open.front();
+		open.pop_front();
+		const uint32_t neighbours[4] = {sector + 1, sector + _sectorsX, sector - 1, sector - _sectorsX};
+		for (uint32_t link = 0; link < 4; link++) {
+			if ((_links[sector] & (1 << link)) && next[neighbours[link]] == UINT32_MAX) {
+				next[neighbours[link]] = sector;
+				open.push_back(neighbours[link]);
+			}
+		}
+	}
+
+	std::vector<uint8_t> route(GetSectorCount(), 0);
+	route[goalSector] = 1;
+	for (uint32_t sector : startSectors) {
+		if (next[sector] == UINT32_MAX) {
+			continue;
+		}
+		// Stops at the goal or where an earlier route already leads on
+		while (!route[sector]) {
+			route[sector] = 1;
+			sector = next[sector];
+		}
+	}
+
+	std::vector<uint8_t> corridor(GetSectorCount(), 0);
+	for (uint32_t sector = 0; sector < GetSectorCount(); sector++) {
+		if (!route[sector]) {
+			continue;
+		}
+		const int32_t sx = sector % _sectorsX, sz = sector / _sectorsX;
+		for (int32_t z = std::max(sz - 1, 0); z <= std::min<int32_t>(sz + 1, _sectorsZ - 1); z++) {
+			for (int32_t x = std::max(sx - 1, 0); x <= std::min<int32_t>(sx + 1, _sectorsX - 1); x++) {
+				corridor[z * _sectorsX + x] = 1;
+			}
+		}
+	}
+	return corridor;
+}
+
+/* FlowField */
+
+bool FlowField::Build(
+	const CostGrid &grid, const SectorGraph &sectors, Cell goal, std::span<const Cell> starts, JobSystem &jobs)
+{
+	std::vector<uint32_t> startSectors;
+	startSectors.reserve(starts.size());
+	for (Cell start : starts) {
+		if (grid.IsPassable(start)) {
+			startSectors.push_back(sectors.GetSector(start));
+		}
+	}
+	if (!starts.empty() && startSectors.empty()) {
+		// Nobody can move, the goal alone is still a valid field
+		startSectors.push_back(sectors.GetSector(goal));
+	}
+	return BuildSectors(grid, sectors, goal, std::move(startSectors), starts, jobs);
+}
+
+bool FlowField::Extend(
+	const CostGrid &grid, const SectorGraph &sectors, const FlowField &previous, std::span<const Cell> starts,
+	JobSystem &jobs)
+{
+	std::vector<uint32_t> startSectors = previous._startSectors;
+	for (Cell start : starts) {
+		if (grid.IsPassable(start)) {
+			startSectors.push_back(sectors.GetSector(start));
+		}
+	}
+	return BuildSectors(grid, sectors, previous._goal, std::move(startSectors), starts, jobs);
+}
+
+bool FlowField::Covers(Cell cell) const { return GetStorageIndex(cell) != UINT32_MAX; }
+
+bool FlowField::CoversSectorsIn(const CellRect &rect) const
+{
+	if (!_grid || rect.minX >= rect.maxX || rect.minZ >= rect.maxZ) {
+		return false;
+	}
+	const uint32_t maxX = std::min(rect.maxX, _grid->GetWidth()) - 1;
+	const uint32_t maxZ = std::min(rect.maxZ, _grid->GetHeight()) - 1;
+	for (uint32_t sz = rect.minZ / FLOW_SECTOR_SIZE; sz <= maxZ / FLOW_SECTOR_SIZE; sz++) {
+		for (uint32_t sx = rect.minX / FLOW_SECTOR_SIZE; sx <= maxX / FLOW_SECTOR_SIZE; sx++) {
+			if (_sectorSlots[sz * _sectorsX + sx] != UINT32_MAX) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+uint32_t FlowField::GetIntegration(Cell cell) const
+{
+	const uint32_t index = GetStorageIndex(cell);
+	return index == UINT32_MAX ? FLOW_UNREACHABLE : _integration[index];
+}
+
+FlowDirection FlowField::GetDirection(Cell cell) const
+{
+	const uint32_t index = GetStorageIndex(cell);
+	return index == UINT32_MAX ? FLOW_DIRECTION_NONE : _directions[index];
+}
+
+std::optional<XMFLOAT2> FlowField::Sample(XMFLOAT2 position) const
+{
+	if (!_grid) {
+		return {};
+	}
+	const std::optional<Cell> cell = _grid->WorldToCell(position);
+	if (!cell || !Covers(*cell)) {
+		return {};
+	}
+	if (*cell == _goal) {
+		return XMFLOAT2{0.0f, 0.0f};
+	}
+
+	// Bilinear over the four cell centres around the position, skipping cells without a direction
+	const XMFLOAT2 origin = _grid->GetOrigin();
+	const float u = (position.x - origin.x) / _grid->GetCellSize() - 0.5f;
+	const float v = (position.y - origin.y) / _grid->GetCellSize() - 0.5f;
+	const float x0 = std::floor(u), z0 = std::floor(v);
+	const float fx = u - x0, fz = v - z0;
+
+	XMVECTOR sum = XMVectorZero();
+	for (uint32_t corner = 0; corner < 4; corner++) {
+		const int32_t x = static_cast<int32_t>(x0) + (corner & 1);
+		const int32_t z = static_cast<int32_t>(z0) + (corner >> 1);
+		if (x < 0 || z < 0) {
+			continue;
+		}
+		const FlowDirection direction = GetDirection({static_cast<uint32_t>(x), static_cast<uint32_t>(z)});
+		if (direction == FLOW_DIRECTION_NONE) {
+			continue;
+		}
+		const float weight = ((corner & 1) ? fx : 1.0f - fx) * ((corner >> 1) ? fz : 1.0f - fz);
+		sum = XMVectorMultiplyAdd(XMLoadFloat2(&DIRECTION_VECTORS[direction]), XMVectorReplicate(weight), sum);
+	}
+
+	// Opposing neighbours can cancel out, the cell itself knows where to go
+	if (XMVectorGetX(XMVector2LengthSq(sum)) < 1e-6f) {
+		const FlowDirection direction = GetDirection(*cell);
+		if (direction == FLOW_DIRECTION_NONE) {
+			return {};
+		}
+		return DIRECTION_VECTORS[direction];
+	}
+
+	XMFLOAT2 out;
+	XMStoreFloat2(&out, XMVector2Normalize(sum));
+	return out;
+}
+
+bool FlowField::BuildSectors(
+	const CostGrid &grid, const SectorGraph &sectors, Cell goal, std::vector<uint32_t> startSectors,
+	std::span<const Cell> starts, JobSystem &jobs)
+{
+	if (!grid.IsPassable(goal)) {
+		return false;
+	}
+	_grid = &grid;
+	_goal = goal;
+	_sectorsX = sectors.GetSectorsX();
+
+	std::sort(startSectors.begin(), startSectors.end());
+	startSectors.erase(std::unique(startSectors.begin(), startSectors.end()), startSectors.end());
+	_startSectors = std::move(startSectors);
+
+	const std::vector<uint8_t> everything(sectors.GetSectorCount(), 1);
+	if (_startSectors.empty()) {
+		Allocate(everything);
+		Integrate();
+	} else {
+		Allocate(sectors.FindCorridor(sectors.GetSector(goal), _startSectors));
+		Integrate();
+
+		// Walls inside a sector can make the corridor a dead end, fall back to searching everywhere
+		const bool blocked = std::any_of(starts.begin(), starts.end(), [&](Cell start) {
+			return grid.IsPassable(start) && GetIntegration(start) == FLOW_UNREACHABLE;
+		});
+		if (blocked && _coveredCount < sectors.GetSectorCount()) {
+			Allocate(everything);
+			Integrate();
+		}
+	}
+
+	// Every sector only reads integration values, so they can all go at once
+	jobs.ParallelFor(_coveredCount, 4, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t slot = begin; slot < end; slot++) {
+			BuildDirections(slot);
+		}
+	});
+	return true;
+}
+
+/* Implementation of private functions */
+
+void FlowField::Allocate(const std::vector<uint8_t> &covered)
+{
+	_sectorSlots.assign(covered.size(), UINT32_MAX);
+	_slotSectors.clear();
+	for (uint32_t sector = 0; sector < covered.size(); sector++) {
+		if (covered[sector]) {
+			_sectorSlots[sector] = static_cast<uint32_t>(_slotSectors.size());
+			_slotSectors.push_back(sector);
+		}
+	}
+	_coveredCount = static_cast<uint32_t>(_slotSectors.size());
+	_integration.assign(size_t{_coveredCount} * SECTOR_CELLS, FLOW_UNREACHABLE);
+	_directions.assign(size_t{_coveredCount} * SECTOR_CELLS, FLOW_DIRECTION_NONE);
+}
+
+uint32_t FlowField::GetStorageIndex(Cell cell) const
+{
+	if (!_grid || !_grid->IsInside(cell)) {
+		return UINT32_MAX;
+	}
+	const uint32_t slot = _sectorSlots[cell.z / FLOW_SECTOR_SIZE * _sectorsX + cell.x / FLOW_SECTOR_SIZE];
+	if (slot == UINT32_MAX) {
+		return UINT32_MAX;
+	}
+	return slot * SECTOR_CELLS + cell.z % FLOW_SECTOR_SIZE * FLOW_SECTOR_SIZE + cell.x % FLOW_SECTOR_SIZE;
+}
+
+// Dijkstra from the goal over the covered sectors. Step costs are small integers, so a ring of buckets replaces
+// the heap and every push and pop is constant time.
+void FlowField::Integrate()
+{
+	thread_local std::vector<std::vector<Cell>> buckets(BUCKET_COUNT);
+	const CostGrid &grid = *_grid;
+
+	_integration[GetStorageIndex(_goal)] = 0;
+	buckets[0].push_back(_goal);
+	size_t pending = 1;
+	for (uint32_t distance = 0; pending > 0; distance++) {
+		std::vector<Cell> &bucket = buckets[distance % BUCKET_COUNT];
+		while (!bucket.empty()) {
+			const Cell cell = bucket.back();
+			bucket.pop_back();
+			pending--;
+			if (_integration[GetStorageIndex(cell)] != distance) {
+				continue; // reached more cheaply since it was queued
+			}
+
+			for (uint32_t direction = 0; direction < GRID_DIRECTION_COUNT; direction++) {
+				if (!grid.CanStep(cell, direction)) {
+					continue;
+				}
+				const Cell neighbour{cell.x + GRID_STEP_X[direction], cell.z + GRID_STEP_Z[direction]};
+				const uint32_t index = GetStorageIndex(neighbour);
+				if (index == UINT32_MAX) {
+					continue;
+				}
+				const uint32_t step = grid.GetStepCost(neighbour, direction);
+				if (distance + step < _integration[index]) {
+					_integration[index] = distance + step;
+					buckets[(distance + step) % BUCKET_COUNT].push_back(neighbour);
+					pending++;
+				}
+			}
+		}
+	}
+}
+
+void FlowField::BuildDirections(uint32_t slot)
+{
+	const CostGrid &grid = *_grid;
+	const uint32_t sector = _slotSectors[slot];
+	const uint32_t minX = sector % _sectorsX * FLOW_SECTOR_SIZE;
+	const uint32_t minZ = sector / _sectorsX * FLOW_SECTOR_SIZE;
+	const uint32_t maxX = std::min(minX + FLOW_SECTOR_SIZE, grid.GetWidth());
+	const uint32_t maxZ = std::min(minZ + FLOW_SECTOR_SIZE, grid.GetHeight());
+
+	for (uint32_t z = minZ; z < maxZ; z++) {
+		for (uint32_t x = minX; x < maxX; x++) {
+			const Cell cell{x, z};
+			const uint32_t index = GetStorageIndex(cell);
+			uint32_t best = _integration[index];
+			if (best == FLOW_UNREACHABLE || cell == _goal) {
+				continue;
+			}
+
+			FlowDirection bestDirection = FLOW_DIRECTION_NONE;
+			for (uint32_t direction = 0; direction < GRID_DIRECTION_COUNT; direction++) {
+				if (!grid.CanStep(cell, direction)) {
+					continue;
+				}
+				const uint32_t integration = GetIntegration({x + GRID_STEP_X[direction], z + GRID_STEP_Z[direction]});
+				if (integration < best) {
+					best = integration;
+					bestDirection = static_cast<FlowDirection>(direction);
+				}
+			}
+			_directions[index] = bestDirection;
+		}
+	}
+}
+
+/* FlowFieldCache */
+
+std::shared_ptr<const FlowField> FlowFieldCache::Get(Cell goal, std::span<const Cell> starts, JobSystem &jobs)
+{
+	if (!_grid.IsPassable(goal)) {
+		return nullptr;
+	}
+	if (!_sectors || _sectorsVersion != _grid.GetVersion()) {
+		_sectors.emplace(_grid);
+		_sectorsVersion = _grid.GetVersion();
+	}
+
+	const uint32_t goalIndex = goal.z * _grid.GetWidth() + goal.x;
+	std::shared_ptr<const FlowField> previous;
+	if (auto found = _byGoal.find(goalIndex); found != _byGoal.end()) {
+		previous = found->second->field;
+		const bool covered = std::all_of(starts.begin(), starts.end(), [&](Cell start) {
+			return !_grid.IsPassable(start) || previous->Covers(start);
+		});
+		if (covered) {
+			_hits++;
+			_entries.splice(_entries.begin(), _entries, found->second);
+			return previous;
+		}
+		_entries.erase(found->second);
+		_byGoal.erase(found);
+	}
+
+	_misses++;
+	auto field = std::make_shared<FlowField>();
+	const bool built = previous ? field->Extend(_grid, *_sectors, *previous, starts, jobs)
+								: field->Build(_grid, *_sectors, goal, starts, jobs);
+	if (!built) {
+		return nullptr;
+	}
+
+	_entries.push_front({goalIndex, field});
+	_byGoal[goalIndex] = _entries.begin();
+	while (_entries.size() > _capacity) {
+		_byGoal.erase(_entries.back().goalIndex);
+		_entries.pop_back();
+	}
+	return field;
+}
+
+void FlowFieldCache::Invalidate(const CellRect &rect)
+{
+	for (auto entry = _entries.begin(); entry != _entries.end();) {
+		if (entry->field->CoversSectorsIn(rect)) {
+			_byGoal.erase(entry->goalIndex);
+			entry = _entries.erase(entry);
+		} else {
+			++entry;
+		}
+	}
+}
+
+void FlowFieldCache::Clear()
+{
+	_entries.clear();
+	_byGoal.clear();
+}
+
+/* Steering */
+
+void TGW::Sim::SteerAlongField(UnitStore &units, std::span<const UnitId> ids, const FlowField &field, const CostGrid &grid)
+{
+	const XMFLOAT2 goal = grid.CellToWorld(field.GetGoal());
+	// Far enough ahead that arrival braking does not kick in on the way
+	const float lookAhead = 2.0f * std::max(units.GetSteering().arrivalRadius, grid.GetCellSize());
+	const std::span<const float> positionsX = units.GetPositionsX();
+	const std::span<const float> positionsZ = units.GetPositionsZ();
+
+	for (UnitId id : ids) {
+		const std::optional<uint32_t> i = units.GetDenseIndex(id);
+		if (!i) {
+			continue;
+		}
+		const XMFLOAT2 position{positionsX[*i], positionsZ[*i]};
+		const std::optional<XMFLOAT2> direction = field.Sample(position);
+		if (!direction || (direction->x == 0.0f && direction->y == 0.0f)) {
+			units.SetMoveTarget(id, goal);
+		} else {
+			units.SetMoveTarget(
+				id, {position.x + direction->x * lookAhead, position.y + direction->y * lookAhead});
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "cost_grid.h"
+#include "core/job_system.h"
+
+#include <list>
+#include <span>
+
+namespace TGW::Sim {
+
+class UnitStore;
+struct UnitId;
+
+// Fields are computed in square sectors of this many cells, only the sectors a move order crosses
+constexpr uint32_t FLOW_SECTOR_SIZE = 32;
+constexpr uint32_t FLOW_UNREACHABLE = UINT32_MAX;
+
+// Directions point at one of the 8 neighbours, counter clockwise from +X
+enum FlowDirection : uint8_t {
+	FLOW_DIRECTION_EAST,
+	FLOW_DIRECTION_NORTH_EAST,
+	FLOW_DIRECTION_NORTH,
+	FLOW_DIRECTION_NORTH_WEST,
+	FLOW_DIRECTION_WEST,
+	FLOW_DIRECTION_SOUTH_WEST,
+	FLOW_DIRECTION_SOUTH,
+	FLOW_DIRECTION_SOUTH_EAST,
+	FLOW_DIRECTION_NONE, // the goal, or no way out
+};
+
+// Which sectors are connected through their shared edge. Coarse, a sector whose inside is split by walls still
+// counts as one, the cell level search catches those cases.
+class SectorGraph {
+  public:
+	explicit SectorGraph(const CostGrid &grid);
+
+	inline uint32_t GetSectorsX() const { return _sectorsX; }
+	inline uint32_t GetSectorsZ() const { return _sectorsZ; }
+	inline uint32_t GetSectorCount() const { return _sectorsX * _sectorsZ; }
+	inline uint32_t GetSector(Cell cell) const { return cell.z / FLOW_SECTOR_SIZE * _sectorsX + cell.x / FLOW_SECTOR_SIZE; }
+	CellRect GetSectorRect(uint32_t sector) const;
+
+	// Marks the sectors on the fewest hop routes from each start sector to the goal sector, and a ring of
+	// neighbours around them so units pushed off the route still find the field
+	std::vector<uint8_t> FindCorridor(uint32_t goalSector, std::span<const uint32_t> startSectors) const;
+
+  private:
+	uint32_t _sectorsX = 0;
+	uint32_t _sectorsZ = 0;
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	// Bit 0 east, bit 1 north (+Z), bit 2 west, bit 3 south
+	std::vector<uint8_t> _links;
+};
+
+// Integration and direction fields towards one goal cell. Storage is per covered sector, so a field for a short
+// order across a huge map stays small.
+class FlowField {
+  public:
+	// Cells that are blocked or outside the grid are ignored as starts. Without starts every sector is covered.
+	// Fails when the goal cannot be entered.
+	bool Build(
+		const CostGrid &grid, const SectorGraph &sectors, Cell goal, std::span<const Cell> starts,
+		JobSystem &jobs = JobSystem::Get());
+	// Rebuilds previous so it also covers routes from the new starts
+	bool Extend(
+		const CostGrid &grid, const SectorGraph &sectors, const FlowField &previous, std::span<const Cell> starts,
+		JobSystem &jobs = JobSystem::Get());
+
+	inline Cell GetGoal() const { return _goal; }
+	inline uint32_t GetCoveredSectorCount() const { return _coveredCount; }
+	inline const std::vector<uint32_t> &GetStartSectors() const { return _startSectors; }
+	bool Covers(Cell cell) const;
+	bool CoversSectorsIn(const CellRect &rect) const;
+
+	// Cost to the goal, FLOW_UNREACHABLE for cells outside the covered sectors or cut off from the goal
+	uint32_t GetIntegration(Cell cell) const;
+	FlowDirection GetDirection(Cell cell) const;
+
+	// Blends the directions around a world position into a unit vector on the ground plane. Zero at the goal,
+	// nothing where the field has no data, callers then head straight for the goal.
+	std::optional<DirectX::XMFLOAT2> Sample(DirectX::XMFLOAT2 position) const;
+
+  private:
+	bool BuildSectors(
+		const CostGrid &grid, const SectorGraph &sectors, Cell goal, std::vector<uint32_t> startSectors,
+		std::span<const Cell> starts, JobSystem &jobs);
+	void Allocate(const std::vector<uint8_t> &covered);
+	uint32_t GetStorageIndex(Cell cell) const;
+	void Integrate();
+	void BuildDirections(uint32_t slot);
+
+	const CostGrid *_grid = nullptr;
+	Cell _goal;
+	uint32_t _sectorsX = 0;
+	uint32_t _coveredCount = 0;
+	std::vector<uint32_t> _startSectors;
+
+	// Per sector, index of its block in the arrays below or UINT32_MAX
+	std::vector<uint32_t> _sectorSlots;
+	std::vector<uint32_t> _slotSectors;
+	// FLOW_SECTOR_SIZE^2 entries per covered sector, row major inside the sector
+	std::vector<uint32_t> _integration;
+	std::vector<FlowDirection> _directions;
+};
+
+// Fields by goal cell, least recently used out first. A move order to a goal that already has a field reuses
+// it, extending it when the new units start in sectors it does not cover.
+class FlowFieldCache {
+  public:
+	explicit FlowFieldCache(const CostGrid &grid, uint32_t capacity = 32) : _grid{grid}, _capacity{capacity} {}
+
+	std::shared_ptr<const FlowField> Get(Cell goal, std::span<const Cell> starts, JobSystem &jobs = JobSystem::Get());
+
+	// Call after changing costs inside rect. Fields crossing it are rebuilt on their next use.
+	void Invalidate(const CellRect &rect);
+	void Clear();
+
+	inline uint32_t GetHits() const { return _hits; }
+	inline uint32_t GetMisses() const { return _misses; }
+
+  private:
+	struct Entry {
+		uint32_t goalIndex;
+		std::shared_ptr<const FlowField> field;
+	};
+
+	const CostGrid &_grid;
+	uint32_t _capacity;
+	std::optional<SectorGraph> _sectors;
+	uint64_t _sectorsVersion = 0;
+
+	std::list<Entry> _entries; // most recently used first
+	std::unordered_map<uint32_t, std::list<Entry>::iterator> _byGoal;
+	uint32_t _hits = 0;
+	uint32_t _misses = 0;
+};
+
+// Points each unit's move target a little way down the field, or at the goal once it is in the goal cell
+void SteerAlongField(UnitStore &units, std::span<const UnitId> ids, const FlowField &field, const CostGrid &grid);
+
+} // namespace TGW::Sim
@@ -0,0 +1,243 @@
+#include "fog_of_war.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t BITS_PER_WORD = 64;
+
+inline uint32_t GetWordCount(uint32_t cells) { return (cells + BITS_PER_WORD - 1) / BITS_PER_WORD; }
+} // namespace
+
+/* Implementation of public functions */
+
+FogOfWar::FogOfWar(uint32_t width, uint32_t height, float cellSize, XMFLOAT2 origin, uint32_t playerCount)
+	: _width{std::max(width, 1u)}, _height{std::max(height, 1u)}, _cellSize{cellSize}, _inverseCellSize{1.0f / cellSize},
+	  _origin{origin}, _players(std::clamp(playerCount, 1u, FOG_MAX_PLAYERS)), _discs(FOG_MAX_SIGHT_CELLS + 1)
+{
+	const uint32_t cells = _width * _height;
+	for (PlayerFog &player : _players) {
+		player.counts.assign(cells, 0);
+		player.visible.assign(GetWordCount(cells), 0);
+		player.explored.assign(GetWordCount(cells), 0);
+	}
+}
+
+void FogOfWar::SetHeights(std::vector<float> heights, float eyeHeight)
+{
+	if (heights.size() != size_t{_width} * _height) {
+		return;
+	}
+	_heights = std::move(heights);
+	_eyeHeight = eyeHeight;
+	RestampAll();
+}
+
+void FogOfWar::ClearHeights()
+{
+	_heights.clear();
+	RestampAll();
+}
+
+uint32_t FogOfWar::AddObserver(uint8_t player, XMFLOAT2 position, float sightRadius)
+{
+	uint32_t observer;
+	if (!_freeObservers.empty()) {
+		observer = _freeObservers.back();
+		_freeObservers.pop_back();
+	} else {
+		observer = static_cast<uint32_t>(_observers.size());
+		_observers.emplace_back();
+	}
+
+	const float radius = std::clamp(std::round(sightRadius * _inverseCellSize), 0.0f, static_cast<float>(FOG_MAX_SIGHT_CELLS));
+	_observers[observer] = Observer{
+	  .cell = GetClampedIndex(position),
+	  .radius = static_cast<uint32_t>(radius),
+	  .player = static_cast<uint8_t>(std::min<uint32_t>(player, GetPlayerCount() - 1)),
+	  .alive = true,
+	};
+	Stamp(_observers[observer], true);
+	return observer;
+}
+
+void FogOfWar::MoveObserver(uint32_t observer, XMFLOAT2 position)
+{
+	Observer &moved = _observers[observer];
+	const uint32_t cell = GetClampedIndex(position);
+	if (!moved.alive || cell == moved.cell) {
+		return;
+	}
+
+	Stamp(moved, false);
+	moved.cell = cell;
+	Stamp(moved, true);
+	_restamps++;
+}
+
+void FogOfWar::RemoveObserver(uint32_t observer)
+{
+	Observer &removed = _observers[observer];
+	if (!removed.alive) {
+		return;
+	}
+	Stamp(removed, false);
+	removed.alive = false;
+	_freeObservers.push_back(observer);
+}
+
+void FogOfWar::MoveObservers(
+	std::span<const uint32_t> observers, std::span<const float> positionsX, std::span<const float> positionsZ)
+{
+	const size_t count = std::min({observers.size(), positionsX.size(), positionsZ.size()});
+	for (size_t i = 0; i < count; i++) {
+		MoveObserver(observers[i], {positionsX[i], positionsZ[i]});
+	}
+}
+
+bool FogOfWar::IsVisible(uint8_t player, XMFLOAT2 position) const
+{
+	const float x = std::floor((position.x - _origin.x) * _inverseCellSize);
+	const float z = std::floor((position.y - _origin.y) * _inverseCellSize);
+	if (!(x >= 0.0f && z >= 0.0f && x < _width && z < _height)) {
+		return false;
+	}
+	return IsVisible(player, Cell{static_cast<uint32_t>(x), static_cast<uint32_t>(z)});
+}
+
+void FogOfWar::BuildTexels(uint8_t player, std::vector<uint8_t> &texels) const
+{
+	const PlayerFog &fog = _players[player];
+	const uint32_t cells = _width * _height;
+	texels.resize(cells);
+	for (uint32_t word = 0; word < fog.explored.size(); word++) {
+		const uint32_t begin = word * BITS_PER_WORD;
+		const uint32_t end = std::min(begin + BITS_PER_WORD, cells);
+		const uint64_t visible = fog.visible[word];
+		const uint64_t explored = fog.explored[word];
+		// Most of a map is either unexplored or explored and out of sight, those words fill in one go
+		if (visible == 0) {
+			if (explored == 0 || explored == UINT64_MAX) {
+				std::fill(texels.begin() + begin, texels.begin() + end, explored ? FOG_TEXEL_EXPLORED : FOG_TEXEL_UNEXPLORED);
+				continue;
+			}
+		}
+		for (uint32_t i = begin; i < end; i++) {
+			const uint32_t bit = i - begin;
+			if ((visible >> bit) & 1) {
+				texels[i] = FOG_TEXEL_VISIBLE;
+			} else {
+				texels[i] = (explored >> bit) & 1 ? FOG_TEXEL_EXPLORED : FOG_TEXEL_UNEXPLORED;
+			}
+		}
+	}
+}
+
+/* Implementation of private functions */
+
+uint32_t FogOfWar::GetClampedIndex(XMFLOAT2 position) const
+{
+	const float x = std::floor((position.x - _origin.x) * _inverseCellSize);
+	const float z = std::floor((position.y - _origin.y) * _inverseCellSize);
+	// Written so NaN ends up in cell 0
+	const uint32_t cellX = !(x >= 0.0f) ? 0 : x >= _width ? _width - 1 : static_cast<uint32_t>(x);
+	const uint32_t cellZ = !(z >= 0.0f) ? 0 : z >= _height ? _height - 1 : static_cast<uint32_t>(z);
+	return cellZ * _width + cellX;
+}
+
+const std::vector<uint32_t> &FogOfWar::GetDisc(uint32_t radius)
+{
+	std::vector<uint32_t> &disc = _discs[radius];
+	if (disc.empty()) {
+		// Cells whose centre lies within radius + 1/2 of the observer's centre, which keeps small discs round
+		const int32_t r = static_cast<int32_t>(radius);
+		for (int32_t dz = -r; dz <= r; dz++) {
+			disc.push_back(static_cast<uint32_t>(std::sqrt(static_cast<float>(r * r + r - dz * dz))));
+		}
+	}
+	return disc;
+}
+
+bool FogOfWar::HasLineOfSight(uint32_t fromX, uint32_t fromZ, uint32_t toX, uint32_t toZ) const
+{
+	const int32_t dx = static_cast<int32_t>(toX - fromX);
+	const int32_t dz = static_cast<int32_t>(toZ - fromZ);
+	const int32_t steps = std::max(std::abs(dx), std::abs(dz));
+	if (steps <= 1) {
+		return true;
+	}
+
+	// The target is seen when no cell along the way rises above the line from the eye to its ground
+	const float eye = _heights[fromZ * _width + fromX] + _eyeHeight;
+	const float target = _heights[toZ * _width + toX];
+	const float inverseSteps = 1.0f / steps;
+	for (int32_t step = 1; step < steps; step++) {
+		const float t = step * inverseSteps;
+		const uint32_t x = static_cast<uint32_t>(static_cast<int32_t>(fromX) + static_cast<int32_t>(std::lround(dx * t)));
+		const uint32_t z = static_cast<uint32_t>(static_cast<int32_t>(fromZ) + static_cast<int32_t>(std::lround(dz * t)));
+		if (_heights[z * _width + x] > eye + (target - eye) * t) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void FogOfWar::Stamp(const Observer &observer, bool add)
+{
+	PlayerFog &fog = _players[observer.player];
+	const std::vector<uint32_t> &disc = GetDisc(observer.radius);
+	const int32_t radius = static_cast<int32_t>(observer.radius);
+	const int32_t centerX = static_cast<int32_t>(observer.cell % _width);
+	const int32_t centerZ = static_cast<int32_t>(observer.cell / _width);
+	bool changed = false;
+
+	for (int32_t dz = -radius; dz <= radius; dz++) {
+		const int32_t z = centerZ + dz;
+		if (z < 0 || z >= static_cast<int32_t>(_height)) {
+			continue;
+		}
+		const int32_t halfWidth = static_cast<int32_t>(disc[dz + radius]);
+		const uint32_t minX = static_cast<uint32_t>(std::max(centerX - halfWidth, 0));
+		const uint32_t maxX = static_cast<uint32_t>(std::min(centerX + halfWidth, static_cast<int32_t>(_width) - 1));
+		const uint32_t row = static_cast<uint32_t>(z) * _width;
+
+		for (uint32_t x = minX; x <= maxX; x++) {
+			if (!_heights.empty() && !HasLineOfSight(observer.cell % _width, observer.cell / _width, x, z)) {
+				continue;
+			}
+			// Only the first observer to see a cell and the last to lose it change the bitsets
+			const uint32_t index = row + x;
+			const uint64_t bit = uint64_t{1} << (index % BITS_PER_WORD);
+			if (add) {
+				if (fog.counts[index]++ == 0) {
+					fog.visible[index / BITS_PER_WORD] |= bit;
+					fog.explored[index / BITS_PER_WORD] |= bit;
+					changed = true;
+				}
+			} else if (--fog.counts[index] == 0) {
+				fog.visible[index / BITS_PER_WORD] &= ~bit;
+				changed = true;
+			}
+		}
+	}
+
+	if (changed) {
+		fog.version++;
+	}
+}
+
+void FogOfWar::RestampAll()
+{
+	for (PlayerFog &player : _players) {
+		std::fill(player.counts.begin(), player.counts.end(), 0);
+		std::fill(player.visible.begin(), player.visible.end(), 0);
+		player.version++;
+	}
+	for (const Observer &observer : _observers) {
+		if (observer.alive) {
+			Stamp(observer, true);
+		}
+	}
+}
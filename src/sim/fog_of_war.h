@@ -0,0 +1,109 @@
+#pragma once
+
+#include "cost_grid.h"
+
+#include <span>
+
+namespace TGW::Sim {
+
+// Unit owners are 8 bit, but fog is only kept for the players that need it
+constexpr uint32_t FOG_MAX_PLAYERS = 8;
+constexpr uint32_t FOG_MAX_SIGHT_CELLS = 64;
+constexpr float FOG_DEFAULT_EYE_HEIGHT = 2.0f;
+
+// Values of the fog texture, one texel per cell
+constexpr uint8_t FOG_TEXEL_UNEXPLORED = 0;
+constexpr uint8_t FOG_TEXEL_EXPLORED = 128;
+constexpr uint8_t FOG_TEXEL_VISIBLE = 255;
+
+// Per player visibility over a grid of cells, laid out like CostGrid. Every observer stamps the disc of cells it
+// sees into a per player count, a cell is visible while its count is above zero and explored once it has been
+// visible. Counts are only touched when an observer enters another cell, so units walking inside a cell cost
+// nothing and a tick only pays for the units that crossed a border.
+//
+// Visible and explored cells are also kept as bitsets, 64 cells to a word, which is what queries and the fog
+// texture read. Up to 65535 observers of one player can see the same cell.
+class FogOfWar {
+  public:
+	FogOfWar(uint32_t width, uint32_t height, float cellSize, DirectX::XMFLOAT2 origin, uint32_t playerCount);
+
+	inline uint32_t GetWidth() const { return _width; }
+	inline uint32_t GetHeight() const { return _height; }
+	inline float GetCellSize() const { return _cellSize; }
+	inline DirectX::XMFLOAT2 GetOrigin() const { return _origin; }
+	inline uint32_t GetPlayerCount() const { return static_cast<uint32_t>(_players.size()); }
+
+	// Terrain height per cell, row major. Once set, terrain above the line from an observer's eye to a cell hides
+	// it. Every observer is stamped again, so this is meant for load time and rare terrain changes.
+	void SetHeights(std::vector<float> heights, float eyeHeight = FOG_DEFAULT_EYE_HEIGHT);
+	void ClearHeights();
+
+	// Observers outside the grid see from the closest border cell
+	uint32_t AddObserver(uint8_t player, DirectX::XMFLOAT2 position, float sightRadius);
+	void MoveObserver(uint32_t observer, DirectX::XMFLOAT2 position);
+	void RemoveObserver(uint32_t observer);
+	// Moves observers[i] to (positionsX[i], positionsZ[i]), for feeding a whole UnitStore each tick
+	void MoveObservers(
+		std::span<const uint32_t> observers, std::span<const float> positionsX, std::span<const float> positionsZ);
+
+	inline bool IsVisible(uint8_t player, Cell cell) const { return TestBit(_players[player].visible, GetIndex(cell)); }
+	inline bool IsExplored(uint8_t player, Cell cell) const { return TestBit(_players[player].explored, GetIndex(cell)); }
+	bool IsVisible(uint8_t player, DirectX::XMFLOAT2 position) const;
+	inline std::span<const uint64_t> GetVisibleBits(uint8_t player) const { return _players[player].visible; }
+	inline std::span<const uint64_t> GetExploredBits(uint8_t player) const { return _players[player].explored; }
+
+	// Bumped whenever a cell of the player changes state, the renderer compares it to skip uploads
+	inline uint64_t GetVersion(uint8_t player) const { return _players[player].version; }
+	// Observers that crossed into another cell and were stamped again, since the last reset
+	inline uint64_t GetRestampCount() const { return _restamps; }
+	inline void ResetRestampCount() { _restamps = 0; }
+
+	// One FOG_TEXEL_* per cell, row major, ready for an R8 texture
+	void BuildTexels(uint8_t player, std::vector<uint8_t> &texels) const;
+
+  private:
+	struct Observer {
+		uint32_t cell = 0;
+		uint32_t radius = 0; // in cells
+		uint8_t player = 0;
+		bool alive = false;
+	};
+
+	struct PlayerFog {
+		std::vector<uint16_t> counts;
+		std::vector<uint64_t> visible;
+		std::vector<uint64_t> explored;
+		uint64_t version = 0;
+	};
+
+	inline uint32_t GetIndex(Cell cell) const { return cell.z * _width + cell.x; }
+	static inline bool TestBit(const std::vector<uint64_t> &bits, uint32_t index)
+	{
+		return (bits[index / 64] >> (index % 64)) & 1;
+	}
+
+	uint32_t GetClampedIndex(DirectX::XMFLOAT2 position) const;
+	const std::vector<uint32_t> &GetDisc(uint32_t radius);
+	bool HasLineOfSight(uint32_t fromX, uint32_t fromZ, uint32_t toX, uint32_t toZ) const;
+	// Adds or removes what an observer sees at its current cell
+	void Stamp(const Observer &observer, bool add);
+	void RestampAll();
+
+	uint32_t _width;
+	uint32_t _height;
+	float _cellSize;
+	float _inverseCellSize;
+	DirectX::XMFLOAT2 _origin;
+
+	std::vector<PlayerFog> _players;
+	std::vector<Observer> _observers;
+	std::vector<uint32_t> _freeObservers;
+	// Half width of every row of a disc, by radius, built on first use
+	std::vector<std::vector<uint32_t>> _discs;
+
+	std::vector<float> _heights;
+	float _eyeHeight = FOG_DEFAULT_EYE_HEIGHT;
+	uint64_t _restamps = 0;
+};
+
+} // namespace TGW::Sim
@@ -0,0 +1,122 @@
+#include "grid_search.h"
+
+using namespace TGW::Sim;
+
+/* Implementation of public functions */
+
+std::optional<uint32_t> GridSearch::FindPath(Cell start, Cell goal, const CellRect &bounds, std::vector<Cell> *path)
+{
+	if (!bounds.Contains(start) || !bounds.Contains(goal) || !_grid.IsPassable(start) || !_grid.IsPassable(goal)) {
+		return {};
+	}
+
+	Begin(bounds);
+	const uint32_t startIndex = GetIndex(start);
+	GetState(startIndex).cost = 0;
+	_open.Push(startIndex, GetOctileDistance(start, goal));
+
+	while (!_open.IsEmpty()) {
+		const uint32_t index = _open.Pop();
+		const Cell cell{_bounds.minX + index % _boundsWidth, _bounds.minZ + index / _boundsWidth};
+		NodeState &state = _states[index];
+		state.closed = true;
+		_expanded++;
+
+		if (cell == goal) {
+			if (path) {
+				// Walk back along the parents, then put that stretch in order
+				const size_t first = path->size();
+				for (Cell at = goal; !(at == start);) {
+					path->push_back(at);
+					const uint8_t parent = _states[GetIndex(at)].parent;
+					at = {at.x - GRID_STEP_X[parent], at.z - GRID_STEP_Z[parent]};
+				}
+				std::reverse(path->begin() + first, path->end());
+			}
+			return state.cost;
+		}
+
+		for (uint32_t direction = 0; direction < GRID_DIRECTION_COUNT; direction++) {
+			const Cell neighbour{cell.x + GRID_STEP_X[direction], cell.z + GRID_STEP_Z[direction]};
+			if (!bounds.Contains(neighbour) || !_grid.CanStep(cell, direction)) {
+				continue;
+			}
+			const uint32_t neighbourIndex = GetIndex(neighbour);
+			NodeState &next = GetState(neighbourIndex);
+			const uint32_t cost = state.cost + _grid.GetStepCost(neighbour, direction);
+			if (!next.closed && cost < next.cost) {
+				next.cost = cost;
+				next.parent = static_cast<uint8_t>(direction);
+				_open.Push(neighbourIndex, cost + GetOctileDistance(neighbour, goal));
+			}
+		}
+	}
+	return {};
+}
+
+void GridSearch::Flood(Cell origin, const CellRect &bounds, bool reverse)
+{
+	Begin(bounds);
+	if (!bounds.Contains(origin) || !_grid.IsPassable(origin)) {
+		return;
+	}
+
+	const uint32_t originIndex = GetIndex(origin);
+	GetState(originIndex).cost = 0;
+	_open.Push(originIndex, 0);
+	while (!_open.IsEmpty()) {
+		const uint32_t index = _open.Pop();
+		const Cell cell{_bounds.minX + index % _boundsWidth, _bounds.minZ + index / _boundsWidth};
+		NodeState &state = _states[index];
+		state.closed = true;
+		_expanded++;
+
+		for (uint32_t direction = 0; direction < GRID_DIRECTION_COUNT; direction++) {
+			const Cell neighbour{cell.x + GRID_STEP_X[direction], cell.z + GRID_STEP_Z[direction]};
+			if (!bounds.Contains(neighbour) || !_grid.CanStep(cell, direction)) {
+				continue;
+			}
+			// Walkability is symmetric, only the price of the step depends on which cell is entered
+			const uint32_t step = _grid.GetStepCost(reverse ? cell : neighbour, direction);
+			const uint32_t neighbourIndex = GetIndex(neighbour);
+			NodeState &next = GetState(neighbourIndex);
+			if (!next.closed && state.cost + step < next.cost) {
+				next.cost = state.cost + step;
+				next.parent = static_cast<uint8_t>(direction);
+				_open.Push(neighbourIndex, next.cost);
+			}
+		}
+	}
+}
+
+uint32_t GridSearch::GetCost(Cell cell) const
+{
+	if (!_bounds.Contains(cell)) {
+		return PATH_UNREACHABLE;
+	}
+	const NodeState &state = _states[GetIndex(cell)];
+	return state.stamp == _stamp ? state.cost : PATH_UNREACHABLE;
+}
+
+/* Implementation of private functions */
+
+void GridSearch::Begin(const CellRect &bounds)
+{
+	_bounds = bounds;
+	_boundsWidth = bounds.maxX - bounds.minX;
+	const uint32_t area = _boundsWidth * (bounds.maxZ - bounds.minZ);
+	if (_states.size() < area) {
+		_states.resize(area, NodeState{PATH_UNREACHABLE, 0, 0, false});
+	}
+	_open.Reserve(area);
+	_open.Clear();
+	_expanded = 0;
+
+	if (++_stamp == 0) {
+		// Wrapped around, old stamps could match again
+		for (NodeState &state : _states) {
+			state.stamp = 0;
+		}
+		_stamp = 1;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "cost_grid.h"
+#include "node_heap.h"
+
+namespace TGW::Sim {
+
+constexpr uint32_t PATH_UNREACHABLE = UINT32_MAX;
+
+// Octile distance in step cost units, a lower bound for any path between the two cells
+inline uint32_t GetOctileDistance(Cell a, Cell b)
+{
+	const uint32_t dx = a.x > b.x ? a.x - b.x : b.x - a.x;
+	const uint32_t dz = a.z > b.z ? a.z - b.z : b.z - a.z;
+	return STRAIGHT_STEP_COST * std::max(dx, dz) + (DIAGONAL_STEP_COST - STRAIGHT_STEP_COST) * std::min(dx, dz);
+}
+
+// A* and Dijkstra over the cells of a rectangle of the grid. Node state lives in arrays sized to the largest
+// rectangle seen so far and stamped per search, so repeated searches neither clear nor allocate.
+class GridSearch {
+  public:
+	explicit GridSearch(const CostGrid &grid) : _grid{grid} {}
+
+	// Cheapest path from start to goal that stays inside bounds. Appends the cells after start, goal included,
+	// to path when one is given.
+	std::optional<uint32_t> FindPath(Cell start, Cell goal, const CellRect &bounds, std::vector<Cell> *path = nullptr);
+
+	// Dijkstra from origin over bounds, GetCost then reads the results until the next search. Reverse floods
+	// measure the cost from every cell to origin instead of from origin, which differs where costs vary.
+	void Flood(Cell origin, const CellRect &bounds, bool reverse = false);
+	uint32_t GetCost(Cell cell) const;
+
+	inline uint32_t GetExpandedCount() const { return _expanded; }
+
+  private:
+	struct NodeState {
+		uint32_t cost;
+		uint32_t stamp;
+		uint8_t parent; // direction we came from
+		bool closed;
+	};
+
+	void Begin(const CellRect &bounds);
+	inline uint32_t GetIndex(Cell cell) const { return (cell.z - _bounds.minZ) * _boundsWidth + cell.x - _bounds.minX; }
+	inline NodeState &GetState(uint32_t index)
+	{
+		NodeState &state = _states[index];
+		if (state.stamp != _stamp) {
+			state = {PATH_UNREACHABLE, _stamp, 0, false};
+		}
+		return state;
+	}
+
+	const CostGrid &_grid;
+	CellRect _bounds;
+	uint32_t _boundsWidth = 0;
+	uint32_t _stamp = 0;
+	uint32_t _expanded = 0;
+	std::vector<NodeState> _states;
+	NodeHeap _open;
+};
+
+} // namespace TGW::Sim
@@ -0,0 +1,396 @@
+#include "hpa_pathfinder.h"
+#include "core/job_system.h"
+
+using namespace TGW::Sim;
+
+/* Implementation of public functions */
+
+HpaPathfinder::HpaPathfinder(const CostGrid &grid, uint32_t cacheCapacity)
+	: _grid{grid}, _clustersX{(grid.GetWidth() + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE},
+	  _clustersZ{(grid.GetHeight() + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE}, _search{grid}, _cache(cacheCapacity)
+{
+	const uint32_t clusterCount = _clustersX * _clustersZ;
+	_clusterNodes.resize(clusterCount);
+	_borderNodes.resize(clusterCount);
+	RebuildClusters(std::vector<uint8_t>(clusterCount, 1));
+}
+
+void HpaPathfinder::OnCostsChanged(const CellRect &rect)
+{
+	// A changed cell on a cluster edge also changes the entrance on the other side
+	const uint32_t minX = rect.minX > 0 ? rect.minX - 1 : 0;
+	const uint32_t minZ = rect.minZ > 0 ? rect.minZ - 1 : 0;
+	const uint32_t maxX = std::min(rect.maxX + 1, _grid.GetWidth());
+	const uint32_t maxZ = std::min(rect.maxZ + 1, _grid.GetHeight());
+	if (minX >= maxX || minZ >= maxZ) {
+		return;
+	}
+
+	std::vector<uint8_t> dirty(_clusterNodes.size(), 0);
+	for (uint32_t z = minZ / HPA_CLUSTER_SIZE; z <= (maxZ - 1) / HPA_CLUSTER_SIZE; z++) {
+		for (uint32_t x = minX / HPA_CLUSTER_SIZE; x <= (maxX - 1) / HPA_CLUSTER_SIZE; x++) {
+			dirty[z * _clustersX + x] = 1;
+		}
+	}
+	RebuildClusters(dirty);
+
+	for (CachedPath &cached : _cache) {
+		if (cached.key != UINT64_MAX && cached.bounds.Intersects(rect)) {
+			cached.key = UINT64_MAX;
+		}
+	}
+}
+
+std::optional<uint32_t> HpaPathfinder::FindPath(Cell start, Cell goal, std::vector<Cell> &path)
+{
+	path.clear();
+	if (!_grid.IsPassable(start) || !_grid.IsPassable(goal)) {
+		return {};
+	}
+	if (start == goal) {
+		path.push_back(start);
+		return 0;
+	}
+
+	const uint64_t key = uint64_t{start.z * _grid.GetWidth() + start.x} << 32 | (goal.z * _grid.GetWidth() + goal.x);
+	if (CachedPath *cached = FindCached(key)) {
+		_cacheHits++;
+		cached->lastUse = ++_cacheClock;
+		path.assign(cached->cells.begin(), cached->cells.end());
+		return cached->cost;
+	}
+	_cacheMisses++;
+
+	// Inside one cluster the direct path can beat any detour over the entrances
+	std::optional<uint32_t> direct;
+	if (GetCluster(start) == GetCluster(goal)) {
+		path.push_back(start);
+		direct = _search.FindPath(start, goal, GetClusterRect(GetCluster(start)), &path);
+	}
+
+	const std::optional<uint32_t> abstract = SearchAbstract(start, goal);
+	std::optional<uint32_t> cost;
+	if (direct && (!abstract || *direct <= *abstract)) {
+		cost = direct;
+	} else if (abstract && Refine(start, goal, path)) {
+		cost = abstract;
+	} else {
+		path.clear();
+		return {};
+	}
+
+	StoreCached(key, *cost, path);
+	return cost;
+}
+
+std::optional<uint32_t> HpaPathfinder::FindFlatPath(Cell start, Cell goal, std::vector<Cell> &path)
+{
+	path.clear();
+	path.push_back(start);
+	const std::optional<uint32_t> cost =
+		_search.FindPath(start, goal, {0, 0, _grid.GetWidth(), _grid.GetHeight()}, &path);
+	if (!cost) {
+		path.clear();
+	}
+	return cost;
+}
+
+/* Implementation of private functions */
+
+CellRect HpaPathfinder::GetClusterRect(uint32_t cluster) const
+{
+	const uint32_t minX = cluster % _clustersX * HPA_CLUSTER_SIZE;
+	const uint32_t minZ = cluster / _clustersX * HPA_CLUSTER_SIZE;
+	return {
+		minX, minZ, std::min(minX + HPA_CLUSTER_SIZE, _grid.GetWidth()), std::min(minZ + HPA_CLUSTER_SIZE, _grid.GetHeight())};
+}
+
+void HpaPathfinder::RebuildClusters(const std::vector<uint8_t> &dirty)
+{
+	// Every border a dirty cluster touches: its own two and the ones its west and south neighbours own
+	std::vector<std::pair<uint32_t, Border>> borders;
+	for (uint32_t cluster = 0; cluster < dirty.size(); cluster++) {
+		if (!dirty[cluster]) {
+			continue;
+		}
+		borders.push_back({cluster, BORDER_EAST});
+		borders.push_back({cluster, BORDER_NORTH});
+		if (cluster % _clustersX > 0 && !dirty[cluster - 1]) {
+			borders.push_back({cluster - 1, BORDER_EAST});
+		}
+		if (cluster >= _clustersX && !dirty[cluster - _clustersX]) {
+			borders.push_back({cluster - _clustersX, BORDER_NORTH});
+		}
+	}
+
+	// Clusters on either side of a rebuilt border get new nodes, so their links are redone as well
+	std::vector<uint8_t> relink(dirty.size(), 0);
+	for (const auto &[cluster, border] : borders) {
+		RemoveBorder(cluster, border);
+		relink[cluster] = 1;
+		const uint32_t neighbour = border == BORDER_EAST ? cluster + 1 : cluster + _clustersX;
+		if ((border == BORDER_EAST && cluster % _clustersX + 1 < _clustersX) ||
+			(border == BORDER_NORTH && neighbour < relink.size())) {
+			relink[neighbour] = 1;
+		}
+	}
+	for (const auto &[cluster, border] : borders) {
+		BuildBorder(cluster, border);
+	}
+
+	std::vector<uint32_t> clusters;
+	for (uint32_t cluster = 0; cluster < relink.size(); cluster++) {
+		if (relink[cluster]) {
+			clusters.push_back(cluster);
+		}
+	}
+	TGW::JobSystem::Get().ParallelFor(static_cast<uint32_t>(clusters.size()), 16, [&](uint32_t begin, uint32_t end) {
+		GridSearch search{_grid};
+		for (uint32_t i = begin; i < end; i++) {
+			LinkCluster(clusters[i], search);
+		}
+	});
+
+	// Size the query state once here so queries never have to
+	size_t largestCluster = 0;
+	for (const auto &nodes : _clusterNodes) {
+		largestCluster = std::max(largestCluster, nodes.size());
+	}
+	const uint32_t stateCount = static_cast<uint32_t>(_nodes.size() + 2);
+	_states.resize(stateCount, SearchState{PATH_UNREACHABLE, UINT32_MAX, 0, false});
+	_goalCosts.resize(stateCount, PATH_UNREACHABLE);
+	_goalStamps.resize(stateCount, 0);
+	_open.Reserve(stateCount);
+	_startEdges.reserve(largestCluster);
+	_abstractPath.reserve(stateCount);
+}
+
+void HpaPathfinder::RemoveBorder(uint32_t cluster, Border border)
+{
+	for (uint32_t node : _borderNodes[cluster][border]) {
+		std::vector<uint32_t> &clusterNodes = _clusterNodes[_nodes[node].cluster];
+		clusterNodes.erase(std::find(clusterNodes.begin(), clusterNodes.end(), node));
+		_nodes[node].edges.clear();
+		_nodes[node].pair = UINT32_MAX;
+		_freeNodes.push_back(node);
+	}
+	_borderNodes[cluster][border].clear();
+}
+
+void HpaPathfinder::BuildBorder(uint32_t cluster, Border border)
+{
+	const CellRect rect = GetClusterRect(cluster);
+	const bool east = border == BORDER_EAST;
+	if ((east && rect.maxX >= _grid.GetWidth()) || (!east && rect.maxZ >= _grid.GetHeight())) {
+		return;
+	}
+
+	// Cells along the border on this side and the other
+	const uint32_t length = east ? rect.maxZ - rect.minZ : rect.maxX - rect.minX;
+	auto inside = [&](uint32_t i) { return east ? Cell{rect.maxX - 1, rect.minZ + i} : Cell{rect.minX + i, rect.maxZ - 1}; };
+	auto outside = [&](uint32_t i) { return east ? Cell{rect.maxX, rect.minZ + i} : Cell{rect.minX + i, rect.maxZ}; };
+
+	auto addTransition = [&](uint32_t i) {
+		const uint32_t a = AddNode(inside(i));
+		const uint32_t b = AddNode(outside(i));
+		_nodes[a].pair = b;
+		_nodes[a].pairCost = STRAIGHT_STEP_COST * _grid.GetCost(outside(i));
+		_nodes[b].pair = a;
+		_nodes[b].pairCost = STRAIGHT_STEP_COST * _grid.GetCost(inside(i));
+		_borderNodes[cluster][border].push_back(a);
+		_borderNodes[cluster][border].push_back(b);
+	};
+
+	// Entrances are maximal runs of walkable cell pairs across the border
+	uint32_t runStart = 0;
+	for (uint32_t i = 0; i <= length; i++) {
+		const bool open = i < length && _grid.IsPassable(inside(i)) && _grid.IsPassable(outside(i));
+		if (open) {
+			continue;
+		}
+		const uint32_t width = i - runStart;
+		if (width > 0 && width <= HPA_MAX_SINGLE_TRANSITION_WIDTH) {
+			addTransition(runStart + width / 2);
+		} else if (width > 0) {
+			addTransition(runStart);
+			addTransition(i - 1);
+		}
+		runStart = i + 1;
+	}
+}
+
+uint32_t HpaPathfinder::AddNode(Cell cell)
+{
+	uint32_t node;
+	if (!_freeNodes.empty()) {
+		node = _freeNodes.back();
+		_freeNodes.pop_back();
+	} else {
+		node = static_cast<uint32_t>(_nodes.size());
+		_nodes.emplace_back();
+	}
+	_nodes[node].cell = cell;
+	_nodes[node].cluster = GetCluster(cell);
+	_clusterNodes[_nodes[node].cluster].push_back(node);
+	return node;
+}
+
+void HpaPathfinder::LinkCluster(uint32_t cluster, GridSearch &search)
+{
+	const CellRect rect = GetClusterRect(cluster);
+	const std::vector<uint32_t> &nodes = _clusterNodes[cluster];
+	for (uint32_t from : nodes) {
+		_nodes[from].edges.clear();
+		search.Flood(_nodes[from].cell, rect);
+		for (uint32_t to : nodes) {
+			const uint32_t cost = search.GetCost(_nodes[to].cell);
+			if (to != from && cost != PATH_UNREACHABLE) {
+				_nodes[from].edges.push_back({to, cost});
+			}
+		}
+	}
+}
+
+std::optional<uint32_t> HpaPathfinder::SearchAbstract(Cell start, Cell goal)
+{
+	const uint32_t startNode = static_cast<uint32_t>(_nodes.size());
+	const uint32_t goalNode = startNode + 1;
+	if (++_stamp == 0) {
+		for (uint32_t i = 0; i < _states.size(); i++) {
+			_states[i].stamp = _goalStamps[i] = 0;
+		}
+		_stamp = 1;
+	}
+
+	// Temporary links from the start into its cluster and from the goal cluster into the goal
+	const uint32_t startCluster = GetCluster(start);
+	_search.Flood(start, GetClusterRect(startCluster));
+	_startEdges.clear();
+	for (uint32_t node : _clusterNodes[startCluster]) {
+		const uint32_t cost = _search.GetCost(_nodes[node].cell);
+		if (cost != PATH_UNREACHABLE) {
+			_startEdges.push_back({node, cost});
+		}
+	}
+	const uint32_t goalCluster = GetCluster(goal);
+	_search.Flood(goal, GetClusterRect(goalCluster), true);
+	for (uint32_t node : _clusterNodes[goalCluster]) {
+		_goalCosts[node] = _search.GetCost(_nodes[node].cell);
+		_goalStamps[node] = _stamp;
+	}
+
+	auto getCell = [&](uint32_t node) { return node == startNode ? start : node == goalNode ? goal : _nodes[node].cell; };
+	auto getState = [&](uint32_t node) -> SearchState & {
+		SearchState &state = _states[node];
+		if (state.stamp != _stamp) {
+			state = {PATH_UNREACHABLE, UINT32_MAX, _stamp, false};
+		}
+		return state;
+	};
+
+	_open.Clear();
+	getState(startNode).cost = 0;
+	_open.Push(startNode, GetOctileDistance(start, goal));
+	while (!_open.IsEmpty()) {
+		const uint32_t current = _open.Pop();
+		SearchState &state = _states[current];
+		state.closed = true;
+		if (current == goalNode) {
+			_abstractPath.clear();
+			for (uint32_t node = goalNode; node != UINT32_MAX; node = _states[node].parent) {
+				_abstractPath.push_back(node);
+			}
+			std::reverse(_abstractPath.begin(), _abstractPath.end());
+			return state.cost;
+		}
+
+		auto relax = [&](uint32_t node, uint32_t cost) {
+			SearchState &next = getState(node);
+			if (!next.closed && cost < next.cost) {
+				next.cost = cost;
+				next.parent = current;
+				_open.Push(node, cost + GetOctileDistance(getCell(node), goal));
+			}
+		};
+		if (current == startNode) {
+			for (const Edge &edge : _startEdges) {
+				relax(edge.node, edge.cost);
+			}
+			continue;
+		}
+		const Node &node = _nodes[current];
+		for (const Edge &edge : node.edges) {
+			relax(edge.node, state.cost + edge.cost);
+		}
+		if (node.pair != UINT32_MAX) {
+			relax(node.pair, state.cost + node.pairCost);
+		}
+		if (_goalStamps[current] == _stamp && _goalCosts[current] != PATH_UNREACHABLE) {
+			relax(goalNode, state.cost + _goalCosts[current]);
+		}
+	}
+	return {};
+}
+
+// Turns the abstract path into cells: entrances are single steps, everything else a search inside one cluster
+bool HpaPathfinder::Refine(Cell start, Cell goal, std::vector<Cell> &path)
+{
+	const uint32_t startNode = static_cast<uint32_t>(_nodes.size());
+	path.clear();
+	path.push_back(start);
+
+	uint32_t previous = startNode;
+	Cell from = start;
+	for (size_t i = 1; i < _abstractPath.size(); i++) {
+		const uint32_t node = _abstractPath[i];
+		const Cell to = i + 1 == _abstractPath.size() ? goal : _nodes[node].cell;
+		if (previous != startNode && _nodes[previous].pair == node) {
+			path.push_back(to);
+		} else if (!(from == to) && !_search.FindPath(from, to, GetClusterRect(GetCluster(to)), &path)) {
+			return false;
+		}
+		previous = node;
+		from = to;
+	}
+	return true;
+}
+
+HpaPathfinder::CachedPath *HpaPathfinder::FindCached(uint64_t key)
+{
+	for (CachedPath &cached : _cache) {
+		if (cached.key == key) {
+			return &cached;
+		}
+	}
+	return nullptr;
+}
+
+// Replaces the least recently used entry, reusing its storage
+void HpaPathfinder::StoreCached(uint64_t key, uint32_t cost, const std::vector<Cell> &path)
+{
+	if (_cache.empty()) {
+		return;
+	}
+	CachedPath *oldest = &_cache.front();
+	for (CachedPath &cached : _cache) {
+		if (cached.key == UINT64_MAX) {
+			oldest = &cached;
+			break;
+		}
+		if (cached.lastUse < oldest->lastUse) {
+			oldest = &cached;
+		}
+	}
+
+	oldest->key = key;
+	oldest->lastUse = ++_cacheClock;
+	oldest->cost = cost;
+	oldest->cells.assign(path.begin(), path.end());
+	oldest->bounds = {UINT32_MAX, UINT32_MAX, 0, 0};
+	for (Cell cell : path) {
+		oldest->bounds.minX = std::min(oldest->bounds.minX, cell.x);
+		oldest->bounds.minZ = std::min(oldest->bounds.minZ, cell.z);
+		oldest->bounds.maxX = std::max(oldest->bounds.maxX, cell.x + 1);
+		oldest->bounds.maxZ = std::max(oldest->bounds.maxZ, cell.z + 1);
+	}
+}
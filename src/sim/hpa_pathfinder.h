@@ -0,0 +1,115 @@
+#pragma once
+
+#include "grid_search.h"
+
+namespace TGW::Sim {
+
+constexpr uint32_t HPA_CLUSTER_SIZE = 16;
+// Entrances up to this wide get one transition in the middle, wider ones one at each end
+constexpr uint32_t HPA_MAX_SINGLE_TRANSITION_WIDTH = 6;
+
+// Hierarchical A* (Botea et al.) for single unit orders. The grid is cut into clusters, entrances between
+// neighbouring clusters become nodes of an abstract graph, and nodes of a cluster are linked by their exact
+// cost through it. Queries search the abstract graph and refine the result cluster by cluster, so paths are
+// near optimal rather than optimal.
+//
+// All search state is preallocated when the graph is built: a query does not allocate unless path has to
+// grow. Not thread safe, give every thread its own pathfinder.
+class HpaPathfinder {
+  public:
+	explicit HpaPathfinder(const CostGrid &grid, uint32_t cacheCapacity = 256);
+
+	// Call after changing costs inside rect. Only the clusters around it are rebuilt, cached paths through it
+	// are dropped.
+	void OnCostsChanged(const CellRect &rect);
+
+	// Fills path with the cells from start to goal, both included, and returns its cost in step units
+	std::optional<uint32_t> FindPath(Cell start, Cell goal, std::vector<Cell> &path);
+	// Plain A* over the whole grid. Optimal and much slower, kept as the reference
+	std::optional<uint32_t> FindFlatPath(Cell start, Cell goal, std::vector<Cell> &path);
+
+	inline uint32_t GetNodeCount() const { return static_cast<uint32_t>(_nodes.size() - _freeNodes.size()); }
+	inline uint32_t GetCacheHits() const { return _cacheHits; }
+	inline uint32_t GetCacheMisses() const { return _cacheMisses; }
+
+  private:
+	struct Edge {
+		uint32_t node;
+		uint32_t cost;
+	};
+
+	struct Node {
+		Cell cell;
+		uint32_t cluster = 0;
+		// The node across the entrance and the price of stepping onto it
+		uint32_t pair = UINT32_MAX;
+		uint32_t pairCost = 0;
+		std::vector<Edge> edges; // within the cluster
+	};
+
+	struct SearchState {
+		uint32_t cost;
+		uint32_t parent;
+		uint32_t stamp;
+		bool closed;
+	};
+
+	struct CachedPath {
+		uint64_t key = UINT64_MAX;
+		uint64_t lastUse = 0;
+		uint32_t cost = 0;
+		CellRect bounds;
+		std::vector<Cell> cells;
+	};
+
+	// Borders are owned by the cluster west or south of them
+	enum Border : uint8_t {
+		BORDER_EAST,
+		BORDER_NORTH,
+		BORDER_COUNT,
+	};
+
+	inline uint32_t GetCluster(Cell cell) const
+	{
+		return cell.z / HPA_CLUSTER_SIZE * _clustersX + cell.x / HPA_CLUSTER_SIZE;
+	}
+	CellRect GetClusterRect(uint32_t cluster) const;
+
+	void RebuildClusters(const std::vector<uint8_t> &dirty);
+	void RemoveBorder(uint32_t cluster, Border border);
+	void BuildBorder(uint32_t cluster, Border border);
+	uint32_t AddNode(Cell cell);
+	void LinkCluster(uint32_t cluster, GridSearch &search);
+
+	std::optional<uint32_t> SearchAbstract(Cell start, Cell goal);
+	bool Refine(Cell start, Cell goal, std::vector<Cell> &path);
+
+	CachedPath *FindCached(uint64_t key);
+	void StoreCached(uint64_t key, uint32_t cost, const std::vector<Cell> &path);
+
+	const CostGrid &_grid;
+	uint32_t _clustersX = 0;
+	uint32_t _clustersZ = 0;
+
+	std::vector<Node> _nodes;
+	std::vector<uint32_t> _freeNodes;
+	std::vector<std::vector<uint32_t>> _clusterNodes;
+	std::vector<std::array<std::vector<uint32_t>, BORDER_COUNT>> _borderNodes;
+
+	// Query state, sized for every node plus the temporary start and goal nodes
+	GridSearch _search;
+	NodeHeap _open;
+	std::vector<SearchState> _states;
+	std::vector<uint32_t> _goalCosts; // to the goal, for nodes in the goal cluster
+	std::vector<uint32_t> _goalStamps;
+	std::vector<Edge> _startEdges;
+	std::vector<uint32_t> _abstractPath;
+	uint32_t _stamp = 0;
+
+	std::vector<CachedPath> _cache;
+	uint64_t _cacheClock = 0;
+	uint32_t _cacheHits = 0;
+	uint32_t _cacheMisses = 0;
+};
+
+} // namespace TGW::Sim
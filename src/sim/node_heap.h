@@ -0,0 +1,107 @@
+#pragma once
+
+#include "common.h"
+
+namespace TGW::Sim {
+
+// Binary min heap over node ids with decrease key. Storage is sized once by Reserve, after that pushes never
+// allocate, which keeps searches allocation free.
+class NodeHeap {
+  public:
+	inline void Reserve(uint32_t nodeCount)
+	{
+		if (_positions.size() < nodeCount) {
+			_positions.resize(nodeCount);
+			_entries.reserve(nodeCount);
+		}
+	}
+	inline void Clear() { _entries.clear(); }
+	inline bool IsEmpty() const { return _entries.empty(); }
+	inline uint32_t GetSize() const { return static_cast<uint32_t>(_entries.size()); }
+
+	// Positions of nodes that left the heap go stale, the entry they point at tells
+	inline bool Contains(uint32_t node) const
+	{
+		const uint32_t position = _positions[node];
+		return position < _entries.size() && _entries[position].node == node;
+	}
+
+	// Inserts node, or lowers its key when it is already queued
+	void Push(uint32_t node, uint32_t key)
+	{
+		uint32_t position;
+		if (Contains(node)) {
+			position = _positions[node];
+			_entries[position].key = key;
+		} else {
+			position = static_cast<uint32_t>(_entries.size());
+			_entries.push_back({key, node});
+		}
+		SiftUp(position);
+	}
+
+	// Node with the lowest key, the one Pop would return
+	inline uint32_t Peek() const { return _entries.front().node; }
+
+	uint32_t Pop()
+	{
+		const uint32_t node = _entries.front().node;
+		_entries.front() = _entries.back();
+		_entries.pop_back();
+		if (!_entries.empty()) {
+			_positions[_entries.front().node] = 0;
+			SiftDown(0);
+		}
+		return node;
+	}
+
+  private:
+	struct Entry {
+		uint32_t key;
+		uint32_t node;
+	};
+
+	void SiftUp(uint32_t position)
+	{
+		const Entry entry = _entries[position];
+		while (position > 0) {
+			const uint32_t parent = (position - 1) / 2;
+			if (_entries[parent].key <= entry.key) {
+				break;
+			}
+			_entries[position] = _entries[parent];
+			_positions[_entries[position].node] = position;
+			position = parent;
+		}
+		_entries[position] = entry;
+		_positions[entry.node] = position;
+	}
+
+	void SiftDown(uint32_t position)
+	{
+		const Entry entry = _entries[position];
+		const uint32_t size = static_cast<uint32_t>(_entries.size());
+		while (true) {
+			uint32_t child = position * 2 + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && _entries[child + 1].key < _entries[child].key) {
+				child++;
+			}
+			if (entry.key <= _entries[child].key) {
+				break;
+			}
+			_entries[position] = _entries[child];
+			_positions[_entries[position].node] = position;
+			position = child;
+		}
+		_entries[position] = entry;
+		_positions[entry.node] = position;
+	}
+
+	std::vector<Entry> _entries;
+	std::vector<uint32_t> _positions;
+};
+
+} // namespace TGW::Sim
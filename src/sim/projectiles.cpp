@@ -0,0 +1,310 @@
+#include "projectiles.h"
+#include "core/hash.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+// Groups of PROJECTILE_LANES projectiles per job, fewer than for units since every one is swept as well
+constexpr uint32_t GROUPS_PER_BATCH = 256;
+constexpr float NO_HIT = 2.0f;
+
+inline uint32_t RoundUpToLanes(uint32_t count)
+{
+	return (count + PROJECTILE_LANES - 1) / PROJECTILE_LANES * PROJECTILE_LANES;
+}
+
+inline XMVECTOR Load4(const std::vector<float> &values, uint32_t i)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values.data() + i));
+}
+
+inline void Store4(std::vector<float> &values, uint32_t i, FXMVECTOR v)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(values.data() + i), v);
+}
+
+inline XMFLOAT3 Lerp(XMFLOAT3 a, XMFLOAT3 b, float t)
+{
+	return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t};
+}
+
+// Height above the ground of the point at t along the segment
+inline float GetClearance(const TGW::Terrain::Heightmap &terrain, XMFLOAT3 a, XMFLOAT3 b, float t)
+{
+	const XMFLOAT3 point = Lerp(a, b, t);
+	return point.y - terrain.GetHeight(point.x, point.z);
+}
+
+// First root of the quadratic through clearances f0, fMid, f1 at the start, middle and end of [0, 1], NO_HIT when
+// it stays above the ground. Along a line the bilinear patch of a cell is quadratic, so this is exact in a cell.
+float FirstRoot(float f0, float fMid, float f1)
+{
+	const float a = 2.0f * f0 - 4.0f * fMid + 2.0f * f1, b = f1 - f0 - a;
+	if (std::abs(a) < 1e-6f) {
+		return b < 0.0f && -f0 / b <= 1.0f ? -f0 / b : NO_HIT;
+	}
+	const float discriminant = b * b - 4.0f * a * f0;
+	if (discriminant < 0.0f) {
+		return NO_HIT;
+	}
+	const float root = std::sqrt(discriminant);
+	const float low = (-b - root) / (2.0f * a), high = (-b + root) / (2.0f * a);
+	const float first = std::min(low, high), second = std::max(low, high);
+	return first >= 0.0f && first <= 1.0f ? first : second >= 0.0f && second <= 1.0f ? second : NO_HIT;
+}
+
+// First fraction of the segment from a to b under the ground, NO_HIT when it stays above. Walks the heightmap
+// cells the segment crosses (Amanatides and Woo) and solves for the ground in those it dips below the top of.
+float MarchTerrain(const TGW::Terrain::Heightmap &terrain, XMFLOAT3 a, XMFLOAT3 b)
+{
+	// Nothing above the highest sample can hit, which is most of a shell's flight
+	if (std::min(a.y, b.y) > terrain.GetMaxHeight()) {
+		return NO_HIT;
+	}
+	float clearanceIn = GetClearance(terrain, a, b, 0.0f);
+	if (clearanceIn <= 0.0f) {
+		return 0.0f;
+	}
+
+	const float inverseSpacing = 1.0f / terrain.GetSpacing();
+	const XMFLOAT2 origin = terrain.GetOrigin();
+	const float startX = (a.x - origin.x) * inverseSpacing, startZ = (a.z - origin.y) * inverseSpacing;
+	const float deltaX = (b.x - a.x) * inverseSpacing, deltaZ = (b.z - a.z) * inverseSpacing;
+	const float unbounded = std::numeric_limits<float>::max();
+	float cellX = std::floor(startX), cellZ = std::floor(startZ);
+	const float stepX = deltaX != 0.0f ? 1.0f / std::abs(deltaX) : unbounded;
+	const float stepZ = deltaZ != 0.0f ? 1.0f / std::abs(deltaZ) : unbounded;
+	float nextX = deltaX > 0.0f ? (cellX + 1.0f - startX) * stepX : deltaX < 0.0f ? (startX - cellX) * stepX : unbounded;
+	float nextZ = deltaZ > 0.0f ? (cellZ + 1.0f - startZ) * stepZ : deltaZ < 0.0f ? (startZ - cellZ) * stepZ : unbounded;
+	// Off the map the heights continue the border cells
+	const float lastCellX = static_cast<float>(terrain.GetWidth() - 2), lastCellZ = static_cast<float>(terrain.GetHeight() - 2);
+
+	float tIn = 0.0f;
+	while (true) {
+		const float tOut = std::min({nextX, nextZ, 1.0f});
+		const float clearanceOut = GetClearance(terrain, a, b, tOut);
+
+		const uint32_t x = static_cast<uint32_t>(std::clamp(cellX, 0.0f, lastCellX));
+		const uint32_t z = static_cast<uint32_t>(std::clamp(cellZ, 0.0f, lastCellZ));
+		const float top = std::max({terrain.GetSample(x, z), terrain.GetSample(x + 1, z), terrain.GetSample(x, z + 1),
+			terrain.GetSample(x + 1, z + 1)});
+		if (clearanceOut <= 0.0f || a.y + (b.y - a.y) * tIn <= top || a.y + (b.y - a.y) * tOut <= top) {
+			const float clearanceMid = GetClearance(terrain, a, b, (tIn + tOut) * 0.5f);
+			const float root = FirstRoot(clearanceIn, clearanceMid, clearanceOut);
+			if (root != NO_HIT) {
+				return std::min(tIn + (tOut - tIn) * root, tOut);
+			}
+			if (clearanceOut <= 0.0f) {
+				return tOut;
+			}
+		}
+		if (tOut >= 1.0f) {
+			return NO_HIT;
+		}
+		if (nextX < nextZ) {
+			nextX += stepX;
+			cellX += deltaX > 0.0f ? 1.0f : -1.0f;
+		} else {
+			nextZ += stepZ;
+			cellZ += deltaZ > 0.0f ? 1.0f : -1.0f;
+		}
+		tIn = tOut;
+		clearanceIn = clearanceOut;
+	}
+}
+
+// First fraction of the segment from a to b inside the sphere, NO_HIT when it misses
+float IntersectSphere(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 center, float radius)
+{
+	const XMFLOAT3 d{b.x - a.x, b.y - a.y, b.z - a.z}, m{a.x - center.x, a.y - center.y, a.z - center.z};
+	const float c = m.x * m.x + m.y * m.y + m.z * m.z - radius * radius;
+	if (c <= 0.0f) {
+		return 0.0f;
+	}
+	const float dd = d.x * d.x + d.y * d.y + d.z * d.z, md = m.x * d.x + m.y * d.y + m.z * d.z;
+	const float discriminant = md * md - dd * c;
+	if (md >= 0.0f || discriminant < 0.0f) {
+		return NO_HIT;
+	}
+	const float t = (-md - std::sqrt(discriminant)) / dd;
+	return t <= 1.0f ? t : NO_HIT;
+}
+} // namespace
+
+/* Implementation of public functions */
+
+void ProjectileSystem::Spawn(const ProjectileDesc &desc)
+{
+	const uint32_t i = _count++;
+	if (_count > _positionX.size()) {
+		Resize(RoundUpToLanes(std::max(_count, static_cast<uint32_t>(_positionX.size()) * 2)));
+	}
+	_positionX[i] = desc.position.x;
+	_positionY[i] = desc.position.y;
+	_positionZ[i] = desc.position.z;
+	_velocityX[i] = desc.velocity.x;
+	_velocityY[i] = desc.velocity.y;
+	_velocityZ[i] = desc.velocity.z;
+	_gravity[i] = PROJECTILE_GRAVITY * desc.gravityScale;
+	_lifetime[i] = desc.lifetime;
+	_owner[i] = desc.owner;
+	_payload[i] = desc.payload;
+}
+
+void ProjectileSystem::Clear()
+{
+	_count = 0;
+	_impacts.clear();
+	Resize(0);
+}
+
+void ProjectileSystem::Tick(float dt, const ProjectileTargets &targets, JobSystem &jobs)
+{
+	_impacts.clear();
+	// Like the terrain's highest sample, shells above the tallest unit skip the unit query
+	_unitCeiling = -std::numeric_limits<float>::max();
+	for (float y : targets.unitsY) {
+		_unitCeiling = std::max(_unitCeiling, y + 2.0f * targets.unitRadius);
+	}
+	const uint32_t groupCount = RoundUpToLanes(_count) / PROJECTILE_LANES;
+	jobs.ParallelFor(
+		groupCount, GROUPS_PER_BATCH, [&](uint32_t begin, uint32_t end) { TickGroups(begin, end, dt, targets); });
+	CollectImpacts();
+}
+
+uint64_t ProjectileSystem::GetStateHash() const
+{
+	uint64_t hash = Hash::Fnv1a({reinterpret_cast<const char *>(&_count), sizeof(_count)});
+	for (const std::vector<float> *values : {&_positionX, &_positionY, &_positionZ, &_velocityX, &_velocityY, &_velocityZ}) {
+		hash = Hash::Fnv1a({reinterpret_cast<const char *>(values->data()), _count * sizeof(float)}, hash);
+	}
+	return hash;
+}
+
+/* Implementation of private functions */
+
+void ProjectileSystem::Resize(uint32_t paddedCount)
+{
+	// Padding lanes stay idle, nothing moves them
+	for (std::vector<float> *values : {&_positionX, &_positionY, &_positionZ, &_velocityX, &_velocityY, &_velocityZ,
+			 &_gravity, &_lifetime, &_startX, &_startY, &_startZ, &_hitFraction}) {
+		values->resize(paddedCount, 0.0f);
+	}
+	_owner.resize(paddedCount);
+	_payload.resize(paddedCount);
+	_hitUnit.resize(paddedCount);
+}
+
+void ProjectileSystem::TickGroups(uint32_t begin, uint32_t end, float dt, const ProjectileTargets &targets)
+{
+	const XMVECTOR deltaTime = XMVectorReplicate(dt);
+	const XMVECTOR halfDeltaTimeSq = XMVectorReplicate(0.5f * dt * dt);
+	std::vector<uint32_t> candidates;
+
+	for (uint32_t group = begin; group < end; group++) {
+		const uint32_t i = group * PROJECTILE_LANES;
+		const XMVECTOR posX = Load4(_positionX, i);
+		const XMVECTOR posY = Load4(_positionY, i);
+		const XMVECTOR posZ = Load4(_positionZ, i);
+		const XMVECTOR velY = Load4(_velocityY, i);
+		const XMVECTOR gravity = Load4(_gravity, i);
+		Store4(_startX, i, posX);
+		Store4(_startY, i, posY);
+		Store4(_startZ, i, posZ);
+
+		// Exact for constant gravity, so the arc does not depend on the tick length
+		Store4(_positionX, i, XMVectorMultiplyAdd(Load4(_velocityX, i), deltaTime, posX));
+		Store4(_positionY, i, XMVectorMultiplyAdd(gravity, halfDeltaTimeSq, XMVectorMultiplyAdd(velY, deltaTime, posY)));
+		Store4(_positionZ, i, XMVectorMultiplyAdd(Load4(_velocityZ, i), deltaTime, posZ));
+		Store4(_velocityY, i, XMVectorMultiplyAdd(gravity, deltaTime, velY));
+		Store4(_lifetime, i, XMVectorSubtract(Load4(_lifetime, i), deltaTime));
+
+		const uint32_t lanes = std::min(PROJECTILE_LANES, _count - i);
+		for (uint32_t lane = 0; lane < lanes; lane++) {
+			std::tie(_hitFraction[i + lane], _hitUnit[i + lane]) = Sweep(i + lane, targets, candidates);
+		}
+	}
+}
+
+std::pair<float, uint32_t> ProjectileSystem::Sweep(
+	uint32_t i, const ProjectileTargets &targets, std::vector<uint32_t> &candidates) const
+{
+	const XMFLOAT3 a{_startX[i], _startY[i], _startZ[i]}, b{_positionX[i], _positionY[i], _positionZ[i]};
+	float hit = targets.terrain && !targets.terrain->IsEmpty() ? MarchTerrain(*targets.terrain, a, b) : NO_HIT;
+	uint32_t unit = UINT32_MAX;
+	if (!targets.grid || std::min(a.y, b.y) > _unitCeiling) {
+		return {hit, unit};
+	}
+
+	const float radius = targets.unitRadius;
+	candidates.clear();
+	targets.grid->QueryBox(
+		{std::min(a.x, b.x) - radius, std::min(a.z, b.z) - radius}, {std::max(a.x, b.x) + radius, std::max(a.z, b.z) + radius},
+		candidates);
+	for (uint32_t candidate : candidates) {
+		if (candidate < targets.unitOwners.size() && targets.unitOwners[candidate] == _owner[i]) {
+			continue;
+		}
+		const XMFLOAT3 center{targets.unitsX[candidate], targets.unitsY[candidate] + radius, targets.unitsZ[candidate]};
+		const float t = IntersectSphere(a, b, center, radius);
+		// Ties go to the lowest index, so the result does not depend on the order the grid returns them in
+		if (t < hit || (t == hit && t != NO_HIT && unit != UINT32_MAX && candidate < unit)) {
+			hit = t;
+			unit = candidate;
+		}
+	}
+	return {hit, unit};
+}
+
+// Serial, so impacts keep the spawn order. Survivors are packed down in the same order.
+void ProjectileSystem::CollectImpacts()
+{
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < _count; i++) {
+		if (_hitFraction[i] <= 1.0f) {
+			const XMFLOAT3 start{_startX[i], _startY[i], _startZ[i]}, end{_positionX[i], _positionY[i], _positionZ[i]};
+			_impacts.push_back({
+			  .position = Lerp(start, end, _hitFraction[i]),
+			  .payload = _payload[i],
+			  .unit = _hitUnit[i],
+			  .owner = _owner[i],
+			  .type = static_cast<uint8_t>(_hitUnit[i] != UINT32_MAX ? PROJECTILE_IMPACT_UNIT : PROJECTILE_IMPACT_GROUND),
+			});
+			continue;
+		}
+		if (_lifetime[i] <= 0.0f) {
+			_impacts.push_back({
+			  .position = {_positionX[i], _positionY[i], _positionZ[i]},
+			  .payload = _payload[i],
+			  .unit = UINT32_MAX,
+			  .owner = _owner[i],
+			  .type = PROJECTILE_IMPACT_EXPIRED,
+			});
+			continue;
+		}
+		if (kept != i) {
+			_positionX[kept] = _positionX[i];
+			_positionY[kept] = _positionY[i];
+			_positionZ[kept] = _positionZ[i];
+			_velocityX[kept] = _velocityX[i];
+			_velocityY[kept] = _velocityY[i];
+			_velocityZ[kept] = _velocityZ[i];
+			_gravity[kept] = _gravity[i];
+			_lifetime[kept] = _lifetime[i];
+			_owner[kept] = _owner[i];
+			_payload[kept] = _payload[i];
+		}
+		kept++;
+	}
+
+	// Lanes freed at the end go back to idle
+	for (uint32_t i = kept; i < _count; i++) {
+		_velocityX[i] = _velocityY[i] = _velocityZ[i] = 0.0f;
+		_gravity[i] = 0.0f;
+	}
+	_count = kept;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "spatial_grid.h"
+#include "terrain/heightmap.h"
+
+namespace TGW::Sim {
+
+// Kernels work on groups of this many projectiles, every array is padded to a multiple of it
+constexpr uint32_t PROJECTILE_LANES = 4;
+constexpr float PROJECTILE_GRAVITY = -9.81f;
+
+struct ProjectileDesc {
+	DirectX::XMFLOAT3 position{};
+	DirectX::XMFLOAT3 velocity{};
+	// Seconds of flight before it is dropped with a PROJECTILE_IMPACT_EXPIRED event, for air bursts and strays
+	float lifetime = 30.0f;
+	// Share of gravity it feels, 1 for shells and less for rockets or flat-firing small arms
+	float gravityScale = 1.0f;
+	uint8_t owner = 0;
+	// Weapon or warhead, handed back with the impact
+	uint32_t payload = 0;
+};
+
+enum ProjectileImpactType : uint8_t {
+	PROJECTILE_IMPACT_GROUND,
+	PROJECTILE_IMPACT_UNIT,
+	PROJECTILE_IMPACT_EXPIRED,
+};
+
+struct ProjectileImpact {
+	DirectX::XMFLOAT3 position;
+	uint32_t payload;
+	uint32_t unit; // index into the target arrays for PROJECTILE_IMPACT_UNIT, UINT32_MAX otherwise
+	uint8_t owner;
+	uint8_t type;
+};
+
+// What projectiles can hit during a tick. Units are spheres of unitRadius resting on their positions, the unit
+// arrays are the ones grid was rebuilt from, usually the dense arrays of a UnitStore. Projectiles do not hit
+// units of their own owner. Either target may be left out.
+struct ProjectileTargets {
+	const Terrain::Heightmap *terrain = nullptr;
+	const SpatialGrid *grid = nullptr;
+	std::span<const float> unitsX;
+	std::span<const float> unitsY;
+	std::span<const float> unitsZ;
+	std::span<const uint8_t> unitOwners;
+	float unitRadius = 1.0f;
+};
+
+// Every projectile in flight as parallel arrays. A tick integrates them four at a time, sweeps the segment each
+// one covered against the terrain with a DDA march over the heightmap cells and against the units near it, and
+// removes the ones that hit something.
+//
+// Ticks are deterministic: projectiles keep their spawn order, impacts come out in that order and nothing
+// depends on how the work was split between threads, so the same spawns and targets replay to the same state.
+class ProjectileSystem {
+  public:
+	void Spawn(const ProjectileDesc &desc);
+	void Clear();
+	inline uint32_t GetCount() const { return _count; }
+
+	// Moves every projectile over dt seconds and replaces the impacts with the ones of this tick
+	void Tick(float dt, const ProjectileTargets &targets, JobSystem &jobs = JobSystem::Get());
+	inline const std::vector<ProjectileImpact> &GetImpacts() const { return _impacts; }
+
+	// Read access to the component arrays, GetCount() entries each
+	inline std::span<const float> GetPositionsX() const { return {_positionX.data(), _count}; }
+	inline std::span<const float> GetPositionsY() const { return {_positionY.data(), _count}; }
+	inline std::span<const float> GetPositionsZ() const { return {_positionZ.data(), _count}; }
+
+	// Hash of the positions and velocities in flight, equal across runs that replayed the same ticks
+	uint64_t GetStateHash() const;
+
+  private:
+	void Resize(uint32_t paddedCount);
+	void TickGroups(uint32_t begin, uint32_t end, float dt, const ProjectileTargets &targets);
+	// Earliest hit along the segment this tick, as the fraction of it travelled and the unit hit if any
+	std::pair<float, uint32_t> Sweep(uint32_t i, const ProjectileTargets &targets, std::vector<uint32_t> &candidates) const;
+	void CollectImpacts();
+
+	uint32_t _count = 0;
+	float _unitCeiling = 0.0f;
+	std::vector<ProjectileImpact> _impacts;
+
+	// Dense, padded to PROJECTILE_LANES with idle projectiles
+	std::vector<float> _positionX;
+	std::vector<float> _positionY;
+	std::vector<float> _positionZ;
+	std::vector<float> _velocityX;
+	std::vector<float> _velocityY;
+	std::vector<float> _velocityZ;
+	std::vector<float> _gravity;
+	std::vector<float> _lifetime;
+	std::vector<uint8_t> _owner;
+	std::vector<uint32_t> _payload;
+
+	// Scratch of a tick: where each segment started and what it hit
+	std::vector<float> _startX;
+	std::vector<float> _startY;
+	std::vector<float> _startZ;
+	std::vector<float> _hitFraction;
+	std::vector<uint32_t> _hitUnit;
+};
+
+} // namespace TGW::Sim
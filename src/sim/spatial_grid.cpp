@@ -0,0 +1,244 @@
+#include "spatial_grid.h"
+#include "camera.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+// Padding past the last sorted point, far enough away to fail every test
+constexpr float PADDING_POSITION = 1e30f;
+constexpr uint32_t LANES = 4;
+constexpr uint32_t POINTS_PER_BATCH = 4096;
+constexpr uint32_t QUERIES_PER_BATCH = 64;
+
+inline XMVECTOR Load4(const std::vector<float> &values, uint32_t i)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values.data() + i));
+}
+
+// Calls fn(lane) for the lanes of a comparison result that passed, up to count lanes
+template <typename Fn> inline void ForEachSetLane(FXMVECTOR mask, uint32_t count, Fn &&fn)
+{
+	uint32_t lanes[LANES];
+	XMStoreInt4(lanes, mask);
+	for (uint32_t lane = 0; lane < count; lane++) {
+		if (lanes[lane]) {
+			fn(lane);
+		}
+	}
+}
+
+inline float Cross(XMFLOAT2 a, XMFLOAT2 b, XMFLOAT2 p) { return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x); }
+} // namespace
+
+/* Implementation of public functions */
+
+SpatialGrid::SpatialGrid(XMFLOAT2 origin, float cellSize, uint32_t cellsX, uint32_t cellsZ)
+	: _origin{origin}, _cellSize{cellSize}, _inverseCellSize{1.0f / cellSize}, _cellsX{std::max(cellsX, 1u)},
+	  _cellsZ{std::max(cellsZ, 1u)}, _cellStarts(size_t{_cellsX} * _cellsZ + 1, 0)
+{
+}
+
+void SpatialGrid::Rebuild(std::span<const float> positionsX, std::span<const float> positionsZ, JobSystem &jobs)
+{
+	_count = static_cast<uint32_t>(std::min(positionsX.size(), positionsZ.size()));
+	_pointCells.resize(_count);
+	jobs.ParallelFor(_count, POINTS_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			_pointCells[i] = GetCellZ(positionsZ[i]) * _cellsX + GetCellX(positionsX[i]);
+		}
+	});
+
+	// Counting sort: histogram, prefix sum, then scatter. Stable, so equal cells keep their input order.
+	std::fill(_cellStarts.begin(), _cellStarts.end(), 0);
+	for (uint32_t cell : _pointCells) {
+		_cellStarts[cell + 1]++;
+	}
+	for (size_t cell = 1; cell < _cellStarts.size(); cell++) {
+		_cellStarts[cell] += _cellStarts[cell - 1];
+	}
+
+	_sortedIndices.resize(_count + LANES - 1);
+	_sortedX.assign(_count + LANES - 1, PADDING_POSITION);
+	_sortedZ.assign(_count + LANES - 1, PADDING_POSITION);
+	std::vector<uint32_t> cursors(_cellStarts.begin(), _cellStarts.end() - 1);
+	for (uint32_t i = 0; i < _count; i++) {
+		const uint32_t slot = cursors[_pointCells[i]]++;
+		_sortedIndices[slot] = i;
+		_sortedX[slot] = positionsX[i];
+		_sortedZ[slot] = positionsZ[i];
+	}
+}
+
+void SpatialGrid::QueryRadius(XMFLOAT2 center, float radius, std::vector<uint32_t> &out) const
+{
+	ForEachInRadius(center, radius, [&](uint32_t slot) { out.push_back(_sortedIndices[slot]); });
+}
+
+void SpatialGrid::QueryBox(XMFLOAT2 min, XMFLOAT2 max, std::vector<uint32_t> &out) const
+{
+	const XMVECTOR minX = XMVectorReplicate(min.x), minZ = XMVectorReplicate(min.y);
+	const XMVECTOR maxX = XMVectorReplicate(max.x), maxZ = XMVectorReplicate(max.y);
+	ForEachRow(GetCellRange(min, max), [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i += LANES) {
+			const XMVECTOR x = Load4(_sortedX, i);
+			const XMVECTOR z = Load4(_sortedZ, i);
+			const XMVECTOR inside = XMVectorAndInt(
+				XMVectorAndInt(XMVectorGreaterOrEqual(x, minX), XMVectorLessOrEqual(x, maxX)),
+				XMVectorAndInt(XMVectorGreaterOrEqual(z, minZ), XMVectorLessOrEqual(z, maxZ)));
+			ForEachSetLane(inside, std::min(LANES, end - i), [&](uint32_t lane) { out.push_back(_sortedIndices[i + lane]); });
+		}
+	});
+}
+
+void SpatialGrid::QueryQuad(const std::array<XMFLOAT2, 4> &corners, std::vector<uint32_t> &out) const
+{
+	XMFLOAT2 min = corners[0], max = corners[0];
+	float area = 0.0f;
+	for (size_t i = 0; i < corners.size(); i++) {
+		const XMFLOAT2 &corner = corners[i], &next = corners[(i + 1) % corners.size()];
+		min = {std::min(min.x, corner.x), std::min(min.y, corner.y)};
+		max = {std::max(max.x, corner.x), std::max(max.y, corner.y)};
+		area += corner.x * next.y - next.x * corner.y;
+	}
+	// Every point would be on the line of a quad without area, a click is not a selection
+	if (area == 0.0f) {
+		return;
+	}
+
+	// Inside means on the same side of all four edges, whichever side that is
+	ForEachRow(GetCellRange(min, max), [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const XMFLOAT2 point{_sortedX[i], _sortedZ[i]};
+			bool negative = false, positive = false;
+			for (size_t edge = 0; edge < corners.size(); edge++) {
+				const float side = Cross(corners[edge], corners[(edge + 1) % corners.size()], point);
+				negative |= side < 0.0f;
+				positive |= side > 0.0f;
+			}
+			if (!(negative && positive)) {
+				out.push_back(_sortedIndices[i]);
+			}
+		}
+	});
+}
+
+void SpatialGrid::QueryNearest(XMFLOAT2 center, uint32_t k, float maxRadius, std::vector<uint32_t> &out) const
+{
+	if (k == 0 || maxRadius <= 0.0f) {
+		return;
+	}
+
+	// Grows the search circle until it holds k points, only then are the k closest known
+	thread_local std::vector<std::pair<float, uint32_t>> candidates;
+	float radius = std::min(_cellSize, maxRadius);
+	while (true) {
+		candidates.clear();
+		ForEachInRadius(center, radius, [&](uint32_t slot) {
+			const float dx = _sortedX[slot] - center.x;
+			const float dz = _sortedZ[slot] - center.y;
+			candidates.push_back({dx * dx + dz * dz, _sortedIndices[slot]});
+		});
+		if (candidates.size() >= k || radius >= maxRadius) {
+			break;
+		}
+		radius = std::min(radius * 2.0f, maxRadius);
+	}
+
+	const size_t count = std::min<size_t>(k, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+	for (size_t i = 0; i < count; i++) {
+		out.push_back(candidates[i].second);
+	}
+}
+
+void SpatialGrid::QueryRadiusBatch(
+	std::span<const XMFLOAT2> centers, float radius, SpatialQueryResults &results, JobSystem &jobs) const
+{
+	const uint32_t queryCount = static_cast<uint32_t>(centers.size());
+	const uint32_t batchCount = (queryCount + QUERIES_PER_BATCH - 1) / QUERIES_PER_BATCH;
+	std::vector<std::vector<uint32_t>> batchIndices(batchCount);
+	results.offsets.assign(queryCount + 1, 0);
+
+	// Every batch fills its own list and records per query counts, the lists are joined afterwards
+	jobs.ParallelFor(queryCount, QUERIES_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		std::vector<uint32_t> &indices = batchIndices[begin / QUERIES_PER_BATCH];
+		for (uint32_t query = begin; query < end; query++) {
+			const size_t before = indices.size();
+			QueryRadius(centers[query], radius, indices);
+			results.offsets[query + 1] = static_cast<uint32_t>(indices.size() - before);
+		}
+	});
+
+	for (uint32_t query = 0; query < queryCount; query++) {
+		results.offsets[query + 1] += results.offsets[query];
+	}
+	results.indices.resize(results.offsets.back());
+	auto output = results.indices.begin();
+	for (const auto &indices : batchIndices) {
+		output = std::copy(indices.begin(), indices.end(), output);
+	}
+}
+
+void TGW::Sim::BoxSelect(
+	const SpatialGrid &grid, const Camera &camera, XMFLOAT2 dragStart, XMFLOAT2 dragEnd, XMFLOAT2 viewportSize,
+	std::vector<uint32_t> &out)
+{
+	const XMFLOAT2 screenCorners[4] = {
+		dragStart, {dragEnd.x, dragStart.y}, dragEnd, {dragStart.x, dragEnd.y}};
+	std::array<XMFLOAT2, 4> groundCorners;
+	for (size_t i = 0; i < groundCorners.size(); i++) {
+		const std::optional<XMFLOAT2> ground =
+			camera.ScreenToGround(screenCorners[i].x, screenCorners[i].y, viewportSize.x, viewportSize.y);
+		if (!ground) {
+			return;
+		}
+		groundCorners[i] = *ground;
+	}
+	grid.QueryQuad(groundCorners, out);
+}
+
+/* Implementation of private functions */
+
+uint32_t SpatialGrid::GetCellX(float x) const
+{
+	const float cell = std::floor((x - _origin.x) * _inverseCellSize);
+	// Written so NaN ends up in cell 0 as well
+	if (!(cell >= 0.0f)) {
+		return 0;
+	}
+	return cell >= _cellsX ? _cellsX - 1 : static_cast<uint32_t>(cell);
+}
+
+uint32_t SpatialGrid::GetCellZ(float z) const
+{
+	const float cell = std::floor((z - _origin.y) * _inverseCellSize);
+	if (!(cell >= 0.0f)) {
+		return 0;
+	}
+	return cell >= _cellsZ ? _cellsZ - 1 : static_cast<uint32_t>(cell);
+}
+
+SpatialGrid::CellRange SpatialGrid::GetCellRange(XMFLOAT2 min, XMFLOAT2 max) const
+{
+	return {GetCellX(min.x), GetCellZ(min.y), GetCellX(max.x), GetCellZ(max.y)};
+}
+
+template <typename Fn> void SpatialGrid::ForEachInRadius(XMFLOAT2 center, float radius, Fn &&fn) const
+{
+	const XMVECTOR centerX = XMVectorReplicate(center.x);
+	const XMVECTOR centerZ = XMVectorReplicate(center.y);
+	const XMVECTOR radiusSq = XMVectorReplicate(radius * radius);
+	ForEachRow(GetCellRange({center.x - radius, center.y - radius}, {center.x + radius, center.y + radius}),
+		[&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i += LANES) {
+				const XMVECTOR dx = XMVectorSubtract(Load4(_sortedX, i), centerX);
+				const XMVECTOR dz = XMVectorSubtract(Load4(_sortedZ, i), centerZ);
+				const XMVECTOR distanceSq = XMVectorMultiplyAdd(dx, dx, XMVectorMultiply(dz, dz));
+				ForEachSetLane(XMVectorLessOrEqual(distanceSq, radiusSq), std::min(LANES, end - i),
+					[&](uint32_t lane) { fn(i + lane); });
+			}
+		});
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "common.h"
+#include "core/job_system.h"
+
+#include <span>
+
+class Camera;
+
+namespace TGW::Sim {
+
+// Results of a batched query, one contiguous run of indices per query
+struct SpatialQueryResults {
+	std::vector<uint32_t> offsets; // query i owns indices[offsets[i], offsets[i + 1])
+	std::vector<uint32_t> indices;
+
+	inline size_t GetQueryCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+	inline std::span<const uint32_t> Get(size_t query) const
+	{
+		return {indices.data() + offsets[query], indices.data() + offsets[query + 1]};
+	}
+};
+
+// Uniform grid over the ground plane, rebuilt from scratch every tick with a counting sort. Points are stored
+// sorted by cell, so a row of cells is one contiguous run and queries stream through memory.
+// Points outside the grid are clamped into the border cells, queries stay exact for them.
+//
+// Queries return indices into the position arrays given to Rebuild, in no particular order unless stated.
+// They only read, so any number of them can run in parallel between rebuilds.
+class SpatialGrid {
+  public:
+	SpatialGrid(DirectX::XMFLOAT2 origin, float cellSize, uint32_t cellsX, uint32_t cellsZ);
+
+	void Rebuild(std::span<const float> positionsX, std::span<const float> positionsZ, JobSystem &jobs = JobSystem::Get());
+
+	inline uint32_t GetCount() const { return _count; }
+
+	// Each appends to out
+	void QueryRadius(DirectX::XMFLOAT2 center, float radius, std::vector<uint32_t> &out) const;
+	void QueryBox(DirectX::XMFLOAT2 min, DirectX::XMFLOAT2 max, std::vector<uint32_t> &out) const;
+	// Convex quad in either winding, what a drag rectangle becomes on the ground under a perspective camera. A quad
+	// without area holds nothing.
+	void QueryQuad(const std::array<DirectX::XMFLOAT2, 4> &corners, std::vector<uint32_t> &out) const;
+	// Up to k points within maxRadius, closest first
+	void QueryNearest(DirectX::XMFLOAT2 center, uint32_t k, float maxRadius, std::vector<uint32_t> &out) const;
+
+	// One radius query per center, spread over the job system
+	void QueryRadiusBatch(
+		std::span<const DirectX::XMFLOAT2> centers, float radius, SpatialQueryResults &results,
+		JobSystem &jobs = JobSystem::Get()) const;
+
+  private:
+	struct CellRange {
+		uint32_t minX, minZ, maxX, maxZ; // inclusive
+	};
+
+	uint32_t GetCellX(float x) const;
+	uint32_t GetCellZ(float z) const;
+	CellRange GetCellRange(DirectX::XMFLOAT2 min, DirectX::XMFLOAT2 max) const;
+	// Calls fn(slot) for the sorted points within radius
+	template <typename Fn> void ForEachInRadius(DirectX::XMFLOAT2 center, float radius, Fn &&fn) const;
+
+	// Calls fn(begin, end) with the runs of sorted points in the cells of range
+	template <typename Fn> void ForEachRow(const CellRange &range, Fn &&fn) const
+	{
+		for (uint32_t z = range.minZ; z <= range.maxZ; z++) {
+			const uint32_t row = z * _cellsX;
+			fn(_cellStarts[row + range.minX], _cellStarts[row + range.maxX + 1]);
+		}
+	}
+
+	DirectX::XMFLOAT2 _origin;
+	float _cellSize;
+	float _inverseCellSize;
+	uint32_t _cellsX;
+	uint32_t _cellsZ;
+	uint32_t _count = 0;
+
+	std::vector<uint32_t> _cellStarts; // per cell, plus one past the end
+	std::vector<uint32_t> _pointCells;
+	// Sorted by cell, padded so the last points can be read four at a time
+	std::vector<uint32_t> _sortedIndices;
+	std::vector<float> _sortedX;
+	std::vector<float> _sortedZ;
+};
+
+// Projects a drag rectangle in screen pixels onto the ground and selects the points under it. Nothing is
+// selected when a corner misses the ground, or for a click without a drag, which is for QueryNearest to pick.
+void BoxSelect(
+	const SpatialGrid &grid, const Camera &camera, DirectX::XMFLOAT2 dragStart, DirectX::XMFLOAT2 dragEnd,
+	DirectX::XMFLOAT2 viewportSize, std::vector<uint32_t> &out);
+
+} // namespace TGW::Sim
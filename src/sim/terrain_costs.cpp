@@ -0,0 +1,66 @@
+#include "terrain_costs.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+// Written so NaN clamps to 0
+uint32_t ClampCell(float position, uint32_t count)
+{
+	return position > 0.0f ? static_cast<uint32_t>(std::min(position, static_cast<float>(count))) : 0;
+}
+
+uint8_t GetSlopeCost(const TGW::Terrain::Heightmap &heightmap, XMFLOAT2 position, const SlopeCostSettings &settings)
+{
+	const XMFLOAT3 normal = heightmap.GetNormal(position.x, position.y);
+	const float slope = std::sqrt(normal.x * normal.x + normal.z * normal.z) / normal.y;
+	if (slope > settings.maxSlope) {
+		return COST_BLOCKED;
+	}
+	return static_cast<uint8_t>(std::min(COST_DEFAULT + std::lround(slope * settings.costPerSlope), long{COST_BLOCKED - 1}));
+}
+} // namespace
+
+/* Implementation of public functions */
+
+std::vector<CellRect> TGW::Sim::ApplyTerrainSlope(const Terrain::Heightmap &heightmap,
+	std::span<const Terrain::SampleRect> rects, CostGrid &grid, const CostGrid *base, const SlopeCostSettings &settings)
+{
+	std::vector<CellRect> changed;
+	const XMFLOAT2 mapOrigin = heightmap.GetOrigin(), gridOrigin = grid.GetOrigin();
+	const float spacing = heightmap.GetSpacing(), inverseCellSize = 1.0f / grid.GetCellSize();
+	for (const Terrain::SampleRect &rect : rects) {
+		if (rect.IsEmpty()) {
+			continue;
+		}
+		// Patches on either side of a changed sample change their slope
+		const float minX = mapOrigin.x + (static_cast<float>(rect.minX) - 1.0f) * spacing;
+		const float minZ = mapOrigin.y + (static_cast<float>(rect.minZ) - 1.0f) * spacing;
+		const float maxX = mapOrigin.x + rect.maxX * spacing, maxZ = mapOrigin.y + rect.maxZ * spacing;
+		const CellRect cells{
+		  ClampCell(std::floor((minX - gridOrigin.x) * inverseCellSize), grid.GetWidth()),
+		  ClampCell(std::floor((minZ - gridOrigin.y) * inverseCellSize), grid.GetHeight()),
+		  ClampCell(std::floor((maxX - gridOrigin.x) * inverseCellSize) + 1.0f, grid.GetWidth()),
+		  ClampCell(std::floor((maxZ - gridOrigin.y) * inverseCellSize) + 1.0f, grid.GetHeight()),
+		};
+
+		bool anyChanged = false;
+		for (uint32_t z = cells.minZ; z < cells.maxZ; z++) {
+			for (uint32_t x = cells.minX; x < cells.maxX; x++) {
+				const Cell cell{x, z};
+				const uint8_t floor = base && base->IsInside(cell) ? base->GetCost(cell) : COST_DEFAULT;
+				const uint8_t cost = std::max(floor, GetSlopeCost(heightmap, grid.CellToWorld(cell), settings));
+				if (cost != grid.GetCost(cell)) {
+					grid.SetCost(cell, cost);
+					anyChanged = true;
+				}
+			}
+		}
+		if (anyChanged) {
+			changed.push_back(cells);
+		}
+	}
+	return changed;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "cost_grid.h"
+#include "terrain/heightmap.h"
+
+namespace TGW::Sim {
+
+struct SlopeCostSettings {
+	// Rise over run above which ground cannot be walked, 1 is 45 degrees
+	float maxSlope = 1.0f;
+	// Extra cost per unit of slope on walkable ground
+	float costPerSlope = 8.0f;
+};
+
+// Recomputes the cost of the cells over changed terrain samples, typically the dirty rects of a crater batch, from
+// the slope at their centres. Cells of base keep at least its cost and stay blocked where it blocks, without base
+// flat ground costs COST_DEFAULT. Returns the cell rects that changed, to hand to FlowFieldCache::Invalidate and
+// HpaPathfinder::OnCostsChanged.
+std::vector<CellRect> ApplyTerrainSlope(const Terrain::Heightmap &heightmap, std::span<const Terrain::SampleRect> rects,
+	CostGrid &grid, const CostGrid *base = nullptr, const SlopeCostSettings &settings = {});
+
+} // namespace TGW::Sim
@@ -0,0 +1,280 @@
+#include "unit_store.h"
+#include "core/hash.h"
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+// Groups of UNIT_LANES units per job, big enough to amortize the dispatch and small enough to balance
+constexpr uint32_t GROUPS_PER_BATCH = 1024;
+constexpr float MIN_SPEED_SQ = 1e-6f;
+
+inline uint32_t RoundUpToLanes(uint32_t count) { return (count + UNIT_LANES - 1) / UNIT_LANES * UNIT_LANES; }
+
+inline XMVECTOR Load4(const std::vector<float> &values, uint32_t i)
+{
+	return XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(values.data() + i));
+}
+
+inline void Store4(std::vector<float> &values, uint32_t i, FXMVECTOR v)
+{
+	XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(values.data() + i), v);
+}
+} // namespace
+
+/* Implementation of public functions */
+
+UnitId UnitStore::Spawn(const UnitDesc &desc)
+{
+	UnitId id;
+	if (!_freeSlots.empty()) {
+		id.index = _freeSlots.back();
+		_freeSlots.pop_back();
+	} else {
+		id.index = static_cast<uint32_t>(_generations.size());
+		_generations.push_back(0);
+		_denseIndices.push_back(UINT32_MAX);
+	}
+	id.generation = _generations[id.index];
+
+	const uint32_t i = _count++;
+	if (_count > _positionX.size()) {
+		Resize(RoundUpToLanes(std::max(_count, static_cast<uint32_t>(_positionX.size()) * 2)));
+	}
+
+	_positionX[i] = desc.position.x;
+	_positionY[i] = desc.position.y;
+	_positionZ[i] = desc.position.z;
+	_velocityX[i] = 0.0f;
+	_velocityZ[i] = 0.0f;
+	_heading[i] = desc.heading;
+	_maxSpeed[i] = desc.maxSpeed;
+	_targetX[i] = desc.position.x;
+	_targetZ[i] = desc.position.z;
+	_moving[i] = 0.0f;
+	_health[i] = desc.health;
+	_owner[i] = desc.owner;
+	_model[i] = desc.model;
+	_ids[i] = id;
+	_denseIndices[id.index] = i;
+	return id;
+}
+
+bool UnitStore::Despawn(UnitId id)
+{
+	const std::optional<uint32_t> denseIndex = GetDenseIndex(id);
+	if (!denseIndex) {
+		return false;
+	}
+
+	const uint32_t last = --_count;
+	if (*denseIndex != last) {
+		MoveUnit(last, *denseIndex);
+	}
+	ClearUnit(last);
+
+	_denseIndices[id.index] = UINT32_MAX;
+	_generations[id.index]++;
+	_freeSlots.push_back(id.index);
+	return true;
+}
+
+std::optional<uint32_t> UnitStore::GetDenseIndex(UnitId id) const
+{
+	if (id.index >= _generations.size() || _generations[id.index] != id.generation ||
+		_denseIndices[id.index] == UINT32_MAX) {
+		return {};
+	}
+	return _denseIndices[id.index];
+}
+
+void UnitStore::SetMoveTarget(UnitId id, XMFLOAT2 target)
+{
+	if (const std::optional<uint32_t> i = GetDenseIndex(id)) {
+		_targetX[*i] = target.x;
+		_targetZ[*i] = target.y;
+		_moving[*i] = 1.0f;
+	}
+}
+
+void UnitStore::Stop(UnitId id)
+{
+	if (const std::optional<uint32_t> i = GetDenseIndex(id)) {
+		_moving[*i] = 0.0f;
+	}
+}
+
+void UnitStore::ApplyDamage(UnitId id, float damage)
+{
+	if (const std::optional<uint32_t> i = GetDenseIndex(id)) {
+		_health[*i] -= damage;
+	}
+}
+
+uint32_t UnitStore::RemoveDead()
+{
+	uint32_t removed = 0;
+	// Backwards, so the unit swapped into a hole has already been looked at
+	for (uint32_t i = _count; i-- > 0;) {
+		if (_health[i] <= 0.0f) {
+			Despawn(_ids[i]);
+			removed++;
+		}
+	}
+	return removed;
+}
+
+void UnitStore::Tick(float dt, JobSystem &jobs)
+{
+	const uint32_t groupCount = RoundUpToLanes(_count) / UNIT_LANES;
+	jobs.ParallelFor(groupCount, GROUPS_PER_BATCH, [&](uint32_t begin, uint32_t end) { TickGroups(begin, end, dt); });
+}
+
+uint64_t UnitStore::GetStateHash() const
+{
+	uint64_t hash = Hash::Fnv1a({reinterpret_cast<const char *>(&_count), sizeof(_count)});
+	for (const std::vector<float> *values :
+		 {&_positionX, &_positionY, &_positionZ, &_velocityX, &_velocityZ, &_heading, &_health, &_moving}) {
+		hash = Hash::Fnv1a({reinterpret_cast<const char *>(values->data()), _count * sizeof(float)}, hash);
+	}
+	return Hash::Fnv1a({reinterpret_cast<const char *>(_ids.data()), _count * sizeof(UnitId)}, hash);
+}
+
+void UnitStore::BuildWorldMatrices(std::vector<XMFLOAT4X4> &out, JobSystem &jobs) const
+{
+	out.resize(_count);
+	const uint32_t groupCount = RoundUpToLanes(_count) / UNIT_LANES;
+	jobs.ParallelFor(groupCount, GROUPS_PER_BATCH, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t group = begin; group < end; group++) {
+			const uint32_t first = group * UNIT_LANES;
+			XMVECTOR sin, cos;
+			XMVectorSinCos(&sin, &cos, Load4(_heading, first));
+
+			XMFLOAT4A s, c;
+			XMStoreFloat4A(&s, sin);
+			XMStoreFloat4A(&c, cos);
+			const float sines[UNIT_LANES] = {s.x, s.y, s.z, s.w};
+			const float cosines[UNIT_LANES] = {c.x, c.y, c.z, c.w};
+
+			// Same layout as XMMatrixRotationY(heading) * XMMatrixTranslation(position)
+			const uint32_t lanes = std::min(UNIT_LANES, _count - first);
+			for (uint32_t lane = 0; lane < lanes; lane++) {
+				const uint32_t i = first + lane;
+				out[i] = XMFLOAT4X4{
+					cosines[lane], 0.0f, -sines[lane], 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, sines[lane], 0.0f, cosines[lane], 0.0f,
+					_positionX[i], _positionY[i], _positionZ[i], 1.0f};
+			}
+		}
+	});
+}
+
+/* Implementation of private functions */
+
+void UnitStore::Resize(uint32_t paddedCount)
+{
+	_positionX.resize(paddedCount);
+	_positionY.resize(paddedCount);
+	_positionZ.resize(paddedCount);
+	_velocityX.resize(paddedCount);
+	_velocityZ.resize(paddedCount);
+	_heading.resize(paddedCount);
+	_maxSpeed.resize(paddedCount);
+	_targetX.resize(paddedCount);
+	_targetZ.resize(paddedCount);
+	_moving.resize(paddedCount);
+	_health.resize(paddedCount);
+	_owner.resize(paddedCount);
+	_model.resize(paddedCount);
+	_ids.resize(paddedCount);
+}
+
+void UnitStore::MoveUnit(uint32_t from, uint32_t to)
+{
+	_positionX[to] = _positionX[from];
+	_positionY[to] = _positionY[from];
+	_positionZ[to] = _positionZ[from];
+	_velocityX[to] = _velocityX[from];
+	_velocityZ[to] = _velocityZ[from];
+	_heading[to] = _heading[from];
+	_maxSpeed[to] = _maxSpeed[from];
+	_targetX[to] = _targetX[from];
+	_targetZ[to] = _targetZ[from];
+	_moving[to] = _moving[from];
+	_health[to] = _health[from];
+	_owner[to] = _owner[from];
+	_model[to] = _model[from];
+	_ids[to] = _ids[from];
+	_denseIndices[_ids[to].index] = to;
+}
+
+// Padding lanes must stay idle: no velocity and no order, so the kernels leave them where they are
+void UnitStore::ClearUnit(uint32_t i)
+{
+	_positionX[i] = _positionY[i] = _positionZ[i] = 0.0f;
+	_velocityX[i] = _velocityZ[i] = 0.0f;
+	_heading[i] = _maxSpeed[i] = 0.0f;
+	_targetX[i] = _targetZ[i] = 0.0f;
+	_moving[i] = 0.0f;
+	_health[i] = 0.0f;
+	_owner[i] = 0;
+	_model[i] = 0;
+	_ids[i] = {};
+}
+
+// Seek with arrival, four units at a time. Idle units brake to a stop with the same acceleration limit.
+void UnitStore::TickGroups(uint32_t begin, uint32_t end, float dt)
+{
+	const XMVECTOR deltaTime = XMVectorReplicate(dt);
+	const XMVECTOR maxDeltaV = XMVectorReplicate(_steering.maxAcceleration * dt);
+	const XMVECTOR invArrival = XMVectorReplicate(1.0f / std::max(_steering.arrivalRadius, 1e-3f));
+	const XMVECTOR stopRadius = XMVectorReplicate(_steering.stopRadius);
+	const XMVECTOR minSpeedSq = XMVectorReplicate(MIN_SPEED_SQ);
+	const XMVECTOR one = XMVectorSplatOne();
+	const XMVECTOR zero = XMVectorZero();
+
+	for (uint32_t group = begin; group < end; group++) {
+		const uint32_t i = group * UNIT_LANES;
+		XMVECTOR posX = Load4(_positionX, i);
+		XMVECTOR posZ = Load4(_positionZ, i);
+		XMVECTOR velX = Load4(_velocityX, i);
+		XMVECTOR velZ = Load4(_velocityZ, i);
+		XMVECTOR moving = Load4(_moving, i);
+
+		const XMVECTOR toTargetX = XMVectorSubtract(Load4(_targetX, i), posX);
+		const XMVECTOR toTargetZ = XMVectorSubtract(Load4(_targetZ, i), posZ);
+		const XMVECTOR distSq = XMVectorMultiplyAdd(toTargetX, toTargetX, XMVectorMultiply(toTargetZ, toTargetZ));
+		const XMVECTOR invDist = XMVectorReciprocalSqrt(XMVectorMax(distSq, minSpeedSq));
+		const XMVECTOR dist = XMVectorMultiply(distSq, invDist);
+
+		// Orders are done once the unit is close enough
+		moving = XMVectorSelect(moving, zero, XMVectorLess(dist, stopRadius));
+
+		const XMVECTOR speed = XMVectorMultiply(Load4(_maxSpeed, i), XMVectorMin(one, XMVectorMultiply(dist, invArrival)));
+		const XMVECTOR scale = XMVectorMultiply(XMVectorMultiply(speed, invDist), moving);
+		const XMVECTOR steerX = XMVectorSubtract(XMVectorMultiply(toTargetX, scale), velX);
+		const XMVECTOR steerZ = XMVectorSubtract(XMVectorMultiply(toTargetZ, scale), velZ);
+
+		const XMVECTOR steerSq = XMVectorMultiplyAdd(steerX, steerX, XMVectorMultiply(steerZ, steerZ));
+		const XMVECTOR steerScale =
+			XMVectorMin(one, XMVectorMultiply(maxDeltaV, XMVectorReciprocalSqrt(XMVectorMax(steerSq, minSpeedSq))));
+		velX = XMVectorMultiplyAdd(steerX, steerScale, velX);
+		velZ = XMVectorMultiplyAdd(steerZ, steerScale, velZ);
+
+		// Fully braked units come to rest instead of creeping
+		const XMVECTOR velSq = XMVectorMultiplyAdd(velX, velX, XMVectorMultiply(velZ, velZ));
+		const XMVECTOR hasSpeed = XMVectorGreater(velSq, minSpeedSq);
+		velX = XMVectorSelect(zero, velX, hasSpeed);
+		velZ = XMVectorSelect(zero, velZ, hasSpeed);
+
+		posX = XMVectorMultiplyAdd(velX, deltaTime, posX);
+		posZ = XMVectorMultiplyAdd(velZ, deltaTime, posZ);
+		const XMVECTOR heading = XMVectorSelect(Load4(_heading, i), XMVectorATan2(velX, velZ), hasSpeed);
+
+		Store4(_positionX, i, posX);
+		Store4(_positionZ, i, posZ);
+		Store4(_velocityX, i, velX);
+		Store4(_velocityZ, i, velZ);
+		Store4(_heading, i, heading);
+		Store4(_moving, i, moving);
+	}
+}
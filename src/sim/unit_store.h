@@ -0,0 +1,112 @@
+#pragma once
+
+#include "common.h"
+#include "core/job_system.h"
+
+#include <span>
+
+namespace TGW::Sim {
+
+// Kernels work on groups of this many units, every array is padded to a multiple of it
+constexpr uint32_t UNIT_LANES = 4;
+
+// Stays valid while the unit lives. Despawning bumps the slot generation, so stale ids stop resolving.
+struct UnitId {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	inline bool IsValid() const { return index != UINT32_MAX; }
+	bool operator==(const UnitId &) const = default;
+};
+
+struct UnitDesc {
+	DirectX::XMFLOAT3 position{};
+	float heading = 0.0f; // radians around +Y, 0 faces +Z
+	float maxSpeed = 5.0f;
+	float health = 100.0f;
+	uint8_t owner = 0;
+	uint32_t model = 0;
+};
+
+struct SteeringSettings {
+	float maxAcceleration = 20.0f;
+	// Units slow down linearly inside this distance of their target
+	float arrivalRadius = 2.0f;
+	// and drop the order once they are this close
+	float stopRadius = 0.1f;
+};
+
+// Every unit in the world as parallel arrays, indexed densely. Despawning swaps the last unit into the hole,
+// so dense indices are only stable between structural changes, use UnitId to hold on to a unit.
+class UnitStore {
+  public:
+	UnitId Spawn(const UnitDesc &desc);
+	bool Despawn(UnitId id);
+	inline bool IsAlive(UnitId id) const { return GetDenseIndex(id).has_value(); }
+	std::optional<uint32_t> GetDenseIndex(UnitId id) const;
+	inline UnitId GetId(uint32_t denseIndex) const { return _ids[denseIndex]; }
+	inline uint32_t GetCount() const { return _count; }
+
+	void SetMoveTarget(UnitId id, DirectX::XMFLOAT2 target);
+	void Stop(UnitId id);
+	void ApplyDamage(UnitId id, float damage);
+	// Despawns every unit at or below zero health, returns how many went
+	uint32_t RemoveDead();
+
+	inline SteeringSettings &GetSteering() { return _steering; }
+
+	// Steers every unit towards its move target and integrates the movement over dt seconds
+	void Tick(float dt, JobSystem &jobs = JobSystem::Get());
+
+	// Hash of every live unit and its orders, equal across runs that replayed the same ticks
+	uint64_t GetStateHash() const;
+
+	// Fills out[i] with the world matrix of dense unit i: rotation by heading, then translation
+	void BuildWorldMatrices(std::vector<DirectX::XMFLOAT4X4> &out, JobSystem &jobs = JobSystem::Get()) const;
+
+	// Read access to the component arrays, GetCount() entries each
+	inline std::span<const float> GetPositionsX() const { return {_positionX.data(), _count}; }
+	inline std::span<const float> GetPositionsY() const { return {_positionY.data(), _count}; }
+	inline std::span<const float> GetPositionsZ() const { return {_positionZ.data(), _count}; }
+	inline std::span<const float> GetVelocitiesX() const { return {_velocityX.data(), _count}; }
+	inline std::span<const float> GetVelocitiesZ() const { return {_velocityZ.data(), _count}; }
+	inline std::span<const float> GetHeadings() const { return {_heading.data(), _count}; }
+	inline std::span<const float> GetHealth() const { return {_health.data(), _count}; }
+	inline std::span<const uint8_t> GetOwners() const { return {_owner.data(), _count}; }
+	inline std::span<const uint32_t> GetModels() const { return {_model.data(), _count}; }
+
+	// Terrain and other systems place units vertically
+	inline std::span<float> GetPositionsY() { return {_positionY.data(), _count}; }
+
+  private:
+	void Resize(uint32_t paddedCount);
+	void MoveUnit(uint32_t from, uint32_t to);
+	void ClearUnit(uint32_t denseIndex);
+	void TickGroups(uint32_t begin, uint32_t end, float dt);
+
+	uint32_t _count = 0;
+	SteeringSettings _steering;
+
+	// Dense, padded to UNIT_LANES with idle units
+	std::vector<float> _positionX;
+	std::vector<float> _positionY;
+	std::vector<float> _positionZ;
+	std::vector<float> _velocityX;
+	std::vector<float> _velocityZ;
+	std::vector<float> _heading;
+	std::vector<float> _maxSpeed;
+	std::vector<float> _targetX;
+	std::vector<float> _targetZ;
+	std::vector<float> _moving; // 1 while following a move order, 0 otherwise, so the kernels can blend with it
+	std::vector<float> _health;
+	std::vector<uint8_t> _owner;
+	std::vector<uint32_t> _model;
+	std::vector<UnitId> _ids;
+
+	// Sparse, per id slot
+	std::vector<uint32_t> _denseIndices;
+	std::vector<uint32_t> _generations;
+	std::vector<uint32_t> _freeSlots;
+};
+
+} // namespace TGW::Sim
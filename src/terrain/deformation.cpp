@@ -0,0 +1,170 @@
+#include "deformation.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+using namespace TGW::Terrain;
+
+namespace {
+// Dirty tiles handed to a job at once, a few hundred thousand samples
+constexpr uint32_t TILES_PER_JOB = 4;
+
+SampleRect Intersect(const SampleRect &a, const SampleRect &b)
+{
+	return {std::max(a.minX, b.minX), std::max(a.minZ, b.minZ), std::min(a.maxX, b.maxX), std::min(a.maxZ, b.maxZ)};
+}
+
+// Written so NaN clamps to 0
+uint32_t ClampSample(float position, uint32_t count)
+{
+	return position > 0.0f ? static_cast<uint32_t>(std::min(position, static_cast<float>(count))) : 0;
+}
+} // namespace
+
+/* Implementation of public functions */
+
+float TGW::Terrain::GetCraterOffset(const Crater &crater, float dx, float dz)
+{
+	const float distanceSq = dx * dx + dz * dz, radiusSq = crater.radius * crater.radius;
+	if (distanceSq < radiusSq) {
+		// Parabolic bowl, from -depth at the centre up to the rim
+		return -crater.depth + (crater.depth + crater.rimHeight) * distanceSq / radiusSq;
+	}
+	const float t = (std::sqrt(distanceSq) - crater.radius) / ((CRATER_RIM_EXTENT - 1.0f) * crater.radius);
+	return t < 1.0f ? crater.rimHeight * (1.0f - t) * (1.0f - t) : 0.0f;
+}
+
+SampleRect TGW::Terrain::GetCraterRect(const Heightmap &heightmap, const Crater &crater)
+{
+	if (!(crater.radius > 0.0f)) {
+		return {};
+	}
+	const float reach = crater.radius * CRATER_RIM_EXTENT, inverseSpacing = 1.0f / heightmap.GetSpacing();
+	const XMFLOAT2 origin = heightmap.GetOrigin();
+	return {
+	  ClampSample(std::ceil((crater.center.x - reach - origin.x) * inverseSpacing), heightmap.GetWidth()),
+	  ClampSample(std::ceil((crater.center.y - reach - origin.y) * inverseSpacing), heightmap.GetHeight()),
+	  ClampSample(std::floor((crater.center.x + reach - origin.x) * inverseSpacing) + 1.0f, heightmap.GetWidth()),
+	  ClampSample(std::floor((crater.center.y + reach - origin.y) * inverseSpacing) + 1.0f, heightmap.GetHeight()),
+	};
+}
+
+/* CraterBatch */
+
+const std::vector<SampleRect> &CraterBatch::Apply(Heightmap &heightmap, Quadtree *quadtree, JobSystem &jobs)
+{
+	_dirtyRects.clear();
+	if (_craters.empty() || heightmap.IsEmpty()) {
+		_craters.clear();
+		return _dirtyRects;
+	}
+
+	const uint32_t tilesX = (heightmap.GetWidth() + CRATER_TILE_SAMPLES - 1) / CRATER_TILE_SAMPLES;
+	const uint32_t tilesZ = (heightmap.GetHeight() + CRATER_TILE_SAMPLES - 1) / CRATER_TILE_SAMPLES;
+	_craterRects.resize(_craters.size());
+	for (size_t i = 0; i < _craters.size(); i++) {
+		_craterRects[i] = GetCraterRect(heightmap, _craters[i]);
+	}
+
+	// Bucket the craters by the tiles they reach, counting first so each tile's list keeps the order they came in
+	_tileCraterStarts.assign(size_t{tilesX} * tilesZ + 1, 0);
+	const auto forEachTile = [&](const SampleRect &rect, auto &&fn) {
+		if (rect.IsEmpty()) {
+			return;
+		}
+		for (uint32_t tileZ = rect.minZ / CRATER_TILE_SAMPLES; tileZ <= (rect.maxZ - 1) / CRATER_TILE_SAMPLES; tileZ++) {
+			for (uint32_t tileX = rect.minX / CRATER_TILE_SAMPLES; tileX <= (rect.maxX - 1) / CRATER_TILE_SAMPLES; tileX++) {
+				fn(tileZ * tilesX + tileX);
+			}
+		}
+	};
+	for (const SampleRect &rect : _craterRects) {
+		forEachTile(rect, [&](uint32_t tile) { _tileCraterStarts[tile + 1]++; });
+	}
+	_dirtyTiles.clear();
+	for (uint32_t tile = 0; tile < tilesX * tilesZ; tile++) {
+		if (_tileCraterStarts[tile + 1] > 0) {
+			_dirtyTiles.push_back(tile);
+		}
+		_tileCraterStarts[tile + 1] += _tileCraterStarts[tile];
+	}
+	_tileCraters.resize(_tileCraterStarts.back());
+	std::vector<uint32_t> cursors{_tileCraterStarts.begin(), _tileCraterStarts.end() - 1};
+	for (uint32_t crater = 0; crater < _craterRects.size(); crater++) {
+		forEachTile(_craterRects[crater], [&](uint32_t tile) { _tileCraters[cursors[tile]++] = crater; });
+	}
+
+	// Tiles are disjoint, so they can be stamped in parallel with the same result as one crater after another
+	const XMFLOAT2 origin = heightmap.GetOrigin();
+	const float spacing = heightmap.GetSpacing();
+	_tileRanges.resize(_dirtyTiles.size());
+	jobs.ParallelFor(static_cast<uint32_t>(_dirtyTiles.size()), TILES_PER_JOB, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const uint32_t tile = _dirtyTiles[i];
+			const uint32_t minX = tile % tilesX * CRATER_TILE_SAMPLES, minZ = tile / tilesX * CRATER_TILE_SAMPLES;
+			const SampleRect tileRect{minX, minZ, minX + CRATER_TILE_SAMPLES, minZ + CRATER_TILE_SAMPLES};
+			float low = std::numeric_limits<float>::max(), high = std::numeric_limits<float>::lowest();
+			for (uint32_t j = _tileCraterStarts[tile]; j < _tileCraterStarts[tile + 1]; j++) {
+				const Crater &crater = _craters[_tileCraters[j]];
+				const auto [craterLow, craterHigh] = heightmap.Modify(
+					Intersect(tileRect, _craterRects[_tileCraters[j]]), [&](uint32_t x, uint32_t z, float &height) {
+						height += GetCraterOffset(crater, origin.x + x * spacing - crater.center.x,
+							origin.y + z * spacing - crater.center.y);
+					});
+				low = std::min(low, craterLow);
+				high = std::max(high, craterHigh);
+			}
+			_tileRanges[i] = {low, high};
+		}
+	});
+
+	for (const auto &[low, high] : _tileRanges) {
+		heightmap.IncludeRange(low, high);
+	}
+	CollectDirtyRects(tilesX, tilesZ);
+	for (SampleRect &rect : _dirtyRects) {
+		rect.maxX = std::min(rect.maxX, heightmap.GetWidth());
+		rect.maxZ = std::min(rect.maxZ, heightmap.GetHeight());
+		if (quadtree) {
+			quadtree->OnHeightsChanged(heightmap, rect);
+		}
+	}
+	_craters.clear();
+	return _dirtyRects;
+}
+
+/* Implementation of private functions */
+
+void CraterBatch::CollectDirtyRects(uint32_t tilesX, uint32_t tilesZ)
+{
+	// Runs of dirty tiles along a row, stacked onto the rect above when that one spans the same tiles. Dirty tiles
+	// come sorted row by row.
+	std::vector<uint32_t> open, nextOpen;
+	size_t i = 0;
+	for (uint32_t tileZ = 0; tileZ < tilesZ && i < _dirtyTiles.size(); tileZ++) {
+		nextOpen.clear();
+		while (i < _dirtyTiles.size() && _dirtyTiles[i] / tilesX == tileZ) {
+			const uint32_t minX = _dirtyTiles[i] % tilesX;
+			uint32_t maxX = minX + 1;
+			while (++i < _dirtyTiles.size() && maxX < tilesX && _dirtyTiles[i] == tileZ * tilesX + maxX) {
+				maxX++;
+			}
+
+			const SampleRect run{minX * CRATER_TILE_SAMPLES, tileZ * CRATER_TILE_SAMPLES, maxX * CRATER_TILE_SAMPLES,
+				(tileZ + 1) * CRATER_TILE_SAMPLES};
+			const auto above = std::find_if(open.begin(), open.end(), [&](uint32_t rect) {
+				return _dirtyRects[rect].minX == run.minX && _dirtyRects[rect].maxX == run.maxX &&
+					   _dirtyRects[rect].maxZ == run.minZ;
+			});
+			if (above != open.end()) {
+				_dirtyRects[*above].maxZ = run.maxZ;
+				nextOpen.push_back(*above);
+			} else {
+				nextOpen.push_back(static_cast<uint32_t>(_dirtyRects.size()));
+				_dirtyRects.push_back(run);
+			}
+		}
+		std::swap(open, nextOpen);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/job_system.h"
+#include "quadtree.h"
+
+namespace TGW::Terrain {
+
+// Side of the tiles a crater batch tracks dirty samples in, one LOD 0 node
+constexpr uint32_t CRATER_TILE_SAMPLES = TERRAIN_CHUNK_QUADS;
+// The rim reaches this far out, in crater radii
+constexpr float CRATER_RIM_EXTENT = 1.5f;
+
+// A bowl of depth below the ground at the centre rising to rimHeight above it at radius, then falling back to the
+// ground at CRATER_RIM_EXTENT radii. Craters add to the heights, so overlapping impacts dig deeper.
+struct Crater {
+	DirectX::XMFLOAT2 center; // world X and Z
+	float radius;
+	float depth;
+	float rimHeight;
+};
+
+// Height a crater adds at dx, dz from its centre
+float GetCraterOffset(const Crater &crater, float dx, float dz);
+// Samples a crater reaches, clamped to the map
+SampleRect GetCraterRect(const Heightmap &heightmap, const Crater &crater);
+
+// Impacts of a tick, stamped together. Apply marks the tiles every crater touches and then goes over each dirty
+// tile once, in parallel, with the craters that reach it in the order they were added. A barrage landing on the
+// same few hectares costs one pass over the union of its craters instead of an update per shell.
+class CraterBatch {
+  public:
+	inline void Add(const Crater &crater) { _craters.push_back(crater); }
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(_craters.size()); }
+	inline bool IsEmpty() const { return _craters.empty(); }
+
+	// Stamps the queued craters into heightmap, refreshes the node ranges of quadtree when given and empties the
+	// queue. Returns the changed samples as disjoint rects, for the renderer and the cost grid to update, valid
+	// until the next Apply.
+	const std::vector<SampleRect> &Apply(Heightmap &heightmap, Quadtree *quadtree, JobSystem &jobs = JobSystem::Get());
+
+  private:
+	void CollectDirtyRects(uint32_t tilesX, uint32_t tilesZ);
+
+	std::vector<Crater> _craters;
+	std::vector<SampleRect> _craterRects;
+	// Craters per dirty tile, CSR style
+	std::vector<uint32_t> _tileCraterStarts;
+	std::vector<uint32_t> _tileCraters;
+	std::vector<uint32_t> _dirtyTiles;
+	std::vector<std::pair<float, float>> _tileRanges;
+	std::vector<SampleRect> _dirtyRects;
+};
+
+} // namespace TGW::Terrain
@@ -0,0 +1,73 @@
+#include "heightmap.h"
+#include "core/file_mapping.h"
+
+#include <limits>
+
+using namespace DirectX;
+using namespace TGW::Terrain;
+
+namespace {
+constexpr uint32_t RAW16_SAMPLE_BYTES = 2;
+constexpr float RAW16_MAX_VALUE = 65535.0f;
+} // namespace
+
+/* Implementation of public functions */
+
+Heightmap::Heightmap(uint32_t width, uint32_t height, float spacing, XMFLOAT2 origin, std::vector<float> heights)
+	: _width{std::max(width, 2u)}, _height{std::max(height, 2u)}, _spacing{spacing}, _inverseSpacing{1.0f / spacing},
+	  _lastX{static_cast<float>(_width - 1)}, _lastZ{static_cast<float>(_height - 1)}, _origin{origin},
+	  _samples{std::move(heights)}
+{
+	_samples.resize(size_t{_width} * _height, 0.0f);
+	const auto [minHeight, maxHeight] = std::minmax_element(_samples.begin(), _samples.end());
+	_minHeight = *minHeight;
+	_maxHeight = *maxHeight;
+}
+
+std::optional<Heightmap>
+Heightmap::LoadRaw16(const std::filesystem::path &path, float spacing, float heightScale, XMFLOAT2 origin)
+{
+	FileMapping file;
+	if (!file.Open(path) || file.GetSize() % RAW16_SAMPLE_BYTES != 0) {
+		return {};
+	}
+
+	// Raw files carry no header, the size has to be a square number of samples
+	const size_t sampleCount = file.GetSize() / RAW16_SAMPLE_BYTES;
+	const uint32_t side = static_cast<uint32_t>(std::lround(std::sqrt(static_cast<double>(sampleCount))));
+	if (side < 2 || size_t{side} * side != sampleCount) {
+		return {};
+	}
+
+	std::vector<float> heights(sampleCount);
+	const uint8_t *data = file.GetData();
+	const float scale = heightScale / RAW16_MAX_VALUE;
+	for (size_t i = 0; i < sampleCount; i++) {
+		const uint16_t value = static_cast<uint16_t>(data[2 * i] | (data[2 * i + 1] << 8));
+		heights[i] = value * scale;
+	}
+	return Heightmap{side, side, spacing, origin, std::move(heights)};
+}
+
+void Heightmap::GetHeights(std::span<const float> positionsX, std::span<const float> positionsZ, std::span<float> heights) const
+{
+	const size_t count = std::min({positionsX.size(), positionsZ.size(), heights.size()});
+	for (size_t i = 0; i < count; i++) {
+		heights[i] = GetHeight(positionsX[i], positionsZ[i]);
+	}
+}
+
+std::pair<float, float> Heightmap::GetRange(uint32_t minX, uint32_t minZ, uint32_t maxX, uint32_t maxZ) const
+{
+	maxX = std::min(maxX, _width - 1);
+	maxZ = std::min(maxZ, _height - 1);
+	float low = std::numeric_limits<float>::max(), high = std::numeric_limits<float>::lowest();
+	for (uint32_t z = minZ; z <= maxZ; z++) {
+		const float *row = _samples.data() + size_t{z} * _width;
+		for (uint32_t x = minX; x <= maxX; x++) {
+			low = std::min(low, row[x]);
+			high = std::max(high, row[x]);
+		}
+	}
+	return {low, high};
+}
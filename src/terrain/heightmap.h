@@ -0,0 +1,136 @@
+#pragma once
+
+#include "common.h"
+
+#include <cmath>
+#include <span>
+
+namespace TGW::Terrain {
+
+// Spacing and height scale of the raw terrain the editor loads, replays have to load it the same way
+constexpr float TERRAIN_SPACING = 1.0f;
+constexpr float TERRAIN_HEIGHT_SCALE = 64.0f;
+
+// Rectangle of samples, half open on both axes
+struct SampleRect {
+	uint32_t minX = 0;
+	uint32_t minZ = 0;
+	uint32_t maxX = 0;
+	uint32_t maxZ = 0;
+
+	inline bool IsEmpty() const { return minX >= maxX || minZ >= maxZ; }
+	inline uint32_t GetArea() const { return IsEmpty() ? 0 : (maxX - minX) * (maxZ - minZ); }
+};
+
+// Grid of height samples over the ground plane. Sample (0, 0) sits at origin and x, z grow along world X and Z
+// by spacing, so a map of n samples spans n - 1 spacings. Queries outside the map clamp to its border.
+//
+// Height and normal queries are a handful of loads and multiplies with no branches beyond the clamp, kept
+// inline so units and projectiles can call them per tick without paying for a call.
+class Heightmap {
+  public:
+	Heightmap() = default;
+	// At least 2 x 2 samples, heights row major
+	Heightmap(uint32_t width, uint32_t height, float spacing, DirectX::XMFLOAT2 origin, std::vector<float> heights);
+
+	// Square little endian 16 bit raw, the format most terrain tools export. 0 maps to height 0 and 65535 to
+	// heightScale.
+	static std::optional<Heightmap>
+	LoadRaw16(const std::filesystem::path &path, float spacing, float heightScale, DirectX::XMFLOAT2 origin = {});
+
+	inline uint32_t GetWidth() const { return _width; }
+	inline uint32_t GetHeight() const { return _height; }
+	inline float GetSpacing() const { return _spacing; }
+	inline DirectX::XMFLOAT2 GetOrigin() const { return _origin; }
+	// World extent along X and Z
+	inline DirectX::XMFLOAT2 GetSize() const { return {(_width - 1) * _spacing, (_height - 1) * _spacing}; }
+	inline float GetMinHeight() const { return _minHeight; }
+	inline float GetMaxHeight() const { return _maxHeight; }
+	inline const std::vector<float> &GetSamples() const { return _samples; }
+	inline float GetSample(uint32_t x, uint32_t z) const { return _samples[z * _width + x]; }
+	inline bool IsEmpty() const { return _samples.empty(); }
+
+	// Bilinear height at a world position
+	inline float GetHeight(float x, float z) const
+	{
+		const Patch patch = GetPatch(x, z);
+		const float south = patch.h00 + (patch.h10 - patch.h00) * patch.tx;
+		const float north = patch.h01 + (patch.h11 - patch.h01) * patch.tx;
+		return south + (north - south) * patch.tz;
+	}
+
+	// Normal of the bilinear surface at a world position
+	inline DirectX::XMFLOAT3 GetNormal(float x, float z) const
+	{
+		const Patch patch = GetPatch(x, z);
+		// Derivatives of the bilinear patch, each a blend of the differences along the two edges it crosses
+		const float southSlope = patch.h10 - patch.h00, northSlope = patch.h11 - patch.h01;
+		const float westSlope = patch.h01 - patch.h00, eastSlope = patch.h11 - patch.h10;
+		const float slopeX = (southSlope + (northSlope - southSlope) * patch.tz) * _inverseSpacing;
+		const float slopeZ = (westSlope + (eastSlope - westSlope) * patch.tx) * _inverseSpacing;
+		const float inverseLength = 1.0f / std::sqrt(slopeX * slopeX + 1.0f + slopeZ * slopeZ);
+		return {-slopeX * inverseLength, inverseLength, -slopeZ * inverseLength};
+	}
+
+	// heights[i] = GetHeight(positionsX[i], positionsZ[i])
+	void GetHeights(std::span<const float> positionsX, std::span<const float> positionsZ, std::span<float> heights) const;
+	// Lowest and highest sample in the inclusive sample rectangle, clamped to the map
+	std::pair<float, float> GetRange(uint32_t minX, uint32_t minZ, uint32_t maxX, uint32_t maxZ) const;
+
+	// Calls fn(x, z, height) with a writable height for every sample of rect, clamped to the map, and returns the
+	// new range of heights in it. Disjoint rects can be modified in parallel, so the map's overall range is left
+	// to IncludeRange.
+	template <typename Fn> std::pair<float, float> Modify(const SampleRect &rect, Fn &&fn)
+	{
+		float low = std::numeric_limits<float>::max(), high = std::numeric_limits<float>::lowest();
+		const uint32_t maxX = std::min(rect.maxX, _width), maxZ = std::min(rect.maxZ, _height);
+		for (uint32_t z = rect.minZ; z < maxZ; z++) {
+			float *row = _samples.data() + size_t{z} * _width;
+			for (uint32_t x = rect.minX; x < maxX; x++) {
+				fn(x, z, row[x]);
+				low = std::min(low, row[x]);
+				high = std::max(high, row[x]);
+			}
+		}
+		return {low, high};
+	}
+	inline void IncludeRange(float low, float high)
+	{
+		_minHeight = std::min(_minHeight, low);
+		_maxHeight = std::max(_maxHeight, high);
+	}
+
+  private:
+	// The four samples around a position and where it sits between them
+	struct Patch {
+		float h00, h10, h01, h11;
+		float tx, tz;
+	};
+
+	inline Patch GetPatch(float x, float z) const
+	{
+		// Written so NaN clamps to the first sample
+		float fx = (x - _origin.x) * _inverseSpacing;
+		float fz = (z - _origin.y) * _inverseSpacing;
+		fx = fx > 0.0f ? std::min(fx, _lastX) : 0.0f;
+		fz = fz > 0.0f ? std::min(fz, _lastZ) : 0.0f;
+		// The last row and column interpolate from the one before, at t = 1
+		const uint32_t ix = std::min(static_cast<uint32_t>(fx), _width - 2);
+		const uint32_t iz = std::min(static_cast<uint32_t>(fz), _height - 2);
+		const float *row = _samples.data() + iz * _width + ix;
+		return {row[0], row[1], row[_width], row[_width + 1], fx - ix, fz - iz};
+	}
+
+	uint32_t _width = 0;
+	uint32_t _height = 0;
+	float _spacing = 1.0f;
+	float _inverseSpacing = 1.0f;
+	float _lastX = 0.0f;
+	float _lastZ = 0.0f;
+	DirectX::XMFLOAT2 _origin{0.0f, 0.0f};
+	float _minHeight = 0.0f;
+	float _maxHeight = 0.0f;
+	std::vector<float> _samples;
+};
+
+} // namespace TGW::Terrain
@@ -0,0 +1,293 @@
+#include "quadtree.h"
+#include "camera.h"
+
+#include <limits>
+
+using namespace DirectX;
+using namespace TGW::Terrain;
+
+namespace {
+constexpr uint32_t FRUSTUM_PLANE_COUNT = 6;
+constexpr uint32_t QUADRANT_COUNT = 4;
+constexpr float UNBOUNDED = std::numeric_limits<float>::max();
+
+float GetDistanceSq(XMFLOAT3 point, XMFLOAT3 min, XMFLOAT3 max)
+{
+	const float dx = std::max({min.x - point.x, 0.0f, point.x - max.x});
+	const float dy = std::max({min.y - point.y, 0.0f, point.y - max.y});
+	const float dz = std::max({min.z - point.z, 0.0f, point.z - max.z});
+	return dx * dx + dy * dy + dz * dz;
+}
+
+// Clip space planes of a row vector view projection matrix, pointing inward
+void GetFrustumPlanes(FXMMATRIX viewProjection, XMFLOAT4 *planes)
+{
+	const XMMATRIX columns = XMMatrixTranspose(viewProjection);
+	XMStoreFloat4(&planes[0], XMVectorAdd(columns.r[3], columns.r[0]));
+	XMStoreFloat4(&planes[1], XMVectorSubtract(columns.r[3], columns.r[0]));
+	XMStoreFloat4(&planes[2], XMVectorAdd(columns.r[3], columns.r[1]));
+	XMStoreFloat4(&planes[3], XMVectorSubtract(columns.r[3], columns.r[1]));
+	XMStoreFloat4(&planes[4], columns.r[2]);
+	XMStoreFloat4(&planes[5], XMVectorSubtract(columns.r[3], columns.r[2]));
+}
+
+bool IsOutside(const XMFLOAT4 *planes, XMFLOAT3 min, XMFLOAT3 max)
+{
+	for (uint32_t i = 0; i < FRUSTUM_PLANE_COUNT; i++) {
+		// The corner furthest along the plane normal is the last to leave
+		const XMFLOAT4 &plane = planes[i];
+		const float x = plane.x > 0.0f ? max.x : min.x;
+		const float y = plane.y > 0.0f ? max.y : min.y;
+		const float z = plane.z > 0.0f ? max.z : min.z;
+		if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+			return true;
+		}
+	}
+	return false;
+}
+} // namespace
+
+/* Quadtree */
+
+Quadtree::Quadtree(const Heightmap &heightmap, const QuadtreeSettings &settings)
+	: _origin{heightmap.GetOrigin()}, _spacing{heightmap.GetSpacing()}, _samplesX{heightmap.GetWidth()},
+	  _samplesZ{heightmap.GetHeight()}
+{
+	// Enough levels for the top nodes to cover the map, or as many as allowed and several top nodes
+	const uint32_t quads = std::max(_samplesX, _samplesZ) - 1;
+	uint32_t lodCount = 1;
+	while (lodCount < TERRAIN_MAX_LODS && GetNodeSamples(lodCount - 1) < quads) {
+		lodCount++;
+	}
+
+	_levels.resize(lodCount);
+	for (uint32_t lod = 0; lod < lodCount; lod++) {
+		Level &level = _levels[lod];
+		const uint32_t nodeSamples = GetNodeSamples(lod);
+		level.nodesX = (_samplesX - 1 + nodeSamples - 1) / nodeSamples;
+		level.nodesZ = (_samplesZ - 1 + nodeSamples - 1) / nodeSamples;
+		level.minHeights.resize(size_t{level.nodesX} * level.nodesZ);
+		level.maxHeights.resize(size_t{level.nodesX} * level.nodesZ);
+
+		for (uint32_t z = 0; z < level.nodesZ; z++) {
+			for (uint32_t x = 0; x < level.nodesX; x++) {
+				UpdateNode(heightmap, lod, x, z);
+			}
+		}
+	}
+
+	float previousRange = 0.0f;
+	for (uint32_t lod = 0; lod < lodCount; lod++) {
+		if (lod + 1 == lodCount) {
+			_ranges[lod] = UNBOUNDED;
+			_morphStarts[lod] = UNBOUNDED;
+			break;
+		}
+		_ranges[lod] = settings.lodDistance * static_cast<float>(1u << lod);
+		_morphStarts[lod] = _ranges[lod] - (_ranges[lod] - previousRange) * std::clamp(settings.morphFraction, 0.0f, 1.0f);
+		previousRange = _ranges[lod];
+	}
+}
+
+void Quadtree::OnHeightsChanged(const Heightmap &heightmap, const SampleRect &rect)
+{
+	if (_levels.empty() || rect.IsEmpty()) {
+		return;
+	}
+	// A sample on the border between two leaves belongs to both
+	const uint32_t leafSamples = GetNodeSamples(0);
+	uint32_t minX = rect.minX > 0 ? (rect.minX - 1) / leafSamples : 0;
+	uint32_t minZ = rect.minZ > 0 ? (rect.minZ - 1) / leafSamples : 0;
+	uint32_t maxX = std::min((rect.maxX - 1) / leafSamples, _levels[0].nodesX - 1);
+	uint32_t maxZ = std::min((rect.maxZ - 1) / leafSamples, _levels[0].nodesZ - 1);
+	for (uint32_t lod = 0; lod < GetLodCount(); lod++) {
+		for (uint32_t z = minZ; z <= maxZ; z++) {
+			for (uint32_t x = minX; x <= maxX; x++) {
+				UpdateNode(heightmap, lod, x, z);
+			}
+		}
+		minX /= 2;
+		minZ /= 2;
+		maxX /= 2;
+		maxZ /= 2;
+	}
+}
+
+void Quadtree::Select(XMFLOAT3 eye, std::vector<TerrainChunk> &chunks) const { SelectAll(eye, nullptr, chunks); }
+
+void Quadtree::Select(XMFLOAT3 eye, FXMMATRIX viewProjection, std::vector<TerrainChunk> &chunks) const
+{
+	XMFLOAT4 planes[FRUSTUM_PLANE_COUNT];
+	GetFrustumPlanes(viewProjection, planes);
+	SelectAll(eye, planes, chunks);
+}
+
+void Quadtree::Select(const Camera &camera, std::vector<TerrainChunk> &chunks) const
+{
+	const XMMATRIX view = camera.GetViewMatrix();
+	XMFLOAT3 eye;
+	XMStoreFloat3(&eye, XMMatrixInverse(nullptr, view).r[3]);
+	Select(eye, XMMatrixMultiply(view, camera.GetProjectionMatrix()), chunks);
+}
+
+/* Implementation of private functions */
+
+void Quadtree::UpdateNode(const Heightmap &heightmap, uint32_t lod, uint32_t x, uint32_t z)
+{
+	Level &level = _levels[lod];
+	const size_t node = size_t{z} * level.nodesX + x;
+	if (lod == 0) {
+		// Nodes share their border samples with the neighbours
+		const uint32_t nodeSamples = GetNodeSamples(0);
+		const auto [low, high] =
+			heightmap.GetRange(x * nodeSamples, z * nodeSamples, (x + 1) * nodeSamples, (z + 1) * nodeSamples);
+		level.minHeights[node] = low;
+		level.maxHeights[node] = high;
+		return;
+	}
+
+	const Level &children = _levels[lod - 1];
+	float low = UNBOUNDED, high = -UNBOUNDED;
+	for (uint32_t child = 0; child < QUADRANT_COUNT; child++) {
+		const uint32_t childX = 2 * x + child % 2, childZ = 2 * z + child / 2;
+		if (childX < children.nodesX && childZ < children.nodesZ) {
+			low = std::min(low, children.minHeights[size_t{childZ} * children.nodesX + childX]);
+			high = std::max(high, children.maxHeights[size_t{childZ} * children.nodesX + childX]);
+		}
+	}
+	level.minHeights[node] = low;
+	level.maxHeights[node] = high;
+}
+
+Quadtree::Bounds Quadtree::GetBounds(uint32_t lod, uint32_t x, uint32_t z) const
+{
+	const Level &level = _levels[lod];
+	const size_t node = size_t{z} * level.nodesX + x;
+	const float size = GetNodeSamples(lod) * _spacing;
+	const float minX = _origin.x + x * size, minZ = _origin.y + z * size;
+	// Nodes on the far edges stop where the map does
+	const float maxX = std::min(minX + size, _origin.x + (_samplesX - 1) * _spacing);
+	const float maxZ = std::min(minZ + size, _origin.y + (_samplesZ - 1) * _spacing);
+	return {{minX, level.minHeights[node], minZ}, {maxX, level.maxHeights[node], maxZ}};
+}
+
+uint8_t Quadtree::GetQuadrantsOnMap(uint32_t lod, uint32_t x, uint32_t z) const
+{
+	const uint32_t half = GetNodeSamples(lod) / 2;
+	uint8_t quadrants = 0;
+	for (uint32_t quadrant = 0; quadrant < QUADRANT_COUNT; quadrant++) {
+		const uint32_t startX = (2 * x + quadrant % 2) * half, startZ = (2 * z + quadrant / 2) * half;
+		if (startX < _samplesX - 1 && startZ < _samplesZ - 1) {
+			quadrants |= 1 << quadrant;
+		}
+	}
+	return quadrants;
+}
+
+void Quadtree::SelectAll(XMFLOAT3 eye, const XMFLOAT4 *planes, std::vector<TerrainChunk> &chunks) const
+{
+	chunks.clear();
+	const uint32_t top = GetLodCount() - 1;
+	for (uint32_t z = 0; z < _levels[top].nodesZ; z++) {
+		for (uint32_t x = 0; x < _levels[top].nodesX; x++) {
+			SelectNode(top, x, z, eye, planes, chunks);
+		}
+	}
+}
+
+bool Quadtree::SelectNode(
+	uint32_t lod, uint32_t x, uint32_t z, XMFLOAT3 eye, const XMFLOAT4 *planes, std::vector<TerrainChunk> &chunks) const
+{
+	const Bounds bounds = GetBounds(lod, x, z);
+	if (_ranges[lod] != UNBOUNDED && GetDistanceSq(eye, bounds.min, bounds.max) > _ranges[lod] * _ranges[lod]) {
+		return false;
+	}
+	if (planes && IsOutside(planes, bounds.min, bounds.max)) {
+		// Handled, there is just nothing to draw
+		return true;
+	}
+
+	const uint8_t onMap = GetQuadrantsOnMap(lod, x, z);
+	if (lod == 0 || GetDistanceSq(eye, bounds.min, bounds.max) > _ranges[lod - 1] * _ranges[lod - 1]) {
+		AddChunk(lod, x, z, onMap, chunks);
+		return true;
+	}
+
+	// Children in range draw themselves, this node fills in the quadrants of those that are not
+	const Level &children = _levels[lod - 1];
+	uint8_t quadrants = 0;
+	for (uint32_t quadrant = 0; quadrant < QUADRANT_COUNT; quadrant++) {
+		const uint32_t childX = 2 * x + quadrant % 2, childZ = 2 * z + quadrant / 2;
+		if ((onMap & (1 << quadrant)) && childX < children.nodesX && childZ < children.nodesZ &&
+			!SelectNode(lod - 1, childX, childZ, eye, planes, chunks)) {
+			quadrants |= 1 << quadrant;
+		}
+	}
+	if (quadrants) {
+		AddChunk(lod, x, z, quadrants, chunks);
+	}
+	return true;
+}
+
+void Quadtree::AddChunk(uint32_t lod, uint32_t x, uint32_t z, uint8_t quadrants, std::vector<TerrainChunk> &chunks) const
+{
+	const float size = GetNodeSamples(lod) * _spacing;
+	chunks.push_back({
+	  .origin = {_origin.x + x * size, _origin.y + z * size},
+	  .size = size,
+	  .lod = lod,
+	  .quadrants = quadrants,
+	  .morphStart = _morphStarts[lod],
+	  .morphEnd = _ranges[lod],
+	});
+}
+
+/* Chunk mesh */
+
+MeshData TGW::Terrain::BuildChunkMesh(uint32_t quads)
+{
+	// Quadrants need an even split
+	quads = std::max(quads + quads % 2, 2u);
+	const uint32_t side = quads + 1;
+	const float step = 1.0f / quads;
+
+	MeshData mesh;
+	mesh.vertices.reserve(size_t{side} * side);
+	for (uint32_t z = 0; z <= quads; z++) {
+		for (uint32_t x = 0; x <= quads; x++) {
+			mesh.vertices.push_back({{x * step, 0.0f, z * step}, {0.0f, 1.0f, 0.0f}, {x * step, z * step}});
+		}
+	}
+
+	const uint32_t half = quads / 2;
+	mesh.indices.reserve(size_t{quads} * quads * 6);
+	for (uint32_t quadrant = 0; quadrant < QUADRANT_COUNT; quadrant++) {
+		const uint32_t startX = quadrant % 2 * half, startZ = quadrant / 2 * half;
+		for (uint32_t z = startZ; z < startZ + half; z++) {
+			for (uint32_t x = startX; x < startX + half; x++) {
+				// Clockwise seen from above, the front face for the default rasterizer state
+				const uint32_t southWest = z * side + x, northWest = southWest + side;
+				mesh.indices.insert(
+					mesh.indices.end(), {southWest, northWest, northWest + 1, southWest, northWest + 1, southWest + 1});
+			}
+		}
+	}
+	return mesh;
+}
+
+float TGW::Terrain::GetMorphFactor(const TerrainChunk &chunk, float distance)
+{
+	if (chunk.morphEnd <= chunk.morphStart) {
+		return 0.0f;
+	}
+	return std::clamp((distance - chunk.morphStart) / (chunk.morphEnd - chunk.morphStart), 0.0f, 1.0f);
+}
+
+XMFLOAT2 TGW::Terrain::MorphGridPosition(XMFLOAT2 gridPosition, float morph, uint32_t quads)
+{
+	// Odd vertices slide onto their even neighbour, even ones are already on the coarser grid
+	const float halfQuads = quads * 0.5f;
+	const float fractionX = gridPosition.x * halfQuads - std::floor(gridPosition.x * halfQuads);
+	const float fractionZ = gridPosition.y * halfQuads - std::floor(gridPosition.y * halfQuads);
+	return {gridPosition.x - fractionX / halfQuads * morph, gridPosition.y - fractionZ / halfQuads * morph};
+}
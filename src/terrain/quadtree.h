@@ -0,0 +1,106 @@
+#pragma once
+
+#include "heightmap.h"
+#include "mesh_data.h"
+
+class Camera;
+
+namespace TGW::Terrain {
+
+// Quads along a side of the grid mesh, which is also the size of a LOD 0 node in samples
+constexpr uint32_t TERRAIN_CHUNK_QUADS = 32;
+constexpr uint32_t TERRAIN_MAX_LODS = 12;
+
+struct QuadtreeSettings {
+	// Distance up to which LOD 0 is drawn, every further LOD reaches twice as far
+	float lodDistance = 48.0f;
+	// Share of each LOD's distance band spent morphing into the next LOD
+	float morphFraction = 0.3f;
+};
+
+// Quadrants of a node, a child each
+enum ChunkQuadrant : uint8_t {
+	CHUNK_QUADRANT_SOUTH_WEST = 1 << 0,
+	CHUNK_QUADRANT_SOUTH_EAST = 1 << 1,
+	CHUNK_QUADRANT_NORTH_WEST = 1 << 2,
+	CHUNK_QUADRANT_NORTH_EAST = 1 << 3,
+	CHUNK_QUADRANT_ALL = 0xF,
+};
+
+// A node to draw this frame with the grid mesh scaled over it. Quadrants drawn by finer nodes, or lying off the
+// map, are left out of the mask.
+struct TerrainChunk {
+	DirectX::XMFLOAT2 origin; // world X and Z of the south west corner
+	float size;				  // world length of a side
+	uint32_t lod;
+	uint8_t quadrants;
+	// Vertices morph onto the next LOD's grid as their distance to the eye goes from morphStart to morphEnd
+	float morphStart;
+	float morphEnd;
+};
+
+// CDLOD (Strugar) selection over a heightmap. Nodes are squares of samples, from TERRAIN_CHUNK_QUADS at LOD 0
+// doubling per level, each with the height range of its samples for culling. Every LOD is drawn up to a distance
+// from the eye and morphs into the next one before it hands over, so there are no cracks or popping.
+class Quadtree {
+  public:
+	Quadtree() = default;
+	explicit Quadtree(const Heightmap &heightmap, const QuadtreeSettings &settings = {});
+
+	inline uint32_t GetLodCount() const { return static_cast<uint32_t>(_levels.size()); }
+	// How far from the eye the LOD is drawn, the top LOD reaches everywhere
+	inline float GetLodRange(uint32_t lod) const { return _ranges[lod]; }
+
+	// Refreshes the height ranges of the nodes over rect after its samples changed, leaves first, then up the levels
+	void OnHeightsChanged(const Heightmap &heightmap, const SampleRect &rect);
+
+	// Replaces chunks with the nodes to draw from eye. The second form also drops nodes outside the frustum of
+	// viewProjection, the third takes both from the camera.
+	void Select(DirectX::XMFLOAT3 eye, std::vector<TerrainChunk> &chunks) const;
+	void Select(DirectX::XMFLOAT3 eye, DirectX::FXMMATRIX viewProjection, std::vector<TerrainChunk> &chunks) const;
+	void Select(const Camera &camera, std::vector<TerrainChunk> &chunks) const;
+
+  private:
+	struct Level {
+		uint32_t nodesX = 0;
+		uint32_t nodesZ = 0;
+		std::vector<float> minHeights;
+		std::vector<float> maxHeights;
+	};
+
+	struct Bounds {
+		DirectX::XMFLOAT3 min;
+		DirectX::XMFLOAT3 max;
+	};
+
+	inline uint32_t GetNodeSamples(uint32_t lod) const { return TERRAIN_CHUNK_QUADS << lod; }
+	void UpdateNode(const Heightmap &heightmap, uint32_t lod, uint32_t x, uint32_t z);
+	Bounds GetBounds(uint32_t lod, uint32_t x, uint32_t z) const;
+	uint8_t GetQuadrantsOnMap(uint32_t lod, uint32_t x, uint32_t z) const;
+	void SelectAll(DirectX::XMFLOAT3 eye, const DirectX::XMFLOAT4 *planes, std::vector<TerrainChunk> &chunks) const;
+	// False when the node is out of its LOD's range and the parent has to cover it
+	bool SelectNode(
+		uint32_t lod, uint32_t x, uint32_t z, DirectX::XMFLOAT3 eye, const DirectX::XMFLOAT4 *planes,
+		std::vector<TerrainChunk> &chunks) const;
+	void AddChunk(uint32_t lod, uint32_t x, uint32_t z, uint8_t quadrants, std::vector<TerrainChunk> &chunks) const;
+
+	DirectX::XMFLOAT2 _origin{0.0f, 0.0f};
+	float _spacing = 1.0f;
+	uint32_t _samplesX = 0;
+	uint32_t _samplesZ = 0;
+	std::vector<Level> _levels;
+	std::array<float, TERRAIN_MAX_LODS> _ranges{};
+	std::array<float, TERRAIN_MAX_LODS> _morphStarts{};
+};
+
+// Grid of quads x quads over [0, 1] on X and Z at y = 0, the mesh every chunk is drawn with. Indices are grouped
+// by quadrant in ChunkQuadrant order, each a quarter of them, so any quadrant is one draw.
+MeshData BuildChunkMesh(uint32_t quads = TERRAIN_CHUNK_QUADS);
+
+// How far a vertex at distance from the eye has morphed, 0 on the chunk's own grid and 1 on the next LOD's
+float GetMorphFactor(const TerrainChunk &chunk, float distance);
+// Moves a grid position in [0, 1] toward the next LOD's grid, where every other vertex is gone. terrain.hlsl does
+// the same per vertex.
+DirectX::XMFLOAT2 MorphGridPosition(DirectX::XMFLOAT2 gridPosition, float morph, uint32_t quads = TERRAIN_CHUNK_QUADS);
+
+} // namespace TGW::Terrain
@@ -0,0 +1,154 @@
+#include "terrain_renderer.h"
+#include "camera.h"
+#include "log.h"
+
+using namespace DirectX;
+
+namespace {
+constexpr uint32_t QUADRANT_COUNT = 4;
+} // namespace
+
+/* Implementation of public functions */
+
+bool TGW::TerrainRenderer::Create(ID3D11Device *device, const Terrain::Heightmap &heightmap)
+{
+	ComPtr<ID3DBlob> vsBlob, psBlob;
+	if (FAILED(CompileShader(L"shaders/terrain.hlsl", "VSMain", "vs_5_0", vsBlob.GetAddressOf())) ||
+		FAILED(CompileShader(L"shaders/terrain.hlsl", "PSMain", "ps_5_0", psBlob.GetAddressOf()))) {
+		return false;
+	}
+	ASSERT_SUCCEEDED(device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &_vs));
+	ASSERT_SUCCEEDED(device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &_ps));
+
+	// Same vertex layout as models, the shader only reads the grid position
+	D3D11_INPUT_ELEMENT_DESC layout[] = {
+	  {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	  {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	  {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0}};
+	ASSERT_SUCCEEDED(device->CreateInputLayout(layout, 3, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &_inputLayout));
+
+	const MeshData mesh = Terrain::BuildChunkMesh();
+	_quadrantIndexCount = static_cast<uint32_t>(mesh.indices.size() / QUADRANT_COUNT);
+
+	D3D11_BUFFER_DESC vbd = {};
+	vbd.Usage = D3D11_USAGE_IMMUTABLE;
+	vbd.ByteWidth = static_cast<UINT>(mesh.vertices.size() * sizeof(Vertex));
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	D3D11_SUBRESOURCE_DATA vinit = {mesh.vertices.data()};
+	ASSERT_SUCCEEDED(device->CreateBuffer(&vbd, &vinit, &_vertexBuffer));
+
+	D3D11_BUFFER_DESC ibd = {};
+	ibd.Usage = D3D11_USAGE_IMMUTABLE;
+	ibd.ByteWidth = static_cast<UINT>(mesh.indices.size() * sizeof(uint32_t));
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	D3D11_SUBRESOURCE_DATA iinit = {mesh.indices.data()};
+	ASSERT_SUCCEEDED(device->CreateBuffer(&ibd, &iinit, &_indexBuffer));
+
+	D3D11_TEXTURE2D_DESC desc{};
+	desc.Width = heightmap.GetWidth();
+	desc.Height = heightmap.GetHeight();
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R32_FLOAT;
+	desc.SampleDesc.Count = 1;
+	// Craters rewrite parts of it, see UpdateHeights
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	D3D11_SUBRESOURCE_DATA init{};
+	init.pSysMem = heightmap.GetSamples().data();
+	init.SysMemPitch = heightmap.GetWidth() * sizeof(float);
+
+	HRESULT hr = device->CreateTexture2D(&desc, &init, _heightTexture.ReleaseAndGetAddressOf());
+	if (SUCCEEDED(hr)) {
+		hr = device->CreateShaderResourceView(_heightTexture.Get(), nullptr, _heightSrv.ReleaseAndGetAddressOf());
+	}
+	if (FAILED(hr)) {
+		Logger::LogInfo(
+			std::format("Failed to create the terrain height texture. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return false;
+	}
+
+	D3D11_SAMPLER_DESC sampDesc = {};
+	sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	sampDesc.AddressU = sampDesc.AddressV = sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	ASSERT_SUCCEEDED(device->CreateSamplerState(&sampDesc, &_heightSampler));
+
+	D3D11_BUFFER_DESC cbd = {};
+	cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	cbd.Usage = D3D11_USAGE_DEFAULT;
+	cbd.ByteWidth = sizeof(TerrainFrameConstantBuffer);
+	ASSERT_SUCCEEDED(device->CreateBuffer(&cbd, nullptr, &_cbFrame));
+	cbd.ByteWidth = sizeof(TerrainChunkConstantBuffer);
+	ASSERT_SUCCEEDED(device->CreateBuffer(&cbd, nullptr, &_cbChunk));
+
+	const XMFLOAT2 size = heightmap.GetSize();
+	_frame.gridQuads = static_cast<float>(Terrain::TERRAIN_CHUNK_QUADS);
+	_frame.mapOrigin = heightmap.GetOrigin();
+	_frame.texelSize = {1.0f / heightmap.GetWidth(), 1.0f / heightmap.GetHeight()};
+	// A map of n samples spans n - 1 spacings but n texels
+	_frame.mapToUV = {(1.0f - _frame.texelSize.x) / size.x, (1.0f - _frame.texelSize.y) / size.y};
+	_frame.sampleSpacing = heightmap.GetSpacing();
+	return true;
+}
+
+void TGW::TerrainRenderer::UpdateHeights(
+	ID3D11DeviceContext *context, const Terrain::Heightmap &heightmap, const Terrain::SampleRect &rect)
+{
+	const uint32_t maxX = std::min(rect.maxX, heightmap.GetWidth()), maxZ = std::min(rect.maxZ, heightmap.GetHeight());
+	if (!_heightTexture || rect.minX >= maxX || rect.minZ >= maxZ) {
+		return;
+	}
+	const D3D11_BOX box{rect.minX, rect.minZ, 0, maxX, maxZ, 1};
+	const float *first = heightmap.GetSamples().data() + size_t{rect.minZ} * heightmap.GetWidth() + rect.minX;
+	context->UpdateSubresource(_heightTexture.Get(), 0, &box, first, heightmap.GetWidth() * sizeof(float), 0);
+}
+
+void TGW::TerrainRenderer::Render(ID3D11DeviceContext *context, const Camera &camera, const Terrain::Quadtree &quadtree)
+{
+	if (!IsCreated() || quadtree.GetLodCount() == 0) {
+		return;
+	}
+	quadtree.Select(camera, _chunks);
+
+	const XMMATRIX view = camera.GetViewMatrix();
+	_frame.viewProjection = XMMatrixTranspose(XMMatrixMultiply(view, camera.GetProjectionMatrix()));
+	XMStoreFloat3(&_frame.eye, XMMatrixInverse(nullptr, view).r[3]);
+	context->UpdateSubresource(_cbFrame.Get(), 0, nullptr, &_frame, 0, 0);
+
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
+	context->IASetInputLayout(_inputLayout.Get());
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context->IASetVertexBuffers(0, 1, _vertexBuffer.GetAddressOf(), &stride, &offset);
+	context->IASetIndexBuffer(_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	context->VSSetShader(_vs.Get(), nullptr, 0);
+	context->PSSetShader(_ps.Get(), nullptr, 0);
+	context->VSSetConstantBuffers(0, 1, _cbFrame.GetAddressOf());
+	context->VSSetConstantBuffers(2, 1, _cbChunk.GetAddressOf());
+	context->VSSetShaderResources(0, 1, _heightSrv.GetAddressOf());
+	context->VSSetSamplers(2, 1, _heightSampler.GetAddressOf());
+
+	for (const Terrain::TerrainChunk &chunk : _chunks) {
+		const TerrainChunkConstantBuffer cb{
+		  .origin = chunk.origin,
+		  .size = chunk.size,
+		  .morphStart = chunk.morphStart,
+		  .morphEnd = chunk.morphEnd,
+		};
+		context->UpdateSubresource(_cbChunk.Get(), 0, nullptr, &cb, 0, 0);
+
+		// Neighbouring quadrants are neighbouring index ranges, so runs of them go in one draw
+		for (uint32_t quadrant = 0; quadrant < QUADRANT_COUNT;) {
+			if (!(chunk.quadrants & (1 << quadrant))) {
+				quadrant++;
+				continue;
+			}
+			const uint32_t first = quadrant;
+			while (quadrant < QUADRANT_COUNT && (chunk.quadrants & (1 << quadrant))) {
+				quadrant++;
+			}
+			context->DrawIndexed((quadrant - first) * _quadrantIndexCount, first * _quadrantIndexCount, 0);
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "pch.h"
+#include "shaders.h"
+#include "terrain/quadtree.h"
+
+using Microsoft::WRL::ComPtr;
+
+class Camera;
+
+namespace TGW {
+
+// Draws a heightmap with the chunks its quadtree selects. Heights live in a float texture the vertex shader
+// samples, every chunk is the same grid mesh placed and morphed by terrain.hlsl.
+class TerrainRenderer {
+  public:
+	// Compiles the shaders and uploads heightmap. Returns false when D3D fails.
+	bool Create(ID3D11Device *device, const Terrain::Heightmap &heightmap);
+	inline bool IsCreated() const { return _heightSrv != nullptr; }
+
+	// Uploads the samples of rect, the dirty rects of a crater batch, without touching the rest of the texture
+	void UpdateHeights(ID3D11DeviceContext *context, const Terrain::Heightmap &heightmap, const Terrain::SampleRect &rect);
+
+	// Leaves its own shaders, input layout and buffers bound
+	void Render(ID3D11DeviceContext *context, const Camera &camera, const Terrain::Quadtree &quadtree);
+
+	inline size_t GetDrawnChunkCount() const { return _chunks.size(); }
+
+  private:
+	ComPtr<ID3D11VertexShader> _vs;
+	ComPtr<ID3D11PixelShader> _ps;
+	ComPtr<ID3D11InputLayout> _inputLayout;
+	ComPtr<ID3D11Buffer> _vertexBuffer;
+	ComPtr<ID3D11Buffer> _indexBuffer;
+	ComPtr<ID3D11Texture2D> _heightTexture;
+	ComPtr<ID3D11ShaderResourceView> _heightSrv;
+	ComPtr<ID3D11SamplerState> _heightSampler;
+	ComPtr<ID3D11Buffer> _cbFrame;
+	ComPtr<ID3D11Buffer> _cbChunk;
+
+	uint32_t _quadrantIndexCount = 0;
+	TerrainFrameConstantBuffer _frame;
+	std::vector<Terrain::TerrainChunk> _chunks;
+};
+
+} // namespace TGW
@@ -1,4 +1,5 @@
 #include "texture.h"
+#include "archive/archive_set.h"
 #include "log.h"
 
 #include "DDSTextureLoader.h"
@@ -14,13 +15,21 @@
 
 static ComPtr<ID3D11ShaderResourceView> LoadWIC(ID3D11Device *device, const WCHAR *filename);
 
-ComPtr<ID3D11ShaderResourceView> TGW::Texture::Load(ID3D11Device *device, const WCHAR *filename)
+ComPtr<ID3D11ShaderResourceView>
+TGW::Texture::Load(ID3D11Device *device, const WCHAR *filename, const TGW::Archive::ArchiveSet *archives)
 {
 	std::wstring extension = std::filesystem::path{filename}.extension().wstring();
 	for (auto &character : extension) {
 		character = std::tolower(character);
 	}
 
+	if (archives) {
+		if (auto data = archives->Read(filename)) {
+			return extension == L".dds" ? LoadDDSFromMemory(device, data->data(), data->size())
+										: LoadEmbeddedCompressed(device, data->data(), data->size());
+		}
+	}
+
 	if (extension == L".dds") {
 		ComPtr<ID3D11ShaderResourceView> srv;
 		HRESULT hr = DirectX::CreateDDSTextureFromFile(device, filename, nullptr, srv.GetAddressOf());
@@ -54,6 +63,73 @@ TGW::Texture::LoadEmbeddedCompressed(ID3D11Device *device, const UINT8 *data, co
 	return srv;
 }
 
+ComPtr<ID3D11ShaderResourceView>
+TGW::Texture::LoadDDSFromMemory(ID3D11Device *device, const UINT8 *data, const size_t dataSize)
+{
+	if (!device) {
+		return nullptr;
+	}
+
+	ComPtr<ID3D11ShaderResourceView> srv = nullptr;
+	HRESULT hr = DirectX::CreateDDSTextureFromMemory(device, data, dataSize, nullptr, &srv);
+	if (FAILED(hr)) {
+		const std::string info =
+			std::format("Failed to load DDS texture from memory. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr));
+		Logger::LogInfo(info);
+	}
+
+	return srv;
+}
+
+std::vector<uint8_t> TGW::Texture::DecodeRGBA8(const UINT8 *data, const size_t dataSize, UINT width, UINT height)
+{
+	if (!data || dataSize > UINT32_MAX || width == 0 || height == 0) {
+		return {};
+	}
+
+	ComPtr<IWICImagingFactory> factory;
+	ComPtr<IWICStream> stream;
+	ComPtr<IWICBitmapDecoder> decoder;
+	ComPtr<IWICBitmapFrameDecode> frame;
+	ComPtr<IWICBitmapScaler> scaler;
+	ComPtr<IWICFormatConverter> converter;
+	std::vector<uint8_t> pixels(size_t{width} * height * 4);
+	HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+	if (SUCCEEDED(hr)) {
+		hr = factory->CreateStream(&stream);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = stream->InitializeFromMemory(const_cast<BYTE *>(data), static_cast<DWORD>(dataSize));
+	}
+	if (SUCCEEDED(hr)) {
+		hr = factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnLoad, &decoder);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = decoder->GetFrame(0, &frame);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = factory->CreateBitmapScaler(&scaler);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = scaler->Initialize(frame.Get(), width, height, WICBitmapInterpolationModeFant);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = factory->CreateFormatConverter(&converter);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = converter->Initialize(
+			scaler.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+	}
+	if (SUCCEEDED(hr)) {
+		hr = converter->CopyPixels(nullptr, width * 4, static_cast<UINT>(pixels.size()), pixels.data());
+	}
+	if (FAILED(hr)) {
+		Logger::LogInfo(std::format("Failed to decode texture. HRESULT: 0x{:08X}", static_cast<unsigned int>(hr)));
+		return {};
+	}
+	return pixels;
+}
+
 // TODO: Not very COM-like, consider changing later
 ComPtr<ID3D11ShaderResourceView> LoadWIC(ID3D11Device *device, const WCHAR *filename)
 {
@@ -6,7 +6,16 @@ using Microsoft::WRL::ComPtr;
 struct ID3D11ShaderResourceView;
 struct ID3D11Device;
 
+namespace TGW::Archive {
+class ArchiveSet;
+}
+
 namespace TGW::Texture {
-ComPtr<ID3D11ShaderResourceView> Load(ID3D11Device *device, const WCHAR *filename);
+// Looks the file up in the mounted archives first when given some, then falls back to the loose file
+ComPtr<ID3D11ShaderResourceView>
+Load(ID3D11Device *device, const WCHAR *filename, const TGW::Archive::ArchiveSet *archives = nullptr);
 ComPtr<ID3D11ShaderResourceView> LoadEmbeddedCompressed(ID3D11Device *device, const UINT8 *data, const size_t dataSize);
+ComPtr<ID3D11ShaderResourceView> LoadDDSFromMemory(ID3D11Device *device, const UINT8 *data, const size_t dataSize);
+// Decodes an image WIC understands to width x height RGBA8 pixels, resized when it has another size. Empty on failure.
+std::vector<uint8_t> DecodeRGBA8(const UINT8 *data, const size_t dataSize, UINT width, UINT height);
 } // namespace TGW::Texture
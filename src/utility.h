@@ -2,16 +2,34 @@
 
 #pragma once
 
-#include "pch.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cwchar>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#endif
+
+#if defined(_MSC_VER)
+#define DEBUG_BREAK() __debugbreak()
+#else
+#define DEBUG_BREAK() __builtin_trap()
+#endif
 
 namespace Utility
 {
-#ifdef _CONSOLE
-    inline void Print(const char* msg) { printf("%s", msg); }
-    inline void Print(const wchar_t* msg) { wprintf(L"%ws", msg); }
+#if defined(_CONSOLE) || !defined(_WIN32)
+    inline void Print(const char* msg) { fprintf(stderr, "%s", msg); }
+    inline void Print(const wchar_t* msg) { fprintf(stderr, "%ls", msg); }
 #else
     inline void Print(const char* msg) { OutputDebugStringA(msg); }
-    inline void Print(const wchar_t* msg) { OutputDebugString(msg); }
+    inline void Print(const wchar_t* msg) { OutputDebugStringW(msg); }
 #endif
 
     inline void Printf(const char* format, ...)
@@ -19,7 +37,7 @@ namespace Utility
         char buffer[256];
         va_list ap;
         va_start(ap, format);
-        vsprintf_s(buffer, 256, format, ap);
+        vsnprintf(buffer, 256, format, ap);
         va_end(ap);
         Print(buffer);
     }
@@ -41,7 +59,7 @@ namespace Utility
         char buffer[256];
         va_list ap;
         va_start(ap, format);
-        vsprintf_s(buffer, 256, format, ap);
+        vsnprintf(buffer, 256, format, ap);
         va_end(ap);
         Print(buffer);
         Print("\n");
@@ -74,7 +92,7 @@ namespace Utility
 #undef HALT
 #endif
 
-#define HALT( ... ) ERROR( __VA_ARGS__ ) __debugbreak();
+#define HALT( ... ) ERROR( __VA_ARGS__ ) DEBUG_BREAK();
 
 #ifdef RELEASE
 
@@ -95,7 +113,7 @@ namespace Utility
             Utility::PrintSubMessage("\'" #isFalse "\' is false"); \
             Utility::PrintSubMessage(__VA_ARGS__); \
             Utility::Print("\n"); \
-            __debugbreak(); \
+            DEBUG_BREAK(); \
         }
 
 #define ASSERT_SUCCEEDED( hr, ... ) \
@@ -104,7 +122,7 @@ namespace Utility
             Utility::PrintSubMessage("hr = 0x%08X", hr); \
             Utility::PrintSubMessage(__VA_ARGS__); \
             Utility::Print("\n"); \
-            __debugbreak(); \
+            DEBUG_BREAK(); \
         }
 
 #define WARN_ONCE_IF( isTrue, ... ) \
@@ -131,4 +149,4 @@ namespace Utility
 
 #endif
 
-#define BreakIfFailed( hr ) if (FAILED(hr)) __debugbreak()
\ No newline at end of file
+#define BreakIfFailed( hr ) if (FAILED(hr)) DEBUG_BREAK()
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "ai/ai_scheduler.h"
+
+#include <gtest/gtest.h>
+
+using namespace TGW::Ai;
+
+namespace {
+// Every thread runs its own virtual time, jobs move it forward by what they pretend to cost
+thread_local uint64_t virtualNanoseconds = 0;
+
+uint64_t GetVirtualTime() { return virtualNanoseconds; }
+
+AiJobFn Spend(uint32_t micros)
+{
+	return [micros] {
+		virtualNanoseconds += micros * 1000ull;
+		return false;
+	};
+}
+
+// 4 times more due every tick than the budget fits, every job has to get a quarter of the ticks
+void ExpectRoundRobin(uint32_t workers)
+{
+	TGW::JobSystem jobs{workers};
+	AiScheduler scheduler{GetVirtualTime};
+	const bool parallel = workers > 0;
+	const uint32_t jobCount = parallel ? 2048 : 40;
+	const uint32_t budget = jobCount / 4 * 10;
+	scheduler.AddSystem({.name = "tactics", .budgetMicros = budget, .parallel = parallel, .agingTicks = 30});
+	std::vector<std::atomic<uint32_t>> runs(jobCount);
+	for (uint32_t i = 0; i < jobCount; i++) {
+		scheduler.AddJob({.system = 0, .priority = 1, .interval = 1}, [&runs, i] {
+			runs[i]++;
+			virtualNanoseconds += 10'000;
+			return false;
+		});
+	}
+	// The first wave runs before any cost is known and may overshoot
+	for (uint32_t tick = 0; tick < 4; tick++) {
+		scheduler.Tick(jobs);
+	}
+	const uint64_t warmOverruns = scheduler.GetStats(0).overruns;
+	for (std::atomic<uint32_t> &count : runs) {
+		count = 0;
+	}
+	for (uint32_t tick = 0; tick < 40; tick++) {
+		scheduler.Tick(jobs);
+		EXPECT_LE(scheduler.GetStats(0).lastMicros, budget) << tick;
+	}
+	const AiSystemStats &stats = scheduler.GetStats(0);
+	EXPECT_EQ(stats.overruns, warmOverruns);
+	EXPECT_GT(stats.backlog, 0u);
+	for (uint32_t i = 0; i < jobCount; i++) {
+		EXPECT_GE(runs[i], 9u) << i;
+		EXPECT_LE(runs[i], 11u) << i;
+	}
+}
+} // namespace
+
+TEST(AiScheduler, KeepsTheIntervalWhenThereIsTime)
+{
+	AiScheduler scheduler{GetVirtualTime};
+	scheduler.AddSystem({.name = "targeting", .budgetMicros = 1000, .parallel = false, .agingTicks = 30});
+	std::vector<uint32_t> ticks;
+	scheduler.AddJob({.system = 0, .priority = 0, .interval = 3}, [&] {
+		ticks.push_back(scheduler.GetTickCount());
+		return false;
+	});
+	for (uint32_t tick = 0; tick < 30; tick++) {
+		scheduler.Tick();
+	}
+	ASSERT_EQ(ticks.size(), 10u);
+	EXPECT_EQ(ticks.front(), 1u);
+	for (size_t i = 1; i < ticks.size(); i++) {
+		EXPECT_EQ(ticks[i] - ticks[i - 1], 3u);
+	}
+}
+
+TEST(AiScheduler, SharesAShortBudgetRoundRobin) { ExpectRoundRobin(0); }
+
+TEST(AiScheduler, SharesAShortBudgetRoundRobinInParallel) { ExpectRoundRobin(3); }
+
+// High priority work alone fills the budget twice over, the low priority job still gets its turn
+TEST(AiScheduler, LowPrioritiesDoNotStarve)
+{
+	AiScheduler scheduler{GetVirtualTime};
+	scheduler.AddSystem({.name = "squads", .budgetMicros = 50, .parallel = false, .agingTicks = 5});
+	for (uint32_t i = 0; i < 10; i++) {
+		scheduler.AddJob({.system = 0, .priority = AI_PRIORITY_LEVELS - 1, .interval = 1}, Spend(10));
+	}
+	std::vector<uint32_t> ticks;
+	scheduler.AddJob({.system = 0, .priority = 0, .interval = 1}, [&] {
+		ticks.push_back(scheduler.GetTickCount());
+		virtualNanoseconds += 10'000;
+		return false;
+	});
+	for (uint32_t tick = 0; tick < 60; tick++) {
+		scheduler.Tick();
+	}
+	// Three levels below, it goes first once the others waited 15 ticks less than it did
+	ASSERT_GE(ticks.size(), 3u);
+	EXPECT_LE(ticks.front(), 20u);
+	EXPECT_LE(scheduler.GetStats(0).peakLateness, 20u);
+}
+
+// Work of 5 slices continues on the consecutive ticks ahead of everything else
+TEST(AiScheduler, SlicedWorkRunsOnConsecutiveTicks)
+{
+	AiScheduler scheduler{GetVirtualTime};
+	scheduler.AddSystem({.name = "planning", .budgetMicros = 30, .parallel = false, .agingTicks = 30});
+	for (uint32_t i = 0; i < 8; i++) {
+		scheduler.AddJob({.system = 0, .priority = 0, .interval = 1}, Spend(10));
+	}
+	std::vector<uint32_t> ticks;
+	uint32_t slices = 0;
+	scheduler.AddJob({.system = 0, .priority = 0, .interval = 100}, [&] {
+		ticks.push_back(scheduler.GetTickCount());
+		virtualNanoseconds += 20'000;
+		return ++slices % 5 != 0;
+	});
+	for (uint32_t tick = 0; tick < 20; tick++) {
+		scheduler.Tick();
+	}
+	ASSERT_EQ(ticks.size(), 5u);
+	EXPECT_EQ(ticks.back() - ticks.front(), 4u);
+	// Its first slice costs twice what the scheduler expects from the others and may overrun once
+	EXPECT_LE(scheduler.GetStats(0).overruns, 1u);
+}
+
+// Work that never finishes fills the whole budget with every slice, the other jobs still get their turns
+TEST(AiScheduler, EndlessSlicesDoNotStarveTheRest)
+{
+	AiScheduler scheduler{GetVirtualTime};
+	scheduler.AddSystem({.name = "planning", .budgetMicros = 50, .parallel = false, .agingTicks = 30});
+	std::vector<uint32_t> runs(10);
+	for (uint32_t i = 0; i < runs.size(); i++) {
+		scheduler.AddJob({.system = 0, .priority = 0, .interval = 1}, [&runs, i] {
+			runs[i]++;
+			virtualNanoseconds += 5'000;
+			return false;
+		});
+	}
+	uint32_t slices = 0;
+	scheduler.AddJob({.system = 0, .priority = 0, .interval = 1}, [&] {
+		slices++;
+		virtualNanoseconds += 50'000;
+		return true;
+	});
+	for (uint32_t tick = 0; tick < 60; tick++) {
+		scheduler.Tick();
+	}
+	// At most AI_MAX_PRIORITY_SLICES ticks in a row go to it, then it takes turns with the others
+	EXPECT_GE(slices, 15u);
+	EXPECT_LE(slices, 45u);
+	for (uint32_t i = 0; i < runs.size(); i++) {
+		EXPECT_GE(runs[i], 15u) << i;
+	}
+}
+
+// A job over budget is an overrun on every tick it runs, until it is removed for good
+TEST(AiScheduler, ReportsOverrunsAndReusesRemovedSlots)
+{
+	AiScheduler scheduler{GetVirtualTime};
+	scheduler.AddSystem({.name = "planning", .budgetMicros = 30, .parallel = false, .agingTicks = 30});
+	for (uint32_t i = 0; i < 9; i++) {
+		scheduler.AddJob({.system = 0, .priority = 0, .interval = 1}, Spend(10));
+	}
+	const AiJobId heavy = scheduler.AddJob({.system = 0, .priority = AI_PRIORITY_LEVELS - 1, .interval = 1}, Spend(200));
+	for (uint32_t tick = 0; tick < 10; tick++) {
+		scheduler.Tick();
+	}
+	EXPECT_GE(scheduler.GetStats(0).overruns, 9u);
+	EXPECT_GE(scheduler.GetStats(0).peakMicros, 200.0f);
+
+	scheduler.RemoveJob(heavy);
+	const uint64_t overruns = scheduler.GetStats(0).overruns;
+	for (uint32_t tick = 0; tick < 10; tick++) {
+		scheduler.Tick();
+	}
+	EXPECT_EQ(scheduler.GetStats(0).overruns, overruns);
+	EXPECT_FALSE(scheduler.IsAlive(heavy));
+
+	const AiJobId reused = scheduler.AddJob({.system = 0, .priority = 0, .interval = 1}, Spend(1));
+	EXPECT_TRUE(scheduler.IsAlive(reused));
+	EXPECT_EQ(reused.index, heavy.index);
+	EXPECT_NE(reused.generation, heavy.generation);
+	EXPECT_EQ(scheduler.GetStats(0).jobCount, 10u);
+
+	scheduler.ResetPeaks();
+	EXPECT_LT(scheduler.GetStats(0).peakMicros, 200.0f);
+}
@@ -0,0 +1,287 @@
+#include "anim/pose_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+
+using namespace TGW::Anim;
+
+namespace {
+constexpr uint32_t JOINT_COUNT = 64;
+constexpr float BAKE_RATE = 60.0f;
+constexpr uint32_t CLIP_COUNT = 4;
+
+// A binary tree of joints, each 0.2 above its parent
+Skeleton MakeSkeleton()
+{
+	Skeleton skeleton;
+	for (uint32_t i = 0; i < JOINT_COUNT; i++) {
+		Joint &joint = skeleton.joints.emplace_back();
+		joint.name = "joint" + std::to_string(i);
+		joint.parent = i == 0 ? JOINT_NO_PARENT : static_cast<uint16_t>((i - 1) / 2);
+		joint.bindPose.translation = {0.0f, i == 0 ? 1.0f : 0.2f, 0.0f};
+		DirectX::XMStoreFloat4x4(&joint.inverseBind, DirectX::XMMatrixIdentity());
+	}
+	return skeleton;
+}
+
+// Every joint swings about its own axis, the root bobs along, a third of the joints and every scale hold still
+AnimationClip MakeClip(uint32_t index)
+{
+	AnimationClip clip;
+	clip.name = "clip" + std::to_string(index);
+	clip.duration = 1.0f + 0.5f * index;
+	const uint32_t keyCount = static_cast<uint32_t>(clip.duration * BAKE_RATE) + 1;
+	const float frequency = DirectX::XM_2PI / clip.duration;
+	for (uint32_t joint = 0; joint < JOINT_COUNT; joint++) {
+		JointTrack &track = clip.tracks.emplace_back();
+		const DirectX::XMVECTOR axis =
+			DirectX::XMVector3Normalize(DirectX::XMVectorSet(std::sin(joint * 1.7f), 1.0f, std::cos(joint * 0.9f), 0.0f));
+		const float amplitude = joint % 3 == 2 ? 0.0f : 0.6f / (1.0f + joint % 5);
+		for (uint32_t key = 0; key < keyCount; key++) {
+			const float time = key / BAKE_RATE;
+			const float angle = amplitude * std::sin(frequency * time + joint * 0.3f);
+			DirectX::XMFLOAT4 rotation;
+			DirectX::XMStoreFloat4(&rotation, DirectX::XMQuaternionRotationAxis(axis, angle));
+			track.rotationTimes.push_back(time);
+			track.rotations.push_back(rotation);
+			track.translationTimes.push_back(time);
+			const float rise = joint == 0 ? 1.0f + 0.05f * std::sin(2.0f * frequency * time) : 0.2f;
+			track.translations.push_back({0.0f, rise, 0.0f});
+			track.scaleTimes.push_back(time);
+			track.scales.push_back({1.0f, 1.0f, 1.0f});
+		}
+	}
+	return clip;
+}
+
+float GetLargestError(const JointTransform &a, const JointTransform &b)
+{
+	// Compare rotations on the same side, q and -q are the same
+	const float dot = a.rotation.x * b.rotation.x + a.rotation.y * b.rotation.y + a.rotation.z * b.rotation.z +
+					  a.rotation.w * b.rotation.w;
+	const float sign = dot < 0.0f ? -1.0f : 1.0f;
+	return std::max({std::abs(a.rotation.x - sign * b.rotation.x), std::abs(a.rotation.y - sign * b.rotation.y),
+		std::abs(a.rotation.z - sign * b.rotation.z), std::abs(a.rotation.w - sign * b.rotation.w),
+		std::abs(a.translation.x - b.translation.x), std::abs(a.translation.y - b.translation.y),
+		std::abs(a.translation.z - b.translation.z), std::abs(a.scale.x - b.scale.x), std::abs(a.scale.y - b.scale.y),
+		std::abs(a.scale.z - b.scale.z)});
+}
+
+bool SameMatrices(std::span<const DirectX::XMFLOAT4X4> a, std::span<const DirectX::XMFLOAT4X4> b)
+{
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+} // namespace
+
+// Compressed clips have to stay close to the imported keys, between frames as well as on them. The bound is a
+// little above the tolerance for the nlerp between keys.
+TEST(CompressedClip, StaysCloseToTheImportedKeys)
+{
+	const Skeleton skeleton = MakeSkeleton();
+	std::vector<JointTransform> expected(JOINT_COUNT), found(JOINT_COUNT);
+	for (uint32_t i = 0; i < CLIP_COUNT; i++) {
+		const AnimationClip raw = MakeClip(i);
+		const CompressedClip clip = CompressClip(raw, skeleton);
+		EXPECT_EQ(clip.GetName(), raw.name);
+		EXPECT_EQ(clip.GetJointCount(), JOINT_COUNT);
+		EXPECT_FLOAT_EQ(clip.GetDuration(), raw.duration);
+		EXPECT_LT(clip.GetByteSize() * 4, raw.GetByteSize());
+
+		for (float time = 0.0f; time <= raw.duration; time += 0.0137f) {
+			raw.Sample(skeleton, time, expected);
+			clip.Sample(time, found);
+			for (uint32_t joint = 0; joint < JOINT_COUNT; joint++) {
+				ASSERT_LE(GetLargestError(expected[joint], found[joint]), 5e-3f)
+					<< raw.name << " joint " << joint << " at " << time;
+			}
+		}
+
+		// Times off the clip clamp to its ends
+		raw.Sample(skeleton, raw.duration, expected);
+		clip.Sample(raw.duration + 5.0f, found);
+		EXPECT_LE(GetLargestError(expected[1], found[1]), 5e-3f);
+		raw.Sample(skeleton, 0.0f, expected);
+		clip.Sample(-1.0f, found);
+		EXPECT_LE(GetLargestError(expected[1], found[1]), 5e-3f);
+	}
+}
+
+TEST(CompressedClip, HeldPosesCostOneKey)
+{
+	const Skeleton skeleton = MakeSkeleton();
+	AnimationClip still;
+	still.duration = 2.0f;
+	still.tracks.resize(JOINT_COUNT);
+	for (JointTrack &track : still.tracks) {
+		for (float time : {0.0f, 1.0f, 2.0f}) {
+			track.translationTimes.push_back(time);
+			track.translations.push_back({0.0f, 0.5f, 0.0f});
+		}
+	}
+	const CompressedClip clip = CompressClip(still, skeleton);
+	EXPECT_EQ(clip.GetFrameCount(), 61u);
+	// One key per channel of every joint
+	EXPECT_EQ(clip.GetKeyCount(), JOINT_COUNT * 3);
+
+	// Channels without keys hold the bind pose
+	std::vector<JointTransform> pose(JOINT_COUNT);
+	clip.Sample(0.7f, pose);
+	EXPECT_NEAR(pose[5].translation.y, 0.5f, 1e-3f);
+	EXPECT_NEAR(pose[5].rotation.w, 1.0f, 1e-3f);
+	EXPECT_NEAR(pose[5].scale.x, 1.0f, 1e-3f);
+}
+
+TEST(AnimationClip, InterpolatesAndFallsBackToTheBindPose)
+{
+	Skeleton skeleton = MakeSkeleton();
+	AnimationClip clip;
+	clip.duration = 1.0f;
+	clip.tracks.resize(2);
+	clip.tracks[0].translationTimes = {0.0f, 1.0f};
+	clip.tracks[0].translations = {{0.0f, 0.0f, 0.0f}, {2.0f, 4.0f, -6.0f}};
+	clip.tracks[0].rotationTimes = {0.0f, 1.0f};
+	clip.tracks[0].rotations = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f, -1.0f}};
+
+	std::vector<JointTransform> pose(JOINT_COUNT);
+	clip.Sample(skeleton, 0.25f, pose);
+	EXPECT_NEAR(pose[0].translation.x, 0.5f, 1e-5f);
+	EXPECT_NEAR(pose[0].translation.z, -1.5f, 1e-5f);
+	// -q is the same rotation, the blend between them stays put
+	EXPECT_NEAR(std::abs(pose[0].rotation.w), 1.0f, 1e-5f);
+	// No keys, and no track at all
+	EXPECT_FLOAT_EQ(pose[1].translation.y, 0.2f);
+	EXPECT_FLOAT_EQ(pose[10].translation.y, 0.2f);
+}
+
+TEST(Skeleton, FindJointAndBlend)
+{
+	const Skeleton skeleton = MakeSkeleton();
+	EXPECT_EQ(skeleton.FindJoint("joint7"), uint16_t{7});
+	EXPECT_FALSE(skeleton.FindJoint("missing"));
+
+	std::vector<JointTransform> a(2), b(2), out(2);
+	a[0].translation = {0.0f, 0.0f, 0.0f};
+	b[0].translation = {4.0f, 0.0f, 0.0f};
+	DirectX::XMStoreFloat4(&b[0].rotation, DirectX::XMQuaternionRotationRollPitchYaw(0.0f, 1.0f, 0.0f));
+	// The same rotation as b[0] from the other side
+	b[1].rotation = {-b[0].rotation.x, -b[0].rotation.y, -b[0].rotation.z, -b[0].rotation.w};
+	b[1].translation = b[0].translation;
+
+	BlendPoses(a, b, 0.0f, out);
+	EXPECT_FLOAT_EQ(out[0].translation.x, 0.0f);
+	EXPECT_NEAR(out[0].rotation.w, 1.0f, 1e-6f);
+	BlendPoses(a, b, 0.5f, out);
+	EXPECT_FLOAT_EQ(out[0].translation.x, 2.0f);
+	// Both halfway, neither the long way around
+	EXPECT_LE(GetLargestError(out[0], out[1]), 1e-6f);
+	EXPECT_NEAR(2.0f * std::acos(std::abs(out[1].rotation.w)), 0.5f, 1e-2f);
+	BlendPoses(a, b, 1.0f, out);
+	EXPECT_LE(GetLargestError(out[0], b[0]), 1e-6f);
+}
+
+TEST(Skeleton, SkinningMatricesChainThroughParents)
+{
+	Skeleton skeleton = MakeSkeleton();
+	std::vector<JointTransform> pose(JOINT_COUNT);
+	GetBindPose(skeleton, pose);
+	std::vector<DirectX::XMFLOAT4X4> matrices(JOINT_COUNT);
+	BuildSkinningMatrices(skeleton, pose, matrices);
+	// Joint 7 is three levels below the root: 7 -> 3 -> 1 -> 0
+	EXPECT_NEAR(matrices[7]._42, 1.0f + 3 * 0.2f, 1e-5f);
+
+	// A quarter turn about Z at the root swings the children onto -X
+	DirectX::XMStoreFloat4(&pose[0].rotation, DirectX::XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, DirectX::XM_PIDIV2));
+	BuildSkinningMatrices(skeleton, pose, matrices);
+	EXPECT_NEAR(matrices[1]._41, -0.2f, 1e-5f);
+	EXPECT_NEAR(matrices[1]._42, 1.0f, 1e-5f);
+
+	// With inverse bind matrices from the bind pose, the bind pose skins to identity
+	GetBindPose(skeleton, pose);
+	BuildSkinningMatrices(skeleton, pose, matrices);
+	for (uint32_t joint = 0; joint < JOINT_COUNT; joint++) {
+		DirectX::XMStoreFloat4x4(&skeleton.joints[joint].inverseBind,
+			DirectX::XMMatrixInverse(nullptr, DirectX::XMLoadFloat4x4(&matrices[joint])));
+	}
+	BuildSkinningMatrices(skeleton, pose, matrices);
+	for (const DirectX::XMFLOAT4X4 &matrix : matrices) {
+		for (uint32_t row = 0; row < 4; row++) {
+			for (uint32_t column = 0; column < 4; column++) {
+				ASSERT_NEAR(matrix.m[row][column], row == column ? 1.0f : 0.0f, 1e-5f);
+			}
+		}
+	}
+}
+
+TEST(PoseCache, SharesFramesAndMatchesOwnPoses)
+{
+	const Skeleton skeleton = MakeSkeleton();
+	std::vector<CompressedClip> clips;
+	for (uint32_t i = 0; i < CLIP_COUNT; i++) {
+		clips.push_back(CompressClip(MakeClip(i), skeleton));
+	}
+
+	// 500 soldiers in 8 groups marching in step
+	std::vector<AnimationInstance> crowd(500);
+	for (uint32_t i = 0; i < crowd.size(); i++) {
+		crowd[i] = {i % 8 % CLIP_COUNT, 0.13f * (i % 8)};
+	}
+	TGW::JobSystem jobs{3};
+	PoseCache cache{skeleton, clips};
+	cache.Evaluate(crowd, jobs);
+	EXPECT_EQ(cache.GetEvaluatedCount(), 8u);
+	EXPECT_EQ(cache.GetCachedCount(), 8u);
+
+	// Cached poses have to be the frame every soldier would get on its own
+	std::vector<JointTransform> pose(JOINT_COUNT);
+	std::vector<DirectX::XMFLOAT4X4> matrices(JOINT_COUNT);
+	for (uint32_t i = 0; i < crowd.size(); i++) {
+		const CompressedClip &clip = clips[crowd[i].clip];
+		clip.SampleFrame(std::round(crowd[i].time * clip.GetSampleRate()), pose);
+		BuildSkinningMatrices(skeleton, pose, matrices);
+		ASSERT_TRUE(SameMatrices(matrices, cache.GetMatrices(i))) << i;
+	}
+
+	// Nothing new to evaluate, and a full loop later the same frames come back
+	cache.Evaluate(crowd, jobs);
+	EXPECT_EQ(cache.GetEvaluatedCount(), 0u);
+	for (AnimationInstance &soldier : crowd) {
+		soldier.time += clips[soldier.clip].GetDuration();
+	}
+	cache.Evaluate(crowd, jobs);
+	EXPECT_EQ(cache.GetEvaluatedCount(), 0u);
+}
+
+TEST(PoseCache, EvictsFramesNotShown)
+{
+	const Skeleton skeleton = MakeSkeleton();
+	const std::vector<CompressedClip> clips = {CompressClip(MakeClip(0), skeleton)};
+	PoseCache cache{skeleton, clips, 4};
+	TGW::JobSystem jobs{0};
+	std::vector<AnimationInstance> walker = {{0, 0.0f}};
+	std::vector<JointTransform> pose(JOINT_COUNT);
+	std::vector<DirectX::XMFLOAT4X4> matrices(JOINT_COUNT);
+	for (uint32_t frame = 0; frame < 10; frame++) {
+		walker[0].time = frame / clips[0].GetSampleRate();
+		cache.Evaluate(walker, jobs);
+		EXPECT_EQ(cache.GetEvaluatedCount(), 1u);
+		EXPECT_LE(cache.GetCachedCount(), 4u);
+		clips[0].SampleFrame(static_cast<float>(frame), pose);
+		BuildSkinningMatrices(skeleton, pose, matrices);
+		ASSERT_TRUE(SameMatrices(matrices, cache.GetMatrices(0))) << frame;
+	}
+
+	// More frames in one tick than the capacity, the cache grows rather than share a slot
+	std::vector<AnimationInstance> crowd(8);
+	for (uint32_t i = 0; i < crowd.size(); i++) {
+		crowd[i] = {0, (20 + i) / clips[0].GetSampleRate()};
+	}
+	cache.Evaluate(crowd, jobs);
+	EXPECT_EQ(cache.GetEvaluatedCount(), 8u);
+	for (uint32_t i = 0; i < crowd.size(); i++) {
+		clips[0].SampleFrame(static_cast<float>(20 + i), pose);
+		BuildSkinningMatrices(skeleton, pose, matrices);
+		ASSERT_TRUE(SameMatrices(matrices, cache.GetMatrices(i))) << i;
+	}
+}
@@ -0,0 +1,244 @@
+#include "archive/archive_reader.h"
+#include "archive/archive_writer.h"
+#include "core/hash.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+using namespace TGW::Archive;
+
+namespace fs = std::filesystem;
+
+namespace {
+const std::string TERRAIN_PATH = "textures/terrain.png";
+const std::string NOISE_PATH = "sounds/noise.wav";
+const std::string EMPTY_PATH = "empty.txt";
+const std::string TANK_PATH = "models/tank.glb";
+
+// Slowly changing bytes over several chunks, LZ4 shrinks them well
+std::vector<uint8_t> MakeTerrain()
+{
+	std::vector<uint8_t> data(3 * CHUNK_SIZE + 1000);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<uint8_t>(i / 64 % 251);
+	}
+	return data;
+}
+
+// Random bytes LZ4 cannot shrink, stored raw
+std::vector<uint8_t> MakeNoise()
+{
+	std::mt19937 rng{7};
+	std::vector<uint8_t> data(100 * 1024);
+	for (uint8_t &byte : data) {
+		byte = static_cast<uint8_t>(rng());
+	}
+	return data;
+}
+
+std::vector<uint8_t> MakeTank() { return {'g', 'l', 'T', 'F', 2, 0, 0, 0}; }
+
+template <typename T> T Get(const std::vector<uint8_t> &bytes, uint64_t offset)
+{
+	T value;
+	std::memcpy(&value, bytes.data() + offset, sizeof(T));
+	return value;
+}
+
+template <typename T> void Set(std::vector<uint8_t> &bytes, uint64_t offset, const T &value)
+{
+	std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+// Where the chunk record of chunk c of the asset at path sits in the file
+uint64_t GetChunkRecordOffset(const std::vector<uint8_t> &bytes, std::string_view path, uint32_t c)
+{
+	const ArchiveHeader header = Get<ArchiveHeader>(bytes, 0);
+	for (uint32_t i = 0; i < header.entryCount; i++) {
+		const ArchiveEntry entry = Get<ArchiveEntry>(bytes, header.entryTableOffset + i * sizeof(ArchiveEntry));
+		if (entry.pathHash == TGW::Hash::HashPath(path)) {
+			return header.chunkTableOffset + (entry.firstChunk + c) * sizeof(ArchiveChunk);
+		}
+	}
+	ADD_FAILURE() << path;
+	return 0;
+}
+} // namespace
+
+class ArchiveTest : public testing::Test {
+  protected:
+	void SetUp() override
+	{
+		const char *test = testing::UnitTest::GetInstance()->current_test_info()->name();
+		_root = fs::temp_directory_path() / "shellshock_test_archive" / test;
+		fs::remove_all(_root);
+		fs::create_directories(_root);
+	}
+
+	void TearDown() override
+	{
+		std::error_code error;
+		fs::remove_all(_root, error);
+	}
+
+	// Packs the test assets, the tank under a spelling that normalizes to TANK_PATH
+	fs::path WriteArchive(TGW::JobSystem &jobs) const
+	{
+		ArchiveWriter writer;
+		EXPECT_TRUE(writer.Add(TERRAIN_PATH, MakeTerrain()));
+		EXPECT_TRUE(writer.Add(NOISE_PATH, MakeNoise()));
+		EXPECT_TRUE(writer.Add(EMPTY_PATH, {}));
+		EXPECT_TRUE(writer.Add("./Models\\Tank.glb", MakeTank()));
+		const fs::path path = _root / "assets.pak";
+		EXPECT_TRUE(writer.Write(path, jobs));
+		return path;
+	}
+
+	std::vector<uint8_t> ReadArchiveBytes() const
+	{
+		TGW::JobSystem jobs{0};
+		std::ifstream file{WriteArchive(jobs), std::ios::binary};
+		return {std::istreambuf_iterator<char>{file}, {}};
+	}
+
+	bool OpenBytes(const std::vector<uint8_t> &bytes) const
+	{
+		const fs::path path = _root / "patched.pak";
+		std::ofstream{path, std::ios::binary | std::ios::trunc}.write(
+			reinterpret_cast<const char *>(bytes.data()), bytes.size());
+		ArchiveReader reader;
+		return reader.Open(path);
+	}
+
+  private:
+	fs::path _root;
+};
+
+TEST_F(ArchiveTest, RoundTrips)
+{
+	TGW::JobSystem jobs{3};
+	ArchiveReader reader;
+	ASSERT_TRUE(reader.Open(WriteArchive(jobs)));
+	ASSERT_EQ(reader.GetEntries().size(), 4u);
+
+	EXPECT_EQ(reader.Read(TERRAIN_PATH, jobs), MakeTerrain());
+	EXPECT_EQ(reader.Read(NOISE_PATH, jobs), MakeNoise());
+	EXPECT_EQ(reader.Read(EMPTY_PATH, jobs), std::vector<uint8_t>{});
+	EXPECT_EQ(reader.Read(TANK_PATH, jobs), MakeTank());
+	// Lookups normalize like Add did
+	EXPECT_EQ(reader.Read("Textures\\Terrain.PNG", jobs), MakeTerrain());
+	EXPECT_FALSE(reader.Read("textures/missing.png", jobs));
+
+	const ArchiveEntry *terrain = reader.Find(TERRAIN_PATH);
+	ASSERT_NE(terrain, nullptr);
+	EXPECT_EQ(terrain->chunkCount, 4u);
+	EXPECT_EQ(terrain->loadOrder, 0u);
+	EXPECT_EQ(reader.GetName(*terrain), TERRAIN_PATH);
+	EXPECT_EQ(reader.GetName(*reader.Find(TANK_PATH)), TANK_PATH);
+	EXPECT_EQ(reader.Find(EMPTY_PATH)->chunkCount, 0u);
+	EXPECT_LT(reader.GetFileSize(), MakeTerrain().size());
+}
+
+TEST_F(ArchiveTest, StoresIncompressibleChunksRaw)
+{
+	const std::vector<uint8_t> bytes = ReadArchiveBytes();
+	const ArchiveChunk noise = Get<ArchiveChunk>(bytes, GetChunkRecordOffset(bytes, NOISE_PATH, 0));
+	EXPECT_EQ(noise.storedSize, noise.size);
+	EXPECT_EQ(noise.size, MakeNoise().size());
+	const ArchiveChunk terrain = Get<ArchiveChunk>(bytes, GetChunkRecordOffset(bytes, TERRAIN_PATH, 1));
+	EXPECT_EQ(terrain.size, CHUNK_SIZE);
+	EXPECT_LT(terrain.storedSize, terrain.size);
+}
+
+TEST_F(ArchiveTest, ReadBatchMatchesRead)
+{
+	TGW::JobSystem jobs{3};
+	ArchiveReader reader;
+	ASSERT_TRUE(reader.Open(WriteArchive(jobs)));
+	const std::vector<std::string> paths = {
+		TANK_PATH, "missing.png", TERRAIN_PATH, EMPTY_PATH, NOISE_PATH, TERRAIN_PATH, "models/missing.glb"};
+	const auto results = reader.ReadBatch(paths, jobs);
+	ASSERT_EQ(results.size(), paths.size());
+	for (size_t i = 0; i < paths.size(); i++) {
+		EXPECT_EQ(results[i], reader.Read(paths[i], jobs)) << paths[i];
+	}
+	EXPECT_FALSE(results[1]);
+	EXPECT_FALSE(results[6]);
+	EXPECT_TRUE(reader.ReadBatch({}, jobs).empty());
+}
+
+TEST(ArchiveWriter, RejectsDuplicatePaths)
+{
+	ArchiveWriter writer;
+	EXPECT_TRUE(writer.Add(TERRAIN_PATH, MakeTank()));
+	EXPECT_FALSE(writer.Add(TERRAIN_PATH, MakeTank()));
+	EXPECT_FALSE(writer.Add("Textures\\Terrain.png", MakeTank()));
+	EXPECT_FALSE(writer.Add("./textures//terrain.png", MakeTank()));
+	EXPECT_TRUE(writer.Add("textures/terrain_n.png", MakeTank()));
+	EXPECT_EQ(writer.GetAssetCount(), 2u);
+}
+
+TEST_F(ArchiveTest, RejectsBadHeaders)
+{
+	const std::vector<uint8_t> bytes = ReadArchiveBytes();
+	ASSERT_TRUE(OpenBytes(bytes));
+
+	std::vector<uint8_t> patched = bytes;
+	Set(patched, offsetof(ArchiveHeader, magic), ARCHIVE_MAGIC + 1);
+	EXPECT_FALSE(OpenBytes(patched));
+
+	patched = bytes;
+	Set(patched, offsetof(ArchiveHeader, version), ARCHIVE_VERSION + 1);
+	EXPECT_FALSE(OpenBytes(patched));
+
+	EXPECT_FALSE(OpenBytes({bytes.begin(), bytes.begin() + sizeof(ArchiveHeader) - 1}));
+}
+
+TEST_F(ArchiveTest, RejectsTruncatedTables)
+{
+	const std::vector<uint8_t> bytes = ReadArchiveBytes();
+	const ArchiveHeader header = Get<ArchiveHeader>(bytes, 0);
+	// Into the string, entry and chunk tables
+	for (const uint64_t size : {bytes.size() - 1, header.stringTableOffset - 1, header.entryTableOffset - 1}) {
+		EXPECT_FALSE(OpenBytes({bytes.begin(), bytes.begin() + size})) << size;
+	}
+
+	// Offsets close to UINT64_MAX must not wrap around into the file
+	std::vector<uint8_t> patched = bytes;
+	Set(patched, offsetof(ArchiveHeader, chunkTableOffset), UINT64_MAX - 7);
+	EXPECT_FALSE(OpenBytes(patched));
+	patched = bytes;
+	Set(patched, offsetof(ArchiveHeader, stringTableSize), UINT64_MAX - header.stringTableOffset + 1);
+	EXPECT_FALSE(OpenBytes(patched));
+	patched = bytes;
+	Set(patched, GetChunkRecordOffset(bytes, TERRAIN_PATH, 0) + offsetof(ArchiveChunk, offset), UINT64_MAX - 15);
+	EXPECT_FALSE(OpenBytes(patched));
+}
+
+TEST_F(ArchiveTest, RejectsMisalignedTables)
+{
+	const std::vector<uint8_t> bytes = ReadArchiveBytes();
+	const ArchiveHeader header = Get<ArchiveHeader>(bytes, 0);
+	std::vector<uint8_t> patched = bytes;
+	Set(patched, offsetof(ArchiveHeader, chunkTableOffset), header.chunkTableOffset - 4);
+	EXPECT_FALSE(OpenBytes(patched));
+	patched = bytes;
+	Set(patched, offsetof(ArchiveHeader, entryTableOffset), header.entryTableOffset - 4);
+	EXPECT_FALSE(OpenBytes(patched));
+}
+
+// Readers put chunk i at i * CHUNK_SIZE, a short chunk before the last would leave a gap even when the sizes add up
+TEST_F(ArchiveTest, RejectsShortChunksInsideAnAsset)
+{
+	const std::vector<uint8_t> bytes = ReadArchiveBytes();
+	std::vector<uint8_t> patched = bytes;
+	const uint64_t middle = GetChunkRecordOffset(bytes, TERRAIN_PATH, 1) + offsetof(ArchiveChunk, size);
+	const uint64_t last = GetChunkRecordOffset(bytes, TERRAIN_PATH, 3) + offsetof(ArchiveChunk, size);
+	Set(patched, middle, CHUNK_SIZE - 1);
+	Set(patched, last, Get<uint32_t>(bytes, last) + 1);
+	EXPECT_FALSE(OpenBytes(patched));
+}
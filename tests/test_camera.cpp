@@ -0,0 +1,68 @@
+#include "camera.h"
+
+#include <gtest/gtest.h>
+
+using namespace DirectX;
+
+TEST(Camera, ZoomStaysInRange)
+{
+	Camera camera;
+	const float start = camera.GetZoom();
+	camera.HandleZoom(120);
+	EXPECT_LT(camera.GetZoom(), start);
+
+	for (int i = 0; i < 20; i++) {
+		camera.HandleZoom(120);
+	}
+	EXPECT_FLOAT_EQ(camera.GetZoom(), 5.0f);
+	for (int i = 0; i < 20; i++) {
+		camera.HandleZoom(-120);
+	}
+	EXPECT_FLOAT_EQ(camera.GetZoom(), 15.0f);
+
+	camera.SetView(XMVectorZero(), XMVectorSet(0.0f, -1.0f, 1.0f, 0.0f), 100.0f);
+	EXPECT_FLOAT_EQ(camera.GetZoom(), 15.0f);
+}
+
+TEST(Camera, OrbitKeepsForwardUnitLength)
+{
+	Camera camera;
+	const float pitch = XMVectorGetY(camera.GetForward());
+	for (int i = 0; i < 1000; i++) {
+		camera.Orbit(37.0f);
+	}
+	EXPECT_NEAR(XMVectorGetX(XMVector3Length(camera.GetForward())), 1.0f, 1e-4f);
+	// Orbiting turns around the vertical axis only
+	EXPECT_NEAR(XMVectorGetY(camera.GetForward()), pitch, 1e-4f);
+}
+
+TEST(Camera, PanMovesOnTheGround)
+{
+	Camera camera;
+	camera.SetView(XMVectorZero(), XMVectorSet(0.0f, -1.0f, 1.0f, 0.0f), 10.0f);
+	camera.Pan(0, 1);
+	EXPECT_NEAR(XMVectorGetX(camera.GetTarget()), 0.0f, 1e-6f);
+	EXPECT_FLOAT_EQ(XMVectorGetY(camera.GetTarget()), 0.0f);
+	EXPECT_GT(XMVectorGetZ(camera.GetTarget()), 0.0f);
+
+	camera.Pan(0, -1);
+	camera.Pan(1, 0);
+	EXPECT_GT(XMVectorGetX(camera.GetTarget()), 0.0f);
+	EXPECT_NEAR(XMVectorGetZ(camera.GetTarget()), 0.0f, 1e-6f);
+}
+
+TEST(Camera, ScreenCentreHitsTheTarget)
+{
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	camera.SetView(XMVectorSet(12.0f, 0.0f, -7.0f, 0.0f), XMVectorSet(1.0f, -1.0f, 1.0f, 0.0f), 10.0f);
+	const std::optional<XMFLOAT2> hit = camera.ScreenToGround(960.0f, 540.0f, 1920.0f, 1080.0f);
+	ASSERT_TRUE(hit);
+	EXPECT_NEAR(hit->x, 12.0f, 1e-3f);
+	EXPECT_NEAR(hit->y, -7.0f, 1e-3f);
+
+	// Looking level, the ray through the top of the screen never comes down
+	camera.SetView(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), 10.0f);
+	EXPECT_FALSE(camera.ScreenToGround(960.0f, 0.0f, 1920.0f, 1080.0f));
+	EXPECT_FALSE(camera.ScreenToGround(0.0f, 0.0f, 0.0f, 0.0f));
+}
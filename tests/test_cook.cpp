@@ -0,0 +1,146 @@
+#include "cook/batch_cooker.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint32_t MODEL_COUNT = 6;
+constexpr uint32_t TEXTURE_COUNT = 4;
+
+bool WriteText(const fs::path &path, std::string_view text)
+{
+	std::ofstream file{path, std::ios::binary | std::ios::trunc};
+	return static_cast<bool>(file.write(text.data(), text.size()));
+}
+
+std::string MakeMtl(uint32_t model, std::string_view extra = {})
+{
+	return "newmtl main\nmap_Kd ../textures/texture_" + std::to_string(model % TEXTURE_COUNT) +
+		   ".png\nmap_Bump ../textures/texture_" + std::to_string((model + 1) % TEXTURE_COUNT) + ".png\n" +
+		   std::string{extra};
+}
+
+// A few quads with their own .mtl, sharing a small texture pool
+class BatchCookerTest : public testing::Test {
+  protected:
+	void SetUp() override
+	{
+		const char *test = testing::UnitTest::GetInstance()->current_test_info()->name();
+		_root = fs::temp_directory_path() / "shellshock_test_cook" / test;
+		fs::remove_all(_root);
+		fs::create_directories(GetContent() / "models");
+		fs::create_directories(GetContent() / "textures");
+		for (uint32_t i = 0; i < MODEL_COUNT; i++) {
+			const std::string name = "model_" + std::to_string(i);
+			const std::string obj = "mtllib " + name + ".mtl\nusemtl main\nv 0 0 0\nv 1 0 0\nv 0 0 " + std::to_string(i + 1) +
+									"\nvt 0 0\nvt 1 0\nvt 0 1\nf 1/1 2/2 3/3\n";
+			ASSERT_TRUE(WriteText(GetContent() / "models" / (name + ".obj"), obj));
+			ASSERT_TRUE(WriteText(GetContent() / "models" / (name + ".mtl"), MakeMtl(i)));
+		}
+		for (uint32_t i = 0; i < TEXTURE_COUNT; i++) {
+			ASSERT_TRUE(WriteText(GetTexture(i), "texture " + std::to_string(i)));
+		}
+	}
+
+	void TearDown() override
+	{
+		std::error_code error;
+		fs::remove_all(_root, error);
+	}
+
+	fs::path GetContent() const { return _root / "content"; }
+	fs::path GetOutput() const { return _root / "cooked"; }
+	fs::path GetTexture(uint32_t texture) const
+	{
+		return GetContent() / "textures" / ("texture_" + std::to_string(texture) + ".png");
+	}
+
+	TGW::Cook::CookStats Cook(TGW::Cook::CookSettings settings = {}) const
+	{
+		TGW::JobSystem jobs{2};
+		return TGW::Cook::BatchCooker{GetContent(), GetOutput(), settings}.Run(jobs);
+	}
+
+  private:
+	fs::path _root;
+};
+} // namespace
+
+TEST_F(BatchCookerTest, FullCookCooksEverything)
+{
+	const TGW::Cook::CookStats stats = Cook();
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.models, MODEL_COUNT);
+	EXPECT_EQ(stats.textures, TEXTURE_COUNT);
+	EXPECT_EQ(stats.cooked, MODEL_COUNT + TEXTURE_COUNT);
+	EXPECT_EQ(stats.cacheHits, 0u);
+	EXPECT_EQ(stats.upToDate, 0u);
+}
+
+TEST_F(BatchCookerTest, NoOpCookRebuildsNothing)
+{
+	ASSERT_TRUE(Cook().errors.empty());
+	const TGW::Cook::CookStats stats = Cook();
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.cooked, 0u);
+	EXPECT_EQ(stats.upToDate, MODEL_COUNT + TEXTURE_COUNT);
+}
+
+// The models point at the texture by path and their own inputs did not change
+TEST_F(BatchCookerTest, TextureChangeRebuildsOnlyTheTexture)
+{
+	ASSERT_TRUE(Cook().errors.empty());
+	ASSERT_TRUE(WriteText(GetTexture(0), "texture 0, repainted"));
+	const TGW::Cook::CookStats stats = Cook();
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.cooked, 1u);
+	EXPECT_EQ(stats.cacheHits, 0u);
+	EXPECT_EQ(stats.upToDate, MODEL_COUNT + TEXTURE_COUNT - 1);
+}
+
+TEST_F(BatchCookerTest, MaterialChangeRebuildsOnlyItsModel)
+{
+	ASSERT_TRUE(Cook().errors.empty());
+	ASSERT_TRUE(WriteText(GetContent() / "models" / "model_0.mtl", MakeMtl(0, "# edited\n")));
+	const TGW::Cook::CookStats stats = Cook();
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.cooked, 1u);
+	EXPECT_EQ(stats.cacheHits, 0u);
+	EXPECT_EQ(stats.upToDate, MODEL_COUNT + TEXTURE_COUNT - 1);
+}
+
+// Going back to content cooked before restores the output from the cache
+TEST_F(BatchCookerTest, RevertedInputComesFromTheCache)
+{
+	ASSERT_TRUE(Cook().errors.empty());
+	ASSERT_TRUE(WriteText(GetTexture(1), "texture 1, repainted"));
+	ASSERT_EQ(Cook().cooked, 1u);
+	ASSERT_TRUE(WriteText(GetTexture(1), "texture 1"));
+	const TGW::Cook::CookStats stats = Cook();
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.cooked, 0u);
+	EXPECT_EQ(stats.cacheHits, 1u);
+}
+
+TEST_F(BatchCookerTest, DeletedOutputIsRestored)
+{
+	ASSERT_TRUE(Cook().errors.empty());
+	const fs::path output = GetOutput() / "models" / ("model_2.obj" + std::string{TGW::Cook::COOKED_MODEL_EXTENSION});
+	ASSERT_TRUE(fs::exists(output));
+	fs::remove(output);
+	const TGW::Cook::CookStats stats = Cook();
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.cooked + stats.cacheHits, 1u);
+	EXPECT_TRUE(fs::exists(output));
+}
+
+TEST_F(BatchCookerTest, ForceCooksEverythingAgain)
+{
+	ASSERT_TRUE(Cook().errors.empty());
+	const TGW::Cook::CookStats stats = Cook({.importFlags = MODEL_IMPORT_FLAGS, .force = true});
+	EXPECT_TRUE(stats.errors.empty());
+	EXPECT_EQ(stats.cooked, MODEL_COUNT + TEXTURE_COUNT);
+}
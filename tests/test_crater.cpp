@@ -0,0 +1,213 @@
+#include "sim/terrain_costs.h"
+#include "terrain/deformation.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+using namespace TGW::Terrain;
+
+namespace {
+constexpr uint32_t MAP_SAMPLES = 513;
+constexpr float COST_CELL_SIZE = 2.0f;
+
+Heightmap MakeHills()
+{
+	std::vector<float> heights(size_t{MAP_SAMPLES} * MAP_SAMPLES);
+	for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+		for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+			heights[size_t{z} * MAP_SAMPLES + x] = 20.0f * std::sin(x * 0.01f) * std::cos(z * 0.013f);
+		}
+	}
+	return {MAP_SAMPLES, MAP_SAMPLES, 1.0f, {0.0f, 0.0f}, std::move(heights)};
+}
+
+TGW::Sim::CostGrid MakeCostGrid(const Heightmap &heightmap)
+{
+	const uint32_t cells = static_cast<uint32_t>(heightmap.GetSize().x / COST_CELL_SIZE);
+	TGW::Sim::CostGrid costs{cells, cells, COST_CELL_SIZE, heightmap.GetOrigin()};
+	const SampleRect all{0, 0, heightmap.GetWidth(), heightmap.GetHeight()};
+	TGW::Sim::ApplyTerrainSlope(heightmap, {&all, 1}, costs);
+	return costs;
+}
+
+// 200 shells on a 300 m target area, some of them hanging off the map's west edge
+std::vector<Crater> MakeBarrage()
+{
+	std::mt19937 rng{5};
+	std::uniform_real_distribution<float> x{-20.0f, 300.0f}, z{100.0f, 400.0f};
+	std::uniform_real_distribution<float> radius{2.0f, 8.0f};
+	std::vector<Crater> craters;
+	for (uint32_t i = 0; i < 200; i++) {
+		const float r = radius(rng);
+		craters.push_back({{x(rng), z(rng)}, r, r * 0.4f, r * 0.1f});
+	}
+	return craters;
+}
+
+// Dirty rects are disjoint, stay on the map and hold every changed sample
+void ExpectDirtyRectsCoverChanges(const Heightmap &original, const Heightmap &shelled, std::span<const SampleRect> dirty)
+{
+	for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+		for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+			const uint32_t count = static_cast<uint32_t>(std::ranges::count_if(dirty, [&](const SampleRect &rect) {
+				return x >= rect.minX && x < rect.maxX && z >= rect.minZ && z < rect.maxZ;
+			}));
+			ASSERT_LE(count, 1u);
+			if (shelled.GetSample(x, z) != original.GetSample(x, z)) {
+				ASSERT_EQ(count, 1u) << x << ", " << z;
+			}
+		}
+	}
+	for (const SampleRect &rect : dirty) {
+		EXPECT_LE(rect.maxX, MAP_SAMPLES);
+		EXPECT_LE(rect.maxZ, MAP_SAMPLES);
+	}
+}
+
+std::vector<SampleRect>
+Shell(Heightmap &heightmap, Quadtree *quadtree, std::span<const Crater> craters, TGW::JobSystem &jobs)
+{
+	CraterBatch batch;
+	for (const Crater &crater : craters) {
+		batch.Add(crater);
+	}
+	EXPECT_EQ(batch.GetCount(), craters.size());
+	const std::vector<SampleRect> dirty = batch.Apply(heightmap, quadtree, jobs);
+	EXPECT_TRUE(batch.IsEmpty());
+	return dirty;
+}
+} // namespace
+
+TEST(Crater, Profile)
+{
+	const Crater crater{{0.0f, 0.0f}, 4.0f, 2.0f, 0.5f};
+	EXPECT_FLOAT_EQ(GetCraterOffset(crater, 0.0f, 0.0f), -2.0f);
+	EXPECT_FLOAT_EQ(GetCraterOffset(crater, 4.0f, 0.0f), 0.5f);
+	EXPECT_NEAR(GetCraterOffset(crater, 0.0f, 3.9999f), 0.5f, 1e-3f);
+	EXPECT_FLOAT_EQ(GetCraterOffset(crater, 0.0f, -4.0f * CRATER_RIM_EXTENT), 0.0f);
+	EXPECT_FLOAT_EQ(GetCraterOffset(crater, 100.0f, 0.0f), 0.0f);
+	// Falls from the rim down to the ground
+	EXPECT_GT(GetCraterOffset(crater, 4.5f, 0.0f), GetCraterOffset(crater, 5.5f, 0.0f));
+	EXPECT_GT(GetCraterOffset(crater, 5.5f, 0.0f), 0.0f);
+}
+
+TEST(Crater, RectCoversTheReachAndClamps)
+{
+	const Heightmap hills = MakeHills();
+	const SampleRect rect = GetCraterRect(hills, {{100.0f, 200.0f}, 4.0f, 1.0f, 0.1f});
+	EXPECT_EQ(rect.minX, 94u);
+	EXPECT_EQ(rect.maxX, 107u);
+	EXPECT_EQ(rect.minZ, 194u);
+	EXPECT_EQ(rect.maxZ, 207u);
+
+	const SampleRect edge = GetCraterRect(hills, {{-2.0f, 512.0f}, 4.0f, 1.0f, 0.1f});
+	EXPECT_EQ(edge.minX, 0u);
+	EXPECT_EQ(edge.maxZ, MAP_SAMPLES);
+	EXPECT_TRUE(GetCraterRect(hills, {{-100.0f, 0.0f}, 4.0f, 1.0f, 0.1f}).IsEmpty());
+	EXPECT_TRUE(GetCraterRect(hills, {{10.0f, 10.0f}, 0.0f, 1.0f, 0.1f}).IsEmpty());
+	EXPECT_TRUE(GetCraterRect(hills, {{10.0f, 10.0f}, std::nanf(""), 1.0f, 0.1f}).IsEmpty());
+}
+
+TEST(CraterBatch, MatchesCratersOneByOne)
+{
+	TGW::JobSystem jobs{3};
+	const std::vector<Crater> craters = MakeBarrage();
+	const Heightmap original = MakeHills();
+	Heightmap batched = original, oneByOne = original;
+	const std::vector<SampleRect> dirty = Shell(batched, nullptr, craters, jobs);
+	for (const Crater &crater : craters) {
+		Shell(oneByOne, nullptr, {&crater, 1}, jobs);
+	}
+	ASSERT_EQ(batched.GetSamples(), oneByOne.GetSamples());
+
+	// Every sample a crater reaches, and only those, is offset by the craters in order
+	std::vector<float> expected = original.GetSamples();
+	for (const Crater &crater : craters) {
+		const SampleRect rect = GetCraterRect(original, crater);
+		for (uint32_t z = rect.minZ; z < rect.maxZ; z++) {
+			for (uint32_t x = rect.minX; x < rect.maxX; x++) {
+				expected[size_t{z} * MAP_SAMPLES + x] += GetCraterOffset(crater, x - crater.center.x, z - crater.center.y);
+			}
+		}
+	}
+	EXPECT_EQ(batched.GetSamples(), expected);
+
+	ExpectDirtyRectsCoverChanges(original, batched, dirty);
+
+	const auto [low, high] = std::minmax_element(expected.begin(), expected.end());
+	EXPECT_LE(batched.GetMinHeight(), *low);
+	EXPECT_GE(batched.GetMaxHeight(), *high);
+}
+
+// A run of dirty tiles ending at the east edge stops there, the first tile of the next row starts a rect of its own
+TEST(CraterBatch, RunsEndAtTheEastEdge)
+{
+	TGW::JobSystem jobs{3};
+	const Heightmap original = MakeHills();
+	Heightmap shelled = original;
+	const Crater craters[] = {{{511.0f, 80.0f}, 4.0f, 2.0f, 0.5f}, {{2.0f, 110.0f}, 4.0f, 2.0f, 0.5f}};
+	const std::vector<SampleRect> dirty = Shell(shelled, nullptr, craters, jobs);
+	EXPECT_EQ(dirty.size(), 2u);
+	ExpectDirtyRectsCoverChanges(original, shelled, dirty);
+}
+
+TEST(CraterBatch, SameOnOneThread)
+{
+	TGW::JobSystem serial{0}, workers{3};
+	const std::vector<Crater> craters = MakeBarrage();
+	Heightmap a = MakeHills(), b = MakeHills();
+	Shell(a, nullptr, craters, serial);
+	Shell(b, nullptr, craters, workers);
+	EXPECT_EQ(a.GetSamples(), b.GetSamples());
+
+	CraterBatch empty;
+	EXPECT_TRUE(empty.Apply(a, nullptr, serial).empty());
+}
+
+TEST(CraterBatch, QuadtreeAndCostsMatchARebuild)
+{
+	TGW::JobSystem jobs{3};
+	Heightmap hills = MakeHills();
+	Quadtree quadtree{hills};
+	TGW::Sim::CostGrid costs = MakeCostGrid(hills);
+	const TGW::Sim::CostGrid before = costs;
+
+	const std::vector<SampleRect> dirty = Shell(hills, &quadtree, MakeBarrage(), jobs);
+	const std::vector<TGW::Sim::CellRect> changed = TGW::Sim::ApplyTerrainSlope(hills, dirty, costs);
+
+	// Eyes down in the craters, where the refreshed height ranges decide the LODs
+	const Quadtree fresh{hills};
+	std::vector<TerrainChunk> updatedChunks, freshChunks;
+	for (const float height : {-20.0f, -8.0f, 0.0f, 8.0f}) {
+		const DirectX::XMFLOAT3 eye{150.0f, height, 250.0f};
+		quadtree.Select(eye, updatedChunks);
+		fresh.Select(eye, freshChunks);
+		ASSERT_EQ(updatedChunks.size(), freshChunks.size());
+		for (size_t i = 0; i < freshChunks.size(); i++) {
+			EXPECT_EQ(updatedChunks[i].origin.x, freshChunks[i].origin.x);
+			EXPECT_EQ(updatedChunks[i].origin.y, freshChunks[i].origin.y);
+			EXPECT_EQ(updatedChunks[i].lod, freshChunks[i].lod);
+			EXPECT_EQ(updatedChunks[i].quadrants, freshChunks[i].quadrants);
+		}
+	}
+
+	// Repricing under the dirty rects ends where pricing the whole map would, and reports what it changed
+	const TGW::Sim::CostGrid rebuilt = MakeCostGrid(hills);
+	const uint32_t cells = costs.GetWidth();
+	ASSERT_TRUE(std::equal(rebuilt.GetCosts(), rebuilt.GetCosts() + cells * cells, costs.GetCosts()));
+	uint32_t repriced = 0;
+	for (uint32_t z = 0; z < cells; z++) {
+		for (uint32_t x = 0; x < cells; x++) {
+			if (costs.GetCost({x, z}) == before.GetCost({x, z})) {
+				continue;
+			}
+			repriced++;
+			EXPECT_TRUE(std::ranges::any_of(changed, [&](const TGW::Sim::CellRect &rect) {
+				return x >= rect.minX && x < rect.maxX && z >= rect.minZ && z < rect.maxZ;
+			})) << x << ", " << z;
+		}
+	}
+	EXPECT_GT(repriced, 0u);
+}
@@ -0,0 +1,228 @@
+#include "sim/flow_field.h"
+
+#include <gtest/gtest.h>
+
+#include <queue>
+#include <random>
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t MAP_SIZE = 256;
+constexpr uint32_t ROOM_SIZE = 32;
+constexpr uint32_t DOOR_WIDTH = 4;
+constexpr uint32_t RUBBLE_PER_ROOM = 6;
+constexpr uint32_t MAP_SEED = 7;
+
+// Square rooms with a door in every wall and some rubble inside, the same shape bench_flow_field times
+CostGrid MakeRoomsMap()
+{
+	std::mt19937 rng{MAP_SEED};
+	std::uniform_int_distribution<uint32_t> door{1, ROOM_SIZE - DOOR_WIDTH - 1};
+	std::uniform_int_distribution<uint32_t> inside{2, ROOM_SIZE - 4};
+	std::uniform_int_distribution<uint32_t> cost{1, 4};
+
+	CostGrid grid{MAP_SIZE, MAP_SIZE};
+	for (uint32_t wall = ROOM_SIZE; wall < MAP_SIZE; wall += ROOM_SIZE) {
+		grid.Fill({wall, 0, wall + 1, MAP_SIZE}, COST_BLOCKED);
+		grid.Fill({0, wall, MAP_SIZE, wall + 1}, COST_BLOCKED);
+	}
+	for (uint32_t roomZ = 0; roomZ < MAP_SIZE; roomZ += ROOM_SIZE) {
+		for (uint32_t roomX = 0; roomX < MAP_SIZE; roomX += ROOM_SIZE) {
+			const uint32_t east = roomZ + door(rng), north = roomX + door(rng);
+			grid.Fill({roomX + ROOM_SIZE, east, roomX + ROOM_SIZE + 1, east + DOOR_WIDTH}, COST_DEFAULT);
+			grid.Fill({north, roomZ + ROOM_SIZE, north + DOOR_WIDTH, roomZ + ROOM_SIZE + 1}, COST_DEFAULT);
+			for (uint32_t i = 0; i < RUBBLE_PER_ROOM; i++) {
+				const uint32_t x = roomX + inside(rng), z = roomZ + inside(rng);
+				grid.Fill({x, z, x + 2, z + 2}, i % 2 ? COST_BLOCKED : static_cast<uint8_t>(cost(rng)));
+			}
+		}
+	}
+	return grid;
+}
+
+const Cell GOAL{MAP_SIZE - 4, 4};
+const std::vector<Cell> STARTS = {{2, 2}, {4, 2}, {2, 6}, {6, 6}};
+
+// Plain Dijkstra over the whole grid with the same step rules, the reference for the integration field
+std::vector<uint32_t> GetCostsToGoal(const CostGrid &grid, Cell goal)
+{
+	std::vector<uint32_t> costs(grid.GetWidth() * grid.GetHeight(), FLOW_UNREACHABLE);
+	using Item = std::pair<uint32_t, uint32_t>;
+	std::priority_queue<Item, std::vector<Item>, std::greater<>> open;
+	costs[goal.z * grid.GetWidth() + goal.x] = 0;
+	open.push({0, goal.z * grid.GetWidth() + goal.x});
+	while (!open.empty()) {
+		const auto [cost, index] = open.top();
+		open.pop();
+		if (cost != costs[index]) {
+			continue;
+		}
+		const Cell cell{index % grid.GetWidth(), index / grid.GetWidth()};
+		for (uint32_t direction = 0; direction < GRID_DIRECTION_COUNT; direction++) {
+			if (!grid.CanStep(cell, direction)) {
+				continue;
+			}
+			const Cell neighbour{cell.x + GRID_STEP_X[direction], cell.z + GRID_STEP_Z[direction]};
+			const uint32_t next = neighbour.z * grid.GetWidth() + neighbour.x;
+			const uint32_t total = cost + grid.GetStepCost(neighbour, direction);
+			if (total < costs[next]) {
+				costs[next] = total;
+				open.push({total, next});
+			}
+		}
+	}
+	return costs;
+}
+
+// Follows the directions from cell and returns whether they end on the goal, each step strictly downhill
+bool ReachesGoal(const FlowField &field, Cell cell)
+{
+	for (uint32_t steps = 0; !(cell == field.GetGoal()); steps++) {
+		const FlowDirection direction = field.GetDirection(cell);
+		if (direction == FLOW_DIRECTION_NONE || steps > MAP_SIZE * MAP_SIZE) {
+			return false;
+		}
+		const Cell next{cell.x + GRID_STEP_X[direction], cell.z + GRID_STEP_Z[direction]};
+		if (field.GetIntegration(next) >= field.GetIntegration(cell)) {
+			return false;
+		}
+		cell = next;
+	}
+	return true;
+}
+} // namespace
+
+TEST(FlowField, FullFieldMatchesDijkstra)
+{
+	const CostGrid grid = MakeRoomsMap();
+	const SectorGraph sectors{grid};
+	FlowField field;
+	TGW::JobSystem jobs{3};
+	ASSERT_TRUE(field.Build(grid, sectors, GOAL, {}, jobs));
+	EXPECT_EQ(field.GetCoveredSectorCount(), sectors.GetSectorCount());
+
+	const std::vector<uint32_t> costs = GetCostsToGoal(grid, GOAL);
+	for (uint32_t z = 0; z < MAP_SIZE; z++) {
+		for (uint32_t x = 0; x < MAP_SIZE; x++) {
+			const uint32_t expected = costs[z * MAP_SIZE + x];
+			ASSERT_EQ(field.GetIntegration({x, z}), expected) << x << ", " << z;
+			if (expected != FLOW_UNREACHABLE && expected != 0) {
+				ASSERT_TRUE(ReachesGoal(field, {x, z})) << x << ", " << z;
+			}
+		}
+	}
+	EXPECT_EQ(field.GetDirection(GOAL), FLOW_DIRECTION_NONE);
+}
+
+TEST(FlowField, CorridorCoversTheRoute)
+{
+	const CostGrid grid = MakeRoomsMap();
+	const SectorGraph sectors{grid};
+	FlowField field;
+	ASSERT_TRUE(field.Build(grid, sectors, GOAL, STARTS));
+	EXPECT_LT(field.GetCoveredSectorCount(), sectors.GetSectorCount());
+
+	const std::vector<uint32_t> costs = GetCostsToGoal(grid, GOAL);
+	for (const Cell start : STARTS) {
+		EXPECT_TRUE(ReachesGoal(field, start));
+		// The corridor follows the fewest sector hops, which may cost a little over the best route
+		const uint32_t best = costs[start.z * MAP_SIZE + start.x];
+		EXPECT_GE(field.GetIntegration(start), best);
+		EXPECT_LE(field.GetIntegration(start), best + best / 10);
+	}
+	EXPECT_EQ(field.GetIntegration({0, MAP_SIZE - 1}), FLOW_UNREACHABLE);
+}
+
+TEST(FlowField, ExtendAddsNewStarts)
+{
+	const CostGrid grid = MakeRoomsMap();
+	const SectorGraph sectors{grid};
+	FlowField field;
+	ASSERT_TRUE(field.Build(grid, sectors, GOAL, STARTS));
+	const Cell late{2, MAP_SIZE - 3};
+	ASSERT_FALSE(field.Covers(late));
+
+	FlowField extended;
+	const Cell starts[] = {late};
+	ASSERT_TRUE(extended.Extend(grid, sectors, field, starts));
+	EXPECT_TRUE(ReachesGoal(extended, late));
+	for (const Cell start : STARTS) {
+		EXPECT_TRUE(ReachesGoal(extended, start));
+	}
+}
+
+TEST(FlowField, RejectsBlockedGoal)
+{
+	CostGrid grid{64, 64};
+	grid.SetCost({10, 10}, COST_BLOCKED);
+	FlowField field;
+	EXPECT_FALSE(field.Build(grid, SectorGraph{grid}, {10, 10}, {}));
+	EXPECT_FALSE(field.Build(grid, SectorGraph{grid}, {64, 10}, {}));
+}
+
+TEST(FlowField, SampleIsUnitLengthTowardsTheGoal)
+{
+	const CostGrid grid{64, 64};
+	FlowField field;
+	ASSERT_TRUE(field.Build(grid, SectorGraph{grid}, {60, 10}, {}));
+	const std::optional<DirectX::XMFLOAT2> direction = field.Sample({10.5f, 10.5f});
+	ASSERT_TRUE(direction);
+	EXPECT_NEAR(std::hypot(direction->x, direction->y), 1.0f, 1e-4f);
+	EXPECT_GT(direction->x, 0.99f);
+
+	const std::optional<DirectX::XMFLOAT2> atGoal = field.Sample({60.5f, 10.5f});
+	ASSERT_TRUE(atGoal);
+	EXPECT_EQ(atGoal->x, 0.0f);
+	EXPECT_FALSE(field.Sample({-5.0f, 10.0f}));
+}
+
+TEST(FlowFieldCache, ReusesAndInvalidates)
+{
+	CostGrid grid = MakeRoomsMap();
+	FlowFieldCache cache{grid};
+	const std::shared_ptr<const FlowField> first = cache.Get(GOAL, STARTS);
+	ASSERT_TRUE(first);
+	EXPECT_EQ(cache.Get(GOAL, STARTS), first);
+	EXPECT_EQ(cache.GetHits(), 1u);
+	EXPECT_EQ(cache.GetMisses(), 1u);
+
+	// A change away from the field keeps it, one inside drops it
+	const CellRect away{MAP_SIZE - 3, MAP_SIZE - 3, MAP_SIZE - 2, MAP_SIZE - 2};
+	ASSERT_FALSE(first->CoversSectorsIn(away));
+	grid.Fill(away, 3);
+	cache.Invalidate(away);
+	EXPECT_EQ(cache.Get(GOAL, STARTS), first);
+
+	const CellRect inside{MAP_SIZE - 8, 6, MAP_SIZE - 6, 8};
+	grid.Fill(inside, 3);
+	cache.Invalidate(inside);
+	const std::shared_ptr<const FlowField> rebuilt = cache.Get(GOAL, STARTS);
+	ASSERT_TRUE(rebuilt);
+	EXPECT_NE(rebuilt, first);
+	EXPECT_EQ(cache.GetMisses(), 2u);
+
+	// Starts outside the covered sectors extend the field
+	const Cell late[] = {{2, MAP_SIZE - 3}};
+	const std::shared_ptr<const FlowField> extended = cache.Get(GOAL, late);
+	ASSERT_TRUE(extended);
+	EXPECT_NE(extended, rebuilt);
+	EXPECT_TRUE(ReachesGoal(*extended, late[0]));
+	EXPECT_TRUE(ReachesGoal(*extended, STARTS[0]));
+	EXPECT_EQ(cache.GetMisses(), 3u);
+
+	EXPECT_FALSE(cache.Get({ROOM_SIZE, ROOM_SIZE}, STARTS));
+}
+
+TEST(FlowFieldCache, EvictsLeastRecentlyUsed)
+{
+	const CostGrid grid{64, 64};
+	FlowFieldCache cache{grid, 2};
+	const auto a = cache.Get({1, 1}, {});
+	const auto b = cache.Get({2, 2}, {});
+	EXPECT_EQ(cache.Get({1, 1}, {}), a);
+	cache.Get({3, 3}, {});
+	EXPECT_EQ(cache.Get({1, 1}, {}), a);
+	EXPECT_NE(cache.Get({2, 2}, {}), b);
+	EXPECT_EQ(cache.GetMisses(), 4u);
+}
@@ -0,0 +1,209 @@
+#include "sim/fog_of_war.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t FOG_CELLS = 128;
+constexpr float CELL_SIZE = 2.0f;
+constexpr float SIGHT_RADIUS = 16.0f;
+constexpr uint32_t UNIT_COUNT = 300;
+
+FogOfWar MakeFog() { return FogOfWar{FOG_CELLS, FOG_CELLS, CELL_SIZE, {0.0f, 0.0f}, 2}; }
+
+std::vector<float> MakeHills()
+{
+	std::vector<float> heights(FOG_CELLS * FOG_CELLS);
+	for (uint32_t z = 0; z < FOG_CELLS; z++) {
+		for (uint32_t x = 0; x < FOG_CELLS; x++) {
+			heights[z * FOG_CELLS + x] = 6.0f * (std::sin(x * 0.15f) + std::cos(z * 0.11f));
+		}
+	}
+	return heights;
+}
+
+DirectX::XMFLOAT2 GetCenter(Cell cell)
+{
+	return {(cell.x + 0.5f) * CELL_SIZE, (cell.z + 0.5f) * CELL_SIZE};
+}
+
+std::vector<uint32_t> GetVisibleCells(const FogOfWar &fog, uint8_t player)
+{
+	std::vector<uint32_t> cells;
+	for (uint32_t z = 0; z < fog.GetHeight(); z++) {
+		for (uint32_t x = 0; x < fog.GetWidth(); x++) {
+			if (fog.IsVisible(player, Cell{x, z})) {
+				cells.push_back(z * fog.GetWidth() + x);
+			}
+		}
+	}
+	return cells;
+}
+} // namespace
+
+TEST(FogOfWar, DiscMatchesBruteForce)
+{
+	FogOfWar fog = MakeFog();
+	const Cell center{40, 70};
+	fog.AddObserver(0, GetCenter(center), SIGHT_RADIUS);
+
+	const int32_t radius = static_cast<int32_t>(SIGHT_RADIUS / CELL_SIZE);
+	for (uint32_t z = 0; z < FOG_CELLS; z++) {
+		for (uint32_t x = 0; x < FOG_CELLS; x++) {
+			const int32_t dx = static_cast<int32_t>(x - center.x), dz = static_cast<int32_t>(z - center.z);
+			const bool inside = dx * dx + dz * dz <= radius * radius + radius;
+			ASSERT_EQ(fog.IsVisible(0, Cell{x, z}), inside) << x << ", " << z;
+			ASSERT_EQ(fog.IsExplored(0, Cell{x, z}), inside);
+			ASSERT_FALSE(fog.IsVisible(1, Cell{x, z}));
+		}
+	}
+}
+
+TEST(FogOfWar, IncrementalMatchesFresh)
+{
+	for (const bool lineOfSight : {false, true}) {
+		std::mt19937 rng{11};
+		std::uniform_real_distribution<float> coordinate{0.0f, FOG_CELLS * CELL_SIZE};
+		std::uniform_real_distribution<float> velocity{-0.5f, 0.5f};
+		std::vector<float> x(UNIT_COUNT), z(UNIT_COUNT), velocityX(UNIT_COUNT), velocityZ(UNIT_COUNT);
+		for (uint32_t i = 0; i < UNIT_COUNT; i++) {
+			x[i] = coordinate(rng);
+			z[i] = coordinate(rng);
+			velocityX[i] = velocity(rng);
+			velocityZ[i] = velocity(rng);
+		}
+
+		FogOfWar fog = MakeFog();
+		if (lineOfSight) {
+			fog.SetHeights(MakeHills());
+		}
+		std::vector<uint32_t> observers;
+		for (uint32_t i = 0; i < UNIT_COUNT; i++) {
+			observers.push_back(fog.AddObserver(static_cast<uint8_t>(i % 2), {x[i], z[i]}, SIGHT_RADIUS));
+		}
+		// Walk far enough that some units leave the map and see from the border
+		for (uint32_t tick = 0; tick < 90; tick++) {
+			for (uint32_t i = 0; i < UNIT_COUNT; i++) {
+				x[i] += velocityX[i];
+				z[i] += velocityZ[i];
+			}
+			fog.MoveObservers(observers, x, z);
+		}
+		EXPECT_GT(fog.GetRestampCount(), 0u);
+
+		FogOfWar fresh = MakeFog();
+		if (lineOfSight) {
+			fresh.SetHeights(MakeHills());
+		}
+		for (uint32_t i = 0; i < UNIT_COUNT; i++) {
+			fresh.AddObserver(static_cast<uint8_t>(i % 2), {x[i], z[i]}, SIGHT_RADIUS);
+		}
+		for (uint8_t player = 0; player < 2; player++) {
+			const std::span<const uint64_t> incremental = fog.GetVisibleBits(player), expected = fresh.GetVisibleBits(player);
+			EXPECT_TRUE(std::equal(incremental.begin(), incremental.end(), expected.begin(), expected.end()))
+				<< "player " << int{player} << (lineOfSight ? " with" : " without") << " line of sight";
+		}
+	}
+}
+
+TEST(FogOfWar, ExploredCellsStayAfterLeaving)
+{
+	FogOfWar fog = MakeFog();
+	const uint32_t observer = fog.AddObserver(0, GetCenter({10, 10}), SIGHT_RADIUS);
+	const uint64_t version = fog.GetVersion(0);
+
+	// Walking inside a cell stamps nothing
+	fog.MoveObserver(observer, {GetCenter({10, 10}).x + 0.4f, GetCenter({10, 10}).y});
+	EXPECT_EQ(fog.GetVersion(0), version);
+	EXPECT_EQ(fog.GetRestampCount(), 0u);
+
+	fog.MoveObserver(observer, GetCenter({100, 100}));
+	EXPECT_GT(fog.GetVersion(0), version);
+	EXPECT_EQ(fog.GetRestampCount(), 1u);
+	EXPECT_FALSE(fog.IsVisible(0, Cell{10, 10}));
+	EXPECT_TRUE(fog.IsExplored(0, Cell{10, 10}));
+	EXPECT_TRUE(fog.IsVisible(0, GetCenter({100, 100})));
+
+	std::vector<uint8_t> texels;
+	fog.BuildTexels(0, texels);
+	ASSERT_EQ(texels.size(), FOG_CELLS * FOG_CELLS);
+	EXPECT_EQ(texels[10 * FOG_CELLS + 10], FOG_TEXEL_EXPLORED);
+	EXPECT_EQ(texels[100 * FOG_CELLS + 100], FOG_TEXEL_VISIBLE);
+	EXPECT_EQ(texels[60 * FOG_CELLS + 60], FOG_TEXEL_UNEXPLORED);
+	for (uint32_t i = 0; i < texels.size(); i++) {
+		const Cell cell{i % FOG_CELLS, i / FOG_CELLS};
+		const uint8_t expected = fog.IsVisible(0, cell)	   ? FOG_TEXEL_VISIBLE
+								 : fog.IsExplored(0, cell) ? FOG_TEXEL_EXPLORED
+														   : FOG_TEXEL_UNEXPLORED;
+		ASSERT_EQ(texels[i], expected) << i;
+	}
+}
+
+TEST(FogOfWar, OverlappingObserversAndRemoval)
+{
+	FogOfWar fog = MakeFog();
+	const uint32_t first = fog.AddObserver(0, GetCenter({50, 50}), SIGHT_RADIUS);
+	const uint32_t second = fog.AddObserver(0, GetCenter({52, 50}), SIGHT_RADIUS);
+	const std::vector<uint32_t> both = GetVisibleCells(fog, 0);
+
+	// Cells the second observer still sees stay visible
+	fog.RemoveObserver(first);
+	EXPECT_TRUE(fog.IsVisible(0, Cell{52, 50}));
+	EXPECT_TRUE(fog.IsVisible(0, Cell{51, 50}));
+	EXPECT_FALSE(fog.IsVisible(0, Cell{50 - 8, 50}));
+	fog.RemoveObserver(first);
+
+	fog.RemoveObserver(second);
+	EXPECT_TRUE(GetVisibleCells(fog, 0).empty());
+	EXPECT_TRUE(fog.IsExplored(0, Cell{50, 50}));
+
+	// Freed slots are reused and stamp like new
+	const uint32_t reused = fog.AddObserver(0, GetCenter({50, 50}), SIGHT_RADIUS);
+	EXPECT_TRUE(reused == first || reused == second);
+	fog.AddObserver(0, GetCenter({52, 50}), SIGHT_RADIUS);
+	EXPECT_EQ(GetVisibleCells(fog, 0), both);
+}
+
+TEST(FogOfWar, HillsHideCellsBehindThem)
+{
+	FogOfWar fog = MakeFog();
+	fog.AddObserver(0, GetCenter({20, 20}), SIGHT_RADIUS);
+	EXPECT_TRUE(fog.IsVisible(0, Cell{27, 20}));
+
+	// A ridge two cells east of the observer
+	std::vector<float> heights(FOG_CELLS * FOG_CELLS, 0.0f);
+	for (uint32_t z = 0; z < FOG_CELLS; z++) {
+		heights[z * FOG_CELLS + 22] = 10.0f;
+	}
+	fog.SetHeights(heights);
+	EXPECT_TRUE(fog.IsVisible(0, Cell{22, 20}));
+	EXPECT_FALSE(fog.IsVisible(0, Cell{27, 20}));
+	EXPECT_TRUE(fog.IsVisible(0, Cell{13, 20}));
+	// Already explored before the ridge rose
+	EXPECT_TRUE(fog.IsExplored(0, Cell{27, 20}));
+
+	fog.ClearHeights();
+	EXPECT_TRUE(fog.IsVisible(0, Cell{27, 20}));
+
+	// Heights of the wrong size are ignored
+	fog.SetHeights(std::vector<float>(10, 100.0f));
+	EXPECT_TRUE(fog.IsVisible(0, Cell{27, 20}));
+}
+
+TEST(FogOfWar, ObserversOffTheMapSeeFromTheBorder)
+{
+	FogOfWar fog = MakeFog();
+	fog.AddObserver(1, {-50.0f, -50.0f}, SIGHT_RADIUS);
+	EXPECT_TRUE(fog.IsVisible(1, Cell{0, 0}));
+	EXPECT_TRUE(fog.IsVisible(1, Cell{8, 0}));
+	EXPECT_FALSE(fog.IsVisible(1, DirectX::XMFLOAT2{-1.0f, 1.0f}));
+	EXPECT_FALSE(fog.IsVisible(1, DirectX::XMFLOAT2{1.0f, FOG_CELLS * CELL_SIZE}));
+
+	fog.AddObserver(1, {std::nanf(""), std::nanf("")}, SIGHT_RADIUS);
+	EXPECT_TRUE(fog.IsVisible(1, Cell{0, 0}));
+}
@@ -0,0 +1,144 @@
+#include "cook/model_compare.h"
+#include "gltf/gltf_loader.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+const fs::path DATA_DIR = SHELLSHOCK_TEST_DATA_DIR;
+
+// Two primitives in quad.bin, one without a material, and a texture outside the model
+const fs::path GLTF_PATH = DATA_DIR / "quad.gltf";
+// An interleaved grid with its image in the BIN chunk, under two root nodes
+const fs::path GLB_PATH = DATA_DIR / "grid.glb";
+
+std::string ReadText(const fs::path &path)
+{
+	std::ifstream file{path, std::ios::binary};
+	return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+} // namespace
+
+TEST(GltfLoader, LoadsGltfWithExternalBuffer)
+{
+	const std::optional<TGW::Gltf::GltfModel> model = TGW::Gltf::Load(GLTF_PATH);
+	ASSERT_TRUE(model);
+	ASSERT_EQ(model->meshes.size(), 2u);
+	EXPECT_EQ(model->meshes[0].vertices.size(), 4u);
+	EXPECT_EQ(model->meshes[0].indices, (std::vector<uint32_t>{0, 2, 1, 1, 2, 3}));
+	EXPECT_EQ(model->meshes[1].indices.size(), 3u);
+
+	// The declared material and the default one Assimp adds for the second primitive
+	ASSERT_EQ(model->materials.size(), 2u);
+	EXPECT_EQ(model->meshes[0].materialIndex, 0u);
+	EXPECT_EQ(model->meshes[1].materialIndex, 1u);
+	EXPECT_EQ(model->materials[0].textures[TEXTURE_SLOT_DIFFUSE], "textures/crate.png");
+	EXPECT_TRUE(model->embeddedImages.empty());
+	EXPECT_EQ(model->files.size(), 2u);
+
+	// V is flipped, missing attributes are zero
+	EXPECT_FLOAT_EQ(model->meshes[0].vertices[2].texCoords.y, 0.0f);
+	EXPECT_FLOAT_EQ(model->meshes[0].vertices[0].texCoords.y, 1.0f);
+	EXPECT_FLOAT_EQ(model->meshes[0].vertices[0].normal.y, 1.0f);
+	EXPECT_FLOAT_EQ(model->meshes[1].vertices[1].normal.y, 0.0f);
+
+	// The only root node's TRS, row major like Assimp's: scale 2 and translation (2, 0, -3) in the last column
+	EXPECT_NEAR(model->rootTransform._14, 2.0f, 1e-5f);
+	EXPECT_NEAR(model->rootTransform._34, -3.0f, 1e-5f);
+	EXPECT_NEAR(DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSet(
+					model->rootTransform._11, model->rootTransform._12, model->rootTransform._13, 0.0f))),
+		2.0f, 1e-5f);
+}
+
+TEST(GltfLoader, LoadsGlbWithEmbeddedImage)
+{
+	const std::optional<TGW::Gltf::GltfModel> model = TGW::Gltf::Load(GLB_PATH);
+	ASSERT_TRUE(model);
+	ASSERT_EQ(model->meshes.size(), 1u);
+	EXPECT_EQ(model->meshes[0].vertices.size(), 9u);
+	EXPECT_EQ(model->meshes[0].indices.size(), 24u);
+	EXPECT_FLOAT_EQ(model->meshes[0].vertices[4].position.y, 0.0f);
+	EXPECT_FLOAT_EQ(model->meshes[0].vertices[8].texCoords.x, 1.0f);
+
+	ASSERT_EQ(model->embeddedImages.size(), 1u);
+	ASSERT_GE(model->embeddedImages[0].size(), 8u);
+	EXPECT_EQ(model->embeddedImages[0][1], 'P');
+	EXPECT_EQ(model->materials[0].textures[TEXTURE_SLOT_DIFFUSE], "*0");
+
+	// Two root nodes get an identity root above them
+	DirectX::XMFLOAT4X4 identity;
+	DirectX::XMStoreFloat4x4(&identity, DirectX::XMMatrixIdentity());
+	EXPECT_EQ(std::memcmp(&model->rootTransform, &identity, sizeof(identity)), 0);
+}
+
+// Anything outside the common subset is left to Assimp instead of half loaded
+TEST(GltfLoader, RejectsUnsupportedFiles)
+{
+	const fs::path directory = fs::temp_directory_path() / "shellshock_test_gltf";
+	fs::create_directories(directory);
+	fs::copy_file(DATA_DIR / "quad.bin", directory / "quad.bin", fs::copy_options::overwrite_existing);
+
+	const std::string gltf = ReadText(GLTF_PATH);
+	const auto rejects = [&](std::string_view from, std::string_view to) {
+		std::string changed = gltf;
+		const size_t at = changed.find(from);
+		EXPECT_NE(at, std::string::npos) << from;
+		changed.replace(at, from.size(), to);
+		std::ofstream{directory / "changed.gltf", std::ios::binary} << changed;
+		return !TGW::Gltf::Load(directory / "changed.gltf");
+	};
+	EXPECT_TRUE(rejects("\"indices\": 3,", "\"indices\": 3, \"mode\": 0,"));
+	EXPECT_TRUE(rejects("\"version\": \"2.0\"", "\"version\": \"1.0\""));
+	EXPECT_TRUE(rejects("\"uri\": \"quad.bin\"", "\"uri\": \"missing.bin\""));
+	EXPECT_TRUE(rejects("\"asset\"", "\"extensionsRequired\": [\"KHR_draco_mesh_compression\"], \"asset\""));
+
+	std::string glb = ReadText(GLB_PATH);
+	glb.resize(glb.size() / 2);
+	std::ofstream{directory / "truncated.glb", std::ios::binary} << glb;
+	EXPECT_FALSE(TGW::Gltf::Load(directory / "truncated.glb"));
+
+	fs::remove_all(directory);
+}
+
+TEST(ModelCompare, FindsDifferences)
+{
+	std::optional<TGW::Cook::CookedModel> model = TGW::Cook::LoadGltfModel(GLTF_PATH);
+	ASSERT_TRUE(model);
+	EXPECT_TRUE(TGW::Cook::CompareModels(*model, *model).empty());
+
+	// Welded and reordered vertices are still the same corners
+	TGW::Cook::CookedModel reordered = *model;
+	MeshData &mesh = reordered.meshes[0];
+	std::reverse(mesh.vertices.begin(), mesh.vertices.end());
+	for (uint32_t &index : mesh.indices) {
+		index = static_cast<uint32_t>(mesh.vertices.size()) - 1 - index;
+	}
+	EXPECT_TRUE(TGW::Cook::CompareModels(*model, reordered).empty());
+
+	TGW::Cook::CookedModel moved = *model;
+	moved.meshes[1].vertices[2].position.x += 0.01f;
+	moved.materials[0].textures[TEXTURE_SLOT_DIFFUSE] = "textures/other.png";
+	moved.rootTransform._42 = 1.0f;
+	EXPECT_EQ(TGW::Cook::CompareModels(*model, moved).size(), 3u);
+
+	TGW::Cook::CookedModel fewer = *model;
+	fewer.meshes.pop_back();
+	EXPECT_EQ(TGW::Cook::CompareModels(*model, fewer).size(), 1u);
+}
+
+// The native loader has to give the editor exactly what the Assimp import did
+TEST(ModelCompare, GltfMatchesAssimp)
+{
+	for (const fs::path &path : {GLTF_PATH, GLB_PATH}) {
+		const std::optional<TGW::Cook::CookedModel> native = TGW::Cook::LoadGltfModel(path);
+		const std::optional<TGW::Cook::CookedModel> assimp = TGW::Cook::ImportModel(path);
+		ASSERT_TRUE(native) << path;
+		ASSERT_TRUE(assimp) << path;
+		for (const std::string &difference : TGW::Cook::CompareModels(*native, *assimp)) {
+			ADD_FAILURE() << path << ": " << difference;
+		}
+	}
+}
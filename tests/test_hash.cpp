@@ -0,0 +1,159 @@
+#include "core/content_hash.h"
+#include "core/content_registry.h"
+#include "core/job_system.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+
+using namespace TGW;
+
+namespace {
+// Past a 1 KiB scramble block, so every stripe and tail length shows up
+constexpr size_t CHECK_LENGTHS = 2200;
+constexpr uint64_t KEY_BYTES = 1000;
+
+std::vector<uint8_t> MakeData(size_t size)
+{
+	std::mt19937 rng{45};
+	std::vector<uint8_t> data(size);
+	for (uint8_t &byte : data) {
+		byte = static_cast<uint8_t>(rng());
+	}
+	return data;
+}
+
+struct Block {
+	uint32_t value = 0;
+};
+
+ContentKey MakeKey(uint32_t value)
+{
+	const std::span<const uint8_t> bytes{reinterpret_cast<const uint8_t *>(&value), sizeof(value)};
+	return ContentKey{.hash = Hash::ContentHash128(bytes), .bytes = KEY_BYTES};
+}
+
+// Makes a Block of value and counts how often it ran
+auto MakeBlock(uint32_t &made, uint32_t value)
+{
+	return [&made, value] {
+		made++;
+		return std::optional<Block>{Block{value}};
+	};
+}
+} // namespace
+
+TEST(ContentHash128, SimdMatchesScalarOnEveryLength)
+{
+	const std::vector<uint8_t> data = MakeData(CHECK_LENGTHS);
+	for (size_t length = 0; length <= data.size(); length++) {
+		const std::span<const uint8_t> bytes{data.data(), length};
+		ASSERT_EQ(Hash::ContentHash128(bytes), Hash::ContentHash128Scalar(bytes)) << length;
+		ASSERT_EQ(Hash::ContentHash128(bytes, length), Hash::ContentHash128Scalar(bytes, length)) << length;
+	}
+}
+
+TEST(ContentHash128, EveryBitSeedAndLengthShows)
+{
+	const std::vector<uint8_t> data = MakeData(CHECK_LENGTHS);
+	const Hash::Hash128 reference = Hash::ContentHash128(data);
+	std::vector<uint8_t> flipped = data;
+	for (size_t i = 0; i < flipped.size(); i++) {
+		flipped[i] ^= 1 << (i % 8);
+		EXPECT_NE(Hash::ContentHash128(flipped), reference) << i;
+		flipped[i] = data[i];
+	}
+	EXPECT_NE(Hash::ContentHash128(data, 1), reference);
+
+	// Trailing zeros are part of the content
+	const std::vector<uint8_t> zeros(64);
+	const Hash::Hash128 empty = Hash::ContentHash128({});
+	EXPECT_NE(Hash::ContentHash128(std::span{zeros}.first(63)), Hash::ContentHash128(zeros));
+	EXPECT_NE(empty, Hash::ContentHash128(std::span{zeros}.first(1)));
+	EXPECT_NE(empty, Hash::ContentHash128({}, 1));
+}
+
+TEST(ContentRegistry, SharesCountsAndReleases)
+{
+	ContentRegistry<Block> registry;
+	uint32_t made = 0;
+	auto first = registry.Acquire(MakeKey(1), MakeBlock(made, 1));
+	auto second = registry.Acquire(MakeKey(1), MakeBlock(made, 1));
+	auto other = registry.Acquire(MakeKey(2), MakeBlock(made, 2));
+	EXPECT_EQ(made, 2u);
+	EXPECT_EQ(first.get(), second.get());
+	EXPECT_EQ(other->value, 2u);
+
+	ContentRegistryStats stats = registry.GetStats();
+	EXPECT_EQ(stats.requests, 3u);
+	EXPECT_EQ(stats.hits, 1u);
+	EXPECT_EQ(stats.liveEntries, 2u);
+	EXPECT_EQ(stats.liveBytes, 2 * KEY_BYTES);
+	EXPECT_EQ(stats.GetSavedBytes(), KEY_BYTES);
+	EXPECT_DOUBLE_EQ(stats.GetDedupRatio(), 1.5);
+
+	// A failed make registers nothing
+	EXPECT_FALSE(registry.Acquire(MakeKey(3), [] { return std::optional<Block>{}; }));
+	EXPECT_EQ(registry.GetStats().liveEntries, 2u);
+
+	// The entry outlives one user, not both, and comes back made anew
+	first.reset();
+	stats = registry.GetStats();
+	EXPECT_EQ(stats.liveEntries, 2u);
+	EXPECT_EQ(stats.GetSavedBytes(), 0u);
+	EXPECT_EQ(second->value, 1u);
+	second.reset();
+	stats = registry.GetStats();
+	EXPECT_EQ(stats.liveEntries, 1u);
+	EXPECT_EQ(stats.liveBytes, KEY_BYTES);
+	EXPECT_EQ(stats.referencedBytes, KEY_BYTES);
+	first = registry.Acquire(MakeKey(1), MakeBlock(made, 1));
+	EXPECT_EQ(made, 3u);
+	EXPECT_EQ(first->value, 1u);
+}
+
+TEST(ContentRegistry, UsersOutliveTheRegistry)
+{
+	uint32_t made = 0;
+	std::shared_ptr<const Block> orphan;
+	{
+		ContentRegistry<Block> registry;
+		orphan = registry.Acquire(MakeKey(4), MakeBlock(made, 4));
+	}
+	ASSERT_TRUE(orphan);
+	EXPECT_EQ(orphan->value, 4u);
+	orphan.reset();
+}
+
+// Threads acquire and drop the same few keys, nothing may leak or be made twice while held
+TEST(ContentRegistry, SharedAcrossThreads)
+{
+	constexpr uint32_t KEYS = 8;
+	ContentRegistry<Block> registry;
+	std::vector<std::shared_ptr<const Block>> held(KEYS);
+	for (uint32_t key = 0; key < KEYS; key++) {
+		held[key] = registry.Acquire(MakeKey(key), [key] { return std::optional<Block>{Block{key}}; });
+	}
+	JobSystem jobs{3};
+	std::atomic<bool> shared{true};
+	jobs.ParallelFor(4096, 64, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			const uint32_t key = i % (KEYS * 2);
+			auto block = registry.Acquire(MakeKey(key), [key] { return std::optional<Block>{Block{key}}; });
+			if (block->value != key || (key < KEYS && block.get() != held[key].get())) {
+				shared = false;
+			}
+		}
+	});
+	EXPECT_TRUE(shared);
+
+	const ContentRegistryStats stats = registry.GetStats();
+	EXPECT_EQ(stats.liveEntries, KEYS);
+	EXPECT_EQ(stats.referencedBytes, KEYS * KEY_BYTES);
+	held.clear();
+	const ContentRegistryStats empty = registry.GetStats();
+	EXPECT_EQ(empty.liveEntries, 0u);
+	EXPECT_EQ(empty.liveBytes, 0u);
+	EXPECT_EQ(empty.referencedBytes, 0u);
+}
@@ -0,0 +1,230 @@
+#include "sim/hpa_pathfinder.h"
+
+#include <gtest/gtest.h>
+
+#include <queue>
+#include <random>
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t MAP_SIZE = 256;
+constexpr uint32_t MAP_SEED = 11;
+constexpr uint32_t QUERY_COUNT = 200;
+constexpr uint32_t BLOCK_COUNT = 800;
+
+// Random blocks, a quarter of them rough ground, the same kind of map bench_hpa times
+CostGrid MakeBlockMap()
+{
+	std::mt19937 rng{MAP_SEED};
+	std::uniform_int_distribution<uint32_t> position{0, MAP_SIZE - 1};
+	std::uniform_int_distribution<uint32_t> extent{1, 8};
+	std::uniform_int_distribution<uint32_t> cost{2, 6};
+
+	CostGrid grid{MAP_SIZE, MAP_SIZE};
+	for (uint32_t i = 0; i < BLOCK_COUNT; i++) {
+		const uint32_t x = position(rng), z = position(rng);
+		grid.Fill({x, z, x + extent(rng), z + extent(rng)}, i % 4 ? COST_BLOCKED : static_cast<uint8_t>(cost(rng)));
+	}
+	return grid;
+}
+
+std::vector<std::pair<Cell, Cell>> MakeQueries(const CostGrid &grid, uint32_t seed)
+{
+	std::mt19937 rng{seed};
+	std::uniform_int_distribution<uint32_t> x{0, grid.GetWidth() - 1}, z{0, grid.GetHeight() - 1};
+	std::vector<std::pair<Cell, Cell>> queries;
+	while (queries.size() < QUERY_COUNT) {
+		const Cell start{x(rng), z(rng)}, goal{x(rng), z(rng)};
+		if (grid.IsPassable(start) && grid.IsPassable(goal)) {
+			queries.push_back({start, goal});
+		}
+	}
+	return queries;
+}
+
+// Plain Dijkstra from start, the reference for flat A*
+std::vector<uint32_t> GetCostsFrom(const CostGrid &grid, Cell start)
+{
+	std::vector<uint32_t> costs(grid.GetWidth() * grid.GetHeight(), PATH_UNREACHABLE);
+	using Item = std::pair<uint32_t, uint32_t>;
+	std::priority_queue<Item, std::vector<Item>, std::greater<>> open;
+	costs[start.z * grid.GetWidth() + start.x] = 0;
+	open.push({0, start.z * grid.GetWidth() + start.x});
+	while (!open.empty()) {
+		const auto [cost, index] = open.top();
+		open.pop();
+		if (cost != costs[index]) {
+			continue;
+		}
+		const Cell cell{index % grid.GetWidth(), index / grid.GetWidth()};
+		for (uint32_t direction = 0; direction < GRID_DIRECTION_COUNT; direction++) {
+			if (!grid.CanStep(cell, direction)) {
+				continue;
+			}
+			const Cell next{cell.x + GRID_STEP_X[direction], cell.z + GRID_STEP_Z[direction]};
+			const uint32_t total = cost + grid.GetStepCost(next, direction);
+			if (total < costs[next.z * grid.GetWidth() + next.x]) {
+				costs[next.z * grid.GetWidth() + next.x] = total;
+				open.push({total, next.z * grid.GetWidth() + next.x});
+			}
+		}
+	}
+	return costs;
+}
+
+// Whether path walks from start to goal in legal steps that add up to cost
+testing::AssertionResult
+IsValidPath(const CostGrid &grid, const std::vector<Cell> &path, Cell start, Cell goal, uint32_t cost)
+{
+	if (path.empty() || !(path.front() == start) || !(path.back() == goal)) {
+		return testing::AssertionFailure() << "path does not run from start to goal";
+	}
+	uint32_t total = 0;
+	for (size_t i = 1; i < path.size(); i++) {
+		uint32_t direction = 0;
+		for (; direction < GRID_DIRECTION_COUNT; direction++) {
+			if (Cell{path[i - 1].x + GRID_STEP_X[direction], path[i - 1].z + GRID_STEP_Z[direction]} == path[i]) {
+				break;
+			}
+		}
+		if (direction == GRID_DIRECTION_COUNT || !grid.CanStep(path[i - 1], direction)) {
+			return testing::AssertionFailure() << "illegal step " << i;
+		}
+		total += grid.GetStepCost(path[i], direction);
+	}
+	if (total != cost) {
+		return testing::AssertionFailure() << "steps cost " << total << ", reported " << cost;
+	}
+	return testing::AssertionSuccess();
+}
+} // namespace
+
+TEST(HpaPathfinder, FlatAStarIsOptimal)
+{
+	const CostGrid grid = MakeBlockMap();
+	HpaPathfinder pathfinder{grid, 0};
+	std::vector<Cell> path;
+	const auto queries = MakeQueries(grid, MAP_SEED + 1);
+	for (size_t i = 0; i < 10; i++) {
+		const auto &[start, goal] = queries[i];
+		const uint32_t expected = GetCostsFrom(grid, start)[goal.z * MAP_SIZE + goal.x];
+		const std::optional<uint32_t> cost = pathfinder.FindFlatPath(start, goal, path);
+		ASSERT_EQ(cost.value_or(PATH_UNREACHABLE), expected) << i;
+		if (cost) {
+			EXPECT_TRUE(IsValidPath(grid, path, start, goal, *cost));
+		}
+	}
+}
+
+// Near optimal: never cheaper than flat A*, found exactly when flat A* finds a path, and a few percent longer on
+// average
+TEST(HpaPathfinder, OptimalityErrorAgainstFlatAStar)
+{
+	const CostGrid grid = MakeBlockMap();
+	HpaPathfinder pathfinder{grid, 0};
+	std::vector<Cell> path;
+	double totalError = 0.0;
+	double worstError = 0.0;
+	uint32_t found = 0;
+	for (const auto &[start, goal] : MakeQueries(grid, MAP_SEED + 1)) {
+		const std::optional<uint32_t> optimal = pathfinder.FindFlatPath(start, goal, path);
+		const std::optional<uint32_t> cost = pathfinder.FindPath(start, goal, path);
+		ASSERT_EQ(cost.has_value(), optimal.has_value());
+		if (!cost) {
+			continue;
+		}
+		ASSERT_TRUE(IsValidPath(grid, path, start, goal, *cost));
+		ASSERT_GE(*cost, *optimal);
+		if (*optimal > 0) {
+			const double error = double(*cost - *optimal) / *optimal;
+			totalError += error;
+			worstError = std::max(worstError, error);
+			found++;
+		}
+	}
+	ASSERT_GT(found, QUERY_COUNT / 2);
+	EXPECT_LT(totalError / found, 0.1);
+	EXPECT_LT(worstError, 0.5);
+}
+
+// After OnCostsChanged the graph has to answer like one built from scratch on the new costs. Cached paths may
+// differ from a fresh search, but must still be walkable.
+TEST(HpaPathfinder, IncrementalRebuildMatchesFreshGraph)
+{
+	CostGrid grid = MakeBlockMap();
+	HpaPathfinder incremental{grid, 0};
+	HpaPathfinder cached{grid};
+	std::vector<Cell> path;
+	const auto queries = MakeQueries(grid, MAP_SEED + 2);
+	for (const auto &[start, goal] : queries) {
+		cached.FindPath(start, goal, path);
+	}
+
+	std::mt19937 rng{MAP_SEED + 3};
+	std::uniform_int_distribution<uint32_t> position{0, MAP_SIZE - 1};
+	std::uniform_int_distribution<uint32_t> extent{1, 40};
+	for (uint32_t change = 0; change < 12; change++) {
+		// Buildings going up, rough ground and cleared ground, some of them cut off by the map edge
+		const uint32_t x = position(rng), z = position(rng);
+		const CellRect rect{x, z, std::min(x + extent(rng), MAP_SIZE), std::min(z + extent(rng), MAP_SIZE)};
+		grid.Fill(rect, change % 3 == 2 ? COST_DEFAULT : change % 3 == 1 ? 4 : COST_BLOCKED);
+		incremental.OnCostsChanged(rect);
+		cached.OnCostsChanged(rect);
+
+		HpaPathfinder fresh{grid, 0};
+		ASSERT_EQ(incremental.GetNodeCount(), fresh.GetNodeCount()) << "after change " << change;
+		for (const auto &[start, goal] : queries) {
+			if (!grid.IsPassable(start) || !grid.IsPassable(goal)) {
+				continue;
+			}
+			const std::optional<uint32_t> expected = fresh.FindPath(start, goal, path);
+			const std::optional<uint32_t> cost = incremental.FindPath(start, goal, path);
+			ASSERT_EQ(cost, expected) << "after change " << change;
+			if (cost) {
+				ASSERT_TRUE(IsValidPath(grid, path, start, goal, *cost));
+			}
+
+			const std::optional<uint32_t> cachedCost = cached.FindPath(start, goal, path);
+			ASSERT_EQ(cachedCost.has_value(), expected.has_value()) << "after change " << change;
+			if (cachedCost) {
+				ASSERT_TRUE(IsValidPath(grid, path, start, goal, *cachedCost));
+			}
+		}
+	}
+}
+
+TEST(HpaPathfinder, CachedPathsAreReusedAndDropped)
+{
+	CostGrid grid{64, 64};
+	HpaPathfinder pathfinder{grid};
+	std::vector<Cell> path;
+	const Cell start{2, 30}, goal{60, 30};
+	const std::optional<uint32_t> first = pathfinder.FindPath(start, goal, path);
+	ASSERT_TRUE(first);
+	EXPECT_EQ(pathfinder.FindPath(start, goal, path), first);
+	EXPECT_EQ(pathfinder.GetCacheHits(), 1u);
+
+	// A wall across the cached route
+	const CellRect wall{30, 10, 31, 50};
+	grid.Fill(wall, COST_BLOCKED);
+	pathfinder.OnCostsChanged(wall);
+	const std::optional<uint32_t> detour = pathfinder.FindPath(start, goal, path);
+	ASSERT_TRUE(detour);
+	EXPECT_GT(*detour, *first);
+	EXPECT_TRUE(IsValidPath(grid, path, start, goal, *detour));
+
+	EXPECT_FALSE(pathfinder.FindPath(start, {30, 30}, path));
+}
+
+TEST(HpaPathfinder, SameClusterAndUnreachable)
+{
+	CostGrid grid{64, 64};
+	grid.Fill({0, 20, 64, 21}, COST_BLOCKED);
+	HpaPathfinder pathfinder{grid};
+	std::vector<Cell> path;
+	EXPECT_EQ(pathfinder.FindPath({3, 3}, {3, 3}, path), 0u);
+	EXPECT_EQ(pathfinder.FindPath({3, 3}, {6, 3}, path), 3 * STRAIGHT_STEP_COST);
+	EXPECT_EQ(path.size(), 4u);
+	EXPECT_FALSE(pathfinder.FindPath({3, 3}, {3, 40}, path));
+}
@@ -0,0 +1,62 @@
+#include "core/job_system.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using namespace TGW;
+
+TEST(JobSystem, ParallelForCoversEveryIndexOnce)
+{
+	JobSystem jobs{3};
+	std::vector<std::atomic<uint32_t>> seen(1000);
+	jobs.ParallelFor(static_cast<uint32_t>(seen.size()), 7, [&](uint32_t begin, uint32_t end) {
+		EXPECT_LE(end - begin, 7u);
+		for (uint32_t i = begin; i < end; i++) {
+			seen[i]++;
+		}
+	});
+	EXPECT_TRUE(std::ranges::all_of(seen, [](const std::atomic<uint32_t> &count) { return count == 1; }));
+}
+
+TEST(JobSystem, ParallelForInsideAJob)
+{
+	JobSystem jobs{2};
+	std::atomic<uint32_t> sum = 0;
+	jobs.ParallelFor(8, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++) {
+			jobs.ParallelFor(100, 10, [&](uint32_t innerBegin, uint32_t innerEnd) { sum += innerEnd - innerBegin; });
+		}
+	});
+	EXPECT_EQ(sum, 800u);
+}
+
+// A submitted job stuck in the queue behind a busy worker must not end up on a thread waiting in ParallelFor. The
+// first job holds the only worker until the loop is done, the second would never return if the loop ran it.
+TEST(JobSystem, ParallelForRunsOnlyItsOwnBatches)
+{
+	JobSystem jobs{1};
+	std::atomic<bool> started = false, release = false, ranQueued = false;
+	jobs.Submit([&] {
+		started = true;
+		while (!release) {
+			std::this_thread::yield();
+		}
+	});
+	while (!started) {
+		std::this_thread::yield();
+	}
+	jobs.Submit([&] {
+		while (!release) {
+			std::this_thread::yield();
+		}
+		ranQueued = true;
+	});
+
+	const std::thread::id caller = std::this_thread::get_id();
+	std::atomic<uint32_t> onCaller = 0;
+	jobs.ParallelFor(16, 1, [&](uint32_t, uint32_t) { onCaller += std::this_thread::get_id() == caller; });
+	EXPECT_EQ(onCaller, 16u);
+	EXPECT_FALSE(ranQueued);
+	release = true;
+}
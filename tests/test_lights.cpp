@@ -0,0 +1,158 @@
+#include "camera.h"
+#include "fx/light_clusters.h"
+
+#include <gtest/gtest.h>
+
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+using namespace TGW::Fx;
+
+namespace {
+constexpr float BATTLE_SIZE = 200.0f;
+constexpr uint32_t LIGHT_COUNT = 256;
+// Lights this close to touching or missing a froxel may land either way
+constexpr double RADIUS_TOLERANCE = 1e-3;
+
+std::vector<PointLight> MakeLights(uint32_t count)
+{
+	std::mt19937 rng{11};
+	std::uniform_real_distribution<float> ground{0.0f, BATTLE_SIZE}, height{0.5f, 10.0f}, radius{3.0f, 12.0f};
+	std::vector<PointLight> lights(count);
+	for (PointLight &light : lights) {
+		light.position = {ground(rng), height(rng), ground(rng)};
+		light.radius = radius(rng);
+		light.color = {1.0f, 1.0f, 1.0f};
+		light.intensity = 4.0f;
+	}
+	return lights;
+}
+
+Camera MakeCamera()
+{
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	camera.SetView(DirectX::XMVectorSet(BATTLE_SIZE * 0.5f, 0.0f, BATTLE_SIZE * 0.2f, 1.0f),
+		DirectX::XMVectorSet(0.0f, -0.5f, 1.0f, 0.0f), 15.0f);
+	return camera;
+}
+
+// Squared distance from a point to a box, 0 inside
+double DistanceSq(const DirectX::XMFLOAT3 &p, const DirectX::XMFLOAT3 &low, const DirectX::XMFLOAT3 &high)
+{
+	const auto axis = [](double v, double a, double b) { return v < a ? a - v : (v > b ? v - b : 0.0); };
+	const double dx = axis(p.x, low.x, high.x), dy = axis(p.y, low.y, high.y), dz = axis(p.z, low.z, high.z);
+	return dx * dx + dy * dy + dz * dz;
+}
+
+// View space box of a froxel, its corners unprojected from NDC through the inverse projection
+void GetFroxelBox(const LightClusters &clusters, DirectX::CXMMATRIX projection, uint32_t x, uint32_t y, uint32_t slice,
+	DirectX::XMFLOAT3 &low, DirectX::XMFLOAT3 &high)
+{
+	const DirectX::XMMATRIX inverseProjection = DirectX::XMMatrixInverse(nullptr, projection);
+	float depths[2];
+	for (uint32_t k = 0; k < 2; k++) {
+		const float viewDepth = std::exp((slice + k - clusters.GetSliceBias()) / clusters.GetSliceScale());
+		DirectX::XMFLOAT4 clip;
+		DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(DirectX::XMVectorSet(0.0f, 0.0f, viewDepth, 1.0f), projection));
+		depths[k] = clip.z / clip.w;
+	}
+	low = {FLT_MAX, FLT_MAX, FLT_MAX};
+	high = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		const float ndcX = 2.0f * (x + (corner & 1)) / clusters.GetTilesX() - 1.0f;
+		const float ndcY = 1.0f - 2.0f * (y + ((corner >> 1) & 1)) / clusters.GetTilesY();
+		const DirectX::XMVECTOR ndc = DirectX::XMVectorSet(ndcX, ndcY, depths[corner >> 2], 1.0f);
+		DirectX::XMFLOAT3 p;
+		DirectX::XMStoreFloat3(&p, DirectX::XMVector3TransformCoord(ndc, inverseProjection));
+		low = {std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z)};
+		high = {std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z)};
+	}
+}
+
+std::vector<uint32_t> GetListed(const LightClusters &clusters, uint32_t x, uint32_t y, uint32_t slice)
+{
+	const LightCluster &cluster = clusters.GetClusters()[clusters.GetClusterIndex(x, y, slice)];
+	const std::span<const uint32_t> indices = clusters.GetLightIndices().subspan(cluster.offset, cluster.count);
+	return {indices.begin(), indices.end()};
+}
+} // namespace
+
+TEST(LightClusters, EveryClusterListsWhatBruteForceFinds)
+{
+	const std::vector<PointLight> lights = MakeLights(LIGHT_COUNT);
+	const Camera camera = MakeCamera();
+	const DirectX::XMMATRIX view = camera.GetViewMatrix();
+	const DirectX::XMMATRIX projection = camera.GetProjectionMatrix();
+	TGW::JobSystem jobs{3};
+	LightClusters clusters;
+	clusters.Build(view, projection, lights, jobs);
+	ASSERT_EQ(clusters.GetClusters().size(), size_t{clusters.GetTilesX()} * clusters.GetTilesY() * clusters.GetSlices());
+	EXPECT_FALSE(clusters.GetLightIndices().empty());
+
+	std::vector<DirectX::XMFLOAT3> positions(lights.size());
+	for (size_t i = 0; i < lights.size(); i++) {
+		DirectX::XMStoreFloat3(&positions[i], DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&lights[i].position), view));
+	}
+	std::vector<uint8_t> listed(lights.size());
+	for (uint32_t slice = 0; slice < clusters.GetSlices(); slice++) {
+		for (uint32_t y = 0; y < clusters.GetTilesY(); y++) {
+			for (uint32_t x = 0; x < clusters.GetTilesX(); x++) {
+				DirectX::XMFLOAT3 low, high;
+				GetFroxelBox(clusters, projection, x, y, slice, low, high);
+				std::ranges::fill(listed, 0);
+				for (uint32_t index : GetListed(clusters, x, y, slice)) {
+					ASSERT_LT(index, lights.size());
+					EXPECT_FALSE(listed[index]) << "light " << index << " listed twice";
+					listed[index] = 1;
+				}
+				for (size_t i = 0; i < lights.size(); i++) {
+					const double distanceSq = DistanceSq(positions[i], low, high);
+					const double inner = lights[i].radius * (1.0 - RADIUS_TOLERANCE);
+					const double outer = lights[i].radius * (1.0 + RADIUS_TOLERANCE);
+					if (distanceSq <= inner * inner) {
+						EXPECT_TRUE(listed[i]) << "light " << i << " missing from " << x << ", " << y << ", " << slice;
+					} else if (distanceSq > outer * outer) {
+						EXPECT_FALSE(listed[i]) << "light " << i << " too far from " << x << ", " << y << ", " << slice;
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(LightClusters, SameListsOnAnyThreadCount)
+{
+	const std::vector<PointLight> lights = MakeLights(LIGHT_COUNT);
+	const Camera camera = MakeCamera();
+	TGW::JobSystem serial{0}, parallel{3};
+	LightClusters first, second;
+	first.Build(camera.GetViewMatrix(), camera.GetProjectionMatrix(), lights, serial);
+	second.Build(camera.GetViewMatrix(), camera.GetProjectionMatrix(), lights, parallel);
+	ASSERT_EQ(first.GetClusters().size(), second.GetClusters().size());
+	for (size_t i = 0; i < first.GetClusters().size(); i++) {
+		EXPECT_EQ(first.GetClusters()[i].offset, second.GetClusters()[i].offset);
+		EXPECT_EQ(first.GetClusters()[i].count, second.GetClusters()[i].count);
+	}
+	EXPECT_TRUE(std::ranges::equal(first.GetLightIndices(), second.GetLightIndices()));
+}
+
+TEST(LightClusters, LightsOutOfViewListNowhere)
+{
+	const Camera camera = MakeCamera();
+	std::vector<PointLight> lights = MakeLights(2);
+	// Behind the camera, then far off to the side
+	lights[0].position = {BATTLE_SIZE * 0.5f, 0.0f, -BATTLE_SIZE};
+	lights[1].position = {BATTLE_SIZE * 10.0f, 0.0f, BATTLE_SIZE * 0.3f};
+	TGW::JobSystem jobs{0};
+	LightClusters clusters;
+	clusters.Build(camera.GetViewMatrix(), camera.GetProjectionMatrix(), lights, jobs);
+	EXPECT_TRUE(clusters.GetLightIndices().empty());
+	for (const LightCluster &cluster : clusters.GetClusters()) {
+		EXPECT_EQ(cluster.count, 0u);
+	}
+
+	clusters.Build(camera.GetViewMatrix(), camera.GetProjectionMatrix(), {}, jobs);
+	EXPECT_TRUE(clusters.GetLightIndices().empty());
+}
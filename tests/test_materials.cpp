@@ -0,0 +1,298 @@
+#include "cook/texture_buckets.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+
+using namespace TGW::Cook;
+
+namespace {
+constexpr uint32_t TEXTURE_POOL = 200;
+// Textures each slot draws from, slot s uses the range starting at s * SLOT_TEXTURES
+constexpr int32_t SLOT_TEXTURES = 50;
+constexpr uint32_t MODEL_COUNT = 300;
+
+struct SceneTexture {
+	std::string name;
+	std::vector<uint8_t> header;
+};
+
+// Indices into the texture pool per material and slot, -1 for none
+using SceneMaterial = std::array<int32_t, TEXTURE_SLOT_COUNT>;
+
+void Put32(std::vector<uint8_t> &data, size_t offset, uint32_t value, bool bigEndian = false)
+{
+	for (size_t i = 0; i < 4; i++) {
+		data[offset + i] = static_cast<uint8_t>(value >> (bigEndian ? 24 - 8 * i : 8 * i));
+	}
+}
+
+std::vector<uint8_t> MakePng(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> data{0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+	data.resize(33);
+	Put32(data, 8, 13, true);
+	std::copy_n("IHDR", 4, data.begin() + 12);
+	Put32(data, 16, width, true);
+	Put32(data, 20, height, true);
+	return data;
+}
+
+// An APP0 segment ahead of the frame, like every JFIF file has
+std::vector<uint8_t> MakeJpeg(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> data{0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10};
+	data.resize(data.size() + 14);
+	const uint8_t frame[] = {0xFF, 0xC0, 0x00, 0x11, 0x08, static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+		static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width), 0x03};
+	data.insert(data.end(), std::begin(frame), std::end(frame));
+	return data;
+}
+
+std::vector<uint8_t> MakeBmp(uint32_t width, int32_t height)
+{
+	std::vector<uint8_t> data(54);
+	data[0] = 'B';
+	data[1] = 'M';
+	Put32(data, 14, 40);
+	Put32(data, 18, width);
+	Put32(data, 22, static_cast<uint32_t>(height));
+	return data;
+}
+
+// DX10 extended header when dxgiFormat is set, a legacy four character code otherwise
+std::vector<uint8_t> MakeDds(uint32_t width, uint32_t height, uint32_t mips, const char (&fourCC)[5], uint32_t dxgiFormat = 0)
+{
+	std::vector<uint8_t> data(dxgiFormat ? 148 : 128);
+	std::copy_n("DDS ", 4, data.begin());
+	Put32(data, 4, 124);
+	Put32(data, 12, height);
+	Put32(data, 16, width);
+	Put32(data, 28, mips);
+	Put32(data, 76, 32);
+	Put32(data, 80, 0x4);
+	std::copy_n(fourCC, 4, data.begin() + 84);
+	if (dxgiFormat) {
+		Put32(data, 128, dxgiFormat);
+		Put32(data, 132, 3); // Texture2D
+		Put32(data, 140, 1);
+	}
+	return data;
+}
+
+void ExpectInfo(const std::vector<uint8_t> &data, uint32_t width, uint32_t height, TextureFormat format, uint32_t mips)
+{
+	const std::optional<TextureInfo> info = ReadTextureInfo(data);
+	ASSERT_TRUE(info);
+	EXPECT_EQ(info->width, width);
+	EXPECT_EQ(info->height, height);
+	EXPECT_EQ(info->format, format);
+	EXPECT_EQ(info->mipLevels, mips);
+}
+
+TextureInfo MakeInfo(uint32_t width, uint32_t height)
+{
+	return {.width = width, .height = height, .format = TEXTURE_FORMAT_RGBA8, .mipLevels = 1, .resizable = true};
+}
+
+std::vector<SceneTexture> MakeTextures()
+{
+	std::mt19937 rng{23};
+	std::uniform_int_distribution<uint32_t> kind{0, 9}, side{200, 2200};
+	std::vector<SceneTexture> textures(TEXTURE_POOL);
+	for (uint32_t i = 0; i < TEXTURE_POOL; i++) {
+		SceneTexture &texture = textures[i];
+		const uint32_t k = kind(rng);
+		if (k < 5) {
+			texture.name = "textures/diffuse_" + std::to_string(i) + ".png";
+			texture.header = MakePng(side(rng), side(rng));
+		} else if (k < 7) {
+			texture.name = "textures/detail_" + std::to_string(i) + ".jpg";
+			texture.header = MakeJpeg(side(rng), side(rng));
+		} else if (k < 9) {
+			texture.name = "textures/normal_" + std::to_string(i) + ".dds";
+			texture.header = MakeDds(1024, 1024, 11, "DX10", 98);
+		} else {
+			texture.name = "textures/mask_" + std::to_string(i) + ".dds";
+			texture.header = MakeDds(512, 512, 10, "DXT1");
+		}
+	}
+	return textures;
+}
+
+// Few textures per slot, so models end up sharing whole materials too
+std::vector<SceneMaterial> MakeMaterials(uint32_t count)
+{
+	std::mt19937 rng{24};
+	std::uniform_int_distribution<int32_t> texture{0, TEXTURE_POOL - 1}, present{0, 3};
+	std::vector<SceneMaterial> materials(count);
+	for (SceneMaterial &material : materials) {
+		material[TEXTURE_SLOT_DIFFUSE] = texture(rng) % SLOT_TEXTURES;
+		for (size_t slot = TEXTURE_SLOT_SPECULAR; slot < TEXTURE_SLOT_COUNT; slot++) {
+			const int32_t first = SLOT_TEXTURES * static_cast<int32_t>(slot);
+			material[slot] = present(rng) == 0 ? -1 : first + texture(rng) % SLOT_TEXTURES;
+		}
+	}
+	return materials;
+}
+} // namespace
+
+TEST(TextureInfo, ReadsHeaders)
+{
+	ExpectInfo(MakePng(300, 200), 300, 200, TEXTURE_FORMAT_RGBA8, 1);
+	ExpectInfo(MakeJpeg(640, 480), 640, 480, TEXTURE_FORMAT_RGBA8, 1);
+	// Negative BMP heights are top down rows
+	ExpectInfo(MakeBmp(64, -32), 64, 32, TEXTURE_FORMAT_RGBA8, 1);
+	ExpectInfo(MakeDds(1024, 512, 11, "DX10", 98), 1024, 512, TEXTURE_FORMAT_BC7, 11);
+	ExpectInfo(MakeDds(512, 512, 10, "DXT1"), 512, 512, TEXTURE_FORMAT_BC1, 10);
+}
+
+TEST(TextureInfo, RejectsCubemapsAndCutHeaders)
+{
+	std::vector<uint8_t> cubemap = MakeDds(256, 256, 1, "DXT1");
+	Put32(cubemap, 112, 0x200);
+	const std::optional<TextureInfo> cubemapInfo = ReadTextureInfo(cubemap);
+	ASSERT_TRUE(cubemapInfo);
+	EXPECT_EQ(cubemapInfo->format, TEXTURE_FORMAT_UNKNOWN);
+
+	const std::vector<uint8_t> png = MakePng(300, 200);
+	EXPECT_FALSE(ReadTextureInfo(std::span{png}.first(20)));
+	EXPECT_FALSE(ReadTextureInfo({}));
+	const std::vector<uint8_t> text{'h', 'e', 'l', 'l', 'o'};
+	EXPECT_FALSE(ReadTextureInfo(text));
+}
+
+TEST(TextureBucketKey, NearestPowerOfTwoForDecodedImages)
+{
+	EXPECT_EQ(GetBucketKey(*ReadTextureInfo(MakePng(300, 200))).width, 256u);
+	EXPECT_EQ(GetBucketKey(*ReadTextureInfo(MakePng(400, 90))).width, 512u);
+	const TextureBucketKey key = GetBucketKey(MakeInfo(1000, 700));
+	EXPECT_EQ(key.width, 1024u);
+	EXPECT_EQ(key.height, 1024u);
+	EXPECT_EQ(key.mipLevels, 11u);
+	EXPECT_EQ(GetBucketKey(MakeInfo(8, 8)).width, 64u);
+	EXPECT_EQ(GetBucketKey(MakeInfo(9000, 9000)).width, 2048u);
+
+	// Block compressed textures keep their exact size and mips
+	const TextureBucketKey compressed = GetBucketKey(*ReadTextureInfo(MakeDds(1024, 512, 11, "DX10", 98)));
+	EXPECT_EQ(compressed.format, TEXTURE_FORMAT_BC7);
+	EXPECT_EQ(compressed.width, 1024u);
+	EXPECT_EQ(compressed.height, 512u);
+	EXPECT_EQ(compressed.mipLevels, 11u);
+}
+
+TEST(MaterialTable, TexturesAndMaterialsOfAScene)
+{
+	const std::vector<SceneTexture> textures = MakeTextures();
+	const std::vector<SceneMaterial> scene = MakeMaterials(MODEL_COUNT);
+	MaterialTable table;
+	std::vector<uint32_t> indices;
+	for (const SceneMaterial &material : scene) {
+		MaterialEntry entry;
+		for (size_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++) {
+			if (material[slot] >= 0) {
+				const SceneTexture &texture = textures[material[slot]];
+				entry.textures[slot] = table.AddTexture(texture.name, *ReadTextureInfo(texture.header));
+			}
+		}
+		indices.push_back(table.AddMaterial(entry));
+	}
+
+	// Every texture sits in a bucket of its own key under its own name
+	const std::span<const TextureBucket> buckets = table.GetBuckets();
+	const std::span<const MaterialEntry> materials = table.GetMaterials();
+	for (size_t i = 0; i < scene.size(); i++) {
+		ASSERT_LT(indices[i], materials.size());
+		const MaterialEntry &entry = materials[indices[i]];
+		for (size_t slot = 0; slot < TEXTURE_SLOT_COUNT; slot++) {
+			const TextureRef ref = entry.textures[slot];
+			if (scene[i][slot] < 0) {
+				EXPECT_FALSE(ref.IsValid());
+				continue;
+			}
+			const SceneTexture &texture = textures[scene[i][slot]];
+			ASSERT_TRUE(ref.IsValid());
+			ASSERT_LT(ref.bucket, buckets.size());
+			ASSERT_LT(ref.slice, buckets[ref.bucket].textures.size());
+			EXPECT_EQ(buckets[ref.bucket].textures[ref.slice], texture.name);
+			EXPECT_EQ(buckets[ref.bucket].key, GetBucketKey(*ReadTextureInfo(texture.header)));
+			EXPECT_EQ(table.FindTexture(texture.name), ref);
+		}
+	}
+	// Identical materials share one entry
+	EXPECT_EQ(std::set<SceneMaterial>(scene.begin(), scene.end()).size(), materials.size());
+	EXPECT_FALSE(table.FindTexture("textures/missing.png"));
+}
+
+TEST(MaterialTable, FullBucketsOpenAnotherUpToTheLimit)
+{
+	MaterialTable table{{.minSize = 64, .maxSize = 2048, .maxSlices = 2, .maxBuckets = 2}};
+	const TextureRef first = table.AddTexture("a.png", MakeInfo(256, 256));
+	EXPECT_EQ(table.AddTexture("a.png", MakeInfo(256, 256)), first);
+	const TextureRef second = table.AddTexture("b.png", MakeInfo(256, 256));
+	const TextureRef third = table.AddTexture("c.png", MakeInfo(256, 256));
+	EXPECT_EQ(first.bucket, second.bucket);
+	EXPECT_EQ(second.slice, 1u);
+	EXPECT_NE(third.bucket, first.bucket);
+	EXPECT_EQ(third.slice, 0u);
+	ASSERT_EQ(table.GetBuckets().size(), 2u);
+	EXPECT_EQ(table.GetBuckets()[0].key, table.GetBuckets()[1].key);
+
+	// No room for a third bucket, and unknown formats never get a slice
+	EXPECT_FALSE(table.AddTexture("d.png", MakeInfo(64, 64)).IsValid());
+	EXPECT_FALSE(table.AddTexture("e.dds", {.width = 64, .height = 64}).IsValid());
+	EXPECT_TRUE(table.AddTexture("c.png", MakeInfo(256, 256)).IsValid());
+}
+
+TEST(MaterialTable, PlannedTexturesKeepTheirSlices)
+{
+	MaterialTable cook;
+	cook.AddTexture("a.png", MakeInfo(256, 256));
+	cook.AddTexture("b.png", MakeInfo(512, 512));
+	cook.AddTexture("c.png", MakeInfo(256, 256));
+	cook.AddTexture("d.png", MakeInfo(256, 256));
+	const std::vector<uint8_t> plan = SerializeTextureBuckets(cook.GetBuckets());
+
+	MaterialTable table;
+	ASSERT_TRUE(table.UsePlan(*DeserializeTextureBuckets(plan)));
+	EXPECT_FALSE(table.UsePlan(cook.GetBuckets()));
+	// Added in another order than the cook saw them, and not all of them
+	EXPECT_EQ(table.AddTexture("d.png", MakeInfo(256, 256)), cook.FindTexture("d.png"));
+	EXPECT_EQ(table.AddTexture("b.png", MakeInfo(512, 512)), cook.FindTexture("b.png"));
+	EXPECT_FALSE(table.FindTexture("a.png"));
+
+	// Textures changed since the cook and new ones go after the planned slices
+	const TextureRef changed = table.AddTexture("a.png", MakeInfo(1024, 1024));
+	EXPECT_NE(changed, cook.FindTexture("a.png"));
+	EXPECT_EQ(table.GetBuckets()[changed.bucket].key, GetBucketKey(MakeInfo(1024, 1024)));
+	const TextureRef added = table.AddTexture("e.png", MakeInfo(256, 256));
+	EXPECT_EQ(added.bucket, cook.FindTexture("c.png")->bucket);
+	EXPECT_EQ(added.slice, 3u);
+	EXPECT_EQ(table.AddTexture("c.png", MakeInfo(256, 256)), cook.FindTexture("c.png"));
+}
+
+TEST(TextureBuckets, RoundTripAndRejectBadData)
+{
+	MaterialTable table;
+	table.AddTexture("a.png", MakeInfo(256, 256));
+	table.AddTexture("b.dds", *ReadTextureInfo(MakeDds(512, 512, 10, "DXT1")));
+	table.AddTexture("c.png", MakeInfo(200, 220));
+	const std::vector<uint8_t> data = SerializeTextureBuckets(table.GetBuckets());
+
+	const auto loaded = DeserializeTextureBuckets(data);
+	ASSERT_TRUE(loaded);
+	ASSERT_EQ(loaded->size(), table.GetBuckets().size());
+	for (size_t i = 0; i < loaded->size(); i++) {
+		EXPECT_EQ((*loaded)[i].key, table.GetBuckets()[i].key);
+		EXPECT_EQ((*loaded)[i].textures, table.GetBuckets()[i].textures);
+	}
+
+	EXPECT_FALSE(DeserializeTextureBuckets(std::span{data}.first(data.size() - 1)));
+	std::vector<uint8_t> corrupt = data;
+	corrupt[0] ^= 0xFF;
+	EXPECT_FALSE(DeserializeTextureBuckets(corrupt));
+	corrupt = data;
+	Put32(corrupt, 4, TEXTURE_BUCKETS_VERSION + 1);
+	EXPECT_FALSE(DeserializeTextureBuckets(corrupt));
+}
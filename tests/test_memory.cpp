@@ -0,0 +1,173 @@
+#include "core/content_registry.h"
+#include "core/job_system.h"
+#include "core/memory_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <string_view>
+
+using namespace TGW;
+
+namespace {
+constexpr uint32_t THREAD_BLOCKS = 20000;
+
+// What the global tracker holds for the scene tag, the tests count relative to it
+MemoryStats GetScene() { return MemoryTracker::Get().GetStats(MEMORY_TAG_SCENE, MEMORY_POOL_CPU); }
+
+// Shared the way MeshGeometry is, one count for every user of the same content
+struct SharedBlock {
+	TrackedAllocation memory;
+};
+} // namespace
+
+TEST(MemoryTracker, ExactWhileThreadsAllocateAndFree)
+{
+	MemoryTracker tracker;
+	JobSystem jobs{3};
+	const uint32_t threads = jobs.GetWorkerCount() + 1;
+	// Every thread frees every other block it allocates, the rest stay live
+	std::vector<uint64_t> kept(threads);
+	jobs.ParallelFor(threads, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t t = begin; t < end; t++) {
+			std::mt19937 rng{31 + t};
+			std::uniform_int_distribution<uint32_t> size{1, 4096};
+			for (uint32_t i = 0; i < THREAD_BLOCKS; i++) {
+				const uint32_t bytes = size(rng);
+				tracker.Allocate(MEMORY_TAG_MESHES, MEMORY_POOL_GPU, bytes);
+				if (i % 2) {
+					tracker.Free(MEMORY_TAG_MESHES, MEMORY_POOL_GPU, bytes);
+				} else {
+					kept[t] += bytes;
+				}
+			}
+		}
+	});
+
+	uint64_t expected = 0;
+	for (uint64_t bytes : kept) {
+		expected += bytes;
+	}
+	const MemoryStats stats = tracker.GetStats(MEMORY_TAG_MESHES, MEMORY_POOL_GPU);
+	EXPECT_EQ(stats.liveBytes, expected);
+	EXPECT_EQ(stats.liveCount, uint64_t{threads} * THREAD_BLOCKS / 2);
+	EXPECT_EQ(stats.totalCount, uint64_t{threads} * THREAD_BLOCKS);
+	EXPECT_GE(stats.peakBytes, expected);
+	EXPECT_EQ(tracker.GetTotal(MEMORY_POOL_GPU).liveBytes, expected);
+
+	tracker.ResetPeaks();
+	EXPECT_EQ(tracker.GetStats(MEMORY_TAG_MESHES, MEMORY_POOL_GPU).peakBytes, expected);
+}
+
+TEST(MemoryTracker, PeaksFollowLiveBytesUntilReset)
+{
+	MemoryTracker tracker;
+	tracker.Allocate(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, 100);
+	tracker.Allocate(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, 50);
+	tracker.Free(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, 100);
+	MemoryStats stats = tracker.GetStats(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU);
+	EXPECT_EQ(stats.liveBytes, 50u);
+	EXPECT_EQ(stats.peakBytes, 150u);
+	EXPECT_EQ(stats.liveCount, 1u);
+	EXPECT_EQ(stats.totalCount, 2u);
+
+	tracker.ResetPeaks();
+	EXPECT_EQ(tracker.GetStats(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU).peakBytes, 50u);
+	tracker.Allocate(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, 20);
+	tracker.Free(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU, 20);
+	stats = tracker.GetStats(MEMORY_TAG_TEXTURES, MEMORY_POOL_GPU);
+	EXPECT_EQ(stats.liveBytes, 50u);
+	EXPECT_EQ(stats.peakBytes, 70u);
+}
+
+TEST(MemoryTracker, TagsAndPoolsCountApart)
+{
+	MemoryTracker tracker;
+	tracker.Allocate(MEMORY_TAG_MESHES, MEMORY_POOL_CPU, 10);
+	tracker.Allocate(MEMORY_TAG_GUI, MEMORY_POOL_CPU, 30);
+	tracker.Free(MEMORY_TAG_GUI, MEMORY_POOL_CPU, 30);
+	tracker.Allocate(MEMORY_TAG_LOGS, MEMORY_POOL_GPU, 5);
+
+	EXPECT_EQ(tracker.GetStats(MEMORY_TAG_MESHES, MEMORY_POOL_CPU).liveBytes, 10u);
+	EXPECT_EQ(tracker.GetStats(MEMORY_TAG_MESHES, MEMORY_POOL_GPU).totalCount, 0u);
+	EXPECT_EQ(tracker.GetStats(MEMORY_TAG_TEXTURES, MEMORY_POOL_CPU).totalCount, 0u);
+	EXPECT_EQ(tracker.GetStats(MEMORY_TAG_LOGS, MEMORY_POOL_CPU).totalCount, 0u);
+
+	// Totals are the sum of the tags, peaks included
+	const MemoryStats cpu = tracker.GetTotal(MEMORY_POOL_CPU);
+	EXPECT_EQ(cpu.liveBytes, 10u);
+	EXPECT_EQ(cpu.peakBytes, 40u);
+	EXPECT_EQ(cpu.liveCount, 1u);
+	EXPECT_EQ(cpu.totalCount, 2u);
+	EXPECT_EQ(tracker.GetTotal(MEMORY_POOL_GPU).liveBytes, 5u);
+
+	std::set<std::string_view> names;
+	for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+		const char *name = MemoryTracker::GetTagName(static_cast<MemoryTag>(tag));
+		ASSERT_NE(name, nullptr);
+		names.insert(name);
+	}
+	EXPECT_EQ(names.size(), size_t{MEMORY_TAG_COUNT});
+}
+
+TEST(TrackedAllocator, CountsLiveBlocksOfAContainer)
+{
+	const MemoryStats before = GetScene();
+	{
+		std::vector<uint64_t, TrackedAllocator<uint64_t, MEMORY_TAG_SCENE>> values;
+		for (uint64_t i = 0; i < 1000; i++) {
+			values.push_back(i);
+		}
+		const MemoryStats filled = GetScene();
+		EXPECT_EQ(filled.liveBytes - before.liveBytes, values.capacity() * sizeof(uint64_t));
+		EXPECT_EQ(filled.liveCount, before.liveCount + 1);
+		EXPECT_GT(filled.totalCount, before.totalCount + 1);
+	}
+	EXPECT_EQ(GetScene().liveBytes, before.liveBytes);
+	EXPECT_EQ(GetScene().liveCount, before.liveCount);
+}
+
+TEST(TrackedAllocation, CopiesCountAgainMovesDoNot)
+{
+	const MemoryStats before = GetScene();
+	{
+		TrackedAllocation first{MEMORY_TAG_SCENE, MEMORY_POOL_CPU, 100};
+		const TrackedAllocation copy = first;
+		TrackedAllocation moved = std::move(first);
+		const TrackedAllocation empty;
+		const TrackedAllocation emptyCopy = empty;
+		EXPECT_EQ(GetScene().liveBytes, before.liveBytes + 200);
+		EXPECT_EQ(GetScene().liveCount, before.liveCount + 2);
+		EXPECT_EQ(first.GetBytes(), 0u);
+		EXPECT_EQ(copy.GetBytes(), 100u);
+		EXPECT_EQ(moved.GetBytes(), 100u);
+		EXPECT_EQ(emptyCopy.GetBytes(), 0u);
+
+		// Assigning over a live allocation frees what it held
+		moved = TrackedAllocation{MEMORY_TAG_SCENE, MEMORY_POOL_CPU, 30};
+		EXPECT_EQ(GetScene().liveBytes, before.liveBytes + 130);
+	}
+	EXPECT_EQ(GetScene().liveBytes, before.liveBytes);
+	EXPECT_EQ(GetScene().liveCount, before.liveCount);
+}
+
+TEST(TrackedAllocation, SharedContentCountsOnceUntilItsLastUser)
+{
+	const MemoryStats before = GetScene();
+	ContentRegistry<SharedBlock> registry;
+	const ContentKey key{.hash = {.low = 1, .high = 2}, .bytes = 64};
+	const auto make = [] { return std::optional<SharedBlock>{{TrackedAllocation{MEMORY_TAG_SCENE, MEMORY_POOL_CPU, 64}}}; };
+
+	std::shared_ptr<const SharedBlock> first = registry.Acquire(key, make);
+	std::shared_ptr<const SharedBlock> second = registry.Acquire(key, make);
+	ASSERT_EQ(first, second);
+	EXPECT_EQ(GetScene().liveBytes, before.liveBytes + 64);
+	EXPECT_EQ(GetScene().liveCount, before.liveCount + 1);
+
+	first.reset();
+	EXPECT_EQ(GetScene().liveBytes, before.liveBytes + 64);
+	second.reset();
+	EXPECT_EQ(GetScene().liveBytes, before.liveBytes);
+	EXPECT_EQ(GetScene().liveCount, before.liveCount);
+}
@@ -0,0 +1,241 @@
+#include "nav/nav_query.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <thread>
+
+using DirectX::XMFLOAT3;
+using namespace TGW::Nav;
+
+namespace {
+// A 256 m map of gentle hills cut in two by a wall with a 4 m gap, the map bench_navmesh times
+constexpr uint32_t MAP_SAMPLES = 257;
+constexpr float MAP_SIZE = 256.0f;
+constexpr float WALL_X = 128.0f;
+constexpr float GAP_MIN_Z = 120.0f;
+constexpr float GAP_MAX_Z = 124.0f;
+
+float GetGroundHeight(float x, float z) { return 2.0f * std::sin(x * 0.05f) * std::cos(z * 0.04f); }
+
+const TGW::Terrain::Heightmap &GetTerrain()
+{
+	static const TGW::Terrain::Heightmap terrain = [] {
+		std::vector<float> heights(MAP_SAMPLES * MAP_SAMPLES);
+		for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+			for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+				heights[z * MAP_SAMPLES + x] = GetGroundHeight(static_cast<float>(x), static_cast<float>(z));
+			}
+		}
+		return TGW::Terrain::Heightmap{MAP_SAMPLES, MAP_SAMPLES, 1.0f, {0.0f, 0.0f}, std::move(heights)};
+	}();
+	return terrain;
+}
+
+// A closed box from min to max, the way a loaded building mesh would come in
+NavGeometry MakeBox(XMFLOAT3 min, XMFLOAT3 max)
+{
+	MeshData box;
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		box.vertices.push_back(Vertex{
+		  .position = {corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z},
+		  .normal = {0.0f, 1.0f, 0.0f},
+		  .texCoords = {0.0f, 0.0f},
+		});
+	}
+	box.indices = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+	return NavGeometry::FromMeshes(std::span{&box, 1}, DirectX::XMMatrixIdentity());
+}
+
+NavGeometry MakeGapBuilding()
+{
+	return MakeBox({WALL_X - 3.0f, -3.0f, GAP_MIN_Z - 1.0f}, {WALL_X + 3.0f, 6.0f, GAP_MAX_Z + 1.0f});
+}
+
+std::unique_ptr<NavMesh> MakeMesh(float agentRadius, TGW::JobSystem &jobs)
+{
+	const NavMeshSettings settings{.agentRadius = agentRadius};
+	auto mesh = std::make_unique<NavMesh>(settings, DirectX::XMFLOAT2{0.0f, 0.0f}, DirectX::XMFLOAT2{MAP_SIZE, MAP_SIZE},
+		&GetTerrain());
+	mesh->AddGeometry(MakeBox({WALL_X - 0.5f, -3.0f, -1.0f}, {WALL_X + 0.5f, 4.0f, GAP_MIN_Z}));
+	mesh->AddGeometry(MakeBox({WALL_X - 0.5f, -3.0f, GAP_MAX_Z}, {WALL_X + 0.5f, 4.0f, MAP_SIZE + 1.0f}));
+	mesh->Build(jobs);
+	return mesh;
+}
+
+XMFLOAT3 OnGround(float x, float z) { return {x, GetGroundHeight(x, z), z}; }
+
+const XMFLOAT3 WEST = OnGround(40.0f, 30.0f);
+const XMFLOAT3 EAST = OnGround(220.0f, 200.0f);
+
+bool IsSameTile(const NavTile &a, const NavTile &b)
+{
+	const auto samePoly = [](const NavPoly &p, const NavPoly &q) {
+		return p.minX == q.minX && p.minZ == q.minZ && p.maxX == q.maxX && p.maxZ == q.maxZ && p.y == q.y &&
+			p.firstLink == q.firstLink && p.linkCount == q.linkCount;
+	};
+	const auto sameLink = [](const NavLink &p, const NavLink &q) {
+		return p.poly == q.poly && p.side == q.side && p.begin == q.begin && p.end == q.end;
+	};
+	const auto sameEdge = [](const NavBorderEdge &p, const NavBorderEdge &q) {
+		return p.poly == q.poly && p.begin == q.begin && p.end == q.end && p.minY == q.minY && p.maxY == q.maxY;
+	};
+	if (!std::ranges::equal(a.polys, b.polys, samePoly) || !std::ranges::equal(a.links, b.links, sameLink)) {
+		return false;
+	}
+	for (uint32_t side = 0; side < NAV_SIDE_COUNT; side++) {
+		if (!std::ranges::equal(a.borders[side], b.borders[side], sameEdge)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Every corner and every quarter metre between them has to be on a polygon
+bool IsOnMesh(const NavQuery &query, const std::vector<XMFLOAT3> &path)
+{
+	for (size_t i = 1; i < path.size(); i++) {
+		const XMFLOAT3 &a = path[i - 1];
+		const XMFLOAT3 &b = path[i];
+		const float length = std::hypot(b.x - a.x, b.z - a.z);
+		const uint32_t steps = std::max(1u, static_cast<uint32_t>(length / 0.25f));
+		for (uint32_t step = 0; step <= steps; step++) {
+			const float t = static_cast<float>(step) / steps;
+			const float x = a.x + (b.x - a.x) * t, z = a.z + (b.z - a.z) * t;
+			if (!query.FindPoly(OnGround(x, z)).IsValid()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Crosses the wall exactly once, inside the gap
+bool GoesThroughGap(const std::vector<XMFLOAT3> &path)
+{
+	uint32_t crossings = 0;
+	for (size_t i = 1; i < path.size(); i++) {
+		const XMFLOAT3 &a = path[i - 1];
+		const XMFLOAT3 &b = path[i];
+		if ((a.x < WALL_X) != (b.x < WALL_X)) {
+			const float z = a.z + (b.z - a.z) * (WALL_X - a.x) / (b.x - a.x);
+			if (z < GAP_MIN_Z || z > GAP_MAX_Z) {
+				return false;
+			}
+			crossings++;
+		}
+	}
+	return crossings == 1;
+}
+} // namespace
+
+TEST(NavMesh, SameTilesOnAnyThreadCount)
+{
+	TGW::JobSystem one{0}, many{3};
+	const std::unique_ptr<NavMesh> serial = MakeMesh(0.5f, one);
+	const std::unique_ptr<NavMesh> wide = MakeMesh(0.5f, many);
+	const auto serialTiles = serial->GetSnapshot();
+	const auto wideTiles = wide->GetSnapshot();
+	ASSERT_EQ(serialTiles->tiles.size(), wideTiles->tiles.size());
+	for (size_t tile = 0; tile < serialTiles->tiles.size(); tile++) {
+		ASSERT_TRUE(serialTiles->tiles[tile]);
+		ASSERT_TRUE(wideTiles->tiles[tile]);
+		EXPECT_TRUE(IsSameTile(*serialTiles->tiles[tile], *wideTiles->tiles[tile])) << tile;
+	}
+}
+
+// Across the wall through the gap, and along one side without going near it
+TEST(NavQuery, CrossesTheWallOnlyThroughTheGap)
+{
+	TGW::JobSystem jobs{3};
+	const std::unique_ptr<NavMesh> mesh = MakeMesh(0.5f, jobs);
+	NavQuery query{*mesh};
+	std::vector<XMFLOAT3> path;
+	const std::optional<float> across = query.FindPath(WEST, EAST, path);
+	const float straight = std::hypot(180.0f, 170.0f);
+	ASSERT_TRUE(across);
+	EXPECT_GE(*across, straight);
+	EXPECT_LE(*across, straight * 1.2f);
+	EXPECT_TRUE(GoesThroughGap(path));
+	EXPECT_TRUE(IsOnMesh(query, path));
+
+	ASSERT_TRUE(query.FindPath(OnGround(20.0f, 20.0f), OnGround(100.0f, 240.0f), path));
+	EXPECT_TRUE(IsOnMesh(query, path));
+	EXPECT_TRUE(std::ranges::none_of(path, [](const XMFLOAT3 &p) { return p.x > WALL_X; }));
+}
+
+TEST(NavQuery, TanksDoNotFitThroughTheGap)
+{
+	TGW::JobSystem jobs{3};
+	const std::unique_ptr<NavMesh> tanks = MakeMesh(2.5f, jobs);
+	NavQuery query{*tanks};
+	std::vector<XMFLOAT3> path;
+	EXPECT_FALSE(query.FindPath(WEST, EAST, path));
+	EXPECT_TRUE(query.FindPath(WEST, OnGround(100.0f, 200.0f), path));
+}
+
+// A building in the gap closes it after rebuilding only the tiles around it, and its roof is its own island
+TEST(NavMesh, BuildingRebuildsOnlyTheTilesAroundIt)
+{
+	TGW::JobSystem jobs{3};
+	const std::unique_ptr<NavMesh> mesh = MakeMesh(0.5f, jobs);
+	NavQuery query{*mesh};
+	std::vector<XMFLOAT3> path;
+	const std::shared_ptr<const NavSnapshot> before = mesh->GetSnapshot();
+	const uint32_t building = mesh->AddGeometry(MakeGapBuilding());
+	const uint32_t rebuilt = mesh->RebuildDirtyAsync(jobs);
+	mesh->WaitForRebuilds();
+	EXPECT_EQ(mesh->GetPendingRebuilds(), 0u);
+
+	const std::shared_ptr<const NavSnapshot> closed = mesh->GetSnapshot();
+	uint32_t changed = 0;
+	for (size_t tile = 0; tile < before->tiles.size(); tile++) {
+		changed += before->tiles[tile] != closed->tiles[tile];
+	}
+	EXPECT_GT(rebuilt, 0u);
+	EXPECT_LE(rebuilt, 4u);
+	EXPECT_EQ(changed, rebuilt);
+	const XMFLOAT3 roof{WALL_X, 6.0f, (GAP_MIN_Z + GAP_MAX_Z) * 0.5f};
+	EXPECT_TRUE(query.FindPoly(roof).IsValid());
+	EXPECT_FALSE(query.FindPath(WEST, EAST, path));
+	EXPECT_FALSE(query.FindPath(OnGround(110.0f, 122.0f), roof, path));
+
+	mesh->RemoveGeometry(building);
+	EXPECT_GT(mesh->RebuildDirtyAsync(jobs), 0u);
+	mesh->WaitForRebuilds();
+	ASSERT_TRUE(query.FindPath(WEST, EAST, path));
+	EXPECT_TRUE(GoesThroughGap(path));
+	EXPECT_EQ(mesh->RebuildDirtyAsync(jobs), 0u);
+}
+
+// Queries on another thread while the gap opens and closes, every answer has to be a whole path or none
+TEST(NavMesh, QueriesStayWholeWhileRebuildsSwapIn)
+{
+	TGW::JobSystem jobs{3};
+	const std::unique_ptr<NavMesh> mesh = MakeMesh(0.5f, jobs);
+	std::atomic<bool> stop = false;
+	std::atomic<uint32_t> broken = 0;
+	std::thread querying{[&] {
+		NavQuery concurrent{*mesh};
+		std::vector<XMFLOAT3> corners;
+		while (!stop) {
+			if (concurrent.FindPath(WEST, EAST, corners) && !GoesThroughGap(corners)) {
+				broken++;
+			}
+		}
+	}};
+	for (uint32_t round = 0; round < 8; round++) {
+		const uint32_t id = mesh->AddGeometry(MakeGapBuilding());
+		mesh->RebuildDirtyAsync(jobs);
+		mesh->RemoveGeometry(id);
+		mesh->RebuildDirtyAsync(jobs);
+	}
+	mesh->WaitForRebuilds();
+	stop = true;
+	querying.join();
+	EXPECT_EQ(broken, 0u);
+
+	NavQuery query{*mesh};
+	std::vector<XMFLOAT3> path;
+	EXPECT_TRUE(query.FindPath(WEST, EAST, path));
+}
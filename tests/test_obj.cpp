@@ -0,0 +1,153 @@
+#include "cook/model_compare.h"
+#include "obj/obj_loader.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+const fs::path DATA_DIR = SHELLSHOCK_TEST_DATA_DIR;
+
+// Two 3x3 quad height field grids with their own materials, v/vt/vn corners, the second grid indexed back from its
+// last vertex
+const fs::path OBJ_PATH = DATA_DIR / "grid.obj";
+constexpr uint32_t GRID_SIZE = 3;
+constexpr uint32_t GRID_COUNT = 2;
+
+// What grid.obj was written from, multiples of 1/8 print and parse exactly
+Vertex GetGridVertex(uint32_t x, uint32_t z, uint32_t grid)
+{
+	const float side = static_cast<float>(GRID_SIZE);
+	return Vertex{
+	  .position = {static_cast<float>(x), static_cast<float>((x * 7 + z * 13 + grid * 5) % 64) * 0.125f,
+		  static_cast<float>(z) + grid * (side + 2.0f)},
+	  .normal = {static_cast<float>((x + z) % 4) * 0.25f, 1.0f, 0.0f},
+	  .texCoords = {static_cast<float>(x) / 4.0f, static_cast<float>(z) / 4.0f},
+	};
+}
+
+bool IsSameVertex(const Vertex &a, const Vertex &b) { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+} // namespace
+
+// Quads are fanned from their first corner, each grid welds down to one vertex per grid point
+TEST(ObjLoader, LoadsGridsWithMaterials)
+{
+	TGW::JobSystem jobs{0};
+	const std::optional<TGW::Obj::ObjModel> model = TGW::Obj::Load(OBJ_PATH, jobs);
+	ASSERT_TRUE(model);
+	ASSERT_EQ(model->meshes.size(), GRID_COUNT);
+	ASSERT_EQ(model->materials.size(), GRID_COUNT + 1);
+	ASSERT_EQ(model->files.size(), 2u);
+	EXPECT_EQ(model->files[0], OBJ_PATH);
+	EXPECT_EQ(model->materials[1].textures[TEXTURE_SLOT_DIFFUSE], "rock.png");
+	EXPECT_EQ(model->materials[2].textures[TEXTURE_SLOT_DIFFUSE], "grass.png");
+	EXPECT_EQ(model->materials[2].textures[TEXTURE_SLOT_NORMAL], "grass_n.png");
+
+	const uint32_t side = GRID_SIZE + 1;
+	const uint32_t fan[6] = {0, 1, 2, 0, 2, 3};
+	for (uint32_t grid = 0; grid < GRID_COUNT; grid++) {
+		const MeshData &mesh = model->meshes[grid];
+		EXPECT_EQ(mesh.materialIndex, grid + 1);
+		EXPECT_EQ(mesh.vertices.size(), side * side);
+		ASSERT_EQ(mesh.indices.size(), GRID_SIZE * GRID_SIZE * 6);
+		for (uint32_t quad = 0; quad < GRID_SIZE * GRID_SIZE; quad++) {
+			const uint32_t x = quad % GRID_SIZE, z = quad / GRID_SIZE;
+			const Vertex corners[4] = {GetGridVertex(x, z, grid), GetGridVertex(x, z + 1, grid),
+				GetGridVertex(x + 1, z + 1, grid), GetGridVertex(x + 1, z, grid)};
+			for (uint32_t i = 0; i < 6; i++) {
+				const uint32_t index = mesh.indices[quad * 6 + i];
+				ASSERT_LT(index, mesh.vertices.size());
+				EXPECT_TRUE(IsSameVertex(mesh.vertices[index], corners[fan[i]])) << grid << ", " << quad << ", " << i;
+			}
+		}
+	}
+}
+
+TEST(ObjLoader, SameOnAnyThreadCount)
+{
+	TGW::JobSystem one{0}, many{7};
+	const std::optional<TGW::Obj::ObjModel> single = TGW::Obj::Load(OBJ_PATH, one);
+	const std::optional<TGW::Obj::ObjModel> wide = TGW::Obj::Load(OBJ_PATH, many);
+	ASSERT_TRUE(single);
+	ASSERT_TRUE(wide);
+	ASSERT_EQ(single->meshes.size(), wide->meshes.size());
+	for (size_t i = 0; i < single->meshes.size(); i++) {
+		const MeshData &a = single->meshes[i];
+		const MeshData &b = wide->meshes[i];
+		EXPECT_EQ(a.indices, b.indices);
+		ASSERT_EQ(a.vertices.size(), b.vertices.size());
+		EXPECT_EQ(std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)), 0);
+	}
+}
+
+// Odd corners of the format no fixture needs to carry, written as text into a directory of the test's own
+class ObjTextTest : public testing::Test {
+  protected:
+	void SetUp() override
+	{
+		const char *test = testing::UnitTest::GetInstance()->current_test_info()->name();
+		_root = fs::temp_directory_path() / "shellshock_test_obj" / test;
+		fs::remove_all(_root);
+		fs::create_directories(_root);
+	}
+
+	void TearDown() override
+	{
+		std::error_code error;
+		fs::remove_all(_root, error);
+	}
+
+	std::optional<TGW::Obj::ObjModel> LoadText(const std::string &name, const std::string &text) const
+	{
+		std::ofstream{_root / name, std::ios::binary} << text;
+		TGW::JobSystem jobs{0};
+		return TGW::Obj::Load(_root / name, jobs);
+	}
+
+  private:
+	fs::path _root;
+};
+
+// CRLF, v//n and v/t corners, a pentagon, unknown statements and a material no library has
+TEST_F(ObjTextTest, HandlesOddCorners)
+{
+	const std::optional<TGW::Obj::ObjModel> model = LoadText("odd.obj",
+		"v 0 0 0\r\nv 1 0 0\r\nv 1 1 0\r\nv 0 1 0\r\nv -1 0.5 0\r\nvn 0 0 1\r\nvt 0.5\r\n\r\ns off\r\nusemtl missing\r\n"
+		"f 1//1 2//1 3//1 4//1 5//1\r\nl 1 2\r\nf -5/1 -4/1 -3/1\r\n");
+	ASSERT_TRUE(model);
+	ASSERT_EQ(model->meshes.size(), 1u);
+	EXPECT_EQ(model->materials.size(), 1u);
+	const MeshData &mesh = model->meshes[0];
+	EXPECT_EQ(mesh.materialIndex, 0u);
+	// The pentagon and the triangle share positions but not UVs
+	ASSERT_EQ(mesh.indices.size(), 12u);
+	EXPECT_EQ(mesh.vertices.size(), 8u);
+	EXPECT_FLOAT_EQ(mesh.vertices[mesh.indices[9]].texCoords.x, 0.5f);
+	EXPECT_FLOAT_EQ(mesh.vertices[mesh.indices[1]].normal.z, 1.0f);
+	EXPECT_FLOAT_EQ(mesh.vertices[mesh.indices[8]].position.x, -1.0f);
+}
+
+// Past the end, before the start and zero are all out of range, Assimp gets the file instead
+TEST_F(ObjTextTest, RejectsIndicesOutOfRange)
+{
+	EXPECT_FALSE(LoadText("past_end.obj", "v 0 0 0\nf 1 2 3\n"));
+	EXPECT_FALSE(LoadText("before_start.obj", "v 0 0 0\nf -1 -2 -3\n"));
+	EXPECT_FALSE(LoadText("zero.obj", "v 0 0 0\nf 0 1 1\n"));
+	EXPECT_FALSE(LoadText("texcoord.obj", "v 0 0 0\nvt 0 0\nf 1/2 1/1 1/1\n"));
+	EXPECT_FALSE(TGW::Obj::Load(DATA_DIR / "missing.obj"));
+}
+
+// The native loader has to give the editor exactly what the Assimp import did
+TEST(ModelCompare, ObjMatchesAssimp)
+{
+	const std::optional<TGW::Cook::CookedModel> native = TGW::Cook::LoadObjModel(OBJ_PATH);
+	const std::optional<TGW::Cook::CookedModel> assimp = TGW::Cook::ImportModel(OBJ_PATH);
+	ASSERT_TRUE(native);
+	ASSERT_TRUE(assimp);
+	for (const std::string &difference : TGW::Cook::CompareModels(*native, *assimp)) {
+		ADD_FAILURE() << difference;
+	}
+}
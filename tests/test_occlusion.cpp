@@ -0,0 +1,371 @@
+#include "cull/occlusion_culler.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace TGW::Cull;
+
+namespace {
+constexpr uint32_t CITY_BLOCKS = 8;
+constexpr float BLOCK_PITCH = 50.0f;
+constexpr float STREET_WIDTH = 12.0f;
+constexpr uint32_t TOWERS_PER_SIDE = 2;
+constexpr uint32_t FACADE_QUADS = 8; // per side of every face of a tower
+constexpr uint32_t UNIT_COUNT = 4000;
+constexpr float UNIT_SIZE = 2.0f;
+// Pixels the scalar rasterizer may disagree on, those whose centre sits on an edge
+constexpr float MAX_MISMATCH_SHARE = 1e-3f;
+constexpr float DEPTH_EPSILON = 1e-5f;
+
+constexpr DirectX::XMFLOAT3 UNIT_MIN{-UNIT_SIZE * 0.5f, 0.0f, -UNIT_SIZE * 0.5f};
+constexpr DirectX::XMFLOAT3 UNIT_MAX{UNIT_SIZE * 0.5f, UNIT_SIZE, UNIT_SIZE * 0.5f};
+
+// Closed unit cube on the ground, x and z in [-0.5, 0.5], y in [0, 1], every face a grid of quads like a facade
+MeshData MakeTower()
+{
+	MeshData mesh;
+	const auto face = [&](DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 u, DirectX::XMFLOAT3 v) {
+		const uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+		for (uint32_t j = 0; j <= FACADE_QUADS; j++) {
+			for (uint32_t i = 0; i <= FACADE_QUADS; i++) {
+				const float s = static_cast<float>(i) / FACADE_QUADS, t = static_cast<float>(j) / FACADE_QUADS;
+				Vertex &vertex = mesh.vertices.emplace_back();
+				vertex.position = {
+					origin.x + u.x * s + v.x * t, origin.y + u.y * s + v.y * t, origin.z + u.z * s + v.z * t};
+			}
+		}
+		for (uint32_t j = 0; j < FACADE_QUADS; j++) {
+			for (uint32_t i = 0; i < FACADE_QUADS; i++) {
+				const uint32_t a = first + j * (FACADE_QUADS + 1) + i, b = a + 1, c = a + FACADE_QUADS + 1, d = c + 1;
+				mesh.indices.insert(mesh.indices.end(), {a, c, b, b, c, d});
+			}
+		}
+	};
+	// u x v points inwards, so every face is clockwise seen from outside
+	face({-0.5f, 0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
+	face({0.5f, 0.0f, 0.5f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
+	face({-0.5f, 0.0f, 0.5f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f});
+	face({0.5f, 0.0f, -0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f});
+	face({-0.5f, 1.0f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f});
+	face({-0.5f, 0.0f, 0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f});
+	return mesh;
+}
+
+// Closed U-shaped building 20 high, x in [-15, 15] and z in [-10, 10], the notch x in [-5, 5] and z in [-10, 5]
+// opens towards -z. Few, large triangles: the footprint extruded upwards.
+MeshData MakeCourtyard()
+{
+	constexpr float HEIGHT = 20.0f;
+	constexpr std::array<DirectX::XMFLOAT2, 8> outline{{
+	  {-15.0f, -10.0f}, {-5.0f, -10.0f}, {-5.0f, 5.0f}, {5.0f, 5.0f}, {5.0f, -10.0f}, {15.0f, -10.0f}, {15.0f, 10.0f},
+	  {-15.0f, 10.0f}}};
+	// Footprint triangles wound like the outline, so the floor faces down
+	constexpr std::array<uint32_t, 18> footprint{0, 1, 2, 0, 2, 7, 2, 3, 7, 3, 6, 7, 3, 4, 5, 3, 5, 6};
+
+	MeshData mesh;
+	for (const float y : {0.0f, HEIGHT}) {
+		for (const DirectX::XMFLOAT2 &corner : outline) {
+			mesh.vertices.emplace_back().position = {corner.x, y, corner.y};
+		}
+	}
+	const uint32_t top = static_cast<uint32_t>(outline.size());
+	for (size_t i = 0; i < footprint.size(); i += 3) {
+		mesh.indices.insert(mesh.indices.end(), {footprint[i], footprint[i + 1], footprint[i + 2]});
+		mesh.indices.insert(mesh.indices.end(), {top + footprint[i], top + footprint[i + 2], top + footprint[i + 1]});
+	}
+	for (uint32_t i = 0; i < top; i++) {
+		const uint32_t next = (i + 1) % top;
+		mesh.indices.insert(mesh.indices.end(), {next, i, top + i, next, top + i, top + next});
+	}
+	return mesh;
+}
+
+DirectX::XMMATRIX MakeViewProjection(DirectX::FXMVECTOR eye, DirectX::FXMVECTOR target)
+{
+	const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(eye, target, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	return DirectX::XMMatrixMultiply(
+		view, DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3.0f, 16.0f / 9.0f, 0.5f, 3000.0f));
+}
+
+// Blocks of towers with units in the streets, seen from a corner a little above the roofs
+struct City {
+	OccluderMesh tower;
+	std::vector<OccluderInstance> occluders;
+	std::vector<DirectX::XMFLOAT4X4> units;
+	DirectX::XMFLOAT4X4 viewProjection;
+
+	City()
+	{
+		const MeshData towerMesh = MakeTower();
+		tower = BuildOccluderMesh({&towerMesh, 1});
+
+		std::mt19937 rng{5};
+		std::uniform_real_distribution<float> height{15.0f, 80.0f};
+		const float lot = (BLOCK_PITCH - STREET_WIDTH) / TOWERS_PER_SIDE;
+		for (uint32_t z = 0; z < CITY_BLOCKS * TOWERS_PER_SIDE; z++) {
+			for (uint32_t x = 0; x < CITY_BLOCKS * TOWERS_PER_SIDE; x++) {
+				const float centerX = (x / TOWERS_PER_SIDE) * BLOCK_PITCH + STREET_WIDTH + (x % TOWERS_PER_SIDE + 0.5f) * lot;
+				const float centerZ = (z / TOWERS_PER_SIDE) * BLOCK_PITCH + STREET_WIDTH + (z % TOWERS_PER_SIDE + 0.5f) * lot;
+				OccluderInstance &instance = occluders.emplace_back();
+				instance.mesh = &tower;
+				DirectX::XMStoreFloat4x4(&instance.world,
+					DirectX::XMMatrixMultiply(DirectX::XMMatrixScaling(lot - 2.0f, height(rng), lot - 2.0f),
+						DirectX::XMMatrixTranslation(centerX, 0.0f, centerZ)));
+			}
+		}
+
+		// Units stand in the streets running along x and along z
+		std::uniform_real_distribution<float> along{0.0f, CITY_BLOCKS * BLOCK_PITCH}, across{1.0f, STREET_WIDTH - 1.0f};
+		std::uniform_int_distribution<uint32_t> street{0, CITY_BLOCKS - 1};
+		for (uint32_t i = 0; i < UNIT_COUNT; i++) {
+			const float a = along(rng), b = street(rng) * BLOCK_PITCH + across(rng);
+			DirectX::XMStoreFloat4x4(&units.emplace_back(),
+				i % 2 ? DirectX::XMMatrixTranslation(a, 0.0f, b) : DirectX::XMMatrixTranslation(b, 0.0f, a));
+		}
+
+		DirectX::XMStoreFloat4x4(&viewProjection,
+			MakeViewProjection(
+				DirectX::XMVectorSet(-30.0f, 90.0f, -30.0f, 1.0f), DirectX::XMVectorSet(200.0f, 0.0f, 200.0f, 1.0f)));
+	}
+};
+
+// One triangle at a time over its bounds with barycentric weights, no tiles, bins or SIMD
+std::vector<float> RasterizeReference(const City &city, uint32_t width, uint32_t height)
+{
+	std::vector<float> depth(size_t{width} * height, 1.0f);
+	const DirectX::XMMATRIX viewProjection = DirectX::XMLoadFloat4x4(&city.viewProjection);
+	const auto edge = [](const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b, float x, float y) {
+		return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+	};
+	for (const OccluderInstance &occluder : city.occluders) {
+		const DirectX::XMMATRIX transform = DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&occluder.world), viewProjection);
+		for (size_t t = 0; t < occluder.mesh->indices.size(); t += 3) {
+			DirectX::XMFLOAT3 screen[3];
+			bool clipped = false;
+			for (uint32_t k = 0; k < 3; k++) {
+				const DirectX::XMFLOAT3 &p = occluder.mesh->positions[occluder.mesh->indices[t + k]];
+				DirectX::XMFLOAT4 clip;
+				DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(DirectX::XMVectorSet(p.x, p.y, p.z, 1.0f), transform));
+				clipped |= clip.w <= 0.0f || clip.z < 0.0f;
+				screen[k] = {(clip.x / clip.w * 0.5f + 0.5f) * width, (0.5f - clip.y / clip.w * 0.5f) * height, clip.z / clip.w};
+			}
+			const float area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+			if (clipped || area <= 0.0f) {
+				continue;
+			}
+			const float left = std::min({screen[0].x, screen[1].x, screen[2].x});
+			const float right = std::max({screen[0].x, screen[1].x, screen[2].x});
+			const float top = std::min({screen[0].y, screen[1].y, screen[2].y});
+			const float bottom = std::max({screen[0].y, screen[1].y, screen[2].y});
+			const int32_t minX = std::max(0, static_cast<int32_t>(std::floor(left)));
+			const int32_t maxX = std::min<int32_t>(width - 1, static_cast<int32_t>(right));
+			const int32_t minY = std::max(0, static_cast<int32_t>(std::floor(top)));
+			const int32_t maxY = std::min<int32_t>(height - 1, static_cast<int32_t>(bottom));
+			for (int32_t y = minY; y <= maxY; y++) {
+				for (int32_t x = minX; x <= maxX; x++) {
+					const float w0 = edge(screen[1], screen[2], x + 0.5f, y + 0.5f);
+					const float w1 = edge(screen[2], screen[0], x + 0.5f, y + 0.5f);
+					const float w2 = edge(screen[0], screen[1], x + 0.5f, y + 0.5f);
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+						continue;
+					}
+					const float z = (w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z) / area;
+					float &pixel = depth[size_t(y) * width + x];
+					pixel = std::min(pixel, z);
+				}
+			}
+		}
+	}
+	return depth;
+}
+
+// Whether every pixel the unit's screen rect touches in depth is nearer than the unit
+bool IsHiddenInReference(const std::vector<float> &depth, uint32_t width, uint32_t height, const City &city, uint32_t unit)
+{
+	const DirectX::XMMATRIX transform =
+		DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&city.units[unit]), DirectX::XMLoadFloat4x4(&city.viewProjection));
+	float minX = std::numeric_limits<float>::max(), minY = minX, minZ = minX, maxX = -minX, maxY = -minX;
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		const DirectX::XMVECTOR position = DirectX::XMVectorSet(corner & 1 ? UNIT_MAX.x : UNIT_MIN.x,
+			corner & 2 ? UNIT_MAX.y : UNIT_MIN.y, corner & 4 ? UNIT_MAX.z : UNIT_MIN.z, 1.0f);
+		DirectX::XMFLOAT4 clip;
+		DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(position, transform));
+		if (clip.w <= 0.0f || clip.z < 0.0f) {
+			return false;
+		}
+		minX = std::min(minX, (clip.x / clip.w * 0.5f + 0.5f) * width);
+		maxX = std::max(maxX, (clip.x / clip.w * 0.5f + 0.5f) * width);
+		minY = std::min(minY, (0.5f - clip.y / clip.w * 0.5f) * height);
+		maxY = std::max(maxY, (0.5f - clip.y / clip.w * 0.5f) * height);
+		minZ = std::min(minZ, clip.z / clip.w);
+	}
+	if (maxX <= 0.0f || maxY <= 0.0f || minX >= width || minY >= height) {
+		return true;
+	}
+	for (uint32_t y = static_cast<uint32_t>(std::max(minY, 0.0f)); y < std::min(std::ceil(maxY), float(height)); y++) {
+		for (uint32_t x = static_cast<uint32_t>(std::max(minX, 0.0f)); x < std::min(std::ceil(maxX), float(width)); x++) {
+			if (depth[size_t{y} * width + x] >= minZ - DEPTH_EPSILON) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool IsUnitVisible(const OcclusionCuller &culler, const City &city, uint32_t unit)
+{
+	return culler.IsVisible(UNIT_MIN, UNIT_MAX, DirectX::XMLoadFloat4x4(&city.units[unit]));
+}
+} // namespace
+
+TEST(OccluderMesh, TowerFitsTheBudgetInsideItsBounds)
+{
+	const MeshData towerMesh = MakeTower();
+	const OccluderSettings settings{.maxTriangles = 128, .maxResolution = 64};
+	const OccluderMesh occluder = BuildOccluderMesh({&towerMesh, 1}, settings);
+	ASSERT_FALSE(occluder.IsEmpty());
+	EXPECT_LE(occluder.GetTriangleCount(), settings.maxTriangles);
+	EXPECT_EQ(occluder.indices.size() % 3, 0u);
+
+	EXPECT_FLOAT_EQ(occluder.boundsMin.x, -0.5f);
+	EXPECT_FLOAT_EQ(occluder.boundsMin.y, 0.0f);
+	EXPECT_FLOAT_EQ(occluder.boundsMax.x, 0.5f);
+	EXPECT_FLOAT_EQ(occluder.boundsMax.y, 1.0f);
+	// Means of what a cluster replaces, a convex shape is never outgrown
+	for (const DirectX::XMFLOAT3 &p : occluder.positions) {
+		EXPECT_GE(p.x, occluder.boundsMin.x);
+		EXPECT_GE(p.y, occluder.boundsMin.y);
+		EXPECT_GE(p.z, occluder.boundsMin.z);
+		EXPECT_LE(p.x, occluder.boundsMax.x);
+		EXPECT_LE(p.y, occluder.boundsMax.y);
+		EXPECT_LE(p.z, occluder.boundsMax.z);
+	}
+	for (uint32_t index : occluder.indices) {
+		EXPECT_LT(index, occluder.positions.size());
+	}
+}
+
+TEST(OccluderMesh, OverBudgetKeepsTheLargestTriangles)
+{
+	const MeshData towerMesh = MakeTower();
+	const OccluderMesh occluder = BuildOccluderMesh({&towerMesh, 1}, {.maxTriangles = 1, .maxResolution = 64});
+	ASSERT_EQ(occluder.GetTriangleCount(), 1u);
+	for (uint32_t index : occluder.indices) {
+		const DirectX::XMFLOAT3 &p = occluder.positions[index];
+		EXPECT_TRUE(std::ranges::any_of(towerMesh.vertices, [&](const Vertex &vertex) {
+			return vertex.position.x == p.x && vertex.position.y == p.y && vertex.position.z == p.z;
+		}));
+	}
+	EXPECT_TRUE(BuildOccluderMesh({&towerMesh, 1}, {.maxTriangles = 0}).IsEmpty());
+	EXPECT_TRUE(BuildOccluderMesh({}).IsEmpty());
+}
+
+// Clustering would bridge the notch, the occluder has to keep to the building's own walls
+TEST(OccluderMesh, ConcaveModelHidesNothingInItsNotch)
+{
+	const MeshData courtyardMesh = MakeCourtyard();
+	const OccluderMesh courtyard = BuildOccluderMesh({&courtyardMesh, 1}, {.maxTriangles = 16});
+	ASSERT_FALSE(courtyard.IsEmpty());
+	EXPECT_LE(courtyard.GetTriangleCount(), 16u);
+	for (const DirectX::XMFLOAT3 &p : courtyard.positions) {
+		EXPECT_TRUE(std::ranges::any_of(courtyardMesh.vertices, [&](const Vertex &vertex) {
+			return vertex.position.x == p.x && vertex.position.y == p.y && vertex.position.z == p.z;
+		}));
+	}
+
+	OccluderInstance instance{.mesh = &courtyard};
+	DirectX::XMStoreFloat4x4(&instance.world, DirectX::XMMatrixIdentity());
+	TGW::JobSystem jobs{0};
+	OcclusionCuller culler;
+	culler.RenderOccluders(
+		MakeViewProjection(DirectX::XMVectorSet(0.0f, 10.0f, -60.0f, 1.0f), DirectX::XMVectorSet(0.0f, 10.0f, 0.0f, 1.0f)),
+		{&instance, 1}, jobs);
+	EXPECT_GT(culler.GetRasterizedTriangleCount(), 0u);
+	for (const float x : {-3.0f, 0.0f, 3.0f}) {
+		for (const float z : {-8.0f, -2.0f, 3.0f}) {
+			EXPECT_TRUE(culler.IsVisible(UNIT_MIN, UNIT_MAX, DirectX::XMMatrixTranslation(x, 0.0f, z))) << x << ", " << z;
+		}
+	}
+}
+
+TEST(OcclusionCuller, DepthMatchesReferenceRasterizer)
+{
+	const City city;
+	TGW::JobSystem jobs{3};
+	OcclusionCuller culler;
+	culler.RenderOccluders(DirectX::XMLoadFloat4x4(&city.viewProjection), city.occluders, jobs);
+	EXPECT_GT(culler.GetRasterizedTriangleCount(), 0u);
+
+	const std::vector<float> reference = RasterizeReference(city, culler.GetWidth(), culler.GetHeight());
+	ASSERT_EQ(culler.GetDepth().size(), reference.size());
+	size_t mismatches = 0;
+	for (size_t i = 0; i < reference.size(); i++) {
+		mismatches += std::abs(reference[i] - culler.GetDepth()[i]) > DEPTH_EPSILON;
+	}
+	EXPECT_LE(mismatches, MAX_MISMATCH_SHARE * reference.size());
+}
+
+TEST(OcclusionCuller, SameDepthOnAnyThreadCount)
+{
+	const City city;
+	TGW::JobSystem serial{0}, parallel{3};
+	OcclusionCuller first, second;
+	first.RenderOccluders(DirectX::XMLoadFloat4x4(&city.viewProjection), city.occluders, serial);
+	second.RenderOccluders(DirectX::XMLoadFloat4x4(&city.viewProjection), city.occluders, parallel);
+	EXPECT_TRUE(std::equal(first.GetDepth().begin(), first.GetDepth().end(), second.GetDepth().begin()));
+	EXPECT_EQ(first.GetRasterizedTriangleCount(), second.GetRasterizedTriangleCount());
+}
+
+TEST(OcclusionCuller, CulledUnitsAreHiddenInReference)
+{
+	const City city;
+	TGW::JobSystem jobs{3};
+	OcclusionCuller culler;
+	culler.RenderOccluders(DirectX::XMLoadFloat4x4(&city.viewProjection), city.occluders, jobs);
+	const std::vector<float> reference = RasterizeReference(city, culler.GetWidth(), culler.GetHeight());
+
+	uint32_t hidden = 0;
+	for (uint32_t unit = 0; unit < UNIT_COUNT; unit++) {
+		if (!IsUnitVisible(culler, city, unit)) {
+			hidden++;
+			EXPECT_TRUE(IsHiddenInReference(reference, culler.GetWidth(), culler.GetHeight(), city, unit)) << unit;
+		}
+	}
+	// The streets are deep enough that most units end up behind some tower
+	EXPECT_GT(hidden, UNIT_COUNT / 4);
+	EXPECT_LT(hidden, UNIT_COUNT);
+}
+
+TEST(OcclusionCuller, WallHidesOnlyWhatIsBehindIt)
+{
+	const MeshData towerMesh = MakeTower();
+	const OccluderMesh tower = BuildOccluderMesh({&towerMesh, 1});
+	// Far wider and taller than the view at its distance, the simplified edges still reach past the screen
+	OccluderInstance wall{.mesh = &tower};
+	DirectX::XMStoreFloat4x4(&wall.world,
+		DirectX::XMMatrixMultiply(
+			DirectX::XMMatrixScaling(200.0f, 200.0f, 2.0f), DirectX::XMMatrixTranslation(0.0f, -100.0f, 50.0f)));
+
+	TGW::JobSystem jobs{0};
+	OcclusionCuller culler;
+	const DirectX::XMMATRIX viewProjection =
+		MakeViewProjection(DirectX::XMVectorSet(0.0f, 5.0f, 0.0f, 1.0f), DirectX::XMVectorSet(0.0f, 5.0f, 1.0f, 1.0f));
+	culler.RenderOccluders(viewProjection, {&wall, 1}, jobs);
+
+	const auto isVisible = [&](float x, float z) {
+		return culler.IsVisible(UNIT_MIN, UNIT_MAX, DirectX::XMMatrixTranslation(x, 4.0f, z));
+	};
+	EXPECT_TRUE(isVisible(0.0f, 20.0f));
+	EXPECT_FALSE(isVisible(0.0f, 80.0f));
+	EXPECT_FALSE(isVisible(10.0f, 300.0f));
+	// Off to the side of the view altogether
+	EXPECT_FALSE(isVisible(500.0f, 20.0f));
+	// Without occluders everything on screen is visible
+	culler.RenderOccluders(viewProjection, {}, jobs);
+	EXPECT_TRUE(isVisible(0.0f, 80.0f));
+	EXPECT_TRUE(isVisible(10.0f, 300.0f));
+}
@@ -0,0 +1,206 @@
+#include "fx/particles.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+
+using namespace TGW::Fx;
+
+namespace {
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+
+EmitterDesc MakeSmoke(uint32_t index)
+{
+	return {
+	  .position = {std::fmod(index * 37.0f, 500.0f), 0.0f, std::fmod(index * 91.0f, 500.0f)},
+	  .radius = 1.0f,
+	  .spread = 0.4f,
+	  .minSpeed = 1.0f,
+	  .maxSpeed = 3.0f,
+	  .minLifetime = 4.0f,
+	  .maxLifetime = 6.0f,
+	  .rate = 800.0f,
+	  .duration = -1.0f,
+	  .gravityScale = -0.05f,
+	  .drag = 0.3f,
+	  .noiseStrength = 2.0f,
+	  .noiseScale = 6.0f,
+	  .startSize = 1.0f,
+	  .endSize = 6.0f,
+	  .startColor = {0.3f, 0.3f, 0.3f, 0.8f},
+	  .endColor = {0.6f, 0.6f, 0.6f, 0.0f},
+	  .capacity = 4096,
+	  .seed = index + 1,
+	};
+}
+
+EmitterDesc MakeFireball(uint32_t index)
+{
+	return {
+	  .position = {std::fmod(index * 53.0f, 500.0f), 1.0f, std::fmod(index * 29.0f, 500.0f)},
+	  .spread = 3.1f,
+	  .minSpeed = 5.0f,
+	  .maxSpeed = 15.0f,
+	  .minLifetime = 0.3f,
+	  .maxLifetime = 0.8f,
+	  .burst = 300,
+	  .gravityScale = 0.5f,
+	  .drag = 2.0f,
+	  .noiseStrength = 10.0f,
+	  .startSize = 2.0f,
+	  .endSize = 0.5f,
+	  .startColor = {1.0f, 0.8f, 0.3f, 1.0f},
+	  .endColor = {0.5f, 0.1f, 0.0f, 0.0f},
+	  .capacity = 300,
+	  .seed = index + 1000,
+	};
+}
+
+float GetDistanceSq(const ParticleInstance &instance, DirectX::XMFLOAT3 point)
+{
+	const float dx = instance.position.x - point.x, dy = instance.position.y - point.y, dz = instance.position.z - point.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+} // namespace
+
+// The same emitters ticked on one thread and on several have to end up bit for bit the same
+TEST(Particles, ReplayIsDeterministicAcrossThreadCounts)
+{
+	TGW::JobSystem serial{0}, wide{3};
+	ParticleSystem a, b;
+	for (uint32_t i = 0; i < 8; i++) {
+		a.AddEmitter(MakeSmoke(i));
+		b.AddEmitter(MakeSmoke(i));
+	}
+	for (uint32_t tick = 0; tick < 90; tick++) {
+		a.AddEmitter(MakeFireball(tick));
+		b.AddEmitter(MakeFireball(tick));
+		a.Tick(TICK_SECONDS, serial);
+		b.Tick(TICK_SECONDS, wide);
+	}
+	EXPECT_GT(a.GetParticleCount(), 0u);
+	EXPECT_EQ(a.GetParticleCount(), b.GetParticleCount());
+	EXPECT_EQ(a.GetStateHash(), b.GetStateHash());
+}
+
+// Every particle of a burst lives exactly its lifetime, then the emitter frees itself
+TEST(Particles, BurstLivesOutItsLifetime)
+{
+	ParticleSystem particles;
+	TGW::JobSystem jobs{0};
+	EmitterDesc desc = MakeFireball(0);
+	desc.minLifetime = desc.maxLifetime = 10.5f * TICK_SECONDS;
+	const EmitterId id = particles.AddEmitter(desc);
+	for (uint32_t tick = 0; tick <= 10; tick++) {
+		particles.Tick(TICK_SECONDS, jobs);
+		ASSERT_EQ(particles.GetParticleCount(), desc.burst) << tick;
+		ASSERT_TRUE(particles.IsAlive(id));
+	}
+	particles.Tick(TICK_SECONDS, jobs);
+	EXPECT_EQ(particles.GetParticleCount(), 0u);
+	EXPECT_FALSE(particles.IsAlive(id));
+	EXPECT_EQ(particles.GetEmitterCount(), 0u);
+
+	// The slot is reused under a new generation, the old id stays dead
+	const EmitterId reused = particles.AddEmitter(desc);
+	EXPECT_EQ(reused.index, id.index);
+	EXPECT_NE(reused, id);
+	EXPECT_FALSE(particles.IsAlive(id));
+	EXPECT_TRUE(particles.IsAlive(reused));
+}
+
+TEST(Particles, RateDurationAndCapacity)
+{
+	ParticleSystem particles;
+	TGW::JobSystem jobs{0};
+	// 90 particles a second for one second, living long enough to all be alive at the end
+	EmitterDesc desc = MakeSmoke(0);
+	desc.rate = 90.0f;
+	desc.duration = 1.0f;
+	desc.minLifetime = desc.maxLifetime = 100.0f;
+	const EmitterId id = particles.AddEmitter(desc);
+	for (uint32_t tick = 0; tick < 60; tick++) {
+		particles.Tick(TICK_SECONDS, jobs);
+	}
+	EXPECT_NEAR(static_cast<float>(particles.GetParticleCount()), 90.0f, 1.0f);
+	EXPECT_TRUE(particles.IsAlive(id));
+
+	// Spawns past the pool are dropped
+	desc.burst = 1000;
+	desc.capacity = 64;
+	particles.AddEmitter(desc);
+	particles.Tick(TICK_SECONDS, jobs);
+	EXPECT_NEAR(static_cast<float>(particles.GetParticleCount()), 90.0f + 64.0f, 1.0f);
+
+	particles.Clear();
+	EXPECT_EQ(particles.GetParticleCount(), 0u);
+	EXPECT_EQ(particles.GetEmitterCount(), 0u);
+	EXPECT_FALSE(particles.IsAlive(id));
+}
+
+TEST(Particles, StopAndMoveEmitters)
+{
+	ParticleSystem particles;
+	TGW::JobSystem jobs{0};
+	EmitterDesc desc = MakeSmoke(0);
+	desc.minLifetime = desc.maxLifetime = 10.5f * TICK_SECONDS;
+	desc.noiseStrength = 0.0f;
+	const EmitterId id = particles.AddEmitter(desc);
+	particles.Tick(TICK_SECONDS, jobs);
+	const uint32_t spawned = particles.GetParticleCount();
+	EXPECT_GT(spawned, 0u);
+
+	// New particles start around the new position, the first ones stay where they were
+	const DirectX::XMFLOAT3 moved{desc.position.x + 100.0f, 0.0f, desc.position.z};
+	particles.MoveEmitter(id, moved);
+	particles.Tick(TICK_SECONDS, jobs);
+	BillboardStream stream;
+	stream.Build(particles, DirectX::XMVectorZero(), jobs);
+	uint32_t near = 0, far = 0;
+	for (const ParticleInstance &instance : stream.GetInstances()) {
+		near += GetDistanceSq(instance, moved) < 5.0f * 5.0f;
+		far += GetDistanceSq(instance, desc.position) < 5.0f * 5.0f;
+	}
+	EXPECT_EQ(far, spawned);
+	EXPECT_EQ(near + far, particles.GetParticleCount());
+
+	// Stopped, the emitter goes once the last particle died
+	particles.StopEmitter(id);
+	for (uint32_t tick = 0; tick < 10; tick++) {
+		particles.Tick(TICK_SECONDS, jobs);
+		ASSERT_TRUE(particles.IsAlive(id)) << tick;
+	}
+	particles.Tick(TICK_SECONDS, jobs);
+	EXPECT_FALSE(particles.IsAlive(id));
+	EXPECT_EQ(particles.GetParticleCount(), 0u);
+}
+
+TEST(BillboardStream, EveryParticleBackToFront)
+{
+	TGW::JobSystem jobs{3};
+	ParticleSystem particles;
+	for (uint32_t i = 0; i < 8; i++) {
+		particles.AddEmitter(MakeSmoke(i));
+	}
+	for (uint32_t tick = 0; tick < 60; tick++) {
+		particles.AddEmitter(MakeFireball(tick));
+		particles.Tick(TICK_SECONDS, jobs);
+	}
+
+	const DirectX::XMFLOAT3 eye{250.0f, 80.0f, -100.0f};
+	BillboardStream stream;
+	stream.Build(particles, DirectX::XMLoadFloat3(&eye), jobs);
+	ASSERT_EQ(stream.GetInstances().size(), particles.GetParticleCount());
+	float last = std::numeric_limits<float>::max();
+	for (const ParticleInstance &instance : stream.GetInstances()) {
+		const float distance = GetDistanceSq(instance, eye);
+		ASSERT_LE(distance, last);
+		last = distance;
+		ASSERT_GT(instance.size, 0.0f);
+	}
+
+	ParticleSystem empty;
+	stream.Build(empty, DirectX::XMLoadFloat3(&eye), jobs);
+	EXPECT_TRUE(stream.GetInstances().empty());
+}
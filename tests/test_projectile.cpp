@@ -0,0 +1,276 @@
+#include "sim/projectiles.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr uint32_t MAP_SAMPLES = 513;
+constexpr float MAP_SIZE = static_cast<float>(MAP_SAMPLES - 1);
+constexpr float CELL_SIZE = 8.0f;
+constexpr float UNIT_RADIUS = 1.0f;
+constexpr uint32_t PLAYER_COUNT = 2;
+// Brute force check: samples per segment and how far inside a target a sample has to be to count
+constexpr uint32_t CHECK_SAMPLES = 64;
+constexpr float CHECK_MARGIN = 1e-3f;
+
+const TGW::Terrain::Heightmap &GetHills()
+{
+	static const TGW::Terrain::Heightmap hills = [] {
+		std::vector<float> heights(size_t{MAP_SAMPLES} * MAP_SAMPLES);
+		for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+			for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+				heights[size_t{z} * MAP_SAMPLES + x] =
+					20.0f * std::sin(x * 0.01f) * std::cos(z * 0.013f) + 3.0f * std::sin((x + z) * 0.07f);
+			}
+		}
+		return TGW::Terrain::Heightmap{MAP_SAMPLES, MAP_SAMPLES, 1.0f, {0.0f, 0.0f}, std::move(heights)};
+	}();
+	return hills;
+}
+
+struct Battlefield {
+	std::vector<float> x, y, z;
+	std::vector<uint8_t> owners;
+	SpatialGrid grid{{0.0f, 0.0f}, CELL_SIZE, static_cast<uint32_t>(MAP_SIZE / CELL_SIZE),
+		static_cast<uint32_t>(MAP_SIZE / CELL_SIZE)};
+	std::mt19937 rng{17};
+
+	// Units standing on the ground inside a square of side extent around the middle of the map
+	Battlefield(uint32_t unitCount, float extent)
+	{
+		std::uniform_real_distribution<float> coordinate{(MAP_SIZE - extent) * 0.5f, (MAP_SIZE + extent) * 0.5f};
+		for (uint32_t i = 0; i < unitCount; i++) {
+			x.push_back(coordinate(rng));
+			z.push_back(coordinate(rng));
+			y.push_back(GetHills().GetHeight(x.back(), z.back()));
+			owners.push_back(static_cast<uint8_t>(i % PLAYER_COUNT));
+		}
+		grid.Rebuild(x, z);
+	}
+
+	ProjectileTargets GetTargets() const { return {&GetHills(), &grid, x, y, z, owners, UNIT_RADIUS}; }
+
+	// Shells lobbed from anywhere on the map and bullets skimming over the units, three to one
+	ProjectileDesc MakeProjectile(float extent)
+	{
+		std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+		const uint8_t owner = static_cast<uint8_t>(rng() % PLAYER_COUNT);
+		const float angle = unit(rng) * DirectX::XM_2PI;
+		if (rng() % 4 != 0) {
+			return {
+			  .position = {MAP_SIZE * unit(rng), 60.0f + 200.0f * unit(rng), MAP_SIZE * unit(rng)},
+			  .velocity = {120.0f * std::cos(angle), 80.0f * (unit(rng) - 0.5f), 120.0f * std::sin(angle)},
+			  .owner = owner,
+			  .payload = 0,
+			};
+		}
+		const float middle = MAP_SIZE * 0.5f;
+		const float startX = middle + extent * (unit(rng) - 0.5f), startZ = middle + extent * (unit(rng) - 0.5f);
+		return {
+		  .position = {startX, GetHills().GetHeight(startX, startZ) + 1.0f + unit(rng), startZ},
+		  .velocity = {400.0f * std::cos(angle), -4.0f * unit(rng), 400.0f * std::sin(angle)},
+		  .lifetime = 3.0f,
+		  .gravityScale = 0.0f,
+		  .owner = owner,
+		  .payload = 1,
+		};
+	}
+};
+
+// True when the point is inside a unit of another owner or under the ground, by more than CHECK_MARGIN
+bool IsBlocked(const Battlefield &field, DirectX::XMFLOAT3 point, uint8_t owner)
+{
+	if (point.y - GetHills().GetHeight(point.x, point.z) < -CHECK_MARGIN) {
+		return true;
+	}
+	for (size_t i = 0; i < field.x.size(); i++) {
+		const float dx = point.x - field.x[i], dy = point.y - field.y[i] - UNIT_RADIUS, dz = point.z - field.z[i];
+		if (field.owners[i] != owner && std::sqrt(dx * dx + dy * dy + dz * dz) < UNIT_RADIUS - CHECK_MARGIN) {
+			return true;
+		}
+	}
+	return false;
+}
+} // namespace
+
+TEST(Projectiles, FreeFlightFollowsGravity)
+{
+	ProjectileSystem projectiles;
+	projectiles.Spawn({.position = {10.0f, 100.0f, 20.0f}, .velocity = {5.0f, 30.0f, -2.0f}, .lifetime = 1.0f, .payload = 7});
+	projectiles.Spawn({
+	  .position = {0.0f, 50.0f, 0.0f},
+	  .velocity = {1.0f, 0.0f, 0.0f},
+	  .lifetime = 10.0f,
+	  .gravityScale = 0.5f,
+	  .owner = 1,
+	  .payload = 8,
+	});
+	ASSERT_EQ(projectiles.GetCount(), 2u);
+
+	// No terrain and no units, only the lifetime ends a flight
+	const float dt = 0.1f;
+	for (uint32_t tick = 0; tick < 5; tick++) {
+		projectiles.Tick(dt, {});
+		EXPECT_TRUE(projectiles.GetImpacts().empty());
+	}
+	const float t = 5 * dt;
+	EXPECT_NEAR(projectiles.GetPositionsX()[0], 10.0f + 5.0f * t, 1e-4f);
+	EXPECT_NEAR(projectiles.GetPositionsY()[0], 100.0f + 30.0f * t + 0.5f * PROJECTILE_GRAVITY * t * t, 1e-3f);
+	EXPECT_NEAR(projectiles.GetPositionsZ()[0], 20.0f - 2.0f * t, 1e-4f);
+	EXPECT_NEAR(projectiles.GetPositionsY()[1], 50.0f + 0.25f * PROJECTILE_GRAVITY * t * t, 1e-3f);
+
+	for (uint32_t tick = 0; tick < 6; tick++) {
+		projectiles.Tick(dt, {});
+	}
+	ASSERT_EQ(projectiles.GetCount(), 1u);
+	// The survivor moved to the front
+	EXPECT_NEAR(projectiles.GetPositionsX()[0], 11 * dt, 1e-4f);
+
+	projectiles.Clear();
+	EXPECT_EQ(projectiles.GetCount(), 0u);
+}
+
+TEST(Projectiles, LifetimeEndsWithAnExpiredImpact)
+{
+	ProjectileSystem projectiles;
+	projectiles.Spawn({.position = {0.0f, 100.0f, 0.0f}, .velocity = {10.0f, 0.0f, 0.0f}, .lifetime = 0.25f, .payload = 3});
+	uint32_t expired = 0;
+	for (uint32_t tick = 0; tick < 10; tick++) {
+		projectiles.Tick(0.1f, {});
+		for (const ProjectileImpact &impact : projectiles.GetImpacts()) {
+			EXPECT_EQ(impact.type, PROJECTILE_IMPACT_EXPIRED);
+			EXPECT_EQ(impact.payload, 3u);
+			EXPECT_EQ(impact.unit, UINT32_MAX);
+			EXPECT_EQ(tick, 2u);
+			expired++;
+		}
+	}
+	EXPECT_EQ(expired, 1u);
+	EXPECT_EQ(projectiles.GetCount(), 0u);
+}
+
+TEST(Projectiles, OwnUnitsAreNotHit)
+{
+	// Two units on flat ground along X, the first of the shooter's own player
+	const TGW::Terrain::Heightmap flat{64, 64, 1.0f, {0.0f, 0.0f}, std::vector<float>(64 * 64, 0.0f)};
+	const std::vector<float> x = {20.0f, 30.0f}, y = {0.0f, 0.0f}, z = {10.0f, 10.0f};
+	const std::vector<uint8_t> owners = {0, 1};
+	SpatialGrid grid{{0.0f, 0.0f}, CELL_SIZE, 8, 8};
+	grid.Rebuild(x, z);
+	const ProjectileTargets targets{&flat, &grid, x, y, z, owners, UNIT_RADIUS};
+
+	ProjectileSystem projectiles;
+	const ProjectileDesc bullet{.position = {5.0f, 1.0f, 10.0f}, .velocity = {100.0f, 0.0f, 0.0f}, .gravityScale = 0.0f};
+	projectiles.Spawn(bullet);
+	projectiles.Tick(0.5f, targets);
+	ASSERT_EQ(projectiles.GetImpacts().size(), 1u);
+	const ProjectileImpact &impact = projectiles.GetImpacts()[0];
+	EXPECT_EQ(impact.type, PROJECTILE_IMPACT_UNIT);
+	EXPECT_EQ(impact.unit, 1u);
+	EXPECT_NEAR(impact.position.x, 29.0f, 1e-3f);
+
+	// Fired by the other player it stops at the first unit instead
+	projectiles.Spawn({.position = bullet.position, .velocity = bullet.velocity, .gravityScale = 0.0f, .owner = 1});
+	projectiles.Tick(0.5f, targets);
+	ASSERT_EQ(projectiles.GetImpacts().size(), 1u);
+	EXPECT_EQ(projectiles.GetImpacts()[0].unit, 0u);
+	EXPECT_EQ(projectiles.GetImpacts()[0].owner, 1u);
+
+	// Aimed at the ground it lands on it
+	projectiles.Spawn({.position = {5.0f, 10.0f, 40.0f}, .velocity = {0.0f, -40.0f, 0.0f}});
+	projectiles.Tick(0.5f, targets);
+	ASSERT_EQ(projectiles.GetImpacts().size(), 1u);
+	EXPECT_EQ(projectiles.GetImpacts()[0].type, PROJECTILE_IMPACT_GROUND);
+	EXPECT_NEAR(projectiles.GetImpacts()[0].position.y, 0.0f, 0.05f);
+}
+
+// Every impact has to touch what it hit, and no segment may pass through a target before its impact or without
+// one. Projectiles are spawned among the units with a long tick so most of them hit something.
+TEST(Projectiles, HitsMatchBruteForce)
+{
+	constexpr float extent = 100.0f, dt = 0.05f;
+	constexpr uint32_t count = 600;
+	Battlefield field{500, extent};
+	ProjectileSystem projectiles;
+	std::vector<ProjectileDesc> descs;
+	for (uint32_t i = 0; i < count; i++) {
+		descs.push_back(field.MakeProjectile(extent));
+		descs.back().position.x = (MAP_SIZE - extent) * 0.5f + extent * (i % 97) / 97.0f;
+		descs.back().position.z = (MAP_SIZE - extent) * 0.5f + extent * (i % 89) / 89.0f;
+		descs.back().position.y = GetHills().GetHeight(descs.back().position.x, descs.back().position.z) + 2.0f;
+		descs.back().payload = i;
+		projectiles.Spawn(descs.back());
+	}
+	projectiles.Tick(dt, field.GetTargets());
+
+	// Payloads carry the spawn index
+	std::vector<const ProjectileImpact *> impactOf(descs.size(), nullptr);
+	uint32_t unitHits = 0;
+	for (const ProjectileImpact &impact : projectiles.GetImpacts()) {
+		impactOf[impact.payload] = &impact;
+		unitHits += impact.type == PROJECTILE_IMPACT_UNIT;
+	}
+	EXPECT_GT(unitHits, 0u);
+	EXPECT_EQ(projectiles.GetImpacts().size() + projectiles.GetCount(), descs.size());
+
+	for (size_t i = 0; i < descs.size(); i++) {
+		const ProjectileDesc &desc = descs[i];
+		const float g = PROJECTILE_GRAVITY * desc.gravityScale;
+		const DirectX::XMFLOAT3 start = desc.position;
+		const DirectX::XMFLOAT3 delta{desc.velocity.x * dt, desc.velocity.y * dt + 0.5f * g * dt * dt, desc.velocity.z * dt};
+
+		float hit = 1.0f;
+		if (const ProjectileImpact *impact = impactOf[i]) {
+			hit = std::abs(delta.x) > std::abs(delta.z) ? (impact->position.x - start.x) / delta.x
+														: (impact->position.z - start.z) / delta.z;
+			if (impact->type == PROJECTILE_IMPACT_UNIT) {
+				const uint32_t u = impact->unit;
+				const float dx = impact->position.x - field.x[u], dy = impact->position.y - field.y[u] - UNIT_RADIUS,
+							dz = impact->position.z - field.z[u];
+				EXPECT_NE(field.owners[u], desc.owner) << i;
+				EXPECT_LE(std::sqrt(dx * dx + dy * dy + dz * dz), UNIT_RADIUS + CHECK_MARGIN) << i;
+			} else {
+				EXPECT_LE(impact->position.y - GetHills().GetHeight(impact->position.x, impact->position.z), 0.05f) << i;
+			}
+		}
+		// Projectiles spawned inside a target hit it at once, with nothing before to check
+		for (uint32_t sample = 0; sample < CHECK_SAMPLES && hit > 0.0f; sample++) {
+			const float t = hit * sample / CHECK_SAMPLES;
+			ASSERT_FALSE(IsBlocked(field, {start.x + delta.x * t, start.y + delta.y * t, start.z + delta.z * t}, desc.owner))
+				<< "projectile " << i << " passed through a target";
+		}
+	}
+}
+
+// The same battle ticked on one thread and on several has to end up bit for bit the same
+TEST(Projectiles, ReplayIsDeterministicAcrossThreadCounts)
+{
+	uint64_t hashes[2];
+	std::vector<ProjectileImpact> impacts[2];
+	for (uint32_t run = 0; run < 2; run++) {
+		TGW::JobSystem jobs{run == 0 ? 0u : 3u};
+		Battlefield field{2000, MAP_SIZE * 0.5f};
+		ProjectileSystem projectiles;
+		for (uint32_t tick = 0; tick < 60; tick++) {
+			while (projectiles.GetCount() < 2000) {
+				projectiles.Spawn(field.MakeProjectile(MAP_SIZE * 0.5f));
+			}
+			projectiles.Tick(1.0f / 30.0f, field.GetTargets(), jobs);
+			impacts[run].insert(impacts[run].end(), projectiles.GetImpacts().begin(), projectiles.GetImpacts().end());
+		}
+		hashes[run] = projectiles.GetStateHash();
+	}
+	EXPECT_EQ(hashes[0], hashes[1]);
+	ASSERT_EQ(impacts[0].size(), impacts[1].size());
+	ASSERT_FALSE(impacts[0].empty());
+	for (size_t i = 0; i < impacts[0].size(); i++) {
+		const ProjectileImpact &a = impacts[0][i], &b = impacts[1][i];
+		ASSERT_TRUE(a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z &&
+					a.unit == b.unit && a.type == b.type)
+			<< "impact " << i;
+	}
+}
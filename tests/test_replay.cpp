@@ -0,0 +1,227 @@
+#include "replay/replay_world.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <random>
+
+using namespace TGW::Replay;
+namespace fs = std::filesystem;
+
+namespace {
+// A smaller version of the battle bench_replay times: two armies advancing on each other and firing every tick
+constexpr uint32_t ARMY_SIZE = 100;
+constexpr uint32_t ARMY_COLUMNS = 10;
+constexpr float ARMY_SPACING = 4.0f;
+constexpr float FRONT_DISTANCE = 40.0f;
+constexpr uint32_t BATTLE_TICKS = 300;
+constexpr uint32_t ORDER_INTERVAL = 60;
+constexpr uint32_t SHOTS_PER_TICK = 3;
+constexpr float SHOT_FLIGHT_SECONDS = 1.0f;
+constexpr uint32_t SHOT_DAMAGE = 25;
+constexpr uint32_t HASH_INTERVAL = 10;
+constexpr uint32_t BATTLE_SEED = 23;
+
+ReplaySettings GetSettings()
+{
+	return {.tickSeconds = 1.0f / 30.0f, .unitRadius = 1.0f, .battleSize = 512.0f, .loadModels = false};
+}
+
+// Aims a shell from shooter at the centre of target, arriving after SHOT_FLIGHT_SECONDS if the target stands still
+TGW::Sim::ProjectileDesc Aim(DirectX::XMFLOAT3 shooter, DirectX::XMFLOAT3 target, uint8_t owner, float radius)
+{
+	const float t = SHOT_FLIGHT_SECONDS;
+	const DirectX::XMFLOAT3 start{shooter.x, shooter.y + radius, shooter.z};
+	return {
+	  .position = start,
+	  .velocity = {(target.x - start.x) / t, (target.y + radius - start.y) / t - 0.5f * TGW::Sim::PROJECTILE_GRAVITY * t,
+		  (target.z - start.z) / t},
+	  .lifetime = t * 2.0f,
+	  .gravityScale = 1.0f,
+	  .owner = owner,
+	  .payload = SHOT_DAMAGE,
+	};
+}
+
+struct Recording {
+	CommandStream stream;
+	// State of the live session at the end
+	uint64_t finalHash = 0;
+};
+
+// Plays the battle against a live world and records everything it does to it
+Recording RecordBattle()
+{
+	CommandRecorder recorder{GetSettings().tickSeconds};
+	ReplayWorld world{GetSettings()};
+	std::mt19937 random{BATTLE_SEED};
+	size_t applied = 0;
+	const auto apply = [&] {
+		const std::vector<Command> &commands = recorder.GetStream().commands;
+		for (; applied < commands.size(); applied++) {
+			world.Apply(commands[applied]);
+		}
+	};
+
+	DirectX::XMFLOAT4X4 headquarters;
+	DirectX::XMStoreFloat4x4(&headquarters, DirectX::XMMatrixTranslation(0.0f, 0.0f, -150.0f));
+	recorder.LoadModel(0, "content/headquarters.glb", headquarters);
+	recorder.SelectModel(0);
+	for (uint8_t owner = 0; owner < 2; owner++) {
+		const float side = owner == 0 ? -1.0f : 1.0f;
+		for (uint32_t i = 0; i < ARMY_SIZE; i++) {
+			recorder.SpawnUnit({
+			  .position = {side * (FRONT_DISTANCE + (i / ARMY_COLUMNS) * ARMY_SPACING), 0.0f,
+				  (static_cast<float>(i % ARMY_COLUMNS) - ARMY_COLUMNS * 0.5f) * ARMY_SPACING},
+			  .heading = 0.0f,
+			  .maxSpeed = 5.0f,
+			  .health = 100.0f,
+			  .owner = owner,
+			  .model = owner,
+			});
+		}
+	}
+
+	for (uint32_t tick = 0; tick < BATTLE_TICKS; tick++) {
+		const TGW::Sim::UnitStore &units = world.GetUnits();
+		const uint32_t count = units.GetCount();
+		if (tick % ORDER_INTERVAL == 0) {
+			std::uniform_real_distribution<float> spread{-10.0f, 10.0f};
+			for (uint32_t i = 0; i < count; i++) {
+				const float towards = units.GetOwners()[i] == 0 ? 15.0f : -15.0f;
+				recorder.MoveUnit(
+					units.GetId(i), {units.GetPositionsX()[i] + towards, units.GetPositionsZ()[i] + spread(random)});
+			}
+		}
+		if (count > 0) {
+			std::uniform_int_distribution<uint32_t> pick{0, count - 1};
+			for (uint32_t shot = 0; shot < SHOTS_PER_TICK * 2; shot++) {
+				const uint32_t shooter = pick(random);
+				const uint32_t target = pick(random);
+				const uint8_t owner = units.GetOwners()[shooter];
+				if (units.GetOwners()[target] == owner) {
+					continue;
+				}
+				const DirectX::XMFLOAT3 from{units.GetPositionsX()[shooter], units.GetPositionsY()[shooter],
+					units.GetPositionsZ()[shooter]};
+				const DirectX::XMFLOAT3 to{
+					units.GetPositionsX()[target], units.GetPositionsY()[target], units.GetPositionsZ()[target]};
+				recorder.Fire(Aim(from, to, owner, GetSettings().unitRadius));
+			}
+		}
+		if (tick % 4 == 0) {
+			recorder.Orbit(static_cast<float>(tick % 7) - 3.0f);
+		}
+		if (tick % 3 == 0) {
+			recorder.Pan(tick % 2 == 0 ? 1 : -1, 1);
+		}
+		if (tick == BATTLE_TICKS / 2) {
+			headquarters._41 += 2.0f;
+			recorder.MoveModel(0, headquarters);
+			recorder.Zoom(-120);
+		}
+
+		apply();
+		world.Tick();
+		recorder.NextTick();
+	}
+	return {.stream = recorder.GetStream(), .finalHash = world.GetStateHash()};
+}
+
+const Recording &GetBattle()
+{
+	static const Recording battle = RecordBattle();
+	return battle;
+}
+
+ReplayReport Replay(const CommandStream &stream, TGW::JobSystem &jobs)
+{
+	ReplayWorld world{GetSettings(), jobs};
+	return RunReplay(stream, world, HASH_INTERVAL);
+}
+} // namespace
+
+TEST(CommandStream, RoundTripsThroughItsBinaryForm)
+{
+	CommandStream stream = GetBattle().stream;
+	stream.terrainPath = "content/terrain.r16";
+	stream.terrainHash = {.low = 1, .high = 2};
+	const std::vector<uint8_t> data = Serialize(stream);
+	const std::optional<CommandStream> loaded = Deserialize(data);
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(*loaded, stream);
+	EXPECT_FALSE(Deserialize(std::span{data}.first(data.size() - 1)));
+	EXPECT_FALSE(Deserialize(std::span{data}.subspan(1)));
+}
+
+TEST(CommandStream, RejectsNewerVersions)
+{
+	std::vector<uint8_t> data = Serialize(GetBattle().stream);
+	data[4] = static_cast<uint8_t>(REPLAY_VERSION + 1);
+	EXPECT_FALSE(Deserialize(data));
+}
+
+// Version 1 had nothing between the tick count and the command count
+TEST(CommandStream, LoadsVersion1WithoutTerrain)
+{
+	CommandRecorder recorder;
+	recorder.Zoom(120);
+	recorder.NextTick();
+	std::vector<uint8_t> data = Serialize(recorder.GetStream());
+	const size_t terrainBytes = sizeof(uint32_t) + 2 * sizeof(uint64_t);
+	data.erase(data.begin() + 16, data.begin() + 16 + terrainBytes);
+	data[4] = 1;
+	const std::optional<CommandStream> loaded = Deserialize(data);
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(*loaded, recorder.GetStream());
+	EXPECT_TRUE(loaded->terrainPath.empty());
+}
+
+TEST(CommandRecorder, RecordsTheTerrainFile)
+{
+	const fs::path path = fs::temp_directory_path() / "shellshock_test_replay_terrain.r16";
+	std::ofstream{path, std::ios::binary} << std::string(8, '\x01');
+	const std::optional<TGW::Hash::Hash128> hash = HashTerrainFile(path);
+	ASSERT_TRUE(hash);
+	CommandRecorder recorder;
+	recorder.SetTerrain(path.generic_string(), *hash);
+	const std::optional<CommandStream> loaded = Deserialize(Serialize(recorder.GetStream()));
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(loaded->terrainPath, path.generic_string());
+	EXPECT_EQ(loaded->terrainHash, *hash);
+
+	// An edited file no longer hashes the same, a missing one not at all
+	std::ofstream{path, std::ios::binary} << std::string(8, '\x02');
+	EXPECT_NE(HashTerrainFile(path), hash);
+	fs::remove(path);
+	EXPECT_FALSE(HashTerrainFile(path));
+}
+
+TEST(ReplayWorld, EndsWhereTheLiveSessionDidOnAnyThreadCount)
+{
+	const Recording &battle = GetBattle();
+	TGW::JobSystem serial{0}, workers{3};
+	const ReplayReport single = Replay(battle.stream, serial);
+	const ReplayReport parallel = Replay(battle.stream, workers);
+	EXPECT_EQ(single.finalHash, battle.finalHash);
+	EXPECT_EQ(parallel.finalHash, battle.finalHash);
+	EXPECT_FALSE(FindDesync(single, parallel));
+	EXPECT_EQ(single.tickMicros.size(), BATTLE_TICKS);
+}
+
+// A move order a little off target, the checkpoint after it has to catch it
+TEST(ReplayWorld, NudgedOrderShowsAsDesync)
+{
+	const Recording &battle = GetBattle();
+	TGW::JobSystem serial{0};
+	CommandStream nudged = battle.stream;
+	const auto order = std::ranges::find_if(nudged.commands, [](const Command &command) {
+		return command.type == COMMAND_MOVE_UNIT && command.tick >= BATTLE_TICKS / 3;
+	});
+	ASSERT_NE(order, nudged.commands.end());
+	order->values[0] += 0.01f;
+	const std::optional<uint32_t> desync = FindDesync(Replay(battle.stream, serial), Replay(nudged, serial));
+	ASSERT_TRUE(desync);
+	EXPECT_GE(*desync, order->tick);
+	EXPECT_LT(*desync, order->tick + HASH_INTERVAL);
+}
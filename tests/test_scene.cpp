@@ -0,0 +1,197 @@
+#include "core/binary_stream.h"
+#include "scene/scene_file.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace TGW::Scene;
+
+namespace {
+// Byte offsets of the fixed fields at the front of a serialized scene
+constexpr size_t VERSION_OFFSET = 4;
+constexpr size_t MODEL_COUNT_OFFSET = 8 + 7 * sizeof(float);
+
+SceneData MakeScene(uint32_t entityCount)
+{
+	std::mt19937 rng{42};
+	std::uniform_real_distribution<float> position{-500.0f, 500.0f};
+
+	SceneData scene;
+	scene.camera = {{1.0f, 2.0f, 3.0f}, {0.5f, -0.7f, 0.5f}, 10.0f};
+	scene.modelPaths = {"content/models/tank.glb", "content/models/bunker.obj", ""};
+	for (uint32_t i = 0; i < entityCount; i++) {
+		scene.modelIndices.push_back(i % scene.modelPaths.size());
+		DirectX::XMStoreFloat4x4(
+			&scene.worldMatrices.emplace_back(), DirectX::XMMatrixTranslation(position(rng), 0.0f, position(rng)));
+		scene.flags.push_back(i == 0 ? ENTITY_FLAG_SELECTED : ENTITY_FLAG_NONE);
+	}
+	return scene;
+}
+
+void WriteUint32(std::vector<uint8_t> &data, size_t offset, uint32_t value)
+{
+	for (size_t i = 0; i < sizeof(uint32_t); i++) {
+		data[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+	}
+}
+} // namespace
+
+TEST(SceneFile, RoundTrip)
+{
+	const SceneData scene = MakeScene(100);
+	const std::vector<uint8_t> data = Serialize(scene);
+	ASSERT_FALSE(data.empty());
+
+	const std::optional<SceneData> loaded = Deserialize(data);
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(loaded->modelPaths, scene.modelPaths);
+	EXPECT_EQ(loaded->modelIndices, scene.modelIndices);
+	EXPECT_EQ(loaded->flags, scene.flags);
+	EXPECT_EQ(loaded->camera.zoom, scene.camera.zoom);
+	ASSERT_EQ(loaded->worldMatrices.size(), scene.worldMatrices.size());
+	EXPECT_EQ(std::memcmp(loaded->worldMatrices.data(), scene.worldMatrices.data(),
+				  scene.worldMatrices.size() * sizeof(DirectX::XMFLOAT4X4)),
+		0);
+	EXPECT_EQ(Serialize(*loaded), data);
+}
+
+TEST(SceneFile, EmptyScene)
+{
+	const std::optional<SceneData> loaded = Deserialize(Serialize(SceneData{}));
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(loaded->GetEntityCount(), 0u);
+	EXPECT_TRUE(loaded->modelPaths.empty());
+}
+
+TEST(SceneFile, SaveLoad)
+{
+	const SceneData scene = MakeScene(1000);
+	const std::filesystem::path path = std::filesystem::temp_directory_path() / "shellshock_test.shscene";
+	ASSERT_TRUE(Save(path, scene));
+	const std::optional<SceneData> loaded = Load(path);
+	std::filesystem::remove(path);
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(Serialize(*loaded), Serialize(scene));
+
+	EXPECT_FALSE(Load(path));
+}
+
+TEST(SceneFile, MismatchedArraysDoNotSerialize)
+{
+	SceneData scene = MakeScene(10);
+	scene.flags.pop_back();
+	EXPECT_TRUE(Serialize(scene).empty());
+	EXPECT_FALSE(Save(std::filesystem::temp_directory_path() / "shellshock_test_bad.shscene", scene));
+}
+
+// The format is little-endian whatever the host, byte for byte
+TEST(SceneFile, LittleEndianLayout)
+{
+	const std::vector<uint8_t> data = Serialize(MakeScene(2));
+	ASSERT_GE(data.size(), MODEL_COUNT_OFFSET + 4);
+	EXPECT_EQ((std::vector<uint8_t>{data.begin(), data.begin() + 4}), (std::vector<uint8_t>{'S', 'H', 'S', 'C'}));
+	EXPECT_EQ(data[VERSION_OFFSET], SCENE_VERSION);
+	EXPECT_EQ(data[VERSION_OFFSET + 3], 0);
+	// Camera target x = 1.0f is 0x3f800000
+	EXPECT_EQ((std::vector<uint8_t>{data.begin() + 8, data.begin() + 12}), (std::vector<uint8_t>{0x00, 0x00, 0x80, 0x3f}));
+	EXPECT_EQ(data[MODEL_COUNT_OFFSET], 3);
+
+	EXPECT_EQ(TGW::ByteSwap<uint32_t>(0x11223344), 0x44332211u);
+	EXPECT_EQ(TGW::ByteSwap<uint16_t>(0x1122), 0x2211);
+
+	const uint8_t bytes[] = {0x44, 0x33, 0x22, 0x11, 0x00, 0x00, 0x80, 0x3f};
+	TGW::BinaryReader reader{bytes};
+	uint32_t integer = 0;
+	float real = 0.0f;
+	EXPECT_TRUE(reader.Read(integer) && reader.Read(real));
+	EXPECT_EQ(integer, 0x11223344u);
+	EXPECT_EQ(real, 1.0f);
+	EXPECT_FALSE(reader.Read(integer));
+	EXPECT_TRUE(reader.HasFailed());
+}
+
+TEST(SceneFile, RejectsBadHeader)
+{
+	const std::vector<uint8_t> data = Serialize(MakeScene(4));
+
+	std::vector<uint8_t> badMagic = data;
+	badMagic[0] ^= 0xff;
+	EXPECT_FALSE(Deserialize(badMagic));
+
+	std::vector<uint8_t> newer = data;
+	WriteUint32(newer, VERSION_OFFSET, SCENE_VERSION + 1);
+	EXPECT_FALSE(Deserialize(newer));
+
+	std::vector<uint8_t> zero = data;
+	WriteUint32(zero, VERSION_OFFSET, 0);
+	EXPECT_FALSE(Deserialize(zero));
+}
+
+TEST(SceneFile, RejectsOutOfBoundsCounts)
+{
+	const SceneData scene = MakeScene(4);
+	const std::vector<uint8_t> data = Serialize(scene);
+
+	// Counts far past the end must fail before they allocate
+	std::vector<uint8_t> models = data;
+	WriteUint32(models, MODEL_COUNT_OFFSET, 0xffffffff);
+	EXPECT_FALSE(Deserialize(models));
+
+	size_t entityCountOffset = MODEL_COUNT_OFFSET + 4;
+	for (const std::string &path : scene.modelPaths) {
+		entityCountOffset += 4 + path.size();
+	}
+	std::vector<uint8_t> entities = data;
+	WriteUint32(entities, entityCountOffset, 0xffffffff);
+	EXPECT_FALSE(Deserialize(entities));
+	WriteUint32(entities, entityCountOffset, 3);
+	EXPECT_FALSE(Deserialize(entities));
+
+	std::vector<uint8_t> trailing = data;
+	trailing.push_back(0);
+	EXPECT_FALSE(Deserialize(trailing));
+
+	SceneData badIndex = scene;
+	badIndex.modelIndices[2] = static_cast<uint32_t>(scene.modelPaths.size());
+	EXPECT_FALSE(Deserialize(Serialize(badIndex)));
+}
+
+TEST(SceneFile, RejectsTruncation)
+{
+	const std::vector<uint8_t> data = Serialize(MakeScene(8));
+	for (size_t size = 0; size < data.size(); size++) {
+		EXPECT_FALSE(Deserialize(std::span{data}.first(size))) << "Loaded from the first " << size << " bytes";
+	}
+}
+
+// Flipped bits must either be rejected or load into a scene that is valid on its own
+TEST(SceneFile, BitFlipFuzz)
+{
+	const std::vector<uint8_t> data = Serialize(MakeScene(16));
+	std::mt19937 rng{7};
+	std::uniform_int_distribution<size_t> bit{0, data.size() * 8 - 1};
+	std::uniform_int_distribution<int> flips{1, 4};
+
+	uint32_t loaded = 0;
+	for (int round = 0; round < 20000; round++) {
+		std::vector<uint8_t> fuzzed = data;
+		for (int i = flips(rng); i > 0; i--) {
+			const size_t flip = bit(rng);
+			fuzzed[flip / 8] ^= static_cast<uint8_t>(1 << (flip % 8));
+		}
+		const std::optional<SceneData> scene = Deserialize(fuzzed);
+		if (!scene) {
+			continue;
+		}
+		loaded++;
+		ASSERT_EQ(scene->worldMatrices.size(), scene->GetEntityCount());
+		ASSERT_EQ(scene->flags.size(), scene->GetEntityCount());
+		for (const uint32_t index : scene->modelIndices) {
+			ASSERT_LT(index, scene->modelPaths.size());
+		}
+		ASSERT_EQ(Serialize(*scene), fuzzed);
+	}
+	// Flips in the matrices and flags are still valid scenes
+	EXPECT_GT(loaded, 0u);
+}
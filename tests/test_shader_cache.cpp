@@ -0,0 +1,323 @@
+#include "shader/shader_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+using namespace TGW::Shader;
+namespace fs = std::filesystem;
+
+namespace {
+// Both shaders and stages, shadows and fog on or off and four light counts
+constexpr uint32_t REQUEST_COUNT = 2 * 2 * 16;
+
+// Stands in for D3DCompile: expands includes and returns the text as bytecode, counting how often it ran
+class StubCompiler final : public IShaderCompiler {
+  public:
+	std::optional<std::vector<uint8_t>> Compile(
+		const ShaderRequest &request, const ShaderFileReader &read, std::string &errors) override
+	{
+		std::string text = request.entryPoint + " " + request.profile + "\n";
+		for (const ShaderDefine &define : request.defines) {
+			text += "#define " + define.name + " " + define.value + "\n";
+		}
+		if (!Expand(request.source, read, text, errors, 0)) {
+			return {};
+		}
+		compiles++;
+		return std::vector<uint8_t>{text.begin(), text.end()};
+	}
+
+	uint64_t GetVersion() const override { return version; }
+
+	std::atomic<uint32_t> compiles = 0;
+	uint64_t version = 1;
+
+  private:
+	// #include "name" is relative to the including file, like the D3D compiler does it
+	static bool Expand(const std::string &path, const ShaderFileReader &read, std::string &text, std::string &errors,
+		uint32_t depth)
+	{
+		const std::optional<std::vector<uint8_t>> data = read(path);
+		if (!data || depth > 8) {
+			errors = "cannot open " + path;
+			return false;
+		}
+		const std::string directory = path.substr(0, path.find_last_of('/') + 1);
+		std::string_view source{reinterpret_cast<const char *>(data->data()), data->size()};
+		while (!source.empty()) {
+			const size_t end = std::min(source.find('\n'), source.size());
+			const std::string_view line = source.substr(0, end);
+			source.remove_prefix(std::min(end + 1, source.size()));
+			if (line.starts_with("#include \"")) {
+				const std::string_view name = line.substr(10, line.find('"', 10) - 10);
+				if (!Expand(directory + std::string{name}, read, text, errors, depth + 1)) {
+					return false;
+				}
+			} else {
+				text.append(line).push_back('\n');
+			}
+		}
+		return true;
+	}
+};
+
+bool WriteText(const fs::path &path, std::string_view text)
+{
+	fs::create_directories(path.parent_path());
+	std::ofstream file{path, std::ios::binary | std::ios::trunc};
+	return static_cast<bool>(file.write(text.data(), text.size()));
+}
+
+std::vector<ShaderRequest> MakeRequests()
+{
+	std::vector<ShaderRequest> requests;
+	for (const char *source : {"model.hlsl", "terrain.hlsl"}) {
+		for (const auto &[entryPoint, profile] : {std::pair{"VSMain", "vs_5_0"}, std::pair{"PSMain", "ps_5_0"}}) {
+			for (uint32_t permutation = 0; permutation < 16; permutation++) {
+				requests.push_back(ShaderRequest{
+				  .source = source,
+				  .entryPoint = entryPoint,
+				  .profile = profile,
+				  .defines = {{"SHADOWS", std::to_string(permutation & 1)}, {"FOG", std::to_string((permutation >> 1) & 1)},
+					{"LIGHTS", std::to_string(1 << (permutation >> 2))}},
+				});
+			}
+		}
+	}
+	return requests;
+}
+
+bool AllLoaded(const std::vector<std::shared_ptr<const ShaderEntry>> &entries)
+{
+	return std::ranges::all_of(entries, [](const auto &entry) { return entry != nullptr; });
+}
+
+void ExpectStats(const ShaderCache &cache, uint32_t embeddedHits, uint32_t diskHits, uint32_t compiled)
+{
+	const ShaderCacheStats stats = cache.GetStats();
+	EXPECT_EQ(stats.embeddedHits, embeddedHits);
+	EXPECT_EQ(stats.diskHits, diskHits);
+	EXPECT_EQ(stats.compiled, compiled);
+	EXPECT_EQ(stats.failed, 0u);
+}
+
+void ExpectSameEntry(const ShaderEntry &a, const ShaderEntry &b)
+{
+	EXPECT_EQ(a.key, b.key);
+	EXPECT_EQ(a.bytecode, b.bytecode);
+	ASSERT_EQ(a.dependencies.size(), b.dependencies.size());
+	for (size_t i = 0; i < a.dependencies.size(); i++) {
+		EXPECT_EQ(a.dependencies[i].path, b.dependencies[i].path);
+		EXPECT_EQ(a.dependencies[i].hash, b.dependencies[i].hash);
+	}
+}
+
+// model.hlsl reads lib/lighting.hlsl which reads lib/common.hlsl, terrain.hlsl reads only lib/common.hlsl
+class ShaderCacheTest : public testing::Test {
+  protected:
+	void SetUp() override
+	{
+		const char *test = testing::UnitTest::GetInstance()->current_test_info()->name();
+		_root = fs::temp_directory_path() / "shellshock_test_shaders" / test;
+		fs::remove_all(_root);
+		ASSERT_TRUE(WriteText(GetSources() / "lib" / "common.hlsl", "float common(float x) { return x; }\n"));
+		ASSERT_TRUE(WriteText(GetSources() / "lib" / "lighting.hlsl", "#include \"common.hlsl\"\nfloat light;\n"));
+		ASSERT_TRUE(WriteText(GetSources() / "model.hlsl", "#include \"lib/lighting.hlsl\"\nfloat model;\n"));
+		ASSERT_TRUE(WriteText(GetSources() / "terrain.hlsl", "#include \"lib/common.hlsl\"\nfloat terrain;\n"));
+	}
+
+	void TearDown() override
+	{
+		std::error_code error;
+		fs::remove_all(_root, error);
+	}
+
+	fs::path GetSources() const { return _root / "src"; }
+	fs::path GetCache() const { return _root / "cache"; }
+
+	const std::vector<ShaderRequest> requests = MakeRequests();
+	StubCompiler compiler;
+
+  private:
+	fs::path _root;
+};
+} // namespace
+
+TEST(ShaderKey, TellsEveryPartOfARequestApart)
+{
+	const ShaderRequest base{.source = "model.hlsl", .entryPoint = "PSMain", .profile = "ps_5_0", .defines = {{"FOG", "1"}}};
+	const uint64_t key = GetShaderKey(base, 1);
+	EXPECT_EQ(GetShaderKey(base, 1), key);
+	EXPECT_NE(GetShaderKey(base, 2), key);
+
+	std::vector<ShaderRequest> changed(6, base);
+	changed[0].source = "terrain.hlsl";
+	changed[1].entryPoint = "VSMain";
+	changed[2].profile = "ps_4_0";
+	changed[3].defines[0].value = "0";
+	changed[4].defines[0].name = "FOG2";
+	changed[5].defines.push_back({"SHADOWS", ""});
+	for (const ShaderRequest &request : changed) {
+		EXPECT_NE(GetShaderKey(request, 1), key);
+	}
+	// Text moving between fields is a different request
+	const ShaderRequest split{.source = "model.hlsl", .entryPoint = "PS", .profile = "Mainps_5_0", .defines = {{"FOG", "1"}}};
+	EXPECT_NE(GetShaderKey(split, 1), key);
+}
+
+TEST_F(ShaderCacheTest, ColdLoadIsTheSameOnAnyThreadCount)
+{
+	TGW::JobSystem many{3}, one{0};
+	ShaderCache cold{compiler, GetSources(), GetCache()};
+	const auto entries = cold.LoadAll(requests, many);
+	const auto serial = ShaderCache{compiler, GetSources()}.LoadAll(requests, one);
+	ASSERT_TRUE(AllLoaded(entries));
+	ASSERT_TRUE(AllLoaded(serial));
+	ExpectStats(cold, 0, 0, REQUEST_COUNT);
+	for (uint32_t i = 0; i < REQUEST_COUNT; i++) {
+		EXPECT_EQ(entries[i]->bytecode, serial[i]->bytecode);
+		if (i > 0) {
+			EXPECT_NE(entries[i]->key, entries[i - 1]->key);
+		}
+	}
+
+	// The source first, then what it included
+	const std::vector<std::string> modelFiles{"model.hlsl", "lib/lighting.hlsl", "lib/common.hlsl"};
+	const std::vector<std::string> terrainFiles{"terrain.hlsl", "lib/common.hlsl"};
+	const auto getPaths = [](const ShaderEntry &entry) {
+		std::vector<std::string> paths;
+		for (const ShaderDependency &dependency : entry.dependencies) {
+			paths.push_back(dependency.path);
+		}
+		return paths;
+	};
+	EXPECT_EQ(getPaths(*entries.front()), modelFiles);
+	EXPECT_EQ(getPaths(*entries.back()), terrainFiles);
+
+	// Asked again, the same entry comes from memory
+	EXPECT_EQ(cold.Load(requests[0]), entries[0]);
+	ExpectStats(cold, 0, 0, REQUEST_COUNT);
+}
+
+TEST_F(ShaderCacheTest, WarmLoadCompilesNothing)
+{
+	ASSERT_TRUE(AllLoaded(ShaderCache{compiler, GetSources(), GetCache()}.LoadAll(requests)));
+	const uint32_t compiles = compiler.compiles;
+	ShaderCache warm{compiler, GetSources(), GetCache()};
+	EXPECT_TRUE(AllLoaded(warm.LoadAll(requests)));
+	ExpectStats(warm, 0, REQUEST_COUNT, 0);
+	EXPECT_EQ(compiler.compiles, compiles);
+}
+
+// Only the model reads lighting, everything reads common
+TEST_F(ShaderCacheTest, EditsRecompileOnlyWhatReadThem)
+{
+	ASSERT_TRUE(AllLoaded(ShaderCache{compiler, GetSources(), GetCache()}.LoadAll(requests)));
+
+	ASSERT_TRUE(WriteText(GetSources() / "lib" / "lighting.hlsl", "#include \"common.hlsl\"\nfloat light2;\n"));
+	ShaderCache lighting{compiler, GetSources(), GetCache()};
+	EXPECT_TRUE(AllLoaded(lighting.LoadAll(requests)));
+	ExpectStats(lighting, 0, REQUEST_COUNT / 2, REQUEST_COUNT / 2);
+
+	ASSERT_TRUE(WriteText(GetSources() / "lib" / "common.hlsl", "float common2(float x) { return x; }\n"));
+	ShaderCache common{compiler, GetSources(), GetCache()};
+	EXPECT_TRUE(AllLoaded(common.LoadAll(requests)));
+	ExpectStats(common, 0, 0, REQUEST_COUNT);
+}
+
+TEST_F(ShaderCacheTest, NewCompilerVersionMissesEverything)
+{
+	ASSERT_TRUE(AllLoaded(ShaderCache{compiler, GetSources(), GetCache()}.LoadAll(requests)));
+	compiler.version = 2;
+	ShaderCache upgraded{compiler, GetSources(), GetCache()};
+	EXPECT_TRUE(AllLoaded(upgraded.LoadAll(requests)));
+	ExpectStats(upgraded, 0, 0, REQUEST_COUNT);
+}
+
+// Sources or includes that are not there fail without poisoning the rest
+TEST_F(ShaderCacheTest, MissingFilesFailAlone)
+{
+	ShaderCache cache{compiler, GetSources()};
+	fs::remove(GetSources() / "lib" / "common.hlsl");
+	const ShaderRequest missing{.source = "missing.hlsl", .entryPoint = "VSMain", .profile = "vs_5_0", .defines = {}};
+	EXPECT_FALSE(cache.Load(missing));
+	EXPECT_FALSE(cache.Load(requests.back()));
+	EXPECT_EQ(cache.GetStats().failed, 2u);
+}
+
+TEST_F(ShaderCacheTest, EntryAndPackFormatsRoundTrip)
+{
+	ShaderCache cache{compiler, GetSources()};
+	const std::shared_ptr<const ShaderEntry> entry = cache.Load(requests[0]);
+	ASSERT_TRUE(entry);
+
+	std::vector<uint8_t> data = SerializeShaderEntry(*entry);
+	const std::optional<ShaderEntry> loaded = DeserializeShaderEntry(data);
+	ASSERT_TRUE(loaded);
+	ExpectSameEntry(*loaded, *entry);
+
+	// Anything cut short, with bytes left over or from another version is turned down
+	for (size_t size = 0; size < data.size(); size++) {
+		EXPECT_FALSE(DeserializeShaderEntry(std::span{data}.first(size))) << size;
+	}
+	data.push_back(0);
+	EXPECT_FALSE(DeserializeShaderEntry(data));
+	data.pop_back();
+	data[4] = static_cast<uint8_t>(SHADER_CACHE_VERSION + 1);
+	EXPECT_FALSE(DeserializeShaderEntry(data));
+
+	const std::vector<ShaderEntry> entries{*entry, *entry};
+	const std::vector<uint8_t> pack = SerializeShaderPack(entries);
+	const std::optional<std::vector<ShaderEntry>> unpacked = DeserializeShaderPack(pack);
+	ASSERT_TRUE(unpacked);
+	ASSERT_EQ(unpacked->size(), 2u);
+	ExpectSameEntry((*unpacked)[1], *entry);
+	EXPECT_FALSE(DeserializeShaderPack(std::span{pack}.first(pack.size() - 1)));
+	EXPECT_FALSE(DeserializeShaderEntry(pack));
+}
+
+TEST_F(ShaderCacheTest, DamagedEntryIsCompiledOver)
+{
+	ShaderCache writer{compiler, GetSources(), GetCache()};
+	const std::shared_ptr<const ShaderEntry> entry = writer.Load(requests[0]);
+	ASSERT_TRUE(entry);
+	const fs::path path = writer.GetEntryPath(entry->key);
+	ASSERT_TRUE(fs::exists(path));
+
+	fs::resize_file(path, fs::file_size(path) / 2);
+	ShaderCache reader{compiler, GetSources(), GetCache()};
+	EXPECT_TRUE(reader.Load(requests[0]));
+	ExpectStats(reader, 0, 0, 1);
+	EXPECT_EQ(fs::file_size(path), SerializeShaderEntry(*entry).size());
+}
+
+TEST_F(ShaderCacheTest, EmbeddedPackIsUsedUnlessSourcesChanged)
+{
+	std::vector<ShaderEntry> entries;
+	for (const auto &entry : ShaderCache{compiler, GetSources()}.LoadAll(requests)) {
+		ASSERT_TRUE(entry);
+		entries.push_back(*entry);
+	}
+	const std::vector<uint8_t> pack = SerializeShaderPack(entries);
+	const uint32_t compiles = compiler.compiles;
+
+	// Shipped without sources, and with them untouched
+	ShaderCache shipped{compiler, GetSources() / "missing"};
+	ASSERT_TRUE(shipped.AddEmbedded(pack));
+	EXPECT_TRUE(AllLoaded(shipped.LoadAll(requests)));
+	ExpectStats(shipped, REQUEST_COUNT, 0, 0);
+	ShaderCache untouched{compiler, GetSources()};
+	ASSERT_TRUE(untouched.AddEmbedded(pack));
+	EXPECT_TRUE(AllLoaded(untouched.LoadAll(requests)));
+	ExpectStats(untouched, REQUEST_COUNT, 0, 0);
+	EXPECT_EQ(compiler.compiles, compiles);
+	EXPECT_FALSE(untouched.AddEmbedded(std::span{pack}.first(pack.size() / 2)));
+
+	// An edited include outranks the pack
+	ASSERT_TRUE(WriteText(GetSources() / "lib" / "lighting.hlsl", "#include \"common.hlsl\"\n"));
+	ShaderCache edited{compiler, GetSources()};
+	ASSERT_TRUE(edited.AddEmbedded(pack));
+	EXPECT_TRUE(AllLoaded(edited.LoadAll(requests)));
+	ExpectStats(edited, REQUEST_COUNT / 2, 0, REQUEST_COUNT / 2);
+}
@@ -0,0 +1,230 @@
+#include "camera.h"
+#include "sim/spatial_grid.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+using namespace TGW::Sim;
+
+namespace {
+constexpr float MAP_SIZE = 256.0f;
+constexpr float CELL_SIZE = 8.0f;
+constexpr uint32_t POINT_COUNT = 5000;
+constexpr uint32_t QUERY_COUNT = 200;
+
+struct Crowd {
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<DirectX::XMFLOAT2> positions;
+};
+
+// Some of the points lie outside the grid, they get clamped into the border cells
+Crowd MakeCrowd()
+{
+	std::mt19937 rng{5};
+	std::uniform_real_distribution<float> coordinate{-20.0f, MAP_SIZE + 20.0f};
+	Crowd crowd;
+	for (uint32_t i = 0; i < POINT_COUNT; i++) {
+		crowd.positions.push_back({coordinate(rng), coordinate(rng)});
+		crowd.x.push_back(crowd.positions.back().x);
+		crowd.z.push_back(crowd.positions.back().y);
+	}
+	return crowd;
+}
+
+SpatialGrid MakeGrid(const Crowd &crowd, TGW::JobSystem &jobs)
+{
+	const uint32_t cells = static_cast<uint32_t>(MAP_SIZE / CELL_SIZE);
+	SpatialGrid grid{{0.0f, 0.0f}, CELL_SIZE, cells, cells};
+	grid.Rebuild(crowd.x, crowd.z, jobs);
+	return grid;
+}
+
+float DistanceSq(DirectX::XMFLOAT2 a, DirectX::XMFLOAT2 b)
+{
+	return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+std::vector<uint32_t> Sorted(std::vector<uint32_t> values)
+{
+	std::sort(values.begin(), values.end());
+	return values;
+}
+
+template <typename Fn> std::vector<uint32_t> BruteForce(const Crowd &crowd, Fn &&inside)
+{
+	std::vector<uint32_t> found;
+	for (uint32_t i = 0; i < crowd.positions.size(); i++) {
+		if (inside(crowd.positions[i])) {
+			found.push_back(i);
+		}
+	}
+	return found;
+}
+
+std::vector<DirectX::XMFLOAT2> MakeCenters()
+{
+	std::mt19937 rng{6};
+	std::uniform_real_distribution<float> coordinate{-30.0f, MAP_SIZE + 30.0f};
+	std::vector<DirectX::XMFLOAT2> centers(QUERY_COUNT);
+	for (DirectX::XMFLOAT2 &center : centers) {
+		center = {coordinate(rng), coordinate(rng)};
+	}
+	return centers;
+}
+} // namespace
+
+TEST(SpatialGrid, RadiusMatchesBruteForce)
+{
+	TGW::JobSystem jobs{3};
+	const Crowd crowd = MakeCrowd();
+	const SpatialGrid grid = MakeGrid(crowd, jobs);
+	EXPECT_EQ(grid.GetCount(), POINT_COUNT);
+
+	std::vector<uint32_t> found;
+	for (const float radius : {0.5f, 6.0f, 30.0f}) {
+		for (const DirectX::XMFLOAT2 center : MakeCenters()) {
+			found.clear();
+			grid.QueryRadius(center, radius, found);
+			const auto expected =
+				BruteForce(crowd, [&](DirectX::XMFLOAT2 point) { return DistanceSq(point, center) <= radius * radius; });
+			ASSERT_EQ(Sorted(found), expected) << center.x << ", " << center.y << " radius " << radius;
+		}
+	}
+}
+
+TEST(SpatialGrid, BoxAndQuadMatchBruteForce)
+{
+	TGW::JobSystem jobs{0};
+	const Crowd crowd = MakeCrowd();
+	const SpatialGrid grid = MakeGrid(crowd, jobs);
+
+	std::vector<uint32_t> found;
+	for (const DirectX::XMFLOAT2 center : MakeCenters()) {
+		const DirectX::XMFLOAT2 min{center.x - 12.0f, center.y - 5.0f}, max{center.x + 7.0f, center.y + 20.0f};
+		found.clear();
+		grid.QueryBox(min, max, found);
+		const auto inBox = BruteForce(crowd, [&](DirectX::XMFLOAT2 p) {
+			return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y;
+		});
+		ASSERT_EQ(Sorted(found), inBox);
+
+		// A diamond, in both windings
+		std::array<DirectX::XMFLOAT2, 4> diamond = {{
+		  {center.x + 15.0f, center.y},
+		  {center.x, center.y + 15.0f},
+		  {center.x - 15.0f, center.y},
+		  {center.x, center.y - 15.0f},
+		}};
+		const auto inDiamond = BruteForce(
+			crowd, [&](DirectX::XMFLOAT2 p) { return std::abs(p.x - center.x) + std::abs(p.y - center.y) <= 15.0f; });
+		found.clear();
+		grid.QueryQuad(diamond, found);
+		ASSERT_EQ(Sorted(found), inDiamond);
+		std::reverse(diamond.begin(), diamond.end());
+		found.clear();
+		grid.QueryQuad(diamond, found);
+		ASSERT_EQ(Sorted(found), inDiamond);
+	}
+}
+
+TEST(SpatialGrid, NearestIsClosestFirst)
+{
+	TGW::JobSystem jobs{0};
+	const Crowd crowd = MakeCrowd();
+	const SpatialGrid grid = MakeGrid(crowd, jobs);
+
+	std::vector<uint32_t> found;
+	std::vector<uint32_t> expected(POINT_COUNT);
+	for (const DirectX::XMFLOAT2 center : MakeCenters()) {
+		found.clear();
+		grid.QueryNearest(center, 8, MAP_SIZE * 2.0f, found);
+		ASSERT_EQ(found.size(), 8u);
+
+		// Ties make the exact indices ambiguous, the distances are not
+		std::iota(expected.begin(), expected.end(), 0u);
+		std::partial_sort(expected.begin(), expected.begin() + 8, expected.end(), [&](uint32_t a, uint32_t b) {
+			return DistanceSq(crowd.positions[a], center) < DistanceSq(crowd.positions[b], center);
+		});
+		for (uint32_t i = 0; i < 8; i++) {
+			ASSERT_EQ(DistanceSq(crowd.positions[found[i]], center), DistanceSq(crowd.positions[expected[i]], center));
+		}
+
+		// maxRadius cuts the list short
+		found.clear();
+		grid.QueryNearest(center, 8, 3.0f, found);
+		for (const uint32_t index : found) {
+			ASSERT_LE(DistanceSq(crowd.positions[index], center), 9.0f);
+		}
+	}
+}
+
+TEST(SpatialGrid, BatchMatchesSingleQueries)
+{
+	TGW::JobSystem jobs{3};
+	const Crowd crowd = MakeCrowd();
+	const SpatialGrid grid = MakeGrid(crowd, jobs);
+
+	SpatialQueryResults results;
+	grid.QueryRadiusBatch(crowd.positions, 6.0f, results, jobs);
+	ASSERT_EQ(results.GetQueryCount(), POINT_COUNT);
+	std::vector<uint32_t> single;
+	for (uint32_t query = 0; query < POINT_COUNT; query++) {
+		single.clear();
+		grid.QueryRadius(crowd.positions[query], 6.0f, single);
+		const std::span<const uint32_t> batched = results.Get(query);
+		ASSERT_TRUE(std::equal(single.begin(), single.end(), batched.begin(), batched.end())) << query;
+	}
+}
+
+TEST(SpatialGrid, RebuildReplacesThePoints)
+{
+	TGW::JobSystem jobs{0};
+	SpatialGrid grid{{0.0f, 0.0f}, CELL_SIZE, 4, 4};
+	const float x[] = {1.0f, 30.0f}, z[] = {1.0f, 30.0f};
+	grid.Rebuild(x, z, jobs);
+	std::vector<uint32_t> found;
+	grid.QueryRadius({1.0f, 1.0f}, 1.0f, found);
+	EXPECT_EQ(found, std::vector<uint32_t>{0});
+
+	grid.Rebuild(std::span<const float>{x}.first(1), std::span<const float>{z}.first(1), jobs);
+	EXPECT_EQ(grid.GetCount(), 1u);
+	found.clear();
+	grid.QueryRadius({30.0f, 30.0f}, 5.0f, found);
+	EXPECT_TRUE(found.empty());
+}
+
+TEST(SpatialGrid, BoxSelectUnderTheCamera)
+{
+	TGW::JobSystem jobs{0};
+	SpatialGrid grid{{-64.0f, -64.0f}, CELL_SIZE, 16, 16};
+	// One point on the camera target, one far behind the camera
+	const float x[] = {0.0f, -60.0f}, z[] = {0.0f, -60.0f};
+	grid.Rebuild(x, z, jobs);
+
+	Camera camera;
+	camera.SetAspectRatio(16.0f / 9.0f);
+	camera.SetView(DirectX::XMVectorZero(), DirectX::XMVectorSet(1.0f, -1.0f, 1.0f, 0.0f), 10.0f);
+	const DirectX::XMFLOAT2 viewport{1920.0f, 1080.0f};
+	std::vector<uint32_t> found;
+	BoxSelect(grid, camera, {900.0f, 500.0f}, {1020.0f, 580.0f}, viewport, found);
+	EXPECT_EQ(found, std::vector<uint32_t>{0});
+
+	// A click right on the point is no box, not even the grid cell under it
+	found.clear();
+	BoxSelect(grid, camera, {960.0f, 540.0f}, {960.0f, 540.0f}, viewport, found);
+	EXPECT_TRUE(found.empty());
+	grid.QueryQuad({{{0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f}}}, found);
+	EXPECT_TRUE(found.empty());
+
+	// A drag off the top of the screen points above the horizon
+	found.clear();
+	camera.SetView(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), 10.0f);
+	BoxSelect(grid, camera, {0.0f, 0.0f}, viewport, viewport, found);
+	EXPECT_TRUE(found.empty());
+}
@@ -0,0 +1,229 @@
+#include "terrain/quadtree.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <fstream>
+#include <random>
+
+using namespace TGW::Terrain;
+
+namespace fs = std::filesystem;
+
+namespace {
+// Not a power of two plus one, so the top nodes hang off the map
+constexpr uint32_t MAP_SAMPLES = 700;
+constexpr float MAP_SPACING = 2.0f;
+
+Heightmap MakeHills()
+{
+	std::vector<float> heights(size_t{MAP_SAMPLES} * MAP_SAMPLES);
+	for (uint32_t z = 0; z < MAP_SAMPLES; z++) {
+		for (uint32_t x = 0; x < MAP_SAMPLES; x++) {
+			heights[size_t{z} * MAP_SAMPLES + x] = 20.0f * std::sin(x * 0.01f) * std::cos(z * 0.013f);
+		}
+	}
+	return Heightmap{MAP_SAMPLES, MAP_SAMPLES, MAP_SPACING, {-100.0f, 50.0f}, std::move(heights)};
+}
+
+// Without culling, the selected quadrants have to tile the map: every quarter of a LOD 0 node drawn exactly once.
+// Quadrants at the far edges may hang off the map, but never lie wholly off it.
+void ExpectTiles(const Heightmap &heightmap, const std::vector<TerrainChunk> &chunks)
+{
+	const float unit = TERRAIN_CHUNK_QUADS / 2 * heightmap.GetSpacing();
+	const uint32_t cellsX = static_cast<uint32_t>(std::ceil(heightmap.GetSize().x / unit));
+	const uint32_t cellsZ = static_cast<uint32_t>(std::ceil(heightmap.GetSize().y / unit));
+	std::vector<uint32_t> hits(size_t{cellsX} * cellsZ, 0);
+	for (const TerrainChunk &chunk : chunks) {
+		const uint32_t span = static_cast<uint32_t>(chunk.size / 2 / unit);
+		for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+			if (!(chunk.quadrants & (1 << quadrant))) {
+				continue;
+			}
+			const uint32_t startX =
+				static_cast<uint32_t>((chunk.origin.x - heightmap.GetOrigin().x) / unit) + quadrant % 2 * span;
+			const uint32_t startZ =
+				static_cast<uint32_t>((chunk.origin.y - heightmap.GetOrigin().y) / unit) + quadrant / 2 * span;
+			ASSERT_LT(startX, cellsX) << "quadrant off the map at LOD " << chunk.lod;
+			ASSERT_LT(startZ, cellsZ) << "quadrant off the map at LOD " << chunk.lod;
+			for (uint32_t z = startZ; z < std::min(startZ + span, cellsZ); z++) {
+				for (uint32_t x = startX; x < std::min(startX + span, cellsX); x++) {
+					hits[size_t{z} * cellsX + x]++;
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < hits.size(); i++) {
+		ASSERT_EQ(hits[i], 1u) << "cell " << i % cellsX << ", " << i / cellsX;
+	}
+}
+} // namespace
+
+TEST(Heightmap, BilinearBetweenSamples)
+{
+	const Heightmap hills = MakeHills();
+	const DirectX::XMFLOAT2 origin = hills.GetOrigin();
+	for (uint32_t i = 0; i < 1000; i++) {
+		const uint32_t x = i * 7919 % MAP_SAMPLES, z = i * 104729 % MAP_SAMPLES;
+		ASSERT_NEAR(hills.GetHeight(origin.x + x * MAP_SPACING, origin.y + z * MAP_SPACING), hills.GetSample(x, z), 1e-4f);
+	}
+
+	// Halfway between four samples is their mean
+	const float mean =
+		(hills.GetSample(10, 20) + hills.GetSample(11, 20) + hills.GetSample(10, 21) + hills.GetSample(11, 21)) / 4.0f;
+	EXPECT_NEAR(hills.GetHeight(origin.x + 10.5f * MAP_SPACING, origin.y + 20.5f * MAP_SPACING), mean, 1e-4f);
+
+	// Off the map and NaN clamp to the border
+	EXPECT_FLOAT_EQ(hills.GetHeight(-1e6f, -1e6f), hills.GetSample(0, 0));
+	EXPECT_FLOAT_EQ(hills.GetHeight(1e6f, 1e6f), hills.GetSample(MAP_SAMPLES - 1, MAP_SAMPLES - 1));
+	EXPECT_FLOAT_EQ(hills.GetHeight(std::nanf(""), std::nanf("")), hills.GetSample(0, 0));
+
+	std::vector<float> x = {origin.x + 3.3f, origin.x + 700.0f, -1e6f}, z = {origin.y + 9.1f, origin.y + 1.0f, 1e6f};
+	std::vector<float> heights(3);
+	hills.GetHeights(x, z, heights);
+	for (size_t i = 0; i < heights.size(); i++) {
+		EXPECT_FLOAT_EQ(heights[i], hills.GetHeight(x[i], z[i]));
+	}
+}
+
+TEST(Heightmap, NormalOfAPlane)
+{
+	// y = 0.5 x - 0.25 z
+	std::vector<float> heights(16 * 16);
+	for (uint32_t z = 0; z < 16; z++) {
+		for (uint32_t x = 0; x < 16; x++) {
+			heights[z * 16 + x] = 0.5f * x * MAP_SPACING - 0.25f * z * MAP_SPACING;
+		}
+	}
+	const Heightmap plane{16, 16, MAP_SPACING, {0.0f, 0.0f}, std::move(heights)};
+	const float length = std::sqrt(0.5f * 0.5f + 1.0f + 0.25f * 0.25f);
+	for (const DirectX::XMFLOAT2 position : {DirectX::XMFLOAT2{3.1f, 7.7f}, DirectX::XMFLOAT2{29.9f, 0.0f}}) {
+		const DirectX::XMFLOAT3 normal = plane.GetNormal(position.x, position.y);
+		EXPECT_NEAR(normal.x, -0.5f / length, 1e-5f);
+		EXPECT_NEAR(normal.y, 1.0f / length, 1e-5f);
+		EXPECT_NEAR(normal.z, 0.25f / length, 1e-5f);
+	}
+	EXPECT_FLOAT_EQ(plane.GetMinHeight(), -0.25f * 15 * MAP_SPACING);
+	EXPECT_FLOAT_EQ(plane.GetMaxHeight(), 0.5f * 15 * MAP_SPACING);
+
+	const auto [low, high] = plane.GetRange(2, 3, 4, 100);
+	EXPECT_FLOAT_EQ(low, plane.GetSample(2, 15));
+	EXPECT_FLOAT_EQ(high, plane.GetSample(4, 3));
+}
+
+TEST(Heightmap, LoadRaw16)
+{
+	const fs::path path = fs::temp_directory_path() / "shellshock_test_heightmap.raw";
+	{
+		std::ofstream file{path, std::ios::binary | std::ios::trunc};
+		// 3 x 3 little endian samples
+		const uint8_t data[] = {0x00, 0x00, 0xFF, 0xFF, 0x00, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00};
+		file.write(reinterpret_cast<const char *>(data), sizeof(data));
+	}
+	const std::optional<Heightmap> loaded = Heightmap::LoadRaw16(path, 4.0f, 100.0f, {1.0f, 2.0f});
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(loaded->GetWidth(), 3u);
+	EXPECT_EQ(loaded->GetHeight(), 3u);
+	EXPECT_FLOAT_EQ(loaded->GetSize().x, 8.0f);
+	EXPECT_FLOAT_EQ(loaded->GetSample(0, 0), 0.0f);
+	EXPECT_FLOAT_EQ(loaded->GetSample(1, 0), 100.0f);
+	EXPECT_NEAR(loaded->GetSample(2, 0), 100.0f * 0x8000 / 65535.0f, 1e-3f);
+	EXPECT_NEAR(loaded->GetSample(2, 2), 100.0f / 65535.0f, 1e-6f);
+	EXPECT_FLOAT_EQ(loaded->GetHeight(5.0f, 2.0f), 100.0f);
+
+	// Not a square number of samples
+	{
+		std::ofstream file{path, std::ios::binary | std::ios::trunc};
+		file.write("\0\0\0\0\0\0", 6);
+	}
+	EXPECT_FALSE(Heightmap::LoadRaw16(path, 1.0f, 1.0f));
+	EXPECT_FALSE(Heightmap::LoadRaw16(path.string() + ".missing", 1.0f, 1.0f));
+	fs::remove(path);
+}
+
+TEST(Quadtree, SelectionTilesTheMap)
+{
+	const Heightmap hills = MakeHills();
+	const Quadtree quadtree{hills};
+	EXPECT_GT(quadtree.GetLodCount(), 2u);
+	for (uint32_t lod = 1; lod < quadtree.GetLodCount(); lod++) {
+		EXPECT_GT(quadtree.GetLodRange(lod), quadtree.GetLodRange(lod - 1));
+	}
+
+	std::mt19937 rng{3};
+	std::uniform_real_distribution<float> coordinate{-200.0f, MAP_SAMPLES * MAP_SPACING + 200.0f};
+	std::uniform_real_distribution<float> height{5.0f, 400.0f};
+	std::vector<TerrainChunk> chunks;
+	for (uint32_t i = 0; i < 20; i++) {
+		const DirectX::XMFLOAT3 eye{coordinate(rng), height(rng), coordinate(rng)};
+		quadtree.Select(eye, chunks);
+		ExpectTiles(hills, chunks);
+		if (HasFatalFailure()) {
+			return;
+		}
+		// The top LOD reaches everywhere and never morphs
+		for (const TerrainChunk &chunk : chunks) {
+			if (chunk.lod + 1 == quadtree.GetLodCount()) {
+				continue;
+			}
+			EXPECT_LT(chunk.morphStart, chunk.morphEnd);
+			EXPECT_LE(chunk.morphEnd, quadtree.GetLodRange(chunk.lod) + 1e-3f);
+		}
+	}
+}
+
+TEST(Quadtree, FrustumDropsChunksBehindTheCamera)
+{
+	const Heightmap hills = MakeHills();
+	const Quadtree quadtree{hills};
+	const DirectX::XMVECTOR eye = DirectX::XMVectorSet(600.0f, 80.0f, 700.0f, 1.0f);
+	const DirectX::XMVECTOR target = DirectX::XMVectorSet(800.0f, 0.0f, 900.0f, 1.0f);
+	const DirectX::XMMATRIX viewProjection = DirectX::XMMatrixMultiply(
+		DirectX::XMMatrixLookAtLH(eye, target, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+		DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f));
+	DirectX::XMFLOAT3 eyePosition;
+	DirectX::XMStoreFloat3(&eyePosition, eye);
+
+	std::vector<TerrainChunk> all, visible;
+	quadtree.Select(eyePosition, all);
+	quadtree.Select(eyePosition, viewProjection, visible);
+	EXPECT_FALSE(visible.empty());
+	EXPECT_LT(visible.size(), all.size());
+
+	// Every culled selection chunk is part of the full one, the camera looks north east
+	for (const TerrainChunk &chunk : visible) {
+		const bool found = std::ranges::any_of(all, [&](const TerrainChunk &other) {
+			return other.lod == chunk.lod && other.origin.x == chunk.origin.x && other.origin.y == chunk.origin.y &&
+				   (other.quadrants & chunk.quadrants) == chunk.quadrants;
+		});
+		EXPECT_TRUE(found) << chunk.origin.x << ", " << chunk.origin.y << " LOD " << chunk.lod;
+		EXPECT_GT(chunk.origin.x + chunk.size, 500.0f);
+		EXPECT_GT(chunk.origin.y + chunk.size, 600.0f);
+	}
+}
+
+TEST(Quadtree, ChunkMeshAndMorph)
+{
+	const MeshData mesh = BuildChunkMesh(8);
+	EXPECT_EQ(mesh.vertices.size(), 9u * 9u);
+	EXPECT_EQ(mesh.indices.size(), 8u * 8u * 6u);
+	EXPECT_FLOAT_EQ(mesh.vertices.back().position.x, 1.0f);
+	EXPECT_FLOAT_EQ(mesh.vertices.back().position.z, 1.0f);
+
+	const TerrainChunk chunk{
+	  .origin = {}, .size = 64.0f, .lod = 0, .quadrants = CHUNK_QUADRANT_ALL, .morphStart = 10.0f, .morphEnd = 20.0f};
+	EXPECT_FLOAT_EQ(GetMorphFactor(chunk, 5.0f), 0.0f);
+	EXPECT_FLOAT_EQ(GetMorphFactor(chunk, 15.0f), 0.5f);
+	EXPECT_FLOAT_EQ(GetMorphFactor(chunk, 25.0f), 1.0f);
+
+	// Fully morphed, every vertex sits on the grid of half as many quads
+	for (const Vertex &vertex : mesh.vertices) {
+		const DirectX::XMFLOAT2 grid{vertex.position.x, vertex.position.z};
+		const DirectX::XMFLOAT2 unmorphed = MorphGridPosition(grid, 0.0f, 8);
+		EXPECT_FLOAT_EQ(unmorphed.x, grid.x);
+		EXPECT_FLOAT_EQ(unmorphed.y, grid.y);
+		const DirectX::XMFLOAT2 morphed = MorphGridPosition(grid, 1.0f, 8);
+		EXPECT_NEAR(morphed.x * 4.0f, std::round(morphed.x * 4.0f), 1e-5f);
+		EXPECT_NEAR(morphed.y * 4.0f, std::round(morphed.y * 4.0f), 1e-5f);
+	}
+}
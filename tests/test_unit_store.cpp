@@ -0,0 +1,204 @@
+#include "sim/unit_store.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace DirectX;
+using namespace TGW::Sim;
+
+namespace {
+constexpr float TICK_SECONDS = 1.0f / 30.0f;
+constexpr uint32_t ARMY_SIZE = 1001; // not a multiple of UNIT_LANES, so the last group has padding lanes
+
+std::vector<UnitId> SpawnArmy(UnitStore &units)
+{
+	std::mt19937 rng{31};
+	std::uniform_real_distribution<float> coordinate{0.0f, 200.0f};
+	std::vector<UnitId> ids;
+	for (uint32_t i = 0; i < ARMY_SIZE; i++) {
+		ids.push_back(units.Spawn({
+		  .position = {coordinate(rng), 0.0f, coordinate(rng)},
+		  .health = static_cast<float>(i % 3),
+		  .owner = static_cast<uint8_t>(i % 8),
+		  .model = i,
+		}));
+		if (i % 2 == 0) {
+			units.SetMoveTarget(ids.back(), {coordinate(rng), coordinate(rng)});
+		}
+	}
+	return ids;
+}
+
+float DistanceTo(const UnitStore &units, UnitId id, XMFLOAT2 target)
+{
+	const uint32_t i = *units.GetDenseIndex(id);
+	const float dx = units.GetPositionsX()[i] - target.x;
+	const float dz = units.GetPositionsZ()[i] - target.y;
+	return std::sqrt(dx * dx + dz * dz);
+}
+} // namespace
+
+TEST(UnitStore, StaleIdsStopResolving)
+{
+	UnitStore units;
+	const UnitId a = units.Spawn({.model = 1});
+	const UnitId b = units.Spawn({.model = 2});
+	EXPECT_TRUE(units.Despawn(a));
+	EXPECT_FALSE(units.Despawn(a));
+	EXPECT_FALSE(units.IsAlive(a));
+
+	// The freed slot comes back under a new generation
+	const UnitId c = units.Spawn({.model = 3});
+	EXPECT_EQ(c.index, a.index);
+	EXPECT_NE(c, a);
+	EXPECT_FALSE(units.IsAlive(a));
+	EXPECT_TRUE(units.IsAlive(c));
+
+	EXPECT_EQ(units.GetCount(), 2u);
+	EXPECT_EQ(units.GetModels()[*units.GetDenseIndex(b)], 2u);
+	EXPECT_EQ(units.GetModels()[*units.GetDenseIndex(c)], 3u);
+	EXPECT_FALSE(units.IsAlive(UnitId{}));
+}
+
+TEST(UnitStore, DespawnKeepsArraysPacked)
+{
+	UnitStore units;
+	const std::vector<UnitId> ids = SpawnArmy(units);
+	for (uint32_t i = 0; i < ARMY_SIZE; i += 7) {
+		ASSERT_TRUE(units.Despawn(ids[i]));
+	}
+
+	uint32_t alive = 0;
+	for (uint32_t i = 0; i < ARMY_SIZE; i++) {
+		if (i % 7 == 0) {
+			EXPECT_FALSE(units.IsAlive(ids[i]));
+			continue;
+		}
+		alive++;
+		// Every survivor still resolves to its own data
+		const std::optional<uint32_t> denseIndex = units.GetDenseIndex(ids[i]);
+		ASSERT_TRUE(denseIndex.has_value());
+		EXPECT_LT(*denseIndex, units.GetCount());
+		EXPECT_EQ(units.GetId(*denseIndex), ids[i]);
+		EXPECT_EQ(units.GetModels()[*denseIndex], i);
+		EXPECT_EQ(units.GetOwners()[*denseIndex], i % 8);
+	}
+	EXPECT_EQ(units.GetCount(), alive);
+}
+
+TEST(UnitStore, RemoveDeadTakesOnlyTheDead)
+{
+	UnitStore units;
+	const std::vector<UnitId> ids = SpawnArmy(units);
+	// A third of the army spawned with zero health, finish off another unit on top
+	units.ApplyDamage(ids[1], 5.0f);
+
+	const uint32_t expected = (ARMY_SIZE + 2) / 3 + 1;
+	EXPECT_EQ(units.RemoveDead(), expected);
+	EXPECT_EQ(units.GetCount(), ARMY_SIZE - expected);
+	for (uint32_t i = 0; i < ARMY_SIZE; i++) {
+		EXPECT_EQ(units.IsAlive(ids[i]), i % 3 != 0 && i != 1) << i;
+	}
+	for (const float health : units.GetHealth()) {
+		EXPECT_GT(health, 0.0f);
+	}
+	EXPECT_EQ(units.RemoveDead(), 0u);
+}
+
+TEST(UnitStore, UnitsArriveAndStop)
+{
+	TGW::JobSystem jobs{2};
+	UnitStore units;
+	const XMFLOAT2 target{30.0f, -12.0f};
+	const UnitId mover = units.Spawn({.position = {0.0f, 0.0f, 0.0f}, .maxSpeed = 6.0f});
+	const UnitId idle = units.Spawn({.position = {5.0f, 0.0f, 5.0f}, .heading = 1.0f});
+	units.SetMoveTarget(mover, target);
+
+	const float maxStep = 6.0f * TICK_SECONDS * 1.001f;
+	float lastDistance = DistanceTo(units, mover, target);
+	for (uint32_t tick = 0; tick < 30 * 20; tick++) {
+		units.Tick(TICK_SECONDS, jobs);
+		const float distance = DistanceTo(units, mover, target);
+		// Never faster than its max speed, and it does not overshoot and come back
+		EXPECT_LE(lastDistance - distance, maxStep);
+		EXPECT_LE(distance, lastDistance + 1e-3f);
+		lastDistance = distance;
+	}
+
+	EXPECT_LT(lastDistance, 0.25f);
+	const uint32_t i = *units.GetDenseIndex(mover);
+	EXPECT_EQ(units.GetVelocitiesX()[i], 0.0f);
+	EXPECT_EQ(units.GetVelocitiesZ()[i], 0.0f);
+
+	// The idle unit was never given an order
+	const uint32_t j = *units.GetDenseIndex(idle);
+	EXPECT_EQ(units.GetPositionsX()[j], 5.0f);
+	EXPECT_EQ(units.GetPositionsZ()[j], 5.0f);
+	EXPECT_EQ(units.GetHeadings()[j], 1.0f);
+}
+
+TEST(UnitStore, StopBrakesToRest)
+{
+	TGW::JobSystem jobs{1};
+	UnitStore units;
+	const UnitId id = units.Spawn({.maxSpeed = 8.0f});
+	units.SetMoveTarget(id, {100.0f, 0.0f});
+	for (uint32_t tick = 0; tick < 30; tick++) {
+		units.Tick(TICK_SECONDS, jobs);
+	}
+	EXPECT_GT(units.GetVelocitiesX()[0], 0.0f);
+
+	units.Stop(id);
+	// 8 m/s at 20 m/s^2 takes 0.4 seconds to shed
+	for (uint32_t tick = 0; tick < 15; tick++) {
+		units.Tick(TICK_SECONDS, jobs);
+	}
+	EXPECT_EQ(units.GetVelocitiesX()[0], 0.0f);
+	EXPECT_EQ(units.GetVelocitiesZ()[0], 0.0f);
+	const float restX = units.GetPositionsX()[0];
+	units.Tick(TICK_SECONDS, jobs);
+	EXPECT_EQ(units.GetPositionsX()[0], restX);
+}
+
+TEST(UnitStore, TickIsIndependentOfWorkerCount)
+{
+	UnitStore single, many;
+	SpawnArmy(single);
+	SpawnArmy(many);
+	TGW::JobSystem oneWorker{1}, fourWorkers{4};
+	for (uint32_t tick = 0; tick < 60; tick++) {
+		single.Tick(TICK_SECONDS, oneWorker);
+		many.Tick(TICK_SECONDS, fourWorkers);
+	}
+	EXPECT_EQ(single.GetStateHash(), many.GetStateHash());
+
+	UnitStore untouched;
+	SpawnArmy(untouched);
+	EXPECT_NE(single.GetStateHash(), untouched.GetStateHash());
+}
+
+TEST(UnitStore, WorldMatricesMatchRotationThenTranslation)
+{
+	TGW::JobSystem jobs{2};
+	UnitStore units;
+	SpawnArmy(units);
+	for (uint32_t tick = 0; tick < 10; tick++) {
+		units.Tick(TICK_SECONDS, jobs);
+	}
+
+	std::vector<XMFLOAT4X4> matrices;
+	units.BuildWorldMatrices(matrices, jobs);
+	ASSERT_EQ(matrices.size(), units.GetCount());
+	for (uint32_t i = 0; i < units.GetCount(); i++) {
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected,
+						XMMatrixRotationY(units.GetHeadings()[i]) *
+							XMMatrixTranslation(units.GetPositionsX()[i], units.GetPositionsY()[i], units.GetPositionsZ()[i]));
+		for (uint32_t row = 0; row < 4; row++) {
+			for (uint32_t column = 0; column < 4; column++) {
+				EXPECT_NEAR(matrices[i].m[row][column], expected.m[row][column], 1e-4f) << i;
+			}
+		}
+	}
+}
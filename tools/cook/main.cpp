@@ -0,0 +1,229 @@
+// Offline content tool.
+//
+//   shellshock_cook pack <content dir> <archive.pak> [load order file]
+//   shellshock_cook list <archive.pak>
+//   shellshock_cook build <content dir> <output dir> [--cache <dir>] [--force]
+//   shellshock_cook gltf-check <model.glb|model.gltf>...
+//   shellshock_cook obj-check <model.obj>...
+//
+// The load order file lists paths relative to the content dir, one per line, in the order a level asks for them.
+// Files it does not mention are appended afterwards in path order.
+//
+// build cooks every model in the content dir and the textures it references. Only stale outputs are rebuilt,
+// the manifest and the content addressed cache live in <output dir>/.cook_cache unless --cache says otherwise.
+// texture_buckets.bin in <output dir> records which textures share a texture array. The editor reads it from its
+// content dir, loose or packed, and creates every array at its planned size with the textures in their slices.
+//
+// gltf-check loads each file with the native glTF loader and with Assimp and reports any difference in meshes,
+// triangles, vertex attributes, materials or root transform, along with both load times. obj-check does the same for
+// the native OBJ loader.
+
+#include "archive/archive_reader.h"
+#include "archive/archive_writer.h"
+#include "cook/batch_cooker.h"
+#include "cook/model_compare.h"
+#include "core/hash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+static std::optional<std::vector<uint8_t>> ReadFile(const fs::path &path)
+{
+	std::ifstream file{path, std::ios::binary};
+	if (!file) {
+		return {};
+	}
+	return std::vector<uint8_t>{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+static int Pack(const fs::path &contentDir, const fs::path &archivePath, const fs::path &loadOrderPath)
+{
+	std::vector<std::string> files;
+	for (const auto &file : fs::recursive_directory_iterator{contentDir}) {
+		// The archive from a previous run may sit in the content dir, spelled differently than on the command line
+		std::error_code error;
+		if (file.is_regular_file() && !fs::equivalent(file.path(), archivePath, error)) {
+			files.push_back(file.path().lexically_relative(contentDir).generic_string());
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	std::vector<std::string> ordered;
+	std::unordered_set<std::string> seen;
+	if (!loadOrderPath.empty()) {
+		std::unordered_map<std::string, std::string> available;
+		for (const auto &file : files) {
+			available.emplace(TGW::Hash::NormalizePath(file), file);
+		}
+
+		std::ifstream loadOrder{loadOrderPath};
+		for (std::string line; std::getline(loadOrder, line);) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			auto file = available.find(TGW::Hash::NormalizePath(line));
+			if (file != available.end() && seen.insert(file->first).second) {
+				ordered.push_back(file->second);
+			}
+		}
+	}
+	for (const auto &file : files) {
+		if (seen.insert(TGW::Hash::NormalizePath(file)).second) {
+			ordered.push_back(file);
+		}
+	}
+
+	TGW::Archive::ArchiveWriter writer;
+	uint64_t totalBytes = 0;
+	for (const auto &file : ordered) {
+		auto data = ReadFile(contentDir / file);
+		if (!data) {
+			std::fprintf(stderr, "Failed to read %s\n", file.c_str());
+			return 1;
+		}
+		totalBytes += data->size();
+		if (!writer.Add(file, std::move(*data))) {
+			std::fprintf(stderr, "Duplicate or colliding path %s\n", file.c_str());
+			return 1;
+		}
+	}
+
+	if (!writer.Write(archivePath)) {
+		std::fprintf(stderr, "Failed to write %s\n", archivePath.string().c_str());
+		return 1;
+	}
+
+	std::error_code error;
+	const uint64_t archiveBytes = fs::file_size(archivePath, error);
+	std::printf(
+		"Packed %zu files, %llu -> %llu bytes\n", ordered.size(), static_cast<unsigned long long>(totalBytes),
+		static_cast<unsigned long long>(archiveBytes));
+	return 0;
+}
+
+static int List(const fs::path &archivePath)
+{
+	TGW::Archive::ArchiveReader reader;
+	if (!reader.Open(archivePath)) {
+		std::fprintf(stderr, "Failed to open %s\n", archivePath.string().c_str());
+		return 1;
+	}
+
+	std::vector<TGW::Archive::ArchiveEntry> entries{reader.GetEntries().begin(), reader.GetEntries().end()};
+	std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) { return a.loadOrder < b.loadOrder; });
+	for (const auto &entry : entries) {
+		const std::string name{reader.GetName(entry)};
+		std::printf("%6u %12llu %s\n", entry.loadOrder, static_cast<unsigned long long>(entry.size), name.c_str());
+	}
+	return 0;
+}
+
+static int Build(const fs::path &contentDir, const fs::path &outputDir, std::span<char *> options)
+{
+	TGW::Cook::CookSettings settings;
+	std::optional<fs::path> cacheDir;
+	for (size_t i = 0; i < options.size(); i++) {
+		const std::string_view option = options[i];
+		if (option == "--force") {
+			settings.force = true;
+		} else if (option == "--cache" && i + 1 < options.size()) {
+			cacheDir = options[++i];
+		} else {
+			std::fprintf(stderr, "Unknown option %s\n", options[i]);
+			return 1;
+		}
+	}
+
+	TGW::Cook::BatchCooker cooker{contentDir, outputDir, settings};
+	if (cacheDir) {
+		cooker.SetCacheDirectory(*cacheDir);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const TGW::Cook::CookStats stats = cooker.Run();
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	for (const auto &error : stats.errors) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+	}
+	std::printf(
+		"%u models, %u textures in %u buckets: %u cooked, %u from cache, %u up to date, %zu failed in %.2f s\n",
+		stats.models, stats.textures, stats.textureBuckets, stats.cooked, stats.cacheHits, stats.upToDate,
+		stats.errors.size(), elapsed.count());
+	return stats.errors.empty() ? 0 : 1;
+}
+
+// What a native loader read, in the shape ImportModel returns for comparison
+using NativeLoad = std::optional<TGW::Cook::CookedModel> (*)(const fs::path &path);
+
+static int CheckNativeLoader(std::span<char *> files, NativeLoad load)
+{
+	using Clock = std::chrono::steady_clock;
+	int result = 0;
+	for (const char *file : files) {
+		const auto nativeStart = Clock::now();
+		const std::optional<TGW::Cook::CookedModel> native = load(file);
+		const auto assimpStart = Clock::now();
+		const std::optional<TGW::Cook::CookedModel> assimp = TGW::Cook::ImportModel(file);
+		const auto end = Clock::now();
+
+		std::vector<std::string> differences;
+		if (!native) {
+			differences.push_back("native loader does not support this file, Assimp is used instead");
+		} else if (!assimp) {
+			differences.push_back("Assimp failed to load");
+		} else {
+			differences = TGW::Cook::CompareModels(*native, *assimp);
+		}
+
+		const std::chrono::duration<double, std::milli> nativeTime = assimpStart - nativeStart;
+		const std::chrono::duration<double, std::milli> assimpTime = end - assimpStart;
+		std::printf(
+			"%s %s: native %.2f ms, Assimp %.2f ms\n", differences.empty() ? "OK  " : "FAIL", file, nativeTime.count(),
+			assimpTime.count());
+		for (const auto &difference : differences) {
+			std::printf("    %s\n", difference.c_str());
+		}
+		if (!differences.empty()) {
+			result = 1;
+		}
+	}
+	return result;
+}
+
+int main(int argc, char **argv)
+{
+	const std::string_view command = argc > 1 ? argv[1] : "";
+	if (command == "pack" && (argc == 4 || argc == 5)) {
+		return Pack(argv[2], argv[3], argc == 5 ? argv[4] : "");
+	}
+	if (command == "list" && argc == 3) {
+		return List(argv[2]);
+	}
+	if (command == "build" && argc >= 4) {
+		return Build(argv[2], argv[3], std::span<char *>{argv + 4, argv + argc});
+	}
+	if (command == "gltf-check" && argc >= 3) {
+		return CheckNativeLoader(std::span<char *>{argv + 2, argv + argc}, TGW::Cook::LoadGltfModel);
+	}
+	if (command == "obj-check" && argc >= 3) {
+		return CheckNativeLoader(std::span<char *>{argv + 2, argv + argc}, TGW::Cook::LoadObjModel);
+	}
+
+	std::fprintf(
+		stderr, "Usage:\n"
+				"  shellshock_cook pack <content dir> <archive.pak> [load order file]\n"
+				"  shellshock_cook list <archive.pak>\n"
+				"  shellshock_cook build <content dir> <output dir> [--cache <dir>] [--force]\n"
+				"  shellshock_cook gltf-check <model.glb|model.gltf>...\n"
+				"  shellshock_cook obj-check <model.obj>...\n");
+	return 1;
+}
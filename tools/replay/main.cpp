@@ -0,0 +1,284 @@
+// Headless replay of sessions recorded with "Shellshock -record <file>" or a CommandRecorder.
+//
+//   shellshock_replay run <file> [--csv <out.csv>] [--hash-every <ticks>] [--expect <hash>] [--threads <n>]
+//                                [--terrain <file.r16>] [--no-models]
+//   shellshock_replay info <file>
+//   shellshock_replay compare <a.csv> <b.csv>
+//
+// run re-executes the stream as fast as it goes with its fixed timestep and prints the tick times and the final state
+// hash. --csv writes one row per tick with its time and, every --hash-every ticks and after the last one, the state
+// hash. --expect fails the run when the final hash differs, for replays checked into CI. --threads sets the workers of
+// the job system, the hash does not depend on it. The terrain the session ran on is loaded from where the editor
+// opened it, with the editor's spacing and height scale, and the run fails when that file is missing or no longer hashes
+// the same. --terrain reads it from somewhere else, it still has to match. Streams that recorded no terrain, version 1
+// ones among them, run on flat ground unless --terrain gives one, which is then taken unchecked. --no-models skips
+// loading the models the session had, for machines without the content.
+//
+// compare reads two CSVs of the same replay, for example before and after a change, and reports how the tick times
+// moved and the first tick whose hashes disagree.
+
+#include "replay/replay_world.h"
+#include "terrain/heightmap.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <span>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+constexpr const char *COMMAND_NAMES[TGW::Replay::COMMAND_TYPE_COUNT] = {
+  "camera orbit", "camera pan",  "camera zoom", "camera view", "load model", "move model", "select model",
+  "remove model", "clear models", "spawn unit", "move unit",   "stop unit",  "despawn unit", "fire",
+};
+
+struct TickStats {
+	double total = 0.0;
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+};
+
+static TickStats GetTickStats(std::vector<float> micros)
+{
+	TickStats stats;
+	if (micros.empty()) {
+		return stats;
+	}
+	std::sort(micros.begin(), micros.end());
+	for (const float tick : micros) {
+		stats.total += tick;
+	}
+	stats.mean = stats.total / micros.size();
+	stats.p50 = micros[micros.size() / 2];
+	stats.p99 = micros[std::min(micros.size() - 1, micros.size() * 99 / 100)];
+	stats.max = micros.back();
+	return stats;
+}
+
+static void PrintTickStats(const char *label, const TickStats &stats)
+{
+	std::printf(
+		"%s%.1f us mean, %.1f us p50, %.1f us p99, %.1f us max\n", label, stats.mean, stats.p50, stats.p99, stats.max);
+}
+
+static std::optional<TGW::Replay::CommandStream> LoadStream(const fs::path &path)
+{
+	std::optional<TGW::Replay::CommandStream> stream = TGW::Replay::Load(path);
+	if (!stream) {
+		std::fprintf(stderr, "Failed to load replay %s\n", path.string().c_str());
+	}
+	return stream;
+}
+
+static std::optional<TGW::Terrain::Heightmap> LoadTerrain(const TGW::Replay::CommandStream &stream, const fs::path &path)
+{
+	if (!stream.terrainPath.empty() && TGW::Replay::HashTerrainFile(path) != stream.terrainHash) {
+		std::fprintf(stderr, "Terrain %s is missing or not the one the session ran on\n", path.string().c_str());
+		return {};
+	}
+	std::optional<TGW::Terrain::Heightmap> terrain =
+		TGW::Terrain::Heightmap::LoadRaw16(path, TGW::Terrain::TERRAIN_SPACING, TGW::Terrain::TERRAIN_HEIGHT_SCALE);
+	if (!terrain) {
+		std::fprintf(stderr, "Failed to load terrain %s\n", path.string().c_str());
+	}
+	return terrain;
+}
+
+static int Run(const fs::path &path, std::span<char *> options)
+{
+	std::optional<fs::path> csvPath;
+	std::optional<fs::path> terrainPath;
+	std::optional<uint64_t> expected;
+	uint32_t hashInterval = 0;
+	uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	TGW::Replay::ReplaySettings settings;
+	for (size_t i = 0; i < options.size(); i++) {
+		const std::string_view option = options[i];
+		if (option == "--csv" && i + 1 < options.size()) {
+			csvPath = options[++i];
+		} else if (option == "--hash-every" && i + 1 < options.size()) {
+			hashInterval = static_cast<uint32_t>(std::strtoul(options[++i], nullptr, 10));
+		} else if (option == "--expect" && i + 1 < options.size()) {
+			expected = std::strtoull(options[++i], nullptr, 16);
+		} else if (option == "--threads" && i + 1 < options.size()) {
+			threads = static_cast<uint32_t>(std::strtoul(options[++i], nullptr, 10));
+		} else if (option == "--terrain" && i + 1 < options.size()) {
+			terrainPath = options[++i];
+		} else if (option == "--no-models") {
+			settings.loadModels = false;
+		} else {
+			std::fprintf(stderr, "Unknown option %s\n", options[i]);
+			return 1;
+		}
+	}
+
+	const std::optional<TGW::Replay::CommandStream> stream = LoadStream(path);
+	if (!stream) {
+		return 1;
+	}
+	if (!terrainPath && !stream->terrainPath.empty()) {
+		terrainPath = stream->terrainPath;
+	}
+	std::optional<TGW::Terrain::Heightmap> terrain;
+	if (terrainPath) {
+		terrain = LoadTerrain(*stream, *terrainPath);
+		if (!terrain) {
+			return 1;
+		}
+	}
+
+	settings.tickSeconds = stream->tickSeconds;
+	TGW::JobSystem jobs{threads};
+	TGW::Replay::ReplayWorld world{settings, jobs};
+	world.SetTerrain(terrain ? &*terrain : nullptr);
+	const TGW::Replay::ReplayReport report = TGW::Replay::RunReplay(*stream, world, hashInterval);
+
+	const TickStats stats = GetTickStats(report.tickMicros);
+	std::printf(
+		"%u ticks, %zu commands in %.2f s, %.0f ticks/s\n", stream->tickCount, stream->commands.size(),
+		stats.total / 1e6, stats.total > 0.0 ? report.tickMicros.size() / (stats.total / 1e6) : 0.0);
+	PrintTickStats("", stats);
+	std::printf(
+		"%u units, %u projectiles, %zu models left\n", world.GetUnits().GetCount(), world.GetProjectiles().GetCount(),
+		world.GetModels().size());
+	std::printf("Final hash %016" PRIx64 "\n", report.finalHash);
+
+	if (csvPath) {
+		std::ofstream csv{*csvPath};
+		csv << "tick,micros,hash\n";
+		size_t checkpoint = 0;
+		for (size_t tick = 0; tick < report.tickMicros.size(); tick++) {
+			csv << tick << ',' << report.tickMicros[tick] << ',';
+			const bool last = tick + 1 == report.tickMicros.size();
+			const bool hashed = hashInterval > 0 && ((tick + 1) % hashInterval == 0 || last);
+			if (hashed || last) {
+				char hash[17];
+				std::snprintf(hash, sizeof(hash), "%016" PRIx64, hashed ? report.hashes[checkpoint++] : report.finalHash);
+				csv << hash;
+			}
+			csv << '\n';
+		}
+		if (!csv) {
+			std::fprintf(stderr, "Failed to write %s\n", csvPath->string().c_str());
+			return 1;
+		}
+	}
+
+	if (expected && *expected != report.finalHash) {
+		std::fprintf(stderr, "Desync: expected final hash %016" PRIx64 "\n", *expected);
+		return 1;
+	}
+	return 0;
+}
+
+static int Info(const fs::path &path)
+{
+	const std::optional<TGW::Replay::CommandStream> stream = LoadStream(path);
+	if (!stream) {
+		return 1;
+	}
+	std::error_code error;
+	std::printf(
+		"%u ticks of %.2f ms, %.1f s, %zu commands, %ju bytes\n", stream->tickCount, stream->tickSeconds * 1000.0f,
+		stream->tickCount * stream->tickSeconds, stream->commands.size(), static_cast<uintmax_t>(fs::file_size(path, error)));
+	if (!stream->terrainPath.empty()) {
+		std::printf(
+			"Terrain %s, hash %016" PRIx64 "%016" PRIx64 "\n", stream->terrainPath.c_str(), stream->terrainHash.high,
+			stream->terrainHash.low);
+	}
+
+	std::array<uint32_t, TGW::Replay::COMMAND_TYPE_COUNT> counts{};
+	for (const TGW::Replay::Command &command : stream->commands) {
+		counts[command.type]++;
+	}
+	for (size_t type = 0; type < counts.size(); type++) {
+		if (counts[type] > 0) {
+			std::printf("  %-14s %u\n", COMMAND_NAMES[type], counts[type]);
+		}
+	}
+	return 0;
+}
+
+struct CsvRun {
+	std::vector<float> tickMicros;
+	// Empty on the ticks without a hash
+	std::vector<std::string> hashes;
+};
+
+static std::optional<CsvRun> ReadCsv(const fs::path &path)
+{
+	std::ifstream file{path};
+	std::string line;
+	if (!file || !std::getline(file, line)) {
+		std::fprintf(stderr, "Failed to read %s\n", path.string().c_str());
+		return {};
+	}
+	CsvRun run;
+	while (std::getline(file, line)) {
+		const size_t first = line.find(',');
+		const size_t second = line.find(',', first + 1);
+		if (first == std::string::npos || second == std::string::npos) {
+			std::fprintf(stderr, "Malformed row in %s: %s\n", path.string().c_str(), line.c_str());
+			return {};
+		}
+		run.tickMicros.push_back(std::strtof(line.c_str() + first + 1, nullptr));
+		run.hashes.push_back(line.substr(second + 1));
+	}
+	return run;
+}
+
+static int Compare(const fs::path &pathA, const fs::path &pathB)
+{
+	const std::optional<CsvRun> a = ReadCsv(pathA);
+	const std::optional<CsvRun> b = ReadCsv(pathB);
+	if (!a || !b) {
+		return 1;
+	}
+
+	const TickStats statsA = GetTickStats(a->tickMicros);
+	const TickStats statsB = GetTickStats(b->tickMicros);
+	PrintTickStats("a: ", statsA);
+	PrintTickStats("b: ", statsB);
+	const auto change = [](double from, double to) { return from > 0.0 ? (to - from) / from * 100.0 : 0.0; };
+	std::printf(
+		"b - a: %+.1f%% mean, %+.1f%% p50, %+.1f%% p99, %+.1f%% max\n", change(statsA.mean, statsB.mean),
+		change(statsA.p50, statsB.p50), change(statsA.p99, statsB.p99), change(statsA.max, statsB.max));
+
+	if (a->tickMicros.size() != b->tickMicros.size()) {
+		std::printf("Different lengths: %zu and %zu ticks\n", a->tickMicros.size(), b->tickMicros.size());
+	}
+	const size_t shared = std::min(a->hashes.size(), b->hashes.size());
+	for (size_t tick = 0; tick < shared; tick++) {
+		if (!a->hashes[tick].empty() && !b->hashes[tick].empty() && a->hashes[tick] != b->hashes[tick]) {
+			std::printf("Desync by tick %zu\n", tick);
+			return 1;
+		}
+	}
+	std::printf("No desync\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const std::string_view command = argc > 1 ? argv[1] : "";
+	if (command == "run" && argc >= 3) {
+		return Run(argv[2], std::span<char *>{argv + 3, argv + argc});
+	}
+	if (command == "info" && argc == 3) {
+		return Info(argv[2]);
+	}
+	if (command == "compare" && argc == 4) {
+		return Compare(argv[2], argv[3]);
+	}
+
+	std::fprintf(
+		stderr, "Usage:\n"
+				"  shellshock_replay run <file> [--csv <out.csv>] [--hash-every <ticks>] [--expect <hash>] [--threads <n>]\n"
+				"                              [--terrain <file.r16>] [--no-models]\n"
+				"  shellshock_replay info <file>\n"
+				"  shellshock_replay compare <a.csv> <b.csv>\n");
+	return 1;
+}
@@ -0,0 +1,64 @@
+// Build time shader compiler.
+//
+//   shellshock_shaderc <shader dir> <output.cpp>
+//
+// Compiles every shader in EDITOR_SHADERS with D3DCompile, in parallel, and writes them as a shader pack into a source
+// file that defines GetEmbeddedShaders(). The editor links that file, so a fresh build starts without compiling any
+// shader. The output is only rewritten when the pack changed, to keep incremental builds from relinking.
+
+#include "cook/cook_cache.h"
+#include "log.h"
+#include "shader/d3d_shader_compiler.h"
+#include "shader/editor_shaders.h"
+
+static std::string MakeSource(std::span<const uint8_t> pack)
+{
+	std::string source = "// Generated by shellshock_shaderc from the editor shaders, do not edit\n\n"
+						 "#include \"shader/editor_shaders.h\"\n\n"
+						 "namespace {\n"
+						 "constexpr uint8_t EMBEDDED_SHADERS[] = {";
+	char byte[8];
+	for (size_t i = 0; i < pack.size(); i++) {
+		std::snprintf(byte, sizeof(byte), "%s0x%02x,", i % 16 == 0 ? "\n\t" : " ", pack[i]);
+		source += byte;
+	}
+	source += "\n};\n"
+			  "} // namespace\n\n"
+			  "std::span<const uint8_t> TGW::Shader::GetEmbeddedShaders() { return EMBEDDED_SHADERS; }\n";
+	return source;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3) {
+		std::fprintf(stderr, "Usage:\n  shellshock_shaderc <shader dir> <output.cpp>\n");
+		return 1;
+	}
+
+	TGW::Shader::D3DShaderCompiler compiler;
+	TGW::Shader::ShaderCache cache{compiler, argv[1]};
+	std::vector<TGW::Shader::ShaderEntry> entries;
+	for (const auto &entry : cache.LoadAll(TGW::Shader::EDITOR_SHADERS)) {
+		if (!entry) {
+			for (const TGW::LogEntry &log : TGW::Logger::GetAll()) {
+				std::fprintf(stderr, "%s\n", log.message.c_str());
+			}
+			return 1;
+		}
+		entries.push_back(*entry);
+	}
+
+	const std::vector<uint8_t> pack = TGW::Shader::SerializeShaderPack(entries);
+	const std::string source = MakeSource(pack);
+	const std::span<const uint8_t> bytes{reinterpret_cast<const uint8_t *>(source.data()), source.size()};
+	const std::optional<std::vector<uint8_t>> previous = TGW::Cook::ReadWholeFile(argv[2]);
+	if (previous && std::ranges::equal(*previous, bytes)) {
+		return 0;
+	}
+	if (!TGW::Cook::WriteFileAtomic(argv[2], bytes)) {
+		std::fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return 1;
+	}
+	std::printf("Embedded %zu shaders, %zu bytes\n", entries.size(), pack.size());
+	return 0;
+}